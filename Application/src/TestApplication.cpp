@@ -207,7 +207,6 @@ void CreateGraphicsEntityHelper(EntityInfo& ei)
 
     //UpdateBV(gs_RenderEngine->models[e.modelID].cpuModel, e);
     ObjectInstance o{};
-	o.name = ei.name;
 	o.bindlessGlobalTextureIndex_Albedo = ei.bindlessGlobalTextureIndex_Albedo;
 	o.bindlessGlobalTextureIndex_Normal = ei.bindlessGlobalTextureIndex_Normal;
 	o.bindlessGlobalTextureIndex_Roughness = ei.bindlessGlobalTextureIndex_Roughness;
@@ -221,6 +220,7 @@ void CreateGraphicsEntityHelper(EntityInfo& ei)
     o.submesh = ei.submesh;
 
 	auto id = gs_GraphicsWorld.CreateObjectInstance(o);
+	gs_GraphicsWorld.GetObjectName(id) = ei.name;
     // assign id
     ei.gfxID = id;
 }
@@ -358,8 +358,8 @@ void TestApplication::Run()
     auto defaultCubeMesh = CreateDefaultCubeMesh();
     auto defaultSphere = icosahedron::make_icosphere(3);
 
-    std::unique_ptr<ModelFileResource> model_plane{ gs_RenderEngine->LoadMeshFromBuffers(defaultPlaneMesh.m_VertexBuffer, defaultPlaneMesh.m_IndexBuffer, nullptr) };
-    std::unique_ptr<ModelFileResource> model_box{ gs_RenderEngine->LoadMeshFromBuffers(defaultCubeMesh.m_VertexBuffer, defaultCubeMesh.m_IndexBuffer, nullptr) };
+    std::unique_ptr<ModelFileResource> model_plane{ gs_RenderEngine->LoadMeshFromBuffers(defaultPlaneMesh.m_VertexBuffer, defaultPlaneMesh.m_IndexBuffer) };
+    std::unique_ptr<ModelFileResource> model_box{ gs_RenderEngine->LoadMeshFromBuffers(defaultCubeMesh.m_VertexBuffer, defaultCubeMesh.m_IndexBuffer) };
     std::unique_ptr<ModelFileResource> model_sphere{nullptr};
     {
         std::vector<uint32_t> indices;
@@ -405,7 +405,7 @@ void TestApplication::Run()
             v.tex.x = 0.5f + glm::atan2(v.pos.z, v.pos.x) / 2.0f * glm::pi<float>();
             v.tex.y = 0.5f + glm::asin(v.pos.y) / glm::pi<float>();
         }        
-        model_sphere.reset(gs_RenderEngine->LoadMeshFromBuffers(vertices, indices, nullptr));
+        model_sphere.reset(gs_RenderEngine->LoadMeshFromBuffers(vertices, indices));
     }
     gs_ModelID_Box = model_box->indices.front();
 
@@ -605,7 +605,9 @@ void TestApplication::Run()
     // Stress test more models
     std::vector<std::unique_ptr<ModelFileResource>> moreModels;
     moreModels.reserve(128);
-#define LOAD_MODEL(FILE) moreModels.emplace_back(gs_RenderEngine->LoadModelFromFile("../Application/models/" FILE))
+    // imported side by side on the task manager, collected once all are queued
+    std::vector<std::future<ModelFileResource*>> pendingModels;
+#define LOAD_MODEL(FILE) pendingModels.emplace_back(gs_RenderEngine->LoadModelFromFileAsync("../Application/models/" FILE, false))
     LOAD_MODEL("arrow.fbx");
     LOAD_MODEL("classroom_door.fbx");
     LOAD_MODEL("cleaning_trolley.fbx");
@@ -629,6 +631,10 @@ void TestApplication::Run()
     LOAD_MODEL("pallet_of_pipes.fbx");
     LOAD_MODEL("I_beam.fbx");
 #undef LOAD_MODEL
+    for (auto& pending : pendingModels)
+    {
+        moreModels.emplace_back(pending.get());
+    }
     {
         int counter = 0;
         for (auto& model : moreModels)
@@ -1186,19 +1192,14 @@ void TestApplication::InitDefaultMeshes()
 {
     auto defaultPlaneMesh = CreateDefaultPlaneXZMesh();
     auto defaultCubeMesh = CreateDefaultCubeMesh();
-    std::unique_ptr<ModelFileResource> plane{ gs_RenderEngine->LoadMeshFromBuffers(defaultPlaneMesh.m_VertexBuffer, defaultPlaneMesh.m_IndexBuffer, nullptr) };
-    std::unique_ptr<ModelFileResource> box{ gs_RenderEngine->LoadMeshFromBuffers(defaultCubeMesh.m_VertexBuffer, defaultCubeMesh.m_IndexBuffer, nullptr) };
+    std::unique_ptr<ModelFileResource> plane{ gs_RenderEngine->LoadMeshFromBuffers(defaultPlaneMesh.m_VertexBuffer, defaultPlaneMesh.m_IndexBuffer) };
+    std::unique_ptr<ModelFileResource> box{ gs_RenderEngine->LoadMeshFromBuffers(defaultCubeMesh.m_VertexBuffer, defaultCubeMesh.m_IndexBuffer) };
 }
 
 void TestApplication::LoadMeshTextures(ModelFileResource* model)
 {
-    for (size_t i = 0; i < model->materials.size(); i++)
-    {
-        if (model->materials[i].albedo.size()) {
-            auto result = gs_RenderEngine->CreateTexture(model->materials[i].albedo);
-            model->materials[i].albedoTexture = result;
-        }
-    }
+    // decoded in parallel, every material texture the file names
+    gs_RenderEngine->LoadModelTextures(model);
 }
 
 void TestApplication::ProcessModelScene(ModelFileResource* model)
@@ -1281,7 +1282,7 @@ void TestApplication::RunTest_DebugDraw()
         // oGFX::Point3D prevpos;
 
         auto& diona = entities[globalDionaID];
-        auto& gfxO = gs_GraphicsWorld.GetObjectInstance(diona.gfxID);
+        auto& gfxBones = gs_GraphicsWorld.GetObjectBones(diona.gfxID);
         const auto& refSkeleton = gs_RenderEngine->GetSkeleton(diona.modelID);
 
         auto* skeleton = diona.localSkeleton;
@@ -1323,9 +1324,9 @@ void TestApplication::RunTest_DebugDraw()
 
            // If the node isn't a bone then we don't care.
           
-               if (gfxO.bones.size())
+               if (gfxBones.size())
                {                   
-                    gfxO.bones[pBoneNode->m_BoneIndex] = pBoneNode->mModelSpaceGlobal * refSkeleton->inverseBindPose[pBoneNode->m_BoneIndex].transform;
+                    gfxBones[pBoneNode->m_BoneIndex] = pBoneNode->mModelSpaceGlobal * refSkeleton->inverseBindPose[pBoneNode->m_BoneIndex].transform;
                }
            }
           
@@ -1837,7 +1838,6 @@ void TestApplication::Tool_HandleUI()
                         if (&entity == gs_GizmoContext.GetSelectedEntityInfo()) {
                             ImGui::PopStyleColor();
                         }
-                        auto& msh = gs_RenderEngine->g_globalModels[entity.modelID];
                         ImGui::Text("Submesh");
                         ImGui::Dummy({1, 1});
                         //for (size_t i = 0; i < msh.m_subMeshes.size(); i++)
@@ -1896,8 +1896,8 @@ void TestApplication::Tool_HandleUI()
                             if(ImGui::TreeNode("Bones"))
                             {
                                 
-                                auto& gfx = gs_GraphicsWorld.GetObjectInstance(entity.gfxID);
-                                for (size_t i = 0; i < gfx.bones.size(); i++)
+                                auto& gfxBones = gs_GraphicsWorld.GetObjectBones(entity.gfxID);
+                                for (size_t i = 0; i < gfxBones.size(); i++)
                                 {
                                     //ImGui::PushID(entity.entityID+i + 1);
                                     //ImGui::Text(("Bones_" + std::to_string(i)).c_str());
@@ -0,0 +1,119 @@
+// Cooks models next to their sources, the renderer maps a cooked file instead of importing while it is current.
+// usage: ModelCooker [-f] <model or folder>...
+
+#include "CookedModel.h"
+#include "TaskManager.h"
+
+#include <assimp/Importer.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+int main(int argc, char* argv[])
+{
+    bool force = false;
+    std::vector<std::string> files;
+    {
+        Assimp::Importer importer;
+        for (int i = 1; i < argc; i++)
+        {
+            const std::string arg = argv[i];
+            if (arg == "-f")
+            {
+                force = true;
+            }
+            else if (std::filesystem::is_directory(arg))
+            {
+                for (const auto& entry : std::filesystem::recursive_directory_iterator(arg))
+                {
+                    if (entry.is_regular_file() && importer.IsExtensionSupported(entry.path().extension().string()))
+                    {
+                        files.push_back(entry.path().string());
+                    }
+                }
+            }
+            else if (std::filesystem::is_regular_file(arg))
+            {
+                files.push_back(arg);
+            }
+            else
+            {
+                std::cerr << "[ModelCooker] " << arg << " not found" << std::endl;
+            }
+        }
+    }
+    if (files.empty())
+    {
+        std::cout << "usage: ModelCooker [-f] <model or folder>...\n"
+            << "  cooks every model next to its source, -f cooks the current ones again" << std::endl;
+        return 1;
+    }
+
+    TaskManager tm;
+    tm.Init(std::max(1u, std::thread::hardware_concurrency() - 1));
+
+    using Clock = std::chrono::high_resolution_clock;
+    int failed = 0;
+    size_t cookedCount = 0;
+    double totalImport = 0.0;
+    double totalCooked = 0.0;
+    for (const std::string& file : files)
+    {
+        oGFX::ModelImport::Model model;
+        if (force == false && oGFX::CookedModel::Load(file, model))
+        {
+            std::cout << "[ModelCooker] " << file << " is current" << std::endl;
+            continue;
+        }
+
+        auto start = Clock::now();
+        if (oGFX::ModelImport::ImportModel(file, model, &tm) == false)
+        {
+            std::cerr << "[ModelCooker] " << file << " could not be imported" << std::endl;
+            ++failed;
+            continue;
+        }
+        const double importMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+        const std::string cooked = oGFX::CookedModel::CookedPath(file);
+        if (oGFX::CookedModel::Write(cooked, model, oGFX::CookedModel::HashSource(file)) == false)
+        {
+            std::cerr << "[ModelCooker] " << cooked << " could not be written" << std::endl;
+            ++failed;
+            continue;
+        }
+
+        // the load the renderer does from now on
+        start = Clock::now();
+        oGFX::ModelImport::Model loaded;
+        if (oGFX::CookedModel::Load(file, loaded) == false)
+        {
+            std::cerr << "[ModelCooker] " << cooked << " could not be read back" << std::endl;
+            ++failed;
+            continue;
+        }
+        const double cookedMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+        ++cookedCount;
+        totalImport += importMs;
+        totalCooked += cookedMs;
+        std::cout << "[ModelCooker] " << file << std::fixed << std::setprecision(2)
+            << " import " << importMs << "ms, cooked " << cookedMs << "ms, "
+            << std::filesystem::file_size(cooked) / 1024 << "KB" << std::defaultfloat << std::endl;
+    }
+    tm.Shutdown();
+
+    if (cookedCount)
+    {
+        std::cout << "[ModelCooker] " << cookedCount << " cooked" << std::fixed << std::setprecision(1)
+            << ", import " << totalImport << "ms against cooked " << totalCooked << "ms ("
+            << totalImport / std::max(totalCooked, 1e-3) << "x)" << std::defaultfloat << std::endl;
+    }
+    return failed ? 1 : 0;
+}
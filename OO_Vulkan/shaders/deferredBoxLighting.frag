@@ -27,6 +27,10 @@ layout (set = 0, binding = 14)uniform sampler clampedSampler;
 layout (set = 0, binding = 15)uniform texture2D LTC;
 layout (set = 0, binding = 16)uniform texture2D LTCLUT;
 layout (set = 0, binding = 17) uniform sampler ssaoSampler;
+layout(std430, set = 0, binding = 18) readonly buffer ShadowTiles
+{
+	vec4 ShadowTiles_SSBO[]; // atlas uv rect of each shadow grid index, xy offset zw size
+};
 
 
 #include "lights.shader"
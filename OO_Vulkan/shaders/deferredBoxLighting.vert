@@ -3,13 +3,9 @@
 
 layout (location = 1) out flat int outLightInstance;
 
-layout(location = 0) in vec3 inPosition;
-layout(location = 1) in vec3 inNormal;
-layout(location = 2) in vec3 inColor;
-layout(location = 3) in vec3 inTangent;
-layout(location = 4) in vec2 inUV;
-
 #include "shared_structs.h"
+#include "vertex_input.shader"
+
 layout( push_constant ) uniform pc
 {
 	LightPC lightPC;
@@ -39,6 +35,9 @@ void main()
 
 	outLightInstance = int(gl_InstanceIndex);
 
-	gl_Position = uboFrameContext.viewProjJittered* xform * vec4(inPosition,1.0);
+	// the default cube fills its own bounds, [-0.5,0.5]
+	const vec3 position = VertexPosition(vec4(-0.5, -0.5, -0.5, 1.0));
+
+	gl_Position = uboFrameContext.viewProjJittered* xform * vec4(position,1.0);
 
 }
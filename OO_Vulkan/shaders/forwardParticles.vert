@@ -5,15 +5,12 @@
 #include "shared_structs.h"
 #include "instancing.shader"
 
-layout(location = 0) in vec3 inPosition;
-layout(location = 1) in vec3 inNormal;
-layout(location = 2) in vec3 inColor;
-layout(location = 3) in vec3 inTangent;
-layout(location = 4) in vec2 inUV;
+#include "vertex_input.shader"
 
 layout(location = 5) in mat4 inXform;
 layout(location = 9) in vec4 inCol;
 layout(location = 10) in uvec4 inInstanceData;
+layout(location = 11) in vec4 inPositionDequant;
 
 
 // Note: Sending too much stuff from VS to FS can result in bottleneck...
@@ -40,14 +37,15 @@ layout(std430, set = 0, binding = 3) readonly buffer GPUScene
 
 void main()
 {
+	const vec3 position = VertexPosition(inPositionDequant);
 	outUV = inUV;
 	outColor = inCol;
 	outInstanceData = inInstanceData;
 	
 	mat3 L2W = mat3(inXform);
 
-	vec3 NN = normalize(inNormal);
-	vec3 NT = normalize(inTangent);
+	vec3 NN = normalize(VertexNormal());
+	vec3 NT = normalize(VertexTangent());
 	vec3 NB = cross(NN, NT);
 	
 	vec3 T = normalize(L2W * vec3(NT)).xyz;
@@ -58,7 +56,7 @@ void main()
 
 	if((inInstanceData.y & 0x0f)>0) // billboard
 	{
-		vec3 fragOffset = inPosition.xyz;
+		vec3 fragOffset = position;
 		vec3 CameraRight_worldspace = vec3(uboFrameContext.view[0][0], uboFrameContext.view[1][0], uboFrameContext.view[2][0]);
 		vec3 CameraUp_worldspace = vec3(uboFrameContext.view[0][1], uboFrameContext.view[1][1], uboFrameContext.view[2][1]);
 		vec3 CameraForward_worldspace = vec3(uboFrameContext.view[0][2], uboFrameContext.view[1][2], uboFrameContext.view[2][2]);
@@ -75,7 +73,7 @@ void main()
 	}
 	else
 	{
-		outPosition = inXform*vec4(inPosition,1.0);
+		outPosition = inXform*vec4(position,1.0);
 	}
 	
 	gl_Position = uboFrameContext.viewProjection * outPosition;
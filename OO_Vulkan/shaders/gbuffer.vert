@@ -4,11 +4,8 @@
 #include "shared_structs.h"
 #include "instancing.shader"
 
-layout(location = 0) in vec3 inPosition;
-layout(location = 1) in vec3 inNormal;
-layout(location = 2) in vec3 inColor;
-layout(location = 3) in vec3 inTangent;
-layout(location = 4) in vec2 inUV;
+#include "vertex_input.shader"
+
 layout(location = 5) out vec4 outPrevPosition;
 layout(location = 6) out vec4 outCurrPosition;
 
@@ -57,24 +54,28 @@ void main()
 {
 
     const uint instanceIndex = gl_InstanceIndex;
+    uvec4 inInstanceData = InstanceDatas[instanceIndex];
+    // per object data lives in the object's persistent slot
+    const uint objectSlot = inInstanceData.x;
 
-    GPUObjectInformation objectInfo = GPUobjectInfo[instanceIndex];
+    GPUObjectInformation objectInfo = GPUobjectInfo[objectSlot];
+    const vec3 position = VertexPosition(objectInfo.positionDequant);
 	outEntityID = objectInfo.entityID;
 	outEmissive = objectInfo.emissiveColour;
 	//decode the matrix into transform matrix
-	mat4 dInsMatrix = GPUTransformToMatrix4x4(GPUScene_SSBO[instanceIndex]);
-    mat4 dPrevInsMatrix = GPUTransformToPreviousMatrix4x4(GPUScene_SSBO[instanceIndex]);
+	mat4 dInsMatrix = GPUTransformToMatrix4x4(GPUScene_SSBO[objectSlot]);
+    mat4 dPrevInsMatrix = GPUTransformToPreviousMatrix4x4(GPUScene_SSBO[objectSlot]);
     vec4 prevPosition;
 	
 	// inefficient
 	mat3 L2W = mat3(dInsMatrix);//inverse(dInsMatrix);
 	//L2W = mat3(1.0);
 
-	vec3 NN = normalize(inNormal);
-	vec3 NT = normalize(inTangent);
+	vec3 NN = normalize(VertexNormal());
+	vec3 NT = normalize(VertexTangent());
 	vec3 NB = cross(NN, NT);
 	
-	mat3 invTranspose = mat3(GPUTransformToInverseTransposeMatrix4x4(GPUScene_SSBO[instanceIndex]));
+	mat3 invTranspose = mat3(GPUTransformToInverseTransposeMatrix4x4(GPUScene_SSBO[objectSlot]));
 
 	vec3 T = normalize(invTranspose * vec3(NT)).xyz;
 	vec3 B = normalize(invTranspose * vec3(NB)).xyz;
@@ -84,7 +85,6 @@ void main()
 	outLightData.t = T;
 	outLightData.n = N;
 
-    uvec4 inInstanceData = InstanceDatas[instanceIndex];
 	bool skinned = UnpackSkinned(inInstanceData.y);
     if(skinned)
 	{
@@ -95,12 +95,12 @@ void main()
         vec4 boneWeights = UnpackBoneWeights(boneInfo);
 		
 		mat4x4 boneToModel;
-		outPosition = ComputeSkinnedVertexPosition(dInsMatrix,inPosition
+		outPosition = ComputeSkinnedVertexPosition(dInsMatrix,position
 													, boneIndices, boneWeights
 													,objectInfo.boneStartIdx,boneToModel);
 		
 		// calculate previous position
-        prevPosition = ComputeSkinnedVertexPosition(dPrevInsMatrix, inPosition
+        prevPosition = ComputeSkinnedVertexPosition(dPrevInsMatrix, position
 													, boneIndices, boneWeights
 													, objectInfo.boneStartIdx, boneToModel);
 		
@@ -109,8 +109,8 @@ void main()
 	}
 	else
 	{
-		outPosition = dInsMatrix * vec4(inPosition,1.0);
-        prevPosition = dPrevInsMatrix * vec4(inPosition, 1.0);
+		outPosition = dInsMatrix * vec4(position,1.0);
+        prevPosition = dPrevInsMatrix * vec4(position, 1.0);
     }
 
 	// gl_Position jitters the motion vectors because its jittered
@@ -120,7 +120,7 @@ void main()
     outPrevPosition = uboFrameContext.prevViewProjJittered * prevPosition;
 	
 	outUV = inUV;
-	outColor = inColor;
+	outColor = VertexColour();
 	outInstanceData = inInstanceData;
     outInstanceData.x = gl_InstanceIndex;
 }
@@ -4,11 +4,7 @@
 #include "shared_structs.h"
 #include "instancing.shader"
 
-layout(location = 0) in vec3 inPos;
-layout(location = 1) in vec3 inNormal;
-layout(location = 2) in vec3 inCol;
-layout(location = 3) in vec3 inTangent;
-layout(location = 4) in vec2 inUV;
+#include "vertex_input.shader"
 
 
 layout(std430, set = 0, binding = 1) readonly buffer instanceBuffer
@@ -47,14 +43,17 @@ layout(push_constant) uniform PushLight
 void main()
 {
 	const uint instanceIndex = gl_InstanceIndex;
+    uvec4 inInstanceData = InstanceDatas[instanceIndex];
+    // per object data lives in the object's persistent slot
+    const uint objectSlot = inInstanceData.x;
 
 	//decode the matrix into transform matrix
-	const mat4 dInsMatrix = GPUTransformToMatrix4x4(GPUScene_SSBO[instanceIndex]);
-    GPUObjectInformation objectInfo = GPUobjectInfo[gl_InstanceIndex];
+	const mat4 dInsMatrix = GPUTransformToMatrix4x4(GPUScene_SSBO[objectSlot]);
+    GPUObjectInformation objectInfo = GPUobjectInfo[objectSlot];
+    const vec3 position = VertexPosition(objectInfo.positionDequant);
 	// inefficient
 
 	vec4 outPosition;
-    uvec4 inInstanceData = InstanceDatas[instanceIndex];
 	bool skinned = UnpackSkinned(inInstanceData.y);
     if(skinned)
 	{
@@ -64,13 +63,13 @@ void main()
         vec4 boneWeights = UnpackBoneWeights(boneInfo);
 		
 		mat4x4 boneToModel; // what do i do with this
-		outPosition = ComputeSkinnedVertexPosition(dInsMatrix,inPos
+		outPosition = ComputeSkinnedVertexPosition(dInsMatrix,position
 													, boneIndices, boneWeights
 													,objectInfo.boneStartIdx,boneToModel);
 	}
 	else
 	{
-		outPosition = dInsMatrix * vec4(inPos,1.0);
+		outPosition = dInsMatrix * vec4(position,1.0);
 	}
 
 	//gl_Position = uboFrameContext.viewProjection * outPosition;
@@ -3,22 +3,13 @@
 
 const uint SHADOW_MAP_SIZE = 4096u;
 
-vec2 GetShadowMapRegion(int gridID, in vec2 uv, in vec2 numCells)
+vec2 GetShadowMapRegion(int gridID, in vec2 uv)
 {
-    const float oneTexelUV = 1.0 / (SHADOW_MAP_SIZE);
-    vec2 gridScalar = vec2(1.0) / numCells - 2 * oneTexelUV; // size for each cell
-
-    vec2 actualUV = (gridScalar) * uv; // uv local to this cell
-
-	// avoid the modolus operator not sure how much that matters
-    int y = gridID / int(numCells.x);
-    int x = gridID - int(numCells.x * y);
+    // tiles come from the shadow atlas and already leave out their 1 texel border
+    vec4 tile = ShadowTiles_SSBO[gridID];
 
-    vec2 borderPixels = vec2(x, y) * 2.0 * oneTexelUV; // number of padding pixels    
-    vec2 offset = gridScalar * vec2(x, y) + borderPixels; // offset to our cell
-
-    // add an extra texel
-    return (offset+oneTexelUV) + actualUV; //sampled position
+    // flip y during sample
+    return tile.xy + vec2(uv.x, 1.0 - uv.y) * tile.zw;
 }
 
 float ShadowCalculation(int gridID, in vec4 fragPosLightSpace, float NdotL)
@@ -31,11 +22,7 @@ float ShadowCalculation(int gridID, in vec4 fragPosLightSpace, float NdotL)
 
     vec2 uvs = vec2(projCoords.x, projCoords.y);
     // uvs = clamp(uvs, oneTexelUV, 1.0 - oneTexelUV); // clamp between the grids
-    uvs = GetShadowMapRegion(gridID, uvs, PC.shadowMapGridDim);
-    
-   
-	// Flip y during sample
-    uvs = vec2(uvs.x, 1.0 - uvs.y);
+    uvs = GetShadowMapRegion(gridID, uvs);
 	
     float currDepth = projCoords.z;
 
@@ -6,6 +6,9 @@
 #define BIND_POINT_INSTANCE_BUFFER_ID  2
 #define BIND_POINT_GPU_SCENE_BUFFER_ID  3
 
+// 1 packs the global vertex buffer to 20 bytes a vertex (VertexPacking.h), vertex_input.shader decodes it
+#define PACKED_VERTEX_FORMAT 0
+
 
 #ifdef __cplusplus
 #include "MathCommon.h"
@@ -164,6 +167,18 @@ struct GPUObjectInformation
     uint materialIdx;
     uint boneWeightsOffset;
     vec4 emissiveColour;
+    vec4 positionDequant; // packed positions are xyz + unorm * w
+};
+
+// Cluster of a submesh, MeshletBuilder.h
+struct GPUMeshlet
+{
+    uint vertexOffset; // into the meshlet vertices, those are relative to the submesh's base vertex
+    uint triangleOffset; // into the meshlet triangles, three 8 bit indices into the meshlet's vertices each
+    uint vertexCount;
+    uint triangleCount;
+    vec4 sphere; // xyz centre, w radius
+    vec4 cone; // xyz axis, w cutoff. All backfacing when dot(centre - eye, axis) >= cutoff * length(centre - eye) + radius * (1 + cutoff)
 };
 
 struct HistoStruct{
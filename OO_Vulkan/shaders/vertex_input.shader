@@ -0,0 +1,65 @@
+#ifndef _VERTEX_INPUT_SHADER_H_
+#define _VERTEX_INPUT_SHADER_H_
+
+// Global vertex buffer layout, see GetGFXVertexInputAttributes. Needs shared_structs.h first.
+#if PACKED_VERTEX_FORMAT
+layout(location = 0) in vec4 inPackedPosition; // unorm16 in the model's bounds
+layout(location = 1) in vec2 inPackedNormal; // octahedral snorm16
+layout(location = 3) in vec2 inPackedTangent; // octahedral snorm16
+layout(location = 4) in vec2 inUV; // half
+#else
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inNormal;
+layout(location = 2) in vec3 inColor;
+layout(location = 3) in vec3 inTangent;
+layout(location = 4) in vec2 inUV;
+#endif
+
+vec3 OctDecode(vec2 e)
+{
+    vec3 n = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));
+    if (n.z < 0.0)
+    {
+        n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    }
+    return normalize(n);
+}
+
+// positionDequant from GPUObjectInformation, unused when not packed
+vec3 VertexPosition(vec4 positionDequant)
+{
+#if PACKED_VERTEX_FORMAT
+    return positionDequant.xyz + inPackedPosition.xyz * positionDequant.w;
+#else
+    return inPosition;
+#endif
+}
+
+vec3 VertexNormal()
+{
+#if PACKED_VERTEX_FORMAT
+    return OctDecode(inPackedNormal);
+#else
+    return inNormal;
+#endif
+}
+
+vec3 VertexTangent()
+{
+#if PACKED_VERTEX_FORMAT
+    return OctDecode(inPackedTangent);
+#else
+    return inTangent;
+#endif
+}
+
+vec3 VertexColour()
+{
+#if PACKED_VERTEX_FORMAT
+    return vec3(1.0); // not packed
+#else
+    return inColor;
+#endif
+}
+
+#endif//INCLUDE_GUARD
@@ -4,7 +4,9 @@
 \author         Jamie Kong, j.kong, 390004720 | code contribution (100%)
 \par            email: j.kong\@digipen.edu
 \date           Oct 02, 2022
-\brief              Bit container class which holds static data and indexes to objects
+\brief              Bit container class which holds static data and indexes to objects.
+    Grows on demand, hands out slots from a free list and tags each slot with a generation
+    so stale handles can be caught.
 
 Copyright (C) 2022 DigiPen Institute of Technology.
 Reproduction or disclosure of this file or its contents
@@ -15,14 +17,24 @@ Technology is prohibited.
 
 #include "VulkanUtils.h" // this is probably bad
 #include <memory>
-#include <bitset>
 #include <vector>
 #include <tuple>
+#include <bit>
 
-template <typename T, int32_t MAX_OBJECTS = 2048>
+template <typename T, int32_t INITIAL_CAPACITY = 2048>
 class BitContainer
 {
 public:
+	using Word = uint64_t;
+	inline static constexpr size_t s_wordBits = sizeof(Word) * 8;
+
+	// Index plus the generation of the slot when the handle was made, goes stale once the slot is removed
+	struct Handle
+	{
+		int32_t id{ -1 };
+		uint32_t generation{};
+	};
+
 	struct Iterator
 	{
 		using iterator_category = std::forward_iterator_tag;
@@ -31,7 +43,7 @@ public:
 		using pointer           = T*;  // or also value_type*
 		using reference         = T&;  // or also value_type&
 
-		Iterator(pointer ptr, pointer begin, pointer end, std::bitset<MAX_OBJECTS>* bits) 
+		Iterator(pointer ptr, pointer begin, pointer end, const std::vector<Word>* bits) 
 			: m_ptr(ptr),
 				m_begin{begin},
 				m_end{end},
@@ -55,7 +67,7 @@ public:
 		pointer m_ptr;
 		pointer m_begin;
 		pointer m_end;
-		std::bitset<MAX_OBJECTS>* m_b;
+		const std::vector<Word>* m_b;
 		
 	};
 
@@ -68,96 +80,93 @@ public:
 	int32_t Add(const T& obj);
 	void Remove(int32_t id);
 	T& Get(int32_t id);
+	bool IsValid(int32_t id) const;
 	void Clear();
 	size_t size();
+	size_t capacity() const;
+
+	Handle GetHandle(int32_t id) const;
+	bool IsValid(Handle h) const;
+	T& Get(Handle h);
 
 	auto Raw();
 	std::vector<T>& buffer();
 
 	T& operator[](size_t i);
 
-
+	// Index of the first occupied slot at or after i, capacity() if there is none
+	static size_t FindNext(const std::vector<Word>& bits, size_t i);
 
 private:
-	std::bitset<MAX_OBJECTS> m_bits{};
+	void Grow();
+
+	std::vector<Word> m_bits{};
 	std::vector<T> m_data{};
+	std::vector<uint32_t> m_generations{};
+	std::vector<int32_t> m_freeList{}; // popped from the back, lowest ids on top
 
 	size_t m_size{};
 };
 
-template <typename T, int32_t MAX_OBJECTS>
-BitContainer<T,MAX_OBJECTS>::BitContainer()
+template <typename T, int32_t INITIAL_CAPACITY>
+BitContainer<T,INITIAL_CAPACITY>::BitContainer()
 {
-	m_data.resize(m_bits.size());
+	Grow();
 }
 
-template <typename T, int32_t MAX_OBJECTS>
-BitContainer<T,MAX_OBJECTS>::~BitContainer()
+template <typename T, int32_t INITIAL_CAPACITY>
+BitContainer<T,INITIAL_CAPACITY>::~BitContainer()
 {
 }
 
-template<typename T, int32_t MAX_OBJECTS>
-inline typename BitContainer<T, MAX_OBJECTS>::Iterator BitContainer<T, MAX_OBJECTS>::begin()
+template<typename T, int32_t INITIAL_CAPACITY>
+inline typename BitContainer<T, INITIAL_CAPACITY>::Iterator BitContainer<T, INITIAL_CAPACITY>::begin()
 {	
-	int i = 0;
-	while (i < m_bits.size())
-	{
-		if (m_bits[i] == true)
-		{
-			return Iterator(m_data.data() + i,m_data.data(),m_data.data() + m_bits.size(),&m_bits);
-		}
-		else
-		{
-			++i;
-		}
-	};
-	return end();
+	size_t i = FindNext(m_bits, 0);
+	return Iterator(m_data.data() + i,m_data.data(),m_data.data() + m_data.size(),&m_bits);
 }
 
-template<typename T, int32_t MAX_OBJECTS>
-inline typename BitContainer<T, MAX_OBJECTS>::Iterator BitContainer<T, MAX_OBJECTS>::end()
+template<typename T, int32_t INITIAL_CAPACITY>
+inline typename BitContainer<T, INITIAL_CAPACITY>::Iterator BitContainer<T, INITIAL_CAPACITY>::end()
 {
-	return Iterator(m_data.data() + m_bits.size(), m_data.data(), m_data.data() + m_bits.size(), &m_bits);
+	return Iterator(m_data.data() + m_data.size(), m_data.data(), m_data.data() + m_data.size(), &m_bits);
 }
 
-template<typename T, int32_t MAX_OBJECTS>
-inline int32_t BitContainer<T, MAX_OBJECTS>::Add(const T& obj)
+template<typename T, int32_t INITIAL_CAPACITY>
+inline int32_t BitContainer<T, INITIAL_CAPACITY>::Add(const T& obj)
 {
-	int32_t id = -1;
-
-	for (size_t i = 0; i < m_bits.size(); i++)
+	if (m_freeList.empty())
 	{
-		if (m_bits[i] == false)
-		{
-			m_bits[i] = true;
-			id = int32_t(i);
-
-			m_data[id] = obj;
-			++m_size;
-			return id;
-		}
+		Grow();
 	}
-	
-	assert(false); // shouldnt hit here. TODO: proper errors
+
+	int32_t id = m_freeList.back();
+	m_freeList.pop_back();
+
+	m_bits[id / s_wordBits] |= Word(1) << (id % s_wordBits);
+	m_data[id] = obj;
+	++m_size;
 	return id;
 }
 
-template<typename T, int32_t MAX_OBJECTS>
-inline void BitContainer<T, MAX_OBJECTS>::Remove(int32_t id)
+template<typename T, int32_t INITIAL_CAPACITY>
+inline void BitContainer<T, INITIAL_CAPACITY>::Remove(int32_t id)
 {
-	if (m_bits[id] == true)
+	if (IsValid(id) == true)
 	{
-		m_bits[id] = false;
+		m_bits[id / s_wordBits] &= ~(Word(1) << (id % s_wordBits));
+		++m_generations[id];
+		m_freeList.push_back(id);
 		--m_size;
 		return;
 	}
 	assert(false); // removed invalid object
 }
 
-template<typename T, int32_t MAX_OBJECTS>
-inline T& BitContainer<T, MAX_OBJECTS>::Get(int32_t id)
+template<typename T, int32_t INITIAL_CAPACITY>
+inline T& BitContainer<T, INITIAL_CAPACITY>::Get(int32_t id)
 {
-	if (m_bits[id] == true)
+	if (IsValid(id) == true)
 	{		
 		return m_data[id];
 	}
@@ -165,58 +174,135 @@ inline T& BitContainer<T, MAX_OBJECTS>::Get(int32_t id)
 	return m_data[0];
 }
 
-template<typename T, int32_t MAX_OBJECTS>
-inline void BitContainer<T, MAX_OBJECTS>::Clear()
+template<typename T, int32_t INITIAL_CAPACITY>
+inline bool BitContainer<T, INITIAL_CAPACITY>::IsValid(int32_t id) const
 {
-	for (size_t i = 0; i < m_bits.size(); i++)
+	return id >= 0 && static_cast<size_t>(id) < m_data.size() 
+		&& (m_bits[id / s_wordBits] & (Word(1) << (id % s_wordBits))) != 0;
+}
+
+template<typename T, int32_t INITIAL_CAPACITY>
+inline void BitContainer<T, INITIAL_CAPACITY>::Clear()
+{
+	for (size_t w = 0; w < m_bits.size(); w++)
+	{
+		// bump the generation of everything that was alive
+		for (Word bits = m_bits[w]; bits != 0; bits &= bits - 1)
+		{
+			++m_generations[w * s_wordBits + std::countr_zero(bits)];
+		}
+		m_bits[w] = 0;
+	}
+
+	m_freeList.clear();
+	for (size_t i = m_data.size(); i > 0; --i)
 	{
-		m_bits[i] = false;
+		m_freeList.push_back(static_cast<int32_t>(i - 1));
 	}
 	m_size = 0;
 }
 
-template<typename T, int32_t MAX_OBJECTS>
-inline size_t BitContainer<T, MAX_OBJECTS>::size()
+template<typename T, int32_t INITIAL_CAPACITY>
+inline size_t BitContainer<T, INITIAL_CAPACITY>::size()
 {
 	return m_size;
 }
 
-template<typename T, int32_t MAX_OBJECTS>
-inline auto BitContainer<T, MAX_OBJECTS>::Raw()
+template<typename T, int32_t INITIAL_CAPACITY>
+inline size_t BitContainer<T, INITIAL_CAPACITY>::capacity() const
 {
-	return std::tuple<std::bitset<MAX_OBJECTS>&, std::vector<T>&>{ m_bits,m_data };
+	return m_data.size();
 }
 
-template<typename T, int32_t MAX_OBJECTS>
-inline std::vector<T>& BitContainer<T, MAX_OBJECTS>::buffer()
+template<typename T, int32_t INITIAL_CAPACITY>
+inline typename BitContainer<T, INITIAL_CAPACITY>::Handle BitContainer<T, INITIAL_CAPACITY>::GetHandle(int32_t id) const
+{
+	assert(IsValid(id)); // handle to an invalid object
+	return Handle{ id, m_generations[id] };
+}
+
+template<typename T, int32_t INITIAL_CAPACITY>
+inline bool BitContainer<T, INITIAL_CAPACITY>::IsValid(Handle h) const
+{
+	return IsValid(h.id) && m_generations[h.id] == h.generation;
+}
+
+template<typename T, int32_t INITIAL_CAPACITY>
+inline T& BitContainer<T, INITIAL_CAPACITY>::Get(Handle h)
+{
+	assert(IsValid(h)); // stale handle, the slot was removed or reused
+	return Get(h.id);
+}
+
+template<typename T, int32_t INITIAL_CAPACITY>
+inline auto BitContainer<T, INITIAL_CAPACITY>::Raw()
+{
+	return std::tuple<std::vector<Word>&, std::vector<T>&>{ m_bits,m_data };
+}
+
+template<typename T, int32_t INITIAL_CAPACITY>
+inline std::vector<T>& BitContainer<T, INITIAL_CAPACITY>::buffer()
 {
 	return m_data;
 }
 
-template<typename T, int32_t MAX_OBJECTS>
-inline T& BitContainer<T, MAX_OBJECTS>::operator[](size_t i)
+template<typename T, int32_t INITIAL_CAPACITY>
+inline T& BitContainer<T, INITIAL_CAPACITY>::operator[](size_t i)
 {
-	return Get(i);
+	return Get(static_cast<int32_t>(i));
 }
 
-template<typename T, int32_t MAX_OBJECTS>
-inline typename BitContainer<T, MAX_OBJECTS>::Iterator& BitContainer<T, MAX_OBJECTS>::Iterator::operator++()
+template<typename T, int32_t INITIAL_CAPACITY>
+inline size_t BitContainer<T, INITIAL_CAPACITY>::FindNext(const std::vector<Word>& bits, size_t i)
 {
-	size_t i = m_ptr - m_begin;
-	while (++i < m_b->size())
+	size_t w = i / s_wordBits;
+	if (w >= bits.size())
 	{
-		if ((*m_b)[i] == true)
+		return bits.size() * s_wordBits;
+	}
+
+	// mask off the bits before i in the first word, then skip whole empty words
+	Word word = bits[w] & (~Word(0) << (i % s_wordBits));
+	while (word == 0)
+	{
+		if (++w == bits.size())
 		{
-			m_ptr = m_begin + i;
-			return *this;
+			return bits.size() * s_wordBits;
 		}
-	};
-	m_ptr = m_end;
+		word = bits[w];
+	}
+	return w * s_wordBits + std::countr_zero(word);
+}
+
+template<typename T, int32_t INITIAL_CAPACITY>
+inline void BitContainer<T, INITIAL_CAPACITY>::Grow()
+{
+	const size_t oldCapacity = m_data.size();
+	// capacity stays a multiple of the word size so FindNext never reads past the data
+	const size_t newCapacity = oldCapacity ? oldCapacity * 2 
+		: ((std::max<size_t>(INITIAL_CAPACITY, 1) + s_wordBits - 1) / s_wordBits) * s_wordBits;
+
+	m_data.resize(newCapacity);
+	m_generations.resize(newCapacity);
+	m_bits.resize(newCapacity / s_wordBits);
+
+	m_freeList.reserve(newCapacity);
+	for (size_t i = newCapacity; i > oldCapacity; --i)
+	{
+		m_freeList.push_back(static_cast<int32_t>(i - 1));
+	}
+}
+
+template<typename T, int32_t INITIAL_CAPACITY>
+inline typename BitContainer<T, INITIAL_CAPACITY>::Iterator& BitContainer<T, INITIAL_CAPACITY>::Iterator::operator++()
+{
+	size_t i = FindNext(*m_b, (m_ptr - m_begin) + 1);
+	m_ptr = m_begin + i;
 	return *this;
 }
 
-template<typename T, int32_t MAX_OBJECTS>
-inline size_t BitContainer<T, MAX_OBJECTS>::Iterator::index() const
+template<typename T, int32_t INITIAL_CAPACITY>
+inline size_t BitContainer<T, INITIAL_CAPACITY>::Iterator::index() const
 {
 	return m_ptr - m_begin;
 }
@@ -16,6 +16,11 @@ Technology is prohibited.
 #include <algorithm>
 #include <iostream>
 
+#if defined(_M_X64) || defined(__SSE2__)
+#define OO_COLL_SSE 1
+#include <emmintrin.h>
+#endif
+
 namespace oGFX::coll
 {
 
@@ -554,4 +559,144 @@ Collision AABBInFrustum(const Frustum& frustum, const AABB& a, bool draw)
 	return Collision::CONTAINS;
 }
 
+void AABBBatch::clear()
+{
+	minX.clear(); minY.clear(); minZ.clear();
+	maxX.clear(); maxY.clear(); maxZ.clear();
+}
+
+void AABBBatch::reserve(size_t n)
+{
+	minX.reserve(n); minY.reserve(n); minZ.reserve(n);
+	maxX.reserve(n); maxY.reserve(n); maxZ.reserve(n);
+}
+
+void AABBBatch::push_back(const AABB& a)
+{
+	// same corners as AABBInFrustum builds
+	const Point3D bmin = a.min();
+	const Point3D bmax = a.max();
+	minX.push_back(bmin.x); minY.push_back(bmin.y); minZ.push_back(bmin.z);
+	maxX.push_back(bmax.x); maxY.push_back(bmax.y); maxZ.push_back(bmax.z);
+}
+
+size_t AABBBatch::size() const
+{
+	return minX.size();
+}
+
+// Instead of testing all 8 corners, each plane only tests the corner furthest along the plane normal and the
+// corner furthest against it. Float multiply and add are monotonic so these are exactly the largest and smallest
+// of the 8 corner distances AABBInFrustum computes, giving the same classification.
+// A box is outside when every corner is on or in front of a plane (smallest distance >= 0),
+// and intersects when some plane does not have every corner behind it (largest distance >= 0).
+namespace {
+struct BatchPlane
+{
+	float nx, ny, nz, w;
+	// which array gives the largest distance per axis, the smallest uses the other one
+	bool posX, posY, posZ;
+};
+
+void GetBatchPlanes(const Frustum& f, BatchPlane (&planes)[6])
+{
+	const Plane* src[6]{ &f.left, &f.right, &f.top, &f.bottom, &f.planeFar, &f.planeNear };
+	for (size_t i = 0; i < 6; i++)
+	{
+		const glm::vec4& n = src[i]->normal;
+		planes[i] = BatchPlane{ n.x, n.y, n.z, n.w, n.x >= 0.0f, n.y >= 0.0f, n.z >= 0.0f };
+	}
+}
+
+Collision Classify(bool outside, bool intersects)
+{
+	if (outside) return Collision::OUTSIDE;
+	return intersects ? Collision::INTERSECTS : Collision::CONTAINS;
+}
+
+void ClassifyRangeScalar(const BatchPlane (&planes)[6], const AABBBatch& b, size_t begin, size_t end, Collision* results)
+{
+	for (size_t i = begin; i < end; i++)
+	{
+		bool outside = false;
+		bool intersects = false;
+		for (const BatchPlane& p : planes)
+		{
+			const float hiX = p.posX ? b.maxX[i] : b.minX[i];
+			const float hiY = p.posY ? b.maxY[i] : b.minY[i];
+			const float hiZ = p.posZ ? b.maxZ[i] : b.minZ[i];
+			const float loX = p.posX ? b.minX[i] : b.maxX[i];
+			const float loY = p.posY ? b.minY[i] : b.maxY[i];
+			const float loZ = p.posZ ? b.minZ[i] : b.maxZ[i];
+
+			// same operation order as DistanceToPoint
+			const float tHi = ((p.nx * hiX + p.ny * hiY) + p.nz * hiZ) - p.w;
+			const float tLo = ((p.nx * loX + p.ny * loY) + p.nz * loZ) - p.w;
+			outside = outside || (tLo >= 0.0f);
+			intersects = intersects || (tHi >= 0.0f);
+		}
+		results[i] = Classify(outside, intersects);
+	}
+}
+} // end anonymous namespace
+
+void AABBInFrustumBatchScalar(const Frustum& f, const AABBBatch& boxes, Collision* results)
+{
+	BatchPlane planes[6];
+	GetBatchPlanes(f, planes);
+	ClassifyRangeScalar(planes, boxes, 0, boxes.size(), results);
+}
+
+void AABBInFrustumBatch(const Frustum& f, const AABBBatch& boxes, Collision* results)
+{
+	BatchPlane planes[6];
+	GetBatchPlanes(f, planes);
+
+	size_t i = 0;
+#if OO_COLL_SSE
+	const size_t simdEnd = boxes.size() & ~size_t(3);
+	const __m128 zero = _mm_setzero_ps();
+	for (; i < simdEnd; i += 4)
+	{
+		__m128 outside = _mm_setzero_ps();
+		__m128 intersects = _mm_setzero_ps();
+		const __m128 minX = _mm_loadu_ps(boxes.minX.data() + i);
+		const __m128 minY = _mm_loadu_ps(boxes.minY.data() + i);
+		const __m128 minZ = _mm_loadu_ps(boxes.minZ.data() + i);
+		const __m128 maxX = _mm_loadu_ps(boxes.maxX.data() + i);
+		const __m128 maxY = _mm_loadu_ps(boxes.maxY.data() + i);
+		const __m128 maxZ = _mm_loadu_ps(boxes.maxZ.data() + i);
+
+		for (const BatchPlane& p : planes)
+		{
+			const __m128 nx = _mm_set1_ps(p.nx);
+			const __m128 ny = _mm_set1_ps(p.ny);
+			const __m128 nz = _mm_set1_ps(p.nz);
+			const __m128 w = _mm_set1_ps(p.w);
+
+			const __m128 tHi = _mm_sub_ps(_mm_add_ps(_mm_add_ps(
+				_mm_mul_ps(nx, p.posX ? maxX : minX),
+				_mm_mul_ps(ny, p.posY ? maxY : minY)),
+				_mm_mul_ps(nz, p.posZ ? maxZ : minZ)), w);
+			const __m128 tLo = _mm_sub_ps(_mm_add_ps(_mm_add_ps(
+				_mm_mul_ps(nx, p.posX ? minX : maxX),
+				_mm_mul_ps(ny, p.posY ? minY : maxY)),
+				_mm_mul_ps(nz, p.posZ ? minZ : maxZ)), w);
+
+			outside = _mm_or_ps(outside, _mm_cmpge_ps(tLo, zero));
+			intersects = _mm_or_ps(intersects, _mm_cmpge_ps(tHi, zero));
+		}
+
+		const int outMask = _mm_movemask_ps(outside);
+		const int intMask = _mm_movemask_ps(intersects);
+		for (int lane = 0; lane < 4; lane++)
+		{
+			results[i + lane] = Classify(outMask & (1 << lane), intMask & (1 << lane));
+		}
+	}
+#endif
+	// remainder, or everything without SSE
+	ClassifyRangeScalar(planes, boxes, i, boxes.size(), results);
+}
+
 }// end namespace oGFX::coll
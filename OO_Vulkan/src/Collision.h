@@ -13,6 +13,7 @@ Technology is prohibited.
 *//*************************************************************************************/
 #pragma once
 #include "Geometry.h"
+#include <vector>
 
 namespace oGFX::coll
 {
@@ -85,4 +86,20 @@ bool PlaneAabb(const Plane& p, const AABB& a, float& t);
 bool SphereInFrustum(const Frustum& f, const Sphere& s);
 Collision AABBInFrustum(const Frustum& f, const AABB& a, bool draw = false);
 
+// Boxes stored as separate min/max arrays so several boxes can be tested per SIMD iteration
+struct AABBBatch
+{
+	std::vector<float> minX, minY, minZ;
+	std::vector<float> maxX, maxY, maxZ;
+
+	void clear();
+	void reserve(size_t n);
+	void push_back(const AABB& a);
+	size_t size() const;
+};
+
+// Classifies every box in the batch, results match AABBInFrustum for each box
+void AABBInFrustumBatch(const Frustum& f, const AABBBatch& boxes, Collision* results);
+void AABBInFrustumBatchScalar(const Frustum& f, const AABBBatch& boxes, Collision* results);
+
 }// end namespace oGFX::coll
@@ -19,7 +19,12 @@ Technology is prohibited.
 #include "CommandBufferManager.h"
 #include "Profiling.h"
 
-const size_t MAX_THREADS = std::thread::hardware_concurrency();
+uint32_t oGFX::MaxMappedThreads()
+{
+    return std::thread::hardware_concurrency() + 1;
+}
+
+const size_t MAX_THREADS = oGFX::MaxMappedThreads();
 
 VkResult oGFX::CommandBufferManager::InitPool(VkDevice device, uint32_t queueIndex)
 {
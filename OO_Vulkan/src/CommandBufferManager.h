@@ -25,6 +25,10 @@ namespace oGFX
 		SUBMITTED = 2,
 };
 
+// Threads with their own pools, the task manager's threads, the thread that made the renderer
+// and one recording thread outside the task manager. See VulkanRenderer::GetThreadMapping
+uint32_t MaxMappedThreads();
+
 class CommandBufferManager
 {
 public:
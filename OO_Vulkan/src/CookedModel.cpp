@@ -0,0 +1,637 @@
+/************************************************************************************//*!
+\file           CookedModel.cpp
+\project        Ouroboros
+\author         Jamie Kong, j.kong, 390004720 | code contribution (100%)
+\par            email: j.kong\@digipen.edu
+\date           May 30, 2024
+\brief              Defines the cooked model format, an imported model written out as flat
+arrays that load by mapping the file instead of running assimp again
+
+Copyright (C) 2022 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents
+without the prior written consent of DigiPen Institute of
+Technology is prohibited.
+*//*************************************************************************************/
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "CookedModel.h"
+#include "Profiling.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <type_traits>
+
+namespace oGFX::CookedModel
+{
+
+namespace
+{
+	constexpr uint32_t MAGIC = 0x534d4f4f; // "OOMS"
+	constexpr uint32_t NONE = static_cast<uint32_t>(-1);
+	constexpr uint64_t SECTION_ALIGNMENT = 16;
+
+	enum Section : uint32_t
+	{
+		VERTICES,
+		INDICES,
+		SUBMESHES,
+		SUBMESH_MATERIALS,
+		MATERIALS,
+		IMPORT_REPORTS,
+		MESHLETS,
+		MESHLET_VERTICES,
+		MESHLET_TRIANGLES,
+		NODES,
+		INVERSE_BIND_POSE,
+		BONE_WEIGHTS,
+		BONES,
+		BONE_NAMES,
+		STRINGS,
+		SECTION_COUNT
+	};
+
+	struct SectionInfo
+	{
+		uint64_t offset;
+		uint64_t count;
+		uint64_t stride; // size of the element it was cooked with, anything else is another layout
+	};
+
+	struct Header
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint64_t sourceHash;
+		uint32_t numSubmesh;
+		uint32_t sceneMeshCount;
+		uint32_t hasSkeleton;
+		uint32_t reserved;
+		SectionInfo sections[SECTION_COUNT];
+	};
+
+	struct StringRef
+	{
+		uint32_t offset;
+		uint32_t length;
+	};
+
+	struct CookedSubmesh
+	{
+		StringRef name;
+		uint32_t baseVertex;
+		uint32_t vertexCount;
+		uint32_t baseIndices;
+		uint32_t indicesCount;
+		float bounds[4];
+		uint32_t meshletOffset;
+		uint32_t meshletCount;
+	};
+
+	// texture paths relative to the source's folder
+	struct CookedMaterial
+	{
+		StringRef albedo;
+		StringRef normal;
+		StringRef specular;
+		StringRef roughness;
+	};
+
+	// the trees are stored parents first, the root has no parent
+	struct CookedNode
+	{
+		uint32_t parent;
+		StringRef name;
+		uint32_t meshRef;
+		glm::mat4 transform;
+	};
+
+	struct CookedBone
+	{
+		uint32_t parent;
+		StringRef name;
+		uint32_t boneIndex;
+		uint32_t isBoneNode;
+		glm::mat4 modelSpaceLocal;
+		glm::mat4 modelSpaceGlobal;
+	};
+
+	struct CookedBoneName
+	{
+		StringRef name;
+		uint32_t index;
+	};
+
+	// Read only view of a whole file, empty when it cannot be opened
+	class MappedFile
+	{
+	public:
+		explicit MappedFile(const std::string& path)
+		{
+#if defined(_WIN32)
+			m_file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+				FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+			LARGE_INTEGER size{};
+			if (m_file == INVALID_HANDLE_VALUE || GetFileSizeEx(m_file, &size) == FALSE || size.QuadPart == 0)
+				return;
+			m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			if (m_mapping == nullptr)
+				return;
+			m_data = static_cast<const uint8_t*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+			m_size = m_data ? static_cast<size_t>(size.QuadPart) : 0;
+#else
+			const int fd = open(path.c_str(), O_RDONLY);
+			if (fd < 0)
+				return;
+			struct stat info{};
+			if (fstat(fd, &info) == 0 && info.st_size > 0)
+			{
+				void* view = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+				if (view != MAP_FAILED)
+				{
+					m_data = static_cast<const uint8_t*>(view);
+					m_size = static_cast<size_t>(info.st_size);
+				}
+			}
+			close(fd);
+#endif
+		}
+
+		~MappedFile()
+		{
+#if defined(_WIN32)
+			if (m_data) UnmapViewOfFile(m_data);
+			if (m_mapping) CloseHandle(m_mapping);
+			if (m_file != INVALID_HANDLE_VALUE) CloseHandle(m_file);
+#else
+			if (m_data) munmap(const_cast<uint8_t*>(m_data), m_size);
+#endif
+		}
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		const uint8_t* data() const { return m_data; }
+		size_t size() const { return m_size; }
+
+	private:
+		const uint8_t* m_data{ nullptr };
+		size_t m_size{};
+#if defined(_WIN32)
+		HANDLE m_file{ INVALID_HANDLE_VALUE };
+		HANDLE m_mapping{ nullptr };
+#endif
+	};
+
+	// The section's elements in place, null when they are not the layout expected or run past the file
+	template <typename T>
+	const T* View(const MappedFile& file, const SectionInfo& section)
+	{
+		static_assert(std::is_trivially_copyable_v<T>);
+		if (section.stride != sizeof(T) || section.offset % alignof(T) != 0 || section.offset > file.size()
+			|| section.count > (file.size() - section.offset) / sizeof(T))
+		{
+			return nullptr;
+		}
+		return reinterpret_cast<const T*>(file.data() + section.offset);
+	}
+
+	template <typename T>
+	void AddSection(std::vector<uint8_t>& bytes, SectionInfo& section, const T* data, size_t count)
+	{
+		static_assert(std::is_trivially_copyable_v<T>);
+		bytes.resize((bytes.size() + SECTION_ALIGNMENT - 1) / SECTION_ALIGNMENT * SECTION_ALIGNMENT);
+		section = { bytes.size(), count, sizeof(T) };
+		const uint8_t* first = reinterpret_cast<const uint8_t*>(data);
+		bytes.insert(bytes.end(), first, first + count * sizeof(T));
+	}
+
+	template <typename T>
+	void AddSection(std::vector<uint8_t>& bytes, SectionInfo& section, const std::vector<T>& data)
+	{
+		AddSection(bytes, section, data.data(), data.size());
+	}
+}
+
+std::string CookedPath(const std::string& source)
+{
+	return source + ".oomesh";
+}
+
+uint64_t HashSource(const std::string& source)
+{
+	PROFILE_SCOPED();
+
+	MappedFile file(source);
+	const uint8_t* bytes = file.data();
+	const size_t size = file.size();
+
+	// eight bytes a step, hashing must stay far cheaper than the import it saves
+	uint64_t hash = 0xcbf29ce484222325ull;
+	size_t i = 0;
+	for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t))
+	{
+		uint64_t word;
+		memcpy(&word, bytes + i, sizeof(word));
+		hash = (hash ^ word) * 0x100000001b3ull;
+	}
+	for (; i < size; i++)
+	{
+		hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+	}
+	return (hash ^ size) * 0x100000001b3ull;
+}
+
+bool Write(const std::string& cookedPath, const ModelImport::Model& model, uint64_t sourceHash)
+{
+	PROFILE_SCOPED();
+
+	const ModelFileResource& resource = *model.resource;
+
+	std::string strings;
+	auto addString = [&strings](const std::string& s) {
+		const StringRef ref{ static_cast<uint32_t>(strings.size()), static_cast<uint32_t>(s.size()) };
+		strings += s;
+		return ref;
+	};
+
+	std::vector<CookedSubmesh> submeshes;
+	submeshes.reserve(model.submeshes.size());
+	for (const SubMesh& sm : model.submeshes)
+	{
+		const oGFX::Sphere& bounds = sm.boundingSphere;
+		submeshes.push_back({ addString(sm.name), sm.baseVertex, sm.vertexCount, sm.baseIndices, sm.indicesCount,
+			{ bounds.center.x, bounds.center.y, bounds.center.z, bounds.radius }, sm.meshletOffset, sm.meshletCount });
+	}
+
+	// the import prefixes the source's folder, which is not where the source will be loaded from
+	const std::string folder = std::filesystem::path(resource.fileName).remove_filename().string();
+	auto addTexture = [&](const std::string& path) {
+		const bool inFolder = path.compare(0, folder.size(), folder) == 0;
+		return addString(inFolder ? path.substr(folder.size()) : path);
+	};
+	std::vector<CookedMaterial> materials;
+	materials.reserve(resource.materials.size());
+	for (const Material& m : resource.materials)
+	{
+		materials.push_back({ addTexture(m.albedo), addTexture(m.normal), addTexture(m.specular), addTexture(m.roughness) });
+	}
+
+	std::vector<CookedNode> nodes;
+	auto flattenNode = [&](auto&& self, const Node* node, uint32_t parent) -> void {
+		const uint32_t index = static_cast<uint32_t>(nodes.size());
+		nodes.push_back({ parent, addString(node->name), node->meshRef, node->transform });
+		for (const Node* child : node->children)
+		{
+			self(self, child, index);
+		}
+	};
+	if (resource.sceneInfo)
+	{
+		flattenNode(flattenNode, resource.sceneInfo, NONE);
+	}
+
+	std::vector<CookedBone> bones;
+	auto flattenBone = [&](auto&& self, const oGFX::BoneNode* bone, uint32_t parent) -> void {
+		const uint32_t index = static_cast<uint32_t>(bones.size());
+		bones.push_back({ parent, addString(bone->mName), bone->m_BoneIndex, bone->mbIsBoneNode ? 1u : 0u,
+			bone->mModelSpaceLocal, bone->mModelSpaceGlobal });
+		for (const oGFX::BoneNode* child : bone->mChildren)
+		{
+			self(self, child, index);
+		}
+	};
+	if (model.skeleton && model.skeleton->m_boneNodes)
+	{
+		flattenBone(flattenBone, model.skeleton->m_boneNodes, NONE);
+	}
+
+	// in bone order so the same model always cooks to the same bytes
+	std::vector<std::pair<uint32_t, std::string>> sortedBones;
+	for (const auto& [name, index] : resource.strToBone)
+	{
+		sortedBones.emplace_back(index, name);
+	}
+	std::sort(sortedBones.begin(), sortedBones.end());
+	std::vector<CookedBoneName> boneNames;
+	for (const auto& [index, name] : sortedBones)
+	{
+		boneNames.push_back({ addString(name), index });
+	}
+
+	Header header{};
+	header.magic = MAGIC;
+	header.version = VERSION;
+	header.sourceHash = sourceHash;
+	header.numSubmesh = resource.numSubmesh;
+	header.sceneMeshCount = resource.sceneMeshCount;
+	header.hasSkeleton = model.skeleton ? 1 : 0;
+
+	std::vector<uint8_t> bytes(sizeof(Header));
+	auto& sections = header.sections;
+	AddSection(bytes, sections[VERTICES], resource.vertices);
+	AddSection(bytes, sections[INDICES], resource.indices);
+	AddSection(bytes, sections[SUBMESHES], submeshes);
+	AddSection(bytes, sections[SUBMESH_MATERIALS], resource.submeshToMaterial);
+	AddSection(bytes, sections[MATERIALS], materials);
+	AddSection(bytes, sections[IMPORT_REPORTS], resource.importReports);
+	AddSection(bytes, sections[MESHLETS], resource.meshlets.meshlets);
+	AddSection(bytes, sections[MESHLET_VERTICES], resource.meshlets.vertices);
+	AddSection(bytes, sections[MESHLET_TRIANGLES], resource.meshlets.triangles);
+	AddSection(bytes, sections[NODES], nodes);
+	if (model.skeleton)
+	{
+		AddSection(bytes, sections[INVERSE_BIND_POSE], model.skeleton->inverseBindPose);
+		AddSection(bytes, sections[BONE_WEIGHTS], model.skeleton->boneWeights);
+	}
+	else
+	{
+		AddSection<oGFX::BoneInverseBindPoseInfo>(bytes, sections[INVERSE_BIND_POSE], nullptr, 0);
+		AddSection<BoneWeight>(bytes, sections[BONE_WEIGHTS], nullptr, 0);
+	}
+	AddSection(bytes, sections[BONES], bones);
+	AddSection(bytes, sections[BONE_NAMES], boneNames);
+	AddSection(bytes, sections[STRINGS], strings.data(), strings.size());
+	memcpy(bytes.data(), &header, sizeof(Header));
+
+	// written beside and moved over so a reader never maps half a file
+	const std::string temp = cookedPath + ".tmp";
+	{
+		std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+		file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+		if (!file)
+		{
+			file.close();
+			std::error_code ec;
+			std::filesystem::remove(temp, ec);
+			return false;
+		}
+	}
+	std::error_code ec;
+	std::filesystem::rename(temp, cookedPath, ec);
+	if (ec)
+	{
+		std::filesystem::remove(temp, ec);
+		return false;
+	}
+	return true;
+}
+
+bool Read(const std::string& cookedPath, const std::string& source, uint64_t sourceHash, ModelImport::Model& out)
+{
+	PROFILE_SCOPED();
+
+	MappedFile file(cookedPath);
+	if (file.size() < sizeof(Header))
+	{
+		return false;
+	}
+	Header header;
+	memcpy(&header, file.data(), sizeof(Header));
+	if (header.magic != MAGIC || header.version != VERSION || header.sourceHash != sourceHash)
+	{
+		return false;
+	}
+
+	const auto& sections = header.sections;
+	const auto* vertices = View<oGFX::Vertex>(file, sections[VERTICES]);
+	const auto* indices = View<uint32_t>(file, sections[INDICES]);
+	const auto* submeshes = View<CookedSubmesh>(file, sections[SUBMESHES]);
+	const auto* submeshMaterials = View<uint32_t>(file, sections[SUBMESH_MATERIALS]);
+	const auto* materials = View<CookedMaterial>(file, sections[MATERIALS]);
+	const auto* reports = View<oGFX::MeshOpt::Report>(file, sections[IMPORT_REPORTS]);
+	const auto* meshlets = View<GPUMeshlet>(file, sections[MESHLETS]);
+	const auto* meshletVertices = View<uint32_t>(file, sections[MESHLET_VERTICES]);
+	const auto* meshletTriangles = View<uint32_t>(file, sections[MESHLET_TRIANGLES]);
+	const auto* nodes = View<CookedNode>(file, sections[NODES]);
+	const auto* inverseBindPose = View<oGFX::BoneInverseBindPoseInfo>(file, sections[INVERSE_BIND_POSE]);
+	const auto* boneWeights = View<BoneWeight>(file, sections[BONE_WEIGHTS]);
+	const auto* bones = View<CookedBone>(file, sections[BONES]);
+	const auto* boneNames = View<CookedBoneName>(file, sections[BONE_NAMES]);
+	const auto* strings = View<char>(file, sections[STRINGS]);
+	if (!vertices || !indices || !submeshes || !submeshMaterials || !materials || !reports || !meshlets
+		|| !meshletVertices || !meshletTriangles || !nodes || !inverseBindPose || !boneWeights || !bones
+		|| !boneNames || !strings)
+	{
+		return false;
+	}
+
+	auto count = [&sections](Section section) { return static_cast<size_t>(sections[section].count); };
+	const size_t stringBytes = count(STRINGS);
+	auto validString = [stringBytes](StringRef ref) { return uint64_t(ref.offset) + ref.length <= stringBytes; };
+	auto text = [strings](StringRef ref) { return std::string(strings + ref.offset, ref.length); };
+
+	if (header.numSubmesh != count(SUBMESHES) || count(SUBMESH_MATERIALS) != count(SUBMESHES)
+		|| (header.hasSkeleton && count(BONE_WEIGHTS) != count(VERTICES)))
+	{
+		return false;
+	}
+
+	ModelImport::Model model;
+	model.resource = std::make_unique<ModelFileResource>(source);
+	ModelFileResource& resource = *model.resource;
+	resource.numSubmesh = header.numSubmesh;
+	resource.sceneMeshCount = header.sceneMeshCount;
+
+	// whole arrays, the layout on disk is the layout in memory
+	resource.vertices.assign(vertices, vertices + count(VERTICES));
+	resource.indices.assign(indices, indices + count(INDICES));
+	resource.submeshToMaterial.assign(submeshMaterials, submeshMaterials + count(SUBMESH_MATERIALS));
+	resource.importReports.assign(reports, reports + count(IMPORT_REPORTS));
+	resource.meshlets.meshlets.assign(meshlets, meshlets + count(MESHLETS));
+	resource.meshlets.vertices.assign(meshletVertices, meshletVertices + count(MESHLET_VERTICES));
+	resource.meshlets.triangles.assign(meshletTriangles, meshletTriangles + count(MESHLET_TRIANGLES));
+
+	// meshlets must stay inside their vertices and triangles
+	for (size_t i = 0; i < count(MESHLETS); i++)
+	{
+		const GPUMeshlet& meshlet = meshlets[i];
+		if (uint64_t(meshlet.vertexOffset) + meshlet.vertexCount > count(MESHLET_VERTICES)
+			|| uint64_t(meshlet.triangleOffset) + meshlet.triangleCount > count(MESHLET_TRIANGLES))
+		{
+			return false;
+		}
+	}
+
+	// the submeshes must stay inside the arrays, the renderer uploads their ranges as they are
+	model.submeshes.resize(count(SUBMESHES));
+	for (size_t i = 0; i < model.submeshes.size(); i++)
+	{
+		const CookedSubmesh& cooked = submeshes[i];
+		if (validString(cooked.name) == false
+			|| uint64_t(cooked.baseVertex) + cooked.vertexCount > resource.vertices.size()
+			|| uint64_t(cooked.baseIndices) + cooked.indicesCount > resource.indices.size()
+			|| uint64_t(cooked.meshletOffset) + cooked.meshletCount > resource.meshlets.meshlets.size())
+		{
+			return false;
+		}
+		// the GPU follows every index without checking, they are relative to the submesh's base vertex
+		for (uint32_t k = cooked.baseIndices; k < cooked.baseIndices + cooked.indicesCount; k++)
+		{
+			if (indices[k] >= cooked.vertexCount)
+			{
+				return false;
+			}
+		}
+		for (uint32_t m = cooked.meshletOffset; m < cooked.meshletOffset + cooked.meshletCount; m++)
+		{
+			const GPUMeshlet& meshlet = meshlets[m];
+			for (uint32_t v = meshlet.vertexOffset; v < meshlet.vertexOffset + meshlet.vertexCount; v++)
+			{
+				if (meshletVertices[v] >= cooked.vertexCount)
+				{
+					return false;
+				}
+			}
+			for (uint32_t t = meshlet.triangleOffset; t < meshlet.triangleOffset + meshlet.triangleCount; t++)
+			{
+				for (uint32_t corner = 0; corner < 3; corner++)
+				{
+					if (((meshletTriangles[t] >> (corner * 8)) & 0xff) >= meshlet.vertexCount)
+					{
+						return false;
+					}
+				}
+			}
+		}
+		SubMesh& sm = model.submeshes[i];
+		sm.name = text(cooked.name);
+		sm.baseVertex = cooked.baseVertex;
+		sm.vertexCount = cooked.vertexCount;
+		sm.baseIndices = cooked.baseIndices;
+		sm.indicesCount = cooked.indicesCount;
+		sm.boundingSphere = oGFX::Sphere{ { cooked.bounds[0], cooked.bounds[1], cooked.bounds[2] }, cooked.bounds[3] };
+		sm.meshletOffset = cooked.meshletOffset;
+		sm.meshletCount = cooked.meshletCount;
+	}
+
+	const std::string folder = std::filesystem::path(source).remove_filename().string();
+	auto texture = [&](StringRef ref) { return ref.length ? folder + text(ref) : std::string{}; };
+	resource.materials.resize(count(MATERIALS));
+	for (size_t i = 0; i < resource.materials.size(); i++)
+	{
+		const CookedMaterial& cooked = materials[i];
+		if (!validString(cooked.albedo) || !validString(cooked.normal) || !validString(cooked.specular) || !validString(cooked.roughness))
+		{
+			return false;
+		}
+		Material& m = resource.materials[i];
+		m.albedo = texture(cooked.albedo);
+		m.normal = texture(cooked.normal);
+		m.specular = texture(cooked.specular);
+		m.roughness = texture(cooked.roughness);
+	}
+
+	// a parent always comes before its children, the tree belongs to the resource as soon as a node is made
+	std::vector<Node*> sceneNodes(count(NODES));
+	for (size_t i = 0; i < sceneNodes.size(); i++)
+	{
+		const CookedNode& cooked = nodes[i];
+		const bool validParent = i == 0 ? cooked.parent == NONE : cooked.parent < i;
+		const bool validMesh = cooked.meshRef == NONE || cooked.meshRef < header.numSubmesh;
+		if (validParent == false || validMesh == false || validString(cooked.name) == false)
+		{
+			return false;
+		}
+		Node* node = new Node();
+		node->name = text(cooked.name);
+		node->meshRef = cooked.meshRef;
+		node->transform = cooked.transform;
+		if (i == 0)
+		{
+			resource.sceneInfo = node;
+		}
+		else
+		{
+			node->parent = sceneNodes[cooked.parent];
+			node->parent->children.push_back(node);
+		}
+		sceneNodes[i] = node;
+	}
+
+	if (header.hasSkeleton)
+	{
+		model.skeleton = std::make_unique<oGFX::Skeleton>();
+		oGFX::Skeleton& skeleton = *model.skeleton;
+		resource.skeleton = &skeleton;
+		skeleton.inverseBindPose.assign(inverseBindPose, inverseBindPose + count(INVERSE_BIND_POSE));
+		skeleton.boneWeights.assign(boneWeights, boneWeights + count(BONE_WEIGHTS));
+		// skinning reads all four bones of a vertex whatever their weight
+		const size_t numBones = skeleton.inverseBindPose.size();
+		for (const BoneWeight& weight : skeleton.boneWeights)
+		{
+			for (uint32_t bone : weight.boneIdx)
+			{
+				if (bone >= numBones)
+				{
+					return false;
+				}
+			}
+		}
+
+		std::vector<oGFX::BoneNode*> boneNodes(count(BONES));
+		for (size_t i = 0; i < boneNodes.size(); i++)
+		{
+			const CookedBone& cooked = bones[i];
+			const bool validParent = i == 0 ? cooked.parent == NONE : cooked.parent < i;
+			// only the nodes that skin have to point at a bone
+			const bool validBone = cooked.boneIndex < numBones || (cooked.boneIndex == NONE && cooked.isBoneNode == 0);
+			if (validParent == false || validBone == false || validString(cooked.name) == false)
+			{
+				return false;
+			}
+			oGFX::BoneNode* bone = new oGFX::BoneNode();
+			bone->mName = text(cooked.name);
+			bone->m_BoneIndex = cooked.boneIndex;
+			bone->mbIsBoneNode = cooked.isBoneNode != 0;
+			bone->mModelSpaceLocal = cooked.modelSpaceLocal;
+			bone->mModelSpaceGlobal = cooked.modelSpaceGlobal;
+			if (i == 0)
+			{
+				skeleton.m_boneNodes = bone;
+			}
+			else
+			{
+				bone->mpParent = boneNodes[cooked.parent];
+				bone->mpParent->mChildren.push_back(bone);
+			}
+			boneNodes[i] = bone;
+		}
+	}
+
+	for (size_t i = 0; i < count(BONE_NAMES); i++)
+	{
+		if (validString(boneNames[i].name) == false)
+		{
+			return false;
+		}
+		resource.strToBone[text(boneNames[i].name)] = boneNames[i].index;
+	}
+
+	out = std::move(model);
+	return true;
+}
+
+bool Load(const std::string& source, ModelImport::Model& out)
+{
+	const std::string cooked = CookedPath(source);
+	// nothing to hash the source against
+	if (std::filesystem::exists(cooked) == false)
+	{
+		return false;
+	}
+	return Read(cooked, source, HashSource(source), out);
+}
+
+}
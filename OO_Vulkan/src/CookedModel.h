@@ -0,0 +1,43 @@
+/************************************************************************************//*!
+\file           CookedModel.h
+\project        Ouroboros
+\author         Jamie Kong, j.kong, 390004720 | code contribution (100%)
+\par            email: j.kong\@digipen.edu
+\date           May 30, 2024
+\brief              Declares the cooked model format, an imported model written out as flat
+arrays that load by mapping the file instead of running assimp again
+
+Copyright (C) 2022 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents
+without the prior written consent of DigiPen Institute of
+Technology is prohibited.
+*//*************************************************************************************/
+#pragma once
+
+#include "ModelImporter.h"
+
+#include <cstdint>
+#include <string>
+
+namespace oGFX::CookedModel
+{
+	// Bumped whenever the import or the layout changes, older files are cooked again
+	constexpr uint32_t VERSION = 1;
+
+	// "Models/bunny.ply" cooks to "Models/bunny.ply.oomesh", next to its source
+	std::string CookedPath(const std::string& source);
+
+	// FNV-1a of the source's bytes, a cooked file only stands in for the bytes it was cooked from
+	uint64_t HashSource(const std::string& source);
+
+	// Writes the model with the hash of its source, false when the file could not be written
+	bool Write(const std::string& cookedPath, const ModelImport::Model& model, uint64_t sourceHash);
+
+	// Maps the cooked file and copies every array out whole. False and the model untouched when the file is
+	// missing, from another version or layout, cooked from other bytes or does not hold together.
+	// Material textures are found relative to the source.
+	bool Read(const std::string& cookedPath, const std::string& source, uint64_t sourceHash, ModelImport::Model& out);
+
+	// Read from the source's cooked path, when it was cooked from the source as it is now
+	bool Load(const std::string& source, ModelImport::Model& out);
+}
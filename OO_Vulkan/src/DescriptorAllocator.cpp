@@ -18,30 +18,38 @@ Technology is prohibited.
 void DescriptorAllocator::ResetPools()
 {
 	PROFILE_SCOPED();
-	std::scoped_lock lock{ *m_mut };
-	for (auto p : usedPools){
-		vkResetDescriptorPool(device, p, 0);
-		freePools.push_back(p);
-	}
+	for (ThreadPools& pools : m_threads)
+	{
+		for (auto p : pools.usedPools){
+			vkResetDescriptorPool(device, p, 0);
+			pools.freePools.push_back(p);
+		}
 
-	//clear the used pools, since we've put them all in the free pools
-	usedPools.clear();
+		//clear the used pools, since we've put them all in the free pools
+		pools.usedPools.clear();
 
-	//reset the current pool handle back to null
-	currentPool = VK_NULL_HANDLE;
+		//reset the current pool handle back to null
+		pools.currentPool = VK_NULL_HANDLE;
+
+		// the cached sets went with their pools
+		pools.setCache.clear();
+		pools.stats = {};
+	}
 }
 
-bool DescriptorAllocator::Allocate(VkDescriptorSet* set, VkDescriptorSetLayout layout)
+bool DescriptorAllocator::Allocate(VkDescriptorSet* set, VkDescriptorSetLayout layout, uint32_t threadID)
 {
-	std::scoped_lock lock{ *m_mut };
+	OO_ASSERT(threadID < m_threads.size());
+	ThreadPools& pools = m_threads[threadID];
+
 	//initialize the currentPool handle if it's null
-	if (currentPool == VK_NULL_HANDLE){
+	if (pools.currentPool == VK_NULL_HANDLE){
 
-		currentPool = GrabPool();
-		usedPools.push_back(currentPool);
+		pools.currentPool = GrabPool(pools);
+		pools.usedPools.push_back(pools.currentPool);
 	}
 
-	VkDescriptorSetAllocateInfo allocInfo = oGFX::vkutils::inits::descriptorSetAllocateInfo(currentPool,&layout,1);
+	VkDescriptorSetAllocateInfo allocInfo = oGFX::vkutils::inits::descriptorSetAllocateInfo(pools.currentPool,&layout,1);
 
 	//try to allocate the descriptor set
 	VkResult allocResult = vkAllocateDescriptorSets(device, &allocInfo, set);
@@ -50,6 +58,7 @@ bool DescriptorAllocator::Allocate(VkDescriptorSet* set, VkDescriptorSetLayout l
 	switch (allocResult) {
 	case VK_SUCCESS:
 	//all good, return
+	++pools.stats.allocated;
 	return true;
 	case VK_ERROR_FRAGMENTED_POOL:
 	case VK_ERROR_OUT_OF_POOL_MEMORY:
@@ -63,16 +72,16 @@ bool DescriptorAllocator::Allocate(VkDescriptorSet* set, VkDescriptorSetLayout l
 
 	if (needReallocate){
 		//allocate a new pool and retry
-		currentPool = GrabPool();
-		usedPools.push_back(currentPool);
+		pools.currentPool = GrabPool(pools);
+		pools.usedPools.push_back(pools.currentPool);
 
-		allocInfo.descriptorPool = currentPool;
+		allocInfo.descriptorPool = pools.currentPool;
 		allocResult = vkAllocateDescriptorSets(device, &allocInfo, set);
-		std::cout << "Descriptor set allocated: " << std::endl;;
 
 		//if it still fails then we have big issues
 		VK_CHK(allocResult);
 		if (allocResult == VK_SUCCESS){
+			++pools.stats.allocated;
 			return true;
 		}
 	}
@@ -80,34 +89,68 @@ bool DescriptorAllocator::Allocate(VkDescriptorSet* set, VkDescriptorSetLayout l
 	return false;
 }
 
-void DescriptorAllocator::Init(VkDevice newDevice)
+VkDescriptorSet DescriptorAllocator::FindCached(const DescriptorSetContent& content, uint32_t threadID)
+{
+	OO_ASSERT(threadID < m_threads.size());
+	ThreadPools& pools = m_threads[threadID];
+	auto it = pools.setCache.find(content);
+	if (it == pools.setCache.end())
+		return VK_NULL_HANDLE;
+
+	++pools.stats.cacheHits;
+	return it->second;
+}
+
+void DescriptorAllocator::AddCached(DescriptorSetContent&& content, VkDescriptorSet set, uint32_t threadID)
+{
+	OO_ASSERT(threadID < m_threads.size());
+	m_threads[threadID].setCache.emplace(std::move(content), set);
+}
+
+DescriptorAllocator::Stats DescriptorAllocator::GetStats() const
+{
+	Stats total;
+	for (const ThreadPools& pools : m_threads)
+	{
+		total.allocated += pools.stats.allocated;
+		total.cacheHits += pools.stats.cacheHits;
+		total.pools += static_cast<uint32_t>(pools.usedPools.size());
+	}
+	return total;
+}
+
+void DescriptorAllocator::Init(VkDevice newDevice, uint32_t threadCount)
 {
 	device = newDevice;
-	m_mut = std::make_unique<std::mutex>();
+	// pools are only made when a thread first allocates
+	m_threads.resize(threadCount);
 }
 
 void DescriptorAllocator::Cleanup()
 {
-	std::scoped_lock lock{ *m_mut };
 	//delete every pool held
-	for (auto p : freePools)
+	for (ThreadPools& pools : m_threads)
 	{
-		vkDestroyDescriptorPool(device, p, nullptr);
-	}
-	for (auto p : usedPools)
-	{
-		vkDestroyDescriptorPool(device, p, nullptr);
+		for (auto p : pools.freePools)
+		{
+			vkDestroyDescriptorPool(device, p, nullptr);
+		}
+		for (auto p : pools.usedPools)
+		{
+			vkDestroyDescriptorPool(device, p, nullptr);
+		}
+		pools = ThreadPools{};
 	}
 }
 
-VkDescriptorPool DescriptorAllocator::GrabPool()
+VkDescriptorPool DescriptorAllocator::GrabPool(ThreadPools& pools)
 {
 	//there are reusable pools availible
-	if (freePools.size() > 0)
+	if (pools.freePools.size() > 0)
 	{
 		//grab pool from the back of the vector and remove it from there.
-		VkDescriptorPool pool = freePools.back();
-		freePools.pop_back();
+		VkDescriptorPool pool = pools.freePools.back();
+		pools.freePools.pop_back();
 		return pool;
 	}
 	else
@@ -134,3 +177,66 @@ VkDescriptorPool DescriptorAllocator::CreatePool(VkDevice device, const Descript
 
 	return descriptorPool;
 }
+
+bool DescriptorSetContent::operator==(const DescriptorSetContent& other) const
+{
+	if (layout != other.layout || writes.size() != other.writes.size()
+		|| bufferInfos.size() != other.bufferInfos.size() || imageInfos.size() != other.imageInfos.size())
+	{
+		return false;
+	}
+	for (size_t i = 0; i < writes.size(); i++)
+	{
+		const Write& a = writes[i];
+		const Write& b = other.writes[i];
+		if (a.binding != b.binding || a.arrayElement != b.arrayElement || a.type != b.type || a.count != b.count)
+		{
+			return false;
+		}
+	}
+	for (size_t i = 0; i < bufferInfos.size(); i++)
+	{
+		const VkDescriptorBufferInfo& a = bufferInfos[i];
+		const VkDescriptorBufferInfo& b = other.bufferInfos[i];
+		if (a.buffer != b.buffer || a.offset != b.offset || a.range != b.range)
+		{
+			return false;
+		}
+	}
+	for (size_t i = 0; i < imageInfos.size(); i++)
+	{
+		const VkDescriptorImageInfo& a = imageInfos[i];
+		const VkDescriptorImageInfo& b = other.imageInfos[i];
+		if (a.sampler != b.sampler || a.imageView != b.imageView || a.imageLayout != b.imageLayout)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+size_t DescriptorSetContent::hash() const
+{
+	size_t result = 0;
+	oGFX::HashCombine(result, layout);
+	for (const Write& w : writes)
+	{
+		oGFX::HashCombine(result, w.binding);
+		oGFX::HashCombine(result, w.arrayElement);
+		oGFX::HashCombine(result, w.type);
+		oGFX::HashCombine(result, w.count);
+	}
+	for (const VkDescriptorBufferInfo& info : bufferInfos)
+	{
+		oGFX::HashCombine(result, info.buffer);
+		oGFX::HashCombine(result, info.offset);
+		oGFX::HashCombine(result, info.range);
+	}
+	for (const VkDescriptorImageInfo& info : imageInfos)
+	{
+		oGFX::HashCombine(result, info.sampler);
+		oGFX::HashCombine(result, info.imageView);
+		oGFX::HashCombine(result, info.imageLayout);
+	}
+	return result;
+}
@@ -14,9 +14,32 @@ Technology is prohibited.
 #pragma once
 #include "vulkan/vulkan.h"
 #include <vector>
-#include <mutex>
+#include <unordered_map>
 
 
+// What a written set holds, sets with equal content are interchangeable
+struct DescriptorSetContent
+{
+	struct Write
+	{
+		uint32_t binding{};
+		uint32_t arrayElement{};
+		VkDescriptorType type{};
+		uint32_t count{};
+	};
+
+	VkDescriptorSetLayout layout{ VK_NULL_HANDLE };
+	std::vector<Write> writes;
+	std::vector<VkDescriptorBufferInfo> bufferInfos;	// every write's infos in write order
+	std::vector<VkDescriptorImageInfo> imageInfos;
+
+	bool operator==(const DescriptorSetContent& other) const;
+
+	size_t hash() const;
+};
+
+// One allocator per frame in flight. Every mapped thread has its own pools, see VulkanRenderer::RegisterThreadMapping,
+// so recording threads never wait on each other. All pools go back at once when the frame starts again.
 class DescriptorAllocator {
 public:
 
@@ -37,22 +60,50 @@ public:
 		};
 	};
 
+	struct Stats
+	{
+		uint32_t allocated{};
+		uint32_t cacheHits{};
+		uint32_t pools{};
+	};
+
+	// Only from the frame's thread, after the frame's fence
 	void ResetPools();
-	bool Allocate(VkDescriptorSet* set, VkDescriptorSetLayout layout);
+	// Only the thread mapped to threadID may use its pools, nothing is locked
+	bool Allocate(VkDescriptorSet* set, VkDescriptorSetLayout layout, uint32_t threadID = 0);
 
-	void Init(VkDevice newDevice);
+	// A set the thread already wrote this frame with the same layout and resources, see DescriptorBuilder::GetContent
+	VkDescriptorSet FindCached(const DescriptorSetContent& content, uint32_t threadID);
+	void AddCached(DescriptorSetContent&& content, VkDescriptorSet set, uint32_t threadID);
+
+	// Since the last reset, summed over the threads
+	Stats GetStats() const;
+
+	void Init(VkDevice newDevice, uint32_t threadCount);
 
 	void Cleanup();
 
 	VkDevice device{};
 private:
-	VkDescriptorPool GrabPool();
+	struct DescriptorSetContentHash
+	{
+		std::size_t operator()(const DescriptorSetContent& k) const {
+			return k.hash();
+		}
+	};
+
+	struct ThreadPools
+	{
+		VkDescriptorPool currentPool{VK_NULL_HANDLE};
+		std::vector<VkDescriptorPool> usedPools;
+		std::vector<VkDescriptorPool> freePools;
+		std::unordered_map<DescriptorSetContent, VkDescriptorSet, DescriptorSetContentHash> setCache;
+		Stats stats;
+	};
+
+	VkDescriptorPool GrabPool(ThreadPools& pools);
 	VkDescriptorPool CreatePool(VkDevice device, const DescriptorAllocator::PoolSizes& poolSizes, int count, VkDescriptorPoolCreateFlags flags);
 
-	VkDescriptorPool currentPool{VK_NULL_HANDLE};
 	PoolSizes descriptorSizes;
-	std::vector<VkDescriptorPool> usedPools;
-	std::vector<VkDescriptorPool> freePools;
-
-	std::unique_ptr<std::mutex> m_mut{};
+	std::vector<ThreadPools> m_threads;
 };
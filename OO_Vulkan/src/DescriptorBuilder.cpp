@@ -25,6 +25,7 @@ DescriptorBuilder DescriptorBuilder::Begin()
 
 	builder.cache = &vr.DescLayoutCache;
 	builder.alloc = &vr.descAllocs[vr.getFrame()];
+	builder.threadID = vr.GetThreadMapping();
 
 	return builder;
 }
@@ -85,8 +86,16 @@ bool DescriptorBuilder::Build(VkDescriptorSet& set, VkDescriptorSetLayout& layou
 {
 	BuildLayout(layout);
 
+	// written already this frame, nothing writes a built set again so it can be shared
+	DescriptorSetContent content = GetContent(layout);
+	set = alloc->FindCached(content, threadID);
+	if (set != VK_NULL_HANDLE)
+	{
+		return true;
+	}
+
 	//allocate descriptor
-	bool success = alloc->Allocate(&set, layout);
+	bool success = alloc->Allocate(&set, layout, threadID);
 	if (!success)
 	{
 		return false;
@@ -110,6 +119,7 @@ bool DescriptorBuilder::Build(VkDescriptorSet& set, VkDescriptorSetLayout& layou
 	}
 
 	vkUpdateDescriptorSets(alloc->device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+	alloc->AddCached(std::move(content), set, threadID);
 	return true;
 }
 
@@ -137,3 +147,36 @@ size_t DescriptorBuilder::getHash()
 	size_t hash = cache->GetLayoutInfo(&layoutInfo).hash();
 	return hash;
 }
+
+DescriptorSetContent DescriptorBuilder::GetContent(VkDescriptorSetLayout layout) const
+{
+	// the layout cache gives the same handle for the same bindings
+	DescriptorSetContent content;
+	content.layout = layout;
+	content.writes.reserve(writes.size());
+	content.bufferInfos.reserve(bufferinfos.size());
+	content.imageInfos.reserve(imageinfos.size());
+	for (const VkWriteDescriptorSet& w : writes)
+	{
+		content.writes.push_back({ w.dstBinding, w.dstArrayElement, w.descriptorType, w.descriptorCount });
+		// until Build the info pointers hold the index of the first info
+		if (w.descriptorType == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER 
+			|| w.descriptorType == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER
+			|| w.descriptorType == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC
+			|| w.descriptorType == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC)
+		{
+			for (size_t i = 0; i < w.descriptorCount; i++)
+			{
+				content.bufferInfos.push_back(bufferinfos[(size_t)w.pBufferInfo + i]);
+			}
+		}
+		else
+		{
+			for (size_t i = 0; i < w.descriptorCount; i++)
+			{
+				content.imageInfos.push_back(imageinfos[(size_t)w.pImageInfo + i]);
+			}
+		}
+	}
+	return content;
+}
@@ -13,10 +13,10 @@ Technology is prohibited.
 *//*************************************************************************************/
 #pragma once
 #include "vulkan/vulkan.h"
+#include "DescriptorAllocator.h"
 #include <vector>
 
 class DescriptorLayoutCache;
-class DescriptorAllocator;
 
 class DescriptorBuilder
 {
@@ -32,6 +32,9 @@ public:
 	bool BuildLayout(VkDescriptorSetLayout& layout);
 
 	size_t getHash();
+	// The layout and every resource written, sets with the same content are shared within a frame
+	DescriptorSetContent GetContent(VkDescriptorSetLayout layout) const;
+	const std::vector<VkDescriptorSetLayoutBinding>& getBindings() const { return bindings; }
 private:
 
 	std::vector<VkWriteDescriptorSet> writes;
@@ -41,5 +44,6 @@ private:
 
 	DescriptorLayoutCache* cache{ nullptr };
 	DescriptorAllocator* alloc{nullptr};
+	uint32_t threadID{};
 };
 
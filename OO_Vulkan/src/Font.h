@@ -62,6 +62,14 @@ public:
 
     virtual void* Get_IMTEXTURE_ID() const { return reinterpret_cast<void*>(static_cast<uint64_t>(m_atlasID)); }
 
+    // Read only lookup, safe to use from several threads. Unknown characters get an empty glyph
+    const Glyph& GetGlyph(wchar_t c) const
+    {
+        static const Glyph s_empty{};
+        auto it = m_characterInfos.find(c);
+        return it != m_characterInfos.end() ? it->second : s_empty;
+    }
+
 public:
     // this is probably bad af
     std::wstring m_name;
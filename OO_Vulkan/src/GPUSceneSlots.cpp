@@ -0,0 +1,98 @@
+/************************************************************************************//*!
+\file           GPUSceneSlots.cpp
+\project        Ouroboros
+\author         Jamie Kong, j.kong, 390004720 | code contribution (100%)
+\par            email: j.kong\@digipen.edu
+\date           May 10, 2024
+\brief              Defines the upload state of the GPU scene buffers, which object slots changed
+since they were last uploaded
+
+Copyright (C) 2022 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents
+without the prior written consent of DigiPen Institute of
+Technology is prohibited.
+*//*************************************************************************************/
+#include "GPUSceneSlots.h"
+
+#include <algorithm>
+#include <cassert>
+
+void GPUSceneSlots::Resize(size_t numSlots)
+{
+	assert(numSlots >= m_slots.size()); // ids are never taken back
+	m_slots.resize(numSlots);
+}
+
+bool GPUSceneSlots::NeedsTransform(uint32_t id, uint32_t dirtyGeneration) const
+{
+	const Slot& slot = m_slots[id];
+	if (slot.transformQueued) return false; // already rebuilt for this upload by another view
+	return slot.hasTransform == false || slot.inMotion || slot.dirtyGeneration != dirtyGeneration;
+}
+
+void GPUSceneSlots::SetTransform(uint32_t id, uint32_t dirtyGeneration, bool inMotion)
+{
+	Slot& slot = m_slots[id];
+	slot.hasTransform = true;
+	slot.dirtyGeneration = dirtyGeneration;
+	slot.inMotion = inMotion;
+	if (slot.transformQueued == false)
+	{
+		slot.transformQueued = true;
+		m_queuedTransforms.push_back(id);
+	}
+}
+
+void GPUSceneSlots::SetInfo(uint32_t id)
+{
+	Slot& slot = m_slots[id];
+	slot.hasInfo = true;
+	if (slot.infoQueued == false)
+	{
+		slot.infoQueued = true;
+		m_queuedInfos.push_back(id);
+	}
+}
+
+void GPUSceneSlots::QueueAll()
+{
+	m_queuedTransforms.clear();
+	m_queuedInfos.clear();
+	for (uint32_t id = 0; id < m_slots.size(); id++)
+	{
+		Slot& slot = m_slots[id];
+		slot.transformQueued = slot.hasTransform;
+		slot.infoQueued = slot.hasInfo;
+		if (slot.hasTransform) m_queuedTransforms.push_back(id);
+		if (slot.hasInfo) m_queuedInfos.push_back(id);
+	}
+}
+
+void GPUSceneSlots::TakeTransformRanges(std::vector<Range>& out)
+{
+	TakeRanges(m_queuedTransforms, m_slots, &Slot::transformQueued, out);
+}
+
+void GPUSceneSlots::TakeInfoRanges(std::vector<Range>& out)
+{
+	TakeRanges(m_queuedInfos, m_slots, &Slot::infoQueued, out);
+}
+
+void GPUSceneSlots::TakeRanges(std::vector<uint32_t>& queued, std::vector<Slot>& slots, bool Slot::* flag, std::vector<Range>& out)
+{
+	out.clear();
+	std::sort(queued.begin(), queued.end());
+	for (uint32_t id : queued)
+	{
+		slots[id].*flag = false;
+		if (out.empty() == false && out.back().first + out.back().count == id)
+		{
+			++out.back().count;
+		}
+		else
+		{
+			out.push_back(Range{ id, 1 });
+		}
+	}
+	queued.clear();
+}
@@ -0,0 +1,70 @@
+/************************************************************************************//*!
+\file           GPUSceneSlots.h
+\project        Ouroboros
+\author         Jamie Kong, j.kong, 390004720 | code contribution (100%)
+\par            email: j.kong\@digipen.edu
+\date           May 10, 2024
+\brief              Declares the upload state of the GPU scene buffers, which object slots changed
+since they were last uploaded
+
+Copyright (C) 2022 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents
+without the prior written consent of DigiPen Institute of
+Technology is prohibited.
+*//*************************************************************************************/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Every object owns the slot of its id in the transform and information buffers.
+// Slots are queued when they change and handed out as contiguous ranges, each slot at most once per take.
+class GPUSceneSlots
+{
+public:
+	struct Range
+	{
+		uint32_t first{};
+		uint32_t count{};
+	};
+
+	// Grows with the world's object container, new slots start out never uploaded
+	void Resize(size_t numSlots);
+	size_t size() const { return m_slots.size(); }
+
+	// True when the transform has to be rebuilt: never uploaded, changed since or still catching up after a move
+	bool NeedsTransform(uint32_t id, uint32_t dirtyGeneration) const;
+	// The transform was rebuilt, inMotion when its previous transform differs from the current one.
+	// A slot in motion is uploaded once more when it stops so the previous transform catches up.
+	void SetTransform(uint32_t id, uint32_t dirtyGeneration, bool inMotion);
+
+	bool HasInfo(uint32_t id) const { return m_slots[id].hasInfo; }
+	void SetInfo(uint32_t id);
+
+	// The buffers were reallocated and start out empty, queue every slot we have data for
+	void QueueAll();
+
+	bool HasQueued() const { return m_queuedTransforms.empty() == false || m_queuedInfos.empty() == false; }
+
+	// Queued slots in ascending order with neighbours merged, the queue is empty afterwards
+	void TakeTransformRanges(std::vector<Range>& out);
+	void TakeInfoRanges(std::vector<Range>& out);
+
+private:
+	struct Slot
+	{
+		uint32_t dirtyGeneration{}; // ObjectInstance::dirtyGeneration of the uploaded transform
+		bool hasTransform{ false };
+		bool hasInfo{ false };
+		bool inMotion{ false };
+		bool transformQueued{ false };
+		bool infoQueued{ false };
+	};
+
+	static void TakeRanges(std::vector<uint32_t>& queued, std::vector<Slot>& slots, bool Slot::* flag, std::vector<Range>& out);
+
+	std::vector<Slot> m_slots;
+	std::vector<uint32_t> m_queuedTransforms;
+	std::vector<uint32_t> m_queuedInfos;
+};
@@ -38,6 +38,8 @@ public:
 
 	void resize(VkCommandBuffer cmd, size_t size);
 	void reserve(VkCommandBuffer cmd, size_t size);
+	// Moves ranges into a new buffer of this size, offsets in elements. Whatever is not moved is dropped.
+	void relocate(VkCommandBuffer cmd, const std::vector<VkBufferCopy>& regions, size_t size);
 	size_t size() const;
 
 	VkBuffer getBuffer()const;
@@ -181,46 +183,21 @@ void GpuVector<T>::writeToCmd(size_t writeSize, const void* data,VkCommandBuffer
 	}
 
 
-	using namespace oGFX;
 	//get writeSize of buffer needed for vertices
 	VkDeviceSize bufferBytes = writeSize * sizeof(T);
 	VkDeviceSize writeBytesOffset = offset * sizeof(T);
 
-	//temporary buffer to stage vertex data before transferring to GPU
-	oGFX::AllocatedBuffer stagingBuffer{};
+	// stage the data in this frame's part of the ring
+	auto staging = m_device->stagingRing.Stage(data, bufferBytes);
 
-	//create buffer and allocate memory to it
-	CreateBuffer("stagingBuffer", m_device->m_allocator, bufferBytes, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-		VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT, stagingBuffer);
-
-	//MAP MEMORY TO VERTEX BUFFER
-	void* mappedData = nullptr;
-	auto result = vmaMapMemory(m_device->m_allocator, stagingBuffer.alloc, &mappedData);
-	if (result != VK_SUCCESS)
-	{
-		assert(false);
-	}
-	memcpy(mappedData, data, (size_t)bufferBytes);
-	vmaUnmapMemory(m_device->m_allocator, stagingBuffer.alloc);
-
-	
-	auto commandBuffer = command;
-	
 	// region of data to copy from and to
 	VkBufferCopy bufferCopyRegion{};
-	bufferCopyRegion.srcOffset = 0;
-	bufferCopyRegion.dstOffset = 0;
+	bufferCopyRegion.srcOffset = staging.offset;
+	bufferCopyRegion.dstOffset = writeBytesOffset;
 	bufferCopyRegion.size = bufferBytes;
-	
+
 	// command to copy src buffer to dst buffer
-	vkCmdCopyBuffer(commandBuffer, stagingBuffer.buffer, m_buffer.buffer, 1, &bufferCopyRegion);
-	
-	auto fun = [oldBuffer = stagingBuffer, alloc = m_device->m_allocator]() {
-		PROFILE_SCOPED("Clean buffer")
-			//clean up staging buffer parts
-			vmaDestroyBuffer(alloc, oldBuffer.buffer, oldBuffer.alloc);
-	};
-	DelayedDeleter::get()->DeleteAfterFrames(fun);
+	vkCmdCopyBuffer(command, staging.buffer, m_buffer.buffer, 1, &bufferCopyRegion);
 
 	//not sure what to do here, we just assume that its tightly packed
 	if (offset < m_size)
@@ -278,39 +255,21 @@ inline void GpuVector<T>::flushToGPU(VkCommandBuffer command)
 		resize(command, maxElement);
 	}
 
-	//temporary buffer to stage vertex data before transferring to GPU
-	oGFX::AllocatedBuffer stagingBuffer;
-
-	//create buffer and allocate memory to it
-	oGFX::CreateBuffer("stagingBuffer", m_device->m_allocator, totalDataSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-		VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT, stagingBuffer);
-
-	//MAP MEMORY TO VERTEX BUFFER
-	void* mappedData = nullptr;
-	auto result = vmaMapMemory(m_device->m_allocator, stagingBuffer.alloc, &mappedData);
-	if (result != VK_SUCCESS)
-	{
-		assert(false);
-	}
-	memcpy(mappedData, m_cpuBuffer.data(), (size_t)totalDataSize);
-	vmaUnmapMemory(m_device->m_allocator, stagingBuffer.alloc);
+	// stage every pending write in one allocation so they go out in a single copy
+	auto staging = m_device->stagingRing.Stage(m_cpuBuffer.data(), totalDataSize);
 	
 	//m_cpuBuffer.clear(); // good for small memory..
 	m_cpuBuffer = {}; // release the memory because it could be quite big
 
-	auto commandBuffer = command;
+	for (auto& copycmd : m_copyRegions)
+	{
+		copycmd.srcOffset += staging.offset;
+	}
 
 	// command to copy src buffer to dst buffer
-	vkCmdCopyBuffer(commandBuffer, stagingBuffer.buffer, m_buffer.buffer, (uint32_t)m_copyRegions.size(), m_copyRegions.data());
+	vkCmdCopyBuffer(command, staging.buffer, m_buffer.buffer, (uint32_t)m_copyRegions.size(), m_copyRegions.data());
 	m_copyRegions.clear();
 
-	auto fun = [oldBuffer = stagingBuffer, alloc = m_device->m_allocator]() {
-		PROFILE_SCOPED("Clean buffer");
-		//clean up staging buffer parts
-		vmaDestroyBuffer(alloc, oldBuffer.buffer, oldBuffer.alloc);
-	};
-	DelayedDeleter::get()->DeleteAfterFrames(fun);
-
 	m_mustUpdate = false;
 }
 
@@ -363,6 +322,46 @@ void GpuVector<T>::reserve(VkCommandBuffer cmd, size_t size)
 	m_mustUpdate = true;
 }
 
+template <typename T>
+void GpuVector<T>::relocate(VkCommandBuffer cmd, const std::vector<VkBufferCopy>& regions, size_t size)
+{
+	PROFILE_SCOPED();
+
+	using namespace oGFX;
+	size = std::max<size_t>(size, 1);
+	oGFX::AllocatedBuffer tempBuffer;
+	VmaPoolCreateFlags noflags = 0;
+	CreateBuffer(m_name, m_device->m_allocator, size * sizeof(T), m_usage, noflags, tempBuffer);
+
+	std::vector<VkBufferCopy> byteRegions(regions);
+	for (VkBufferCopy& r : byteRegions)
+	{
+		r.srcOffset *= sizeof(T);
+		r.dstOffset *= sizeof(T);
+		r.size *= sizeof(T);
+	}
+	if (byteRegions.empty() == false)
+	{
+		vkCmdCopyBuffer(cmd, m_buffer.buffer, tempBuffer.buffer, (uint32_t)byteRegions.size(), byteRegions.data());
+	}
+
+	// frames in flight still draw from the old one
+	auto fun = [oldBuffer = m_buffer, alloc = m_device->m_allocator]() {
+			PROFILE_SCOPED("Clean up buffer");
+			vmaDestroyBuffer(alloc, oldBuffer.buffer, oldBuffer.alloc);
+		};
+	DelayedDeleter::get()->DeleteAfterFrames(fun);
+
+	m_buffer = tempBuffer;
+
+	accumulatedBytes -= m_capacity;
+	accumulatedBytes += size;
+
+	m_capacity = size;
+	m_size = std::min(m_size, size);
+	m_mustUpdate = true;
+}
+
 template <typename T>
 size_t GpuVector<T>::size() const
 {
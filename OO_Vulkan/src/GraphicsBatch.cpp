@@ -21,6 +21,7 @@ Technology is prohibited.
 #include <cassert>
 #include "Profiling.h"
 #include "DebugDraw.h"
+#include "Collision.h"
 
 //#define _SILENCE_CXX17_CODECVT_HEADER_DEPRECATION_WARNING
 //#define _SILENCE_ALL_CXX17_DEPRECATION_WARNINGS
@@ -30,113 +31,49 @@ Technology is prohibited.
 #include <sstream>
 #include <numeric>
 
-DrawData ObjectInsToDrawData(const ObjectInstance& obj)
+uint32_t GlobalSubmeshOf(const ObjectInstance& obj)
 {
-	DrawData dd;
-	dd.bindlessGlobalTextureIndex_Albedo = obj.bindlessGlobalTextureIndex_Albedo;
-	dd.bindlessGlobalTextureIndex_Normal = obj.bindlessGlobalTextureIndex_Normal;
-	dd.bindlessGlobalTextureIndex_Roughness = obj.bindlessGlobalTextureIndex_Roughness;
-	dd.bindlessGlobalTextureIndex_Metallic = obj.bindlessGlobalTextureIndex_Metallic;
-	dd.bindlessGlobalTextureIndex_Emissive = obj.bindlessGlobalTextureIndex_Emissive;
-	dd.emissiveColour = obj.emissiveColour;
-	dd.localToWorld = obj.localToWorld;
-	dd.prevLocalToWorld = obj.prevLocalToWorld;
-	dd.entityID = obj.entityID; // Unique ID for this entity instance
-	dd.flags = obj.flags;
-	dd.instanceData = obj.instanceData;
-	dd.ptrToBoneBuffer = &obj.bones;
-	dd.modelID = obj.modelID;
-	dd.submeshID = obj.submesh;
-	return dd;
+	auto& vr = *VulkanRenderer::get();
+	gfxModel& mdl = vr.g_globalModels[obj.modelID];
+	return mdl.m_subMeshes[obj.submesh];
 }
 
-oGFX::AABB getBoxFun(ObjectInstance& oi)
-{
-	auto& vr = *VulkanRenderer::get();
-	auto& models = vr.g_globalModels;
-	auto& submeshes = vr.g_globalSubmesh;
-
-	oGFX::AABB box;
-	auto& mdl = models[oi.modelID];
-	uint32_t submeshID = mdl.m_subMeshes[oi.submesh];
-
-	oGFX::Sphere bs = submeshes[submeshID].boundingSphere;
-
-	float sx = glm::length(glm::vec3(oi.localToWorld[0][0], oi.localToWorld[1][0], oi.localToWorld[2][0]));
-	float sy = glm::length(glm::vec3(oi.localToWorld[0][1], oi.localToWorld[1][1], oi.localToWorld[2][1]));
-	float sz = glm::length(glm::vec3(oi.localToWorld[0][2], oi.localToWorld[1][2], oi.localToWorld[2][2]));
-
-	box.center = vec3(oi.localToWorld * vec4(bs.center, 1.0));
-	float maxSize = std::max(sx, std::max(sy, sz));
-	maxSize *= bs.radius;
-	box.halfExt = vec3{ maxSize };
-	return box;
-};
-OO_OPTIMIZE_OFF
-void CullDrawData(const oGFX::Frustum& f, std::vector<DrawData>& outData, const std::vector<ObjectInstance*>& contained, const std::vector<ObjectInstance*>& intersecting, bool debug = false)
+void FilterAndSortVisible(std::vector<uint32_t>& visible, WorldSnapshot& snapshot)
 {
-	PROFILE_SCOPED();
-	auto& vr = *VulkanRenderer::get();
-
-	outData.clear();
-	outData.reserve(contained.size() + intersecting.size());	
-
-	for (size_t i = 0; i < contained.size(); i++)
+	// sort on (submesh, id) packed in one key so instances of a mesh end up next to each other
+	thread_local std::vector<uint64_t> keys;
+	keys.clear();
+	keys.reserve(visible.size());
+	for (uint32_t id : visible)
 	{
-		ObjectInstance& src = *contained[i];
-
-		if (src.isRenderable() == false) continue;
-
-		if(debug)
-			oGFX::DebugDraw::AddAABB(getBoxFun(src), oGFX::Colors::GREEN);
-		DrawData dd = ObjectInsToDrawData(src);
-		gfxModel& mdl = vr.g_globalModels[src.modelID];
-		//for (size_t s = 0; s < mdl.m_subMeshes.size(); s++)
-		//{
-		//	// add draw call for each submesh
-		//	if (src.submesh[s] == true)
-		//	{
-		//		dd.submeshID = mdl.m_subMeshes[s];
-				dd.submeshID = mdl.m_subMeshes[src.submesh];
-				outData.push_back(dd);
-		//	}
-		//}
-
+		ObjectInstance& obj = snapshot.objects.buffer()[id];
+		if (obj.isRenderable() == false) continue;
+		keys.push_back(uint64_t(GlobalSubmeshOf(obj)) << 32 | id);
 	}
-	size_t intersectAccepted{};
-	for (size_t i = 0; i < intersecting.size(); i++)
+	std::sort(keys.begin(), keys.end());
+
+	visible.clear();
+	for (uint64_t k : keys)
 	{
-		ObjectInstance& src = *intersecting[i];
-
-		if (src.isRenderable() == false) continue;
-		if (debug)
-			oGFX::DebugDraw::AddAABB(getBoxFun(src), oGFX::Colors::RED);
-		if (oGFX::coll::AABBInFrustum(f, getBoxFun(src), debug) != oGFX::coll::OUTSIDE) {
-			DrawData dd = ObjectInsToDrawData(src);
-			gfxModel& mdl = vr.g_globalModels[src.modelID];
-			//for (size_t s = 0; s < mdl.m_subMeshes.size(); s++)
-			//{
-			//	// add draw call for each submesh
-			//	if (src.submesh[s] == true)
-			//	{
-			//		dd.submeshID = mdl.m_subMeshes[s];
-					dd.submeshID = mdl.m_subMeshes[src.submesh];
-					outData.push_back(dd);
-			//	}
-			//}
-			if (debug)
-				oGFX::DebugDraw::AddAABB(getBoxFun(src), oGFX::Colors::YELLOW);
-			intersectAccepted++;
-		}
+		visible.push_back(static_cast<uint32_t>(k));
 	}
-	//if(debug)
-	//	printf("Accepted Entities-%3llu/%3llu Intersect-%3llu/%3llu\n", outData.size(), contained.size() + intersecting.size(), intersectAccepted, intersecting.size());
 }
-OO_OPTIMIZE_ON
-void SortDrawDataByMesh(std::vector<DrawData>& drawData)
+
+uint64_t HashCombine(uint64_t h, uint64_t v)
 {
-	std::sort(drawData.begin(), drawData.end(),
-		[](const DrawData& L, const DrawData& R) {return L.submeshID < R.submeshID; });
+	return h ^ (v + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2));
+}
+
+uint64_t HashMatrix(const glm::mat4& m)
+{
+	// FNV-1a over the bits, the light matrices are rebuilt from the same inputs every frame
+	uint64_t h = 0xcbf29ce484222325ull;
+	const uint8_t* bytes = reinterpret_cast<const uint8_t*>(glm::value_ptr(m));
+	for (size_t i = 0; i < sizeof(glm::mat4); i++)
+	{
+		h = (h ^ bytes[i]) * 0x100000001b3ull;
+	}
+	return h;
 }
 
 void AppendBatch(std::vector<oGFX::IndirectCommand>& dest, oGFX::IndirectCommand cmd, uint32_t cnt)
@@ -148,7 +85,7 @@ void AppendBatch(std::vector<oGFX::IndirectCommand>& dest, oGFX::IndirectCommand
 	}
 }
 
-void GenerateCommands(const std::vector<DrawData>& entities, std::vector<oGFX::IndirectCommand>& commands, ObjectInstanceFlags filter)
+void GenerateCommands(const std::vector<uint32_t>& entities, WorldSnapshot& snapshot, std::vector<oGFX::IndirectCommand>& commands, ObjectInstanceFlags filter)
 {
 	auto& vr = *VulkanRenderer::get();
 
@@ -158,12 +95,12 @@ void GenerateCommands(const std::vector<DrawData>& entities, std::vector<oGFX::I
 
 	for (size_t y = 0; y < entities.size(); y++)
 	{
-		auto& ent = entities[y];
-		auto& subMesh = vr.g_globalSubmesh[ent.submeshID];
+		const uint32_t submeshID = GlobalSubmeshOf(snapshot.objects.buffer()[entities[y]]);
+		auto& subMesh = vr.g_globalSubmesh[submeshID];
 
-		if (ent.submeshID != currModelID) // check if we are using the same model
+		if (submeshID != currModelID) // check if we are using the same model
 		{
-			currModelID = ent.submeshID;
+			currModelID = submeshID;
 
 			AppendBatch(commands, indirectCmd, indirectCmd.instanceCount);
 
@@ -193,6 +130,55 @@ void GenerateCommands(const std::vector<DrawData>& entities, std::vector<oGFX::I
 	AppendBatch(commands, indirectCmd, indirectCmd.instanceCount);
 }
 
+uint32_t GraphicsBatch::ViewSet::AddView(const oGFX::Frustum& f, std::vector<oGFX::IndirectCommand>* outCommands)
+{
+	OO_ASSERT(frustums.size() < oGFX::OctTree::s_max_views && "Too many views to cull in one pass");
+	const uint32_t view = static_cast<uint32_t>(frustums.size());
+	frustums.push_back(f);
+	commands.push_back(outCommands);
+	if (visible.size() <= view)
+	{
+		visible.emplace_back();
+	}
+	visible[view].clear();
+	return view;
+}
+
+void GraphicsBatch::ViewSet::Clear()
+{
+	// keep the visible lists around so their capacity is reused next frame
+	frustums.clear();
+	commands.clear();
+}
+
+uint32_t GraphicsBatch::ViewSet::size() const
+{
+	return static_cast<uint32_t>(frustums.size());
+}
+
+void GraphicsBatch::QueueViewCulling(std::queue<Task>& tasks, oGFX::OctTree& tree, ViewSet& views, uint32_t numGroups
+	, std::function<void(uint32_t)> perView)
+{
+	const uint32_t numViews = views.size();
+	numGroups = std::clamp(numGroups, 1u, std::max(numViews, 1u));
+	for (uint32_t g = 0; g < numGroups && numViews; g++)
+	{
+		const uint32_t first = numViews * g / numGroups;
+		const uint32_t last = numViews * (g + 1) / numGroups;
+		tasks.emplace([&tree, &views, first, last, perView](void*) {
+			PROFILE_SCOPED("Cull view group");
+			tree.GetEntitiesInFrustums(views.frustums.data() + first, last - first, views.visible.data() + first);
+			if (perView)
+			{
+				for (uint32_t v = first; v < last; v++)
+				{
+					perView(v);
+				}
+			}
+		});
+	}
+}
+
 void GraphicsBatch::Init(GraphicsWorld* gw, VulkanRenderer* renderer, size_t maxObjects)
 {
 	assert(gw != nullptr);
@@ -213,12 +199,14 @@ void GraphicsBatch::Init(GraphicsWorld* gw, VulkanRenderer* renderer, size_t max
 		for (size_t face = 0; face < cubeFaces; face++)
 		{
 			cd.m_commands[face].clear();
-			cd.m_culledObjects[face].clear();
+			cd.m_views[face] = 0;
 		}
 	}
 
 	s_scratchBuffer.reserve(maxObjects);
 
+	m_shadowAtlas.Init(SHADOW_ATLAS_SIZE, SHADOW_TILE_MIN, SHADOW_TILE_MAX);
+
 }
 
 void GraphicsBatch::GenerateBatches()
@@ -230,14 +218,22 @@ void GraphicsBatch::GenerateBatches()
 	{
 		batch.clear();
 	}
+	m_views.Clear();
 
+	// register the views, these are cheap and have to happen in order
 	ProcessGeometry();
-	
-	ProcessUI();
-
 	ProcessLights();
 
-	ProcessParticleEmitters();
+	// the rest only reads the snapshot and writes to buffers of its own, fan it out
+	std::queue<Task> tasks;
+	CullViews(tasks);
+	ProcessUI(tasks);
+	tasks.emplace([this](void*) { ProcessParticleEmitters(); });
+	m_renderer->g_taskManager.AddTaskListAndWait(tasks);
+
+	UpdateShadowTiles();
+	RequestTextureMips();
+	MergeUIVertices();
 
 }
 
@@ -246,7 +242,10 @@ void GraphicsBatch::ProcessLights()
 	PROFILE_SCOPED();
 	VulkanRenderer& vr = *VulkanRenderer::get();
 
-	for (auto& light : m_world->m_OmniLightCopy)
+	// a snapshot is processed again when no newer one was published, so its lights are only read
+	const auto& snapshotLights = m_world->RenderSnapshot().omniLights;
+	m_omniLights.assign(snapshotLights.begin(), snapshotLights.end());
+	for (auto& light : m_omniLights)
 	{
 		if (LightType::POINT != GetLightType(light)) 
 		{
@@ -295,12 +294,14 @@ void GraphicsBatch::ProcessLights()
 	m_numShadowCastGrids = 0;
 
 	m_culledLights.clear();
-	auto& lights = m_world->m_OmniLightCopy;
+	m_culledLightIds.clear();
+	auto& lights = m_omniLights;
+	auto& lightIds = m_world->RenderSnapshot().omniLightIds;
 	m_culledLights.reserve(lights.size());
 	//oGFX::DebugDraw::AddArrow(currWorld->cameras[0].m_position, currWorld->cameras[0].m_position + currWorld->cameras[0].GetUp(),oGFX::Colors::GREEN);
 	//oGFX::DebugDraw::AddArrow(currWorld->cameras[0].m_position, currWorld->cameras[0].m_position + currWorld->cameras[0].GetRight(),oGFX::Colors::RED);
 	//oGFX::DebugDraw::AddArrow(currWorld->cameras[0].m_position, currWorld->cameras[0].m_position + currWorld->cameras[0].GetFront(),oGFX::Colors::BLUE);
-	oGFX::Frustum frust = m_world->cameras[0].GetFrustum();
+	oGFX::Frustum frust = m_world->RenderSnapshot().cameras[0].GetFrustum();
 	//{
 	//	oGFX::DebugDraw::DrawCameraFrustrumDebugArrows(frust);
 	//}
@@ -379,12 +380,13 @@ void GraphicsBatch::ProcessLights()
 		}
 	
 		m_culledLights.emplace_back(si);
+		m_culledLightIds.emplace_back(lightIds[&e - lights.data()]);
 	}
 
 	// process shadows
 	int32_t gridIdx = 0;
 	//front camera culling
-	auto& camera = m_world->cameras[0];
+	auto& camera = m_world->RenderSnapshot().cameras[0];
 	std::vector<LocalLightInstance*> shadowLights;
 	for (size_t i = 0; i < m_culledLights.size(); i++)
 	{
@@ -405,13 +407,59 @@ void GraphicsBatch::ProcessLights()
 	});
 
 	m_shadowCasters.clear();
+	m_shadowTileRects.clear();
 	int32_t numLights{};
 
-	std::vector<ObjectInstance*> containedEnt;
-	std::vector<ObjectInstance*> intersectEnt;
+	for (CastersData& caster : m_casterData)
+	{
+		for (size_t face = 0; face < POINT_LIGHT_FACE_COUNT; face++)
+		{
+			caster.m_commands[face].clear();
+			caster.m_dirty[face] = false;
+		}
+		caster.m_atlasLight = nullptr;
+	}
+
+	// face resolution follows how much of the screen the light covers, the closest lights get their tiles first
+	if (shadowLights.size() > MAX_LIGHTS)
+	{
+		shadowLights.resize(MAX_LIGHTS);
+	}
+	const float tanHalfFov = tanf(glm::radians(camera.GetFov()) * 0.5f);
+	const uint32_t screenHeight = m_renderer->m_swapchain.swapChainExtent.height;
+	m_shadowRequests.clear();
 	for (LocalLightInstance* ePtr : shadowLights)
 	{
-		LocalLightInstance& e = *ePtr;
+		oGFX::ShadowAtlas::Request request;
+		request.lightID = m_culledLightIds[ePtr - m_culledLights.data()];
+		request.numFaces = GetLightType(*ePtr) == LightType::POINT ? POINT_LIGHT_FACE_COUNT : AREA_LIGHT_FACE_COUNT;
+		const float distance = glm::length(glm::vec3(ePtr->position) - camera.m_position);
+		request.desiredSize = oGFX::ShadowAtlas::SizeForCoverage(ePtr->radius.x, distance, tanHalfFov, screenHeight, SHADOW_TILE_MIN, SHADOW_TILE_MAX);
+		m_shadowRequests.emplace_back(request);
+	}
+	m_shadowAtlas.Update(m_shadowRequests, m_shadowAtlasLights);
+
+	auto assignTiles = [this](CastersData& caster, const LocalLightInstance& e, oGFX::ShadowAtlas::Light* atlasLight) {
+		caster.m_atlasLight = atlasLight;
+		const float texel = 1.0f / SHADOW_ATLAS_SIZE;
+		for (uint32_t face = 0; face < atlasLight->numFaces; face++)
+		{
+			caster.m_lightHash[face] = HashMatrix(e.projection * e.view[face]);
+			// 1 texel border so filtering does not bleed into the neighbouring tiles
+			const oGFX::ShadowAtlas::Tile& tile = atlasLight->faces[face].tile;
+			m_shadowTileRects.emplace_back(glm::vec4(tile.x + 1, tile.y + 1, tile.size - 2, tile.size - 2) * texel);
+		}
+	};
+
+	for (size_t lightIdx = 0; lightIdx < shadowLights.size(); lightIdx++)
+	{
+		LocalLightInstance& e = *shadowLights[lightIdx];
+		oGFX::ShadowAtlas::Light* atlasLight = m_shadowAtlasLights[lightIdx];
+		if (atlasLight == nullptr)
+		{
+			// no room left in the atlas, lit without shadows this frame
+			continue;
+		}
 		// enable the data for lighting pass to use as a shadow light
 		SetCastsShadows(e,true);
 		{
@@ -430,20 +478,9 @@ void GraphicsBatch::ProcessLights()
 				for (size_t face = 0; face < POINT_LIGHT_FACE_COUNT; face++)
 				{
 					glm::mat4 vp = lightProj * e.view[face];
-					oGFX::Frustum f = oGFX::Frustum::CreateFromViewProj(vp);
-
-					bool draw = false;
-
-					containedEnt.clear();
-					intersectEnt.clear();
-					m_world->m_OctTree->GetEntitiesInFrustum(f, containedEnt, intersectEnt);
-
-
-					CullDrawData(f, caster.m_culledObjects[face], containedEnt, intersectEnt, draw);
-					SortDrawDataByMesh(caster.m_culledObjects[face]);
-					GenerateCommands(caster.m_culledObjects[face], caster.m_commands[face]
-						, ObjectInstanceFlags::SHADOW_CASTER | ObjectInstanceFlags::RENDER_ENABLED);				
+					caster.m_views[face] = m_views.AddView(oGFX::Frustum::CreateFromViewProj(vp), &caster.m_commands[face]);
 				}
+				assignTiles(caster, e, atlasLight);
 				numLights++;
 			}
 			else // else area light
@@ -459,20 +496,9 @@ void GraphicsBatch::ProcessLights()
 				for (size_t face = 0; face < AREA_LIGHT_FACE_COUNT; face++)
 				{
 					glm::mat4 vp = lightProj * e.view[face]; // get the only view 
-					oGFX::Frustum f = oGFX::Frustum::CreateFromViewProj(vp);
-
-					bool draw = false;
-
-					containedEnt.clear();
-					intersectEnt.clear();
-					m_world->m_OctTree->GetEntitiesInFrustum(f, containedEnt, intersectEnt);
-
-
-					CullDrawData(f, caster.m_culledObjects[face], containedEnt, intersectEnt, draw);
-					SortDrawDataByMesh(caster.m_culledObjects[face]);
-					GenerateCommands(caster.m_culledObjects[face], caster.m_commands[face]
-						, ObjectInstanceFlags::SHADOW_CASTER | ObjectInstanceFlags::RENDER_ENABLED);				
+					caster.m_views[face] = m_views.AddView(oGFX::Frustum::CreateFromViewProj(vp), &caster.m_commands[face]);
 				}
+				assignTiles(caster, e, atlasLight);
 				numLights++;
 			}						
 		}
@@ -483,40 +509,121 @@ void GraphicsBatch::ProcessLights()
 
 }
 
+void GraphicsBatch::UpdateShadowTiles()
+{
+	PROFILE_SCOPED();
+
+	WorldSnapshot& snapshot = m_world->RenderSnapshot();
+	m_numShadowFacesRendered = 0;
+	for (size_t i = 0; i < m_shadowCasters.size(); i++)
+	{
+		CastersData& caster = m_casterData[i];
+		oGFX::ShadowAtlas::Light& atlasLight = *caster.m_atlasLight;
+		for (uint32_t face = 0; face < atlasLight.numFaces; face++)
+		{
+			// the octree gave us everything that can cast into this face, a caster entering or leaving changes the hash
+			uint64_t hash = caster.m_lightHash[face];
+			uint32_t newestGeneration{};
+			bool animated{ false };
+			for (uint32_t id : GetVisibleObjects(caster.m_views[face]))
+			{
+				ObjectInstance& obj = snapshot.objects.buffer()[id];
+				hash = HashCombine(hash, id);
+				newestGeneration = std::max(newestGeneration, obj.dirtyGeneration);
+				// bones move without dirtying the object
+				animated = animated || obj.isSkinned();
+			}
+			caster.m_dirty[face] = oGFX::ShadowAtlas::UpdateFace(atlasLight.faces[face], hash, newestGeneration, animated, snapshot.generation);
+			m_numShadowFacesRendered += caster.m_dirty[face];
+		}
+	}
+}
+
+void GraphicsBatch::RequestTextureMips()
+{
+	PROFILE_SCOPED();
+
+	// CPU estimate of the texel density, each texture is taken to span the object's bounding sphere once
+	oGFX::TextureResidency& residency = m_renderer->textureResidency;
+	WorldSnapshot& snapshot = m_world->RenderSnapshot();
+	auto& camera = snapshot.cameras[0];
+	const float tanHalfFov = tanf(glm::radians(camera.GetFov()) * 0.5f);
+	const uint32_t screenHeight = m_renderer->m_swapchain.swapChainExtent.height;
+	for (uint32_t id : m_views.visible[m_cameraView])
+	{
+		const ObjectInstance& obj = snapshot.objects.buffer()[id];
+		const oGFX::Sphere& bounds = m_renderer->g_globalSubmesh[GlobalSubmeshOf(obj)].boundingSphere;
+		const glm::vec3 centre = obj.localToWorld * glm::vec4(bounds.center, 1.0f);
+		const float scale = std::max({ glm::length(glm::vec3(obj.localToWorld[0])), glm::length(glm::vec3(obj.localToWorld[1])), glm::length(glm::vec3(obj.localToWorld[2])) });
+		const float distance = glm::length(centre - camera.m_position);
+
+		const uint32_t textures[] = { obj.bindlessGlobalTextureIndex_Albedo, obj.bindlessGlobalTextureIndex_Normal,
+			obj.bindlessGlobalTextureIndex_Roughness, obj.bindlessGlobalTextureIndex_Metallic, obj.bindlessGlobalTextureIndex_Emissive };
+		for (uint32_t textureID : textures)
+		{
+			const oGFX::TextureResidency::Texture* t = residency.Get(textureID);
+			if (t == nullptr)
+				continue;
+			const uint32_t mip = oGFX::TextureResidency::MipForCoverage(t->size, static_cast<uint32_t>(t->mipBytes.size()),
+				bounds.radius * scale, distance, tanHalfFov, screenHeight);
+			residency.Request(textureID, mip, m_renderer->currentFrame);
+		}
+	}
+}
+
 void GraphicsBatch::ProcessGeometry()
 {
 	using Batch = GraphicsBatch::DrawBatch;
-	using Flags = ObjectInstanceFlags;
-	
-	oGFX::Frustum f;
-	std::vector<ObjectInstance*> containedEnt;
-	std::vector<ObjectInstance*> intersectEnt;
-
-	f = m_world->cameras[0].GetFrustum();
-	containedEnt.clear();
-	intersectEnt.clear();
-	//m_world->m_OctTree->GetAllEntities(containedEnt);
-	m_world->m_OctTree->GetEntitiesInFrustum(f, containedEnt, intersectEnt);
-	CullDrawData(f, m_culledCameraObjects, containedEnt, intersectEnt);
-	SortDrawDataByMesh(m_culledCameraObjects);
-	GenerateCommands(m_culledCameraObjects, m_batches[Batch::ALL_OBJECTS], Flags::RENDER_ENABLED);
-
-	//printf("Total Entities[%3llu/%3llu] Con[%3llu] Int[%3llu]\n", m_culledCameraObjects.size(), m_world->m_OctTree->size(), containedEnt.size(), intersectEnt.size());
+
+	// the camera is culled along with the shadow views in CullViews
+	m_cameraView = m_views.AddView(m_world->RenderSnapshot().cameras[0].GetFrustum(), &m_batches[Batch::ALL_OBJECTS]);
+}
+
+void GraphicsBatch::CullViews(std::queue<Task>& tasks)
+{
+	PROFILE_SCOPED();
+
+	// one group of views per worker, each view only writes to its own list and commands
+	WorldSnapshot& snapshot = m_world->RenderSnapshot();
+	const uint32_t numGroups = m_renderer->g_taskManager.GetThreadCount();
+	QueueViewCulling(tasks, *m_world->m_OctTree, m_views, numGroups, [this, &snapshot](uint32_t v) {
+		FilterAndSortVisible(m_views.visible[v], snapshot);
+		if (m_views.commands[v])
+		{
+			// the flags are not filtered on yet, see GenerateCommands
+			GenerateCommands(m_views.visible[v], snapshot, *m_views.commands[v], ObjectInstanceFlags::RENDER_ENABLED);
+		}
+	});
 }
 
-void GraphicsBatch::ProcessUI()
+const std::vector<uint32_t>& GraphicsBatch::GetVisibleObjects(uint32_t view) const
+{
+	return m_views.visible[view];
+}
+
+void GraphicsBatch::ProcessUI(std::queue<Task>& tasks)
 {
 	using Flags = UIInstanceFlags;
-	auto& allUI = m_world->m_UIcopy;
+	auto& allUI = m_world->RenderSnapshot().ui;
 
 	PROFILE_SCOPED();
-	m_uiVertices.clear();
-	
-	std::vector<UIInstance*> instances;
-	instances.reserve(128);
+	m_uiInstances.clear();
+	m_numUIChunks = 0;
 
-	std::queue<Task> tasks;
+	auto addChunks = [this](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i += UI_INSTANCES_PER_TASK)
+		{
+			if (m_uiChunks.size() <= m_numUIChunks)
+			{
+				m_uiChunks.emplace_back();
+			}
+			UIChunk& chunk = m_uiChunks[m_numUIChunks++];
+			chunk.begin = i;
+			chunk.end = std::min(end, i + UI_INSTANCES_PER_TASK);
+		}
+	};
 
+	// world space ui first, screen space after it starting at m_SSVertOffset
 	for (auto& ui: allUI)
 	{
 		if (static_cast<bool>(ui.flags & Flags::RENDER_ENABLED) == false)
@@ -529,46 +636,12 @@ void GraphicsBatch::ProcessUI()
 			// skip non depth
 			continue;
 		}
-
-		if (static_cast<bool>(ui.flags & Flags::TEXT_INSTANCE))
-		{
-			instances.emplace_back(&ui);
-			auto lam = [this, &ui = ui](void*) {GenerateTextGeometry(ui); };
-			lam(nullptr);
-			// tasks.emplace(lam);
-			
-		}
-		else
-		{
-			GenerateSpriteGeometry(ui);
-		}
+		m_uiInstances.push_back(&ui);
 	}
+	addChunks(0, m_uiInstances.size());
+	m_numWorldUIChunks = m_numUIChunks;
 
-	size_t i = 0;
-	for (; i < instances.size()/4; i++)
-	{
-		 auto lam = [this, ui = instances.data()+i*4](void*) {
-			 for (size_t x = 0; x < 4; x++)
-			 {
-				 UIInstance* uiPtr= *(ui + x);
-				 GenerateTextGeometry(*uiPtr); 
-			 }			 
-		 };
-		 tasks.emplace(lam);
-	}
-	i *= 4;
-	auto lam = [this, ui = instances.data()+i, i = i, instancesSz = instances.size()](void*) {
-		for (size_t x = i; x < instancesSz; x++)
-		{
-			GenerateTextGeometry(**(ui+x)); 
-		}		 
-	};
-	//tasks.emplace(lam);
-
-	//VulkanRenderer::get()->g_taskManager.AddTaskListAndWait(tasks);
-
-	// dirty way of doing screenspace
-	m_SSVertOffset = m_uiVertices.size();
+	const size_t screenBegin = m_uiInstances.size();
 	for (auto& ui: allUI)
 	{
 		if (static_cast<bool>(ui.flags & Flags::RENDER_ENABLED) == false)
@@ -581,29 +654,62 @@ void GraphicsBatch::ProcessUI()
 			// skip depth
 			continue;
 		}
+		m_uiInstances.push_back(&ui);
+	}
+	addChunks(screenBegin, m_uiInstances.size());
 
-		if (static_cast<bool>(ui.flags & Flags::TEXT_INSTANCE))
-		{
-			GenerateTextGeometry(ui);
-		}
-		else
+	for (size_t c = 0; c < m_numUIChunks; c++)
+	{
+		tasks.emplace([this, &chunk = m_uiChunks[c]](void*) {
+			chunk.vertices.clear();
+			for (size_t i = chunk.begin; i < chunk.end; i++)
+			{
+				const UIInstance& ui = *m_uiInstances[i];
+				if (static_cast<bool>(ui.flags & Flags::TEXT_INSTANCE))
+				{
+					GenerateTextGeometry(ui, chunk.vertices);
+				}
+				else
+				{
+					GenerateSpriteGeometry(ui, chunk.vertices);
+				}
+			}
+		});
+	}
+}
+
+void GraphicsBatch::MergeUIVertices()
+{
+	PROFILE_SCOPED();
+	m_uiVertices.clear();
+	for (size_t c = 0; c < m_numUIChunks; c++)
+	{
+		if (c == m_numWorldUIChunks)
 		{
-			GenerateSpriteGeometry(ui);
+			m_SSVertOffset = m_uiVertices.size();
 		}
+		const std::vector<oGFX::UIVertex>& verts = m_uiChunks[c].vertices;
+		m_uiVertices.insert(m_uiVertices.end(), verts.begin(), verts.end());
+	}
+	if (m_numWorldUIChunks == m_numUIChunks)
+	{
+		m_SSVertOffset = m_uiVertices.size();
 	}
-
 }
 
 void GraphicsBatch::ProcessParticleEmitters()
 {
-	auto& allEmitters = m_world->m_EmitterCopy;
+	// the snapshot is read only, it is drawn again when the game has not published a newer one
+	const auto& allEmitters = m_world->RenderSnapshot().emitters;
 	m_particleList.clear();
 	m_particleCommands.clear();
 	/// Create parciles batch
 	uint32_t emitterCnt = 0;
 	auto* vr = VulkanRenderer::get();
-	for (auto& emitter : allEmitters)
+	for (const auto& emitter : allEmitters)
 	{
+		if (vr->IsModelPublished(emitter.modelID) == false)
+			continue;
 		// note to support multiple textures permesh we have to do this per submesh 
 		//setup instance data	
 		// TODO: this is really bad fix this
@@ -625,16 +731,19 @@ void GraphicsBatch::ProcessParticleEmitters()
 		// Important: Make sure this index packing matches the unpacking in the shader
 		const uint32_t albedo_normal = albedo << 16 | (normal & 0xFFFF);
 		const uint32_t roughness_metallic = roughness << 16 | (metallic & 0xFFFF);
-		for (auto& pd : emitter.particles)
+		auto& model = m_renderer->g_globalModels[emitter.modelID];
+
+		// copy list, then fill in what the renderer knows about the emitter
+		const size_t first = m_particleList.size();
+		m_particleList.insert(m_particleList.end(), emitter.particles.begin(), emitter.particles.end());
+		for (size_t i = first; i < m_particleList.size(); i++)
 		{
+			ParticleData& pd = m_particleList[i];
 			pd.instanceData.z = albedo_normal;
 			pd.instanceData.w = roughness_metallic;
+			pd.positionDequant = model.positionDequant;
 		}
 
-		// copy list
-		m_particleList.insert(m_particleList.end(), emitter.particles.begin(), emitter.particles.end());
-
-		auto& model = m_renderer->g_globalModels[emitter.modelID];
 		// set up the commands and number of particles
 		oGFX::IndirectCommand cmd{};
 
@@ -656,9 +765,6 @@ void GraphicsBatch::ProcessParticleEmitters()
 		}
 		//increment instance data
 		emitterCnt += cmd.instanceCount;
-
-		// clear this so next draw we dont care
-		emitter.particles.clear();
 	}
 }
 
@@ -699,7 +805,7 @@ size_t GraphicsBatch::GetScreenSpaceUIOffset() const
 	return m_SSVertOffset;
 }
 
-void GraphicsBatch::GenerateSpriteGeometry(const UIInstance& ui) 
+void GraphicsBatch::GenerateSpriteGeometry(const UIInstance& ui, std::vector<oGFX::UIVertex>& out)
 {
 
 	const auto& mdl_xform = ui.localToWorld;
@@ -735,13 +841,13 @@ void GraphicsBatch::GenerateSpriteGeometry(const UIInstance& ui)
 		vert.pos.w = 1.0; // positive is sprite
 		vert.col = ui.colour;
 		vert.tex = glm::vec4(textureCoords[i], albedo, ui.entityID);
-		m_uiVertices.push_back(vert);
+		out.push_back(vert);
 	}
 
 }
 
 
-void GraphicsBatch::GenerateTextGeometry(const UIInstance& ui)
+void GraphicsBatch::GenerateTextGeometry(const UIInstance& ui, std::vector<oGFX::UIVertex>& out)
 {
 	PROFILE_SCOPED();
 	using FontFormatting = oGFX::FontFormatting;
@@ -824,7 +930,7 @@ void GraphicsBatch::GenerateTextGeometry(const UIInstance& ui)
 			// handle having spaces at the end of a sentence from the previous iterator			
 			if ((&tokens.front() - 1) < (&*token - 1) && std::prev(token)->compare(" ") == 0)
 			{
-				const auto& gly = fontAtlas->m_characterInfos[L' '];
+				const auto& gly = fontAtlas->GetGlyph(L' ');
 				float value = (gly.Advance.x) * fontScale;
 				sizeTaken -= value;
 			}
@@ -845,7 +951,7 @@ void GraphicsBatch::GenerateTextGeometry(const UIInstance& ui)
 		// grab the with of the token
 		float textSize = std::accumulate(token->begin(), token->end(), 0.0f, [&](float x, const std::wstring::value_type c)->float
 			{
-				const auto& gly = fontAtlas->m_characterInfos[c];
+				const auto& gly = fontAtlas->GetGlyph(c);
 				float value = (gly.Advance.x) * fontScale;
 				return x + value;
 			}
@@ -966,26 +1072,24 @@ void GraphicsBatch::GenerateTextGeometry(const UIInstance& ui)
 	if (ui.format.alignment & (FontAlignment::Top_Centre | FontAlignment::Top_Left | FontAlignment::Top_Right))
 	{
 		// downwards growth is handled for us...
-		startY = /*ui.position.y*/ + halfBoxY - fontAtlas->m_characterInfos['L'].Size.y * fontScale;
+		startY = /*ui.position.y*/ + halfBoxY - fontAtlas->GetGlyph('L').Size.y * fontScale;
 	}
 	else if (ui.format.alignment & (FontAlignment::Bottom_Centre | FontAlignment::Bottom_Left | FontAlignment::Bottom_Right))
 	{
 		// whereas.. needs to take into account vertical line space to handle upwards growth
-		startY = /*ui.position.y*/ - halfBoxY + (std::max(0, numLines - 1) * fontAtlas->m_characterInfos['L'].Size.y * fontScale * ui.format.verticalLineSpace);
+		startY = /*ui.position.y*/ - halfBoxY + (std::max(0, numLines - 1) * fontAtlas->GetGlyph('L').Size.y * fontScale * ui.format.verticalLineSpace);
 	}
 	else
 	{
 		// centre alignment takes into account everything
-		const float fullFontSize = fontAtlas->m_characterInfos['L'].Size.y * fontScale;
-		const float halfFontSize = fontAtlas->m_characterInfos['L'].Size.y * fontScale / 2.0f;
+		const float fullFontSize = fontAtlas->GetGlyph('L').Size.y * fontScale;
+		const float halfFontSize = fontAtlas->GetGlyph('L').Size.y * fontScale / 2.0f;
 		const float halfLines = std::max(0.0f,float(numLines-1) / 2);
 		startY = /*ui.position.y*/ -halfFontSize + halfLines * fullFontSize * ui.format.verticalLineSpace;
 	}
 
-	std::vector<oGFX::UIVertex> vertexBuffer;
-	
-	// arbitrary size
-	vertexBuffer.reserve(tokens.size() * 4 * 10);
+	// appended straight into the chunk, its capacity carries over between frames
+	std::vector<oGFX::UIVertex>& vertexBuffer = out;
 	glm::vec2 cursorPos{ startX, startY };
 	for (const auto& token : tokens)
 	{
@@ -993,7 +1097,7 @@ void GraphicsBatch::GenerateTextGeometry(const UIInstance& ui)
 		for (const auto& c : token)
 		{
 			//get our glyph of this char
-			const oGFX::Font::Glyph& glyph = fontAtlas->m_characterInfos[c];
+			const oGFX::Font::Glyph& glyph = fontAtlas->GetGlyph(c);
 
 			if (c == '\n')
 			{
@@ -1052,13 +1156,4 @@ void GraphicsBatch::GenerateTextGeometry(const UIInstance& ui)
 
 		}
 	}
-	
-	// transfer to global buffer
-	std::scoped_lock lock{ m_uiVertMutex };
-	auto sz = m_uiVertices.size();
-	m_uiVertices.resize(m_uiVertices.size() + vertexBuffer.size());
-	for (size_t i = 0; i < vertexBuffer.size(); i++)
-	{
-		m_uiVertices[sz + i] = vertexBuffer[i];
-	}
 }
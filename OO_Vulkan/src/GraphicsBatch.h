@@ -18,13 +18,20 @@ Technology is prohibited.
 #include <vector>
 #include <array>
 #include <mutex>
+#include <queue>
+#include <functional>
 #include "Font.h"
+#include "TaskManager.h"
+#include "ShadowAtlas.h"
 
 class VulkanRenderer;
 
 class GraphicsWorld;
 
 constexpr size_t MAX_LIGHTS = 3;
+constexpr uint32_t SHADOW_ATLAS_SIZE = 4096;
+constexpr uint32_t SHADOW_TILE_MIN = 128;
+constexpr uint32_t SHADOW_TILE_MAX = 1024;
 
 class GraphicsBatch
 {
@@ -50,8 +57,15 @@ public:
 	void GenerateBatches();
 	void ProcessLights();
 	void ProcessGeometry();
-	void ProcessUI();
+	void ProcessUI(std::queue<Task>& tasks);
 	void ProcessParticleEmitters();
+	void CullViews(std::queue<Task>& tasks);
+	// Marks the shadow faces whose light or casters changed since their tile was last rendered
+	void UpdateShadowTiles();
+	// Asks the texture residency for the mips the camera can resolve on every visible object's textures
+	void RequestTextureMips();
+	// Object ids visible from a view, sorted by submesh in the same order as the view's commands
+	const std::vector<uint32_t>& GetVisibleObjects(uint32_t view) const;
 	const std::vector<oGFX::IndirectCommand>& GetBatch(int32_t batchIdx);
 	const std::vector<oGFX::IndirectCommand>& GetParticlesBatch();
 	const std::vector<ParticleData>& GetParticlesData();
@@ -61,8 +75,9 @@ public:
 	size_t GetScreenSpaceUIOffset() const;
 	// TODO :: need to return indices out if i am doing fill
 	
-	void GenerateTextGeometry(const UIInstance& ui);
-	void GenerateSpriteGeometry(const UIInstance& ui);
+	void GenerateTextGeometry(const UIInstance& ui, std::vector<oGFX::UIVertex>& out);
+	void GenerateSpriteGeometry(const UIInstance& ui, std::vector<oGFX::UIVertex>& out);
+	void MergeUIVertices();
 	
 	size_t m_numShadowCastGrids{};
 
@@ -74,16 +89,55 @@ public:
 	std::vector<ParticleData> m_particleList;
 	std::vector<oGFX::IndirectCommand> m_particleCommands;
 	std::vector<oGFX::UIVertex> m_uiVertices;
-	std::mutex m_uiVertMutex;
 
+	// ui is generated in chunks on the task manager, then merged in chunk order so the output does not depend on scheduling
+	struct UIChunk {
+		size_t begin{};
+		size_t end{};
+		std::vector<oGFX::UIVertex> vertices;
+	};
+	std::vector<const UIInstance*> m_uiInstances;
+	std::vector<UIChunk> m_uiChunks;
+	size_t m_numUIChunks{};
+	size_t m_numWorldUIChunks{};
+	static constexpr size_t UI_INSTANCES_PER_TASK = 32;
+
+	std::vector<OmniLightInstance> m_omniLights; // the snapshot's lights with their views built, the snapshot stays as the world wrote it
 	std::vector<LocalLightInstance>m_culledLights;
 	std::vector<LocalLightInstance>m_shadowCasters;
+	std::vector<uint32_t> m_culledLightIds; // world id of each culled light
+
+	// Tiles are kept across frames, a face is only rendered again when it is dirty
+	oGFX::ShadowAtlas m_shadowAtlas;
+	std::vector<oGFX::ShadowAtlas::Request> m_shadowRequests;
+	std::vector<oGFX::ShadowAtlas::Light*> m_shadowAtlasLights;
+	std::vector<glm::vec4> m_shadowTileRects; // uv rect of each shadow grid index, xy offset zw size
+	uint32_t m_numShadowFacesRendered{};
+
+	// Views culled together in a single pass over the octree, registered while the batches are generated
+	struct ViewSet {
+		std::vector<oGFX::Frustum> frustums;
+		std::vector<std::vector<uint32_t>> visible; // object ids seen by each view
+		std::vector<std::vector<oGFX::IndirectCommand>*> commands; // where each view's draw commands go
+
+		uint32_t AddView(const oGFX::Frustum& f, std::vector<oGFX::IndirectCommand>* outCommands = nullptr);
+		void Clear();
+		uint32_t size() const;
+	};
+	ViewSet m_views;
+	uint32_t m_cameraView{};
 
-	std::vector<DrawData> m_culledCameraObjects;
+	// Splits the views into numGroups contiguous groups and queues one task per group.
+	// Each group shares a single traversal of the tree, perView then runs for every view of the group on the same task.
+	static void QueueViewCulling(std::queue<Task>& tasks, oGFX::OctTree& tree, ViewSet& views, uint32_t numGroups
+		, std::function<void(uint32_t)> perView = {});
 
 	struct CastersData {		
 		std::vector<oGFX::IndirectCommand> m_commands [6];
-		std::vector<DrawData> m_culledObjects [6];
+		uint32_t m_views [6]{};
+		uint64_t m_lightHash [6]{}; // the light transform the face is rendered with
+		bool m_dirty [6]{};
+		oGFX::ShadowAtlas::Light* m_atlasLight{ nullptr };
 	};
 	std::vector<CastersData> m_casterData;
 
@@ -23,19 +23,124 @@ GraphicsWorld::GraphicsWorld() :
 	m_OctTree{ std::make_shared<oGFX::OctTree>() }
 {
 }
+template <typename T, typename SRC>
+void CopyInstances(std::vector<T>& dst, SRC& src)
+{
+	// assign over existing elements so their heap storage is reused, only a growing world allocates
+	dst.resize(src.size());
+	size_t i = 0;
+	for (const T& v : src)
+	{
+		dst[i++] = v;
+	}
+}
+
+void GraphicsWorld::PublishSnapshot()
+{
+	PROFILE_SCOPED();
+	auto& vr = *VulkanRenderer::get();
+	WorldSnapshot& snapshot = m_Snapshots[m_WriteSlot];
+	snapshot.generation = ++m_PublishedGeneration;
+
+	for (auto iter = m_ObjectInstances.begin(); iter != m_ObjectInstances.end(); iter++)
+	{
+		ObjectInstance& src = *iter;
+		if (src.localToWorld != src.prevLocalToWorld)
+		{
+			src.isDirty = true;
+		}
+		if (src.isDirty == true)
+		{
+			// stamped with the generation so the renderer still sees it if it skips this snapshot
+			src.dirtyGeneration = snapshot.generation;
+			src.isDirty = false;
+		}
+		src.prevLocalToWorld = src.localToWorld;
+
+		if (src.isSkinned())
+		{
+			auto& bones = m_ObjectBones[iter.index()];
+			if (bones.empty())
+			{
+				// models are published on the render thread, this one may still be waiting
+				const oGFX::Skeleton* skeleton = vr.GetSkeleton(src.modelID);
+				OO_ASSERT(skeleton && skeleton->inverseBindPose.size() && "Src model does not have bones");
+				bones.resize(skeleton->inverseBindPose.size());
+				for (auto& b : bones)
+				{
+					b = mat4(1.0f);
+				}
+			}
+		}
+	}
+
+	{
+		PROFILE_SCOPED("Snapshot objects");
+		// ObjectInstance is trivially copyable, this is a flat copy of the hot data
+		snapshot.objects = m_ObjectInstances;
+	}
+	snapshot.bones.resize(std::max(snapshot.bones.size(), m_ObjectBones.size()));
+	for (auto iter = m_ObjectInstances.begin(); iter != m_ObjectInstances.end(); iter++)
+	{
+		if (iter->isSkinned())
+		{
+			// reuses the capacity of the previous copy
+			snapshot.bones[iter.index()] = m_ObjectBones[iter.index()];
+		}
+	}
+
+	CopyInstances(snapshot.emitters, m_EmitterInstances);
+	CopyInstances(snapshot.ui, m_UIInstances);
+	CopyInstances(snapshot.omniLights, m_OmniLightInstances);
+	snapshot.omniLightIds.clear();
+	for (auto iter = m_OmniLightInstances.begin(); iter != m_OmniLightInstances.end(); iter++)
+	{
+		snapshot.omniLightIds.push_back(static_cast<uint32_t>(iter.index()));
+	}
+
+	snapshot.numCameras = numCameras;
+	snapshot.cameras = cameras;
+	snapshot.ssaoSettings = ssaoSettings;
+	snapshot.lightSettings = lightSettings;
+	snapshot.bloomSettings = bloomSettings;
+	snapshot.colourSettings = colourSettings;
+	snapshot.vignetteSettings = vignetteSettings;
+
+	// hand the snapshot over and take back whatever the renderer has not consumed
+	m_WriteSlot = m_ReadySlot.exchange(m_WriteSlot | SNAPSHOT_FRESH_BIT, std::memory_order_acq_rel) & ~SNAPSHOT_FRESH_BIT;
+}
+
 OO_OPTIMIZE_OFF
 void GraphicsWorld::BeginFrame()
 {
 	PROFILE_SCOPED();
 	auto& vr = *VulkanRenderer::get();
-	for (size_t i = 0; i < m_ObjectInstances.size(); i++)
+
+	if (publishFromGameThread == false)
 	{
-		m_ObjectInstances.buffer()[i].prevLocalToWorld = m_ObjectInstancesCopy.buffer()[i].localToWorld;
+		PublishSnapshot();
+	}
+
+	if (m_ReadySlot.load(std::memory_order_acquire) & SNAPSHOT_FRESH_BIT)
+	{
+		// the matrices drawn with last frame become the previous ones when the renderer updates the new cameras
+		std::array<Camera, 2> lastCameras = RenderSnapshot().cameras;
+		// pointer flip, the previous read slot goes back to the game thread
+		m_ReadSlot = m_ReadySlot.exchange(m_ReadSlot, std::memory_order_acq_rel) & ~SNAPSHOT_FRESH_BIT;
+		for (size_t i = 0; i < lastCameras.size(); i++)
+		{
+			RenderSnapshot().cameras[i].matrices = lastCameras[i].matrices;
+		}
 	}
-	m_ObjectInstancesCopy = m_ObjectInstances;
+	WorldSnapshot& snapshot = RenderSnapshot();
+	auto& objects = snapshot.objects;
+
+	m_ObjectBounds.resize(objects.buffer().size());
+	m_ObjectLastTransform.resize(objects.buffer().size());
+	m_ObjectGenerations.resize(objects.buffer().size());
 	
 	// this doesnt work with all submesh
-	auto getBoxFun = [&ents = m_ObjectInstancesCopy.buffer(), &models = vr.g_globalModels,&submeshes = vr.g_globalSubmesh](ObjectInstance& oi)->oGFX::AABB {
+	auto getBoxFun = [&models = vr.g_globalModels,&submeshes = vr.g_globalSubmesh](ObjectInstance& oi)->oGFX::AABB {
 		oGFX::AABB box;
 		auto& mdl = models[oi.modelID];
 		uint32_t g_submeshID = mdl.m_subMeshes[oi.submesh];
@@ -53,65 +158,65 @@ void GraphicsWorld::BeginFrame()
 		return box;
 	};
 
-	m_OctTree->ClearTree(); 
 	{
-		PROFILE_SCOPED("Build Octtree");
-		for (auto iter = m_ObjectInstancesCopy.begin(); iter != m_ObjectInstancesCopy.end(); iter++)
+		PROFILE_SCOPED("Update Octtree");
+		// drop objects that were destroyed since the last snapshot we consumed, an id handed out again is a new object
+		for (uint32_t id = 0; id < m_OctTree->capacity(); ++id)
 		{
-			ObjectInstance& cpy = *iter;
-			//if (cpy.isDirty == true) 
+			if (m_OctTree->Contains(id) && objects.IsValid(ObjectHandle{ static_cast<int32_t>(id), m_ObjectGenerations[id] }) == false)
 			{
-				size_t idx = iter.index();
-				oGFX::AABB box = getBoxFun(cpy);
-				//if (cpy.newObject == false)
-				//	m_octTree.Remove(idx);
-				m_OctTree->Insert(&cpy, box);
+				m_OctTree->Remove(id);
 			}
 		}
-	}
-	
-	for (auto iter = m_ObjectInstances.begin(); iter != m_ObjectInstances.end(); iter++)
-	{
-		ObjectInstance& src = *iter;
-		if (src.isSkinned())
+
+		// only new and moved objects touch the tree, static objects stay where they were inserted
+		for (auto iter = objects.begin(); iter != objects.end(); iter++)
 		{
-			auto& mdl = vr.g_globalModels[src.modelID];
-			if (src.bones.empty())
+			ObjectInstance& obj = *iter;
+			const uint32_t id = static_cast<uint32_t>(iter.index());
+			if (vr.IsModelPublished(obj.modelID) == false)
 			{
-				OO_ASSERT(mdl.skeleton->inverseBindPose.size() && "Src model does not have bones");
-				src.bones.resize(mdl.skeleton->inverseBindPose.size());
-				for (auto& b : src.bones)
+				// loaded after the last publish, it joins the tree once the render thread has the model
+				continue;
+			}
+			const bool inTree = m_OctTree->Contains(id);
+			if (inTree == false || obj.dirtyGeneration > m_ConsumedGeneration)
+			{
+				obj.prevLocalToWorld = inTree ? m_ObjectLastTransform[id] : obj.localToWorld;
+				m_ObjectLastTransform[id] = obj.localToWorld;
+				m_ObjectBounds[id] = getBoxFun(obj);
+				if (inTree)
 				{
-					b = mat4(1.0f);
+					m_OctTree->Move(id, m_ObjectBounds[id]);
+				}
+				else
+				{
+					m_OctTree->Insert(id, m_ObjectBounds[id]);
+					m_ObjectGenerations[id] = objects.GetHandle(id).generation;
 				}
 			}
-		}		
-		src.isDirty = false;
-		src.newObject = false;
-	}
-	
-	m_EmitterCopy.clear();
-	m_EmitterCopy.reserve(m_EmitterInstances.size());
-	for (const EmitterInstance& src: m_EmitterInstances)
-	{
-		m_EmitterCopy.emplace_back(src);
-	}
-
-	m_UIcopy.clear();
-	m_UIcopy.reserve(m_UIInstances.size());
-	for (const UIInstance& src: m_UIInstances)
-	{
-		m_UIcopy.emplace_back(src);
+			else
+			{
+				obj.prevLocalToWorld = obj.localToWorld;
+			}
+		}
 	}
 
-	m_OmniLightCopy.clear();
-	m_OmniLightCopy.reserve(m_OmniLightInstances.size());
-	for (const OmniLightInstance& src: m_OmniLightInstances)
+	if (m_OctTree->NeedsRebuild())
 	{
-		m_OmniLightCopy.emplace_back(src);
+		// something left the root bounds, resize and rebuild the whole tree
+		PROFILE_SCOPED("Build Octtree");
+		m_OctTree->ClearTree();
+		for (auto iter = objects.begin(); iter != objects.end(); iter++)
+		{
+			if (vr.IsModelPublished(iter->modelID))
+			{
+				m_OctTree->Insert(static_cast<uint32_t>(iter.index()), m_ObjectBounds[iter.index()]);
+			}
+		}
 	}
 
-	
+	m_ConsumedGeneration = snapshot.generation;
 }
 OO_OPTIMIZE_ON
 
@@ -128,7 +233,16 @@ int32_t GraphicsWorld::CreateObjectInstance()
 int32_t GraphicsWorld::CreateObjectInstance(ObjectInstance obj)
 {
 	++m_EntityCount;
+	// a new object may land in a reused id, make sure the renderer refreshes its slot
+	obj.SetDirty();
 	auto id = m_ObjectInstances.Add(obj);
+	if (static_cast<size_t>(id) >= m_ObjectNames.size())
+	{
+		m_ObjectNames.resize(m_ObjectInstances.buffer().size());
+		m_ObjectBones.resize(m_ObjectInstances.buffer().size());
+	}
+	m_ObjectNames[id].clear();
+	m_ObjectBones[id].clear();
 	return id;
 }
 
@@ -136,18 +250,50 @@ ObjectInstance& GraphicsWorld::GetObjectInstance(int32_t id)
 {
 	return m_ObjectInstances.Get(id);
 }
+GraphicsWorld::ObjectHandle GraphicsWorld::GetObjectHandle(int32_t id) const
+{
+	return m_ObjectInstances.GetHandle(id);
+}
+bool GraphicsWorld::IsValid(ObjectHandle handle) const
+{
+	return m_ObjectInstances.IsValid(handle);
+}
+ObjectInstance& GraphicsWorld::GetObjectInstance(ObjectHandle handle)
+{
+	return m_ObjectInstances.Get(handle);
+}
+
+std::string& GraphicsWorld::GetObjectName(int32_t id)
+{
+	OO_ASSERT(static_cast<size_t>(id) < m_ObjectNames.size() && "Invalid object id");
+	return m_ObjectNames[id];
+}
+
+std::vector<glm::mat4>& GraphicsWorld::GetObjectBones(int32_t id)
+{
+	OO_ASSERT(static_cast<size_t>(id) < m_ObjectBones.size() && "Invalid object id");
+	return m_ObjectBones[id];
+}
 
 void GraphicsWorld::DestroyObjectInstance(int32_t id)
 {
+	// the renderer drops it from the tree once it sees a snapshot without it
 	m_ObjectInstances.Remove(id);
-	m_OctTree->Remove(&m_ObjectInstances.buffer()[id]); // remove from tree special
 	--m_EntityCount;
 }
+void GraphicsWorld::DestroyObjectInstance(ObjectHandle handle)
+{
+	if (m_ObjectInstances.IsValid(handle) == false)
+	{
+		assert(false); // stale handle, the object was already destroyed
+		return;
+	}
+	DestroyObjectInstance(handle.id);
+}
 
 void GraphicsWorld::ClearObjectInstances()
 {
 	m_ObjectInstances.Clear();
-	m_OctTree->ClearTree();
 	m_EntityCount = 0;
 }
 
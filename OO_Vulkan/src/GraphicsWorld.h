@@ -27,6 +27,9 @@ Technology is prohibited.
 #include <vector>
 #include <array>
 #include <memory>
+#include <string>
+#include <type_traits>
+#include <atomic>
 
 namespace oGFX {
     class OctTree;
@@ -72,10 +75,10 @@ enum class UIInstanceFlags : uint32_t
 };
 ENUM_OPERATORS_GEN(UIInstanceFlags, uint32_t)
 
+// Hot per object render data, kept trivially copyable so the frame snapshot is a flat copy.
+// Cold data (names, bones) lives in separate tables in GraphicsWorld indexed by the same id.
 struct ObjectInstance
 {
-    std::string name;
-
     uint32_t bindlessGlobalTextureIndex_Albedo{ 0xFFFFFFFF };
     uint32_t bindlessGlobalTextureIndex_Normal{ 0xFFFFFFFF };
     uint32_t bindlessGlobalTextureIndex_Roughness{ 0xFFFFFFFF };
@@ -92,8 +95,7 @@ struct ObjectInstance
         | ObjectInstanceFlags::SHADOW_CASTER)};
 
     bool isDirty = true;
-    bool newObject = true;
-    oGFX::OctNode* treeNode{ nullptr };
+    uint32_t dirtyGeneration{}; // snapshot generation this object last changed in
 
     // helper functions
     void SetShadowCaster(bool s);
@@ -111,33 +113,11 @@ struct ObjectInstance
     bool isDynamic();
     bool isTransparent();
 
-    std::vector<glm::mat4> bones;
-
     uint32_t modelID{}; // Index for the mesh
     uint32_t submesh;// submeshes to draw
     uint32_t entityID{}; // Unique ID for this entity instance
 };
-
-struct DrawData {
-    uint32_t bindlessGlobalTextureIndex_Albedo{ 0xFFFFFFFF };
-    uint32_t bindlessGlobalTextureIndex_Normal{ 0xFFFFFFFF };
-    uint32_t bindlessGlobalTextureIndex_Roughness{ 0xFFFFFFFF };
-    uint32_t bindlessGlobalTextureIndex_Metallic{ 0xFFFFFFFF };
-    uint32_t bindlessGlobalTextureIndex_Emissive{ 0xFFFFFFFF };
-    glm::vec4 emissiveColour{};
-
-    glm::mat4x4 localToWorld{ 1.0f };
-    glm::mat4x4 prevLocalToWorld{ 1.0f };
-
-    uint32_t submeshID{}; // Index for the mesh
-    uint32_t entityID{}; // Unique ID for this entity instance
-    ObjectInstanceFlags flags{};
-    uint8_t instanceData{};
-    uint32_t objectInstanceID{};
-
-    uint32_t modelID{};
-    const std::vector<glm::mat4>* ptrToBoneBuffer{nullptr};
-};
+static_assert(std::is_trivially_copyable_v<ObjectInstance>, "ObjectInstance must stay trivially copyable, move heap data to the cold tables");
 
 struct UIInstance
 {
@@ -174,6 +154,7 @@ struct ParticleData
     glm::mat4 transform{1.0f};
     glm::vec4 colour{1.0f};
     glm::ivec4 instanceData{0}; // EntityID, flags  ,abledo norm, roughness metal
+    glm::vec4 positionDequant{ 0.0f, 0.0f, 0.0f, 1.0f }; // filled by GraphicsBatch from the model
 };
 
 struct UIData
@@ -232,6 +213,72 @@ struct DecalInstance
     float nearZ{ -1.0f };
 };
 
+struct SSAOSettings
+{
+    float radius = 0.5f;
+    float bias = 0.025f;
+    float intensity = 1.0f;
+    uint32_t samples = 8;
+    uint32_t type = 0;
+};
+
+struct LightingSettings
+{
+    float ambient = 0.2f;
+    float maxBias = 0.0001f;
+    float biasMultiplier = 0.002f;
+    float specularModifier = 16.0f;
+    glm::vec3 directionalLight{0, -1, 0};
+    glm::vec4 directionalLightColor{ 1, 1, 1, 1 };
+};
+
+struct BloomSettings
+{
+    bool enabled = true;
+    float threshold = 10.0f;
+    float softThreshold = 0.01f;
+};
+
+struct ColourCorrectionSettings
+{
+    bool enabled = false;
+    float highlightThreshold = 1.0f;
+    float shadowThreshold = 0.0f;
+    glm::vec4 shadowColour{};
+    glm::vec4 midtonesColour{};
+    glm::vec4 highlightColour{};
+    float exposure = 0.20f;
+};
+
+struct VignetteSettings
+{
+    bool enabled = false;
+    vec4 colour;
+    float innerRadius;
+    float outerRadius;
+};
+
+// Renderer side copy of the world, handed over by GraphicsWorld::PublishSnapshot
+struct WorldSnapshot
+{
+    uint32_t generation{};
+    BitContainer<ObjectInstance> objects;
+    std::vector<std::vector<glm::mat4>> bones; // only skinned objects are copied
+    std::vector<UIInstance> ui;
+    std::vector<OmniLightInstance> omniLights;
+    std::vector<uint32_t> omniLightIds; // world id of each light, stable while the light lives
+    std::vector<EmitterInstance> emitters;
+
+    // what the renderer draws with, the game keeps writing the live ones in GraphicsWorld
+    uint32_t numCameras{ 1 };
+    std::array<Camera, 2> cameras;
+    SSAOSettings ssaoSettings{};
+    LightingSettings lightSettings{};
+    BloomSettings bloomSettings{};
+    ColourCorrectionSettings colourSettings{};
+    VignetteSettings vignetteSettings{};
+};
+
 // TODO: Move all object storage here...
 class GraphicsWorld
 {
@@ -240,17 +287,35 @@ public:
     GraphicsWorld();
     // Call this at the beginning of the frame
     void BeginFrame();
+    // Copies the world into the game side snapshot and hands it to the renderer.
+    // Call from the game thread once the frame is simulated when publishFromGameThread is set.
+    void PublishSnapshot();
     // Call this at the end of the frame
     void EndFrame();
 
+    // The snapshot consumed by the last BeginFrame, render thread only
+    WorldSnapshot& RenderSnapshot() { return m_Snapshots[m_ReadSlot]; }
+    // Any of the slots, whichever thread owns it right now
+    WorldSnapshot& GetSnapshot(uint32_t slot) { return m_Snapshots[slot]; }
+    inline static constexpr uint32_t NUM_SNAPSHOTS = 3;
+
     auto& GetAllObjectInstances() { return m_ObjectInstances; }
     auto& GetAllOmniLightInstances() { return m_OmniLightInstances; }
     auto& GetAllEmitterInstances() { return m_EmitterInstances; }
     auto& GetAllUIInstances() { return m_UIInstances; }
 
+    using ObjectHandle = BitContainer<ObjectInstance>::Handle;
+
     int32_t CreateObjectInstance();
     int32_t CreateObjectInstance(ObjectInstance obj);
     ObjectInstance& GetObjectInstance(int32_t id);
+    // A handle goes stale once its object is destroyed, even when the id is handed out again
+    ObjectHandle GetObjectHandle(int32_t id) const;
+    bool IsValid(ObjectHandle handle) const;
+    ObjectInstance& GetObjectInstance(ObjectHandle handle);
+    void DestroyObjectInstance(ObjectHandle handle);
+    std::string& GetObjectName(int32_t id);
+    std::vector<glm::mat4>& GetObjectBones(int32_t id);
     void DestroyObjectInstance(int32_t id);
     void ClearObjectInstances();
 
@@ -274,6 +339,9 @@ public:
 
     void SubmitParticles(std::vector<ParticleData>& particleData, uint32_t cnt, int32_t modelID);
 
+    // When false the renderer publishes in BeginFrame, for applications that update and render on one thread
+    bool publishFromGameThread = false;
+
     uint32_t numCameras = 1;
     std::array<bool, 2> shouldRenderCamera{ true, false };
     std::array<Camera, 2>cameras;
@@ -283,56 +351,20 @@ public:
     // TODO: Fix Me ! This is for testing
     DecalInstance m_HardcodedDecalInstance;
 
-    struct SSAOSettings
-    {
-        float radius = 0.5f;
-        float bias = 0.025f;
-        float intensity = 1.0f;
-        uint32_t samples = 8;
-        uint32_t type = 0;
-    }ssaoSettings{};
-
-    struct LightingSettings
-    {
-        float ambient = 0.2f;
-        float maxBias = 0.0001f;
-        float biasMultiplier = 0.002f;
-        float specularModifier = 16.0f;
-        glm::vec3 directionalLight{0, -1, 0};
-        glm::vec4 directionalLightColor{ 1, 1, 1, 1 };
-    }lightSettings{};
-
-    struct BloomSettings
-    {
-        bool enabled = true;
-        float threshold = 10.0f;
-        float softThreshold = 0.01f;
-    }bloomSettings{};
-
-    struct ColourCorrectionSettings
-    {
-        bool enabled = false;
-        float highlightThreshold = 1.0f;
-        float shadowThreshold = 0.0f;
-        glm::vec4 shadowColour{};
-        glm::vec4 midtonesColour{};
-        glm::vec4 highlightColour{};
-        float exposure = 0.20f;
-    }colourSettings{};
-
-    struct VignetteSettings
-    {
-        bool enabled = false;
-        vec4 colour;
-        float innerRadius;
-        float outerRadius;
-    }vignetteSettings{};
+    SSAOSettings ssaoSettings{};
+    LightingSettings lightSettings{};
+    BloomSettings bloomSettings{};
+    ColourCorrectionSettings colourSettings{};
+    VignetteSettings vignetteSettings{};
 
     friend class VulkanRenderer;
     friend class GraphicsBatch;
 private:
     int32_t m_EntityCount{};
     BitContainer<ObjectInstance> m_ObjectInstances;
+    // cold object data, indexed by object id
+    std::vector<std::string> m_ObjectNames;
+    std::vector<std::vector<glm::mat4>> m_ObjectBones;
     int32_t m_UiCount{};
     BitContainer<UIInstance> m_UIInstances;
     int32_t m_LightCount{};
@@ -341,12 +373,19 @@ private:
     BitContainer<EmitterInstance> m_EmitterInstances;
     bool initialized = false;
 
-    //etc
-    BitContainer<ObjectInstance> m_ObjectInstancesCopy;
-    std::vector<uint32_t> m_ObjectsIndex;
-    std::vector<UIInstance> m_UIcopy;
-    std::vector<OmniLightInstance> m_OmniLightCopy;
-    std::vector<EmitterInstance> m_EmitterCopy;
+    // triple buffered snapshots, the game thread fills the write slot while the renderer reads another
+    inline static constexpr uint32_t SNAPSHOT_FRESH_BIT = 0x4;
+    std::array<WorldSnapshot, NUM_SNAPSHOTS> m_Snapshots;
+    uint32_t m_WriteSlot{ 0 }; // game thread only
+    uint32_t m_ReadSlot{ 1 };  // render thread only
+    std::atomic<uint32_t> m_ReadySlot{ 2 }; // slot index, with SNAPSHOT_FRESH_BIT when not yet consumed
+    uint32_t m_PublishedGeneration{}; // game thread only
+    uint32_t m_ConsumedGeneration{};  // render thread only
+
+    // render thread object state, indexed by object id
+    std::vector<oGFX::AABB> m_ObjectBounds; // world bounds of each object, updated when dirty
+    std::vector<glm::mat4> m_ObjectLastTransform; // transform last seen by the renderer
+    std::vector<uint32_t> m_ObjectGenerations; // generation of the object each tree entry was made for
 
     std::shared_ptr<oGFX::OctTree> m_OctTree;
     // + Spatial Acceleration Structures
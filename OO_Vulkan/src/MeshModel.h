@@ -18,6 +18,10 @@ Technology is prohibited.
 #include "VulkanUtils.h"
 #include "Mesh.h"
 #include "Geometry.h"
+#include "MeshRangeAllocator.h"
+#include "MeshOptimizer.h"
+#include "VertexPacking.h"
+#include "MeshletBuilder.h"
 
 #pragma warning( push )
 #pragma warning( disable : 26451 ) // vendor overflow
@@ -104,6 +108,11 @@ struct ModelFileResource
     std::vector<oGFX::Vertex> vertices;
     std::vector<uint32_t> indices;
     std::vector<uint32_t> submeshToMaterial;
+    // file vertex to loaded vertex, the import merges and reorders them
+    std::vector<uint32_t> vertexRemap;
+    std::vector<oGFX::MeshOpt::Report> importReports;
+    // clusters of every submesh, the submeshes hold their range
+    oGFX::Meshlets::MeshletData meshlets;
     std::vector<Material> materials;
 
     Node* sceneInfo{ nullptr };
@@ -125,6 +134,9 @@ struct SubMesh
     uint32_t baseIndices{};
     uint32_t indicesCount{};
     oGFX::Sphere boundingSphere;
+    // range of the global meshlet buffer
+    uint32_t meshletOffset{};
+    uint32_t meshletCount{};
 
     // TODO: Material
 };
@@ -139,6 +151,16 @@ struct gfxModel
     uint32_t baseIndices{};
     uint32_t indicesCount{};
 
+    // ranges of the global mesh buffers, the offsets are the base vertex and base index above
+    MeshRangeAllocator::Allocation vertexRange;
+    MeshRangeAllocator::Allocation indexRange;
+    MeshRangeAllocator::Allocation meshletRange;
+    MeshRangeAllocator::Allocation meshletVertexRange;
+    MeshRangeAllocator::Allocation meshletTriangleRange;
+
+    // bounds the packed positions are quantized to, see VertexPacking.h
+    glm::vec4 positionDequant{ 0.0f, 0.0f, 0.0f, 1.0f };
+
     uint32_t skinningWeightsOffset{};
 
     std::vector<uint32_t> m_subMeshes;
@@ -0,0 +1,436 @@
+/************************************************************************************//*!
+\file           MeshOptimizer.cpp
+\project        Ouroboros
+\author         Jamie Kong, j.kong, 390004720 | code contribution (100%)
+\par            email: j.kong\@digipen.edu
+\date           May 20, 2024
+\brief              Defines the import time mesh optimization, vertex deduplication, triangle order for
+the post transform cache and overdraw, vertex order for fetch
+
+Copyright (C) 2022 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents
+without the prior written consent of DigiPen Institute of
+Technology is prohibited.
+*//*************************************************************************************/
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+
+namespace
+{
+	using namespace oGFX::MeshOpt;
+
+	uint64_t HashVertex(const std::vector<VertexStream>& streams, uint32_t v)
+	{
+		uint64_t hash = 0xcbf29ce484222325ull;
+		for (const VertexStream& s : streams)
+		{
+			const unsigned char* bytes = static_cast<const unsigned char*>(s.data) + v * s.stride;
+			for (size_t i = 0; i < s.size; ++i)
+			{
+				hash ^= bytes[i];
+				hash *= 0x100000001b3ull;
+			}
+		}
+		return hash;
+	}
+
+	bool EqualVertex(const std::vector<VertexStream>& streams, uint32_t a, uint32_t b)
+	{
+		for (const VertexStream& s : streams)
+		{
+			const unsigned char* bytes = static_cast<const unsigned char*>(s.data);
+			if (memcmp(bytes + a * s.stride, bytes + b * s.stride, s.size) != 0)
+				return false;
+		}
+		return true;
+	}
+
+	// Forsyth's scoring, tuned for a 32 entry LRU
+	constexpr int32_t CACHE_SIZE = 32;
+
+	float VertexScore(uint32_t activeTriangles, int32_t cachePosition)
+	{
+		if (activeTriangles == 0)
+			return -1.0f;
+
+		float score = 0.0f;
+		if (cachePosition >= 0)
+		{
+			// the last triangle's vertices are about to be used again whatever happens, do not favour one of them
+			if (cachePosition < 3)
+				score = 0.75f;
+			else
+				score = std::pow(1.0f - static_cast<float>(cachePosition - 3) / (CACHE_SIZE - 3), 1.5f);
+		}
+		// get the vertices with few triangles left out of the way, lone triangles are the ones that cost misses
+		return score + 2.0f / std::sqrt(static_cast<float>(activeTriangles));
+	}
+
+	// triangles using each vertex, offsets[v] to offsets[v + 1]
+	void BuildAdjacency(const uint32_t* indices, size_t indexCount, size_t vertexCount,
+		std::vector<uint32_t>& offsets, std::vector<uint32_t>& triangles)
+	{
+		offsets.assign(vertexCount + 1, 0);
+		for (size_t i = 0; i < indexCount; ++i)
+		{
+			++offsets[indices[i] + 1];
+		}
+		std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+		std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+		triangles.resize(indexCount);
+		for (size_t i = 0; i < indexCount; ++i)
+		{
+			triangles[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+		}
+	}
+
+	uint32_t CountMisses(const uint32_t* indices, size_t triangleCount, std::vector<uint32_t>& timestamps, uint32_t& time, uint32_t cacheSize)
+	{
+		uint32_t misses = 0;
+		for (size_t i = 0; i < triangleCount * 3; ++i)
+		{
+			uint32_t& stamp = timestamps[indices[i]];
+			// FIFO, a hit does not refresh the entry
+			if (time - stamp > cacheSize)
+			{
+				stamp = time++;
+				++misses;
+			}
+		}
+		return misses;
+	}
+}
+
+namespace oGFX::MeshOpt
+{
+	size_t GenerateVertexRemap(std::vector<uint32_t>& remap, const uint32_t* indices, size_t indexCount, size_t vertexCount,
+		const std::vector<VertexStream>& streams)
+	{
+		remap.assign(vertexCount, UNUSED_VERTEX);
+
+		// open addressing over the first vertex seen with each value
+		size_t tableSize = 1;
+		while (tableSize < vertexCount + vertexCount / 4) tableSize *= 2;
+		std::vector<uint32_t> table(tableSize, UNUSED_VERTEX);
+		const size_t mask = tableSize - 1;
+
+		uint32_t next = 0;
+		for (size_t i = 0; i < indexCount; ++i)
+		{
+			const uint32_t v = indices[i];
+			if (remap[v] != UNUSED_VERTEX)
+				continue;
+
+			size_t slot = HashVertex(streams, v) & mask;
+			while (table[slot] != UNUSED_VERTEX && EqualVertex(streams, table[slot], v) == false)
+			{
+				slot = (slot + 1) & mask;
+			}
+			if (table[slot] == UNUSED_VERTEX)
+			{
+				table[slot] = v;
+				remap[v] = next++;
+			}
+			else
+			{
+				remap[v] = remap[table[slot]];
+			}
+		}
+		return next;
+	}
+
+	void RemapIndices(uint32_t* indices, size_t indexCount, const std::vector<uint32_t>& remap)
+	{
+		for (size_t i = 0; i < indexCount; ++i)
+		{
+			indices[i] = remap[indices[i]];
+		}
+	}
+
+	void OptimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount)
+	{
+		const size_t triangleCount = indexCount / 3;
+		if (triangleCount == 0)
+			return;
+
+		std::vector<uint32_t> offsets, adjacency;
+		BuildAdjacency(indices, indexCount, vertexCount, offsets, adjacency);
+
+		std::vector<uint32_t> active(vertexCount);
+		std::vector<int32_t> cachePosition(vertexCount, -1);
+		std::vector<float> vertexScore(vertexCount);
+		for (size_t v = 0; v < vertexCount; ++v)
+		{
+			active[v] = offsets[v + 1] - offsets[v];
+			vertexScore[v] = VertexScore(active[v], -1);
+		}
+
+		std::vector<float> triangleScore(triangleCount);
+		std::vector<bool> emitted(triangleCount, false);
+		uint32_t best = 0;
+		for (size_t t = 0; t < triangleCount; ++t)
+		{
+			triangleScore[t] = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+			if (triangleScore[t] > triangleScore[best]) best = static_cast<uint32_t>(t);
+		}
+
+		std::vector<uint32_t> result;
+		result.reserve(indexCount);
+		std::vector<uint32_t> cache, nextCache;
+		cache.reserve(CACHE_SIZE + 3);
+		nextCache.reserve(CACHE_SIZE + 3);
+		size_t cursor = 0;
+
+		for (size_t emittedCount = 0; emittedCount < triangleCount; ++emittedCount)
+		{
+			if (best == UNUSED_VERTEX)
+			{
+				// nothing in the cache has triangles left, start again from the next triangle in the input
+				while (emitted[cursor]) ++cursor;
+				best = static_cast<uint32_t>(cursor);
+			}
+
+			const uint32_t* tri = indices + best * 3;
+			emitted[best] = true;
+			nextCache.assign(tri, tri + 3);
+			for (uint32_t k = 0; k < 3; ++k)
+			{
+				const uint32_t v = tri[k];
+				result.push_back(v);
+
+				// drop the triangle from the vertex's active list
+				uint32_t* list = adjacency.data() + offsets[v];
+				auto it = std::find(list, list + active[v], best);
+				if (it != list + active[v])
+				{
+					std::swap(*it, list[active[v] - 1]);
+					--active[v];
+				}
+			}
+			for (uint32_t v : cache)
+			{
+				if (v != tri[0] && v != tri[1] && v != tri[2]) nextCache.push_back(v);
+			}
+
+			// new scores for whatever is in the cache or just fell out of it
+			for (size_t i = 0; i < nextCache.size(); ++i)
+			{
+				const uint32_t v = nextCache[i];
+				cachePosition[v] = i < CACHE_SIZE ? static_cast<int32_t>(i) : -1;
+				vertexScore[v] = VertexScore(active[v], cachePosition[v]);
+			}
+
+			best = UNUSED_VERTEX;
+			float bestScore = -1.0f;
+			for (uint32_t v : nextCache)
+			{
+				for (uint32_t i = offsets[v]; i < offsets[v] + active[v]; ++i)
+				{
+					const uint32_t t = adjacency[i];
+					const uint32_t* ti = indices + t * 3;
+					triangleScore[t] = vertexScore[ti[0]] + vertexScore[ti[1]] + vertexScore[ti[2]];
+					if (triangleScore[t] > bestScore)
+					{
+						bestScore = triangleScore[t];
+						best = t;
+					}
+				}
+			}
+
+			if (nextCache.size() > CACHE_SIZE) nextCache.resize(CACHE_SIZE);
+			std::swap(cache, nextCache);
+		}
+
+		std::copy(result.begin(), result.end(), indices);
+	}
+
+	void OptimizeOverdraw(uint32_t* indices, size_t indexCount, const float* positions, size_t vertexCount, size_t positionStride,
+		float threshold)
+	{
+		const size_t triangleCount = indexCount / 3;
+		if (triangleCount == 0)
+			return;
+
+		constexpr uint32_t cacheSize = 16;
+		std::vector<uint32_t> timestamps(vertexCount, 0);
+		uint32_t time = cacheSize + 1;
+
+		// hard boundaries, the cache order starts over where a triangle misses all three vertices.
+		// The first triangle always starts one, it misses fewer when it is degenerate
+		std::vector<uint32_t> hard;
+		for (size_t t = 0; t < triangleCount; ++t)
+		{
+			const uint32_t misses = CountMisses(indices + t * 3, 1, timestamps, time, cacheSize);
+			if (t == 0 || misses == 3) hard.push_back(static_cast<uint32_t>(t));
+		}
+		hard.push_back(static_cast<uint32_t>(triangleCount));
+
+		// soft boundaries, split a cluster where the part so far is already close enough to the cluster's ACMR
+		std::vector<uint32_t> clusters;
+		for (size_t c = 0; c + 1 < hard.size(); ++c)
+		{
+			const uint32_t start = hard[c];
+			const uint32_t end = hard[c + 1];
+
+			time += cacheSize + 1;
+			const float clusterACMR = static_cast<float>(CountMisses(indices + start * 3, end - start, timestamps, time, cacheSize)) / (end - start);
+
+			time += cacheSize + 1;
+			uint32_t pieceStart = start;
+			uint32_t pieceMisses = 0;
+			clusters.push_back(start);
+			for (uint32_t t = start; t < end; ++t)
+			{
+				pieceMisses += CountMisses(indices + t * 3, 1, timestamps, time, cacheSize);
+				const float pieceACMR = static_cast<float>(pieceMisses) / (t - pieceStart + 1);
+				if (t + 1 < end && pieceACMR <= clusterACMR * threshold)
+				{
+					// the next piece starts with a cold cache, as it would after the clusters are sorted
+					pieceStart = t + 1;
+					pieceMisses = 0;
+					time += cacheSize + 1;
+					clusters.push_back(pieceStart);
+				}
+			}
+		}
+		clusters.push_back(static_cast<uint32_t>(triangleCount));
+
+		auto position = [positions, positionStride](uint32_t v) {
+			return reinterpret_cast<const float*>(reinterpret_cast<const char*>(positions) + v * positionStride);
+		};
+
+		// clusters facing out of the mesh are drawn first, they cover what is behind them
+		const size_t numClusters = clusters.size() - 1;
+		std::vector<float> clusterCentroid(numClusters * 3, 0.0f);
+		std::vector<float> clusterNormal(numClusters * 3, 0.0f);
+		float meshCentroid[3]{};
+		float meshArea = 0.0f;
+		for (size_t c = 0; c < numClusters; ++c)
+		{
+			float area = 0.0f;
+			for (uint32_t t = clusters[c]; t < clusters[c + 1]; ++t)
+			{
+				const float* p0 = position(indices[t * 3]);
+				const float* p1 = position(indices[t * 3 + 1]);
+				const float* p2 = position(indices[t * 3 + 2]);
+				const float e1[3]{ p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+				const float e2[3]{ p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+				const float n[3]{ e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+				const float a = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+				for (int k = 0; k < 3; ++k)
+				{
+					clusterCentroid[c * 3 + k] += (p0[k] + p1[k] + p2[k]) / 3.0f * a;
+					clusterNormal[c * 3 + k] += n[k];
+					meshCentroid[k] += (p0[k] + p1[k] + p2[k]) / 3.0f * a;
+				}
+				area += a;
+			}
+			meshArea += area;
+			for (int k = 0; k < 3; ++k)
+			{
+				clusterCentroid[c * 3 + k] = area > 0.0f ? clusterCentroid[c * 3 + k] / area : position(indices[clusters[c] * 3])[k];
+			}
+		}
+		for (int k = 0; k < 3; ++k)
+		{
+			meshCentroid[k] = meshArea > 0.0f ? meshCentroid[k] / meshArea : 0.0f;
+		}
+
+		std::vector<float> sortKey(numClusters);
+		for (size_t c = 0; c < numClusters; ++c)
+		{
+			const float* n = &clusterNormal[c * 3];
+			const float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+			float key = 0.0f;
+			for (int k = 0; k < 3; ++k)
+			{
+				key += (clusterCentroid[c * 3 + k] - meshCentroid[k]) * (length > 0.0f ? n[k] / length : 0.0f);
+			}
+			sortKey[c] = key;
+		}
+
+		std::vector<uint32_t> order(numClusters);
+		std::iota(order.begin(), order.end(), 0u);
+		std::stable_sort(order.begin(), order.end(), [&sortKey](uint32_t a, uint32_t b) { return sortKey[a] > sortKey[b]; });
+
+		std::vector<uint32_t> result;
+		result.reserve(triangleCount * 3);
+		for (uint32_t c : order)
+		{
+			result.insert(result.end(), indices + clusters[c] * 3, indices + clusters[c + 1] * 3);
+		}
+		std::copy(result.begin(), result.end(), indices);
+	}
+
+	size_t OptimizeVertexFetchRemap(std::vector<uint32_t>& remap, const uint32_t* indices, size_t indexCount, size_t vertexCount)
+	{
+		remap.assign(vertexCount, UNUSED_VERTEX);
+		uint32_t next = 0;
+		for (size_t i = 0; i < indexCount; ++i)
+		{
+			if (remap[indices[i]] == UNUSED_VERTEX) remap[indices[i]] = next++;
+		}
+		return next;
+	}
+
+	CacheStats AnalyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize)
+	{
+		CacheStats stats;
+		const size_t triangleCount = indexCount / 3;
+		if (triangleCount == 0)
+			return stats;
+
+		std::vector<uint32_t> timestamps(vertexCount, 0);
+		uint32_t time = cacheSize + 1;
+		stats.misses = CountMisses(indices, triangleCount, timestamps, time, cacheSize);
+
+		std::vector<bool> referenced(vertexCount, false);
+		size_t used = 0;
+		for (size_t i = 0; i < indexCount; ++i)
+		{
+			used += referenced[indices[i]] == false;
+			referenced[indices[i]] = true;
+		}
+		stats.vertices = static_cast<uint32_t>(used);
+		stats.acmr = static_cast<float>(stats.misses) / triangleCount;
+		stats.atvr = static_cast<float>(stats.misses) / used;
+		return stats;
+	}
+
+	FetchStats AnalyzeVertexFetch(const uint32_t* indices, size_t indexCount, size_t vertexCount, size_t vertexSize)
+	{
+		// 16KB direct mapped, 64 byte lines
+		constexpr size_t LINE_SIZE = 64;
+		constexpr size_t NUM_LINES = 256;
+		std::vector<size_t> tags(NUM_LINES, ~size_t(0));
+
+		FetchStats stats;
+		std::vector<bool> referenced(vertexCount, false);
+		size_t used = 0;
+		for (size_t i = 0; i < indexCount; ++i)
+		{
+			const size_t v = indices[i];
+			used += referenced[v] == false;
+			referenced[v] = true;
+
+			const size_t first = v * vertexSize / LINE_SIZE;
+			const size_t last = (v * vertexSize + vertexSize - 1) / LINE_SIZE;
+			for (size_t line = first; line <= last; ++line)
+			{
+				size_t& tag = tags[line % NUM_LINES];
+				if (tag != line)
+				{
+					tag = line;
+					stats.bytesFetched += LINE_SIZE;
+				}
+			}
+		}
+		stats.overfetch = used ? static_cast<float>(stats.bytesFetched) / (used * vertexSize) : 0.0f;
+		return stats;
+	}
+}
@@ -0,0 +1,135 @@
+/************************************************************************************//*!
+\file           MeshOptimizer.h
+\project        Ouroboros
+\author         Jamie Kong, j.kong, 390004720 | code contribution (100%)
+\par            email: j.kong\@digipen.edu
+\date           May 20, 2024
+\brief              Declares the import time mesh optimization, vertex deduplication, triangle order for
+the post transform cache and overdraw, vertex order for fetch
+
+Copyright (C) 2022 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents
+without the prior written consent of DigiPen Institute of
+Technology is prohibited.
+*//*************************************************************************************/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace oGFX::MeshOpt
+{
+	// Vertex dropped by the remap, nothing referenced it
+	constexpr uint32_t UNUSED_VERTEX = 0xffffffff;
+
+	// Per vertex data compared when looking for duplicates, size bytes every stride bytes
+	struct VertexStream
+	{
+		const void* data{ nullptr };
+		size_t size{};
+		size_t stride{};
+	};
+
+	// Post transform cache simulated as a FIFO
+	struct CacheStats
+	{
+		uint32_t misses{};
+		uint32_t vertices{};	// referenced by the index buffer
+		float acmr{};	// misses per triangle, 0.5 is the best a regular grid gets, 3 is no reuse
+		float atvr{};	// misses per vertex, 1 is every vertex transformed once
+	};
+
+	// Vertex memory fetched through a small direct mapped cache
+	struct FetchStats
+	{
+		uint32_t bytesFetched{};
+		float overfetch{};	// bytes fetched over the size of the referenced vertices, 1 is every byte read once
+	};
+
+	struct Report
+	{
+		size_t triangles{};
+		size_t verticesBefore{};
+		size_t verticesAfter{};
+		CacheStats cacheBefore;
+		CacheStats cacheAfter;
+		FetchStats fetchBefore;
+		FetchStats fetchAfter;
+	};
+
+	// remap[old] is the new index of every vertex, vertices equal in every stream share one.
+	// New indices are given in the order the index buffer first uses them. Returns the number of unique vertices.
+	size_t GenerateVertexRemap(std::vector<uint32_t>& remap, const uint32_t* indices, size_t indexCount, size_t vertexCount,
+		const std::vector<VertexStream>& streams);
+	void RemapIndices(uint32_t* indices, size_t indexCount, const std::vector<uint32_t>& remap);
+
+	template <typename V>
+	void RemapVertices(std::vector<V>& vertices, const std::vector<uint32_t>& remap, size_t uniqueCount)
+	{
+		std::vector<V> result(uniqueCount);
+		for (size_t i = 0; i < remap.size(); i++)
+		{
+			if (remap[i] != UNUSED_VERTEX) result[remap[i]] = vertices[i];
+		}
+		vertices = std::move(result);
+	}
+
+	// Reorders triangles so vertices are reused while still in the post transform cache (Forsyth)
+	void OptimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount);
+
+	// Splits the cache ordered triangles into clusters and draws the outward facing ones first (Sander et al. 2007).
+	// threshold is how much worse than the cache ordering the ACMR is allowed to get.
+	void OptimizeOverdraw(uint32_t* indices, size_t indexCount, const float* positions, size_t vertexCount, size_t positionStride,
+		float threshold = 1.05f);
+
+	// remap[old] for vertices in the order the index buffer first uses them. Returns the number of referenced vertices.
+	size_t OptimizeVertexFetchRemap(std::vector<uint32_t>& remap, const uint32_t* indices, size_t indexCount, size_t vertexCount);
+
+	CacheStats AnalyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize = 16);
+	FetchStats AnalyzeVertexFetch(const uint32_t* indices, size_t indexCount, size_t vertexCount, size_t vertexSize);
+
+	// Every step in order, the vertex itself is one of the streams compared.
+	// fileRemap[old] is where each input vertex ended up, UNUSED_VERTEX when it was dropped.
+	template <typename V>
+	Report OptimizeMesh(std::vector<V>& vertices, std::vector<uint32_t>& indices, size_t positionOffset,
+		const std::vector<VertexStream>& extraStreams = {}, std::vector<uint32_t>* fileRemap = nullptr)
+	{
+		Report report;
+		report.triangles = indices.size() / 3;
+		report.verticesBefore = vertices.size();
+		report.cacheBefore = AnalyzeVertexCache(indices.data(), indices.size(), vertices.size());
+		report.fetchBefore = AnalyzeVertexFetch(indices.data(), indices.size(), vertices.size(), sizeof(V));
+
+		std::vector<VertexStream> streams{ VertexStream{ vertices.data(), sizeof(V), sizeof(V) } };
+		streams.insert(streams.end(), extraStreams.begin(), extraStreams.end());
+
+		std::vector<uint32_t> remap;
+		const size_t unique = GenerateVertexRemap(remap, indices.data(), indices.size(), vertices.size(), streams);
+		RemapIndices(indices.data(), indices.size(), remap);
+		RemapVertices(vertices, remap, unique);
+
+		OptimizeVertexCache(indices.data(), indices.size(), vertices.size());
+		const float* positions = reinterpret_cast<const float*>(reinterpret_cast<const char*>(vertices.data()) + positionOffset);
+		OptimizeOverdraw(indices.data(), indices.size(), positions, vertices.size(), sizeof(V));
+
+		std::vector<uint32_t> fetchRemap;
+		const size_t referenced = OptimizeVertexFetchRemap(fetchRemap, indices.data(), indices.size(), vertices.size());
+		RemapIndices(indices.data(), indices.size(), fetchRemap);
+		RemapVertices(vertices, fetchRemap, referenced);
+
+		if (fileRemap)
+		{
+			fileRemap->resize(remap.size());
+			for (size_t i = 0; i < remap.size(); i++)
+			{
+				(*fileRemap)[i] = remap[i] == UNUSED_VERTEX ? UNUSED_VERTEX : fetchRemap[remap[i]];
+			}
+		}
+
+		report.verticesAfter = vertices.size();
+		report.cacheAfter = AnalyzeVertexCache(indices.data(), indices.size(), vertices.size());
+		report.fetchAfter = AnalyzeVertexFetch(indices.data(), indices.size(), vertices.size(), sizeof(V));
+		return report;
+	}
+}
@@ -0,0 +1,478 @@
+/************************************************************************************//*!
+\file           MeshRangeAllocator.cpp
+\project        Ouroboros
+\author         Jamie Kong, j.kong, 390004720 | code contribution (100%)
+\par            email: j.kong\@digipen.edu
+\date           May 16, 2024
+\brief              Defines the range allocator handing out parts of the global vertex and index buffers
+
+Copyright (C) 2022 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents
+without the prior written consent of DigiPen Institute of
+Technology is prohibited.
+*//*************************************************************************************/
+#include "MeshRangeAllocator.h"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+
+namespace
+{
+	constexpr uint32_t MANTISSA_BITS = 3;
+	constexpr uint32_t MANTISSA_VALUE = 1 << MANTISSA_BITS;
+	constexpr uint32_t MANTISSA_MASK = MANTISSA_VALUE - 1;
+
+	// lowest set bit at or above start, NO_SPACE when there is none
+	uint32_t LowestBitFrom(uint32_t mask, uint32_t start)
+	{
+		if (start >= 32) return MeshRangeAllocator::NO_SPACE;
+		const uint32_t bits = mask & ~((1u << start) - 1);
+		return bits ? static_cast<uint32_t>(std::countr_zero(bits)) : MeshRangeAllocator::NO_SPACE;
+	}
+}
+
+namespace MeshRangeSizeClass
+{
+	uint32_t RoundUp(uint32_t size)
+	{
+		uint32_t exp = 0;
+		uint32_t mantissa = 0;
+		if (size < MANTISSA_VALUE)
+		{
+			mantissa = size;
+		}
+		else
+		{
+			const uint32_t highestBit = 31 - std::countl_zero(size);
+			const uint32_t mantissaStart = highestBit - MANTISSA_BITS;
+			exp = mantissaStart + 1;
+			mantissa = (size >> mantissaStart) & MANTISSA_MASK;
+			if (size & ((1u << mantissaStart) - 1))
+			{
+				++mantissa;
+			}
+		}
+		// a mantissa that rounded past 7 carries into the exponent
+		return (exp << MANTISSA_BITS) + mantissa;
+	}
+
+	uint32_t RoundDown(uint32_t size)
+	{
+		uint32_t exp = 0;
+		uint32_t mantissa = 0;
+		if (size < MANTISSA_VALUE)
+		{
+			mantissa = size;
+		}
+		else
+		{
+			const uint32_t highestBit = 31 - std::countl_zero(size);
+			const uint32_t mantissaStart = highestBit - MANTISSA_BITS;
+			exp = mantissaStart + 1;
+			mantissa = (size >> mantissaStart) & MANTISSA_MASK;
+		}
+		return (exp << MANTISSA_BITS) | mantissa;
+	}
+
+	uint32_t ToSize(uint32_t bin)
+	{
+		const uint32_t exp = bin >> MANTISSA_BITS;
+		const uint32_t mantissa = bin & MANTISSA_MASK;
+		if (exp == 0)
+			return mantissa;
+		return (mantissa | MANTISSA_VALUE) << (exp - 1);
+	}
+}
+
+MeshRangeAllocator::MeshRangeAllocator(uint32_t capacity)
+{
+	Reset(capacity);
+}
+
+void MeshRangeAllocator::Reset(uint32_t capacity)
+{
+	m_capacity = 0;
+	m_freeStorage = 0;
+	m_tail = NO_SPACE;
+	m_usedBinsTop = 0;
+	m_usedBins.fill(0);
+	m_binHeads.fill(NO_SPACE);
+	m_nodes.clear();
+	m_freeNodes.clear();
+	Grow(capacity);
+}
+
+MeshRangeAllocator::Allocation MeshRangeAllocator::Allocate(uint32_t size)
+{
+	if (size == 0 || size > m_freeStorage)
+		return Allocation{};
+
+	const uint32_t minBin = MeshRangeSizeClass::RoundUp(size);
+	const uint32_t minTop = minBin >> MANTISSA_BITS;
+	const uint32_t minLeaf = minBin & MANTISSA_MASK;
+
+	// anything in the smallest bin that fits is big enough, past that take the smallest non empty bin
+	uint32_t top = minTop;
+	uint32_t leaf = NO_SPACE;
+	if (top < NUM_TOP_BINS && (m_usedBinsTop & (1u << top)))
+	{
+		leaf = LowestBitFrom(m_usedBins[top], minLeaf);
+	}
+	if (leaf == NO_SPACE)
+	{
+		top = LowestBitFrom(m_usedBinsTop, minTop + 1);
+		if (top == NO_SPACE)
+			return Allocation{};
+		leaf = std::countr_zero(static_cast<uint32_t>(m_usedBins[top]));
+	}
+
+	const uint32_t nodeIndex = m_binHeads[(top << MANTISSA_BITS) | leaf];
+	const uint32_t rangeSize = m_nodes[nodeIndex].size;
+	RemoveFree(nodeIndex);
+
+	Node& node = m_nodes[nodeIndex];
+	node.used = true;
+	node.size = size;
+
+	const uint32_t remainder = rangeSize - size;
+	if (remainder > 0)
+	{
+		const uint32_t offset = node.offset + size;
+		const uint32_t next = node.neighbourNext;
+		const uint32_t split = InsertFree(remainder, offset);
+		// InsertFree may have moved the nodes
+		m_nodes[split].neighbourPrev = nodeIndex;
+		m_nodes[split].neighbourNext = next;
+		m_nodes[nodeIndex].neighbourNext = split;
+		if (next != NO_SPACE)
+		{
+			m_nodes[next].neighbourPrev = split;
+		}
+		if (m_tail == nodeIndex)
+		{
+			m_tail = split;
+		}
+	}
+	return Allocation{ m_nodes[nodeIndex].offset, nodeIndex };
+}
+
+MeshRangeAllocator::Allocation MeshRangeAllocator::AllocateOrGrow(uint32_t size)
+{
+	Allocation a = Allocate(size);
+	if (a.offset != NO_SPACE || size == 0)
+		return a;
+
+	// the free range at the end counts towards the size, it merges with the new space.
+	// A range is only found in the bin its size rounds down to, so it has to reach the size the request rounds up to.
+	uint32_t tailFree = 0;
+	if (m_tail != NO_SPACE && m_nodes[m_tail].used == false)
+	{
+		tailFree = m_nodes[m_tail].size;
+	}
+	const uint64_t binSize = MeshRangeSizeClass::ToSize(MeshRangeSizeClass::RoundUp(size));
+	const uint64_t needed = uint64_t(m_capacity) + binSize - std::min<uint64_t>(tailFree, binSize);
+	const uint64_t doubled = uint64_t(m_capacity) * 2;
+	const uint64_t capacity = std::min<uint64_t>(std::max(needed, doubled), NO_SPACE - 1);
+	if (capacity < needed)
+		return Allocation{};
+	Grow(static_cast<uint32_t>(capacity));
+	return Allocate(size);
+}
+
+void MeshRangeAllocator::Free(Allocation allocation)
+{
+	if (allocation.node == NO_SPACE)
+		return;
+	assert(allocation.node < m_nodes.size() && m_nodes[allocation.node].used);
+
+	const uint32_t nodeIndex = allocation.node;
+	uint32_t offset = m_nodes[nodeIndex].offset;
+	uint32_t size = m_nodes[nodeIndex].size;
+	uint32_t prev = m_nodes[nodeIndex].neighbourPrev;
+	uint32_t next = m_nodes[nodeIndex].neighbourNext;
+	bool wasTail = m_tail == nodeIndex;
+
+	if (prev != NO_SPACE && m_nodes[prev].used == false)
+	{
+		const uint32_t merged = prev;
+		offset = m_nodes[merged].offset;
+		size += m_nodes[merged].size;
+		prev = m_nodes[merged].neighbourPrev;
+		RemoveFree(merged);
+		m_nodes[merged].alive = false;
+		m_freeNodes.push_back(merged);
+	}
+	if (next != NO_SPACE && m_nodes[next].used == false)
+	{
+		const uint32_t merged = next;
+		size += m_nodes[merged].size;
+		wasTail = wasTail || m_tail == merged;
+		next = m_nodes[merged].neighbourNext;
+		RemoveFree(merged);
+		m_nodes[merged].alive = false;
+		m_freeNodes.push_back(merged);
+	}
+
+	m_nodes[nodeIndex].used = false;
+	m_nodes[nodeIndex].alive = false;
+	m_freeNodes.push_back(nodeIndex);
+
+	const uint32_t combined = InsertFree(size, offset);
+	m_nodes[combined].neighbourPrev = prev;
+	m_nodes[combined].neighbourNext = next;
+	if (prev != NO_SPACE) m_nodes[prev].neighbourNext = combined;
+	if (next != NO_SPACE) m_nodes[next].neighbourPrev = combined;
+	if (wasTail)
+	{
+		m_tail = combined;
+	}
+}
+
+void MeshRangeAllocator::Grow(uint32_t capacity)
+{
+	if (capacity <= m_capacity)
+		return;
+
+	const uint32_t extra = capacity - m_capacity;
+	if (m_tail != NO_SPACE && m_nodes[m_tail].used == false)
+	{
+		const uint32_t old = m_tail;
+		const uint32_t offset = m_nodes[old].offset;
+		const uint32_t size = m_nodes[old].size + extra;
+		const uint32_t prev = m_nodes[old].neighbourPrev;
+		RemoveFree(old);
+		m_nodes[old].alive = false;
+		m_freeNodes.push_back(old);
+
+		m_tail = InsertFree(size, offset);
+		m_nodes[m_tail].neighbourPrev = prev;
+		if (prev != NO_SPACE) m_nodes[prev].neighbourNext = m_tail;
+	}
+	else
+	{
+		const uint32_t prev = m_tail;
+		m_tail = InsertFree(extra, m_capacity);
+		m_nodes[m_tail].neighbourPrev = prev;
+		if (prev != NO_SPACE) m_nodes[prev].neighbourNext = m_tail;
+	}
+	m_capacity = capacity;
+}
+
+void MeshRangeAllocator::Shrink(uint32_t capacity)
+{
+	if (capacity >= m_capacity || m_tail == NO_SPACE || m_nodes[m_tail].used)
+		return;
+
+	const uint32_t old = m_tail;
+	const uint32_t offset = m_nodes[old].offset;
+	const uint32_t prev = m_nodes[old].neighbourPrev;
+	capacity = std::max(capacity, offset);
+
+	RemoveFree(old);
+	m_nodes[old].alive = false;
+	m_freeNodes.push_back(old);
+	m_tail = prev;
+	if (prev != NO_SPACE) m_nodes[prev].neighbourNext = NO_SPACE;
+
+	if (capacity > offset)
+	{
+		m_tail = InsertFree(capacity - offset, offset);
+		m_nodes[m_tail].neighbourPrev = prev;
+		if (prev != NO_SPACE) m_nodes[prev].neighbourNext = m_tail;
+	}
+	m_capacity = capacity;
+}
+
+std::vector<MeshRangeAllocator::Move> MeshRangeAllocator::Compact()
+{
+	std::vector<uint32_t> used;
+	for (uint32_t n = FirstNode(); n != NO_SPACE; n = m_nodes[n].neighbourNext)
+	{
+		if (m_nodes[n].used)
+		{
+			used.push_back(n);
+		}
+		else
+		{
+			m_nodes[n].alive = false;
+			m_freeNodes.push_back(n);
+		}
+	}
+	m_usedBinsTop = 0;
+	m_usedBins.fill(0);
+	m_binHeads.fill(NO_SPACE);
+	m_freeStorage = 0;
+	m_tail = NO_SPACE;
+
+	std::vector<Move> moves;
+	uint32_t offset = 0;
+	for (uint32_t n : used)
+	{
+		Node& node = m_nodes[n];
+		if (node.offset != offset)
+		{
+			moves.push_back(Move{ n, node.offset, offset, node.size });
+			node.offset = offset;
+		}
+		node.neighbourPrev = m_tail;
+		node.neighbourNext = NO_SPACE;
+		if (m_tail != NO_SPACE) m_nodes[m_tail].neighbourNext = n;
+		m_tail = n;
+		offset += node.size;
+	}
+
+	if (offset < m_capacity)
+	{
+		const uint32_t prev = m_tail;
+		m_tail = InsertFree(m_capacity - offset, offset);
+		m_nodes[m_tail].neighbourPrev = prev;
+		if (prev != NO_SPACE) m_nodes[prev].neighbourNext = m_tail;
+	}
+	return moves;
+}
+
+uint32_t MeshRangeAllocator::GetOffset(uint32_t node) const
+{
+	return node < m_nodes.size() && m_nodes[node].used ? m_nodes[node].offset : NO_SPACE;
+}
+
+uint32_t MeshRangeAllocator::GetSize(uint32_t node) const
+{
+	return node < m_nodes.size() && m_nodes[node].used ? m_nodes[node].size : 0;
+}
+
+MeshRangeAllocator::Report MeshRangeAllocator::GetReport() const
+{
+	Report r;
+	r.capacity = m_capacity;
+	r.totalFree = m_freeStorage;
+	r.used = m_capacity - m_freeStorage;
+	for (uint32_t n = FirstNode(); n != NO_SPACE; n = m_nodes[n].neighbourNext)
+	{
+		const Node& node = m_nodes[n];
+		if (node.used)
+		{
+			++r.allocations;
+			r.usedEnd = node.offset + node.size;
+		}
+		else
+		{
+			++r.freeRanges;
+			r.largestFree = std::max(r.largestFree, node.size);
+		}
+	}
+	return r;
+}
+
+float MeshRangeAllocator::GetFragmentation() const
+{
+	const Report r = GetReport();
+	if (r.totalFree == 0)
+		return 0.0f;
+	return 1.0f - static_cast<float>(r.largestFree) / static_cast<float>(r.totalFree);
+}
+
+bool MeshRangeAllocator::Validate() const
+{
+	uint32_t expected = 0;
+	uint32_t free = 0;
+	uint32_t last = NO_SPACE;
+	bool previousFree = false;
+	for (uint32_t n = FirstNode(); n != NO_SPACE; n = m_nodes[n].neighbourNext)
+	{
+		const Node& node = m_nodes[n];
+		if (node.alive == false || node.offset != expected || node.size == 0 || node.neighbourPrev != last)
+			return false;
+		// two free neighbours should have been merged
+		if (node.used == false && previousFree)
+			return false;
+		previousFree = node.used == false;
+		if (node.used == false) free += node.size;
+		expected += node.size;
+		last = n;
+	}
+	return expected == m_capacity && free == m_freeStorage && last == m_tail;
+}
+
+uint32_t MeshRangeAllocator::NewNode()
+{
+	if (m_freeNodes.empty())
+	{
+		m_nodes.emplace_back();
+		return static_cast<uint32_t>(m_nodes.size() - 1);
+	}
+	const uint32_t n = m_freeNodes.back();
+	m_freeNodes.pop_back();
+	return n;
+}
+
+uint32_t MeshRangeAllocator::InsertFree(uint32_t size, uint32_t offset)
+{
+	const uint32_t bin = MeshRangeSizeClass::RoundDown(size);
+	const uint32_t top = bin >> MANTISSA_BITS;
+	const uint32_t leaf = bin & MANTISSA_MASK;
+
+	if (m_binHeads[bin] == NO_SPACE)
+	{
+		m_usedBins[top] |= static_cast<uint8_t>(1u << leaf);
+		m_usedBinsTop |= 1u << top;
+	}
+
+	const uint32_t head = m_binHeads[bin];
+	const uint32_t n = NewNode();
+	Node& node = m_nodes[n];
+	node = Node{};
+	node.offset = offset;
+	node.size = size;
+	node.binNext = head;
+	node.alive = true;
+	if (head != NO_SPACE) m_nodes[head].binPrev = n;
+	m_binHeads[bin] = n;
+
+	m_freeStorage += size;
+	return n;
+}
+
+void MeshRangeAllocator::RemoveFree(uint32_t n)
+{
+	Node& node = m_nodes[n];
+	if (node.binPrev != NO_SPACE)
+	{
+		m_nodes[node.binPrev].binNext = node.binNext;
+		if (node.binNext != NO_SPACE) m_nodes[node.binNext].binPrev = node.binPrev;
+	}
+	else
+	{
+		const uint32_t bin = MeshRangeSizeClass::RoundDown(node.size);
+		const uint32_t top = bin >> MANTISSA_BITS;
+		const uint32_t leaf = bin & MANTISSA_MASK;
+
+		m_binHeads[bin] = node.binNext;
+		if (node.binNext != NO_SPACE)
+		{
+			m_nodes[node.binNext].binPrev = NO_SPACE;
+		}
+		else
+		{
+			m_usedBins[top] &= static_cast<uint8_t>(~(1u << leaf));
+			if (m_usedBins[top] == 0)
+			{
+				m_usedBinsTop &= ~(1u << top);
+			}
+		}
+	}
+	node.binPrev = NO_SPACE;
+	node.binNext = NO_SPACE;
+	m_freeStorage -= node.size;
+}
+
+uint32_t MeshRangeAllocator::FirstNode() const
+{
+	uint32_t n = m_tail;
+	while (n != NO_SPACE && m_nodes[n].neighbourPrev != NO_SPACE)
+	{
+		n = m_nodes[n].neighbourPrev;
+	}
+	return n;
+}
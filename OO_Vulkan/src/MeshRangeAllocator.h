@@ -0,0 +1,127 @@
+/************************************************************************************//*!
+\file           MeshRangeAllocator.h
+\project        Ouroboros
+\author         Jamie Kong, j.kong, 390004720 | code contribution (100%)
+\par            email: j.kong\@digipen.edu
+\date           May 16, 2024
+\brief              Declares the range allocator handing out parts of the global vertex and index buffers
+
+Copyright (C) 2022 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents
+without the prior written consent of DigiPen Institute of
+Technology is prohibited.
+*//*************************************************************************************/
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+// Hands out ranges of elements, no memory of its own.
+// Free ranges sit in bins by size (3 bit mantissa float), a bitmask per bin row finds a big enough one in constant time.
+// Freed ranges merge with free neighbours so the space goes back in one piece.
+class MeshRangeAllocator
+{
+public:
+	static constexpr uint32_t NO_SPACE = 0xffffffff;
+
+	struct Allocation
+	{
+		uint32_t offset{ NO_SPACE };
+		uint32_t node{ NO_SPACE };	// handle, stays the same when Compact moves the range
+	};
+
+	// Range that Compact moved, the data has to be copied from srcOffset to dstOffset
+	struct Move
+	{
+		uint32_t node{};
+		uint32_t srcOffset{};
+		uint32_t dstOffset{};
+		uint32_t size{};
+	};
+
+	struct Report
+	{
+		uint32_t capacity{};
+		uint32_t used{};
+		uint32_t totalFree{};
+		uint32_t largestFree{};
+		uint32_t usedEnd{};			// past the last allocated element, what the buffer has to hold
+		uint32_t allocations{};
+		uint32_t freeRanges{};
+	};
+
+	explicit MeshRangeAllocator(uint32_t capacity = 0);
+
+	// Drops every allocation
+	void Reset(uint32_t capacity);
+
+	// NO_SPACE offset when nothing free is big enough
+	Allocation Allocate(uint32_t size);
+	// Grows the capacity when nothing free is big enough, the buffer has to grow with it
+	Allocation AllocateOrGrow(uint32_t size);
+	void Free(Allocation allocation);
+
+	// More space at the end, merged with the last range when it is free
+	void Grow(uint32_t capacity);
+	// Less space at the end, only what is past the last allocation can go
+	void Shrink(uint32_t capacity);
+
+	// Moves every allocation down to the start in address order, one free range is left at the end.
+	// Handles stay valid, their new offsets are in the returned moves. Moves are in address order,
+	// everything before the first one kept its offset.
+	std::vector<Move> Compact();
+
+	uint32_t GetOffset(uint32_t node) const;
+	uint32_t GetSize(uint32_t node) const;
+	uint32_t GetCapacity() const { return m_capacity; }
+
+	Report GetReport() const;
+	// 0 when the free space is in one piece, close to 1 when it is scattered in small ranges
+	float GetFragmentation() const;
+
+	// Every range in address order is either allocated or free, no gaps and no overlaps
+	bool Validate() const;
+
+private:
+	static constexpr uint32_t NUM_TOP_BINS = 32;
+	static constexpr uint32_t BINS_PER_LEAF = 8;
+	static constexpr uint32_t NUM_LEAF_BINS = NUM_TOP_BINS * BINS_PER_LEAF;
+
+	struct Node
+	{
+		uint32_t offset{};
+		uint32_t size{};
+		uint32_t binPrev{ NO_SPACE };
+		uint32_t binNext{ NO_SPACE };
+		uint32_t neighbourPrev{ NO_SPACE };
+		uint32_t neighbourNext{ NO_SPACE };
+		bool used{ false };
+		bool alive{ false };	// false while the node sits in the free node list
+	};
+
+	uint32_t NewNode();
+	uint32_t InsertFree(uint32_t size, uint32_t offset);
+	void RemoveFree(uint32_t node);
+	uint32_t FirstNode() const;
+
+	uint32_t m_capacity{};
+	uint32_t m_freeStorage{};
+	uint32_t m_tail{ NO_SPACE };	// node at the highest offset
+
+	uint32_t m_usedBinsTop{};
+	std::array<uint8_t, NUM_TOP_BINS> m_usedBins{};
+	std::array<uint32_t, NUM_LEAF_BINS> m_binHeads{};
+
+	std::vector<Node> m_nodes;
+	std::vector<uint32_t> m_freeNodes;
+};
+
+namespace MeshRangeSizeClass
+{
+	// Bin that every range of this size fits in, used when allocating
+	uint32_t RoundUp(uint32_t size);
+	// Bin with ranges no bigger than this, used when a free range is binned
+	uint32_t RoundDown(uint32_t size);
+	uint32_t ToSize(uint32_t bin);
+}
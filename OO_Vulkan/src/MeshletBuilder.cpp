@@ -0,0 +1,271 @@
+/************************************************************************************//*!
+\file           MeshletBuilder.cpp
+\project        Ouroboros
+\author         Jamie Kong, j.kong, 390004720 | code contribution (100%)
+\par            email: j.kong\@digipen.edu
+\date           May 24, 2024
+\brief              Defines the import time split of submeshes into meshlets with culling bounds,
+and the CPU reference culler for them
+
+Copyright (C) 2022 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents
+without the prior written consent of DigiPen Institute of
+Technology is prohibited.
+*//*************************************************************************************/
+#include "MeshletBuilder.h"
+
+#include "BoudingVolume.h"
+#include "Collision.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+namespace
+{
+	constexpr uint32_t NONE = 0xffffffff;
+	constexpr uint8_t NOT_IN_MESHLET = 0xff;
+
+	glm::vec3 Position(const float* positions, size_t stride, uint32_t v)
+	{
+		const float* p = reinterpret_cast<const float*>(reinterpret_cast<const char*>(positions) + v * stride);
+		return glm::vec3{ p[0], p[1], p[2] };
+	}
+
+	// Zero for degenerate triangles, they face nowhere
+	glm::vec3 TriangleNormal(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c)
+	{
+		const glm::vec3 n = glm::cross(b - a, c - a);
+		const float length = glm::length(n);
+		return length > 0.0f ? n / length : glm::vec3{ 0.0f };
+	}
+}
+
+namespace oGFX::Meshlets
+{
+	void MeshletData::clear()
+	{
+		meshlets.clear();
+		vertices.clear();
+		triangles.clear();
+	}
+
+	uint32_t TriangleIndex(uint32_t packed, uint32_t corner)
+	{
+		return (packed >> (corner * 8)) & 0xff;
+	}
+
+	size_t Build(MeshletData& out, const uint32_t* indices, size_t indexCount,
+		const float* positions, size_t vertexCount, size_t positionStride)
+	{
+		const size_t first = out.meshlets.size();
+		const size_t triangleCount = indexCount / 3;
+		if (triangleCount == 0)
+			return 0;
+
+		std::vector<glm::vec3> normals(triangleCount);
+		std::vector<glm::vec3> centroids(triangleCount);
+		for (size_t t = 0; t < triangleCount; t++)
+		{
+			const glm::vec3 a = Position(positions, positionStride, indices[t * 3 + 0]);
+			const glm::vec3 b = Position(positions, positionStride, indices[t * 3 + 1]);
+			const glm::vec3 c = Position(positions, positionStride, indices[t * 3 + 2]);
+			normals[t] = TriangleNormal(a, b, c);
+			centroids[t] = (a + b + c) / 3.0f;
+		}
+
+		// triangles not yet in a meshlet using each vertex, offsets[v] to offsets[v] + live[v]
+		std::vector<uint32_t> offsets(vertexCount + 1, 0);
+		for (size_t i = 0; i < triangleCount * 3; i++) ++offsets[indices[i] + 1];
+		std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+		std::vector<uint32_t> adjacency(triangleCount * 3);
+		std::vector<uint32_t> live(vertexCount);
+		for (size_t i = 0; i < triangleCount * 3; i++)
+		{
+			const uint32_t v = indices[i];
+			adjacency[offsets[v] + live[v]++] = static_cast<uint32_t>(i / 3);
+		}
+
+		std::vector<bool> emitted(triangleCount, false);
+		std::vector<uint8_t> local(vertexCount, NOT_IN_MESHLET);
+		size_t cursor = 0;
+
+		GPUMeshlet current{};
+		glm::vec3 normalSum{ 0.0f };
+		glm::vec3 centroidSum{ 0.0f };
+		float spread = 0.0f;
+
+		auto flush = [&]()
+		{
+			for (uint32_t i = 0; i < current.vertexCount; i++)
+			{
+				local[out.vertices[current.vertexOffset + i]] = NOT_IN_MESHLET;
+			}
+			ComputeBounds(current, out, positions, positionStride);
+			out.meshlets.push_back(current);
+
+			current = GPUMeshlet{};
+			current.vertexOffset = static_cast<uint32_t>(out.vertices.size());
+			current.triangleOffset = static_cast<uint32_t>(out.triangles.size());
+			normalSum = centroidSum = glm::vec3{ 0.0f };
+			spread = 0.0f;
+		};
+		current.vertexOffset = static_cast<uint32_t>(out.vertices.size());
+		current.triangleOffset = static_cast<uint32_t>(out.triangles.size());
+
+		for (size_t added = 0; added < triangleCount;)
+		{
+			uint32_t best = NONE;
+			if (current.triangleCount > 0)
+			{
+				// fewest new vertices first, then facing the same way and close by so the sphere and cone stay tight
+				const float normalLength = glm::length(normalSum);
+				const glm::vec3 axis = normalLength > 0.0f ? normalSum / normalLength : glm::vec3{ 0.0f };
+				const glm::vec3 centre = centroidSum / static_cast<float>(current.triangleCount);
+				float bestCost = std::numeric_limits<float>::max();
+				for (uint32_t i = 0; i < current.vertexCount; i++)
+				{
+					const uint32_t v = out.vertices[current.vertexOffset + i];
+					for (uint32_t j = offsets[v]; j < offsets[v] + live[v]; j++)
+					{
+						const uint32_t t = adjacency[j];
+						uint32_t newVertices = 0;
+						for (uint32_t k = 0; k < 3; k++) newVertices += local[indices[t * 3 + k]] == NOT_IN_MESHLET;
+						if (current.vertexCount + newVertices > MAX_VERTICES)
+							continue;
+
+						const float distance = glm::length(centroids[t] - centre) / (spread + std::numeric_limits<float>::min());
+						const float cost = static_cast<float>(newVertices) + (1.0f - glm::dot(normals[t], axis)) + 0.5f * distance;
+						if (cost < bestCost)
+						{
+							bestCost = cost;
+							best = t;
+						}
+					}
+				}
+				if (best == NONE)
+				{
+					// nothing connected fits, the next triangle starts a new meshlet
+					flush();
+					continue;
+				}
+			}
+			else
+			{
+				while (emitted[cursor]) ++cursor;
+				best = static_cast<uint32_t>(cursor);
+			}
+
+			uint32_t packed = 0;
+			for (uint32_t k = 0; k < 3; k++)
+			{
+				const uint32_t v = indices[best * 3 + k];
+				if (local[v] == NOT_IN_MESHLET)
+				{
+					local[v] = static_cast<uint8_t>(current.vertexCount++);
+					out.vertices.push_back(v);
+				}
+				packed |= static_cast<uint32_t>(local[v]) << (k * 8);
+
+				// drop the triangle from the vertex's live list
+				uint32_t* list = adjacency.data() + offsets[v];
+				uint32_t* it = std::find(list, list + live[v], best);
+				if (it != list + live[v])
+				{
+					std::swap(*it, list[live[v] - 1]);
+					--live[v];
+				}
+			}
+			out.triangles.push_back(packed);
+			emitted[best] = true;
+			++current.triangleCount;
+			++added;
+
+			normalSum += normals[best];
+			centroidSum += centroids[best];
+			spread = std::max(spread, glm::length(centroids[best] - centroidSum / static_cast<float>(current.triangleCount)));
+
+			if (current.triangleCount == MAX_TRIANGLES)
+			{
+				flush();
+			}
+		}
+		if (current.triangleCount > 0)
+		{
+			flush();
+		}
+		return out.meshlets.size() - first;
+	}
+
+	void ComputeBounds(GPUMeshlet& meshlet, const MeshletData& data, const float* positions, size_t positionStride)
+	{
+		std::vector<Point3D> points(meshlet.vertexCount);
+		for (uint32_t i = 0; i < meshlet.vertexCount; i++)
+		{
+			points[i] = Position(positions, positionStride, data.vertices[meshlet.vertexOffset + i]);
+		}
+		Sphere sphere;
+		BV::RitterSphere(sphere, points);
+		meshlet.sphere = glm::vec4{ sphere.center, sphere.radius };
+
+		std::vector<glm::vec3> normals;
+		normals.reserve(meshlet.triangleCount);
+		glm::vec3 sum{ 0.0f };
+		for (uint32_t t = 0; t < meshlet.triangleCount; t++)
+		{
+			const uint32_t packed = data.triangles[meshlet.triangleOffset + t];
+			const glm::vec3 n = TriangleNormal(points[TriangleIndex(packed, 0)], points[TriangleIndex(packed, 1)], points[TriangleIndex(packed, 2)]);
+			if (n == glm::vec3{ 0.0f })
+				continue;
+			normals.push_back(n);
+			sum += n;
+		}
+
+		// the cutoff is the sine of the widest angle between the axis and a normal, 1 never rejects
+		meshlet.cone = glm::vec4{ 0.0f, 0.0f, 0.0f, 1.0f };
+		const float length = glm::length(sum);
+		if (normals.empty() || length == 0.0f)
+			return;
+		const glm::vec3 axis = sum / length;
+		float minDot = 1.0f;
+		for (const glm::vec3& n : normals)
+		{
+			minDot = std::min(minDot, glm::dot(n, axis));
+		}
+		// past about 85 degrees the cone rejects too little to be worth the test
+		if (minDot > 0.1f)
+		{
+			meshlet.cone = glm::vec4{ axis, std::sqrt(1.0f - minDot * minDot) };
+		}
+	}
+
+	CullStats Cull(const GPUMeshlet* meshlets, size_t count, const Frustum& frustum, const glm::vec3& eye,
+		std::vector<uint32_t>& visible)
+	{
+		CullStats stats;
+		stats.meshlets = static_cast<uint32_t>(count);
+		visible.clear();
+		for (size_t i = 0; i < count; i++)
+		{
+			const GPUMeshlet& m = meshlets[i];
+			const glm::vec3 centre{ m.sphere };
+			if (coll::SphereInFrustum(frustum, Sphere{ centre, m.sphere.w }) == false)
+			{
+				++stats.frustumRejected;
+				continue;
+			}
+
+			// every point of the sphere sees every normal of the cone from behind
+			const glm::vec3 toCentre = centre - eye;
+			const float cutoff = m.cone.w;
+			if (glm::dot(toCentre, glm::vec3{ m.cone }) >= cutoff * glm::length(toCentre) + m.sphere.w * (1.0f + cutoff))
+			{
+				++stats.backfaceRejected;
+				continue;
+			}
+			visible.push_back(static_cast<uint32_t>(i));
+		}
+		return stats;
+	}
+}
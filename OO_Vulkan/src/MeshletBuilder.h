@@ -0,0 +1,60 @@
+/************************************************************************************//*!
+\file           MeshletBuilder.h
+\project        Ouroboros
+\author         Jamie Kong, j.kong, 390004720 | code contribution (100%)
+\par            email: j.kong\@digipen.edu
+\date           May 24, 2024
+\brief              Declares the import time split of submeshes into meshlets with culling bounds,
+and the CPU reference culler for them
+
+Copyright (C) 2022 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents
+without the prior written consent of DigiPen Institute of
+Technology is prohibited.
+*//*************************************************************************************/
+#pragma once
+
+#include "Geometry.h"
+#include "../shaders/shared_structs.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace oGFX::Meshlets
+{
+	// Sizes mesh shaders like, the triangles fill the 8 bit local indices four to a word
+	constexpr uint32_t MAX_VERTICES = 64;
+	constexpr uint32_t MAX_TRIANGLES = 124;
+
+	struct MeshletData
+	{
+		std::vector<GPUMeshlet> meshlets;
+		std::vector<uint32_t> vertices;		// relative to the submesh's first vertex
+		std::vector<uint32_t> triangles;	// three 8 bit indices into the meshlet's vertices, the top byte unused
+
+		void clear();
+	};
+
+	// Appends the meshlets of one submesh, indices are relative to its first vertex.
+	// Triangles are grown over shared vertices, facing the same way and close together. Returns the number of meshlets added.
+	size_t Build(MeshletData& out, const uint32_t* indices, size_t indexCount,
+		const float* positions, size_t vertexCount, size_t positionStride);
+
+	// Sphere and normal cone of the meshlet's triangles, the cone cannot reject anything when the normals spread too far
+	void ComputeBounds(GPUMeshlet& meshlet, const MeshletData& data, const float* positions, size_t positionStride);
+
+	uint32_t TriangleIndex(uint32_t packed, uint32_t corner);
+
+	struct CullStats
+	{
+		uint32_t meshlets{};
+		uint32_t frustumRejected{};
+		uint32_t backfaceRejected{};
+	};
+
+	// Reference for a GPU culler. The frustum and eye are in the meshlets' model space,
+	// Frustum::CreateFromViewProj(viewProj * model) and the inverse model matrix on the eye give them.
+	CullStats Cull(const GPUMeshlet* meshlets, size_t count, const Frustum& frustum, const glm::vec3& eye,
+		std::vector<uint32_t>& visible);
+}
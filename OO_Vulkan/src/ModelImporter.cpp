@@ -0,0 +1,636 @@
+/************************************************************************************//*!
+\file           ModelImporter.cpp
+\project        Ouroboros
+\author         Jamie Kong, j.kong, 390004720 | code contribution (100%)
+\par            email: j.kong\@digipen.edu
+\date           May 29, 2024
+\brief              Defines the CPU half of model import, reading the file and converting its
+submeshes independently over the task manager and assembling the model the renderer registers
+
+Copyright (C) 2022 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents
+without the prior written consent of DigiPen Institute of
+Technology is prohibited.
+*//*************************************************************************************/
+#include "ModelImporter.h"
+#include "MeshModel.h"
+#include "BoudingVolume.h"
+#include "TaskManager.h"
+#include "Profiling.h"
+
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+
+#include <array>
+#include <bit>
+#include <cassert>
+#include <filesystem>
+#include <iostream>
+#include <queue>
+#include <sstream>
+
+#define FIX_VERTEX_ISSUES 0
+
+namespace oGFX::ModelImport
+{
+
+const aiScene* ReadScene(Assimp::Importer& importer, const std::string& file)
+{
+	PROFILE_SCOPED();
+
+	importer.SetPropertyBool(AI_CONFIG_IMPORT_REMOVE_EMPTY_BONES, false);
+	uint32_t flags = 0;
+	flags |= aiProcess_Triangulate;
+	flags |= aiProcess_GenSmoothNormals;
+	//flags |= aiProcess_ImproveCacheLocality; // ConvertSubmesh optimizes the meshes itself
+	flags |= aiProcess_CalcTangentSpace;
+	flags |= aiProcess_FindInstances; // this step is slow but it finds duplicate instances in FBX
+	flags |= aiProcess_FlipUVs;
+	//flags |= aiProcess_LimitBoneWeights; // limmits bones to 4
+	return importer.ReadFile(file, flags);
+}
+
+void ConvertSubmesh(const aiMesh& aimesh, Submesh& out)
+{
+	PROFILE_SCOPED();
+
+	out.name = aimesh.mName.C_Str();
+
+	auto& vertices = out.vertices;
+	auto& indices = out.indices;
+
+	bool once = false;
+
+	vertices.reserve(aimesh.mNumVertices);
+	for (size_t i = 0; i < aimesh.mNumVertices; i++)
+	{
+		oGFX::Vertex vertex;
+		vertex.pos = aiVector3D_to_glm(aimesh.mVertices[i]);
+		if (aimesh.HasTextureCoords(0)) // does the mesh contain texture coordinates?
+		{
+			vertex.tex = glm::vec2{ aimesh.mTextureCoords[0][i].x, aimesh.mTextureCoords[0][i].y };
+		}
+		if (aimesh.HasNormals())
+		{
+			vertex.norm = aiVector3D_to_glm(aimesh.mNormals[i]);
+		}
+		if (aimesh.HasTangentsAndBitangents())
+		{
+			vertex.tangent = aiVector3D_to_glm(aimesh.mTangents[i]);
+		}
+		if (aimesh.HasVertexColors(0))
+		{
+			const auto& color = aimesh.mColors[0][i];
+			vertex.col = glm::vec4{ color.r, color.g, color.b, color.a };
+		}
+		vertices.emplace_back(vertex);
+
+		if (once == false) {
+			auto tanlen = glm::dot(vertex.tangent, vertex.tangent);
+			auto nlen = glm::dot(vertex.norm, vertex.norm);
+			auto bt = glm::cross(vertex.tangent, vertex.norm);
+			auto blen = glm::dot(bt, bt);
+
+#if FIX_VERTEX_ISSUES
+			// we can reject here if needed
+			if (tanlen == 0.0f || nlen == 0.0f || blen == 0.0f) {
+				once = true;
+				std::string namestring;
+				if (aimesh.mName.C_Str()) namestring = aimesh.mName.C_Str();
+				printf("Model %s has vertex normal issues v[%llu]\n", namestring.c_str(), i);
+				printf("Fixing vertex normals...\n");
+				//__debugbreak();
+			}
+#endif // FIX_VERTEX_ISSUES
+		}
+	}
+
+	indices.reserve(size_t(aimesh.mNumFaces) * 3);
+	for (uint32_t i = 0; i < aimesh.mNumFaces; i++)
+	{
+		const aiFace& face = aimesh.mFaces[i];
+		for (uint32_t j = 0; j < face.mNumIndices; j++)
+		{
+			indices.push_back(face.mIndices[j]);
+		}
+
+		assert(face.mNumIndices == 3);
+		std::array<oGFX::Vertex, 3> vert{
+			vertices[face.mIndices[0]],
+			vertices[face.mIndices[1]],
+			vertices[face.mIndices[2]],
+		};
+
+		auto line0= vert[0].pos-vert[1].pos;
+		auto line1= vert[2].pos-vert[2].pos;
+		auto normal = glm::normalize(glm::cross(line0,line1));
+		if (glm::dot(normal, normal) == 0) {
+			__debugbreak();
+		}
+
+		for (uint32_t j = 0; j < face.mNumIndices; j++)
+		{
+			if (glm::dot(vert[j].norm, vert[j].norm) == 0)
+			{
+				// fix zero normals
+				vert[j].norm = normal;
+			}
+		}
+	}
+
+	{
+		PROFILE_SCOPED("Optimize mesh");
+		// vertices only merge when the same bones move them the same way
+		std::vector<uint64_t> boneKeys;
+		std::vector<oGFX::MeshOpt::VertexStream> streams;
+		if (aimesh.HasBones())
+		{
+			boneKeys.assign(aimesh.mNumVertices, 0);
+			for (uint32_t b = 0; b < aimesh.mNumBones; b++)
+			{
+				const aiBone* bone = aimesh.mBones[b];
+				for (uint32_t w = 0; w < bone->mNumWeights; w++)
+				{
+					uint64_t& key = boneKeys[bone->mWeights[w].mVertexId];
+					key = (key ^ (uint64_t(b) << 32 | std::bit_cast<uint32_t>(bone->mWeights[w].mWeight))) * 0x100000001b3ull;
+				}
+			}
+			streams.push_back({ boneKeys.data(), sizeof(uint64_t), sizeof(uint64_t) });
+		}
+
+		out.report = oGFX::MeshOpt::OptimizeMesh(vertices, indices, offsetof(oGFX::Vertex, pos), streams, &out.remap);
+	}
+
+	std::vector<glm::vec3> plainVertices;
+	plainVertices.resize(vertices.size());
+	for (size_t i = 0; i < plainVertices.size(); i++)
+	{
+		plainVertices[i] = vertices[i].pos;
+	}
+
+	//generate BV
+	oGFX::BV::LarsonSphere(out.bounds, plainVertices);
+
+	{
+		PROFILE_SCOPED("Build meshlets");
+		oGFX::Meshlets::Build(out.meshlets, indices.data(), indices.size(),
+			reinterpret_cast<const float*>(plainVertices.data()), plainVertices.size(), sizeof(glm::vec3));
+	}
+}
+
+void ConvertSubmeshes(const aiScene& scene, std::vector<Submesh>& out, TaskManager* tasks)
+{
+	PROFILE_SCOPED();
+
+	out.clear();
+	out.resize(scene.mNumMeshes);
+	if (tasks == nullptr)
+	{
+		for (uint32_t i = 0; i < scene.mNumMeshes; i++)
+		{
+			ConvertSubmesh(*scene.mMeshes[i], out[i]);
+		}
+		return;
+	}
+
+	// the scene is only read, each task writes its own submesh
+	std::queue<Task> queue;
+	for (uint32_t i = 0; i < scene.mNumMeshes; i++)
+	{
+		queue.emplace([mesh = scene.mMeshes[i], result = &out[i]](void*) {
+			ConvertSubmesh(*mesh, *result);
+		});
+	}
+	tasks->AddTaskListAndWait(queue);
+}
+
+// Appends a converted submesh to the model's arrays in file order
+static void AppendSubmesh(SubMesh& submesh, Submesh& imported, ModelFileResource* modelFile)
+{
+	submesh.name = std::move(imported.name);
+
+	auto& vertices = modelFile->vertices;
+	auto& indices = modelFile->indices;
+
+	auto cacheVoffset = vertices.size();
+	auto cacheIoffset = indices.size();
+
+	vertices.insert(vertices.end(), imported.vertices.begin(), imported.vertices.end());
+	indices.insert(indices.end(), imported.indices.begin(), imported.indices.end());
+	modelFile->importReports.push_back(imported.report);
+	// bone weights are given per file vertex
+	for (uint32_t v : imported.remap)
+	{
+		modelFile->vertexRemap.push_back(v == oGFX::MeshOpt::UNUSED_VERTEX ? v : static_cast<uint32_t>(cacheVoffset + v));
+	}
+
+	submesh.vertexCount = static_cast<uint32_t>(vertices.size() - cacheVoffset);
+	submesh.baseVertex = static_cast<uint32_t>(cacheVoffset);
+	submesh.indicesCount = static_cast<uint32_t>(indices.size() - cacheIoffset);
+	submesh.baseIndices = static_cast<uint32_t>(cacheIoffset);
+	submesh.boundingSphere = imported.bounds;
+
+	// the submesh's meshlets point into its own arrays, moved to the end of the model's
+	auto& clusters = modelFile->meshlets;
+	submesh.meshletOffset = static_cast<uint32_t>(clusters.meshlets.size());
+	submesh.meshletCount = static_cast<uint32_t>(imported.meshlets.meshlets.size());
+	const uint32_t vertexBase = static_cast<uint32_t>(clusters.vertices.size());
+	const uint32_t triangleBase = static_cast<uint32_t>(clusters.triangles.size());
+	for (GPUMeshlet m : imported.meshlets.meshlets)
+	{
+		m.vertexOffset += vertexBase;
+		m.triangleOffset += triangleBase;
+		clusters.meshlets.push_back(m);
+	}
+	clusters.vertices.insert(clusters.vertices.end(), imported.meshlets.vertices.begin(), imported.meshlets.vertices.end());
+	clusters.triangles.insert(clusters.triangles.end(), imported.meshlets.triangles.begin(), imported.meshlets.triangles.end());
+}
+
+static void LoadBoneInformation(ModelFileResource& fileData,
+	oGFX::Skeleton& skeleton,
+	aiMesh& aimesh,
+	std::vector<BoneWeight>& boneWeights,
+	uint32_t& vCnt
+)
+{
+	uint32_t numBones = 0;
+	std::stringstream ss;
+	for (size_t i = 0; i < aimesh.mNumBones; i++)
+	{
+		auto& currBone = aimesh.mBones[i];
+		uint32_t boneIndex = 0;
+		std::string boneName = currBone->mName.C_Str();
+
+
+		if (fileData.strToBone.find(boneName) == fileData.strToBone.end())
+		{
+			// bone doesnt exist, allocate
+			boneIndex = numBones++;
+
+			oGFX::BoneInverseBindPoseInfo& invBindPoseInfo = skeleton.inverseBindPose.emplace_back(oGFX::BoneInverseBindPoseInfo{});
+
+			// Map the name of this bone to this index. (map<string,int>)
+			fileData.strToBone[boneName] = boneIndex;
+
+			// Setup information
+			// TODO: quaternions?
+			invBindPoseInfo.transform = aiMat4_to_glm(currBone->mOffsetMatrix);
+			invBindPoseInfo.boneIdx = boneIndex;
+		}
+		else
+		{
+			// bone already exists!
+			boneIndex = fileData.strToBone[boneName];
+		}
+
+		// Add the bone weights for the vertices for the current bone
+		for (size_t j = 0; j < currBone->mNumWeights; ++j)
+		{
+			// the file vertex was merged or reordered at import
+			const unsigned vertexID = fileData.vertexRemap[currBone->mWeights[j].mVertexId + vCnt];
+			const float weight = currBone->mWeights[j].mWeight;
+			if (vertexID == oGFX::MeshOpt::UNUSED_VERTEX)
+				continue;
+
+			bool success = false;
+
+			auto& vertex = boneWeights[vertexID];
+			for (int slot = 0; slot < 4; ++slot)
+			{
+				// merged vertices carry the same weights, only the first one counts
+				if (vertex.boneIdx[slot] == boneIndex && vertex.boneWeights[slot] != 0.0f) {
+					success = true;
+					break;
+				}
+
+				if (vertex.boneWeights[slot] == 0.0f)
+				{
+					vertex.boneIdx[slot] = boneIndex;
+					vertex.boneWeights[slot] = weight;
+					success = true;
+					break;
+				}
+			}
+#define NORMALIZE_BONE_WEIGHTS
+
+			// Check if the number of weights is >4, just in case, since we dont support
+			if (!success)
+			{
+				
+				
+				float sum;
+#ifdef NORMALIZE_BONE_WEIGHTS
+				uint32_t minBone = boneIndex;
+				float minW = weight;
+				for (size_t i = 0; i < 4; i++)
+				{
+					if (vertex.boneWeights[i] < minW)
+					{
+						std::swap(vertex.boneWeights[i], minW);
+						std::swap(vertex.boneIdx[i], minBone);
+					}
+				}
+				sum = 0.0f;
+				for (size_t i = 0; i < 4; i++)
+				{
+					sum += vertex.boneWeights[i];
+				}
+				for (size_t i = 0; i < 4; i++)
+				{
+					vertex.boneWeights[i]*= (1.0f/sum);
+				}
+				sum = 0.0f;
+				for (auto&[key,val] :  fileData.strToBone)
+				{
+					if (val == minBone)
+					{
+						ss << "Discarded weight: [" << key<<",\t"<< minW << "]" << std::endl;
+						break;
+					}
+				}
+				for (size_t i = 0; i < 4; i++)
+				{
+					sum += vertex.boneWeights[i];
+				}
+				//std::cout << "Final sum : [" << sum<< "]"<<std::endl;
+
+#else
+				//dump bone names
+				std::cout << "Dumping bones...\n";
+				std::cout << "Bone affected : " << currBone->mName.C_Str() << ",\t" << weight<< std::endl;
+				for (size_t i = 0; i < 4; i++)
+				{
+					for (auto&[key,val] :  fileData.strToBone)
+					{
+						if (val == vertex.boneIdx[i])
+						{
+							std::cout << "Bone affected : " << key << ",\t"<<vertex.boneWeights[i] << std::endl;
+							break;
+						}
+					}
+				}				
+				// Vertex already has 4 bone weights assigned.
+				assert(false && "Bone weights >4 is not supported.");
+#endif // NORMALIZE_BONE_WEIGHTS
+			}
+		}
+
+	} // end bone for
+	vCnt += aimesh.mNumVertices;
+}
+
+static void BuildSkeletonRecursive(ModelFileResource& fileData, aiNode* ainode, oGFX::BoneNode* parent, glm::mat4 parentXform = glm::mat4(1.0f), std::string prefix = std::string("\t"))
+{
+	std::string node_name{ ainode->mName.data };
+	//std::stringstream ss;
+	// TODO: quat ?
+	glm::mat4x4 node_transform = parentXform * aiMat4_to_glm(ainode->mTransformation);
+	oGFX::BoneNode* targetParent = parent;
+	std::string cName = node_name.substr(node_name.find_last_of("_") + 1);
+	oGFX::BoneNode* node = parent;
+
+	//std::cout << "Loading " << node_name << std::endl;
+
+	// Save the bone index
+	bool bIsBoneNode = false;
+	auto iter = fileData.strToBone.find(node_name);
+	if (iter != fileData.strToBone.end())
+	{
+		//ss <<prefix<< "Creating bone " << node_name << std::endl;
+		prefix += '\t';
+		bIsBoneNode = true;
+		node = new oGFX::BoneNode;
+		node->mbIsBoneNode = true;
+		node->mName = node_name;
+		node->mpParent = targetParent;
+		node->mModelSpaceLocal = node_transform;
+		node->mModelSpaceGlobal= node_transform;
+		node->m_BoneIndex = iter->second;
+		if (targetParent)
+		{
+			targetParent->mChildren.push_back(node);
+		}
+		targetParent = node;
+	}
+
+	// Leaving this here to check the scale
+	aiVector3D pos, scale;
+	aiQuaternion qua;
+	ainode->mTransformation.Decompose(scale, qua, pos);
+
+	if ((scale.x - scale.y) > 0.0001f || (scale.x - scale.z) > 0.0001f)
+	{
+		static bool firstTime = true;
+		if (firstTime)
+		{
+			// Non-uniform scale bone detected...
+			__debugbreak();
+			firstTime = false;
+		}
+	}
+
+	// Recursion through all children
+	for (size_t i = 0; i < ainode->mNumChildren; i++)
+	{
+		if (bIsBoneNode)
+		{
+			// we have collapsed the transforms start for new local transform
+			BuildSkeletonRecursive(fileData, ainode->mChildren[i], targetParent,glm::mat4(1.0f),prefix);
+		}
+		else
+		{
+			BuildSkeletonRecursive(fileData, ainode->mChildren[i], targetParent,node_transform,prefix);
+		}
+	}
+	//std::cout << ss.str();
+}
+
+bool ImportModel(const std::string& file, Model& out, TaskManager* tasks)
+{
+	PROFILE_SCOPED();
+
+	std::stringstream ss;
+	// new model loader
+	Assimp::Importer importer;
+	const aiScene* scene = ReadScene(importer, file);
+	if (!scene)
+	{
+		return false;
+	}
+
+	ss <<"[Loading] " << file << std::endl;
+	//if (scene->mNumAnimations && scene->mAnimations[0]->mNumMorphMeshChannels)
+	//{
+	//	std::stringstream ss{"Morphs\n"};
+	//	for (size_t i = 0; i < scene->mAnimations[0]->mNumMorphMeshChannels; i++)
+	//	{
+	//		auto& morph = scene->mAnimations[0]->mMorphMeshChannels[i];
+	//		for (size_t y = 0; y < morph->mNumKeys; y++)
+	//		{
+	//			auto& key = morph->mKeys[y];
+	//			ss << "T:[" << key.mTime << "]" << std::endl;
+	//			for (size_t x = 0; x < key.mNumValuesAndWeights; x++)
+	//			{
+	//				ss << "\tV:[" << key.mValues[x] << "] W:[" << key.mWeights[x] << "]" << std::endl;
+	//			}
+	//		}
+	//		ss << std::endl;
+	//	}
+	//	os << ss.str() << std::endl;
+	//}
+
+	size_t count{ 0 };
+	ss << "Meshes" << scene->mNumMeshes << std::endl;
+	for (size_t i = 0; i < scene->mNumMeshes; i++)
+	{
+		auto& mesh = scene->mMeshes[i];
+		ss << "\tMesh" << i << " " << mesh->mName.C_Str() << std::endl;
+		ss << "\t\tverts:"  << mesh->mNumVertices << std::endl;
+		ss << "\t\tbones:"  << mesh->mNumBones << std::endl;
+		/*
+		for (size_t anim = 0; anim < mesh->mNumAnimMeshes; anim++)
+		{
+		std::stringstream ss;
+			ss << "Anim mesh_" << anim << ":" << mesh->mName.C_Str() << std::endl;
+			auto& animMesh = mesh->mAnimMeshes[anim];
+			if (animMesh->HasPositions())
+			{
+				for (size_t pos = 0; pos < animMesh->mNumVertices; pos++)
+				{
+					++count;
+					auto v = aiVector3D_to_glm(animMesh->mVertices[pos]);
+					ss << "\tPos:"<< pos<< "[" << v.x << "," << v.y << "," << v.z <<"]" << std::endl;
+				}
+			}
+		os << ss.str() << std::endl;
+		}
+		os << "Takes huge amount of data : " << (float)(sizeof(glm::vec3) * count) / (1024) << "Kb" << std::endl;
+		*/
+		
+		//int sum = 0;
+		//for (size_t x = 0; x <  scene->mMeshes[i]->mNumBones; x++)
+		//{
+		//	std::map<uint32_t, float> wts;
+		//	os << "\t\t\tweights:"  << scene->mMeshes[i]->mBones[x]->mNumWeights << std::endl;
+		//	for (size_t y = 0; y < scene->mMeshes[i]->mBones[x]->mNumWeights; y++)
+		//	{
+		//		auto& weight = scene->mMeshes[i]->mBones[x]->mWeights[y];
+		//		assert(wts.find(weight.mVertexId) == wts.end());
+		//		wts[weight.mVertexId] = weight.mWeight;
+		//	}
+		//	for (auto [v,w] :wts)
+		//	{
+		//		os << "\t\t\t\t"  <<":["<<v <<"," << w << "]" << std::endl;
+		//	}
+		//	sum += scene->mMeshes[i]->mBones[x]->mNumWeights;
+		//}
+		//os << "\t\t\t|sum weights:"  << sum << std::endl;
+	}
+
+#if 0
+	if (scene->HasAnimations())
+	{
+		os << "Animated scene\n";
+		for (size_t i = 0; i < scene->mNumAnimations; i++)
+		{
+			os << "Anim name: " << scene->mAnimations[i]->mName.C_Str() << std::endl;
+			os << "Anim frames: "<< scene->mAnimations[i]->mDuration << std::endl;
+			os << "Anim ticksPerSecond: "<< scene->mAnimations[i]->mTicksPerSecond << std::endl;
+			os << "Anim duration: "<< static_cast<float>(scene->mAnimations[i]->mDuration)/scene->mAnimations[i]->mTicksPerSecond << std::endl;
+			os << "Anim numChannels: "<< scene->mAnimations[i]->mNumChannels << std::endl;
+			os << "Anim numMeshChannels: "<< scene->mAnimations[i]->mNumMeshChannels << std::endl;
+			os << "Anim numMeshChannels: "<< scene->mAnimations[i]->mNumMorphMeshChannels << std::endl;
+			for (size_t x = 0; x < scene->mAnimations[i]->mNumChannels; x++)
+			{
+				auto& channel = scene->mAnimations[i]->mChannels[x];
+				os << "\tKeys name: " << channel->mNodeName.C_Str() << std::endl;
+				for (size_t y = 0; y < channel->mNumPositionKeys; y++)
+				{
+					os << "\t Key_"<< std::to_string(y)<<" time: " << channel->mPositionKeys[y].mTime << std::endl;
+					auto& pos = channel->mPositionKeys[y].mValue;
+					os << "\t Key_"<< std::to_string(y)<<" value: " <<pos.x <<", " << pos.y<<", " << pos.z << std::endl;
+				}
+			}
+		}
+		os << std::endl;
+	}
+#endif
+
+	out.resource = std::make_unique<ModelFileResource>(file);
+	ModelFileResource* modelFile = out.resource.get();
+
+	modelFile->materials.resize(scene->mNumMaterials);
+	for (size_t i = 0; i < scene->mNumMaterials; i++)
+	{
+		const aiMaterial* material = scene->mMaterials[i];
+		Material& modelMaterial = modelFile->materials[i];
+
+		auto updateTexture = [&](aiTextureType type, std::string& saveTo) {
+			const unsigned int numTexture = material->GetTextureCount(type);
+			OO_ASSERT(numTexture <= 1);
+			for (unsigned int j = 0; j < numTexture; j++) {
+				aiString texturePath;
+				if (material->GetTexture(type, j, &texturePath) == AI_SUCCESS) {
+					// texturePath contains the path to the diffuse texture
+					std::filesystem::path pWithoutFile = file;
+					pWithoutFile.remove_filename();
+					std::string finalPath = pWithoutFile.string() + texturePath.C_Str();
+					if (std::filesystem::exists(finalPath)) {
+						saveTo = finalPath;
+					}
+				}
+			}
+		};
+		
+		updateTexture(aiTextureType_DIFFUSE, modelMaterial.albedo);
+		updateTexture(aiTextureType_NORMALS, modelMaterial.normal);
+		updateTexture(aiTextureType_DIFFUSE_ROUGHNESS, modelMaterial.roughness);
+		updateTexture(aiTextureType_SPECULAR, modelMaterial.specular);		
+	
+	}
+
+	modelFile->numSubmesh = scene->mNumMeshes;
+	modelFile->submeshToMaterial.resize(scene->mNumMeshes);
+
+	// the submeshes convert in parallel and are appended in file order
+	std::vector<Submesh> imported;
+	ConvertSubmeshes(*scene, imported, tasks);
+
+	uint32_t totalBones{ 0 };
+	out.submeshes.resize(scene->mNumMeshes);
+	for (size_t i = 0; i < scene->mNumMeshes; i++)
+	{
+		modelFile->submeshToMaterial[i] = scene->mMeshes[i]->mMaterialIndex;
+		AppendSubmesh(out.submeshes[i], imported[i], modelFile);
+		totalBones += scene->mMeshes[i]->mNumBones;
+	}
+	bool hasBone = totalBones > 0;
+
+	if (hasBone)
+	{
+		out.skeleton = std::make_unique<Skeleton>();
+		Skeleton& skeleton = *out.skeleton;
+		modelFile->skeleton = &skeleton;
+		skeleton.boneWeights.resize(modelFile->vertices.size());
+		uint32_t verticesCnt = 0;
+		for (size_t i = 0; i < scene->mNumMeshes; i++)
+		{
+			auto& aimesh = scene->mMeshes[i];
+			LoadBoneInformation(*modelFile, skeleton, *aimesh, skeleton.boneWeights, verticesCnt);
+		}
+		skeleton.m_boneNodes = new oGFX::BoneNode();
+		skeleton.m_boneNodes->mName = "RootNode";
+		BuildSkeletonRecursive(*modelFile, scene->mRootNode, skeleton.m_boneNodes);
+	}
+
+	//always has one transform, root
+	modelFile->ModelSceneLoad(scene, *scene->mRootNode, nullptr, glm::mat4{ 1.0f });
+
+	ss << "\t [Meshes loaded] " << modelFile->sceneMeshCount << std::endl;
+
+	//std::cout << ss.str();
+	return true;
+}
+
+}
@@ -0,0 +1,64 @@
+/************************************************************************************//*!
+\file           ModelImporter.h
+\project        Ouroboros
+\author         Jamie Kong, j.kong, 390004720 | code contribution (100%)
+\par            email: j.kong\@digipen.edu
+\date           May 29, 2024
+\brief              Declares the CPU half of model import, reading the file and converting its
+submeshes independently over the task manager and assembling the model the renderer registers
+
+Copyright (C) 2022 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents
+without the prior written consent of DigiPen Institute of
+Technology is prohibited.
+*//*************************************************************************************/
+#pragma once
+
+#include "VulkanUtils.h"
+#include "Geometry.h"
+#include "MeshOptimizer.h"
+#include "MeshletBuilder.h"
+#include "MeshModel.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+struct aiScene;
+struct aiMesh;
+namespace Assimp { class Importer; }
+class TaskManager;
+
+namespace oGFX::ModelImport
+{
+	// One submesh converted, optimized, bounded and split into meshlets, shares nothing with the others
+	struct Submesh
+	{
+		std::string name;
+		std::vector<Vertex> vertices;
+		std::vector<uint32_t> indices;	// relative to the submesh's first vertex
+		std::vector<uint32_t> remap;	// file vertex to vertex, MeshOpt::UNUSED_VERTEX when it was dropped
+		MeshOpt::Report report;
+		Sphere bounds;
+		Meshlets::MeshletData meshlets;	// offsets into its own arrays
+	};
+
+	// Reads the file with the post processing the renderer expects, the scene lives as long as the importer
+	const aiScene* ReadScene(Assimp::Importer& importer, const std::string& file);
+
+	void ConvertSubmesh(const aiMesh& mesh, Submesh& out);
+
+	// Converts every mesh of the scene, one task each when given a task manager and in order on this thread otherwise
+	void ConvertSubmeshes(const aiScene& scene, std::vector<Submesh>& out, TaskManager* tasks = nullptr);
+
+	// A whole file on the CPU, what the renderer registers and what the cooker writes out
+	struct Model
+	{
+		std::unique_ptr<ModelFileResource> resource;
+		std::vector<SubMesh> submeshes;		// ranges into the resource's own arrays
+		std::unique_ptr<Skeleton> skeleton;	// null when no mesh is skinned, the resource points at it
+	};
+
+	// Reads, converts and assembles the file without touching the device, false when assimp cannot read it
+	bool ImportModel(const std::string& file, Model& out, TaskManager* tasks = nullptr);
+}
@@ -17,6 +17,7 @@ Technology is prohibited.
 #include "GraphicsWorld.h"
 #include "Profiling.h"
 #include <algorithm>
+#include <bit>
 #include <iostream>
 
 glm::vec3 g_max{-1e10};
@@ -33,7 +34,7 @@ namespace oGFX {
 
 }
 
-void OctTree::Insert(ObjectInstance* entity, AABB objBox)
+void OctTree::Insert(uint32_t entity, AABB objBox)
 {
 	PROFILE_SCOPED();
 	NodeEntry entry;
@@ -41,6 +42,11 @@ void OctTree::Insert(ObjectInstance* entity, AABB objBox)
 	entry.obj = entity;
 	PerformInsert(m_root.get(), entry);
 
+	if (oGFX::coll::AabbContains(m_root->box, entry.box) == false)
+	{
+		m_outOfBounds = true;
+	}
+
 	auto bmax = entry.box.max();
 	auto bmin = entry.box.min();
 
@@ -53,19 +59,18 @@ void OctTree::Insert(ObjectInstance* entity, AABB objBox)
 	g_min.z = std::min(g_min.z, bmin.z);
 }
 
-void OctTree::Remove(ObjectInstance* entity)
+void OctTree::Remove(uint32_t entity)
 {
 	PROFILE_SCOPED();
-	OctNode* node = entity->treeNode;
-	//OO_ASSERT(node && "Entity did not record the node");
-	if (node == nullptr) return; // what could go wrong
+	if (Contains(entity) == false) return; // what could go wrong
+	OctNode* node = m_entityNodes[entity];
 
 	auto it = std::find_if(node->entities.begin(), node->entities.end(), [chk = entity](const NodeEntry& e) { return e.obj == chk; });
 	if (it != node->entities.end()) 
 	{
 		std::swap(*it, node->entities.back());
 		node->entities.pop_back();
-		entity->treeNode = nullptr;
+		m_entityNodes[entity] = nullptr;
 		--m_nodes;
 		return;
 	}
@@ -73,13 +78,50 @@ void OctTree::Remove(ObjectInstance* entity)
 	OO_ASSERT(false && "Entity does not exist in node it points to");
 }
 
-void OctTree::GetEntitiesInFrustum(const Frustum& frust, std::vector<ObjectInstance*>& contained, std::vector<ObjectInstance*>& intersecting)
+void OctTree::Move(uint32_t entity, AABB box)
+{
+	PROFILE_SCOPED();
+	OctNode* node = Contains(entity) ? m_entityNodes[entity] : nullptr;
+	if (node && FitsInNode(node, box))
+	{
+		auto it = std::find_if(node->entities.begin(), node->entities.end(), [chk = entity](const NodeEntry& e) { return e.obj == chk; });
+		OO_ASSERT(it != node->entities.end() && "Entity does not exist in node it points to");
+		it->box = box;
+		return;
+	}
+
+	// left its node, relink from the root
+	Remove(entity);
+	Insert(entity, box);
+}
+
+bool OctTree::Contains(uint32_t entity) const
+{
+	return entity < m_entityNodes.size() && m_entityNodes[entity] != nullptr;
+}
+
+uint32_t OctTree::capacity() const
+{
+	return static_cast<uint32_t>(m_entityNodes.size());
+}
+
+void OctTree::GetEntitiesInFrustum(const Frustum& frust, std::vector<uint32_t>& contained, std::vector<uint32_t>& intersecting)
 {
 	PROFILE_SCOPED();
 	GatherFrustEntities(m_root.get(), frust, contained, intersecting);	
 }
 
-void OctTree::GetAllEntities(std::vector<ObjectInstance*>& entities)
+void OctTree::GetEntitiesInFrustums(const Frustum* frusts, uint32_t numViews, std::vector<uint32_t>* visible)
+{
+	PROFILE_SCOPED();
+	OO_ASSERT(numViews <= s_max_views);
+	if (numViews == 0) return;
+
+	const uint32_t allViews = numViews == s_max_views ? UINT32_MAX : (1u << numViews) - 1;
+	GatherViewEntities(m_root.get(), frusts, allViews, 0, visible);
+}
+
+void OctTree::GetAllEntities(std::vector<uint32_t>& entities)
 {
 	std::vector<uint32_t>depth;
 	GatherEntities(m_root.get(), entities, depth);
@@ -106,6 +148,7 @@ void OctTree::ClearTree()
 		g_min = glm::vec3{ FLT_MAX };
 	}
 	m_nodes = 0;
+	m_outOfBounds = false;
 }
 
 void OctTree::ResizeTree(const AABB& box)
@@ -119,6 +162,11 @@ uint32_t OctTree::size() const
 	return m_nodes;
 }
 
+bool OctTree::NeedsRebuild() const
+{
+	return m_outOfBounds;
+}
+
 void OctTree::GatherBoxWithDepth(OctNode* node, std::vector<AABB>& boxes, std::vector<uint32_t>& depth)
 {
 	if (node == nullptr) return;
@@ -146,7 +194,7 @@ void OctTree::GatherBox(OctNode* node, std::vector<AABB>& boxes)
 	}
 }
 
-void OctTree::GatherEntities(OctNode* node, std::vector<ObjectInstance*>& entities, std::vector<uint32_t>& depth)
+void OctTree::GatherEntities(OctNode* node, std::vector<uint32_t>& entities, std::vector<uint32_t>& depth)
 {
 	if (node == nullptr) return;
 	
@@ -190,7 +238,7 @@ void OctTree::GatherFrustBoxes(OctNode* node, const Frustum& frust, std::vector<
 	}
 }
 
-void OctTree::GatherFrustEntities(OctNode* node, const Frustum& frust, std::vector<ObjectInstance*>& contained, std::vector<ObjectInstance*>& intersect)
+void OctTree::GatherFrustEntities(OctNode* node, const Frustum& frust, std::vector<uint32_t>& contained, std::vector<uint32_t>& intersect)
 {
 	if (node == nullptr) return;
 
@@ -222,6 +270,78 @@ void OctTree::GatherFrustEntities(OctNode* node, const Frustum& frust, std::vect
 	}
 }
 
+void OctTree::GatherViewEntities(OctNode* node, const Frustum* frusts, uint32_t partial, uint32_t contained, std::vector<uint32_t>* visible)
+{
+	if (node == nullptr) return;
+
+	// the root keeps entities outside of its box until the tree is rebuilt, so its box says nothing about them
+	const bool looseNode = node == m_root.get() && m_outOfBounds;
+	const uint32_t looseViews = partial | contained;
+
+	// only the views that straddled the parent need to look at this node
+	for (uint32_t views = partial; views; views &= views - 1)
+	{
+		const uint32_t v = std::countr_zero(views);
+		switch (oGFX::coll::AABBInFrustum(frusts[v], node->box))
+		{
+		case oGFX::coll::OUTSIDE:
+			partial &= ~(1u << v);
+			break;
+		case oGFX::coll::CONTAINS:
+			partial &= ~(1u << v);
+			contained |= 1u << v;
+			break;
+		case oGFX::coll::INTERSECTS:
+			break;
+		}
+	}
+
+	if (node->entities.size())
+	{
+		const uint32_t testViews = looseNode ? looseViews : partial;
+		const uint32_t takeViews = looseNode ? 0 : contained;
+
+		for (uint32_t views = takeViews; views; views &= views - 1)
+		{
+			std::vector<uint32_t>& out = visible[std::countr_zero(views)];
+			for (size_t i = 0; i < node->entities.size(); i++)
+			{
+				out.push_back(node->entities[i].obj);
+			}
+		}
+
+		if (testViews)
+		{
+			thread_local oGFX::coll::AABBBatch boxes;
+			thread_local std::vector<oGFX::coll::Collision> results;
+			boxes.clear();
+			for (size_t i = 0; i < node->entities.size(); i++)
+			{
+				boxes.push_back(node->entities[i].box);
+			}
+			results.resize(boxes.size());
+
+			for (uint32_t views = testViews; views; views &= views - 1)
+			{
+				const uint32_t v = std::countr_zero(views);
+				oGFX::coll::AABBInFrustumBatch(frusts[v], boxes, results.data());
+				for (size_t i = 0; i < results.size(); i++)
+				{
+					if (results[i] != oGFX::coll::OUTSIDE)
+						visible[v].push_back(node->entities[i].obj);
+				}
+			}
+		}
+	}
+
+	// children lie inside this node, views that missed it miss them too
+	if ((partial | contained) == 0) return;
+	for (size_t i = 0; i < s_num_children; i++)
+	{
+		GatherViewEntities(node->children[i].get(), frusts, partial, contained, visible);
+	}
+}
+
 void OctTree::SplitNode(OctNode* node)
 {
 	const uint32_t currDepth = node->depth + 1;
@@ -260,7 +380,7 @@ void OctTree::PerformInsert(OctNode* node,const NodeEntry& entry)
 	{
 		node->nodeID = ++m_nodes;
 		node->entities.push_back(entry);
-		entry.obj->treeNode = node;
+		LinkEntity(entry.obj, node);
 		return;
 	}
 
@@ -280,7 +400,7 @@ void OctTree::PerformInsert(OctNode* node,const NodeEntry& entry)
 	// not contained in any child
 	node->nodeID = ++m_nodes;
 	node->entities.push_back(entry);	
-	entry.obj->treeNode = node;
+	LinkEntity(entry.obj, node);
 }
 
 bool OctTree::PerformRemove(OctNode* node, const NodeEntry& entry)
@@ -311,6 +431,40 @@ bool OctTree::PerformRemove(OctNode* node, const NodeEntry& entry)
 	return false;
 }
 
+void OctTree::LinkEntity(uint32_t entity, OctNode* node)
+{
+	if (entity >= m_entityNodes.size())
+	{
+		m_entityNodes.resize(size_t(entity) + 1, nullptr);
+	}
+	m_entityNodes[entity] = node;
+}
+
+bool OctTree::FitsInNode(OctNode* node, const AABB& box) const
+{
+	if (oGFX::coll::AabbContains(node->box, box) == false)
+	{
+		// the root keeps entities that are outside of the tree bounds
+		return node == m_root.get() && m_outOfBounds;
+	}
+
+	// leaves take everything inside them
+	if (node->depth + 1 > m_maxDepth || node->children[0] == nullptr)
+	{
+		return true;
+	}
+
+	// would be pushed further down on insert
+	for (size_t i = 0; i < s_num_children; i++)
+	{
+		if (oGFX::coll::AabbContains(node->children[i]->box, box))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
 void OctTree::PerformClear(OctNode* node)
 {
 	if (node == nullptr) return;
@@ -322,7 +476,7 @@ void OctTree::PerformClear(OctNode* node)
 
 	for (size_t i = 0; i < node->entities.size(); i++)
 	{
-		node->entities[i].obj->treeNode = nullptr;
+		m_entityNodes[node->entities[i].obj] = nullptr;
 	}
 	node->entities.clear();
 }
@@ -18,7 +18,6 @@ Technology is prohibited.
 #include <vector>
 #include <memory>
 
-struct ObjectInstance;
 namespace oGFX {
 
 struct OctNode;
@@ -29,39 +28,54 @@ class OctTree
 public:
 	inline static constexpr uint32_t s_num_children = 8;
 	inline static constexpr uint32_t s_stop_depth = 8;
+	inline static constexpr uint32_t s_max_views = 32;
 public:
 	OctTree(const AABB rootBox = { Point3D{-500.0f},Point3D{500.0f} } ,int stopDepth = s_stop_depth);
 
-	void Insert(ObjectInstance* entity, AABB box);
+	void Insert(uint32_t entity, AABB box);
 
-	void Remove(ObjectInstance* entity);
+	void Remove(uint32_t entity);
+	// Updates the bounds of an entity already in the tree, relinking it only if it left its node
+	void Move(uint32_t entity, AABB box);
+	bool Contains(uint32_t entity) const;
+	// One past the largest entity id the tree has seen
+	uint32_t capacity() const;
 
 	void GetActiveBoxList(std::vector<AABB>& boxes, std::vector<uint32_t>& depth);
-	void GetEntitiesInFrustum(const Frustum& frust, std::vector<ObjectInstance*>& contains, std::vector<ObjectInstance*>& intersect);
-	void GetAllEntities(std::vector<ObjectInstance*>& entities);
+	void GetEntitiesInFrustum(const Frustum& frust, std::vector<uint32_t>& contains, std::vector<uint32_t>& intersect);
+	// Culls up to s_max_views frustums in one traversal, visible[v] receives every entity that overlaps frusts[v]
+	void GetEntitiesInFrustums(const Frustum* frusts, uint32_t numViews, std::vector<uint32_t>* visible);
+	void GetAllEntities(std::vector<uint32_t>& entities);
 	void GetBoxesInFrustum(const Frustum& frust, std::vector<AABB>& contains, std::vector<AABB>& intersect);
 
 	void ClearTree();
 	void ResizeTree(const AABB& box);
 	uint32_t size() const;
+	// True when an entity was inserted outside of the root bounds and the tree must be rebuilt
+	bool NeedsRebuild() const;
 
 private:
 	std::unique_ptr<OctNode> m_root{};
+	std::vector<OctNode*> m_entityNodes; // node each entity id lives in
 
 	uint32_t m_entitiesCnt{};
 	uint32_t m_maxDepth{ s_stop_depth };
 
 	uint32_t m_nodes{};
+	bool m_outOfBounds{ false };
 	uint32_t m_boxesInsertCnt[s_num_children];
 
 	void GatherBoxWithDepth(OctNode* node,std::vector<AABB>& boxes, std::vector<uint32_t>& depth);
 	void GatherBox(OctNode* node,std::vector<AABB>& boxes);
-	void GatherEntities(OctNode* node,std::vector<ObjectInstance*>& entities, std::vector<uint32_t>& depth);
+	void GatherEntities(OctNode* node,std::vector<uint32_t>& entities, std::vector<uint32_t>& depth);
 	void GatherFrustBoxes(OctNode* node, const Frustum& frust,std::vector<AABB>& contained, std::vector<AABB>& intersect);
-	void GatherFrustEntities(OctNode* node, const Frustum& frust,std::vector<ObjectInstance*>& contained, std::vector<ObjectInstance*>& intersect);
+	void GatherFrustEntities(OctNode* node, const Frustum& frust,std::vector<uint32_t>& contained, std::vector<uint32_t>& intersect);
+	void GatherViewEntities(OctNode* node, const Frustum* frusts, uint32_t partial, uint32_t contained, std::vector<uint32_t>* visible);
 	
 	void PerformInsert(OctNode* node, const NodeEntry& entry);
 	bool PerformRemove(OctNode* node, const NodeEntry& entry);
+	bool FitsInNode(OctNode* node, const AABB& box) const;
+	void LinkEntity(uint32_t entity, OctNode* node);
 	void SplitNode(OctNode* node);
 	void PerformClear(OctNode* node);
 
@@ -80,7 +94,7 @@ struct OctNode
 
 struct NodeEntry 
 {
-	ObjectInstance* obj{ nullptr };
+	uint32_t obj{ UINT32_MAX };
 	AABB box{};
 };
 
@@ -0,0 +1,359 @@
+/************************************************************************************//*!
+\file           PipelineCache.cpp
+\project        Ouroboros
+\author         Jamie Kong, j.kong, 390004720 | code contribution (100%)
+\par            email: j.kong\@digipen.edu
+\date           May 09, 2024
+\brief              Defines the pipeline cache kept on disk, the SPIR-V cache and the manifest of pipelines to warm up
+
+Copyright (C) 2022 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents
+without the prior written consent of DigiPen Institute of
+Technology is prohibited.
+*//*************************************************************************************/
+#include "PipelineCache.h"
+#include "VulkanDevice.h"
+#include "VulkanUtils.h"
+#include "Profiling.h"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace
+{
+	constexpr uint32_t CACHE_FILE_MAGIC = 0x4350474F; // "OGPC"
+	constexpr uint32_t CACHE_FILE_VERSION = 1;
+
+	struct CacheFileHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint64_t dataSize;
+		uint64_t checksum;
+	};
+
+	uint64_t Fnv1a64(const void* data, size_t size)
+	{
+		uint64_t hash = 0xcbf29ce484222325ull;
+		const unsigned char* bytes = static_cast<const unsigned char*>(data);
+		for (size_t i = 0; i < size; ++i)
+		{
+			hash ^= bytes[i];
+			hash *= 0x100000001b3ull;
+		}
+		return hash;
+	}
+
+	template <typename T>
+	void Combine(size_t& seed, const T& v)
+	{
+		seed ^= std::hash<T>{}(v) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+	}
+
+	bool ReadWholeFile(const std::string& path, std::vector<char>& out)
+	{
+		std::ifstream file(path, std::ios::binary | std::ios::ate);
+		if (!file.is_open())
+			return false;
+		out.resize(static_cast<size_t>(file.tellg()));
+		file.seekg(0);
+		file.read(out.data(), out.size());
+		return static_cast<bool>(file);
+	}
+}
+
+size_t PipelineDesc::ComputeHash() const
+{
+	size_t result = layoutHash;
+	Combine(result, static_cast<uint32_t>(bindPoint));
+	for (const std::string& s : shaders)
+	{
+		Combine(result, s);
+	}
+	for (VkFormat f : colourFormats)
+	{
+		Combine(result, static_cast<uint32_t>(f));
+	}
+	Combine(result, colourFormats.size());
+	Combine(result, static_cast<uint32_t>(depthFormat));
+	return result;
+}
+
+std::vector<char> PackPipelineCacheFile(const void* data, size_t size)
+{
+	CacheFileHeader header{ CACHE_FILE_MAGIC, CACHE_FILE_VERSION, size, Fnv1a64(data, size) };
+	std::vector<char> file(sizeof(header) + size);
+	memcpy(file.data(), &header, sizeof(header));
+	if (size)
+	{
+		memcpy(file.data() + sizeof(header), data, size);
+	}
+	return file;
+}
+
+bool UnpackPipelineCacheFile(const std::vector<char>& file, const VkPhysicalDeviceProperties& props, std::vector<char>& data)
+{
+	data.clear();
+
+	CacheFileHeader header{};
+	if (file.size() < sizeof(header))
+		return false;
+	memcpy(&header, file.data(), sizeof(header));
+	if (header.magic != CACHE_FILE_MAGIC || header.version != CACHE_FILE_VERSION || header.dataSize != file.size() - sizeof(header))
+		return false;
+
+	const char* payload = file.data() + sizeof(header);
+	if (Fnv1a64(payload, header.dataSize) != header.checksum)
+		return false;
+
+	// the driver's own header says which device and driver build wrote it
+	VkPipelineCacheHeaderVersionOne vkHeader{};
+	if (header.dataSize < sizeof(vkHeader))
+		return false;
+	memcpy(&vkHeader, payload, sizeof(vkHeader));
+	if (vkHeader.headerSize < sizeof(vkHeader) || vkHeader.headerSize > header.dataSize
+		|| vkHeader.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+		|| vkHeader.vendorID != props.vendorID
+		|| vkHeader.deviceID != props.deviceID
+		|| memcmp(vkHeader.pipelineCacheUUID, props.pipelineCacheUUID, VK_UUID_SIZE) != 0)
+		return false;
+
+	data.assign(payload, payload + header.dataSize);
+	return true;
+}
+
+std::string WritePipelineManifest(const std::vector<PipelineDesc>& descs)
+{
+	std::ostringstream out;
+	for (const PipelineDesc& d : descs)
+	{
+		out << std::hex << d.hash << std::dec << ' ' << static_cast<uint32_t>(d.bindPoint);
+		out << ' ' << d.shaders.size();
+		for (const std::string& s : d.shaders)
+		{
+			out << ' ' << s;
+		}
+		out << ' ' << d.colourFormats.size();
+		for (VkFormat f : d.colourFormats)
+		{
+			out << ' ' << static_cast<uint32_t>(f);
+		}
+		out << ' ' << static_cast<uint32_t>(d.depthFormat);
+		out << ' ' << d.sets.size();
+		for (const auto& set : d.sets)
+		{
+			out << ' ' << set.size();
+			for (const VkDescriptorSetLayoutBinding& b : set)
+			{
+				out << ' ' << b.binding << ' ' << static_cast<uint32_t>(b.descriptorType) << ' ' << b.descriptorCount << ' ' << b.stageFlags;
+			}
+		}
+		out << '\n';
+	}
+	return out.str();
+}
+
+std::vector<PipelineDesc> ReadPipelineManifest(const std::string& text)
+{
+	// anything past these is a damaged line
+	constexpr size_t MAX_COUNT = 64;
+
+	std::vector<PipelineDesc> descs;
+	std::istringstream lines(text);
+	std::string line;
+	while (std::getline(lines, line))
+	{
+		std::istringstream in(line);
+		PipelineDesc d;
+		uint32_t bindPoint{}, depthFormat{};
+		size_t count{};
+
+		in >> std::hex >> d.hash >> std::dec >> bindPoint >> count;
+		if (!in || count > MAX_COUNT) continue;
+		d.bindPoint = static_cast<VkPipelineBindPoint>(bindPoint);
+		d.shaders.resize(count);
+		for (std::string& s : d.shaders)
+		{
+			in >> s;
+		}
+
+		in >> count;
+		if (!in || count > MAX_COUNT) continue;
+		d.colourFormats.resize(count);
+		for (VkFormat& f : d.colourFormats)
+		{
+			uint32_t v{};
+			in >> v;
+			f = static_cast<VkFormat>(v);
+		}
+		in >> depthFormat >> count;
+		if (!in || count > MAX_COUNT) continue;
+		d.depthFormat = static_cast<VkFormat>(depthFormat);
+
+		d.sets.resize(count);
+		for (auto& set : d.sets)
+		{
+			in >> count;
+			if (!in || count > MAX_COUNT) break;
+			set.resize(count);
+			for (VkDescriptorSetLayoutBinding& b : set)
+			{
+				uint32_t type{};
+				in >> b.binding >> type >> b.descriptorCount >> b.stageFlags;
+				b.descriptorType = static_cast<VkDescriptorType>(type);
+				b.pImmutableSamplers = nullptr;
+			}
+		}
+
+		const bool valid = in && d.shaders.size() == (d.bindPoint == VK_PIPELINE_BIND_POINT_COMPUTE ? 1u : 2u);
+		if (valid)
+		{
+			descs.push_back(std::move(d));
+		}
+	}
+	return descs;
+}
+
+void PipelineCache::Init(VulkanDevice* device, const std::string& cachePath, const std::string& manifestPath)
+{
+	PROFILE_SCOPED();
+	m_device = device;
+	m_cachePath = cachePath;
+	m_manifestPath = manifestPath;
+
+	std::vector<char> file;
+	std::vector<char> data;
+	if (ReadWholeFile(m_cachePath, file))
+	{
+		if (UnpackPipelineCacheFile(file, m_device->properties, data))
+		{
+			m_stats.loadedBytes = data.size();
+		}
+		else
+		{
+			m_stats.rejectedFile = true;
+			std::cerr << "[PipelineCache] " << m_cachePath << " does not fit this device or driver, starting cold" << std::endl;
+		}
+	}
+
+	VkPipelineCacheCreateInfo cacheCI{ VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO };
+	cacheCI.initialDataSize = data.size();
+	cacheCI.pInitialData = data.empty() ? nullptr : data.data();
+	VkResult result = vkCreatePipelineCache(m_device->logicalDevice, &cacheCI, nullptr, &m_cache);
+	if (result != VK_SUCCESS && data.empty() == false)
+	{
+		// the driver did not take it after all
+		m_stats.loadedBytes = 0;
+		m_stats.rejectedFile = true;
+		cacheCI.initialDataSize = 0;
+		cacheCI.pInitialData = nullptr;
+		result = vkCreatePipelineCache(m_device->logicalDevice, &cacheCI, nullptr, &m_cache);
+	}
+	VK_CHK(result);
+	VK_NAME(m_device->logicalDevice, "PipelineCache", m_cache);
+
+	if (ReadWholeFile(m_manifestPath, file))
+	{
+		m_loadedManifest = ReadPipelineManifest(std::string(file.begin(), file.end()));
+		m_stats.manifestLoaded = static_cast<uint32_t>(m_loadedManifest.size());
+	}
+	// the next run warms up what this run warmed up, even if it is not used again
+	for (const PipelineDesc& d : m_loadedManifest)
+	{
+		if (m_manifestHashes.insert(d.hash).second)
+		{
+			m_manifest.push_back(d);
+		}
+	}
+
+	std::cout << "[PipelineCache] " << (m_stats.loadedBytes ? "warm" : "cold") << " start, " << m_stats.loadedBytes
+		<< " bytes, " << m_stats.manifestLoaded << " pipelines in manifest" << std::endl;
+}
+
+void PipelineCache::Save()
+{
+	PROFILE_SCOPED();
+	if (m_cache == VK_NULL_HANDLE)
+		return;
+
+	size_t size{};
+	VK_CHK(vkGetPipelineCacheData(m_device->logicalDevice, m_cache, &size, nullptr));
+	std::vector<char> data(size);
+	VK_CHK(vkGetPipelineCacheData(m_device->logicalDevice, m_cache, &size, data.data()));
+	data.resize(size);
+
+	// written next to the old one first so a crash while saving does not leave half a file
+	const std::vector<char> file = PackPipelineCacheFile(data.data(), data.size());
+	const std::string temp = m_cachePath + ".tmp";
+	{
+		std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+		out.write(file.data(), file.size());
+		if (!out)
+		{
+			std::cerr << "[PipelineCache] Failed to write " << temp << std::endl;
+			return;
+		}
+	}
+	std::remove(m_cachePath.c_str());
+	std::rename(temp.c_str(), m_cachePath.c_str());
+	m_stats.savedBytes = data.size();
+
+	std::lock_guard<std::mutex> lock(m_manifestLock);
+	std::ofstream manifest(m_manifestPath, std::ios::trunc);
+	manifest << WritePipelineManifest(m_manifest);
+}
+
+void PipelineCache::Destroy()
+{
+	if (m_cache)
+	{
+		vkDestroyPipelineCache(m_device->logicalDevice, m_cache, nullptr);
+		m_cache = VK_NULL_HANDLE;
+	}
+	ClearShaderCode();
+}
+
+const std::vector<char>& PipelineCache::GetShaderCode(const std::string& path)
+{
+	std::lock_guard<std::mutex> lock(m_shaderLock);
+	auto iter = m_shaderCode.find(path);
+	if (iter != m_shaderCode.end())
+	{
+		++m_stats.shaderHits;
+		return iter->second;
+	}
+	++m_stats.shaderReads;
+	// read under the lock, two threads asking for the same file only read it once
+	return m_shaderCode.emplace(path, oGFX::readFile(path)).first->second;
+}
+
+void PipelineCache::ClearShaderCode()
+{
+	std::lock_guard<std::mutex> lock(m_shaderLock);
+	m_shaderCode.clear();
+}
+
+void PipelineCache::RecordPipeline(const PipelineDesc& desc)
+{
+	for (const std::string& s : desc.shaders)
+	{
+		// the manifest is split on whitespace
+		if (s.find_first_of(" \t\r\n") != std::string::npos)
+			return;
+	}
+
+	std::lock_guard<std::mutex> lock(m_manifestLock);
+	if (m_manifestHashes.insert(desc.hash).second)
+	{
+		m_manifest.push_back(desc);
+		++m_stats.manifestRecorded;
+	}
+}
+
+PipelineCache::Stats PipelineCache::GetStats() const
+{
+	std::scoped_lock lock(m_shaderLock, m_manifestLock);
+	return m_stats;
+}
@@ -0,0 +1,98 @@
+/************************************************************************************//*!
+\file           PipelineCache.h
+\project        Ouroboros
+\author         Jamie Kong, j.kong, 390004720 | code contribution (100%)
+\par            email: j.kong\@digipen.edu
+\date           May 09, 2024
+\brief              Declares the pipeline cache kept on disk, the SPIR-V cache and the manifest of pipelines to warm up
+
+Copyright (C) 2022 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents
+without the prior written consent of DigiPen Institute of
+Technology is prohibited.
+*//*************************************************************************************/
+#pragma once
+
+#include "vulkan/vulkan.h"
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+struct VulkanDevice;
+
+// Everything needed to build a pipeline the command list builds on demand.
+// The fixed function state is the same for all of them so it is not part of it.
+struct PipelineDesc
+{
+	VkPipelineBindPoint bindPoint{ VK_PIPELINE_BIND_POINT_GRAPHICS };
+	std::vector<std::string> shaders;							// vertex and fragment, or compute
+	std::vector<std::vector<VkDescriptorSetLayoutBinding>> sets;	// bindings per descriptor set, no immutable samplers
+	std::vector<VkFormat> colourFormats;
+	VkFormat depthFormat{ VK_FORMAT_UNDEFINED };
+
+	size_t layoutHash{};	// key of the pipeline layout
+	size_t hash{};			// key of the pipeline, from ComputeHash
+
+	size_t ComputeHash() const;
+};
+
+// Pipeline cache data wrapped with a header of our own, a torn or stale file is thrown away instead of handed to the driver
+std::vector<char> PackPipelineCacheFile(const void* data, size_t size);
+// False when the file is damaged or was written by another device or driver
+bool UnpackPipelineCacheFile(const std::vector<char>& file, const VkPhysicalDeviceProperties& props, std::vector<char>& data);
+
+// One pipeline per line, lines that do not parse are skipped
+std::string WritePipelineManifest(const std::vector<PipelineDesc>& descs);
+std::vector<PipelineDesc> ReadPipelineManifest(const std::string& text);
+
+class PipelineCache
+{
+public:
+	struct Stats
+	{
+		size_t loadedBytes{};		// pipeline cache data accepted from disk
+		size_t savedBytes{};
+		bool rejectedFile{ false };	// a file was there but did not fit this device
+		uint32_t shaderReads{};		// SPIR-V files read from disk
+		uint32_t shaderHits{};		// SPIR-V requests served from memory
+		uint32_t manifestLoaded{};	// pipelines known from the last run
+		uint32_t manifestRecorded{};	// pipelines added this run
+	};
+
+	void Init(VulkanDevice* device, const std::string& cachePath, const std::string& manifestPath);
+	// Writes the driver's cache and the manifest, call once the device is idle
+	void Save();
+	void Destroy();
+
+	VkPipelineCache Get() const { return m_cache; }
+
+	// SPIR-V of a shader, read from disk once
+	const std::vector<char>& GetShaderCode(const std::string& path);
+	// Shaders were rebuilt, read them again on next use
+	void ClearShaderCode();
+
+	// Adds a pipeline built on demand, the next run builds it during startup
+	void RecordPipeline(const PipelineDesc& desc);
+	// Pipelines recorded by the last run
+	const std::vector<PipelineDesc>& GetManifest() const { return m_loadedManifest; }
+
+	Stats GetStats() const;
+
+private:
+	VulkanDevice* m_device{ nullptr };
+	VkPipelineCache m_cache{ VK_NULL_HANDLE };
+	std::string m_cachePath;
+	std::string m_manifestPath;
+
+	mutable std::mutex m_shaderLock;
+	std::unordered_map<std::string, std::vector<char>> m_shaderCode;
+
+	mutable std::mutex m_manifestLock;
+	std::vector<PipelineDesc> m_loadedManifest;
+	std::vector<PipelineDesc> m_manifest;
+	std::unordered_set<size_t> m_manifestHashes;
+
+	Stats m_stats;
+};
@@ -0,0 +1,182 @@
+/************************************************************************************//*!
+\file           RGTransientPool.cpp
+\project        Ouroboros
+\author         Jamie Kong, j.kong, 390004720 | code contribution (100%)
+\par            email: j.kong\@digipen.edu
+\date           May 02, 2024
+\brief              Defines the pool that places transient render graph textures in one shared block of memory
+
+Copyright (C) 2022 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents
+without the prior written consent of DigiPen Institute of
+Technology is prohibited.
+*//*************************************************************************************/
+#include "RGTransientPool.h"
+#include "VulkanDevice.h"
+#include "VulkanTexture.h"
+#include "VulkanUtils.h"
+#include "Profiling.h"
+
+#include <algorithm>
+#include <iostream>
+
+void RGTransientPool::Init(VulkanDevice* device)
+{
+	m_device = device;
+}
+
+void RGTransientPool::Destroy()
+{
+	// the textures are destroyed by their passes
+	if (m_memory)
+	{
+		vmaFreeMemory(m_device->m_allocator, m_memory);
+		m_memory = VK_NULL_HANDLE;
+	}
+	m_textures.clear();
+	m_requests.clear();
+	m_passLists.clear();
+	m_timelineSteps = 0;
+	m_placed = false;
+	m_stats = {};
+}
+
+void RGTransientPool::Register(vkutils::Texture& texture)
+{
+	OO_ASSERT(IsTransient(&texture) == false);
+	m_textures.push_back(&texture);
+	m_requests.emplace_back();
+	m_placed = false;
+
+	// the pass lists seen so far have to be looked at again with this texture in them
+	m_passLists.clear();
+	m_timelineSteps = 0;
+	for (RGAliasRequest& r : m_requests)
+	{
+		r.lifetime.reset();
+	}
+}
+
+bool RGTransientPool::IsTransient(const void* resource) const
+{
+	return std::find(m_textures.begin(), m_textures.end(), resource) != m_textures.end();
+}
+
+void RGTransientPool::Update(const std::vector<RGPassDesc>& passes, const RGCompileResult& compiled)
+{
+	PROFILE_SCOPED();
+	if (m_textures.empty())
+		return;
+
+	std::vector<std::string> passList(passes.size());
+	for (size_t i = 0; i < passes.size(); ++i)
+	{
+		passList[i] = passes[i].name;
+	}
+
+	if (std::find(m_passLists.begin(), m_passLists.end(), passList) == m_passLists.end())
+	{
+		const uint32_t steps = static_cast<uint32_t>(compiled.order.size());
+		if (m_timelineSteps + steps > RG_MAX_TIMELINE)
+		{
+			// start over from the pass list in use, the old layout stays valid for it
+			m_passLists.clear();
+			m_timelineSteps = 0;
+			for (RGAliasRequest& r : m_requests)
+			{
+				r.lifetime.reset();
+			}
+		}
+
+		std::vector<const void*> resources(m_textures.begin(), m_textures.end());
+		std::vector<RGLifetime> lifetimes;
+		RGComputeLifetimes(passes, compiled, resources, m_timelineSteps, lifetimes);
+		for (size_t i = 0; i < m_requests.size(); ++i)
+		{
+			m_requests[i].lifetime |= lifetimes[i];
+		}
+		m_timelineSteps += steps;
+		m_passLists.push_back(std::move(passList));
+		m_stats.numPassLists = static_cast<uint32_t>(m_passLists.size());
+
+		if (m_placed && RGAliasLayoutValid(m_requests, m_layout) == false)
+		{
+			m_placed = false;
+		}
+	}
+
+	if (m_placed == false)
+	{
+		Place();
+	}
+}
+
+void RGTransientPool::Invalidate()
+{
+	m_placed = false;
+}
+
+void RGTransientPool::Place()
+{
+	PROFILE_SCOPED();
+	// frames in flight may still use the old images
+	vkDeviceWaitIdle(m_device->logicalDevice);
+
+	uint32_t memoryTypeBits = ~0u;
+	VkDeviceSize alignment = 1;
+	for (size_t i = 0; i < m_textures.size(); ++i)
+	{
+		VkMemoryRequirements memReq{};
+		vkGetImageMemoryRequirements(m_device->logicalDevice, m_textures[i]->image.image, &memReq);
+		m_requests[i].size = memReq.size;
+		m_requests[i].alignment = memReq.alignment;
+		memoryTypeBits &= memReq.memoryTypeBits;
+		alignment = std::max(alignment, memReq.alignment);
+	}
+	m_placed = true;
+
+	if (memoryTypeBits == 0)
+	{
+		std::cerr << "[Transient] No memory type fits every transient texture, they keep their own memory" << std::endl;
+		return;
+	}
+
+	m_layout = RGPackAliases(m_requests);
+
+	VkMemoryRequirements memReq{};
+	memReq.size = m_layout.heapSize;
+	memReq.alignment = alignment;
+	memReq.memoryTypeBits = memoryTypeBits;
+
+	VmaAllocationCreateInfo allocCI{};
+	allocCI.flags = VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT;
+	allocCI.requiredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+	allocCI.priority = 1.0f;
+
+	VmaAllocation memory{ VK_NULL_HANDLE };
+	VkResult result = vmaAllocateMemory(m_device->m_allocator, &memReq, &allocCI, &memory, nullptr);
+	if (result != VK_SUCCESS)
+	{
+		std::cerr << "[Transient] Failed to allocate transient memory - " << oGFX::vkutils::tools::VkResultString(result) << std::endl;
+		return;
+	}
+	vmaSetAllocationName(m_device->m_allocator, memory, "RGTransientPool");
+
+	for (size_t i = 0; i < m_textures.size(); ++i)
+	{
+		m_textures[i]->AliasImageMemory(memory, m_layout.offsets[i]);
+	}
+
+	// nothing is bound to the old block anymore
+	if (m_memory)
+	{
+		vmaFreeMemory(m_device->m_allocator, m_memory);
+	}
+	m_memory = memory;
+
+	m_stats.heapSize = m_layout.heapSize;
+	m_stats.unaliasedSize = m_layout.unaliasedSize;
+	m_stats.numTextures = static_cast<uint32_t>(m_textures.size());
+	std::cout << "[Transient] " << m_stats.numTextures << " textures in " << (m_stats.heapSize >> 20) << "MB, "
+		<< (m_stats.unaliasedSize >> 20) << "MB without aliasing" << std::endl;
+}
@@ -0,0 +1,71 @@
+/************************************************************************************//*!
+\file           RGTransientPool.h
+\project        Ouroboros
+\author         Jamie Kong, j.kong, 390004720 | code contribution (100%)
+\par            email: j.kong\@digipen.edu
+\date           May 02, 2024
+\brief              Declares the pool that places transient render graph textures in one shared block of memory
+
+Copyright (C) 2022 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents
+without the prior written consent of DigiPen Institute of
+Technology is prohibited.
+*//*************************************************************************************/
+#pragma once
+
+#include "vulkan/vulkan.h"
+#include <string>
+#include <vector>
+#include "VmaUsage.h"
+#include "RenderGraphCompiler.h"
+
+struct VulkanDevice;
+namespace vkutils
+{
+class Texture;
+}
+
+// Textures that are written and read within a frame only. Their lifetimes come from the compiled render graph,
+// textures that are never alive at the same time share memory.
+class RGTransientPool
+{
+public:
+	struct Stats
+	{
+		uint64_t heapSize{};		// memory actually allocated
+		uint64_t unaliasedSize{};	// what the textures would take on their own
+		uint32_t numTextures{};
+		uint32_t numPassLists{};
+	};
+
+	void Init(VulkanDevice* device);
+	void Destroy();
+
+	// The texture keeps its own memory until the first update places it
+	void Register(vkutils::Texture& texture);
+	bool IsTransient(const void* resource) const;
+
+	// Adds the lifetimes of this frame's pass list and places the textures again when the memory layout does not fit it.
+	// Call after the graph is compiled and before any of its passes are recorded.
+	void Update(const std::vector<RGPassDesc>& passes, const RGCompileResult& compiled);
+
+	// The textures were recreated on their own memory (resize), they are placed again on the next update
+	void Invalidate();
+
+	const Stats& GetStats() const { return m_stats; }
+
+private:
+	void Place();
+
+	VulkanDevice* m_device{ nullptr };
+	std::vector<vkutils::Texture*> m_textures;
+	std::vector<RGAliasRequest> m_requests;
+	RGAliasLayout m_layout;
+
+	std::vector<std::vector<std::string>> m_passLists;	// pass lists seen so far, each owns a range of the timeline
+	uint32_t m_timelineSteps{};
+
+	VmaAllocation m_memory{ VK_NULL_HANDLE };
+	bool m_placed{ false };
+	Stats m_stats;
+};
@@ -16,6 +16,7 @@ Technology is prohibited.
 
 #include "GfxRenderpass.h"
 #include "VulkanRenderer.h"
+#include "Profiling.h"
 
 OO_OPTIMIZE_OFF
 RenderGraph::RenderGraph()
@@ -44,16 +45,36 @@ void RenderGraph::Setup()
 
 void RenderGraph::Compile()
 {
+	PROFILE_SCOPED();
+	m_passDescs.resize(passes.size());
+	for (size_t i = 0; i < passes.size(); ++i)
+	{
+		m_passDescs[i].name = passes[i].name;
+		m_passDescs[i].accesses = passes[i].accesses;
+	}
+	m_compiled = RGCompile(m_passDescs, m_outputs);
+	m_isCompiled = true;
 }
 
 void RenderGraph::Execute()
 {
 	auto& vr = *VulkanRenderer::get();
-	for (PassInfo& passInfo : passes)
+	for (uint32_t i = 0; i < passes.size(); ++i)
 	{
-		GfxRenderpass* pass = passInfo.pass;
-		auto renderTask = [vr = &vr, pass = pass](void*) {
+		if (m_isCompiled && m_compiled.culled[i])
+			continue;
+
+		// the graph is gone by the time the tasks run, they keep their own copy of the barriers
+		std::vector<RGBarrier> barriers;
+		if (m_isCompiled)
+		{
+			barriers.assign(m_compiled.barriers.begin() + m_compiled.barrierBegin[i], m_compiled.barriers.begin() + m_compiled.barrierBegin[i + 1]);
+		}
+
+		GfxRenderpass* pass = passes[i].pass;
+		auto renderTask = [vr = &vr, pass = pass, barriers = std::move(barriers)](void*) {
 			const VkCommandBuffer cmd = vr->GetCommandBuffer();
+			RecordBarriers(cmd, barriers);
 			pass->Draw(cmd);
 			};
 		vr.m_taskList.push(Task(renderTask, nullptr, &vr.drawCallRecordingCompleted));
@@ -80,6 +101,7 @@ void RenderGraph::Write(vkutils::Texture* t, ResourceUsage usage)
 		imgFormat = VK_IMAGE_LAYOUT_GENERAL;
 	}
 	passes[currentPass].textureReg[t].expectedLayout = imgFormat;
+	passes[currentPass].accesses.push_back(RGAccess{ t, usage, true, false, t->format == VulkanRenderer::G_DEPTH_FORMAT, IsTransient(t) });
 }
 
 void RenderGraph::Write(vkutils::Texture& t, ResourceUsage u)
@@ -93,6 +115,7 @@ void RenderGraph::Read(vkutils::Texture* t, ResourceUsage usage)
 	OO_ASSERT(usage == SRV); // should there be anything else?
 	//ensure tracking image globally ??
 	passes[currentPass].textureReg[t].expectedLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	passes[currentPass].accesses.push_back(RGAccess{ t, usage, false, false, t->format == VulkanRenderer::G_DEPTH_FORMAT, IsTransient(t) });
 }
 
 void RenderGraph::Read(vkutils::Texture& t, ResourceUsage u)
@@ -107,6 +130,7 @@ void RenderGraph::Read(oGFX::AllocatedBuffer* buffer)
 
 	//ensure tracking buffer globally ??
 	passes[currentPass].bufferReg[buffer].expectedAccess = ResourceUsage::SRV;
+	passes[currentPass].accesses.push_back(RGAccess{ buffer, ResourceUsage::SRV, false, true, false });
 }
 
 void RenderGraph::Read(oGFX::AllocatedBuffer& buffer)
@@ -122,6 +146,7 @@ void RenderGraph::Write(oGFX::AllocatedBuffer* buffer, ResourceUsage usage)
 
 	//ensure tracking buffer globally ??
 	passes[currentPass].bufferReg[buffer].expectedAccess = ResourceUsage::UAV;
+	passes[currentPass].accesses.push_back(RGAccess{ buffer, ResourceUsage::UAV, true, true, false });
 }
 
 void RenderGraph::Write(oGFX::AllocatedBuffer& buffer, ResourceUsage)
@@ -129,6 +154,152 @@ void RenderGraph::Write(oGFX::AllocatedBuffer& buffer, ResourceUsage)
 	Write(&buffer);
 }
 
+bool RenderGraph::IsTransient(const vkutils::Texture* texture) const
+{
+	return transients && transients->IsTransient(texture);
+}
+
+void RenderGraph::MarkOutput(vkutils::Texture& texture)
+{
+	m_outputs.push_back(&texture);
+}
+
+void RenderGraph::MarkOutput(oGFX::AllocatedBuffer& buffer)
+{
+	m_outputs.push_back(&buffer);
+}
+
+namespace
+{
+	// Stages and accesses of a usage mask, images also wait on the transfer and compute stages
+	// because the pass command lists move them in and out of their reference layout there.
+	void UsageToVk(uint32_t usages, bool write, bool buffer, bool depth, VkPipelineStageFlags& stages, VkAccessFlags& access)
+	{
+		stages = 0;
+		access = 0;
+		if (buffer == false)
+		{
+			stages |= VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+		}
+		else if (usages == 0)
+		{
+			// uploaded before the graph
+			stages |= VK_PIPELINE_STAGE_TRANSFER_BIT;
+			access |= write ? VK_ACCESS_TRANSFER_WRITE_BIT : 0;
+		}
+
+		constexpr VkPipelineStageFlags shaderStages = VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+		if (usages & (1u << SRV))
+		{
+			stages |= shaderStages;
+			access |= VK_ACCESS_SHADER_READ_BIT;
+			if (buffer)
+			{
+				// we do not know how the buffer is bound, cover indirect, index and vertex fetch as well
+				stages |= VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
+				access |= VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT;
+			}
+		}
+		if (usages & (1u << UAV))
+		{
+			stages |= shaderStages;
+			access |= VK_ACCESS_SHADER_READ_BIT | (write ? VK_ACCESS_SHADER_WRITE_BIT : 0);
+		}
+		if (usages & (1u << ATTACHMENT))
+		{
+			if (depth)
+			{
+				stages |= VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+				access |= VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | (write ? VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT : 0);
+			}
+			else
+			{
+				stages |= VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+				access |= VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | (write ? VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT : 0);
+			}
+		}
+	}
+}
+
+void RenderGraph::RecordBarriers(VkCommandBuffer cmd, const std::vector<RGBarrier>& barriers)
+{
+	if (barriers.empty())
+		return;
+
+	// everything the pass waits on goes into a single vkCmdPipelineBarrier
+	VkPipelineStageFlags srcStages = 0;
+	VkPipelineStageFlags dstStages = 0;
+	std::vector<VkBufferMemoryBarrier> bufferBarriers;
+	std::vector<VkImageMemoryBarrier> imageBarriers;
+	VkMemoryBarrier memoryBarrier{ VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+	for (const RGBarrier& b : barriers)
+	{
+		VkPipelineStageFlags srcStage, dstStage;
+		VkAccessFlags srcAccess, dstAccess;
+		UsageToVk(b.srcUsages, b.srcWrite, b.buffer, b.depth, srcStage, srcAccess);
+		UsageToVk(1u << b.dstUsage, b.dstWrite, b.buffer, b.depth, dstStage, dstAccess);
+		// write after read only has to wait for the readers, nothing to make visible
+		if (b.srcWrite == false)
+		{
+			srcAccess = 0;
+			dstAccess = 0;
+		}
+		srcStages |= srcStage;
+		dstStages |= dstStage;
+
+		if (b.buffer)
+		{
+			auto* buffer = static_cast<const oGFX::AllocatedBuffer*>(b.resource);
+			VkBufferMemoryBarrier& bmb = bufferBarriers.emplace_back(VkBufferMemoryBarrier{ VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER });
+			bmb.srcAccessMask = srcAccess;
+			bmb.dstAccessMask = dstAccess;
+			bmb.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			bmb.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			bmb.buffer = buffer->buffer;
+			bmb.offset = 0;
+			bmb.size = VK_WHOLE_SIZE;
+		}
+		else
+		{
+			auto* texture = static_cast<const vkutils::Texture*>(b.resource);
+			// passes leave their images in the reference layout, the layout changes stay with the command list
+			VkImageLayout oldLayout = texture->referenceLayout;
+			if (b.discard)
+			{
+				// the memory may have been written by any earlier pass through another transient
+				srcStages |= VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+				srcAccess = VK_ACCESS_MEMORY_WRITE_BIT;
+				oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			}
+			else if (texture->referenceLayout == VK_IMAGE_LAYOUT_UNDEFINED)
+			{
+				// no layout to name in an image barrier
+				memoryBarrier.srcAccessMask |= srcAccess;
+				memoryBarrier.dstAccessMask |= dstAccess;
+				continue;
+			}
+
+			VkImageMemoryBarrier& imb = imageBarriers.emplace_back(oGFX::vkutils::inits::imageMemoryBarrier());
+			imb.srcAccessMask = srcAccess;
+			imb.dstAccessMask = dstAccess;
+			imb.oldLayout = oldLayout;
+			imb.newLayout = texture->referenceLayout;
+			imb.image = texture->image.image;
+			imb.subresourceRange.aspectMask = b.depth ? VK_IMAGE_ASPECT_DEPTH_BIT : VK_IMAGE_ASPECT_COLOR_BIT;
+			imb.subresourceRange.baseMipLevel = 0;
+			imb.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+			imb.subresourceRange.baseArrayLayer = 0;
+			imb.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
+		}
+	}
+
+	const uint32_t numMemoryBarriers = (memoryBarrier.srcAccessMask | memoryBarrier.dstAccessMask) ? 1 : 0;
+	vkCmdPipelineBarrier(cmd, srcStages, dstStages, 0,
+		numMemoryBarriers, &memoryBarrier,
+		static_cast<uint32_t>(bufferBarriers.size()), bufferBarriers.data(),
+		static_cast<uint32_t>(imageBarriers.size()), imageBarriers.data());
+}
+
 void RenderGraph::DumpPassDependencies()
 {
 	printf("=============\n");
@@ -183,6 +354,28 @@ void RenderGraph::DumpPassDependencies()
 			printf("\t  Buf[%s] requested : %s\n", kvp.first->name.c_str(), state);
 		}
 	}
+	if (m_isCompiled)
+	{
+		printf("-------------\n");
+		for (uint32_t i = 0; i < passes.size(); ++i)
+		{
+			if (m_compiled.culled[i])
+			{
+				printf("Pass %s culled\n", passes[i].name.c_str());
+				continue;
+			}
+			const uint32_t numBarriers = m_compiled.barrierBegin[i + 1] - m_compiled.barrierBegin[i];
+			printf("Pass %s level %u waits on %u resources\n", passes[i].name.c_str(), m_compiled.level[i], numBarriers);
+			for (uint32_t b = m_compiled.barrierBegin[i]; b < m_compiled.barrierBegin[i + 1]; ++b)
+			{
+				const RGBarrier& barrier = m_compiled.barriers[b];
+				const char* resName = barrier.buffer ? static_cast<const oGFX::AllocatedBuffer*>(barrier.resource)->name.c_str()
+					: static_cast<const vkutils::Texture*>(barrier.resource)->name.c_str();
+				const char* srcName = barrier.discard ? "discard" : barrier.srcPass == RGBarrier::EXTERNAL ? "upload" : passes[barrier.srcPass].name.c_str();
+				printf("\t  %s[%s] after %s %s\n", barrier.buffer ? "Buf" : "Tex", resName, srcName, barrier.srcWrite ? "write" : "read");
+			}
+		}
+	}
 	printf("=============\n");
 	printf("\n");
 }
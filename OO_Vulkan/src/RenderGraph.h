@@ -19,6 +19,8 @@ Technology is prohibited.
 #include "VulkanDevice.h"
 #include "VulkanTexture.h"
 #include "RGResource.h"
+#include "RenderGraphCompiler.h"
+#include "RGTransientPool.h"
 #include "rhi/CommandList.h"
 
 OO_OPTIMIZE_OFF
@@ -29,6 +31,7 @@ class GfxRenderpass;
 	public:
 		std::string name{}; // maybe remove when not debug?
 		VulkanDevice* device{ nullptr };
+		RGTransientPool* transients{ nullptr };
 		RenderGraph();
 
 		void AddPass(GfxRenderpass* pass);
@@ -52,6 +55,13 @@ class GfxRenderpass;
 		void Read(oGFX::AllocatedBuffer* buffer);
 		void Read(oGFX::AllocatedBuffer& buffer);
 
+		// Used after the graph (presented, copied back), passes writing these are never culled
+		void MarkOutput(vkutils::Texture& texture);
+		void MarkOutput(oGFX::AllocatedBuffer& buffer);
+
+		const RGCompileResult& GetCompileResult() const { return m_compiled; }
+		const std::vector<RGPassDesc>& GetPassDescs() const { return m_passDescs; }
+
 		void DumpPassDependencies();
 
 		RGTextureRef RegisterExternalTexture(vkutils::Texture& texture);
@@ -65,13 +75,23 @@ class GfxRenderpass;
 
 			TextureRegistry textureReg;
 			BufferRegistry bufferReg;
+
+			std::vector<RGAccess> accesses;
 		};
 
+		bool IsTransient(const vkutils::Texture* texture) const;
+		static void RecordBarriers(VkCommandBuffer cmd, const std::vector<RGBarrier>& barriers);
+
 		std::vector<PassInfo> passes;
 		std::vector<std::shared_ptr<RGTexture>> textures;
 
 		uint32_t currentPass = 0;
 
+		std::vector<const void*> m_outputs;
+		std::vector<RGPassDesc> m_passDescs;
+		RGCompileResult m_compiled;
+		bool m_isCompiled{ false };
+
 		std::vector<TextureRegistry>m_trackedTextures;
 
 		//std::unordered_map<VkBuffer, BufferStateTracking> m_trackedBuffers;
@@ -0,0 +1,337 @@
+/************************************************************************************//*!
+\file           RenderGraphCompiler.cpp
+\project        Ouroboros
+\author         Jamie Kong, j.kong, 390004720 | code contribution (100%)
+\par            email: j.kong\@digipen.edu
+\date           May 02, 2024
+\brief              Defines the device free part of the render graph compile, pass order, culling, barriers and transient aliasing
+
+Copyright (C) 2022 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents
+without the prior written consent of DigiPen Institute of
+Technology is prohibited.
+*//*************************************************************************************/
+#include "RenderGraphCompiler.h"
+
+#include <algorithm>
+#include <numeric>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace
+{
+	constexpr int32_t NO_WRITER = -2;
+
+	uint32_t UsageBit(ResourceUsage usage)
+	{
+		return 1u << static_cast<uint32_t>(usage);
+	}
+
+	// a pass declaring the same resource more than once touches it once, any write makes it a write
+	std::vector<RGAccess> MergeAccesses(const std::vector<RGAccess>& accesses)
+	{
+		std::vector<RGAccess> merged;
+		merged.reserve(accesses.size());
+		for (const RGAccess& a : accesses)
+		{
+			auto it = std::find_if(merged.begin(), merged.end(), [&a](const RGAccess& m) { return m.resource == a.resource; });
+			if (it == merged.end())
+			{
+				merged.push_back(a);
+			}
+			else if (a.write && it->write == false)
+			{
+				it->write = true;
+				it->usage = a.usage;
+			}
+		}
+		return merged;
+	}
+}
+
+RGCompileResult RGCompile(const std::vector<RGPassDesc>& passes, const std::vector<const void*>& outputs)
+{
+	const uint32_t numPasses = static_cast<uint32_t>(passes.size());
+
+	std::vector<std::vector<RGAccess>> accesses(numPasses);
+	for (uint32_t p = 0; p < numPasses; ++p)
+	{
+		accesses[p] = MergeAccesses(passes[p].accesses);
+	}
+
+	// first sweep, who produces what each pass consumes
+	struct ProducerState
+	{
+		int32_t writer{ NO_WRITER };
+		bool readBeforeWrite{ false };
+	};
+	std::unordered_map<const void*, ProducerState> producers;
+	std::vector<std::vector<uint32_t>> producedBy(numPasses);
+	for (uint32_t p = 0; p < numPasses; ++p)
+	{
+		for (const RGAccess& a : accesses[p])
+		{
+			ProducerState& s = producers[a.resource];
+			if (s.writer >= 0)
+			{
+				producedBy[p].push_back(s.writer);
+			}
+			else if (a.write == false)
+			{
+				s.readBeforeWrite = true;
+			}
+			if (a.write)
+			{
+				s.writer = static_cast<int32_t>(p);
+			}
+		}
+	}
+
+	// walk back from the passes that have to run
+	const std::unordered_set<const void*> outputSet(outputs.begin(), outputs.end());
+	std::vector<bool> live(numPasses, false);
+	for (uint32_t p = 0; p < numPasses; ++p)
+	{
+		bool writes = false;
+		for (const RGAccess& a : accesses[p])
+		{
+			if (a.write == false) continue;
+			writes = true;
+			if (outputSet.count(a.resource) || producers[a.resource].readBeforeWrite)
+			{
+				live[p] = true;
+			}
+		}
+		// nothing declared, the pass has effects we cannot see
+		live[p] = live[p] || writes == false;
+	}
+	for (uint32_t p = numPasses; p-- > 0;)
+	{
+		if (live[p] == false) continue;
+		for (uint32_t dep : producedBy[p])
+		{
+			live[dep] = true;
+		}
+	}
+
+	RGCompileResult result;
+	result.culled.resize(numPasses);
+	result.level.assign(numPasses, 0);
+	result.barrierBegin.assign(numPasses + 1, 0);
+
+	// second sweep over what survived, the barriers and dependency levels
+	struct SyncState
+	{
+		int32_t writer{ NO_WRITER };
+		uint32_t writerUsages{};
+		uint32_t syncedReads{};		// read usages that already waited on the last write
+		uint32_t readerUsages{};
+		std::vector<uint32_t> readers;
+	};
+	std::unordered_map<const void*, SyncState> states;
+
+	uint32_t maxLevel = 0;
+	for (uint32_t p = 0; p < numPasses; ++p)
+	{
+		result.culled[p] = live[p] == false;
+		result.barrierBegin[p] = static_cast<uint32_t>(result.barriers.size());
+		if (result.culled[p]) continue;
+		result.order.push_back(p);
+
+		uint32_t& level = result.level[p];
+		auto dependOn = [&result, &level](int32_t src) {
+			if (src >= 0) level = std::max(level, result.level[src] + 1);
+		};
+
+		for (const RGAccess& a : accesses[p])
+		{
+			auto it = states.find(a.resource);
+			RGBarrier barrier;
+			barrier.resource = a.resource;
+			barrier.dstPass = p;
+			barrier.dstUsage = a.usage;
+			barrier.dstWrite = a.write;
+			barrier.buffer = a.buffer;
+			barrier.depth = a.depth;
+
+			if (it == states.end())
+			{
+				it = states.emplace(a.resource, SyncState{}).first;
+				if (a.transient)
+				{
+					// another transient may have used the memory, nothing before this is worth keeping
+					barrier.srcWrite = true;
+					barrier.discard = true;
+					result.barriers.push_back(barrier);
+					barrier.discard = false;
+				}
+				else if (a.buffer)
+				{
+					// uploaded before the graph runs
+					it->second.writer = RGBarrier::EXTERNAL;
+				}
+			}
+			SyncState& s = it->second;
+
+			if (a.write == false)
+			{
+				if (s.writer != NO_WRITER)
+				{
+					dependOn(s.writer);
+					// an earlier reader with the same usage already made the write visible to us
+					if ((s.syncedReads & UsageBit(a.usage)) == 0)
+					{
+						barrier.srcPass = s.writer;
+						barrier.srcUsages = s.writerUsages;
+						barrier.srcWrite = true;
+						result.barriers.push_back(barrier);
+						s.syncedReads |= UsageBit(a.usage);
+					}
+				}
+				s.readers.push_back(p);
+				s.readerUsages |= UsageBit(a.usage);
+				continue;
+			}
+
+			if (s.readers.empty() == false)
+			{
+				// the readers already waited on the previous write, only wait for them to finish
+				for (uint32_t r : s.readers)
+				{
+					dependOn(static_cast<int32_t>(r));
+				}
+				barrier.srcPass = static_cast<int32_t>(s.readers.back());
+				barrier.srcUsages = s.readerUsages;
+				barrier.srcWrite = false;
+				result.barriers.push_back(barrier);
+			}
+			else if (s.writer != NO_WRITER)
+			{
+				dependOn(s.writer);
+				barrier.srcPass = s.writer;
+				barrier.srcUsages = s.writerUsages;
+				barrier.srcWrite = true;
+				result.barriers.push_back(barrier);
+			}
+
+			s.writer = static_cast<int32_t>(p);
+			s.writerUsages = UsageBit(a.usage);
+			s.syncedReads = 0;
+			s.readerUsages = 0;
+			s.readers.clear();
+		}
+		maxLevel = std::max(maxLevel, level);
+	}
+	result.barrierBegin[numPasses] = static_cast<uint32_t>(result.barriers.size());
+
+	if (result.order.empty() == false)
+	{
+		result.groups.resize(maxLevel + 1);
+		for (uint32_t p : result.order)
+		{
+			result.groups[result.level[p]].push_back(p);
+		}
+	}
+	return result;
+}
+
+void RGComputeLifetimes(const std::vector<RGPassDesc>& passes, const RGCompileResult& compiled,
+	const std::vector<const void*>& resources, uint32_t firstStep, std::vector<RGLifetime>& lifetimes)
+{
+	lifetimes.resize(resources.size());
+
+	std::unordered_map<const void*, size_t> index;
+	for (size_t i = 0; i < resources.size(); ++i)
+	{
+		index.emplace(resources[i], i);
+	}
+
+	constexpr uint32_t NONE = ~0u;
+	std::vector<uint32_t> first(resources.size(), NONE);
+	std::vector<uint32_t> last(resources.size(), NONE);
+	for (uint32_t step = 0; step < compiled.order.size(); ++step)
+	{
+		for (const RGAccess& a : passes[compiled.order[step]].accesses)
+		{
+			auto it = index.find(a.resource);
+			if (it == index.end()) continue;
+			if (first[it->second] == NONE) first[it->second] = step;
+			last[it->second] = step;
+		}
+	}
+
+	for (size_t i = 0; i < resources.size(); ++i)
+	{
+		if (first[i] == NONE) continue;
+		for (uint32_t step = first[i]; step <= last[i] && firstStep + step < RG_MAX_TIMELINE; ++step)
+		{
+			lifetimes[i].set(firstStep + step);
+		}
+	}
+}
+
+namespace
+{
+	uint64_t AlignUp(uint64_t v, uint64_t alignment)
+	{
+		return (v + alignment - 1) / alignment * alignment;
+	}
+}
+
+RGAliasLayout RGPackAliases(const std::vector<RGAliasRequest>& requests)
+{
+	RGAliasLayout layout;
+	layout.offsets.assign(requests.size(), 0);
+
+	std::vector<size_t> bySize(requests.size());
+	std::iota(bySize.begin(), bySize.end(), size_t(0));
+	std::stable_sort(bySize.begin(), bySize.end(), [&requests](size_t a, size_t b) { return requests[a].size > requests[b].size; });
+
+	std::vector<size_t> placed;
+	std::vector<size_t> overlapping;
+	placed.reserve(requests.size());
+	for (size_t i : bySize)
+	{
+		const RGAliasRequest& r = requests[i];
+		layout.unaliasedSize = AlignUp(layout.unaliasedSize, r.alignment) + r.size;
+
+		overlapping.clear();
+		for (size_t j : placed)
+		{
+			if ((requests[j].lifetime & r.lifetime).any()) overlapping.push_back(j);
+		}
+		std::sort(overlapping.begin(), overlapping.end(), [&layout](size_t a, size_t b) { return layout.offsets[a] < layout.offsets[b]; });
+
+		// first gap between the ranges of what is alive at the same time
+		uint64_t offset = 0;
+		for (size_t j : overlapping)
+		{
+			if (offset + r.size <= layout.offsets[j]) break;
+			offset = std::max(offset, AlignUp(layout.offsets[j] + requests[j].size, r.alignment));
+		}
+
+		layout.offsets[i] = offset;
+		layout.heapSize = std::max(layout.heapSize, offset + r.size);
+		placed.push_back(i);
+	}
+	return layout;
+}
+
+bool RGAliasLayoutValid(const std::vector<RGAliasRequest>& requests, const RGAliasLayout& layout)
+{
+	if (layout.offsets.size() != requests.size())
+		return false;
+
+	for (size_t i = 0; i < requests.size(); ++i)
+	{
+		if (layout.offsets[i] % requests[i].alignment || layout.offsets[i] + requests[i].size > layout.heapSize)
+			return false;
+		for (size_t j = i + 1; j < requests.size(); ++j)
+		{
+			const bool sharesMemory = layout.offsets[i] < layout.offsets[j] + requests[j].size && layout.offsets[j] < layout.offsets[i] + requests[i].size;
+			if (sharesMemory && (requests[i].lifetime & requests[j].lifetime).any())
+				return false;
+		}
+	}
+	return true;
+}
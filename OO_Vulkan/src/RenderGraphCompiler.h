@@ -0,0 +1,100 @@
+/************************************************************************************//*!
+\file           RenderGraphCompiler.h
+\project        Ouroboros
+\author         Jamie Kong, j.kong, 390004720 | code contribution (100%)
+\par            email: j.kong\@digipen.edu
+\date           May 02, 2024
+\brief              Declares the device free part of the render graph compile, pass order, culling, barriers and transient aliasing
+
+Copyright (C) 2022 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents
+without the prior written consent of DigiPen Institute of
+Technology is prohibited.
+*//*************************************************************************************/
+#pragma once
+
+#include <bitset>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "RGResource.h"
+
+// One resource a pass touches, the key is whatever identifies the resource (texture or buffer pointer)
+struct RGAccess
+{
+	const void* resource{ nullptr };
+	ResourceUsage usage{ UNKNOWN };
+	bool write{ false };
+	bool buffer{ false };
+	bool depth{ false };
+	bool transient{ false };	// contents do not survive between frames, the memory is shared with other transients
+};
+
+struct RGPassDesc
+{
+	std::string name;
+	std::vector<RGAccess> accesses;
+};
+
+// Dependency a pass has to wait on before it starts.
+// srcUsages is a mask of (1 << ResourceUsage), a write after read only needs an execution dependency so srcWrite is false.
+struct RGBarrier
+{
+	static constexpr int32_t EXTERNAL = -1; // buffers are uploaded by the transfer commands before the graph
+
+	const void* resource{ nullptr };
+	int32_t srcPass{ EXTERNAL };
+	uint32_t dstPass{};
+	uint32_t srcUsages{};
+	bool srcWrite{ false };
+	ResourceUsage dstUsage{ UNKNOWN };
+	bool dstWrite{ false };
+	bool buffer{ false };
+	bool depth{ false };
+	bool discard{ false };	// first use of a transient this frame, whatever was in its memory before is thrown away
+};
+
+struct RGCompileResult
+{
+	std::vector<uint32_t> order;			// live passes in submission order
+	std::vector<bool> culled;				// per pass, nothing live reads what it writes
+	std::vector<uint32_t> level;			// per pass, longest chain of dependencies leading to it
+	std::vector<std::vector<uint32_t>> groups;	// live passes per level, passes in a group do not depend on each other
+	std::vector<RGBarrier> barriers;		// grouped by dstPass in submission order
+	std::vector<uint32_t> barrierBegin;		// barriers of pass i are [barrierBegin[i], barrierBegin[i+1])
+};
+
+// Builds the dependency graph from the declared reads and writes.
+// Passes without writes, passes writing an output and passes writing a resource that is read before it is written
+// (history carried over from the last frame) are kept, every pass they depend on is kept with them.
+// A write is treated as read-modify-write, so an earlier writer of the same resource stays alive.
+RGCompileResult RGCompile(const std::vector<RGPassDesc>& passes, const std::vector<const void*>& outputs);
+
+// Steps of a timeline a transient is alive in. Every pass list the renderer has used gets its own range of steps,
+// so two transients may only share memory when they are never alive at the same time in any of them.
+constexpr uint32_t RG_MAX_TIMELINE = 256;
+using RGLifetime = std::bitset<RG_MAX_TIMELINE>;
+
+// Marks the steps from the first to the last live pass touching each resource, step 0 is firstStep
+void RGComputeLifetimes(const std::vector<RGPassDesc>& passes, const RGCompileResult& compiled,
+	const std::vector<const void*>& resources, uint32_t firstStep, std::vector<RGLifetime>& lifetimes);
+
+struct RGAliasRequest
+{
+	uint64_t size{};
+	uint64_t alignment{ 1 };
+	RGLifetime lifetime;
+};
+
+struct RGAliasLayout
+{
+	std::vector<uint64_t> offsets;	// per request
+	uint64_t heapSize{};			// memory needed with aliasing
+	uint64_t unaliasedSize{};		// memory needed when every request has its own
+};
+
+// Places the largest requests first, each at the lowest offset not used by a request alive at the same time
+RGAliasLayout RGPackAliases(const std::vector<RGAliasRequest>& requests);
+
+// False when two requests sharing memory are alive at the same time
+bool RGAliasLayoutValid(const std::vector<RGAliasRequest>& requests, const RGAliasLayout& layout);
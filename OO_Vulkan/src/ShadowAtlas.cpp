@@ -0,0 +1,328 @@
+/************************************************************************************//*!
+\file           ShadowAtlas.cpp
+\project        Ouroboros
+\author         Jamie Kong, j.kong, 390004720 | code contribution (100%)
+\par            email: j.kong\@digipen.edu
+\date           May 02, 2024
+\brief              Defines the shadow atlas, a quadtree of power of two tiles handed out per light face and kept across frames
+
+Copyright (C) 2022 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents
+without the prior written consent of DigiPen Institute of
+Technology is prohibited.
+*//*************************************************************************************/
+#include "ShadowAtlas.h"
+#include "UtilCommon.h"
+
+#include <algorithm>
+
+namespace oGFX
+{
+
+namespace
+{
+	uint32_t NextPowerOfTwo(uint32_t v)
+	{
+		uint32_t p = 1;
+		while (p < v) p <<= 1;
+		return p;
+	}
+
+	uint32_t Log2(uint32_t v)
+	{
+		uint32_t r = 0;
+		while (v >>= 1) ++r;
+		return r;
+	}
+}
+
+void ShadowAtlasAllocator::Init(uint32_t atlasSize, uint32_t minTileSize)
+{
+	OO_ASSERT(atlasSize && (atlasSize & (atlasSize - 1)) == 0);
+	OO_ASSERT(minTileSize && (minTileSize & (minTileSize - 1)) == 0 && minTileSize <= atlasSize);
+	m_atlasSize = atlasSize;
+	m_minTileSize = minTileSize;
+	m_numLevels = Log2(atlasSize / minTileSize) + 1;
+
+	// complete quadtree, 1 + 4 + 16 + ... nodes
+	uint32_t numNodes = 0;
+	for (uint32_t level = 0, count = 1; level < m_numLevels; ++level, count *= 4)
+	{
+		numNodes += count;
+	}
+	m_nodes.resize(numNodes);
+	Clear();
+}
+
+void ShadowAtlasAllocator::Clear()
+{
+	std::fill(m_nodes.begin(), m_nodes.end(), static_cast<uint8_t>(FREE));
+	m_usedArea = 0;
+}
+
+bool ShadowAtlasAllocator::Allocate(uint32_t size, Tile& out)
+{
+	size = std::max(NextPowerOfTwo(size), m_minTileSize);
+	if (size > m_atlasSize)
+		return false;
+
+	const uint32_t targetLevel = Log2(m_atlasSize / size);
+	uint32_t node = INVALID_NODE;
+	uint32_t level = 0;
+	FindFreeNode(0, 0, targetLevel, node, level);
+	if (node == INVALID_NODE)
+		return false;
+
+	// split the smallest free tile we found down to the size asked for
+	while (level < targetLevel)
+	{
+		m_nodes[node] = SPLIT;
+		node = 4 * node + 1;
+		++level;
+	}
+	m_nodes[node] = USED;
+	m_usedArea += uint64_t(size) * size;
+	out = TileOf(node);
+	return true;
+}
+
+void ShadowAtlasAllocator::Free(Tile& tile)
+{
+	if (tile.IsValid() == false)
+		return;
+	OO_ASSERT(tile.node < m_nodes.size() && m_nodes[tile.node] == USED);
+
+	m_nodes[tile.node] = FREE;
+	m_usedArea -= uint64_t(tile.size) * tile.size;
+
+	// merge back up while all four siblings are free
+	uint32_t node = tile.node;
+	while (node != 0)
+	{
+		const uint32_t parent = (node - 1) / 4;
+		const uint32_t first = 4 * parent + 1;
+		if (m_nodes[first] != FREE || m_nodes[first + 1] != FREE || m_nodes[first + 2] != FREE || m_nodes[first + 3] != FREE)
+			break;
+		m_nodes[parent] = FREE;
+		node = parent;
+	}
+	tile = Tile{};
+}
+
+void ShadowAtlasAllocator::FindFreeNode(uint32_t node, uint32_t level, uint32_t targetLevel, uint32_t& best, uint32_t& bestLevel) const
+{
+	// an exact fit cannot be beaten
+	if (best != INVALID_NODE && bestLevel == targetLevel)
+		return;
+
+	switch (m_nodes[node])
+	{
+	case FREE:
+		// prefer the deepest free tile so large tiles are only split when nothing smaller is left
+		if (best == INVALID_NODE || level > bestLevel)
+		{
+			best = node;
+			bestLevel = level;
+		}
+		break;
+	case SPLIT:
+		if (level < targetLevel)
+		{
+			for (uint32_t c = 1; c <= 4; ++c)
+			{
+				FindFreeNode(4 * node + c, level + 1, targetLevel, best, bestLevel);
+			}
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+ShadowAtlasAllocator::Tile ShadowAtlasAllocator::TileOf(uint32_t node) const
+{
+	Tile t;
+	t.node = node;
+
+	uint32_t level = 0;
+	for (uint32_t n = node; n != 0; n = (n - 1) / 4)
+	{
+		++level;
+	}
+	t.size = m_atlasSize >> level;
+
+	// walk back up, each child index picks a quadrant of its parent
+	uint32_t depth = level;
+	for (uint32_t n = node; n != 0; n = (n - 1) / 4, --depth)
+	{
+		const uint32_t child = (n - 1) % 4;
+		const uint32_t half = m_atlasSize >> depth;
+		t.x += (child & 1) * half;
+		t.y += (child >> 1) * half;
+	}
+	return t;
+}
+
+void ShadowAtlas::Init(uint32_t atlasSize, uint32_t minTileSize, uint32_t maxTileSize)
+{
+	m_allocator.Init(atlasSize, minTileSize);
+	m_maxTileSize = std::clamp(maxTileSize, minTileSize, atlasSize);
+	m_lights.clear();
+}
+
+void ShadowAtlas::Update(const std::vector<Request>& requests, std::vector<Light*>& out)
+{
+	auto find = [this](uint32_t id) -> Light* {
+		for (Light& l : m_lights)
+		{
+			if (l.id == id) return &l;
+		}
+		return nullptr;
+	};
+
+	for (Light& l : m_lights)
+	{
+		l.seen = false;
+	}
+	for (const Request& r : requests)
+	{
+		if (Light* l = find(r.lightID)) l->seen = true;
+	}
+
+	// lights that are gone or culled give their tiles back before anyone asks for new ones
+	for (size_t i = 0; i < m_lights.size();)
+	{
+		if (m_lights[i].seen == false)
+		{
+			Release(m_lights[i]);
+			m_lights[i] = m_lights.back();
+			m_lights.pop_back();
+		}
+		else
+		{
+			++i;
+		}
+	}
+
+	// no reallocation below, the pointers handed out stay valid until the next update
+	m_lights.reserve(m_lights.size() + requests.size());
+	out.assign(requests.size(), nullptr);
+
+	const uint32_t minTile = m_allocator.MinTileSize();
+	auto tryAllocate = [this](Light& light, uint32_t numFaces, uint32_t size) {
+		Tile tiles[MAX_FACES];
+		for (uint32_t f = 0; f < numFaces; ++f)
+		{
+			if (m_allocator.Allocate(size, tiles[f]) == false)
+			{
+				for (uint32_t i = 0; i < f; ++i)
+				{
+					m_allocator.Free(tiles[i]);
+				}
+				return false;
+			}
+		}
+		// only let go of the old tiles once the new ones are in hand
+		Release(light);
+		light.numFaces = numFaces;
+		light.size = size;
+		for (uint32_t f = 0; f < numFaces; ++f)
+		{
+			light.faces[f].tile = tiles[f];
+		}
+		return true;
+	};
+
+	for (size_t i = 0; i < requests.size(); ++i)
+	{
+		const Request& r = requests[i];
+		OO_ASSERT(r.numFaces > 0 && r.numFaces <= MAX_FACES);
+		const uint32_t wanted = std::clamp(NextPowerOfTwo(r.desiredSize), minTile, m_maxTileSize);
+
+		Light* light = find(r.lightID);
+		if (light == nullptr)
+		{
+			light = &m_lights.emplace_back();
+			light->id = r.lightID;
+			light->seen = true;
+		}
+		if (light->numFaces != r.numFaces)
+		{
+			Release(*light);
+		}
+
+		if (wanted > light->size)
+		{
+			// step down until something fits, a light that already has tiles keeps them when nothing larger does
+			for (uint32_t size = wanted; size > light->size && size >= minTile; size >>= 1)
+			{
+				if (tryAllocate(*light, r.numFaces, size)) break;
+			}
+		}
+		else if (wanted * 2 < light->size)
+		{
+			// one level of slack so a light sitting on the boundary does not flip between sizes,
+			// the smaller tiles always fit in the space given back
+			Release(*light);
+			tryAllocate(*light, r.numFaces, wanted);
+		}
+
+		out[i] = light->size ? light : nullptr;
+	}
+}
+
+bool ShadowAtlas::UpdateFace(Face& face, uint64_t contentHash, uint32_t newestCasterGeneration, bool animatedCaster, uint32_t generation)
+{
+	const bool dirty = face.valid == false
+		|| face.contentHash != contentHash
+		|| newestCasterGeneration > face.renderedGeneration
+		|| animatedCaster;
+
+	face.valid = true;
+	face.dirty = dirty;
+	face.contentHash = contentHash;
+	face.renderedGeneration = generation;
+	return dirty;
+}
+
+void ShadowAtlas::Invalidate()
+{
+	for (Light& l : m_lights)
+	{
+		for (Face& f : l.faces)
+		{
+			f.valid = false;
+		}
+	}
+}
+
+uint32_t ShadowAtlas::SizeForCoverage(float radius, float distance, float tanHalfFov, uint32_t screenHeight, uint32_t minSize, uint32_t maxSize)
+{
+	// fraction of the screen height the sphere of influence spans, the whole screen once the camera is inside it
+	float coverage = 1.0f;
+	if (distance > radius && tanHalfFov > 0.0f)
+	{
+		coverage = std::min(1.0f, radius / (distance * tanHalfFov));
+	}
+
+	const float pixels = coverage * static_cast<float>(screenHeight);
+	uint32_t size = minSize;
+	while (static_cast<float>(size) < pixels && size < maxSize)
+	{
+		size <<= 1;
+	}
+	return size;
+}
+
+void ShadowAtlas::Release(Light& light)
+{
+	for (Face& f : light.faces)
+	{
+		m_allocator.Free(f.tile);
+		f = Face{};
+	}
+	light.size = 0;
+	light.numFaces = 0;
+}
+
+}
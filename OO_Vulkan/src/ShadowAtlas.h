@@ -0,0 +1,128 @@
+/************************************************************************************//*!
+\file           ShadowAtlas.h
+\project        Ouroboros
+\author         Jamie Kong, j.kong, 390004720 | code contribution (100%)
+\par            email: j.kong\@digipen.edu
+\date           May 02, 2024
+\brief              Declares the shadow atlas, a quadtree of power of two tiles handed out per light face and kept across frames
+
+Copyright (C) 2022 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents
+without the prior written consent of DigiPen Institute of
+Technology is prohibited.
+*//*************************************************************************************/
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace oGFX
+{
+
+// Quadtree over a square atlas, every node is a power of two tile that is either free, split into 4 or in use
+class ShadowAtlasAllocator
+{
+public:
+	static constexpr uint32_t INVALID_NODE = ~0u;
+
+	struct Tile
+	{
+		uint32_t x{};
+		uint32_t y{};
+		uint32_t size{};
+		uint32_t node{ INVALID_NODE };
+
+		bool IsValid() const { return node != INVALID_NODE; }
+	};
+
+	void Init(uint32_t atlasSize, uint32_t minTileSize);
+	void Clear();
+
+	// Size is rounded up to a power of two, returns false when no tile of that size is left
+	bool Allocate(uint32_t size, Tile& out);
+	void Free(Tile& tile);
+
+	uint32_t AtlasSize() const { return m_atlasSize; }
+	uint32_t MinTileSize() const { return m_minTileSize; }
+	uint64_t UsedArea() const { return m_usedArea; }
+
+private:
+	enum NodeState : uint8_t
+	{
+		FREE,
+		SPLIT,
+		USED,
+	};
+
+	// children of node n are 4n+1 to 4n+4
+	void FindFreeNode(uint32_t node, uint32_t level, uint32_t targetLevel, uint32_t& best, uint32_t& bestLevel) const;
+	Tile TileOf(uint32_t node) const;
+
+	std::vector<uint8_t> m_nodes;
+	uint32_t m_atlasSize{};
+	uint32_t m_minTileSize{};
+	uint32_t m_numLevels{};
+	uint64_t m_usedArea{};
+};
+
+// Hands out tiles to the shadow casting lights and remembers what each tile was last rendered with,
+// so faces whose light and casters have not changed keep their depth from the previous frames.
+class ShadowAtlas
+{
+public:
+	using Tile = ShadowAtlasAllocator::Tile;
+	static constexpr uint32_t MAX_FACES = 6;
+
+	struct Face
+	{
+		Tile tile;
+		uint64_t contentHash{};			// light transform and the casters it saw
+		uint32_t renderedGeneration{};	// snapshot generation the tile was last rendered in
+		bool valid{ false };			// tile holds the depth of a previous render
+		bool dirty{ true };				// has to be rendered this frame
+	};
+
+	struct Light
+	{
+		uint32_t id{};
+		uint32_t numFaces{};
+		uint32_t size{};
+		Face faces[MAX_FACES];
+		bool seen{ false };
+	};
+
+	struct Request
+	{
+		uint32_t lightID{};
+		uint32_t numFaces{};
+		uint32_t desiredSize{};
+	};
+
+	void Init(uint32_t atlasSize, uint32_t minTileSize, uint32_t maxTileSize);
+
+	// Requests are sorted by priority, the first ones get their tiles first.
+	// Lights that are not requested give their tiles back. out[i] is null when request i did not fit at all.
+	void Update(const std::vector<Request>& requests, std::vector<Light*>& out);
+
+	// Decides whether a face has to be rendered again and remembers the state it is rendered with.
+	// newestCasterGeneration is the highest dirty generation among the casters the face sees.
+	static bool UpdateFace(Face& face, uint64_t contentHash, uint32_t newestCasterGeneration, bool animatedCaster, uint32_t generation);
+
+	// Forget the content of every tile, call when the atlas was not rendered after an Update
+	void Invalidate();
+
+	// Face resolution from how large the light's sphere of influence is on screen
+	static uint32_t SizeForCoverage(float radius, float distance, float tanHalfFov, uint32_t screenHeight, uint32_t minSize, uint32_t maxSize);
+
+	const ShadowAtlasAllocator& Allocator() const { return m_allocator; }
+	size_t NumLights() const { return m_lights.size(); }
+
+private:
+	void Release(Light& light);
+
+	ShadowAtlasAllocator m_allocator;
+	std::vector<Light> m_lights;
+	uint32_t m_maxTileSize{};
+};
+
+}
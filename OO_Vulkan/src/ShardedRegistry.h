@@ -0,0 +1,249 @@
+/************************************************************************************//*!
+\file           ShardedRegistry.h
+\project        Ouroboros
+\author         Jamie Kong, j.kong, 390004720 | code contribution (100%)
+\par            email: j.kong\@digipen.edu
+\date           May 13, 2024
+\brief              Declares a hash to handle registry that recording threads share, lock free lookups and one build per key
+
+Copyright (C) 2022 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents
+without the prior written consent of DigiPen Institute of
+Technology is prohibited.
+*//*************************************************************************************/
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// Values are only ever added, so a hit reads the table without taking a lock.
+// A miss locks one of the shards, a key that is already being built is waited on instead of built again.
+// T is a handle, a value-initialised T means empty and is never stored.
+template <typename T>
+class ShardedRegistry
+{
+public:
+	static constexpr size_t NUM_SHARDS = 16;
+	static constexpr size_t INITIAL_CAPACITY = 32; // per shard, power of two
+
+	struct Stats
+	{
+		uint64_t builds{};
+		uint64_t waits{};	// found another thread building the same key
+	};
+
+	ShardedRegistry() = default;
+	ShardedRegistry(const ShardedRegistry&) = delete;
+	ShardedRegistry& operator=(const ShardedRegistry&) = delete;
+
+	// Lock free, returns T{} when the key has not been built
+	T Find(size_t key) const
+	{
+		const Table* table = m_shards[ShardOf(key)].table.load(std::memory_order_acquire);
+		return table ? table->Find(key) : T{};
+	}
+
+	// Returns the value of key, calling build() if no thread has built it yet. Safe to call from any thread.
+	// built is set when this call did the building.
+	template <typename F>
+	T GetOrBuild(size_t key, F&& build, bool* built = nullptr)
+	{
+		if (built) *built = false;
+		if (T found = Find(key); found != T{})
+			return found;
+
+		Shard& shard = m_shards[ShardOf(key)];
+		std::promise<T> promise;
+		{
+			std::unique_lock<std::mutex> lock(shard.lock);
+			// added between the lookup and the lock
+			if (T found = Find(key); found != T{})
+				return found;
+
+			auto iter = shard.inFlight.find(key);
+			if (iter != shard.inFlight.end())
+			{
+				std::shared_future<T> pending = iter->second;
+				lock.unlock();
+				m_waits.fetch_add(1, std::memory_order_relaxed);
+				return pending.get();
+			}
+			shard.inFlight.emplace(key, promise.get_future().share());
+		}
+
+		// built without the lock, other keys in this shard carry on
+		T value{};
+		try
+		{
+			value = build();
+		}
+		catch (...)
+		{
+			std::lock_guard<std::mutex> lock(shard.lock);
+			shard.inFlight.erase(key);
+			promise.set_exception(std::current_exception());
+			throw;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(shard.lock);
+			if (value != T{})
+			{
+				Insert(shard, key, value);
+			}
+			shard.inFlight.erase(key);
+		}
+		promise.set_value(value);
+		m_builds.fetch_add(1, std::memory_order_relaxed);
+		if (built) *built = true;
+		return value;
+	}
+
+	// Not safe with concurrent builds, for shutdown
+	template <typename F>
+	void ForEach(F&& func) const
+	{
+		for (const Shard& shard : m_shards)
+		{
+			if (const Table* table = shard.table.load(std::memory_order_acquire))
+			{
+				for (const Entry& e : table->entries)
+				{
+					const T value = e.value.load(std::memory_order_acquire);
+					if (value != T{}) func(e.key.load(std::memory_order_relaxed), value);
+				}
+			}
+		}
+	}
+
+	size_t Size() const
+	{
+		size_t count{};
+		for (const Shard& shard : m_shards)
+		{
+			count += shard.count.load(std::memory_order_relaxed);
+		}
+		return count;
+	}
+
+	// Not safe with concurrent lookups, for shutdown
+	void Clear()
+	{
+		for (Shard& shard : m_shards)
+		{
+			std::lock_guard<std::mutex> lock(shard.lock);
+			shard.table.store(nullptr, std::memory_order_release);
+			shard.tables.clear();
+			shard.count.store(0, std::memory_order_relaxed);
+		}
+	}
+
+	Stats GetStats() const
+	{
+		return Stats{ m_builds.load(), m_waits.load() };
+	}
+
+private:
+	struct Entry
+	{
+		std::atomic<size_t> key{};
+		std::atomic<T> value{};	// written last, readers only trust the key once this is set
+	};
+
+	// open addressing, linear probing, entries are never removed
+	struct Table
+	{
+		explicit Table(size_t capacity) : entries(capacity), mask(capacity - 1) {}
+
+		T Find(size_t key) const
+		{
+			for (size_t i = Mix(key) & mask;; i = (i + 1) & mask)
+			{
+				const T value = entries[i].value.load(std::memory_order_acquire);
+				if (value == T{})
+					return T{};
+				if (entries[i].key.load(std::memory_order_relaxed) == key)
+					return value;
+			}
+		}
+
+		void Insert(size_t key, T value)
+		{
+			for (size_t i = Mix(key) & mask;; i = (i + 1) & mask)
+			{
+				if (entries[i].value.load(std::memory_order_relaxed) == T{})
+				{
+					entries[i].key.store(key, std::memory_order_relaxed);
+					entries[i].value.store(value, std::memory_order_release);
+					return;
+				}
+			}
+		}
+
+		std::vector<Entry> entries;
+		size_t mask;
+	};
+
+	struct Shard
+	{
+		std::atomic<Table*> table{ nullptr };
+		std::vector<std::unique_ptr<Table>> tables;	// every table this shard had, readers may still be in an old one
+		std::atomic<size_t> count{};
+		std::unordered_map<size_t, std::shared_future<T>> inFlight;
+		std::mutex lock;
+	};
+
+	static size_t Mix(size_t key)
+	{
+		// the keys are already hashes, spread them again so shard and slot bits differ
+		uint64_t x = static_cast<uint64_t>(key);
+		x ^= x >> 33;
+		x *= 0xff51afd7ed558ccdull;
+		x ^= x >> 33;
+		return static_cast<size_t>(x);
+	}
+
+	static size_t ShardOf(size_t key)
+	{
+		return (Mix(key) >> 48) % NUM_SHARDS;
+	}
+
+	// shard lock held
+	void Insert(Shard& shard, size_t key, T value)
+	{
+		Table* table = shard.table.load(std::memory_order_relaxed);
+		const size_t count = shard.count.load(std::memory_order_relaxed);
+		if (table == nullptr || (count + 1) * 2 > table->entries.size())
+		{
+			// grow at half full, the old table stays alive for whoever is still probing it
+			auto grown = std::make_unique<Table>(table ? table->entries.size() * 2 : INITIAL_CAPACITY);
+			if (table)
+			{
+				for (const Entry& e : table->entries)
+				{
+					const T v = e.value.load(std::memory_order_relaxed);
+					if (v != T{}) grown->Insert(e.key.load(std::memory_order_relaxed), v);
+				}
+			}
+			table = grown.get();
+			table->Insert(key, value);
+			shard.tables.push_back(std::move(grown));
+			shard.table.store(table, std::memory_order_release);
+		}
+		else
+		{
+			table->Insert(key, value);
+		}
+		shard.count.store(count + 1, std::memory_order_relaxed);
+	}
+
+	std::array<Shard, NUM_SHARDS> m_shards;
+	std::atomic<uint64_t> m_builds{};
+	std::atomic<uint64_t> m_waits{};
+};
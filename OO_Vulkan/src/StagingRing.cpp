@@ -0,0 +1,154 @@
+/************************************************************************************//*!
+\file           StagingRing.cpp
+\project        Ouroboros
+\author         Jamie Kong, j.kong, 390004720 | code contribution (100%)
+\par            email: j.kong\@digipen.edu
+\date           May 02, 2024
+\brief              Defines a persistently mapped staging ring buffer that is recycled per frame in flight
+
+Copyright (C) 2022 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents
+without the prior written consent of DigiPen Institute of
+Technology is prohibited.
+*//*************************************************************************************/
+#include "StagingRing.h"
+#include "VulkanDevice.h"
+#include "DelayedDeleter.h"
+#include "Profiling.h"
+#include "UtilCommon.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace oGFX
+{
+
+void RingAllocator::Init(uint64_t capacity, uint32_t framesInFlight)
+{
+	OO_ASSERT(capacity > 0 && framesInFlight > 0);
+	m_capacity = capacity;
+	m_head = 0;
+	m_tail = 0;
+	m_frame = 0;
+	wraps = 0;
+	m_frameEnds.assign(framesInFlight, 0);
+}
+
+uint64_t RingAllocator::Allocate(uint64_t size, uint64_t alignment)
+{
+	OO_ASSERT(alignment && (alignment & (alignment - 1)) == 0);
+	if (size == 0 || size > m_capacity)
+		return INVALID_OFFSET;
+
+	const uint64_t pos = m_head % m_capacity;
+	const uint64_t aligned = (pos + alignment - 1) & ~(alignment - 1);
+	uint64_t start = m_head + (aligned - pos);
+	bool wrapped = false;
+	if (aligned + size > m_capacity)
+	{
+		// does not fit before the end, skip the tail end and start over at offset 0
+		start = m_head + (m_capacity - pos);
+		wrapped = true;
+	}
+
+	// would run into memory the GPU may still be reading
+	if (start + size - m_tail > m_capacity)
+		return INVALID_OFFSET;
+
+	wraps += wrapped;
+	m_head = start + size;
+	m_frameEnds[m_frame] = m_head;
+	return start % m_capacity;
+}
+
+void RingAllocator::BeginFrame(uint32_t frame)
+{
+	OO_ASSERT(frame < m_frameEnds.size());
+	m_frame = frame;
+	// frames retire in order so the tail only ever moves forward
+	m_tail = std::max(m_tail, m_frameEnds[frame]);
+	m_frameEnds[frame] = m_head;
+}
+
+void StagingRing::Init(VulkanDevice* device, VkDeviceSize capacity, uint32_t framesInFlight)
+{
+	m_device = device;
+	CreateBuffer("StagingRing", m_device->m_allocator, capacity, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+		VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT, m_buffer);
+	m_mapped = static_cast<uint8_t*>(m_buffer.allocInfo.pMappedData);
+	OO_ASSERT(m_mapped != nullptr);
+
+	m_ring.Init(capacity, framesInFlight);
+	m_stats = {};
+	m_stats.capacity = capacity;
+}
+
+void StagingRing::Destroy()
+{
+	if (m_buffer.buffer)
+	{
+		vmaDestroyBuffer(m_device->m_allocator, m_buffer.buffer, m_buffer.alloc);
+		m_buffer.buffer = VK_NULL_HANDLE;
+		m_mapped = nullptr;
+	}
+}
+
+void StagingRing::BeginFrame(uint32_t frame)
+{
+	std::scoped_lock lock(m_mutex);
+	m_ring.BeginFrame(frame);
+	m_stats.bytesThisFrame = 0;
+	m_stats.allocationsThisFrame = 0;
+}
+
+StagingRing::Allocation StagingRing::Stage(const void* data, VkDeviceSize size, VkDeviceSize alignment)
+{
+	PROFILE_SCOPED();
+
+	Allocation result{};
+	{
+		std::scoped_lock lock(m_mutex);
+		const uint64_t offset = m_ring.Allocate(size, alignment);
+		if (offset == RingAllocator::INVALID_OFFSET)
+		{
+			// ring is full, fall back to a buffer of its own for this write
+			AllocatedBuffer stagingBuffer{};
+			CreateBuffer("stagingBuffer", m_device->m_allocator, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+				VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT, stagingBuffer);
+			memcpy(stagingBuffer.allocInfo.pMappedData, data, size);
+			vmaFlushAllocation(m_device->m_allocator, stagingBuffer.alloc, 0, size);
+
+			DelayedDeleter::get()->DeleteAfterFrames([oldBuffer = stagingBuffer, alloc = m_device->m_allocator]() {
+				PROFILE_SCOPED("Clean buffer");
+				vmaDestroyBuffer(alloc, oldBuffer.buffer, oldBuffer.alloc);
+			});
+
+			++m_stats.fallbackAllocations;
+			result.buffer = stagingBuffer.buffer;
+			result.mapped = stagingBuffer.allocInfo.pMappedData;
+			return result;
+		}
+
+		m_stats.bytesThisFrame += size;
+		++m_stats.allocationsThisFrame;
+		m_stats.peakBytesInFlight = std::max(m_stats.peakBytesInFlight, m_ring.BytesInFlight());
+		m_stats.wraps = m_ring.wraps;
+
+		result.buffer = m_buffer.buffer;
+		result.offset = offset;
+		result.mapped = m_mapped + offset;
+	}
+
+	// regions handed out never overlap so the copy can happen outside the lock
+	memcpy(result.mapped, data, size);
+	vmaFlushAllocation(m_device->m_allocator, m_buffer.alloc, result.offset, size);
+	return result;
+}
+
+StagingRing::Stats StagingRing::GetStats() const
+{
+	std::scoped_lock lock(m_mutex);
+	return m_stats;
+}
+
+}
@@ -0,0 +1,93 @@
+/************************************************************************************//*!
+\file           StagingRing.h
+\project        Ouroboros
+\author         Jamie Kong, j.kong, 390004720 | code contribution (100%)
+\par            email: j.kong\@digipen.edu
+\date           May 02, 2024
+\brief              Declares a persistently mapped staging ring buffer that is recycled per frame in flight
+
+Copyright (C) 2022 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents
+without the prior written consent of DigiPen Institute of
+Technology is prohibited.
+*//*************************************************************************************/
+#pragma once
+#include "vulkan/vulkan.h"
+#include "VulkanUtils.h"
+
+#include <vector>
+#include <mutex>
+
+struct VulkanDevice;
+
+namespace oGFX
+{
+
+// CPU side bookkeeping of the ring, offsets only so it can be tested without a device
+class RingAllocator
+{
+public:
+	static constexpr uint64_t INVALID_OFFSET = ~0ull;
+
+	void Init(uint64_t capacity, uint32_t framesInFlight);
+
+	// Returns INVALID_OFFSET when the ring is out of space
+	uint64_t Allocate(uint64_t size, uint64_t alignment);
+
+	// Call once the fence of this frame has signalled, everything the frame allocated the last time around is free again
+	void BeginFrame(uint32_t frame);
+
+	uint64_t Capacity() const { return m_capacity; }
+	uint64_t BytesInFlight() const { return m_head - m_tail; }
+
+	uint64_t wraps{};
+
+private:
+	uint64_t m_capacity{};
+	// monotonic, the physical offset is the value modulo capacity
+	uint64_t m_head{};
+	uint64_t m_tail{};
+	std::vector<uint64_t> m_frameEnds;
+	uint32_t m_frame{};
+};
+
+class StagingRing
+{
+public:
+	struct Allocation
+	{
+		VkBuffer buffer{ VK_NULL_HANDLE };
+		VkDeviceSize offset{};
+		void* mapped{ nullptr };
+	};
+
+	struct Stats
+	{
+		uint64_t capacity{};
+		uint64_t bytesThisFrame{};
+		uint32_t allocationsThisFrame{};
+		uint64_t peakBytesInFlight{};
+		uint64_t wraps{};
+		uint64_t fallbackAllocations{};	// writes that did not fit in the ring and got their own buffer
+	};
+
+	void Init(VulkanDevice* device, VkDeviceSize capacity, uint32_t framesInFlight);
+	void Destroy();
+
+	void BeginFrame(uint32_t frame);
+
+	// Copies the data into the ring and returns where it landed, safe to call from any thread
+	Allocation Stage(const void* data, VkDeviceSize size, VkDeviceSize alignment = 16);
+
+	Stats GetStats() const;
+
+private:
+	VulkanDevice* m_device{ nullptr };
+	AllocatedBuffer m_buffer{};
+	uint8_t* m_mapped{ nullptr };
+	RingAllocator m_ring;
+	Stats m_stats{};
+	mutable std::mutex m_mutex;
+};
+
+}
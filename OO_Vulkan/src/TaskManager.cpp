@@ -1,6 +1,13 @@
 #include "TaskManager.h"
 #include "VulkanRenderer.h"
 
+namespace
+{
+    // the manager and queue of the worker running on this thread
+    thread_local const TaskManager* t_Manager = nullptr;
+    thread_local int32_t t_QueueIndex = -1;
+}
+
 TaskManager::TaskManager()
 {
 }
@@ -11,10 +18,15 @@ TaskManager::~TaskManager()
 
 int32_t TaskManager::Init(uint32_t threadPoolSize)
 {
-    std::function<void()> pTaskHandler = [this]() { this->TaskExecutor(); };
+    m_OwnerThread = std::this_thread::get_id();
+    m_ShuttingDown = false;
+
+    // queues are created up front so workers can steal from each other as soon as they start
+    for (uint32_t i = 0; i < threadPoolSize + 1; ++i)
+        m_Queues.push_back(std::make_unique<WorkerQueue>());
 
     for (uint32_t i = 0; i < threadPoolSize; ++i)
-        m_ThreadPool.push_back(std::thread(pTaskHandler));
+        m_ThreadPool.push_back(std::thread([this, i]() { this->TaskExecutor(i + 1); }));
 
     return 0;
 }
@@ -35,104 +47,207 @@ void TaskManager::Shutdown()
         iter->join();
         iter = m_ThreadPool.erase(iter);
     }
+    m_Queues.clear();
 }
 
 void TaskManager::AddTask(Task& newTask)
 {
-    std::unique_lock<std::mutex> lock(m_CriticalSection);
-    m_TaskQueue.push(std::move(newTask));
+    Enqueue(std::move(newTask));
+    m_PendingTasks.fetch_add(1);
 
     // Wake a single thread to pick up the task
-    m_QueueCondition.notify_one();
+    WakeWorkers(false);
 }
 
 void TaskManager::AddTaskList(std::queue<Task>& newTaskList)
 {
-    std::unique_lock<std::mutex> lock(m_CriticalSection);
-    while (newTaskList.size())
-    {
-        m_TaskQueue.push(std::move(newTaskList.front()));
-        newTaskList.pop();
-    }
+    EnqueueList(newTaskList, nullptr);
 
     // Wake up all threads to pick up as many concurrent tasks as possible
-    m_QueueCondition.notify_all();
+    WakeWorkers(true);
 }
 
 void TaskManager::AddTaskListAndWait(std::queue<Task>& newTaskList)
 {
     if (newTaskList.empty()) return;
 
-    std::condition_variable cv;
-    std::mutex waitMut;
-    bool waitingForTasks = true;
-    auto tasksDone = [&w = waitingForTasks, &mut = waitMut, &cond = cv](void*) {
-        std::scoped_lock l(mut);
-        w = false;
-        cond.notify_all();
-        };
-    TaskCompletionCallback cb(Task(tasksDone), (uint32_t)newTaskList.size());
-    std::queue<Task> tasks;
-    while (newTaskList.size()) 
+    TaskCounter counter;
+    EnqueueList(newTaskList, &counter);
+    WakeWorkers(true);
+    {
+        PROFILE_SCOPED("AddTaskListAndWait");
+        WaitForCounter(counter);
+    }
+}
+
+void TaskManager::WaitForCounter(const TaskCounter& counter)
+{
+    const int32_t queueIndex = LocalQueueIndex();
+    while (counter.IsDone() == false)
+    {
+        // help with the work instead of blocking, the tasks we wait on may be sitting in our own queue
+        Task task;
+        if (FindTask(queueIndex, task))
+        {
+            Execute(task);
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void TaskManager::Enqueue(Task&& newTask)
+{
+    if (newTask.pTaskCounter)
+        newTask.pTaskCounter->Count.fetch_add(1, std::memory_order_relaxed);
+
+    bool queued = false;
+    const int32_t queueIndex = LocalQueueIndex();
+    if (queueIndex >= 0)
     {
-        newTaskList.front().pTaskCompletionCallback = &cb;
-        tasks.emplace(newTaskList.front());
+        WorkerQueue& queue = *m_Queues[queueIndex];
+        TaskSlot& slot = queue.slots[queue.nextSlot & (TASKS_PER_QUEUE - 1)];
+        // the slot is free again once whoever took its task has copied it out
+        if (slot.busy.load(std::memory_order_acquire) == false)
+        {
+            ++queue.nextSlot;
+            slot.task = std::move(newTask);
+            slot.busy.store(true, std::memory_order_relaxed);
+            queued = queue.deque.Push(&slot);
+            if (queued == false)
+            {
+                newTask = std::move(slot.task);
+                slot.busy.store(false, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    if (queued == false)
+    {
+        // no queue of our own or it is full
+        std::unique_lock<std::mutex> lock(m_CriticalSection);
+        m_Overflow.push_back(std::move(newTask));
+        m_OverflowCount.fetch_add(1);
+    }
+}
+
+void TaskManager::EnqueueList(std::queue<Task>& newTaskList, TaskCounter* counter)
+{
+    int32_t count{};
+    while (newTaskList.size())
+    {
+        if (counter)
+            newTaskList.front().pTaskCounter = counter;
+        Enqueue(std::move(newTaskList.front()));
         newTaskList.pop();
+        ++count;
     }
+    // published once for the whole list, sleeping workers only look at it to decide whether to wake up
+    m_PendingTasks.fetch_add(count);
+}
 
-    AddTaskList(tasks);
+bool TaskManager::FindTask(int32_t queueIndex, Task& out)
+{
+    auto take = [this, &out](TaskSlot* slot) {
+        out = std::move(slot->task);
+        slot->busy.store(false, std::memory_order_release);
+        m_PendingTasks.fetch_sub(1);
+        return true;
+    };
+
+    if (queueIndex >= 0)
     {
-        PROFILE_SCOPED("AddTaskListAndWait");
-        // wait for task to complete
-        std::unique_lock l(waitMut);
-        cv.wait(l, [&wait = waitingForTasks]() { return wait == false; });
+        if (TaskSlot* slot = m_Queues[queueIndex]->deque.Pop())
+            return take(slot);
     }
+
+    if (m_OverflowCount.load() > 0)
+    {
+        std::unique_lock<std::mutex> lock(m_CriticalSection);
+        if (m_Overflow.size())
+        {
+            out = std::move(m_Overflow.front());
+            m_Overflow.pop_front();
+            m_OverflowCount.fetch_sub(1);
+            m_PendingTasks.fetch_sub(1);
+            return true;
+        }
+    }
+
+    // steal starting from our neighbour so the thieves spread out over the queues
+    const size_t numQueues = m_Queues.size();
+    const size_t start = queueIndex >= 0 ? static_cast<size_t>(queueIndex) : 0;
+    for (size_t i = 1; i <= numQueues; ++i)
+    {
+        const size_t victim = (start + i) % numQueues;
+        if (static_cast<int32_t>(victim) == queueIndex)
+            continue;
+        if (TaskSlot* slot = m_Queues[victim]->deque.Steal())
+            return take(slot);
+    }
+    return false;
 }
 
+void TaskManager::Execute(Task& task)
+{
+    task.pTaskFunction(task.pTaskParam);
 
-void TaskManager::TaskExecutor()
+    // When we are done, tick down the group this task belongs to
+    if (task.pTaskCounter)
+        task.pTaskCounter->Count.fetch_sub(1, std::memory_order_release);
+}
+
+void TaskManager::WakeWorkers(bool all)
 {
+    // only take the lock when someone is actually asleep
+    if (m_Sleepers.load() == 0)
+        return;
+
+    std::unique_lock<std::mutex> lock(m_CriticalSection);
+    if (all)
+        m_QueueCondition.notify_all();
+    else
+        m_QueueCondition.notify_one();
+}
+
+int32_t TaskManager::LocalQueueIndex() const
+{
+    if (t_Manager == this)
+        return t_QueueIndex;
+    if (std::this_thread::get_id() == m_OwnerThread)
+        return 0;
+    return -1;
+}
+
+void TaskManager::TaskExecutor(uint32_t queueIndex)
+{
+    t_Manager = this;
+    t_QueueIndex = static_cast<int32_t>(queueIndex);
+
     auto ThreadID = std::this_thread::get_id();
     auto mapping = VulkanRenderer::get()->RegisterThreadMapping();
     //printf("Thread_%llu initialized to mapping [%u]\n", ThreadID,mapping);
     std::string s("TaskThread_" + std::to_string(mapping));
     OPTICK_THREAD(s.c_str());
 
-    while (true)
+    while (m_ShuttingDown == false)
     {
         Task taskToExecute;
+        if (FindTask(t_QueueIndex, taskToExecute))
         {
-            // Try to unload a task to execute
-            std::unique_lock<std::mutex> lock(m_CriticalSection);
-            m_QueueCondition.wait(lock, [this] { return !this->m_TaskQueue.empty() || m_ShuttingDown; });    // Sleep until a task is available to execute or we are shutting down
-
-            if (m_ShuttingDown)
-                break;
-
-            // Get the task (if not shutting down
-            taskToExecute = m_TaskQueue.front();
-            m_TaskQueue.pop();
+            Execute(taskToExecute);
+            continue;
         }
 
-        while (taskToExecute.pTaskFunction)
-        {
-            // Execute the task
-            taskToExecute.pTaskFunction(taskToExecute.pTaskParam);
-
-            // When we are done, if there was a completion callback, tick it down and execute if needed
-            if (taskToExecute.pTaskCompletionCallback)
-            {
-                // If this was the last task on which we were waiting, execute the completion task now
-                if (--taskToExecute.pTaskCompletionCallback->TaskCount == 0)
-                {
-                    taskToExecute = taskToExecute.pTaskCompletionCallback->CompletionTask;
-                    delete taskToExecute.pTaskCompletionCallback;
-                    continue;
-                }
-            }
-
-            // No completion task to run, fetch another task or sleep
-            break;
-        }
+        // Nothing to run or steal, sleep until a task is queued or we are shutting down
+        std::unique_lock<std::mutex> lock(m_CriticalSection);
+        m_Sleepers.fetch_add(1);
+        m_QueueCondition.wait(lock, [this] { return m_PendingTasks.load() > 0 || m_ShuttingDown; });
+        m_Sleepers.fetch_sub(1);
     }
+
+    t_Manager = nullptr;
+    t_QueueIndex = -1;
 }
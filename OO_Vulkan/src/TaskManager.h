@@ -1,44 +1,224 @@
 #pragma once
 
 #include <queue>
-#include <functional>
+#include <deque>
+#include <vector>
+#include <memory>
+#include <atomic>
 #include <thread>
 #include <mutex>
 #include <condition_variable>
+#include <type_traits>
+#include <new>
+#include <cstddef>
 
-typedef std::function<void(void*)> TaskFunc;
-struct TaskCompletionCallback;
+/**
+ * @brief   Type erased void(void*) callable. Captures up to INLINE_SIZE bytes are stored inline so queuing a task
+ *          does not allocate, larger ones fall back to the heap.
+ */
+class TaskFunc
+{
+public:
+    static constexpr size_t INLINE_SIZE = 64;
+
+    TaskFunc() = default;
+
+    template<typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, TaskFunc>>>
+    TaskFunc(F&& func)
+    {
+        using Fn = std::decay_t<F>;
+        if constexpr (sizeof(Fn) <= INLINE_SIZE && alignof(Fn) <= alignof(std::max_align_t) && std::is_nothrow_move_constructible_v<Fn>)
+        {
+            new (m_Storage) Fn(std::forward<F>(func));
+            m_Ops = &InlineOps<Fn>::ops;
+        }
+        else
+        {
+            *reinterpret_cast<Fn**>(m_Storage) = new Fn(std::forward<F>(func));
+            m_Ops = &HeapOps<Fn>::ops;
+        }
+    }
+
+    TaskFunc(const TaskFunc& other) : m_Ops(other.m_Ops)
+    {
+        if (m_Ops) m_Ops->copy(m_Storage, other.m_Storage);
+    }
+
+    TaskFunc(TaskFunc&& other) noexcept : m_Ops(other.m_Ops)
+    {
+        if (m_Ops) m_Ops->move(m_Storage, other.m_Storage);
+        other.m_Ops = nullptr;
+    }
+
+    TaskFunc& operator=(const TaskFunc& other)
+    {
+        if (this != &other)
+        {
+            TaskFunc tmp(other);
+            *this = std::move(tmp);
+        }
+        return *this;
+    }
+
+    TaskFunc& operator=(TaskFunc&& other) noexcept
+    {
+        if (this != &other)
+        {
+            Reset();
+            m_Ops = other.m_Ops;
+            if (m_Ops) m_Ops->move(m_Storage, other.m_Storage);
+            other.m_Ops = nullptr;
+        }
+        return *this;
+    }
+
+    ~TaskFunc() { Reset(); }
+
+    void operator()(void* param) const { m_Ops->invoke(m_Storage, param); }
+    explicit operator bool() const { return m_Ops != nullptr; }
+
+private:
+    struct Ops
+    {
+        void (*invoke)(void* storage, void* param);
+        void (*copy)(void* dst, const void* src);
+        void (*move)(void* dst, void* src); // leaves src destroyed
+        void (*destroy)(void* storage);
+    };
+
+    template<typename Fn>
+    struct InlineOps
+    {
+        static void Invoke(void* s, void* param) { (*static_cast<Fn*>(s))(param); }
+        static void Copy(void* d, const void* s) { new (d) Fn(*static_cast<const Fn*>(s)); }
+        static void Move(void* d, void* s) { new (d) Fn(std::move(*static_cast<Fn*>(s))); static_cast<Fn*>(s)->~Fn(); }
+        static void Destroy(void* s) { static_cast<Fn*>(s)->~Fn(); }
+        static constexpr Ops ops{ Invoke, Copy, Move, Destroy };
+    };
+
+    template<typename Fn>
+    struct HeapOps
+    {
+        static Fn*& Ptr(void* s) { return *static_cast<Fn**>(s); }
+        static void Invoke(void* s, void* param) { (*Ptr(s))(param); }
+        static void Copy(void* d, const void* s) { Ptr(d) = new Fn(**static_cast<Fn* const*>(s)); }
+        static void Move(void* d, void* s) { Ptr(d) = Ptr(s); Ptr(s) = nullptr; }
+        static void Destroy(void* s) { delete Ptr(s); }
+        static constexpr Ops ops{ Invoke, Copy, Move, Destroy };
+    };
+
+    void Reset()
+    {
+        if (m_Ops) m_Ops->destroy(m_Storage);
+        m_Ops = nullptr;
+    }
+
+    alignas(std::max_align_t) mutable unsigned char m_Storage[INLINE_SIZE];
+    const Ops* m_Ops{ nullptr };
+};
+
+/**
+ * @brief   Counts the queued tasks that have not finished yet. Tasks tick it up when they are added and down once they
+ *          have run, wait on it with TaskManager::WaitForCounter.
+ */
+struct TaskCounter
+{
+    std::atomic<int32_t>    Count{};
+
+    bool IsDone() const { return Count.load(std::memory_order_acquire) == 0; }
+};
 
 struct Task
 {
     TaskFunc                pTaskFunction{};              ///< The task to execute
     void*                   pTaskParam{};                 ///< Parameters (in the form of a void pointer) to pass to the task (NOTE** calling code is responsible for the memory backing parameter pointer).
-    TaskCompletionCallback* pTaskCompletionCallback{};    ///< If this task is part of a larger group of tasks that require post-completion synchronization, they will be associated with a task sync primitive
+    TaskCounter*            pTaskCounter{};               ///< If this task is part of a larger group of tasks that require post-completion synchronization, the counter of that group
 
-    Task(TaskFunc pTaskFunction, void* pTaskParam = nullptr, TaskCompletionCallback* pCompletionCallback = nullptr) :
-        pTaskFunction(pTaskFunction), pTaskParam(pTaskParam), pTaskCompletionCallback(pCompletionCallback) {}
-
-private:
-    friend class TaskManager;
-    Task() {};
+    Task() = default;
+    Task(TaskFunc pTaskFunction, void* pTaskParam = nullptr, TaskCounter* pCounter = nullptr) :
+        pTaskFunction(std::move(pTaskFunction)), pTaskParam(pTaskParam), pTaskCounter(pCounter) {}
 };
 
-struct TaskCompletionCallback
+/**
+ * @brief   Fixed size Chase-Lev work stealing deque. The owning thread pushes and pops at the bottom,
+ *          any other thread steals from the top.
+ */
+template<typename T, size_t CAPACITY>
+class WorkStealingDeque
 {
-    Task                    CompletionTask;     ///< The task to execute once the task count reaches 0
-    std::atomic_uint        TaskCount{};          ///< Number of tasks this callback is paired with. Count will tick down upon completion of each dependent task.
+    static_assert((CAPACITY & (CAPACITY - 1)) == 0, "Capacity must be a power of two");
+public:
+    /**
+     * @brief   Owner only. Returns false when the deque is full.
+     */
+    bool Push(T* item)
+    {
+        const int64_t b = m_Bottom.load(std::memory_order_relaxed);
+        const int64_t t = m_Top.load(std::memory_order_acquire);
+        if (b - t >= static_cast<int64_t>(CAPACITY))
+            return false;
+
+        m_Buffer[b & (CAPACITY - 1)].store(item, std::memory_order_relaxed);
+        m_Bottom.store(b + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief   Owner only. Takes the most recently pushed item.
+     */
+    T* Pop()
+    {
+        const int64_t b = m_Bottom.load(std::memory_order_relaxed) - 1;
+        m_Bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = m_Top.load(std::memory_order_relaxed);
+
+        T* item = nullptr;
+        if (t <= b)
+        {
+            item = m_Buffer[b & (CAPACITY - 1)].load(std::memory_order_relaxed);
+            if (t == b)
+            {
+                // last item, race the thieves for it
+                if (m_Top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed) == false)
+                    item = nullptr;
+                m_Bottom.store(b + 1, std::memory_order_relaxed);
+            }
+        }
+        else
+        {
+            m_Bottom.store(b + 1, std::memory_order_relaxed);
+        }
+        return item;
+    }
+
+    /**
+     * @brief   Any thread. Takes the oldest item, returns nullptr when empty or when another thread won the race.
+     */
+    T* Steal()
+    {
+        int64_t t = m_Top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const int64_t b = m_Bottom.load(std::memory_order_acquire);
+        if (t >= b)
+            return nullptr;
 
-    TaskCompletionCallback(Task completionTask, uint32_t taskCount = 1) :
-        CompletionTask(completionTask), TaskCount(taskCount) {}
+        T* item = m_Buffer[t & (CAPACITY - 1)].load(std::memory_order_relaxed);
+        if (m_Top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed) == false)
+            return nullptr;
+        return item;
+    }
 
 private:
-    TaskCompletionCallback() = delete;
+    alignas(64) std::atomic<int64_t> m_Top{ 0 };
+    alignas(64) std::atomic<int64_t> m_Bottom{ 0 };
+    alignas(64) std::atomic<T*> m_Buffer[CAPACITY]{};
 };
 
-
 class TaskManager
 {
 public:
+    static constexpr size_t TASKS_PER_QUEUE = 4096;
 
     /**
      * @brief   Constructor with default behavior.
@@ -52,6 +232,7 @@ public:
 
     /**
      * @brief   Initialization function for the TaskManager. Dictates the size of our thread pool.
+     *          The calling thread also gets a queue of its own and helps out while it waits on a counter.
      */
     int32_t Init(uint32_t threadPoolSize);
 
@@ -70,19 +251,57 @@ public:
      */
     void AddTaskList(std::queue<Task>& newTaskList);
 
+    /**
+     * @brief   Enqueues multiple tasks and runs tasks on this thread until all of them are done.
+     */
     void AddTaskListAndWait(std::queue<Task>& newTaskList);
 
+    /**
+     * @brief   Runs queued tasks on this thread until the counter reaches zero.
+     */
+    void WaitForCounter(const TaskCounter& counter);
+
+    /**
+     * @brief   Number of worker threads in the pool.
+     */
+    uint32_t GetThreadCount() const { return static_cast<uint32_t>(m_ThreadPool.size()); }
+
 private:
     TaskManager(const TaskManager&) = delete;
     TaskManager& operator=(const TaskManager&) = delete;
     TaskManager(const TaskManager&&) = delete;
     TaskManager& operator=(const TaskManager&&) = delete;
 
-    void TaskExecutor();
+    struct TaskSlot
+    {
+        Task                    task;
+        std::atomic<bool>       busy{ false };
+    };
+
+    // Per thread queue, only the owner allocates slots and pushes, everyone else steals
+    struct WorkerQueue
+    {
+        WorkStealingDeque<TaskSlot, TASKS_PER_QUEUE>    deque;
+        std::unique_ptr<TaskSlot[]>                     slots{ std::make_unique<TaskSlot[]>(TASKS_PER_QUEUE) };
+        size_t                                          nextSlot{};
+    };
+
+    void TaskExecutor(uint32_t queueIndex);
+    void Enqueue(Task&& newTask);
+    void EnqueueList(std::queue<Task>& newTaskList, TaskCounter* counter);
+    bool FindTask(int32_t queueIndex, Task& out);
+    void Execute(Task& task);
+    void WakeWorkers(bool all);
+    int32_t LocalQueueIndex() const;
 
-    bool                        m_ShuttingDown = false;
-    std::vector<std::thread>    m_ThreadPool = {};
-    std::queue<Task>            m_TaskQueue = {};
-    std::mutex                  m_CriticalSection;
-    std::condition_variable     m_QueueCondition;
+    std::atomic<bool>                           m_ShuttingDown = false;
+    std::vector<std::thread>                    m_ThreadPool = {};
+    std::vector<std::unique_ptr<WorkerQueue>>   m_Queues = {};     ///< [0] belongs to the thread that called Init, the rest to the workers
+    std::thread::id                             m_OwnerThread{};
+    std::deque<Task>                            m_Overflow = {};   ///< Tasks from threads without a queue, or from full queues
+    std::atomic<int32_t>                        m_OverflowCount{};
+    std::atomic<int32_t>                        m_PendingTasks{};  ///< Queued tasks nobody has picked up yet
+    std::atomic<int32_t>                        m_Sleepers{};
+    std::mutex                                  m_CriticalSection;
+    std::condition_variable                     m_QueueCondition;
 };
@@ -12,8 +12,42 @@ without the prior written consent of DigiPen Institute of
 Technology is prohibited.
 *//*************************************************************************************/
 #include "Tests_Assignment1.h"
+#include "OctTree.h"
+#include "GraphicsBatch.h"
+#include "TaskManager.h"
+#include "StagingRing.h"
+#include "ShadowAtlas.h"
+#include "RenderGraphCompiler.h"
+#include "PipelineCache.h"
+#include "DescriptorBuilder.h"
+#include "ShardedRegistry.h"
+#include "MeshRangeAllocator.h"
+#include "GPUSceneSlots.h"
+#include "MeshOptimizer.h"
+#include "VertexPacking.h"
+#include "MeshletBuilder.h"
+#include "TextureUploader.h"
+#include "TextureResidency.h"
+#include "ModelImporter.h"
+#include "CookedModel.h"
+#include "loader/stb_image.h"
+#include "DefaultMeshCreator.h"
 #include <iostream>
 #include <iomanip>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <functional>
+#include <cstring>
+#include <algorithm>
+#include <fstream>
+#include <numeric>
+
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+#include <sstream>
+#include <map>
+#include <filesystem>
 
 namespace oGFX {
 
@@ -770,6 +804,59 @@ int RunAllTests()
 	PlaneAabbTest49("PlaneAabbTest49");
 	PlaneAabbTest50("PlaneAabbTest50");
 
+	FrustumAabbBatchTest1("FrustumAabbBatchTest1");
+	FrustumAabbBatchTest2("FrustumAabbBatchTest2");
+
+	CullViewsScalingBenchmark("CullViewsScalingBenchmark");
+	TaskManagerContentionBenchmark("TaskManagerContentionBenchmark");
+
+	StagingRingTest1("StagingRingTest1");
+	StagingRingTest2("StagingRingTest2");
+
+	ShadowAtlasTest1("ShadowAtlasTest1");
+	ShadowAtlasTest2("ShadowAtlasTest2");
+
+	RenderGraphCompileTest1("RenderGraphCompileTest1");
+	RenderGraphCompileTest2("RenderGraphCompileTest2");
+
+	TransientAliasingTest1("TransientAliasingTest1");
+	TransientAliasingTest2("TransientAliasingTest2");
+
+	PipelineCacheTest1("PipelineCacheTest1");
+	PipelineCacheTest2("PipelineCacheTest2");
+
+	ShardedRegistryStressTest("ShardedRegistryStressTest");
+
+	MeshRangeAllocatorTest1("MeshRangeAllocatorTest1");
+	MeshRangeAllocatorTest2("MeshRangeAllocatorTest2");
+
+	MeshOptimizerTest1("MeshOptimizerTest1");
+	MeshOptimizerTest2("MeshOptimizerTest2");
+	VertexPackingTest1("VertexPackingTest1");
+	VertexPackingTest2("VertexPackingTest2");
+	MeshletTest1("MeshletTest1");
+	MeshletTest2("MeshletTest2");
+	TextureUploaderTest1("TextureUploaderTest1");
+	TextureUploaderBenchmark("TextureUploaderBenchmark");
+	TextureResidencyTest1("TextureResidencyTest1");
+	TextureResidencyTest2("TextureResidencyTest2");
+	ImageLoadingTest1("ImageLoadingTest1");
+	ImageLoadingBenchmark("ImageLoadingBenchmark");
+	ModelImportTest1("ModelImportTest1");
+	ModelImportBenchmark("ModelImportBenchmark");
+	CookedModelTest1("CookedModelTest1");
+	CookedModelBenchmark("CookedModelBenchmark");
+	OctTreeUpdateBenchmark("OctTreeUpdateBenchmark");
+	SnapshotCostBenchmark("SnapshotCostBenchmark");
+	SnapshotAllocationTest1("SnapshotAllocationTest1");
+	BitContainerBenchmark("BitContainerBenchmark");
+	BitContainerHandleTest1("BitContainerHandleTest1");
+	FrustumAabbBatchBenchmark("FrustumAabbBatchBenchmark");
+	MultiViewCullingTest1("MultiViewCullingTest1");
+	MultiViewCullingTest2("MultiViewCullingTest2");
+	GPUSceneSlotsTest1("GPUSceneSlotsTest1");
+	DescriptorSetCacheTest1("DescriptorSetCacheTest1");
+
 	return 1;
 }
 
@@ -8594,7 +8681,3751 @@ void PrintTestHeader(const std::string& testName)
 		PrintResultPlane(TestPlaneAabb(plane, aabb, t), t);
 	}
 
-} // end namespace oGFX
+#pragma endregion
+
+#pragma region FrustumAabbBatch
+
+/** Batched Frustum Vs Aabb -- 2 tests, compares against AABBInFrustum **/
+
+	void RunFrustumAabbBatch(const Frustum& frust, const std::vector<Aabb>& boxes)
+	{
+		coll::AABBBatch batch;
+		for (const Aabb& a : boxes)
+		{
+			batch.push_back(a);
+		}
+		std::vector<coll::Collision> simd(boxes.size());
+		std::vector<coll::Collision> scalar(boxes.size());
+		coll::AABBInFrustumBatch(frust, batch, simd.data());
+		coll::AABBInFrustumBatchScalar(frust, batch, scalar.data());
+
+		size_t mismatches{};
+		size_t counts[3]{};
+		for (size_t i = 0; i < boxes.size(); i++)
+		{
+			coll::Collision expected = coll::AABBInFrustum(frust, boxes[i]);
+			if (simd[i] != expected || scalar[i] != expected)
+			{
+				++mismatches;
+			}
+			++counts[expected];
+		}
+		std::cout << "  Outside:" << counts[coll::OUTSIDE] << " Intersects:" << counts[coll::INTERSECTS] 
+			<< " Contains:" << counts[coll::CONTAINS] << std::endl;
+		std::cout << "  Result:" << (mismatches ? "false" : "true") << " mismatches:" << mismatches << std::endl;
+	}
+
+	// Grid of boxes straddling every plane of a perspective frustum, count not a multiple of 4
+	void FrustumAabbBatchTest1(const std::string& testName)
+	{
+		PrintTestHeader(testName);
+
+		glm::mat4 proj = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 50.0f);
+		glm::mat4 view = glm::lookAt(Vector3(0, 2, 10), Vector3(0, 0, 0), Vector3(0, 1, 0));
+		Frustum frust = Frustum::CreateFromViewProj(proj * view);
+
+		std::vector<Aabb> boxes;
+		for (int x = -30; x <= 30; x += 3)
+			for (int y = -15; y <= 15; y += 3)
+				for (int z = -50; z <= 20; z += 3)
+				{
+					Vector3 c{ float(x), float(y), float(z) };
+					boxes.emplace_back(c - Vector3(0.75f), c + Vector3(0.75f));
+				}
+
+		RunFrustumAabbBatch(frust, boxes);
+	}
+
+	// Boxes exactly touching the near and side planes of an axis aligned frustum
+	void FrustumAabbBatchTest2(const std::string& testName)
+	{
+		PrintTestHeader(testName);
+
+		glm::mat4 proj = glm::perspective(glm::radians(90.0f), 1.0f, 1.0f, 10.0f);
+		Frustum frust = Frustum::CreateFromViewProj(proj);
+
+		std::vector<Aabb> boxes;
+		for (int i = 0; i < 23; i++)
+		{
+			float d = 1.0f + float(i) * 0.5f;
+			boxes.emplace_back(Vector3(-d, -0.5f, -d - 1.0f), Vector3(-d + 1.0f, 0.5f, -d));
+			boxes.emplace_back(Vector3(-0.5f, -0.5f, -d), Vector3(0.5f, 0.5f, -d + 1.0f));
+			boxes.emplace_back(Vector3(d, d, -d), Vector3(d + 1.0f, d + 1.0f, -d + 1.0f));
+		}
+
+		RunFrustumAabbBatch(frust, boxes);
+	}
+
+#pragma endregion
+
+#pragma region CullViewsScaling
+
+/** Culls a synthetic scene from a camera and 3 point lights with 1 to N workers and reports the speedup **/
+
+	void CullViewsScalingBenchmark(const std::string& testName)
+	{
+		PrintTestHeader(testName);
+
+		constexpr uint32_t numObjects = 50000;
+		constexpr uint32_t numViews = 1 + 3 * POINT_LIGHT_FACE_COUNT;
+		constexpr int iterations = 20;
+
+		std::mt19937 rng(1234);
+		std::uniform_real_distribution<float> pos(-240.0f, 240.0f);
+		std::uniform_real_distribution<float> ext(0.1f, 2.0f);
+		std::uniform_real_distribution<float> angle(0.0f, glm::two_pi<float>());
+
+		OctTree tree(Aabb{ Vector3(-250.0f), Vector3(250.0f) });
+		for (uint32_t i = 0; i < numObjects; i++)
+		{
+			Vector3 c{ pos(rng), pos(rng), pos(rng) };
+			Vector3 h{ ext(rng) };
+			tree.Insert(i, Aabb{ c - h, c + h });
+		}
+
+		GraphicsBatch::ViewSet views;
+		glm::mat4 proj = glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, 150.0f);
+		for (uint32_t v = 0; v < numViews; v++)
+		{
+			Vector3 eye{ pos(rng), pos(rng), pos(rng) };
+			float a = angle(rng);
+			glm::mat4 view = glm::lookAt(eye, eye + Vector3(cosf(a), 0.0f, sinf(a)), Vector3(0, 1, 0));
+			views.AddView(Frustum::CreateFromViewProj(proj * view));
+		}
+
+		const uint32_t hwThreads = std::thread::hardware_concurrency();
+		const uint32_t maxWorkers = hwThreads > 1 ? hwThreads - 1 : 1;
+		double baselineMs{};
+		size_t baselineVisible{};
+		bool consistent = true;
+		for (uint32_t workers = 1; workers <= maxWorkers; workers++)
+		{
+			TaskManager tm;
+			tm.Init(workers);
+
+			auto start = std::chrono::high_resolution_clock::now();
+			for (int i = 0; i < iterations; i++)
+			{
+				for (uint32_t v = 0; v < views.size(); v++)
+				{
+					views.visible[v].clear();
+				}
+				std::queue<Task> tasks;
+				GraphicsBatch::QueueViewCulling(tasks, tree, views, workers);
+				tm.AddTaskListAndWait(tasks);
+			}
+			auto end = std::chrono::high_resolution_clock::now();
+			tm.Shutdown();
+
+			const double ms = std::chrono::duration<double, std::milli>(end - start).count() / iterations;
+			size_t visible{};
+			for (uint32_t v = 0; v < views.size(); v++)
+			{
+				visible += views.visible[v].size();
+			}
+			if (workers == 1)
+			{
+				baselineMs = ms;
+				baselineVisible = visible;
+			}
+			consistent = consistent && visible == baselineVisible;
+
+			std::cout << "  Workers:" << workers << " Time:" << std::fixed << std::setprecision(3) << ms 
+				<< "ms Speedup:" << std::setprecision(2) << baselineMs / ms << "x" << std::endl;
+		}
+		std::cout << "  Result:" << (consistent ? "true" : "false") << " visible:" << baselineVisible << std::endl;
+	}
 
 #pragma endregion
 
+#pragma region TaskManagerContention
+
+/** Runs many tiny tasks through a replica of the old single mutex queue and through the TaskManager and reports the speedup **/
+
+	// The previous TaskManager design: one std::queue of std::function tasks behind one mutex
+	class MutexTaskQueue
+	{
+	public:
+		explicit MutexTaskQueue(uint32_t threads)
+		{
+			for (uint32_t i = 0; i < threads; i++)
+			{
+				m_threads.emplace_back([this]() {
+					while (true)
+					{
+						std::function<void()> task;
+						{
+							std::unique_lock<std::mutex> lock(m_mutex);
+							m_cv.wait(lock, [this] { return !m_tasks.empty() || m_shutdown; });
+							if (m_shutdown) break;
+							task = m_tasks.front();
+							m_tasks.pop();
+						}
+						task();
+						if (--m_remaining == 0)
+						{
+							std::scoped_lock lock(m_doneMutex);
+							m_doneCv.notify_all();
+						}
+					}
+				});
+			}
+		}
+
+		~MutexTaskQueue()
+		{
+			{
+				std::scoped_lock lock(m_mutex);
+				m_shutdown = true;
+				m_cv.notify_all();
+			}
+			for (auto& t : m_threads) t.join();
+		}
+
+		void RunAndWait(std::vector<std::function<void()>>& tasks)
+		{
+			m_remaining = static_cast<uint32_t>(tasks.size());
+			{
+				std::scoped_lock lock(m_mutex);
+				for (auto& t : tasks) m_tasks.push(t);
+				m_cv.notify_all();
+			}
+			std::unique_lock<std::mutex> lock(m_doneMutex);
+			m_doneCv.wait(lock, [this] { return m_remaining == 0; });
+		}
+
+	private:
+		std::vector<std::thread> m_threads;
+		std::queue<std::function<void()>> m_tasks;
+		std::mutex m_mutex;
+		std::condition_variable m_cv;
+		std::atomic<uint32_t> m_remaining{};
+		std::mutex m_doneMutex;
+		std::condition_variable m_doneCv;
+		bool m_shutdown = false;
+	};
+
+	void TaskManagerContentionBenchmark(const std::string& testName)
+	{
+		PrintTestHeader(testName);
+
+		constexpr uint32_t numTasks = 4000;
+		constexpr int iterations = 50;
+		const uint32_t hwThreads = std::thread::hardware_concurrency();
+		const uint32_t workers = hwThreads > 1 ? hwThreads - 1 : 1;
+
+		std::atomic<uint64_t> legacySum{};
+		std::atomic<uint64_t> stealingSum{};
+		auto tinyWork = [](uint32_t i, std::atomic<uint64_t>& sum) {
+			uint64_t h = i;
+			for (int r = 0; r < 16; r++) h = h * 6364136223846793005ull + 1442695040888963407ull;
+			sum.fetch_add(h & 0xFF, std::memory_order_relaxed);
+		};
+
+		double legacyMs{};
+		{
+			MutexTaskQueue legacy(workers);
+			std::vector<std::function<void()>> tasks;
+			auto start = std::chrono::high_resolution_clock::now();
+			for (int it = 0; it < iterations; it++)
+			{
+				tasks.clear();
+				for (uint32_t i = 0; i < numTasks; i++)
+				{
+					tasks.emplace_back([&tinyWork, &legacySum, i]() { tinyWork(i, legacySum); });
+				}
+				legacy.RunAndWait(tasks);
+			}
+			auto end = std::chrono::high_resolution_clock::now();
+			legacyMs = std::chrono::duration<double, std::milli>(end - start).count() / iterations;
+		}
+
+		double stealingMs{};
+		{
+			TaskManager tm;
+			tm.Init(workers);
+			auto start = std::chrono::high_resolution_clock::now();
+			for (int it = 0; it < iterations; it++)
+			{
+				std::queue<Task> tasks;
+				for (uint32_t i = 0; i < numTasks; i++)
+				{
+					tasks.emplace([&tinyWork, &stealingSum, i](void*) { tinyWork(i, stealingSum); });
+				}
+				tm.AddTaskListAndWait(tasks);
+			}
+			auto end = std::chrono::high_resolution_clock::now();
+			tm.Shutdown();
+			stealingMs = std::chrono::duration<double, std::milli>(end - start).count() / iterations;
+		}
+
+		std::cout << "  Workers:" << workers << " Tasks:" << numTasks << std::fixed << std::setprecision(3)
+			<< " MutexQueue:" << legacyMs << "ms WorkStealing:" << stealingMs << "ms Speedup:"
+			<< std::setprecision(2) << legacyMs / stealingMs << "x" << std::endl;
+		std::cout << "  Result:" << (legacySum == stealingSum ? "true" : "false") << std::endl;
+	}
+
+#pragma endregion
+
+#pragma region StagingRing
+
+/** Staging ring allocator -- 2 tests, CPU side offsets only **/
+
+	// Odd sized allocations over many frames with 2 in flight, checks alignment, bounds and overlap with live frames
+	void StagingRingTest1(const std::string& testName)
+	{
+		PrintTestHeader(testName);
+
+		constexpr uint64_t capacity = 4096;
+		constexpr uint32_t framesInFlight = 2;
+		oGFX::RingAllocator ring;
+		ring.Init(capacity, framesInFlight);
+
+		struct Range { uint64_t begin, end; };
+		std::vector<Range> live[framesInFlight];
+		std::mt19937 rng(42);
+		std::uniform_int_distribution<uint64_t> sizes(1, 700);
+
+		size_t errors{};
+		size_t failed{};
+		for (uint32_t frame = 0; frame < 200; frame++)
+		{
+			const uint32_t slot = frame % framesInFlight;
+			ring.BeginFrame(slot);
+			live[slot].clear();
+
+			for (int i = 0; i < 3; i++)
+			{
+				const uint64_t size = sizes(rng);
+				const uint64_t offset = ring.Allocate(size, 16);
+				if (offset == oGFX::RingAllocator::INVALID_OFFSET)
+				{
+					++failed;
+					continue;
+				}
+				if (offset % 16 != 0 || offset + size > capacity)
+				{
+					++errors;
+				}
+				for (const auto& frameRanges : live)
+				{
+					for (const Range& r : frameRanges)
+					{
+						if (offset < r.end && r.begin < offset + size)
+						{
+							++errors;
+						}
+					}
+				}
+				live[slot].push_back({ offset, offset + size });
+			}
+		}
+		std::cout << "  Wraps:" << ring.wraps << " Failed:" << failed << std::endl;
+		std::cout << "  Result:" << (errors == 0 && ring.wraps > 0 ? "true" : "false") << " errors:" << errors << std::endl;
+	}
+
+	// Fills the ring while the frame is still in flight, then checks the space comes back once its fence has signalled
+	void StagingRingTest2(const std::string& testName)
+	{
+		PrintTestHeader(testName);
+
+		oGFX::RingAllocator ring;
+		ring.Init(1024, 2);
+
+		bool result = true;
+		ring.BeginFrame(0);
+		result = result && ring.Allocate(600, 256) == 0;
+		ring.BeginFrame(1);
+		result = result && ring.Allocate(200, 256) == 768;
+		// 600 does not fit before the end and frame 0 still owns the start
+		result = result && ring.Allocate(600, 256) == oGFX::RingAllocator::INVALID_OFFSET;
+		ring.BeginFrame(0);
+		// frame 0 retired, wrap around to the start
+		result = result && ring.Allocate(600, 256) == 0;
+		result = result && ring.wraps == 1;
+		result = result && ring.BytesInFlight() == 1024;
+		result = result && ring.Allocate(16, 16) == oGFX::RingAllocator::INVALID_OFFSET;
+
+		std::cout << "  Result:" << (result ? "true" : "false") << std::endl;
+	}
+
+#pragma endregion
+
+#pragma region ShadowAtlas
+
+/** Shadow atlas -- 2 tests, CPU side tiles and caching only **/
+
+	// Random tiles of mixed sizes, checks bounds and overlap, then that freeing everything merges back to one tile
+	void ShadowAtlasTest1(const std::string& testName)
+	{
+		PrintTestHeader(testName);
+
+		oGFX::ShadowAtlasAllocator atlas;
+		atlas.Init(4096, 128);
+
+		std::vector<oGFX::ShadowAtlasAllocator::Tile> tiles;
+		std::mt19937 rng(7);
+		std::uniform_int_distribution<uint32_t> sizes(100, 1500);
+
+		size_t errors{};
+		size_t failed{};
+		for (int i = 0; i < 2000; i++)
+		{
+			if (tiles.size() && rng() % 3 == 0)
+			{
+				const size_t victim = rng() % tiles.size();
+				atlas.Free(tiles[victim]);
+				tiles[victim] = tiles.back();
+				tiles.pop_back();
+				continue;
+			}
+
+			oGFX::ShadowAtlasAllocator::Tile t;
+			const uint32_t size = sizes(rng);
+			if (atlas.Allocate(size, t) == false)
+			{
+				++failed;
+				continue;
+			}
+			if (t.size < size || (t.size & (t.size - 1)) || t.x % t.size || t.y % t.size || t.x + t.size > 4096 || t.y + t.size > 4096)
+			{
+				++errors;
+			}
+			for (const auto& o : tiles)
+			{
+				if (t.x < o.x + o.size && o.x < t.x + t.size && t.y < o.y + o.size && o.y < t.y + t.size)
+				{
+					++errors;
+				}
+			}
+			tiles.push_back(t);
+		}
+
+		uint64_t area{};
+		for (const auto& t : tiles)
+		{
+			area += uint64_t(t.size) * t.size;
+		}
+		errors += area != atlas.UsedArea();
+
+		for (auto& t : tiles)
+		{
+			atlas.Free(t);
+		}
+		oGFX::ShadowAtlasAllocator::Tile whole;
+		const bool merged = atlas.UsedArea() == 0 && atlas.Allocate(4096, whole) && whole.x == 0 && whole.y == 0;
+
+		std::cout << "  Failed:" << failed << std::endl;
+		std::cout << "  Result:" << (errors == 0 && merged && failed > 0 ? "true" : "false") << " errors:" << errors << std::endl;
+	}
+
+	// Three point lights fighting for space, cached faces and giving tiles back once a light goes away
+	void ShadowAtlasTest2(const std::string& testName)
+	{
+		PrintTestHeader(testName);
+
+		oGFX::ShadowAtlas atlas;
+		atlas.Init(4096, 128, 1024);
+
+		bool result = true;
+		std::vector<oGFX::ShadowAtlas::Request> requests{ { 10, 6, 1024 }, { 11, 6, 900 }, { 12, 6, 1024 } };
+		std::vector<oGFX::ShadowAtlas::Light*> lights;
+		atlas.Update(requests, lights);
+		// 16 tiles of 1024 fit, the last light steps down
+		result = result && lights[0]->size == 1024 && lights[1]->size == 1024 && lights[2]->size == 512;
+
+		using Atlas = oGFX::ShadowAtlas;
+		Atlas::Face& face = lights[0]->faces[0];
+		result = result && Atlas::UpdateFace(face, 1, 0, false, 5) == true;	// never rendered
+		result = result && Atlas::UpdateFace(face, 1, 5, false, 6) == false;	// nothing changed since
+		result = result && Atlas::UpdateFace(face, 1, 7, false, 7) == true;	// a caster moved
+		result = result && Atlas::UpdateFace(face, 2, 7, false, 8) == true;	// light moved or a caster came in
+		result = result && Atlas::UpdateFace(face, 2, 7, true, 8) == true;		// skinned caster
+
+		// same requests, the tiles and what was rendered into them stay
+		const oGFX::ShadowAtlas::Tile before = lights[0]->faces[0].tile;
+		atlas.Update(requests, lights);
+		result = result && lights[0]->faces[0].tile.node == before.node && Atlas::UpdateFace(lights[0]->faces[0], 2, 7, false, 9) == false;
+
+		// small shrink is absorbed, a large one gives space back
+		requests[1].desiredSize = 512;
+		atlas.Update(requests, lights);
+		result = result && lights[1]->size == 1024;
+		requests[1].desiredSize = 200;
+		atlas.Update(requests, lights);
+		result = result && lights[1]->size == 256 && lights[1]->faces[0].valid == false;
+
+		// the first light is gone, the last one grows into its space
+		requests.erase(requests.begin());
+		atlas.Update(requests, lights);
+		result = result && atlas.NumLights() == 2 && lights[1]->size == 1024;
+		result = result && atlas.Allocator().UsedArea() == 6ull * 1024 * 1024 + 6ull * 256 * 256;
+
+		result = result && Atlas::SizeForCoverage(5.0f, 2.0f, 0.5f, 1080, 128, 1024) == 1024;
+		result = result && Atlas::SizeForCoverage(1.0f, 100.0f, 0.5f, 1080, 128, 1024) == 128;
+		result = result && Atlas::SizeForCoverage(1.0f, 4.0f, 0.5f, 1080, 128, 1024) == 1024;
+
+		std::cout << "  Result:" << (result ? "true" : "false") << std::endl;
+	}
+
+#pragma endregion
+
+#pragma region RenderGraphCompile
+
+/** Render graph compile -- 2 tests, mock passes without a device **/
+
+	// Resources of a deferred frame, keys only have to be unique
+	struct MockFrame
+	{
+		int shadow, depth, gbuffer, ssao, lighting, history, debugView, final, instances, luminance;
+
+		std::vector<RGPassDesc> passes;
+
+		MockFrame()
+		{
+			auto tex = [](const void* r, ResourceUsage u, bool w, bool depth = false) { return RGAccess{ r, u, w, false, depth }; };
+			auto buf = [](const void* r, ResourceUsage u, bool w) { return RGAccess{ r, u, w, true, false }; };
+			passes = {
+				{ "Shadow",		{ tex(&shadow, ATTACHMENT, true, true), buf(&instances, SRV, false) } },
+				{ "ZPrePass",	{ tex(&depth, ATTACHMENT, true, true) } },
+				{ "GBuffer",	{ tex(&gbuffer, ATTACHMENT, true), tex(&depth, ATTACHMENT, true, true), buf(&instances, SRV, false) } },
+				{ "SSAO",		{ tex(&depth, SRV, false, true), tex(&gbuffer, SRV, false), tex(&ssao, UAV, true) } },
+				{ "Lighting",	{ tex(&gbuffer, SRV, false), tex(&depth, SRV, false, true), tex(&shadow, SRV, false, true), tex(&ssao, SRV, false),
+								  tex(&history, SRV, false), tex(&lighting, ATTACHMENT, true) } },
+				{ "DebugView",	{ tex(&gbuffer, SRV, false), tex(&debugView, UAV, true) } },
+				{ "Histogram",	{ tex(&lighting, SRV, false), buf(&luminance, UAV, true) } },
+				{ "HistoryCopy",{ tex(&lighting, SRV, false), tex(&history, UAV, true) } },
+				{ "Bloom",		{ tex(&lighting, SRV, false), buf(&luminance, SRV, false), tex(&final, UAV, true) } },
+				{ "UI",			{ tex(&final, ATTACHMENT, true) } },
+				{ "Profiler",	{} },
+			};
+		}
+	};
+
+	// Pass order, culling and which passes are independent of each other
+	void RenderGraphCompileTest1(const std::string& testName)
+	{
+		PrintTestHeader(testName);
+
+		MockFrame frame;
+		const RGCompileResult r = RGCompile(frame.passes, { &frame.final });
+
+		bool result = true;
+		// nothing reads the debug view, history is read before it is written so its writer stays
+		result = result && r.order == std::vector<uint32_t>{ 0, 1, 2, 3, 4, 6, 7, 8, 9, 10 };
+		result = result && r.culled[5] == true && r.culled[7] == false && r.culled[10] == false;
+		result = result && r.level == std::vector<uint32_t>{ 0, 0, 1, 2, 3, 0, 4, 4, 5, 6, 0 };
+		result = result && r.groups.size() == 7;
+		result = result && r.groups[0] == std::vector<uint32_t>{ 0, 1, 10 };
+		result = result && r.groups[4] == std::vector<uint32_t>{ 6, 7 };
+
+		// without outputs only the history writer, the passes without writes and what they need survive
+		const RGCompileResult noOutput = RGCompile(frame.passes, {});
+		result = result && noOutput.culled[8] && noOutput.culled[9] && noOutput.culled[6] && noOutput.culled[7] == false && noOutput.culled[4] == false;
+
+		for (uint32_t level = 0; level < r.groups.size(); level++)
+		{
+			std::cout << "  Level " << level << ":";
+			for (uint32_t p : r.groups[level])
+			{
+				std::cout << " " << frame.passes[p].name;
+			}
+			std::cout << std::endl;
+		}
+		std::cout << "  Result:" << (result ? "true" : "false") << std::endl;
+	}
+
+	// Barriers per pass, reads that were already made visible and write after read dependencies
+	void RenderGraphCompileTest2(const std::string& testName)
+	{
+		PrintTestHeader(testName);
+
+		MockFrame frame;
+		const RGCompileResult r = RGCompile(frame.passes, { &frame.final });
+
+		auto count = [&r](uint32_t pass) { return r.barrierBegin[pass + 1] - r.barrierBegin[pass]; };
+		auto first = [&r](uint32_t pass) -> const RGBarrier& { return r.barriers[r.barrierBegin[pass]]; };
+
+		bool result = true;
+		result = result && r.barriers.size() == 11;
+		result = result && count(0) == 1 && count(1) == 0 && count(2) == 1 && count(3) == 2 && count(4) == 2 && count(5) == 0
+			&& count(6) == 2 && count(7) == 1 && count(8) == 1 && count(9) == 1 && count(10) == 0;
+
+		// instances wait on the upload once, the second reader is already covered
+		result = result && first(0).srcPass == RGBarrier::EXTERNAL && first(0).buffer;
+		// depth written by the prepass and again by the gbuffer
+		result = result && first(2).resource == &frame.depth && first(2).srcPass == 1 && first(2).srcWrite && first(2).depth;
+		// lighting reads the gbuffer after ssao did, only shadow and ssao need a barrier
+		result = result && first(4).resource == &frame.shadow && r.barriers[r.barrierBegin[4] + 1].srcUsages == (1u << UAV);
+		// history is overwritten after lighting read it
+		result = result && first(7).resource == &frame.history && first(7).srcPass == 4 && first(7).srcWrite == false;
+		result = result && first(9).srcPass == 8 && first(9).srcUsages == (1u << UAV) && first(9).dstUsage == ATTACHMENT;
+
+		// a read and a write of the same resource in one pass is one access
+		int tex;
+		const std::vector<RGPassDesc> rmw{
+			{ "A", { RGAccess{ &tex, UAV, true } } },
+			{ "B", { RGAccess{ &tex, SRV, false }, RGAccess{ &tex, UAV, true } } },
+		};
+		const RGCompileResult r2 = RGCompile(rmw, { &tex });
+		result = result && r2.barriers.size() == 1 && r2.barriers[0].srcPass == 0 && r2.barriers[0].dstWrite && r2.level[1] == 1;
+
+		size_t declared{};
+		for (const RGPassDesc& p : frame.passes)
+		{
+			declared += p.accesses.size();
+		}
+		std::cout << "  Declared accesses:" << declared << " Barriers:" << r.barriers.size() << std::endl;
+		std::cout << "  Result:" << (result ? "true" : "false") << std::endl;
+	}
+
+#pragma endregion
+
+#pragma region TransientAliasing
+
+/** Transient aliasing -- 2 tests, lifetimes and memory packing without a device **/
+
+	// Most memory alive at any one step, no packing can go below this
+	uint64_t PeakLiveMemory(const std::vector<RGAliasRequest>& requests)
+	{
+		uint64_t peak{};
+		for (uint32_t step = 0; step < RG_MAX_TIMELINE; step++)
+		{
+			uint64_t live{};
+			for (const RGAliasRequest& r : requests)
+			{
+				live += r.lifetime.test(step) ? r.size : 0;
+			}
+			peak = std::max(peak, live);
+		}
+		return peak;
+	}
+
+	// Hand checked layout, then random lifetimes checked for overlap, alignment and waste
+	void TransientAliasingTest1(const std::string& testName)
+	{
+		PrintTestHeader(testName);
+
+		auto steps = [](uint32_t first, uint32_t last) {
+			RGLifetime l;
+			for (uint32_t i = first; i <= last; i++) l.set(i);
+			return l;
+		};
+
+		bool result = true;
+		{
+			const std::vector<RGAliasRequest> requests{ { 100, 4, steps(0, 1) }, { 100, 4, steps(2, 3) }, { 50, 4, steps(1, 2) } };
+			const RGAliasLayout layout = RGPackAliases(requests);
+			result = result && layout.offsets == std::vector<uint64_t>{ 0, 0, 100 } && layout.heapSize == 150 && layout.unaliasedSize == 250;
+			result = result && RGAliasLayoutValid(requests, layout);
+
+			// the same layout no longer fits once the first two are alive together
+			std::vector<RGAliasRequest> overlapping = requests;
+			overlapping[1].lifetime |= steps(1, 1);
+			result = result && RGAliasLayoutValid(overlapping, layout) == false;
+		}
+
+		std::mt19937 rng(13);
+		std::uniform_int_distribution<uint64_t> sizes(1, 1 << 20);
+		std::uniform_int_distribution<uint32_t> alignments(0, 8);
+		std::uniform_int_distribution<uint32_t> starts(0, 63);
+		std::uniform_int_distribution<uint32_t> lengths(0, 12);
+
+		size_t errors{};
+		uint64_t heap{}, unaliased{}, peak{};
+		for (int run = 0; run < 20; run++)
+		{
+			std::vector<RGAliasRequest> requests(100);
+			for (RGAliasRequest& r : requests)
+			{
+				r.size = sizes(rng);
+				r.alignment = 256ull << alignments(rng);
+				const uint32_t first = starts(rng);
+				r.lifetime = steps(first, std::min(first + lengths(rng), 63u));
+			}
+			const RGAliasLayout layout = RGPackAliases(requests);
+			const uint64_t lowerBound = PeakLiveMemory(requests);
+			errors += RGAliasLayoutValid(requests, layout) == false;
+			errors += layout.heapSize < lowerBound || layout.heapSize > layout.unaliasedSize;
+			heap += layout.heapSize;
+			unaliased += layout.unaliasedSize;
+			peak += lowerBound;
+		}
+
+		std::cout << "  Aliased:" << (heap >> 20) << "MB Unaliased:" << (unaliased >> 20) << "MB Peak live:" << (peak >> 20) << "MB" << std::endl;
+		std::cout << "  Result:" << (result && errors == 0 ? "true" : "false") << " errors:" << errors << std::endl;
+	}
+
+	// Transient render targets of the current pass list at 4K, with either ambient occlusion pass
+	void TransientAliasingTest2(const std::string& testName)
+	{
+		PrintTestHeader(testName);
+
+		constexpr uint64_t width = 3840;
+		constexpr uint64_t height = 2160;
+		constexpr uint64_t alignment = 64 * 1024;
+		auto bytes = [](float scale, uint64_t bpp) {
+			const uint64_t size = uint64_t(width * scale) * uint64_t(height * scale) * bpp;
+			return (size + alignment - 1) / alignment * alignment;
+		};
+
+		// persistent resources only matter for the order, the shadow atlas, depth and history are never transient
+		int depth, shadow, lighting, velocity, entity, final, luminance;
+		int normal, albedo, material, emissive, ssaoRaw, ssaoFinal, bright;
+		int bloomDown[5];
+
+		struct Transient { const void* key; uint64_t size; };
+		std::vector<Transient> transients{
+			{ &normal, bytes(1.0f, 4) }, { &albedo, bytes(1.0f, 4) }, { &material, bytes(1.0f, 4) }, { &emissive, bytes(1.0f, 8) },
+			{ &ssaoRaw, bytes(0.5f, 4) }, { &ssaoFinal, bytes(1.0f, 1) }, { &bright, bytes(1.0f, 8) },
+		};
+		float scale = 0.5f;
+		for (int& down : bloomDown)
+		{
+			transients.push_back({ &down, bytes(scale, 8) });
+			scale /= 2.0f;
+		}
+
+		auto buildFrame = [&](bool xegtao) {
+			auto tex = [&transients](const void* r, ResourceUsage u, bool w) {
+				const bool transient = std::any_of(transients.begin(), transients.end(), [r](const Transient& t) { return t.key == r; });
+				return RGAccess{ r, u, w, false, false, transient };
+			};
+			std::vector<RGPassDesc> passes{
+				{ "Shadow",		{ tex(&shadow, ATTACHMENT, true) } },
+				{ "ZPrePass",	{ tex(&depth, ATTACHMENT, true) } },
+				{ "GBuffer",	{ tex(&normal, ATTACHMENT, true), tex(&albedo, ATTACHMENT, true), tex(&material, ATTACHMENT, true), tex(&emissive, ATTACHMENT, true),
+								  tex(&velocity, ATTACHMENT, true), tex(&entity, ATTACHMENT, true), tex(&depth, ATTACHMENT, true) } },
+				xegtao ? RGPassDesc{ "XeGTAO",	{ tex(&depth, SRV, false), tex(&normal, SRV, false), tex(&ssaoFinal, UAV, true) } }
+					   : RGPassDesc{ "SSAO",	{ tex(&ssaoFinal, ATTACHMENT, true), tex(&ssaoRaw, ATTACHMENT, true), tex(&depth, SRV, false), tex(&normal, SRV, false) } },
+				{ "Lighting",	{ tex(&lighting, ATTACHMENT, true), tex(&depth, SRV, false), tex(&normal, SRV, false), tex(&albedo, SRV, false),
+								  tex(&material, SRV, false), tex(&emissive, SRV, false), tex(&shadow, SRV, false), tex(&ssaoFinal, SRV, false) } },
+				{ "Sky",		{ tex(&lighting, ATTACHMENT, true), tex(&depth, ATTACHMENT, true) } },
+				{ "Histogram",	{ tex(&lighting, SRV, false), RGAccess{ &luminance, UAV, true, true } } },
+				{ "ForwardUI",	{ tex(&lighting, ATTACHMENT, true), tex(&velocity, ATTACHMENT, true), tex(&entity, ATTACHMENT, true), tex(&depth, ATTACHMENT, true) } },
+				{ "Particles",	{ tex(&final, ATTACHMENT, true), tex(&entity, ATTACHMENT, true), tex(&depth, ATTACHMENT, true) } },
+				{ "Bloom",		{ tex(&final, UAV, true), tex(&bright, UAV, true), tex(&bloomDown[0], UAV, true), tex(&bloomDown[1], UAV, true), tex(&bloomDown[2], UAV, true),
+								  tex(&bloomDown[3], UAV, true), tex(&bloomDown[4], UAV, true), tex(&lighting, SRV, false), RGAccess{ &luminance, SRV, false, true } } },
+				{ "ScreenSpaceUI",	{ tex(&final, ATTACHMENT, true) } },
+				{ "DebugDraw",	{ tex(&final, ATTACHMENT, true) } },
+			};
+			return passes;
+		};
+
+		std::vector<const void*> keys;
+		std::vector<RGAliasRequest> requests;
+		for (const Transient& t : transients)
+		{
+			keys.push_back(t.key);
+			requests.push_back({ t.size, alignment, {} });
+		}
+
+		// every pass list gets its own range of the timeline, the same as the pool does
+		uint32_t timeline = 0;
+		bool result = true;
+		RGAliasLayout single;
+		for (bool xegtao : { true, false })
+		{
+			const std::vector<RGPassDesc> passes = buildFrame(xegtao);
+			const RGCompileResult compiled = RGCompile(passes, { &final, &luminance });
+			result = result && compiled.culled == std::vector<bool>(passes.size(), false);
+
+			std::vector<RGLifetime> lifetimes;
+			RGComputeLifetimes(passes, compiled, keys, timeline, lifetimes);
+			timeline += static_cast<uint32_t>(compiled.order.size());
+			for (size_t i = 0; i < requests.size(); i++)
+			{
+				requests[i].lifetime |= lifetimes[i];
+			}
+
+			// every transient starts the frame with a discard
+			size_t discards{};
+			for (const RGBarrier& b : compiled.barriers)
+			{
+				discards += b.discard;
+			}
+			result = result && discards == (xegtao ? transients.size() - 1 : transients.size());
+
+			if (xegtao)
+			{
+				single = RGPackAliases(requests);
+				result = result && RGAliasLayoutValid(requests, single);
+			}
+		}
+
+		const RGAliasLayout layout = RGPackAliases(requests);
+		result = result && RGAliasLayoutValid(requests, layout);
+		result = result && layout.heapSize == PeakLiveMemory(requests) && layout.heapSize < layout.unaliasedSize;
+		// the bloom chain lives after the gbuffer is done with
+		result = result && layout.offsets[6] < requests[3].size;
+
+		std::cout << std::fixed << std::setprecision(1);
+		std::cout << "  Without aliasing:" << layout.unaliasedSize / 1048576.0 << "MB" << std::endl;
+		std::cout << "  With aliasing, XeGTAO only:" << single.heapSize / 1048576.0 << "MB" << std::endl;
+		std::cout << "  With aliasing, both AO passes:" << layout.heapSize / 1048576.0 << "MB" << std::endl;
+		std::cout << "  Result:" << (result ? "true" : "false") << std::endl;
+	}
+
+#pragma endregion
+
+#pragma region PipelineCache
+
+/** Pipeline cache -- 2 tests, the file header and the warmup manifest without a device **/
+
+	// Cache files are only handed to the driver when they are whole and were written by the same device and driver
+	void PipelineCacheTest1(const std::string& testName)
+	{
+		PrintTestHeader(testName);
+
+		VkPhysicalDeviceProperties props{};
+		props.vendorID = 0x10DE;
+		props.deviceID = 0x2484;
+		for (uint32_t i = 0; i < VK_UUID_SIZE; i++)
+		{
+			props.pipelineCacheUUID[i] = static_cast<uint8_t>(i * 7);
+		}
+
+		// what vkGetPipelineCacheData hands back, the driver's header and its blobs
+		std::vector<char> blob(4096);
+		VkPipelineCacheHeaderVersionOne vkHeader{};
+		vkHeader.headerSize = sizeof(vkHeader);
+		vkHeader.headerVersion = VK_PIPELINE_CACHE_HEADER_VERSION_ONE;
+		vkHeader.vendorID = props.vendorID;
+		vkHeader.deviceID = props.deviceID;
+		memcpy(vkHeader.pipelineCacheUUID, props.pipelineCacheUUID, VK_UUID_SIZE);
+		std::mt19937 rng(14);
+		for (char& c : blob)
+		{
+			c = static_cast<char>(rng());
+		}
+		memcpy(blob.data(), &vkHeader, sizeof(vkHeader));
+
+		const std::vector<char> file = PackPipelineCacheFile(blob.data(), blob.size());
+		std::vector<char> data;
+		bool result = UnpackPipelineCacheFile(file, props, data) && data == blob;
+
+		// new driver
+		VkPhysicalDeviceProperties updated = props;
+		updated.pipelineCacheUUID[3] ^= 1;
+		result = result && UnpackPipelineCacheFile(file, updated, data) == false && data.empty();
+
+		// another gpu from the same vendor
+		VkPhysicalDeviceProperties other = props;
+		other.deviceID = 0x2204;
+		result = result && UnpackPipelineCacheFile(file, other, data) == false;
+
+		// one flipped bit anywhere, or a write that stopped part way
+		size_t accepted{};
+		for (size_t i = 0; i < file.size(); i += 97)
+		{
+			std::vector<char> damaged = file;
+			damaged[i] ^= 0x10;
+			accepted += UnpackPipelineCacheFile(damaged, props, data);
+		}
+		for (size_t size : { size_t(0), size_t(8), file.size() / 2, file.size() - 1 })
+		{
+			accepted += UnpackPipelineCacheFile(std::vector<char>(file.begin(), file.begin() + size), props, data);
+		}
+
+		// a header too small to hold the driver's own
+		const std::vector<char> tiny = PackPipelineCacheFile(blob.data(), 16);
+		accepted += UnpackPipelineCacheFile(tiny, props, data);
+
+		std::cout << "  Damaged files accepted:" << accepted << std::endl;
+		std::cout << "  Result:" << (result && accepted == 0 ? "true" : "false") << std::endl;
+	}
+
+	// Pipelines read back from the manifest hash to the same keys they were recorded under
+	void PipelineCacheTest2(const std::string& testName)
+	{
+		PrintTestHeader(testName);
+
+		auto binding = [](uint32_t b, VkDescriptorType type, VkShaderStageFlags stages) {
+			VkDescriptorSetLayoutBinding result{};
+			result.binding = b;
+			result.descriptorType = type;
+			result.descriptorCount = 1;
+			result.stageFlags = stages;
+			return result;
+		};
+
+		std::vector<PipelineDesc> descs(2);
+		descs[0].bindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+		descs[0].shaders = { "Shaders/bin/gbuffer.vert.spv", "Shaders/bin/gbuffer.frag.spv" };
+		descs[0].sets = {
+			{ binding(0, VK_DESCRIPTOR_TYPE_SAMPLER, VK_SHADER_STAGE_ALL_GRAPHICS), binding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS) },
+			{ binding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_ALL_GRAPHICS | VK_SHADER_STAGE_COMPUTE_BIT) },
+		};
+		descs[0].colourFormats = { VK_FORMAT_R8G8B8A8_UNORM, VK_FORMAT_R16G16B16A16_SFLOAT, VK_FORMAT_R32_SINT };
+		descs[0].depthFormat = VK_FORMAT_D32_SFLOAT_S8_UINT;
+		descs[0].layoutHash = 0x1234;
+
+		descs[1].bindPoint = VK_PIPELINE_BIND_POINT_COMPUTE;
+		descs[1].shaders = { "Shaders/bin/histogram.comp.spv" };
+		descs[1].sets = { { binding(0, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT), binding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT) } };
+		descs[1].layoutHash = 0x5678;
+
+		for (PipelineDesc& d : descs)
+		{
+			d.hash = d.ComputeHash();
+		}
+
+		// the same shaders drawing into other formats is another pipeline
+		PipelineDesc otherFormats = descs[0];
+		otherFormats.colourFormats[0] = VK_FORMAT_B8G8R8A8_UNORM;
+		bool result = otherFormats.ComputeHash() != descs[0].hash && descs[0].hash != descs[1].hash;
+
+		// damaged lines are skipped, the rest still loads
+		const std::string text = WritePipelineManifest(descs) + "ffff 1 7 a.spv\n\n" + "not a pipeline\n";
+		const std::vector<PipelineDesc> loaded = ReadPipelineManifest(text);
+		result = result && loaded.size() == descs.size();
+		for (size_t i = 0; result && i < loaded.size(); i++)
+		{
+			const PipelineDesc& a = descs[i];
+			const PipelineDesc& b = loaded[i];
+			result = a.hash == b.hash && a.bindPoint == b.bindPoint && a.shaders == b.shaders && a.colourFormats == b.colourFormats
+				&& a.depthFormat == b.depthFormat && a.sets.size() == b.sets.size();
+			for (size_t s = 0; result && s < a.sets.size(); s++)
+			{
+				result = a.sets[s].size() == b.sets[s].size();
+				for (size_t j = 0; result && j < a.sets[s].size(); j++)
+				{
+					result = a.sets[s][j].binding == b.sets[s][j].binding && a.sets[s][j].descriptorType == b.sets[s][j].descriptorType
+						&& a.sets[s][j].descriptorCount == b.sets[s][j].descriptorCount && a.sets[s][j].stageFlags == b.sets[s][j].stageFlags;
+				}
+			}
+			// the layout hash is made again from the bindings on warmup
+			PipelineDesc rehashed = b;
+			rehashed.layoutHash = a.layoutHash;
+			result = result && rehashed.ComputeHash() == a.hash;
+		}
+
+		std::cout << "  Manifest:" << text.size() << " bytes, " << loaded.size() << " pipelines" << std::endl;
+		std::cout << "  Result:" << (result ? "true" : "false") << std::endl;
+	}
+
+#pragma endregion
+
+#pragma region ShardedRegistry
+
+/** Sharded registry -- hammers the pipeline registry from many threads with a fake builder **/
+
+	// Every key is built exactly once however many threads miss on it together, and everyone gets the same value
+	void ShardedRegistryStressTest(const std::string& testName)
+	{
+		PrintTestHeader(testName);
+
+		constexpr uint32_t numKeys = 512;
+		constexpr uint32_t lookupsPerThread = 200000;
+		const uint32_t numThreads = std::max(4u, std::thread::hardware_concurrency());
+
+		ShardedRegistry<const uint32_t*> registry;
+		std::vector<uint32_t> values(numKeys);
+		std::vector<std::atomic<uint32_t>> buildCounts(numKeys);
+		std::atomic<uint32_t> wrongValues{};
+		std::atomic<bool> go{ false };
+
+		std::vector<std::thread> threads;
+		for (uint32_t t = 0; t < numThreads; t++)
+		{
+			threads.emplace_back([&, t]() {
+				std::mt19937 rng(t);
+				// most threads start on the same few keys so they miss together
+				std::uniform_int_distribution<uint32_t> hot(0, 7);
+				std::uniform_int_distribution<uint32_t> any(0, numKeys - 1);
+				while (go.load() == false) std::this_thread::yield();
+
+				for (uint32_t i = 0; i < lookupsPerThread; i++)
+				{
+					const uint32_t k = i < 64 ? hot(rng) : any(rng);
+					// spread over the whole range, as pipeline hashes are
+					const size_t key = (size_t(k) + 1) * 0x9E3779B97F4A7C15ull;
+					const uint32_t* v = registry.GetOrBuild(key, [&, k]() {
+						buildCounts[k].fetch_add(1);
+						// a pipeline takes a while to compile, give the other threads time to miss on it too
+						std::this_thread::sleep_for(std::chrono::microseconds(200));
+						values[k] = k * 3 + 1;
+						return &values[k];
+					});
+					if (v != &values[k] || *v != k * 3 + 1)
+					{
+						wrongValues.fetch_add(1);
+					}
+				}
+			});
+		}
+
+		const auto start = std::chrono::high_resolution_clock::now();
+		go = true;
+		for (auto& t : threads) t.join();
+		const float ms = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+		uint32_t builtTwice{}, neverBuilt{};
+		for (auto& c : buildCounts)
+		{
+			builtTwice += c.load() > 1;
+			neverBuilt += c.load() == 0;
+		}
+		size_t visited{};
+		registry.ForEach([&](size_t, const uint32_t* v) { visited += (v >= values.data() && v < values.data() + numKeys); });
+
+		const auto stats = registry.GetStats();
+		const bool result = wrongValues == 0 && builtTwice == 0 && stats.builds == numKeys - neverBuilt
+			&& registry.Size() == stats.builds && visited == stats.builds;
+
+		std::cout << "  Threads:" << numThreads << " Lookups:" << uint64_t(numThreads) * lookupsPerThread << " in " << ms << "ms" << std::endl;
+		std::cout << "  Builds:" << stats.builds << " Waited on another build:" << stats.waits << " Built twice:" << builtTwice << std::endl;
+		std::cout << "  Result:" << (result ? "true" : "false") << std::endl;
+	}
+
+#pragma endregion
+
+#pragma region MeshRangeAllocator
+
+/** Mesh range allocator -- randomized load and unload traces over the vertex and index pools **/
+
+	// Checks every range against a plain list of what is allocated, through frees, growth, compaction and shrinking
+	void MeshRangeAllocatorTest1(const std::string& testName)
+	{
+		PrintTestHeader(testName);
+
+		bool result = true;
+
+		// size classes round the right way and cover every size
+		for (uint32_t size = 1; size < (1u << 20); size = size + 1 + size / 7)
+		{
+			const uint32_t up = MeshRangeSizeClass::ToSize(MeshRangeSizeClass::RoundUp(size));
+			const uint32_t down = MeshRangeSizeClass::ToSize(MeshRangeSizeClass::RoundDown(size));
+			result = result && up >= size && down <= size;
+		}
+
+		struct Live
+		{
+			MeshRangeAllocator::Allocation a;
+			uint32_t size;
+			uint32_t tag;	// stands in for the contents, moves must carry it along
+		};
+
+		MeshRangeAllocator alloc(4096);
+		std::vector<Live> live;
+		std::vector<uint32_t> memory(alloc.GetCapacity(), 0);	// tag of whoever owns each element
+		std::mt19937 rng(1234);
+		std::uniform_int_distribution<uint32_t> sizeDist(1, 700);
+		uint32_t nextTag = 1;
+		uint32_t overlaps{}, lostData{}, invalid{}, compactions{};
+
+		auto checkLive = [&]() {
+			for (const Live& l : live)
+			{
+				const uint32_t offset = alloc.GetOffset(l.a.node);
+				if (offset == MeshRangeAllocator::NO_SPACE || alloc.GetSize(l.a.node) != l.size)
+				{
+					++lostData;
+					continue;
+				}
+				for (uint32_t i = offset; i < offset + l.size; i++)
+				{
+					lostData += memory[i] != l.tag;
+				}
+			}
+		};
+
+		for (uint32_t step = 0; step < 20000; step++)
+		{
+			const uint32_t roll = rng() % 100;
+			if (roll < 55 || live.empty())
+			{
+				Live l{ {}, sizeDist(rng), nextTag++ };
+				l.a = alloc.AllocateOrGrow(l.size);
+				if (l.a.offset == MeshRangeAllocator::NO_SPACE)
+				{
+					++invalid;
+					continue;
+				}
+				if (memory.size() < alloc.GetCapacity()) memory.resize(alloc.GetCapacity(), 0);
+				for (uint32_t i = l.a.offset; i < l.a.offset + l.size; i++)
+				{
+					overlaps += memory[i] != 0;
+					memory[i] = l.tag;
+				}
+				live.push_back(l);
+			}
+			else if (roll < 98)
+			{
+				const size_t idx = rng() % live.size();
+				const Live l = live[idx];
+				const uint32_t offset = alloc.GetOffset(l.a.node);
+				std::fill(memory.begin() + offset, memory.begin() + offset + l.size, 0u);
+				alloc.Free(l.a);
+				live[idx] = live.back();
+				live.pop_back();
+			}
+			else
+			{
+				// what the renderer does with the GPU copies, into a fresh buffer so moves cannot trample each other
+				++compactions;
+				const auto moves = alloc.Compact();
+				std::vector<uint32_t> moved = memory;
+				for (const auto& m : moves)
+				{
+					std::fill(moved.begin() + m.srcOffset, moved.begin() + m.srcOffset + m.size, 0u);
+				}
+				for (const auto& m : moves)
+				{
+					std::copy(memory.begin() + m.srcOffset, memory.begin() + m.srcOffset + m.size, moved.begin() + m.dstOffset);
+				}
+				memory = std::move(moved);
+
+				const auto report = alloc.GetReport();
+				result = result && report.freeRanges <= 1 && report.usedEnd == report.used;
+				alloc.Shrink(report.usedEnd + report.usedEnd / 4);
+				memory.resize(alloc.GetCapacity());
+				checkLive();
+			}
+			invalid += alloc.Validate() == false;
+		}
+		checkLive();
+
+		for (const Live& l : live) alloc.Free(l.a);
+		const auto empty = alloc.GetReport();
+		result = result && overlaps == 0 && lostData == 0 && invalid == 0 && alloc.Validate()
+			&& empty.allocations == 0 && empty.freeRanges == 1 && empty.largestFree == empty.capacity;
+
+		std::cout << "  Compactions:" << compactions << " Capacity:" << empty.capacity << std::endl;
+		std::cout << "  Overlaps:" << overlaps << " Lost data:" << lostData << " Invalid states:" << invalid << std::endl;
+		std::cout << "  Result:" << (result ? "true" : "false") << std::endl;
+	}
+
+	// Streams levels in and out with mesh sized allocations, compares the buffer the old bump offsets needed with the range allocator.
+	// The GPU buffer only grows to the last element written, so the high water mark of used ranges is what it costs.
+	void MeshRangeAllocatorTest2(const std::string& testName)
+	{
+		PrintTestHeader(testName);
+
+		// a few big meshes, a lot of small props
+		std::mt19937 rng(42);
+		std::lognormal_distribution<float> meshSize(8.0f, 1.5f);
+		auto vertexCount = [&]() { return std::clamp(static_cast<uint32_t>(meshSize(rng)), 24u, 1u << 20); };
+
+		constexpr uint32_t numLevels = 40;
+		constexpr uint32_t levelsLoaded = 3;	// the current level and its neighbours
+		std::vector<std::vector<uint32_t>> levelMeshes(numLevels);
+		for (auto& meshes : levelMeshes)
+		{
+			meshes.resize(60 + rng() % 140);
+			for (uint32_t& m : meshes) m = vertexCount();
+		}
+
+		MeshRangeAllocator alloc;
+		MeshRangeAllocator compacted;
+		std::vector<std::vector<MeshRangeAllocator::Allocation>> loaded(numLevels), loadedCompacted(numLevels);
+		uint64_t bumpEnd{}, peakLive{}, live{}, ops{}, moved{}, compactions{};
+		uint64_t peakEnd{}, peakEndCompacted{};
+		float worstFragmentation{};
+		bool result = true;
+
+		float allocMs{}, compactMs{};
+		for (uint32_t pass = 0; pass < 4; pass++)
+		{
+			for (uint32_t level = 0; level < numLevels; level++)
+			{
+				const uint32_t unload = (level + numLevels - levelsLoaded) % numLevels;
+				auto t0 = std::chrono::high_resolution_clock::now();
+				for (auto& a : loaded[unload])
+				{
+					live -= alloc.GetSize(a.node);
+					alloc.Free(a);
+					++ops;
+				}
+				loaded[unload].clear();
+				for (uint32_t size : levelMeshes[level])
+				{
+					loaded[level].push_back(alloc.AllocateOrGrow(size));
+					result = result && loaded[level].back().offset != MeshRangeAllocator::NO_SPACE;
+					live += size;
+					bumpEnd += size;
+					++ops;
+				}
+				allocMs += std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - t0).count();
+				peakLive = std::max(peakLive, live);
+				peakEnd = std::max<uint64_t>(peakEnd, alloc.GetReport().usedEnd);
+				worstFragmentation = std::max(worstFragmentation, alloc.GetFragmentation());
+
+				// same trace, defragmenting when the renderer would
+				for (auto& a : loadedCompacted[unload]) compacted.Free(a);
+				loadedCompacted[unload].clear();
+				t0 = std::chrono::high_resolution_clock::now();
+				if (compacted.GetFragmentation() > 0.5f && compacted.GetReport().totalFree > compacted.GetCapacity() / 4)
+				{
+					++compactions;
+					for (const auto& m : compacted.Compact()) moved += m.size;
+					compacted.Shrink(compacted.GetReport().usedEnd);
+				}
+				compactMs += std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - t0).count();
+				for (uint32_t size : levelMeshes[level]) loadedCompacted[level].push_back(compacted.AllocateOrGrow(size));
+				peakEndCompacted = std::max<uint64_t>(peakEndCompacted, compacted.GetReport().usedEnd);
+			}
+		}
+		result = result && alloc.Validate() && compacted.Validate();
+
+		const auto report = alloc.GetReport();
+		constexpr float toMB = sizeof(oGFX::GpuVertex) / (1024.0f * 1024.0f);
+		// freed ranges are reused, the buffer stays within a small multiple of what is ever loaded at once
+		result = result && peakEnd < peakLive * 2 && peakEndCompacted <= peakEnd && bumpEnd > peakEnd * 10;
+
+		std::cout << std::fixed << std::setprecision(1);
+		std::cout << "  Peak loaded:" << peakLive * toMB << "MB Bump offsets:" << bumpEnd * toMB << "MB" << std::endl;
+		std::cout << "  Range allocator:" << peakEnd * toMB << "MB, " << report.freeRanges << " free ranges at the end, largest "
+			<< report.largestFree * toMB << "MB, worst fragmentation " << std::setprecision(2) << worstFragmentation << std::endl;
+		std::cout << std::setprecision(1) << "  With defragmenting:" << peakEndCompacted * toMB << "MB, " << compactions << " times, moved " << moved * toMB << "MB in total" << std::endl;
+		std::cout << std::setprecision(3) << "  " << ops << " allocations and frees in " << allocMs << "ms, compacting " << compactMs << "ms" << std::endl;
+		std::cout << std::defaultfloat << "  Result:" << (result ? "true" : "false") << std::endl;
+	}
+
+#pragma endregion
+
+#pragma region MeshOptimizer
+
+/** Mesh optimizer -- deduplication and reordering on the sample models and on a synthetic grid **/
+
+	// Triangles as sorted position triples, the same mesh gives the same list however it was ordered
+	std::vector<std::array<float, 9>> CanonicalTriangles(const std::vector<oGFX::Vertex>& vertices, const std::vector<uint32_t>& indices)
+	{
+		std::vector<std::array<float, 9>> tris;
+		for (size_t t = 0; t + 2 < indices.size(); t += 3)
+		{
+			std::array<std::array<float, 3>, 3> corners;
+			for (size_t k = 0; k < 3; k++)
+			{
+				const glm::vec3& p = vertices[indices[t + k]].pos;
+				corners[k] = { p.x, p.y, p.z };
+			}
+			// rotate so the smallest corner is first, the winding stays
+			const size_t first = std::min_element(corners.begin(), corners.end()) - corners.begin();
+			std::array<float, 9> tri;
+			for (size_t k = 0; k < 3; k++)
+			{
+				std::copy(corners[(first + k) % 3].begin(), corners[(first + k) % 3].end(), tri.begin() + k * 3);
+			}
+			tris.push_back(tri);
+		}
+		std::sort(tris.begin(), tris.end());
+		return tris;
+	}
+
+	void PrintMeshReport(const oGFX::MeshOpt::Report& r)
+	{
+		std::cout << std::fixed << std::setprecision(3);
+		std::cout << "  Vertices:" << r.verticesBefore << " -> " << r.verticesAfter << std::endl;
+		std::cout << "  ACMR:" << r.cacheBefore.acmr << " -> " << r.cacheAfter.acmr
+			<< " ATVR:" << r.cacheBefore.atvr << " -> " << r.cacheAfter.atvr
+			<< " Overfetch:" << r.fetchBefore.overfetch << " -> " << r.fetchAfter.overfetch << std::endl;
+		std::cout << std::defaultfloat;
+	}
+
+	// Positions and triangles of an ascii PLY, what the sample models are
+	bool ReadPly(const std::string& path, std::vector<glm::vec3>& positions, std::vector<uint32_t>& indices)
+	{
+		std::ifstream file(path);
+		if (file.is_open() == false)
+			return false;
+
+		size_t numVertices{}, numFaces{};
+		std::string line;
+		while (std::getline(file, line) && line.rfind("end_header", 0) != 0)
+		{
+			std::istringstream in(line);
+			std::string word, element;
+			in >> word >> element;
+			if (word == "element" && element == "vertex") in >> numVertices;
+			if (word == "element" && element == "face") in >> numFaces;
+		}
+		positions.assign(numVertices, glm::vec3{});
+		for (glm::vec3& p : positions)
+		{
+			std::getline(file, line);
+			std::istringstream(line) >> p.x >> p.y >> p.z;
+		}
+		indices.clear();
+		for (size_t f = 0; f < numFaces; f++)
+		{
+			uint32_t n{}, a{}, b{}, c{};
+			file >> n >> a >> b >> c;
+			if (n == 3) indices.insert(indices.end(), { a, b, c });
+		}
+		return true;
+	}
+
+	// The bunny from the sample models, unindexed and shuffled the way a careless exporter would leave it
+	void MeshOptimizerTest1(const std::string& testName)
+	{
+		PrintTestHeader(testName);
+
+		std::vector<glm::vec3> positions;
+		std::vector<uint32_t> fileIndices;
+		if (ReadPly("Models/bunny.ply", positions, fileIndices) == false)
+		{
+			std::cout << "  Skipped, Models/bunny.ply not found" << std::endl;
+			return;
+		}
+		const size_t numVertices = positions.size();
+
+		// as the file has it
+		std::vector<oGFX::Vertex> vertices(numVertices);
+		for (size_t i = 0; i < numVertices; i++) vertices[i].pos = positions[i];
+		std::vector<uint32_t> indices = fileIndices;
+		const auto trianglesBefore = CanonicalTriangles(vertices, indices);
+
+		const auto start = std::chrono::high_resolution_clock::now();
+		const auto report = oGFX::MeshOpt::OptimizeMesh(vertices, indices, offsetof(oGFX::Vertex, pos));
+		const float ms = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		bool result = CanonicalTriangles(vertices, indices) == trianglesBefore
+			&& report.cacheAfter.acmr < std::min(0.8f, report.cacheBefore.acmr) && report.cacheAfter.atvr < 1.6f
+			&& report.fetchAfter.overfetch < report.fetchBefore.overfetch;
+
+		// unindexed and shuffled, the way a careless exporter would leave it, has to come back to one vertex per position
+		std::mt19937 rng(7);
+		std::vector<uint32_t> order(fileIndices.size() / 3);
+		std::iota(order.begin(), order.end(), 0u);
+		std::shuffle(order.begin(), order.end(), rng);
+
+		std::vector<oGFX::Vertex> soup;
+		std::vector<uint32_t> soupIndices;
+		for (uint32_t t : order)
+		{
+			for (uint32_t k = 0; k < 3; k++)
+			{
+				oGFX::Vertex v{};
+				v.pos = positions[fileIndices[t * 3 + k]];
+				soupIndices.push_back(static_cast<uint32_t>(soup.size()));
+				soup.push_back(v);
+			}
+		}
+		const std::vector<oGFX::Vertex> original = soup;
+
+		std::vector<uint32_t> fileRemap;
+		const auto soupReport = oGFX::MeshOpt::OptimizeMesh(soup, soupIndices, offsetof(oGFX::Vertex, pos), {}, &fileRemap);
+
+		// every distinct position the faces use, once
+		std::vector<std::array<float, 3>> distinct;
+		for (uint32_t i : fileIndices) distinct.push_back({ positions[i].x, positions[i].y, positions[i].z });
+		std::sort(distinct.begin(), distinct.end());
+		distinct.erase(std::unique(distinct.begin(), distinct.end()), distinct.end());
+
+		bool remapValid = fileRemap.size() == original.size();
+		for (size_t i = 0; remapValid && i < original.size(); i++)
+		{
+			remapValid = fileRemap[i] < soup.size() && soup[fileRemap[i]].pos == original[i].pos;
+		}
+		result = result && soup.size() == distinct.size() && remapValid && CanonicalTriangles(soup, soupIndices) == trianglesBefore
+			&& soupReport.cacheAfter.acmr < 0.8f;
+
+		std::cout << "  bunny.ply " << indices.size() / 3 << " triangles in " << ms << "ms" << std::endl;
+		PrintMeshReport(report);
+		std::cout << "  Unindexed and shuffled:" << std::endl;
+		PrintMeshReport(soupReport);
+		std::cout << "  Result:" << (result ? "true" : "false") << std::endl;
+	}
+
+	// A grid with split seams and bone keys, the split vertices come back together but vertices that only differ in bone weights do not.
+	// A degenerate first triangle keeps every triangle
+	void MeshOptimizerTest2(const std::string& testName)
+	{
+		PrintTestHeader(testName);
+
+		constexpr uint32_t N = 64;
+
+		std::vector<oGFX::Vertex> vertices;
+		std::vector<uint32_t> indices;
+		std::vector<uint64_t> boneKeys;
+		// every quad has its own four corners, as if each had been exported alone
+		for (uint32_t y = 0; y < N; y++)
+		{
+			for (uint32_t x = 0; x < N; x++)
+			{
+				const uint32_t base = static_cast<uint32_t>(vertices.size());
+				for (uint32_t c = 0; c < 4; c++)
+				{
+					oGFX::Vertex v{};
+					const uint32_t cx = x + (c & 1), cy = y + (c >> 1);
+					v.pos = glm::vec3(static_cast<float>(cx), static_cast<float>(cy), 0.0f);
+					v.norm = glm::vec3(0.0f, 0.0f, 1.0f);
+					vertices.push_back(v);
+					// the right half of the grid is skinned to another bone, its left edge is split along the seam
+					boneKeys.push_back(x >= N / 2 ? 1 : 0);
+				}
+				indices.insert(indices.end(), { base, base + 1, base + 2, base + 2, base + 1, base + 3 });
+			}
+		}
+		// the triangles come in a random order
+		std::mt19937 rng(3);
+		std::vector<uint32_t> order(indices.size() / 3);
+		std::iota(order.begin(), order.end(), 0u);
+		std::shuffle(order.begin(), order.end(), rng);
+		std::vector<uint32_t> shuffled;
+		for (uint32_t t : order) shuffled.insert(shuffled.end(), indices.begin() + t * 3, indices.begin() + t * 3 + 3);
+		indices = shuffled;
+
+		const auto trianglesBefore = CanonicalTriangles(vertices, indices);
+		const std::vector<oGFX::Vertex> original = vertices;
+		const std::vector<uint64_t> originalKeys = boneKeys;
+
+		std::vector<uint32_t> fileRemap;
+		const std::vector<oGFX::MeshOpt::VertexStream> streams{ { boneKeys.data(), sizeof(uint64_t), sizeof(uint64_t) } };
+		const auto report = oGFX::MeshOpt::OptimizeMesh(vertices, indices, offsetof(oGFX::Vertex, pos), streams, &fileRemap);
+
+		// where each vertex ended up has the same position and bone key it started with
+		std::vector<uint64_t> keyAfter(vertices.size(), ~0ull);
+		bool remapValid = fileRemap.size() == original.size();
+		for (size_t i = 0; remapValid && i < original.size(); i++)
+		{
+			const uint32_t v = fileRemap[i];
+			remapValid = v < vertices.size() && vertices[v].pos == original[i].pos && (keyAfter[v] == ~0ull || keyAfter[v] == originalKeys[i]);
+			if (remapValid) keyAfter[v] = originalKeys[i];
+		}
+
+		// the seam column is there once per bone
+		const size_t expectedVertices = (N + 1) * (N + 1) + (N + 1);
+
+		// cache ordering alone, the overdraw step may only cost a little of it
+		std::vector<uint32_t> cacheOnly = indices;
+		oGFX::MeshOpt::OptimizeVertexCache(cacheOnly.data(), cacheOnly.size(), vertices.size());
+		const auto cacheOnlyStats = oGFX::MeshOpt::AnalyzeVertexCache(cacheOnly.data(), cacheOnly.size(), vertices.size());
+
+		bool result = vertices.size() == expectedVertices && remapValid && CanonicalTriangles(vertices, indices) == trianglesBefore
+			&& report.cacheAfter.acmr < 0.8f && report.cacheAfter.acmr <= cacheOnlyStats.acmr * 1.1f
+			&& report.cacheBefore.acmr > 2.5f;
+
+		// two corners merged into one, the first triangle misses the cache fewer than three times
+		std::vector<oGFX::Vertex> degenerate(5);
+		for (uint32_t i = 0; i < 5; i++) degenerate[i].pos = glm::vec3(static_cast<float>(i), static_cast<float>(i * i), 1.0f);
+		const std::vector<uint32_t> degenerateIndices{ 0, 0, 1, 2, 3, 4 };
+		std::vector<uint32_t> overdrawOnly = degenerateIndices;
+		oGFX::MeshOpt::OptimizeOverdraw(overdrawOnly.data(), overdrawOnly.size(), &degenerate[0].pos.x, degenerate.size(), sizeof(oGFX::Vertex));
+		std::vector<oGFX::Vertex> degenerateMesh = degenerate;
+		std::vector<uint32_t> degenerateMeshIndices = degenerateIndices;
+		oGFX::MeshOpt::OptimizeMesh(degenerateMesh, degenerateMeshIndices, offsetof(oGFX::Vertex, pos));
+		const bool keptDegenerate = CanonicalTriangles(degenerate, overdrawOnly) == CanonicalTriangles(degenerate, degenerateIndices)
+			&& CanonicalTriangles(degenerateMesh, degenerateMeshIndices) == CanonicalTriangles(degenerate, degenerateIndices);
+		result = result && keptDegenerate;
+
+		std::cout << "  " << N << "x" << N << " grid, cache order alone ACMR:" << cacheOnlyStats.acmr << std::endl;
+		PrintMeshReport(report);
+		std::cout << "  Degenerate first triangle kept:" << keptDegenerate << std::endl;
+		std::cout << "  Result:" << (result ? "true" : "false") << std::endl;
+	}
+
+#pragma endregion
+#pragma region VertexPacking
+
+/** Vertex packing -- error bounds of the encode and decode, memory of the sample models packed **/
+
+	double AngleDegrees(const glm::vec3& a, const glm::vec3& b)
+	{
+		const glm::dvec3 da{ a }, db{ b };
+		return glm::degrees(std::atan2(glm::length(glm::cross(da, db)), glm::dot(da, db)));
+	}
+
+	// Round trip of every part of the vertex against the bounds in VertexPacking.h
+	void VertexPackingTest1(const std::string& testName)
+	{
+		PrintTestHeader(testName);
+		namespace VP = oGFX::VertexPacking;
+
+		std::mt19937 rng(11);
+		std::normal_distribution<float> normal;
+		std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+		// directions, random and the octahedron's corners and edges where the folding happens
+		std::vector<glm::vec3> directions;
+		for (int i = 0; i < 200000; i++)
+		{
+			const glm::vec3 d{ normal(rng), normal(rng), normal(rng) };
+			if (glm::dot(d, d) > 0.0f) directions.push_back(glm::normalize(d));
+		}
+		for (int x = -1; x <= 1; x++)
+			for (int y = -1; y <= 1; y++)
+				for (int z = -1; z <= 1; z++)
+					if (x || y || z) directions.push_back(glm::normalize(glm::vec3(x, y, z)));
+
+		double worstAngle = 0.0;
+		bool stable = true;
+		for (const glm::vec3& d : directions)
+		{
+			int16_t q[2];
+			VP::OctEncode(d, q);
+			const glm::vec3 decoded = VP::OctDecode(q);
+			worstAngle = std::max(worstAngle, AngleDegrees(decoded, d));
+
+			// the fold has two codes for the same direction, either is fine
+			int16_t again[2];
+			VP::OctEncode(decoded, again);
+			stable = stable && VP::OctDecode(again) == decoded;
+		}
+
+		// positions in boxes of every size and place
+		float worstPosition = 0.0f;
+		for (int i = 0; i < 200000; i++)
+		{
+			const float size = std::pow(10.0f, unit(rng) * 6.0f - 3.0f);
+			const glm::vec4 dequant{ (unit(rng) - 0.5f) * 200.0f, (unit(rng) - 0.5f) * 200.0f, (unit(rng) - 0.5f) * 200.0f, size };
+			oGFX::Vertex v{};
+			v.pos = glm::vec3{ dequant } + glm::vec3{ unit(rng), unit(rng), unit(rng) } * size;
+			const oGFX::PackedVertex packed = VP::Pack(v, dequant);
+			const glm::vec3 error = glm::abs(VP::Unpack(packed, dequant).pos - v.pos);
+			worstPosition = std::max(worstPosition, std::max({ error.x, error.y, error.z }) / VP::PositionErrorBound(dequant));
+
+			const oGFX::PackedVertex repacked = VP::Pack(VP::Unpack(packed, dequant), dequant);
+			stable = stable && std::equal(std::begin(packed.pos), std::end(packed.pos), std::begin(repacked.pos));
+		}
+
+		// UVs tiled well past [0,1] and down to the subnormal halves
+		float worstTexCoord = 0.0f;
+		for (int i = 0; i < 200000; i++)
+		{
+			const float t = (unit(rng) - 0.5f) * std::pow(2.0f, unit(rng) * 30.0f - 22.0f);
+			oGFX::Vertex v{};
+			v.tex = glm::vec2{ t, -t };
+			const glm::vec2 decoded = VP::Unpack(VP::Pack(v, glm::vec4{ 0.0f, 0.0f, 0.0f, 1.0f }), glm::vec4{ 0.0f, 0.0f, 0.0f, 1.0f }).tex;
+			worstTexCoord = std::max(worstTexCoord, std::abs(decoded.x - t) / VP::TexCoordErrorBound(t));
+			worstTexCoord = std::max(worstTexCoord, std::abs(decoded.y + t) / VP::TexCoordErrorBound(t));
+		}
+
+		const bool result = worstAngle <= VP::DIRECTION_ERROR_DEGREES && worstPosition <= 1.0f && worstTexCoord <= 1.0f && stable;
+
+		std::cout << std::setprecision(4);
+		std::cout << "  Direction:" << worstAngle << " deg (bound " << VP::DIRECTION_ERROR_DEGREES << ")"
+			<< " Position:" << worstPosition << " of the bound, UV:" << worstTexCoord << " of the bound" << std::endl;
+		std::cout << std::defaultfloat;
+		std::cout << "  Result:" << (result ? "true" : "false") << std::endl;
+	}
+
+	// The memory the sample models take packed, and how far their decoded vertices are from the originals
+	void VertexPackingTest2(const std::string& testName)
+	{
+		PrintTestHeader(testName);
+		namespace VP = oGFX::VertexPacking;
+
+		std::vector<std::pair<std::string, std::vector<oGFX::Vertex>>> models{
+			{ "Default cube", CreateDefaultCubeMesh().m_VertexBuffer },
+			{ "Default plane XZ", CreateDefaultPlaneXZMesh().m_VertexBuffer },
+			{ "Default plane XY", CreateDefaultPlaneXYMesh().m_VertexBuffer },
+		};
+
+		std::vector<glm::vec3> positions;
+		std::vector<uint32_t> indices;
+		if (ReadPly("Models/bunny.ply", positions, indices))
+		{
+			// the file only has positions, smooth normals and some tangent like the importer would make
+			std::vector<oGFX::Vertex> bunny(positions.size());
+			for (size_t i = 0; i < positions.size(); i++) bunny[i].pos = positions[i];
+			for (size_t t = 0; t + 2 < indices.size(); t += 3)
+			{
+				const glm::vec3 n = glm::cross(positions[indices[t + 1]] - positions[indices[t]], positions[indices[t + 2]] - positions[indices[t]]);
+				for (size_t k = 0; k < 3; k++) bunny[indices[t + k]].norm += n;
+			}
+			for (oGFX::Vertex& v : bunny)
+			{
+				v.norm = glm::dot(v.norm, v.norm) > 0.0f ? glm::normalize(v.norm) : glm::vec3{ 0.0f, 1.0f, 0.0f };
+				const glm::vec3 axis = std::abs(v.norm.x) < 0.9f ? glm::vec3{ 1.0f, 0.0f, 0.0f } : glm::vec3{ 0.0f, 1.0f, 0.0f };
+				v.tangent = glm::normalize(glm::cross(v.norm, axis));
+				v.tex = glm::vec2{ v.pos.x, v.pos.y } * 10.0f;
+			}
+			models.emplace_back("bunny.ply", std::move(bunny));
+		}
+		else
+		{
+			std::cout << "  Models/bunny.ply not found, default meshes only" << std::endl;
+		}
+
+		bool result = true;
+		VP::MemoryReport total;
+		std::cout << std::fixed << std::setprecision(2);
+		for (const auto& [name, vertices] : models)
+		{
+			VP::MemoryReport report;
+			report.Add(vertices.data(), vertices.size());
+			total.Add(vertices.data(), vertices.size());
+
+			const glm::vec4 dequant = VP::ComputePositionDequant(vertices.data(), vertices.size());
+			std::vector<oGFX::PackedVertex> packed(vertices.size());
+			VP::Pack(vertices.data(), vertices.size(), dequant, packed.data());
+
+			float worstPosition = 0.0f;
+			double worstNormal = 0.0;
+			for (size_t i = 0; i < vertices.size(); i++)
+			{
+				const oGFX::Vertex decoded = VP::Unpack(packed[i], dequant);
+				const glm::vec3 error = glm::abs(decoded.pos - vertices[i].pos);
+				worstPosition = std::max({ worstPosition, error.x, error.y, error.z });
+				worstNormal = std::max({ worstNormal, AngleDegrees(decoded.norm, vertices[i].norm), AngleDegrees(decoded.tangent, vertices[i].tangent) });
+			}
+			result = result && worstPosition <= VP::PositionErrorBound(dequant) && worstNormal <= VP::DIRECTION_ERROR_DEGREES;
+
+			std::cout << "  " << std::left << std::setw(18) << name << std::right << std::setw(7) << report.vertices << " vertices "
+				<< std::setw(9) << report.unpackedBytes / 1024.0f << "KB -> " << std::setw(8) << report.packedBytes / 1024.0f << "KB"
+				<< std::scientific << " position error " << worstPosition / dequant.w << " of the size" << std::fixed << std::endl;
+		}
+		std::cout << "  Total " << total.models << " models " << total.unpackedBytes / 1024.0f << "KB -> " << total.packedBytes / 1024.0f << "KB, "
+			<< total.modelsWithColour << " with vertex colours" << std::endl;
+		std::cout << std::defaultfloat;
+
+		result = result && total.packedBytes * sizeof(oGFX::Vertex) == total.unpackedBytes * sizeof(oGFX::PackedVertex)
+			&& total.packedBytes * 2 < total.unpackedBytes;
+		std::cout << "  Result:" << (result ? "true" : "false") << std::endl;
+	}
+
+#pragma endregion
+#pragma region Meshlets
+
+/** Meshlets -- every triangle in exactly one meshlet within the limits, culling never rejects what could be seen, build time and rejection rates **/
+
+	// Sphere with bumps so the meshlets get some spread of normals, the winding faces out
+	void MeshletTestSphere(uint32_t rings, uint32_t segments, std::vector<glm::vec3>& positions, std::vector<uint32_t>& indices)
+	{
+		positions.clear();
+		indices.clear();
+		for (uint32_t r = 0; r <= rings; r++)
+		{
+			const float theta = glm::pi<float>() * r / rings;
+			for (uint32_t s = 0; s <= segments; s++)
+			{
+				const float phi = glm::two_pi<float>() * s / segments;
+				const float radius = 1.0f + 0.1f * std::sin(theta * 9.0f) * std::sin(phi * 7.0f);
+				positions.push_back(radius * glm::vec3{ std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi) });
+			}
+		}
+		for (uint32_t r = 0; r < rings; r++)
+		{
+			for (uint32_t s = 0; s < segments; s++)
+			{
+				const uint32_t a = r * (segments + 1) + s, b = a + segments + 1;
+				indices.insert(indices.end(), { a, a + 1, b, b, a + 1, b + 1 });
+			}
+		}
+	}
+
+	std::vector<std::pair<std::string, std::pair<std::vector<glm::vec3>, std::vector<uint32_t>>>> MeshletTestModels()
+	{
+		std::vector<std::pair<std::string, std::pair<std::vector<glm::vec3>, std::vector<uint32_t>>>> models;
+		auto add = [&models](const std::string& name, const DefaultMesh& mesh) {
+			std::vector<glm::vec3> positions;
+			for (const oGFX::Vertex& v : mesh.m_VertexBuffer) positions.push_back(v.pos);
+			models.push_back({ name, { positions, mesh.m_IndexBuffer } });
+		};
+		add("Default cube", CreateDefaultCubeMesh());
+		add("Default plane XZ", CreateDefaultPlaneXZMesh());
+
+		std::vector<glm::vec3> positions;
+		std::vector<uint32_t> indices;
+		MeshletTestSphere(96, 192, positions, indices);
+		models.push_back({ "Bumpy sphere", { positions, indices } });
+		if (ReadPly("Models/bunny.ply", positions, indices))
+		{
+			models.push_back({ "bunny.ply", { positions, indices } });
+		}
+		else
+		{
+			std::cout << "  Models/bunny.ply not found, generated meshes only" << std::endl;
+		}
+		return models;
+	}
+
+	// Checks the meshlets against the mesh and a brute force cull of their triangles from cameras all around it
+	void MeshletTest1(const std::string& testName)
+	{
+		PrintTestHeader(testName);
+		namespace ML = oGFX::Meshlets;
+
+		bool result = true;
+		for (const auto& [name, mesh] : MeshletTestModels())
+		{
+			const auto& [positions, indices] = mesh;
+			ML::MeshletData data;
+			ML::Build(data, indices.data(), indices.size(), &positions[0].x, positions.size(), sizeof(glm::vec3));
+
+			// every triangle once, the same corners in the same order
+			std::vector<std::array<uint32_t, 3>> before, after;
+			for (size_t t = 0; t < indices.size(); t += 3) before.push_back({ indices[t], indices[t + 1], indices[t + 2] });
+			bool valid = true;
+			for (const GPUMeshlet& m : data.meshlets)
+			{
+				valid = valid && m.vertexCount <= ML::MAX_VERTICES && m.triangleCount <= ML::MAX_TRIANGLES && m.triangleCount > 0;
+				for (uint32_t t = 0; valid && t < m.triangleCount; t++)
+				{
+					std::array<uint32_t, 3> tri;
+					for (uint32_t k = 0; k < 3; k++)
+					{
+						const uint32_t local = ML::TriangleIndex(data.triangles[m.triangleOffset + t], k);
+						valid = valid && local < m.vertexCount;
+						tri[k] = data.vertices[m.vertexOffset + local];
+					}
+					after.push_back(tri);
+				}
+				// the sphere holds every vertex
+				for (uint32_t v = 0; valid && v < m.vertexCount; v++)
+				{
+					valid = glm::length(positions[data.vertices[m.vertexOffset + v]] - glm::vec3{ m.sphere }) <= m.sphere.w * 1.0001f + 1e-6f;
+				}
+			}
+			std::sort(before.begin(), before.end());
+			std::sort(after.begin(), after.end());
+			valid = valid && before == after;
+
+			// a rejected meshlet has no triangle facing the eye and no vertex in the frustum
+			std::mt19937 rng(5);
+			std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+			const glm::vec3 centre = glm::vec3{ data.meshlets[0].sphere };
+			float size = 0.0f;
+			for (const glm::vec3& p : positions) size = std::max(size, glm::length(p - centre));
+
+			uint32_t falseRejects = 0, rejects = 0;
+			std::vector<uint32_t> visible;
+			for (int view = 0; view < 64; view++)
+			{
+				const glm::vec3 eye = centre + glm::vec3{ unit(rng), unit(rng), unit(rng) } * size * 3.0f;
+				const glm::vec3 target = centre + glm::vec3{ unit(rng), unit(rng), unit(rng) } * size;
+				if (glm::length(target - eye) < 1e-3f)
+					continue;
+				const glm::mat4 viewProj = glm::perspective(glm::radians(50.0f), 16.0f / 9.0f, size * 0.01f, size * 10.0f)
+					* glm::lookAt(eye, target, std::abs(glm::normalize(target - eye).y) > 0.99f ? glm::vec3{ 1, 0, 0 } : glm::vec3{ 0, 1, 0 });
+				const auto stats = ML::Cull(data.meshlets.data(), data.meshlets.size(), Frustum::CreateFromViewProj(viewProj), eye, visible);
+				rejects += stats.frustumRejected + stats.backfaceRejected;
+
+				std::vector<bool> kept(data.meshlets.size(), false);
+				for (uint32_t i : visible) kept[i] = true;
+				for (size_t i = 0; i < data.meshlets.size(); i++)
+				{
+					if (kept[i])
+						continue;
+					const GPUMeshlet& m = data.meshlets[i];
+					bool seen = false;
+					for (uint32_t t = 0; seen == false && t < m.triangleCount; t++)
+					{
+						glm::vec3 p[3];
+						bool inside = false;
+						for (uint32_t k = 0; k < 3; k++)
+						{
+							p[k] = positions[data.vertices[m.vertexOffset + ML::TriangleIndex(data.triangles[m.triangleOffset + t], k)]];
+							const glm::vec4 clip = viewProj * glm::vec4{ p[k], 1.0f };
+							const float w = clip.w * 1.0001f;
+							inside = inside || (std::abs(clip.x) <= w && std::abs(clip.y) <= w && clip.z >= -w && clip.z <= w);
+						}
+						// a vertex inside with the front face towards the eye, or a triangle the frustum planes could not reject either
+						const glm::vec3 n = glm::cross(p[1] - p[0], p[2] - p[0]);
+						const bool front = glm::dot(n, p[0] - eye) < -1e-5f * glm::length(n) * glm::length(p[0] - eye);
+						seen = front && inside;
+					}
+					falseRejects += seen;
+				}
+			}
+			result = result && valid && falseRejects == 0 && rejects > 0;
+
+			std::cout << "  " << std::left << std::setw(18) << name << std::right << std::setw(6) << data.meshlets.size() << " meshlets, valid:"
+				<< (valid ? "true" : "false") << " false rejections:" << falseRejects << std::endl;
+		}
+		std::cout << "  Result:" << (result ? "true" : "false") << std::endl;
+	}
+
+	// Build time, fill and how much a camera orbiting each model rejects
+	void MeshletTest2(const std::string& testName)
+	{
+		PrintTestHeader(testName);
+		namespace ML = oGFX::Meshlets;
+
+		bool result = true;
+		std::cout << std::fixed << std::setprecision(2);
+		for (const auto& [name, mesh] : MeshletTestModels())
+		{
+			const auto& [positions, indices] = mesh;
+			ML::MeshletData data;
+			const auto start = std::chrono::high_resolution_clock::now();
+			ML::Build(data, indices.data(), indices.size(), &positions[0].x, positions.size(), sizeof(glm::vec3));
+			const float buildMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+			glm::vec3 lo{ std::numeric_limits<float>::max() }, hi{ -std::numeric_limits<float>::max() };
+			for (const glm::vec3& p : positions)
+			{
+				lo = glm::min(lo, p);
+				hi = glm::max(hi, p);
+			}
+			const glm::vec3 centre = (lo + hi) * 0.5f;
+			const float size = std::max(glm::length(hi - lo) * 0.5f, 1e-3f);
+
+			// close and looking past the middle, the frustum cuts part of the model away
+			constexpr int VIEWS = 256;
+			uint64_t meshlets = 0, frustum = 0, backface = 0;
+			std::vector<uint32_t> visible;
+			float cullMs = 0.0f;
+			for (int view = 0; view < VIEWS; view++)
+			{
+				const float a = glm::two_pi<float>() * view / VIEWS;
+				const glm::vec3 eye = centre + glm::vec3{ std::cos(a), 0.4f * std::sin(a * 3.0f), std::sin(a) } * size * 1.2f;
+				const glm::vec3 target = centre + glm::vec3{ -std::sin(a), 0.0f, std::cos(a) } * size;
+				const glm::mat4 viewProj = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, size * 0.01f, size * 10.0f)
+					* glm::lookAt(eye, target, glm::vec3{ 0, 1, 0 });
+				const Frustum f = Frustum::CreateFromViewProj(viewProj);
+
+				const auto cullStart = std::chrono::high_resolution_clock::now();
+				const auto stats = ML::Cull(data.meshlets.data(), data.meshlets.size(), f, eye, visible);
+				cullMs += std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - cullStart).count();
+				meshlets += stats.meshlets;
+				frustum += stats.frustumRejected;
+				backface += stats.backfaceRejected;
+			}
+			// a closed mesh always shows its back to the camera somewhere
+			if (name == "Bumpy sphere" || name == "bunny.ply")
+			{
+				result = result && backface > 0;
+			}
+
+			std::cout << "  " << std::left << std::setw(18) << name << std::right << std::setw(8) << indices.size() / 3 << " triangles "
+				<< std::setw(6) << data.meshlets.size() << " meshlets in " << std::setw(7) << buildMs << "ms, "
+				<< float(indices.size() / 3) / data.meshlets.size() << " triangles "
+				<< float(data.vertices.size()) / data.meshlets.size() << " vertices each" << std::endl;
+			std::cout << "  " << std::setw(26) << "" << "rejected frustum " << 100.0f * frustum / meshlets << "% backface "
+				<< 100.0f * backface / meshlets << "%, " << 1000.0f * cullMs / VIEWS << "us a view" << std::endl;
+		}
+		std::cout << std::defaultfloat;
+		std::cout << "  Result:" << (result ? "true" : "false") << std::endl;
+	}
+
+#pragma endregion
+
+#pragma region TextureUploader
+
+/** Texture uploads -- batch retirement order without a device, then batched against one submit and wait per texture on a headless device **/
+
+	// Batches retire in submission order however far the semaphore has moved, callbacks only once
+	void TextureUploaderTest1(const std::string& testName)
+	{
+		PrintTestHeader(testName);
+
+		oGFX::UploadTimeline timeline;
+		std::vector<int> ran;
+		auto record = [&ran](int id) { return [&ran, id]() { ran.push_back(id); }; };
+
+		bool result = true;
+		result = result && timeline.RecordingValue() == 1;
+		timeline.OnComplete(record(0));
+		timeline.OnComplete(record(1));
+		result = result && timeline.Close() == 1;
+		// nothing queued still takes a value so the semaphore keeps counting up
+		result = result && timeline.Close() == 2;
+		timeline.OnComplete(record(2));
+		result = result && timeline.Close() == 3;
+		timeline.OnComplete(record(3));
+		result = result && timeline.RecordingValue() == 4;
+		result = result && timeline.BatchesInFlight() == 3;
+
+		for (auto& fn : timeline.Retire(0)) fn();
+		result = result && ran.empty();
+		for (auto& fn : timeline.Retire(2)) fn();
+		result = result && ran == std::vector<int>{ 0, 1 } && timeline.Retired() == 2;
+		// the semaphore can jump past several batches between polls
+		for (auto& fn : timeline.Retire(100)) fn();
+		result = result && ran == std::vector<int>{ 0, 1, 2 } && timeline.BatchesInFlight() == 0;
+		// the batch still being recorded is not retired
+		for (auto& fn : timeline.Retire(100)) fn();
+		result = result && ran.size() == 3;
+		result = result && timeline.Close() == 4;
+		for (auto& fn : timeline.Retire(4)) fn();
+		result = result && ran == std::vector<int>{ 0, 1, 2, 3 };
+
+		std::cout << "  Result:" << (result ? "true" : "false") << std::endl;
+	}
+
+	// Instance and device without a surface, a software device is preferred so the numbers compare between machines
+	struct UploaderTestDevice
+	{
+		VkInstance instance{ VK_NULL_HANDLE };
+		VkPhysicalDevice physicalDevice{ VK_NULL_HANDLE };
+		VkDevice device{ VK_NULL_HANDLE };
+		VmaAllocator allocator{};
+		VkPhysicalDeviceProperties properties{};
+		uint32_t graphicsFamily{ ~0u };
+		uint32_t transferFamily{ ~0u };
+		VkQueue graphicsQueue{ VK_NULL_HANDLE };
+		VkQueue transferQueue{ VK_NULL_HANDLE };
+
+		bool Create()
+		{
+			VkApplicationInfo appInfo{ VK_STRUCTURE_TYPE_APPLICATION_INFO };
+			appInfo.pApplicationName = "TextureUploaderTest";
+			appInfo.apiVersion = VK_API_VERSION_1_3;
+			VkInstanceCreateInfo ici{ VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO };
+			ici.pApplicationInfo = &appInfo;
+			if (vkCreateInstance(&ici, nullptr, &instance) != VK_SUCCESS)
+				return false;
+
+			uint32_t count{};
+			vkEnumeratePhysicalDevices(instance, &count, nullptr);
+			std::vector<VkPhysicalDevice> devices(count);
+			vkEnumeratePhysicalDevices(instance, &count, devices.data());
+			for (VkPhysicalDevice pd : devices)
+			{
+				VkPhysicalDeviceProperties props{};
+				vkGetPhysicalDeviceProperties(pd, &props);
+				if (props.apiVersion < VK_API_VERSION_1_3)
+					continue;
+				if (physicalDevice == VK_NULL_HANDLE || props.deviceType == VK_PHYSICAL_DEVICE_TYPE_CPU)
+				{
+					physicalDevice = pd;
+					properties = props;
+				}
+			}
+			if (physicalDevice == VK_NULL_HANDLE)
+				return false;
+
+			// same rule as the renderer, the first other family that can copy
+			vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &count, nullptr);
+			std::vector<VkQueueFamilyProperties> families(count);
+			vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &count, families.data());
+			for (uint32_t i = 0; i < count && graphicsFamily == ~0u; i++)
+			{
+				if (families[i].queueCount > 0 && families[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) graphicsFamily = i;
+			}
+			for (uint32_t i = 0; i < count && transferFamily == ~0u; i++)
+			{
+				if (i != graphicsFamily && families[i].queueCount > 0 && families[i].queueFlags & VK_QUEUE_TRANSFER_BIT) transferFamily = i;
+			}
+			if (graphicsFamily == ~0u)
+				return false;
+			transferFamily = transferFamily == ~0u ? graphicsFamily : transferFamily;
+
+			const float priority = 1.0f;
+			std::vector<VkDeviceQueueCreateInfo> queues;
+			for (uint32_t family : { graphicsFamily, transferFamily })
+			{
+				if (queues.empty() == false && queues.front().queueFamilyIndex == family)
+					continue;
+				VkDeviceQueueCreateInfo qci{ VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO };
+				qci.queueFamilyIndex = family;
+				qci.queueCount = 1;
+				qci.pQueuePriorities = &priority;
+				queues.push_back(qci);
+			}
+			VkPhysicalDeviceVulkan13Features vk13Features{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES };
+			vk13Features.synchronization2 = VK_TRUE;
+			VkPhysicalDeviceVulkan12Features vk12Features{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES };
+			vk12Features.pNext = &vk13Features;
+			vk12Features.timelineSemaphore = VK_TRUE;
+			VkDeviceCreateInfo dci{ VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO };
+			dci.pNext = &vk12Features;
+			dci.queueCreateInfoCount = static_cast<uint32_t>(queues.size());
+			dci.pQueueCreateInfos = queues.data();
+			if (vkCreateDevice(physicalDevice, &dci, nullptr, &device) != VK_SUCCESS)
+				return false;
+			vkGetDeviceQueue(device, graphicsFamily, 0, &graphicsQueue);
+			vkGetDeviceQueue(device, transferFamily, 0, &transferQueue);
+
+			VmaVulkanFunctions vulkanFuns{};
+			vulkanFuns.vkGetInstanceProcAddr = &vkGetInstanceProcAddr;
+			vulkanFuns.vkGetDeviceProcAddr = &vkGetDeviceProcAddr;
+			VmaAllocatorCreateInfo allocatorInfo{};
+			allocatorInfo.physicalDevice = physicalDevice;
+			allocatorInfo.device = device;
+			allocatorInfo.instance = instance;
+			allocatorInfo.pVulkanFunctions = &vulkanFuns;
+			allocatorInfo.vulkanApiVersion = VK_API_VERSION_1_3;
+			return vmaCreateAllocator(&allocatorInfo, &allocator) == VK_SUCCESS;
+		}
+
+		void Destroy()
+		{
+			if (allocator) vmaDestroyAllocator(allocator);
+			if (device) vkDestroyDevice(device, nullptr);
+			if (instance) vkDestroyInstance(instance, nullptr);
+		}
+	};
+
+	// Many small textures as a level load sees them, the upload service against what fromBuffer did for every texture.
+	// Reads one texture back to check the ownership transfer and layouts left the texels intact, and the last mip of a blitted chain.
+	void TextureUploaderBenchmark(const std::string& testName)
+	{
+		PrintTestHeader(testName);
+
+		UploaderTestDevice ctx;
+		if (ctx.Create() == false)
+		{
+			ctx.Destroy();
+			std::cout << "  Skipped: no Vulkan 1.3 device" << std::endl;
+			return;
+		}
+
+		constexpr uint32_t TEXTURES = 256;
+		constexpr uint32_t DIM = 128;
+		constexpr VkDeviceSize SIZE = DIM * DIM * sizeof(uint32_t);
+		std::vector<std::vector<uint32_t>> texels(TEXTURES, std::vector<uint32_t>(DIM * DIM));
+		std::mt19937 rng(21);
+		for (auto& t : texels)
+		{
+			for (uint32_t& texel : t) texel = rng();
+		}
+
+		VkBufferImageCopy region{};
+		region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+		region.imageExtent = { DIM, DIM, 1 };
+		const VkImageSubresourceRange range{ VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+
+		auto createImages = [&ctx](std::vector<oGFX::AllocatedImage>& images, uint32_t count, uint32_t mipLevels) {
+			VkImageCreateInfo ici{ VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO };
+			ici.imageType = VK_IMAGE_TYPE_2D;
+			ici.format = VK_FORMAT_R8G8B8A8_UNORM;
+			ici.extent = { DIM, DIM, 1 };
+			ici.mipLevels = mipLevels;
+			ici.arrayLayers = 1;
+			ici.samples = VK_SAMPLE_COUNT_1_BIT;
+			ici.tiling = VK_IMAGE_TILING_OPTIMAL;
+			ici.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+			ici.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+			ici.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			VmaAllocationCreateInfo aci{};
+			aci.usage = VMA_MEMORY_USAGE_AUTO;
+			images.resize(count);
+			for (auto& image : images)
+			{
+				VK_CHK(vmaCreateImage(ctx.allocator, &ici, &aci, &image.image, &image.allocation, &image.allocationInfo));
+			}
+		};
+		auto destroyImages = [&ctx](std::vector<oGFX::AllocatedImage>& images) {
+			for (auto& image : images) vmaDestroyImage(ctx.allocator, image.image, image.allocation);
+			images.clear();
+		};
+
+		VkCommandPoolCreateInfo poolInfo{ VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO };
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+		poolInfo.queueFamilyIndex = ctx.graphicsFamily;
+		VkCommandPool pool{ VK_NULL_HANDLE };
+		VK_CHK(vkCreateCommandPool(ctx.device, &poolInfo, nullptr, &pool));
+		VkCommandBufferAllocateInfo cmdInfo{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO };
+		cmdInfo.commandPool = pool;
+		cmdInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		cmdInfo.commandBufferCount = 1;
+		VkCommandBuffer cmd{ VK_NULL_HANDLE };
+		VK_CHK(vkAllocateCommandBuffers(ctx.device, &cmdInfo, &cmd));
+		auto submitAndWait = [&ctx, &cmd]() {
+			VK_CHK(vkEndCommandBuffer(cmd));
+			VkSubmitInfo si{ VK_STRUCTURE_TYPE_SUBMIT_INFO };
+			si.commandBufferCount = 1;
+			si.pCommandBuffers = &cmd;
+			VK_CHK(vkQueueSubmit(ctx.graphicsQueue, 1, &si, VK_NULL_HANDLE));
+			VK_CHK(vkQueueWaitIdle(ctx.graphicsQueue));
+		};
+		VkCommandBufferBeginInfo beginInfo{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+		// what Texture2D::fromBuffer does, a staging buffer, a submission and a wait each
+		std::vector<oGFX::AllocatedImage> images;
+		createImages(images, TEXTURES, 1);
+		const auto syncStart = std::chrono::high_resolution_clock::now();
+		for (uint32_t i = 0; i < TEXTURES; i++)
+		{
+			oGFX::AllocatedBuffer staging{};
+			oGFX::CreateBuffer(ctx.allocator, SIZE, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+				VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT, staging);
+			memcpy(staging.allocInfo.pMappedData, texels[i].data(), SIZE);
+			vmaFlushAllocation(ctx.allocator, staging.alloc, 0, SIZE);
+
+			VK_CHK(vkBeginCommandBuffer(cmd, &beginInfo));
+			oGFX::vkutils::tools::setImageLayout(cmd, images[i].image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, range);
+			vkCmdCopyBufferToImage(cmd, staging.buffer, images[i].image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+			oGFX::vkutils::tools::setImageLayout(cmd, images[i].image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, range);
+			submitAndWait();
+			vmaDestroyBuffer(ctx.allocator, staging.buffer, staging.alloc);
+		}
+		const float syncMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - syncStart).count();
+		destroyImages(images);
+
+		oGFX::TextureUploader uploader;
+		uploader.Init(ctx.device, ctx.allocator, ctx.graphicsQueue, ctx.graphicsFamily, ctx.transferQueue, ctx.transferFamily);
+		createImages(images, TEXTURES, 1);
+		uint32_t completed{};
+		const auto batchStart = std::chrono::high_resolution_clock::now();
+		for (uint32_t i = 0; i < TEXTURES; i++)
+		{
+			oGFX::TextureUploader::Upload upload;
+			upload.image = images[i].image;
+			upload.range = range;
+			upload.regions = { region };
+			uploader.Enqueue(upload, texels[i].data(), SIZE, [&completed]() { ++completed; });
+		}
+		const float enqueueMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - batchStart).count();
+		uploader.Update(true);
+		const float batchMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - batchStart).count();
+		const auto stats = uploader.GetStats();
+
+		// the last texture back to the host, on the graphics queue that owns it now
+		constexpr uint32_t CHECKED = TEXTURES - 1;
+		oGFX::AllocatedBuffer readback{};
+		oGFX::CreateBuffer(ctx.allocator, SIZE, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT, readback);
+		VK_CHK(vkBeginCommandBuffer(cmd, &beginInfo));
+		oGFX::vkutils::tools::setImageLayout(cmd, images[CHECKED].image, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, range);
+		vkCmdCopyImageToBuffer(cmd, images[CHECKED].image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, readback.buffer, 1, &region);
+		submitAndWait();
+		vmaInvalidateAllocation(ctx.allocator, readback.alloc, 0, SIZE);
+		const bool intact = memcmp(readback.allocInfo.pMappedData, texels[CHECKED].data(), SIZE) == 0;
+
+		// a flat colour blitted down to 1x1 comes out as it went in
+		constexpr uint32_t MIPS = 8; // DIM down to 1
+		constexpr uint32_t FLAT = 0xff336699u;
+		const std::vector<uint32_t> flat(DIM * DIM, FLAT);
+		std::vector<oGFX::AllocatedImage> mipped;
+		createImages(mipped, 1, MIPS);
+		oGFX::TextureUploader::Upload mipUpload;
+		mipUpload.image = mipped[0].image;
+		mipUpload.range = { VK_IMAGE_ASPECT_COLOR_BIT, 0, MIPS, 0, 1 };
+		mipUpload.regions = { region };
+		mipUpload.generateMips = true;
+		bool mipsDone = false;
+		uploader.Enqueue(mipUpload, flat.data(), SIZE, [&mipsDone]() { mipsDone = true; });
+		uploader.Update(true);
+
+		const VkImageSubresourceRange lastMip{ VK_IMAGE_ASPECT_COLOR_BIT, MIPS - 1, 1, 0, 1 };
+		VkBufferImageCopy lastRegion{};
+		lastRegion.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, MIPS - 1, 0, 1 };
+		lastRegion.imageExtent = { 1, 1, 1 };
+		VK_CHK(vkBeginCommandBuffer(cmd, &beginInfo));
+		oGFX::vkutils::tools::setImageLayout(cmd, mipped[0].image, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, lastMip);
+		vkCmdCopyImageToBuffer(cmd, mipped[0].image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, readback.buffer, 1, &lastRegion);
+		submitAndWait();
+		vmaInvalidateAllocation(ctx.allocator, readback.alloc, 0, sizeof(uint32_t));
+		const bool mipsIntact = mipsDone && *static_cast<const uint32_t*>(readback.allocInfo.pMappedData) == FLAT;
+		vmaDestroyBuffer(ctx.allocator, readback.buffer, readback.alloc);
+
+		uploader.Destroy();
+		destroyImages(images);
+		destroyImages(mipped);
+		vkDestroyCommandPool(ctx.device, pool, nullptr);
+
+		std::cout << "  " << ctx.properties.deviceName << (stats.dedicatedTransferQueue ? ", transfer queue" : ", shared graphics queue") << std::endl;
+		std::cout << "  " << TEXTURES << " textures of " << SIZE / 1024 << "KB, submit and wait each " << syncMs << "ms, batched "
+			<< batchMs << "ms (" << enqueueMs << "ms staging), " << syncMs / batchMs << "x" << std::endl;
+		std::cout << "  Batches:" << stats.batches << " Completed:" << completed << " Readback:" << (intact ? "intact" : "corrupt")
+			<< " Last mip:" << (mipsIntact ? "intact" : "corrupt") << std::endl;
+
+		const bool result = completed == TEXTURES && stats.batches == 1 && stats.textures == TEXTURES && intact && mipsIntact;
+		std::cout << "  Result:" << (result ? "true" : "false") << std::endl;
+		ctx.Destroy();
+	}
+
+#pragma endregion
+
+#pragma region TextureResidency
+
+/** Texture residency -- the mip streaming policy without a device, loads, budget, LRU eviction and the CPU mip chain **/
+
+	// Mip sizes of a square RGBA8 texture, finest first
+	std::vector<uint64_t> ResidencyTestMips(uint32_t size)
+	{
+		std::vector<uint64_t> mips;
+		for (uint32_t s = size; ; s /= 2)
+		{
+			mips.push_back(uint64_t(s) * s * 4);
+			if (s == 1) break;
+		}
+		return mips;
+	}
+
+	// Hand checked cases, loads wait for the budget, the least recently seen give back first and only when needed
+	void TextureResidencyTest1(const std::string& testName)
+	{
+		PrintTestHeader(testName);
+
+		using Residency = oGFX::TextureResidency;
+		const std::vector<uint64_t> mips = ResidencyTestMips(1024); // tail at 128 is mip 3
+		auto from = [&mips](uint32_t mip) { uint64_t b{}; for (size_t m = mip; m < mips.size(); m++) b += mips[m]; return b; };
+		Residency residency;
+		// room for one texture at full resolution, one at mip 1 and one tail
+		residency.Init(from(0) + from(1) + from(3) + 16, ~0ull);
+		for (uint32_t id = 0; id < 3; id++)
+		{
+			residency.Register(id, 1024, mips, 3);
+		}
+
+		bool result = true;
+		std::vector<Residency::Change> changes;
+		uint64_t frame = 1;
+		// nothing asked for, nothing moves
+		residency.Update(frame, changes);
+		result = result && changes.empty() && residency.GetStats().targetBytes == 3 * from(3);
+
+		// texture 1 is wanted at full resolution, texture 0 at mip 1, the finest request of the frame wins
+		residency.Request(1, 2, frame);
+		residency.Request(1, 0, frame);
+		residency.Request(0, 1, frame);
+		residency.Update(++frame, changes);
+		result = result && changes.size() == 2;
+		result = result && changes.size() == 2 && changes[0].textureID == 1 && changes[0].fromMip == 3 && changes[0].toMip == 0;
+		result = result && changes.size() == 2 && changes[1].textureID == 0 && changes[1].toMip == 1;
+		// in flight, asked again they are not sent twice
+		residency.Request(1, 0, frame);
+		residency.Update(++frame, changes);
+		result = result && changes.empty() && residency.Get(1)->residentMip == 3 && residency.GetStats().changesInFlight == 2;
+		residency.Complete(1, 0);
+		residency.Complete(0, 1);
+		result = result && residency.Get(1)->residentMip == 0 && residency.Get(0)->residentMip == 1;
+
+		// texture 2 now wants full resolution, texture 1 was not seen so it gives its mips back
+		++frame;
+		residency.Request(0, 1, frame);
+		residency.Request(2, 0, frame);
+		residency.Update(++frame, changes);
+		result = result && changes.size() == 2;
+		result = result && changes.size() == 2 && changes[0].textureID == 1 && changes[0].toMip == 3;
+		result = result && changes.size() == 2 && changes[1].textureID == 2 && changes[1].toMip == 0;
+		result = result && residency.GetStats().targetBytes <= residency.GetStats().budget && residency.GetStats().evictions == 1;
+		residency.Complete(1, 3);
+		residency.Complete(2, 0);
+
+		// a lower budget takes the mips nobody looked at
+		residency.SetBudget(from(1) + 2 * from(3) + 16);
+		residency.Request(0, 1, frame);
+		residency.Update(++frame, changes);
+		result = result && changes.size() == 1 && changes[0].textureID == 2 && changes[0].toMip == 3;
+		residency.Complete(2, 3);
+		result = result && residency.GetStats().residentBytes == residency.GetStats().targetBytes;
+		// unregistering returns the texture's bytes
+		const uint64_t before = residency.GetStats().targetBytes;
+		residency.Unregister(2);
+		result = result && before - residency.GetStats().targetBytes == from(3);
+		result = result && residency.IsStreamed(2) == false && residency.GetStats().streamed == 2;
+
+		// more asked for than fits, the finest mip that fits is sent instead
+		Residency tight;
+		tight.Init(from(1) + 16, ~0ull);
+		tight.Register(0, 1024, mips, 3);
+		tight.Request(0, 0, 1);
+		tight.Update(2, changes);
+		result = result && changes.size() == 1 && changes[0].toMip == 1;
+
+		// one frame's uploads stop at the per frame budget, the first one always goes
+		Residency paced;
+		paced.Init(~0ull, mips[0] / 2);
+		for (uint32_t id = 0; id < 4; id++)
+		{
+			paced.Register(id, 1024, mips, 3);
+			paced.Request(id, 0, 1);
+		}
+		paced.Update(2, changes);
+		result = result && changes.size() == 1 && paced.GetStats().uploadBytes == from(0);
+
+		result = result && Residency::MipForCoverage(1024, 11, 1.0f, 100.0f, 1.0f, 1000) == 6;	// 10 pixels
+		result = result && Residency::MipForCoverage(1024, 11, 1.0f, 0.5f, 1.0f, 1000) == 0;	// inside the sphere
+		result = result && Residency::MipForCoverage(1024, 4, 1.0f, 1e6f, 1.0f, 1000) == 3;	// clamped to the last mip
+
+		std::cout << "  Result:" << (result ? "true" : "false") << std::endl;
+	}
+
+	// A camera flying past a row of textured objects, the budget holds every frame and close objects get their mips
+	void TextureResidencyTest2(const std::string& testName)
+	{
+		PrintTestHeader(testName);
+
+		using Residency = oGFX::TextureResidency;
+		bool result = true;
+
+		// the CPU chain averages 2x2 blocks and repeats the last row and column of odd sides
+		oGFX::FileImageData image;
+		image.w = 5;
+		image.h = 3;
+		image.format = VK_FORMAT_R8G8B8A8_UNORM;
+		image.imgData.resize(5 * 3 * 4);
+		for (size_t i = 0; i < image.imgData.size(); i++)
+		{
+			image.imgData[i] = static_cast<uint8_t>(i * 4);
+		}
+		VkBufferImageCopy region{};
+		region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+		region.imageExtent = { 5, 3, 1 };
+		image.mipInformation.push_back(region);
+		image.dataSize = image.imgData.size();
+		image.GenerateMipChain();
+		result = result && image.mipInformation.size() == 3;
+		result = result && image.mipInformation[1].imageExtent.width == 2 && image.mipInformation[1].imageExtent.height == 1;
+		result = result && image.mipInformation[2].imageExtent.width == 1 && image.mipInformation[2].bufferOffset == 60 + 8;
+		result = result && image.dataSize == 60 + 8 + 4 && image.generateMips == false;
+		// texel (0,0) of mip 1 from texels (0,0) (1,0) (0,1) (1,1) of mip 0, red channel
+		result = result && image.imgData[60] == (0 + 16 + 80 + 96 + 2) / 4;
+
+		constexpr uint32_t OBJECTS = 64;
+		constexpr uint32_t FRAMES = 600;
+		constexpr uint32_t SIZE = 2048;
+		const std::vector<uint64_t> mips = ResidencyTestMips(SIZE);
+		const uint32_t tailMip = 4; // 128
+		Residency residency;
+		const uint64_t budget = 6 * mips[0];
+		residency.Init(budget, 32ull * 1024 * 1024);
+		for (uint32_t id = 0; id < OBJECTS; id++)
+		{
+			residency.Register(id, SIZE, mips, tailMip);
+		}
+
+		std::vector<Residency::Change> changes;
+		std::vector<Residency::Change> inFlight;
+		uint64_t peakTarget{};
+		uint64_t sharpFrames{};
+		const float tanHalfFov = std::tan(glm::radians(30.0f));
+		for (uint64_t frame = 1; frame <= FRAMES; frame++)
+		{
+			// last frame's uploads land
+			for (const auto& c : inFlight)
+			{
+				residency.Complete(c.textureID, c.toMip);
+			}
+			residency.Update(frame, changes);
+			inFlight = changes;
+			peakTarget = std::max(peakTarget, residency.GetStats().targetBytes);
+
+			// objects every 4 units along z, the camera looks down the row and sees the next 40 units
+			const float cameraZ = frame * 0.4f;
+			for (uint32_t id = 0; id < OBJECTS; id++)
+			{
+				const float distance = id * 4.0f - cameraZ;
+				if (distance < -1.0f || distance > 40.0f)
+					continue;
+				residency.Request(id, Residency::MipForCoverage(SIZE, (uint32_t)mips.size(), 1.0f, std::abs(distance), tanHalfFov, 1080), frame);
+			}
+			// the object just ahead of the camera is shown at what it asked for within a few frames
+			const uint32_t ahead = static_cast<uint32_t>(cameraZ / 4.0f) + 1;
+			if (ahead < OBJECTS && frame > 10)
+			{
+				const float distance = ahead * 4.0f - cameraZ;
+				const uint32_t wanted = Residency::MipForCoverage(SIZE, (uint32_t)mips.size(), 1.0f, distance, tanHalfFov, 1080);
+				sharpFrames += residency.Get(ahead)->residentMip <= wanted + 1;
+			}
+		}
+		const auto stats = residency.GetStats();
+		result = result && peakTarget <= budget && stats.evictions > 0 && sharpFrames > (FRAMES - 10) * 9 / 10;
+
+		std::cout << "  " << OBJECTS << " textures of " << SIZE << "^2, budget " << budget / (1024 * 1024) << "MB, peak " << peakTarget / (1024 * 1024)
+			<< "MB, all at full resolution " << OBJECTS * residency.Get(0)->BytesFrom(0) / (1024 * 1024) << "MB" << std::endl;
+		std::cout << "  Loads:" << stats.loads << " Evictions:" << stats.evictions << " Sharp ahead:" << sharpFrames << "/" << FRAMES - 10 << std::endl;
+		std::cout << "  Result:" << (result ? "true" : "false") << std::endl;
+	}
+
+#pragma endregion
+
+#pragma region ImageLoading
+
+/** Image loading -- the pixel payload is taken over from the decoder and moved to the upload, never copied on the way **/
+
+	// The payload owns what it adopts, moves leave the source empty, half floats convert in place
+	void ImageLoadingTest1(const std::string& testName)
+	{
+		PrintTestHeader(testName);
+
+		bool result = true;
+		oGFX::PixelBuffer pixels;
+		result = result && pixels.empty() && pixels.data() == nullptr;
+
+		uint8_t* decoded = static_cast<uint8_t*>(malloc(64));
+		for (uint8_t i = 0; i < 64; i++) decoded[i] = i;
+		pixels.Adopt(decoded, 64);
+		result = result && pixels.data() == decoded && pixels.size() == 64;
+
+		oGFX::PixelBuffer moved = std::move(pixels);
+		result = result && moved.data() == decoded && pixels.empty() && pixels.data() == nullptr;
+		pixels = std::move(moved);
+		result = result && pixels.data() == decoded && moved.empty();
+
+		// grows keeping the contents
+		pixels.resize(4096);
+		result = result && pixels.size() == 4096 && pixels[0] == 0 && pixels[63] == 63;
+		pixels.resize(16);
+		result = result && pixels.size() == 16 && pixels[15] == 15;
+
+		// a move of the whole image keeps the pixels where they are
+		oGFX::FileImageData image;
+		image.imgData = std::move(pixels);
+		const uint8_t* where = image.imgData.data();
+		oGFX::FileImageData handed = std::move(image);
+		result = result && handed.imgData.data() == where && image.imgData.empty();
+		handed.Free();
+		result = result && handed.imgData.empty() && handed.dataSize == 0;
+
+		// in place conversion matches converting into a separate buffer
+		std::vector<float> floats(1024);
+		for (size_t i = 0; i < floats.size(); i++)
+		{
+			floats[i] = (static_cast<float>(i) - 300.0f) * 0.37f;
+		}
+		oGFX::PixelBuffer hdr;
+		hdr.resize(floats.size() * sizeof(float));
+		memcpy(hdr.data(), floats.data(), hdr.size());
+		const float highest = oGFX::FloatsToHalf(hdr.data(), hdr.data(), floats.size());
+		hdr.resize(floats.size() * sizeof(uint16_t));
+		result = result && highest == floats.back();
+		for (size_t i = 0; i < floats.size(); i++)
+		{
+			uint16_t half;
+			memcpy(&half, hdr.data() + i * sizeof(uint16_t), sizeof(uint16_t));
+			result = result && half == oGFX::float_to_half(floats[i]);
+		}
+
+		std::cout << "  Result:" << (result ? "true" : "false") << std::endl;
+	}
+
+	// MB/s of decoded pixels from a directory of images to upload memory, the copies the loader used to make against the moves
+	void ImageLoadingBenchmark(const std::string& testName)
+	{
+		PrintTestHeader(testName);
+
+		constexpr uint32_t IMAGES = 24;
+		constexpr uint32_t SIZE = 1024;
+		constexpr int RUNS = 3;
+		const std::filesystem::path folder = std::filesystem::temp_directory_path() / "oo_image_load_benchmark";
+		std::filesystem::create_directories(folder);
+
+		// uncompressed 32 bit TGA, cheap to decode so what is measured is what happens to the pixels after
+		std::vector<std::string> files;
+		std::mt19937 rng(7);
+		for (uint32_t i = 0; i < IMAGES; i++)
+		{
+			const std::string file = (folder / ("image" + std::to_string(i) + ".tga")).string();
+			std::ofstream out(file, std::ios::binary);
+			const uint8_t header[18] = { 0, 0, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+				uint8_t(SIZE & 0xff), uint8_t(SIZE >> 8), uint8_t(SIZE & 0xff), uint8_t(SIZE >> 8), 32, 0x28 };
+			out.write(reinterpret_cast<const char*>(header), sizeof(header));
+			std::vector<uint32_t> texels(size_t(SIZE) * SIZE);
+			for (uint32_t& t : texels) t = rng();
+			out.write(reinterpret_cast<const char*>(texels.data()), texels.size() * sizeof(uint32_t));
+			files.push_back(file);
+		}
+
+		// stands in for the persistently mapped upload memory, touched once so both paths write warm pages
+		const size_t imageBytes = size_t(SIZE) * SIZE * 4;
+		std::vector<uint8_t> staging(imageBytes * IMAGES, 1);
+		using Clock = std::chrono::high_resolution_clock;
+
+		// what the loader did before, the decoded pixels copied into the image, the image copied into the
+		// work queue's lambda and that copy staged
+		double legacySeconds = 1e30;
+		uint64_t legacyHash{};
+		for (int run = 0; run < RUNS; run++)
+		{
+			const auto start = Clock::now();
+			for (uint32_t i = 0; i < IMAGES; i++)
+			{
+				int w, h, c;
+				stbi_uc* ptr = stbi_load(files[i].c_str(), &w, &h, &c, STBI_rgb_alpha);
+				std::vector<uint8_t> imgData(size_t(w) * h * 4);
+				memcpy(imgData.data(), ptr, imgData.size());
+				stbi_image_free(ptr);
+				std::function<void()> lam = [captured = imgData, dst = staging.data() + imageBytes * i]() {
+					memcpy(dst, captured.data(), captured.size());
+				};
+				lam();
+			}
+			legacySeconds = std::min(legacySeconds, std::chrono::duration<double>(Clock::now() - start).count());
+			legacyHash = std::accumulate(staging.begin(), staging.end(), uint64_t{});
+		}
+
+		// the decoder's buffer is the payload, staged once and freed
+		double movedSeconds = 1e30;
+		uint64_t movedHash{};
+		std::fill(staging.begin(), staging.end(), uint8_t(1));
+		for (int run = 0; run < RUNS; run++)
+		{
+			const auto start = Clock::now();
+			for (uint32_t i = 0; i < IMAGES; i++)
+			{
+				oGFX::FileImageData image;
+				image.Create(files[i]);
+				memcpy(staging.data() + imageBytes * i, image.imgData.data(), image.dataSize);
+				image.Free();
+				auto payload = std::make_shared<oGFX::FileImageData>(std::move(image));
+				std::function<void()> lam = [payload]() {};
+				lam();
+			}
+			movedSeconds = std::min(movedSeconds, std::chrono::duration<double>(Clock::now() - start).count());
+			movedHash = std::accumulate(staging.begin(), staging.end(), uint64_t{});
+		}
+		std::filesystem::remove_all(folder);
+
+		const double megabytes = double(imageBytes) * IMAGES / (1024.0 * 1024.0);
+		std::cout << "  " << IMAGES << " images of " << SIZE << "^2, " << megabytes << "MB decoded" << std::endl;
+		std::cout << std::fixed << std::setprecision(1)
+			<< "  Copied:" << megabytes / legacySeconds << "MB/s Moved:" << megabytes / movedSeconds << "MB/s ("
+			<< legacySeconds / movedSeconds << "x)" << std::defaultfloat << std::endl;
+		const bool result = legacyHash == movedHash;
+		std::cout << "  Result:" << (result ? "true" : "false") << std::endl;
+	}
+
+#pragma endregion
+
+#pragma region ModelImport
+	/** Model import converting its submeshes on the task manager **/
+
+	// fnv over what the renderer takes from a converted submesh
+	static uint64_t HashSubmeshes(const std::vector<oGFX::ModelImport::Submesh>& submeshes)
+	{
+		uint64_t hash = 0xcbf29ce484222325ull;
+		auto mix = [&hash](const void* data, size_t size) {
+			const uint8_t* bytes = static_cast<const uint8_t*>(data);
+			for (size_t i = 0; i < size; i++) hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+		};
+		for (const auto& s : submeshes)
+		{
+			for (const auto& v : s.vertices) mix(&v.pos, sizeof(v.pos));
+			mix(s.indices.data(), s.indices.size() * sizeof(uint32_t));
+			mix(s.remap.data(), s.remap.size() * sizeof(uint32_t));
+			mix(s.meshlets.meshlets.data(), s.meshlets.meshlets.size() * sizeof(GPUMeshlet));
+			mix(s.meshlets.triangles.data(), s.meshlets.triangles.size() * sizeof(s.meshlets.triangles[0]));
+		}
+		return hash;
+	}
+
+	// parallel conversion is the serial conversion, and meshlets built per submesh and rebased are the ones
+	// a single shared array would have had
+	void ModelImportTest1(const std::string& testName)
+	{
+		PrintTestHeader(testName);
+
+		Assimp::Importer importer;
+		const aiScene* scene = oGFX::ModelImport::ReadScene(importer, "Models/bunny.ply");
+		OO_ASSERT(scene && scene->mNumMeshes);
+
+		std::vector<oGFX::ModelImport::Submesh> serial;
+		oGFX::ModelImport::ConvertSubmeshes(*scene, serial);
+
+		TaskManager tm;
+		tm.Init(std::max(1u, std::thread::hardware_concurrency() - 1));
+		std::vector<oGFX::ModelImport::Submesh> parallel;
+		oGFX::ModelImport::ConvertSubmeshes(*scene, parallel, &tm);
+		tm.Shutdown();
+
+		bool result = serial.size() == parallel.size() && HashSubmeshes(serial) == HashSubmeshes(parallel);
+		const auto& bunny = serial.front();
+		result &= bunny.meshlets.meshlets.size() && bunny.remap.size() == scene->mMeshes[0]->mNumVertices;
+
+		// two grids as two submeshes of one model
+		auto grid = [](uint32_t n, float z, std::vector<glm::vec3>& pos, std::vector<uint32_t>& idx) {
+			for (uint32_t y = 0; y <= n; y++)
+				for (uint32_t x = 0; x <= n; x++)
+					pos.emplace_back(float(x), float(y), z + 0.1f * float((x * y) % 3));
+			for (uint32_t y = 0; y < n; y++)
+				for (uint32_t x = 0; x < n; x++)
+				{
+					const uint32_t a = y * (n + 1) + x, b = a + 1, c = a + n + 1, d = c + 1;
+					idx.insert(idx.end(), { a, b, c, b, d, c });
+				}
+		};
+		std::vector<glm::vec3> pos[2];
+		std::vector<uint32_t> idx[2];
+		grid(20, 0.0f, pos[0], idx[0]);
+		grid(33, 5.0f, pos[1], idx[1]);
+
+		oGFX::Meshlets::MeshletData shared, rebased;
+		for (uint32_t i = 0; i < 2; i++)
+		{
+			oGFX::Meshlets::Build(shared, idx[i].data(), idx[i].size(), &pos[i][0].x, pos[i].size(), sizeof(glm::vec3));
+
+			// what AppendSubmesh does with a submesh's own meshlets
+			oGFX::Meshlets::MeshletData own;
+			oGFX::Meshlets::Build(own, idx[i].data(), idx[i].size(), &pos[i][0].x, pos[i].size(), sizeof(glm::vec3));
+			const uint32_t vertexBase = static_cast<uint32_t>(rebased.vertices.size());
+			const uint32_t triangleBase = static_cast<uint32_t>(rebased.triangles.size());
+			for (GPUMeshlet m : own.meshlets)
+			{
+				m.vertexOffset += vertexBase;
+				m.triangleOffset += triangleBase;
+				rebased.meshlets.push_back(m);
+			}
+			rebased.vertices.insert(rebased.vertices.end(), own.vertices.begin(), own.vertices.end());
+			rebased.triangles.insert(rebased.triangles.end(), own.triangles.begin(), own.triangles.end());
+		}
+		result &= shared.meshlets.size() == rebased.meshlets.size()
+			&& shared.vertices == rebased.vertices && shared.triangles == rebased.triangles
+			&& memcmp(shared.meshlets.data(), rebased.meshlets.data(), shared.meshlets.size() * sizeof(GPUMeshlet)) == 0;
+
+		std::cout << "  Submeshes:" << serial.size() << " meshlets:" << bunny.meshlets.meshlets.size()
+			<< " rebased meshlets:" << rebased.meshlets.size() << std::endl;
+		std::cout << "  Result:" << (result ? "true" : "false") << std::endl;
+	}
+
+	// ms to import every model the engine ships, one after the other against one task per file
+	// with each file's submeshes spread over the same pool
+	void ModelImportBenchmark(const std::string& testName)
+	{
+		PrintTestHeader(testName);
+
+		std::vector<std::string> files;
+		{
+			Assimp::Importer importer;
+			for (const char* folder : { "Models", "../Application/models" })
+			{
+				if (std::filesystem::exists(folder) == false) continue;
+				for (const auto& entry : std::filesystem::recursive_directory_iterator(folder))
+				{
+					if (entry.is_regular_file() && importer.IsExtensionSupported(entry.path().extension().string()))
+					{
+						files.push_back(entry.path().string());
+					}
+				}
+			}
+		}
+		std::sort(files.begin(), files.end());
+		using Clock = std::chrono::high_resolution_clock;
+
+		std::vector<uint64_t> serialHashes(files.size());
+		size_t submeshes{};
+		auto start = Clock::now();
+		for (size_t i = 0; i < files.size(); i++)
+		{
+			Assimp::Importer importer;
+			std::vector<oGFX::ModelImport::Submesh> converted;
+			if (const aiScene* scene = oGFX::ModelImport::ReadScene(importer, files[i]))
+			{
+				oGFX::ModelImport::ConvertSubmeshes(*scene, converted);
+			}
+			submeshes += converted.size();
+			serialHashes[i] = HashSubmeshes(converted);
+		}
+		const double serialMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+		TaskManager tm;
+		const uint32_t workers = std::max(1u, std::thread::hardware_concurrency() - 1);
+		tm.Init(workers);
+		std::vector<uint64_t> parallelHashes(files.size());
+		start = Clock::now();
+		{
+			std::queue<Task> queue;
+			for (size_t i = 0; i < files.size(); i++)
+			{
+				queue.emplace([&tm, file = &files[i], hash = &parallelHashes[i]](void*) {
+					Assimp::Importer importer;
+					std::vector<oGFX::ModelImport::Submesh> converted;
+					if (const aiScene* scene = oGFX::ModelImport::ReadScene(importer, *file))
+					{
+						oGFX::ModelImport::ConvertSubmeshes(*scene, converted, &tm);
+					}
+					*hash = HashSubmeshes(converted);
+				});
+			}
+			tm.AddTaskListAndWait(queue);
+		}
+		const double parallelMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+		tm.Shutdown();
+
+		std::cout << "  " << files.size() << " files, " << submeshes << " submeshes, " << workers << " workers" << std::endl;
+		std::cout << std::fixed << std::setprecision(1)
+			<< "  Serial:" << serialMs << "ms Parallel:" << parallelMs << "ms ("
+			<< serialMs / std::max(parallelMs, 1e-3) << "x)" << std::defaultfloat << std::endl;
+		const bool result = serialHashes == parallelHashes;
+		std::cout << "  Result:" << (result ? "true" : "false") << std::endl;
+	}
+
+#pragma endregion
+
+#pragma region CookedModel
+	/** Cooked models, imported once and mapped on every load after **/
+
+	// what a model holds that the cooked file must bring back, the texture ids are found again after loading
+	static std::string DescribeModel(const oGFX::ModelImport::Model& model)
+	{
+		std::stringstream ss;
+		const ModelFileResource& res = *model.resource;
+		ss << res.numSubmesh << " " << res.sceneMeshCount << "\n";
+		auto bytes = [&ss](const void* data, size_t size) {
+			uint64_t hash = 0xcbf29ce484222325ull;
+			for (size_t i = 0; i < size; i++) hash = (hash ^ static_cast<const uint8_t*>(data)[i]) * 0x100000001b3ull;
+			ss << size << ":" << hash << "\n";
+		};
+		bytes(res.vertices.data(), res.vertices.size() * sizeof(oGFX::Vertex));
+		bytes(res.indices.data(), res.indices.size() * sizeof(uint32_t));
+		bytes(res.submeshToMaterial.data(), res.submeshToMaterial.size() * sizeof(uint32_t));
+		bytes(res.importReports.data(), res.importReports.size() * sizeof(oGFX::MeshOpt::Report));
+		bytes(res.meshlets.meshlets.data(), res.meshlets.meshlets.size() * sizeof(GPUMeshlet));
+		bytes(res.meshlets.vertices.data(), res.meshlets.vertices.size() * sizeof(uint32_t));
+		bytes(res.meshlets.triangles.data(), res.meshlets.triangles.size() * sizeof(uint32_t));
+		for (const SubMesh& sm : model.submeshes)
+		{
+			ss << sm.name << " " << sm.baseVertex << " " << sm.vertexCount << " " << sm.baseIndices << " " << sm.indicesCount << " "
+				<< sm.boundingSphere.center.x << " " << sm.boundingSphere.radius << " " << sm.meshletOffset << " " << sm.meshletCount << "\n";
+		}
+		for (const Material& m : res.materials)
+		{
+			ss << std::filesystem::path(m.albedo).filename() << std::filesystem::path(m.normal).filename()
+				<< std::filesystem::path(m.specular).filename() << std::filesystem::path(m.roughness).filename() << "\n";
+		}
+		auto nodes = [&ss](auto&& self, const Node* node, int depth) -> void {
+			ss << depth << node->name << node->meshRef << node->transform[3][0] << (node->parent ? node->parent->name : "") << "\n";
+			for (const Node* child : node->children) self(self, child, depth + 1);
+		};
+		if (res.sceneInfo) nodes(nodes, res.sceneInfo, 0);
+		ss << (res.skeleton == model.skeleton.get()) << "\n";
+		if (model.skeleton)
+		{
+			bytes(model.skeleton->boneWeights.data(), model.skeleton->boneWeights.size() * sizeof(BoneWeight));
+			bytes(model.skeleton->inverseBindPose.data(), model.skeleton->inverseBindPose.size() * sizeof(oGFX::BoneInverseBindPoseInfo));
+			auto bones = [&ss](auto&& self, const oGFX::BoneNode* bone, int depth) -> void {
+				ss << depth << bone->mName << bone->m_BoneIndex << bone->mbIsBoneNode << bone->mModelSpaceLocal[3][1]
+					<< bone->mModelSpaceGlobal[3][2] << (bone->mpParent ? bone->mpParent->mName : "") << "\n";
+				for (const oGFX::BoneNode* child : bone->mChildren) self(self, child, depth + 1);
+			};
+			if (model.skeleton->m_boneNodes) bones(bones, model.skeleton->m_boneNodes, 0);
+		}
+		std::map<std::string, uint32_t> names(res.strToBone.begin(), res.strToBone.end());
+		for (const auto& [name, index] : names) ss << name << index << "\n";
+		return ss.str();
+	}
+
+	// a model holding a bit of everything comes back the same, also from another folder, and the file is
+	// refused once it is stale, from another version, cut short or points outside its own arrays
+	void CookedModelTest1(const std::string& testName)
+	{
+		PrintTestHeader(testName);
+
+		const std::filesystem::path folder = std::filesystem::temp_directory_path() / "oo_cooked_model_test";
+		std::filesystem::create_directories(folder / "moved");
+		const std::string source = (folder / "model.fbx").string();
+		const std::string movedSource = (folder / "moved" / "model.fbx").string();
+		const std::string cooked = oGFX::CookedModel::CookedPath(source);
+
+		oGFX::ModelImport::Model model;
+		model.resource = std::make_unique<ModelFileResource>(source);
+		ModelFileResource& res = *model.resource;
+		std::mt19937 rng(3);
+		std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+		res.vertices.resize(200);
+		for (auto& v : res.vertices)
+		{
+			v.pos = { dist(rng), dist(rng), dist(rng) };
+			v.norm = glm::normalize(v.pos);
+			v.tex = { dist(rng), dist(rng) };
+		}
+		// two submeshes of 100 vertices
+		model.submeshes.resize(2);
+		for (uint32_t s = 0; s < 2; s++)
+		{
+			SubMesh& sm = model.submeshes[s];
+			sm.name = "part" + std::to_string(s);
+			sm.baseVertex = s * 100;
+			sm.vertexCount = 100;
+			sm.baseIndices = static_cast<uint32_t>(res.indices.size());
+			for (uint32_t i = 0; i < 300; i++) res.indices.push_back(rng() % 100);
+			sm.indicesCount = 300;
+			sm.boundingSphere = oGFX::Sphere{ { float(s), 0.0f, 0.0f }, 2.0f };
+			sm.meshletOffset = static_cast<uint32_t>(res.meshlets.meshlets.size());
+			sm.meshletCount = static_cast<uint32_t>(oGFX::Meshlets::Build(res.meshlets, res.indices.data() + sm.baseIndices, sm.indicesCount,
+				&res.vertices[sm.baseVertex].pos.x, sm.vertexCount, sizeof(oGFX::Vertex)));
+			res.importReports.push_back({});
+			res.importReports.back().triangles = 100;
+			res.importReports.back().cacheAfter.acmr = 0.75f + s;
+		}
+		res.numSubmesh = 2;
+		res.submeshToMaterial = { 1, 0 };
+		res.materials.resize(2);
+		res.materials[0].albedo = (folder / "wood.png").string();
+		res.materials[1].normal = (folder / "textures" / "brick_n.png").string();
+
+		res.sceneInfo = new Node{};
+		res.sceneInfo->name = "MdlSceneRoot";
+		for (uint32_t i = 0; i < 2; i++)
+		{
+			Node* node = res.sceneInfo->children.emplace_back(new Node{});
+			node->name = "mesh" + std::to_string(i);
+			node->parent = res.sceneInfo;
+			node->meshRef = i;
+			node->transform[3][0] = float(i + 1);
+		}
+		Node* leaf = res.sceneInfo->children[0]->children.emplace_back(new Node{});
+		leaf->name = "leaf";
+		leaf->parent = res.sceneInfo->children[0];
+		res.sceneMeshCount = 2;
+
+		model.skeleton = std::make_unique<oGFX::Skeleton>();
+		res.skeleton = model.skeleton.get();
+		model.skeleton->boneWeights.resize(res.vertices.size());
+		for (auto& w : model.skeleton->boneWeights)
+		{
+			w.boneIdx[0] = rng() % 2;
+			w.boneWeights[0] = 1.0f;
+		}
+		model.skeleton->inverseBindPose = { { 0, glm::mat4{ 2.0f } }, { 1, glm::mat4{ 3.0f } } };
+		model.skeleton->m_boneNodes = new oGFX::BoneNode();
+		model.skeleton->m_boneNodes->mName = "RootNode";
+		oGFX::BoneNode* parent = model.skeleton->m_boneNodes;
+		for (uint32_t i = 0; i < 2; i++)
+		{
+			oGFX::BoneNode* bone = parent->mChildren.emplace_back(new oGFX::BoneNode());
+			bone->mName = i ? "spine" : "hip";
+			bone->m_BoneIndex = i;
+			bone->mbIsBoneNode = true;
+			bone->mpParent = parent;
+			bone->mModelSpaceLocal[3][1] = float(i + 5);
+			bone->mModelSpaceGlobal[3][2] = float(i + 7);
+			res.strToBone[bone->mName] = i;
+			parent = bone;
+		}
+
+		bool result = oGFX::CookedModel::Write(cooked, model, 42);
+		oGFX::ModelImport::Model loaded;
+		result &= oGFX::CookedModel::Read(cooked, movedSource, 42, loaded);
+		result &= loaded.resource && DescribeModel(model) == DescribeModel(loaded);
+		result &= loaded.resource && loaded.resource->fileName == movedSource
+			&& loaded.resource->materials[0].albedo == (folder / "moved" / "wood.png").string()
+			&& loaded.resource->materials[1].normal == (folder / "moved" / "textures" / "brick_n.png").string()
+			&& loaded.resource->materials[1].albedo.empty();
+		std::cout << "  Round trip:" << result << std::endl;
+
+		std::vector<char> bytes(std::filesystem::file_size(cooked));
+		std::ifstream(cooked, std::ios::binary).read(bytes.data(), bytes.size());
+		auto refused = [&](const std::vector<char>& contents, uint64_t hash) {
+			const std::string broken = cooked + ".broken";
+			std::ofstream(broken, std::ios::binary).write(contents.data(), contents.size());
+			oGFX::ModelImport::Model untouched;
+			return oGFX::CookedModel::Read(broken, source, hash, untouched) == false && untouched.resource == nullptr;
+		};
+		std::vector<char> otherVersion = bytes;
+		const uint32_t nextVersion = oGFX::CookedModel::VERSION + 1;
+		memcpy(otherVersion.data() + sizeof(uint32_t), &nextVersion, sizeof(nextVersion));
+		const bool stale = refused(bytes, 43);
+		const bool versioned = refused(otherVersion, 42);
+		const bool truncated = refused(std::vector<char>(bytes.begin(), bytes.end() - 16), 42)
+			&& refused(std::vector<char>(bytes.begin(), bytes.begin() + 24), 42);
+		std::cout << "  Refused stale:" << stale << " other version:" << versioned << " truncated:" << truncated << std::endl;
+		result &= stale && versioned && truncated;
+
+		// Write keeps what it is given, each field is broken on its own and put back after
+		auto refusedWith = [&](auto& field, auto value) {
+			const auto kept = field;
+			field = value;
+			const std::string broken = cooked + ".broken";
+			bool refusedModel = oGFX::CookedModel::Write(broken, model, 42);
+			oGFX::ModelImport::Model untouched;
+			refusedModel &= oGFX::CookedModel::Read(broken, source, 42, untouched) == false && untouched.resource == nullptr;
+			field = kept;
+			return refusedModel;
+		};
+		const bool meshletRanges = refusedWith(res.meshlets.meshlets[1].vertexOffset, uint32_t(res.meshlets.vertices.size()))
+			&& refusedWith(res.meshlets.meshlets[0].triangleCount, uint32_t(res.meshlets.triangles.size() + 1));
+		const bool meshletValues = refusedWith(res.meshlets.vertices[0], 100u)
+			&& refusedWith(res.meshlets.triangles[0], 0xffffffu);
+		const bool indexValues = refusedWith(res.indices[310], 100u); // the second submesh's, one past its vertices
+		const bool boneIds = refusedWith(model.skeleton->boneWeights[7].boneIdx[3], 2u)
+			&& refusedWith(model.skeleton->m_boneNodes->mChildren[0]->m_BoneIndex, 5u)
+			&& refusedWith(model.skeleton->m_boneNodes->mChildren[0]->m_BoneIndex, uint32_t(-1));
+		const bool meshRefs = refusedWith(res.sceneInfo->children[1]->meshRef, 2u);
+		oGFX::ModelImport::Model restored;
+		const bool intact = oGFX::CookedModel::Read(cooked, source, 42, restored) && DescribeModel(model) == DescribeModel(restored);
+		std::cout << "  Refused meshlet ranges:" << meshletRanges << " meshlet values:" << meshletValues << " indices:" << indexValues
+			<< " bone ids:" << boneIds << " mesh refs:" << meshRefs << " intact:" << intact << std::endl;
+		result &= meshletRanges && meshletValues && indexValues && boneIds && meshRefs && intact;
+
+		// the renderer's path, cooked from the source's bytes and stale once they change
+		std::ofstream(source, std::ios::binary) << "not much of a model";
+		model.skeleton.reset();
+		res.skeleton = nullptr;
+		result &= oGFX::CookedModel::Write(cooked, model, oGFX::CookedModel::HashSource(source));
+		oGFX::ModelImport::Model fresh;
+		const bool current = oGFX::CookedModel::Load(source, fresh) && DescribeModel(model) == DescribeModel(fresh)
+			&& fresh.skeleton == nullptr && fresh.resource->skeleton == nullptr;
+		std::ofstream(source, std::ios::binary | std::ios::app) << "!";
+		oGFX::ModelImport::Model changed;
+		const bool edited = oGFX::CookedModel::Load(source, changed) == false;
+		std::cout << "  Current source:" << current << " edited source:" << edited << std::endl;
+		result &= current && edited;
+
+		std::filesystem::remove_all(folder);
+		std::cout << "  Result:" << (result ? "true" : "false") << std::endl;
+	}
+
+	// ms to load every model the engine ships through assimp against from its cooked file, hashing the source included
+	void CookedModelBenchmark(const std::string& testName)
+	{
+		PrintTestHeader(testName);
+
+		std::vector<std::string> files;
+		{
+			Assimp::Importer importer;
+			for (const char* folder : { "Models", "../Application/models" })
+			{
+				if (std::filesystem::exists(folder) == false) continue;
+				for (const auto& entry : std::filesystem::recursive_directory_iterator(folder))
+				{
+					if (entry.is_regular_file() && importer.IsExtensionSupported(entry.path().extension().string()))
+					{
+						files.push_back(entry.path().string());
+					}
+				}
+			}
+		}
+		std::sort(files.begin(), files.end());
+		const std::filesystem::path cookedFolder = std::filesystem::temp_directory_path() / "oo_cooked_model_benchmark";
+		std::filesystem::create_directories(cookedFolder);
+
+		TaskManager tm;
+		tm.Init(std::max(1u, std::thread::hardware_concurrency() - 1));
+		using Clock = std::chrono::high_resolution_clock;
+		bool result = true;
+		double totalCold{};
+		double totalCooked{};
+		for (size_t i = 0; i < files.size(); i++)
+		{
+			const std::string& file = files[i];
+			auto start = Clock::now();
+			oGFX::ModelImport::Model imported;
+			if (oGFX::ModelImport::ImportModel(file, imported, &tm) == false) continue;
+			const double coldMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+			const std::string cooked = (cookedFolder / (std::to_string(i) + ".oomesh")).string();
+			result &= oGFX::CookedModel::Write(cooked, imported, oGFX::CookedModel::HashSource(file));
+
+			start = Clock::now();
+			oGFX::ModelImport::Model loaded;
+			const bool read = oGFX::CookedModel::Read(cooked, file, oGFX::CookedModel::HashSource(file), loaded);
+			const double cookedMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+			result &= read && DescribeModel(imported) == DescribeModel(loaded);
+
+			totalCold += coldMs;
+			totalCooked += cookedMs;
+			std::cout << "  " << std::left << std::setw(40) << std::filesystem::path(file).filename().string() << std::right << std::fixed << std::setprecision(2)
+				<< std::setw(9) << coldMs << "ms" << std::setw(8) << cookedMs << "ms"
+				<< std::setw(8) << std::filesystem::file_size(cooked) / 1024 << "KB" << std::defaultfloat << std::endl;
+		}
+		tm.Shutdown();
+		std::filesystem::remove_all(cookedFolder);
+
+		std::cout << std::fixed << std::setprecision(1)
+			<< "  " << files.size() << " files, Cold:" << totalCold << "ms Cooked:" << totalCooked << "ms ("
+			<< totalCold / std::max(totalCooked, 1e-3) << "x)" << std::defaultfloat << std::endl;
+		std::cout << "  Result:" << (result ? "true" : "false") << std::endl;
+	}
+
+#pragma endregion
+
+#pragma region OctTreeUpdate
+
+/** Moves 1%, 10% and all of a scene every frame, rebuilding the tree against moving only the changed entries **/
+
+	void OctTreeUpdateBenchmark(const std::string& testName)
+	{
+		PrintTestHeader(testName);
+
+		constexpr int frames = 10;
+		const uint32_t counts[] = { 1000, 10000, 50000 };
+		const uint32_t movingPercents[] = { 1, 10, 100 };
+		const Aabb bounds{ Vector3(-250.0f), Vector3(250.0f) };
+		const Frustum frust = Frustum::CreateFromViewProj(glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, 300.0f)
+			* glm::lookAt(Vector3(0.0f), Vector3(0.0f, 0.0f, 1.0f), Vector3(0.0f, 1.0f, 0.0f)));
+
+		// the culling result, the entries of intersecting nodes still get tested against the frustum
+		auto visibleIn = [&frust](OctTree& tree, const std::vector<Aabb>& boxes)
+		{
+			std::vector<uint32_t> contained;
+			std::vector<uint32_t> intersecting;
+			tree.GetEntitiesInFrustum(frust, contained, intersecting);
+			for (uint32_t id : intersecting)
+			{
+				if (coll::AABBInFrustum(frust, boxes[id]) != coll::OUTSIDE)
+				{
+					contained.push_back(id);
+				}
+			}
+			std::sort(contained.begin(), contained.end());
+			return contained;
+		};
+
+		bool result = true;
+		for (uint32_t count : counts)
+		{
+			std::mt19937 rng(count);
+			std::uniform_real_distribution<float> pos(-240.0f, 240.0f);
+			std::uniform_real_distribution<float> ext(0.1f, 2.0f);
+			std::uniform_real_distribution<float> step(-1.0f, 1.0f);
+
+			std::vector<Aabb> boxes(count);
+			for (Aabb& box : boxes)
+			{
+				Vector3 c{ pos(rng), pos(rng), pos(rng) };
+				Vector3 h{ ext(rng) };
+				box = Aabb{ c - h, c + h };
+			}
+
+			OctTree rebuilt(bounds);
+			OctTree incremental(bounds);
+			for (uint32_t i = 0; i < count; i++)
+			{
+				rebuilt.Insert(i, boxes[i]);
+				incremental.Insert(i, boxes[i]);
+			}
+
+			std::vector<uint32_t> ids(count);
+			std::iota(ids.begin(), ids.end(), 0);
+			for (uint32_t percent : movingPercents)
+			{
+				const uint32_t moving = std::max(1u, count * percent / 100);
+				double rebuildMs{};
+				double incrementalMs{};
+				for (int f = 0; f < frames; f++)
+				{
+					std::shuffle(ids.begin(), ids.end(), rng);
+					for (uint32_t m = 0; m < moving; m++)
+					{
+						Aabb& box = boxes[ids[m]];
+						const Vector3 delta = glm::clamp(box.center + Vector3{ step(rng), step(rng), step(rng) },
+							Vector3(-240.0f), Vector3(240.0f)) - box.center;
+						box = Aabb{ box.min() + delta, box.max() + delta };
+					}
+
+					// what the world did before, throw the tree away and insert everything again
+					auto start = std::chrono::high_resolution_clock::now();
+					rebuilt.ClearTree();
+					for (uint32_t i = 0; i < count; i++)
+					{
+						rebuilt.Insert(i, boxes[i]);
+					}
+					auto mid = std::chrono::high_resolution_clock::now();
+					// what GraphicsWorld::BeginFrame does now, only the moved entries relink
+					for (uint32_t m = 0; m < moving; m++)
+					{
+						incremental.Move(ids[m], boxes[ids[m]]);
+					}
+					if (incremental.NeedsRebuild())
+					{
+						incremental.ClearTree();
+						for (uint32_t i = 0; i < count; i++)
+						{
+							incremental.Insert(i, boxes[i]);
+						}
+					}
+					auto end = std::chrono::high_resolution_clock::now();
+
+					rebuildMs += std::chrono::duration<double, std::milli>(mid - start).count();
+					incrementalMs += std::chrono::duration<double, std::milli>(end - mid).count();
+				}
+				rebuildMs /= frames;
+				incrementalMs /= frames;
+
+				std::vector<uint32_t> entities;
+				incremental.GetAllEntities(entities);
+				const bool same = entities.size() == count && visibleIn(rebuilt, boxes) == visibleIn(incremental, boxes);
+				result = result && same;
+				std::cout << "  Objects:" << std::setw(6) << count << " Moving:" << std::setw(3) << percent << "%"
+					<< std::fixed << std::setprecision(3) << " Rebuild:" << rebuildMs << "ms Incremental:" << incrementalMs
+					<< "ms Speedup:" << std::setprecision(2) << rebuildMs / std::max(incrementalMs, 1e-6) << "x"
+					<< std::defaultfloat << (same ? "" : " mismatch") << std::endl;
+			}
+		}
+		std::cout << "  Result:" << (result ? "true" : "false") << std::endl;
+	}
+
+#pragma endregion
+
+#pragma region SnapshotCost
+
+/** Copies a world into a snapshot with names and bones inside each object, the way it was, against the hot only objects copied now **/
+
+	// ObjectInstance as it was before names and bones moved to the cold tables
+	struct LegacyObjectInstance
+	{
+		std::string name;
+		ObjectInstance hot;
+		std::vector<glm::mat4> bones;
+	};
+
+	void SnapshotCostBenchmark(const std::string& testName)
+	{
+		PrintTestHeader(testName);
+
+		constexpr int iterations = 20;
+		constexpr uint32_t numBones = 64;
+		const uint32_t counts[] = { 1000, 10000, 50000 };
+
+		bool result = true;
+		for (uint32_t count : counts)
+		{
+			BitContainer<LegacyObjectInstance> legacy;
+			BitContainer<ObjectInstance> objects;
+			std::vector<std::vector<glm::mat4>> bones(count);
+			for (uint32_t i = 0; i < count; i++)
+			{
+				// one in ten is skinned, names are past the small string buffer like the editor's are
+				ObjectInstance obj;
+				obj.localToWorld = glm::translate(glm::mat4{ 1.0f }, Vector3{ static_cast<float>(i) });
+				obj.entityID = i;
+				obj.SetSkinned(i % 10 == 0);
+
+				LegacyObjectInstance old;
+				old.name = "Level/Props/Object_" + std::to_string(i);
+				old.hot = obj;
+				if (obj.isSkinned())
+				{
+					old.bones.assign(numBones, glm::mat4{ 1.0f });
+					bones[i] = old.bones;
+				}
+				legacy.Add(old);
+				objects.Add(obj);
+			}
+
+			// the snapshots live across frames, so both copy into the storage of the previous copy
+			BitContainer<LegacyObjectInstance> legacySnapshot = legacy;
+			auto start = std::chrono::high_resolution_clock::now();
+			for (int it = 0; it < iterations; it++)
+			{
+				legacySnapshot = legacy;
+			}
+			auto mid = std::chrono::high_resolution_clock::now();
+
+			BitContainer<ObjectInstance> snapshot = objects;
+			std::vector<std::vector<glm::mat4>> snapshotBones = bones;
+			for (int it = 0; it < iterations; it++)
+			{
+				// what GraphicsWorld::PublishSnapshot does
+				snapshot = objects;
+				snapshotBones.resize(std::max(snapshotBones.size(), bones.size()));
+				for (auto iter = objects.begin(); iter != objects.end(); iter++)
+				{
+					if (iter->isSkinned())
+					{
+						snapshotBones[iter.index()] = bones[iter.index()];
+					}
+				}
+			}
+			auto end = std::chrono::high_resolution_clock::now();
+
+			const double legacyMs = std::chrono::duration<double, std::milli>(mid - start).count() / iterations;
+			const double currentMs = std::chrono::duration<double, std::milli>(end - mid).count() / iterations;
+			bool same = legacySnapshot.size() == snapshot.size();
+			for (auto iter = legacySnapshot.begin(); same && iter != legacySnapshot.end(); iter++)
+			{
+				same = memcmp(&iter->hot.localToWorld, &snapshot.Get(static_cast<int32_t>(iter.index())).localToWorld, sizeof(glm::mat4)) == 0
+					&& iter->bones == snapshotBones[iter.index()];
+			}
+			result = result && same;
+
+			std::cout << "  Objects:" << std::setw(6) << count << std::fixed << std::setprecision(3)
+				<< " Inline cold data:" << legacyMs << "ms Hot only:" << currentMs << "ms Speedup:"
+				<< std::setprecision(2) << legacyMs / std::max(currentMs, 1e-6) << "x" << std::defaultfloat
+				<< " (" << sizeof(LegacyObjectInstance) << " against " << sizeof(ObjectInstance) << " bytes per object)" << std::endl;
+		}
+		std::cout << "  Result:" << (result ? "true" : "false") << std::endl;
+	}
+
+#pragma endregion
+
+#pragma region SnapshotAllocations
+
+/** Publishes a world frame after frame and checks no snapshot moves its heap storage once the snapshots have grown to fit it **/
+
+	void SnapshotAllocationTest1(const std::string& testName)
+	{
+		PrintTestHeader(testName);
+
+		constexpr uint32_t numObjects = 1000;
+		constexpr uint32_t numBones = 64;
+		constexpr int warmup = 3;
+		constexpr int frames = 20;
+
+		GraphicsWorld world;
+		world.publishFromGameThread = true;
+		for (uint32_t i = 0; i < numObjects; i++)
+		{
+			const int32_t id = world.CreateObjectInstance();
+			ObjectInstance& obj = world.GetObjectInstance(id);
+			obj.entityID = i;
+			world.GetObjectName(id) = "Level/Props/Object_" + std::to_string(i);
+			if (i % 10 == 0)
+			{
+				// sized up front, the world sizes an empty palette from the model
+				obj.SetSkinned(true);
+				world.GetObjectBones(id).assign(numBones, glm::mat4{ 1.0f });
+			}
+		}
+		for (uint32_t i = 0; i < 8; i++)
+		{
+			world.CreateLightInstance();
+		}
+		for (uint32_t i = 0; i < 4; i++)
+		{
+			EmitterInstance emitter;
+			emitter.particles.resize(256);
+			world.CreateEmitterInstance(emitter);
+		}
+		for (uint32_t i = 0; i < 16; i++)
+		{
+			UIInstance ui;
+			ui.name = "Hud/Label_" + std::to_string(i);
+			ui.textData = "A line of text past the small string buffer";
+			world.CreateUIInstance(ui);
+		}
+
+		// every object and light moves every frame
+		auto simulate = [&world](int frame) {
+			for (ObjectInstance& obj : world.GetAllObjectInstances())
+			{
+				obj.localToWorld = glm::translate(glm::mat4{ 1.0f }, Vector3{ static_cast<float>(frame) });
+			}
+			for (OmniLightInstance& light : world.GetAllOmniLightInstances())
+			{
+				light.position = glm::vec4{ static_cast<float>(frame), 0.0f, 0.0f, 1.0f };
+			}
+		};
+
+		// no renderer consumes here, so the game thread keeps swapping two slots, both hold the world after this
+		for (int f = 0; f < warmup; f++)
+		{
+			simulate(f);
+			world.PublishSnapshot();
+		}
+
+		// every heap buffer the snapshots hold, a copy that allocates leaves a container in another buffer
+		auto storage = [&world]() {
+			std::vector<std::pair<const void*, size_t>> buffers;
+			auto add = [&buffers](const auto& container) { buffers.emplace_back(container.data(), container.capacity()); };
+			for (uint32_t slot = 0; slot < GraphicsWorld::NUM_SNAPSHOTS; slot++)
+			{
+				WorldSnapshot& snapshot = world.GetSnapshot(slot);
+				auto [bits, objects] = snapshot.objects.Raw();
+				add(bits);
+				add(objects);
+				add(snapshot.bones);
+				for (const auto& bones : snapshot.bones) add(bones);
+				add(snapshot.ui);
+				for (const UIInstance& ui : snapshot.ui)
+				{
+					add(ui.name);
+					add(ui.textData);
+				}
+				add(snapshot.omniLights);
+				add(snapshot.omniLightIds);
+				add(snapshot.emitters);
+				for (const EmitterInstance& emitter : snapshot.emitters) add(emitter.particles);
+			}
+			return buffers;
+		};
+
+		const auto before = storage();
+		for (int f = warmup; f < warmup + frames; f++)
+		{
+			simulate(f);
+			world.PublishSnapshot();
+		}
+		const auto after = storage();
+		size_t moved = 0;
+		for (size_t i = 0; i < before.size(); i++)
+		{
+			moved += before[i] != after[i];
+		}
+
+		std::cout << "  Frames:" << frames << " Buffers:" << before.size() << " Reallocated:" << moved << std::endl;
+		std::cout << "  Result:" << (before.size() == after.size() && moved == 0 ? "true" : "false") << std::endl;
+	}
+
+#pragma endregion
+
+#pragma region BitContainer
+
+/** Adds, iterates and removes 1k, 64k and 1M transforms, then churns half of them through the free list **/
+
+	void BitContainerBenchmark(const std::string& testName)
+	{
+		PrintTestHeader(testName);
+
+		const uint32_t counts[] = { 1000, 64 * 1024, 1024 * 1024 };
+		auto nsPerOp = [](auto start, auto end, size_t ops) {
+			return std::chrono::duration<double, std::nano>(end - start).count() / static_cast<double>(ops);
+		};
+
+		bool result = true;
+		for (uint32_t count : counts)
+		{
+			BitContainer<glm::mat4> container;
+			std::vector<int32_t> ids(count);
+
+			auto start = std::chrono::high_resolution_clock::now();
+			for (uint32_t i = 0; i < count; i++)
+			{
+				ids[i] = container.Add(glm::mat4{ static_cast<float>(i) });
+			}
+			auto end = std::chrono::high_resolution_clock::now();
+			const double addNs = nsPerOp(start, end, count);
+
+			start = std::chrono::high_resolution_clock::now();
+			float sum{};
+			size_t visited{};
+			for (const glm::mat4& m : container)
+			{
+				sum += m[0][0];
+				++visited;
+			}
+			end = std::chrono::high_resolution_clock::now();
+			const double iterateNs = nsPerOp(start, end, count);
+
+			// every other one leaves, holes are what iteration has to skip over
+			std::mt19937 rng(count);
+			std::shuffle(ids.begin(), ids.end(), rng);
+			const uint32_t half = count / 2;
+			std::vector<BitContainer<glm::mat4>::Handle> removed(half);
+			start = std::chrono::high_resolution_clock::now();
+			for (uint32_t i = 0; i < half; i++)
+			{
+				removed[i] = container.GetHandle(ids[i]);
+				container.Remove(ids[i]);
+			}
+			end = std::chrono::high_resolution_clock::now();
+			const double removeNs = nsPerOp(start, end, half);
+
+			start = std::chrono::high_resolution_clock::now();
+			size_t sparseVisited{};
+			for (const glm::mat4& m : container)
+			{
+				sum += m[0][0];
+				++sparseVisited;
+			}
+			end = std::chrono::high_resolution_clock::now();
+			const double sparseNs = nsPerOp(start, end, count - half);
+
+			// the free list hands the holes back out, the handles taken before went stale
+			const size_t capacity = container.capacity();
+			start = std::chrono::high_resolution_clock::now();
+			for (uint32_t i = 0; i < half; i++)
+			{
+				container.Add(glm::mat4{ 1.0f });
+			}
+			end = std::chrono::high_resolution_clock::now();
+			const double reuseNs = nsPerOp(start, end, half);
+
+			bool stale = true;
+			for (const auto& h : removed)
+			{
+				stale = stale && container.IsValid(h.id) && container.IsValid(h) == false;
+			}
+			const bool ok = visited == count && sparseVisited == count - half && container.size() == count
+				&& container.capacity() == capacity && stale && sum != 0.0f;
+			result = result && ok;
+
+			std::cout << "  Elements:" << std::setw(8) << count << std::fixed << std::setprecision(2)
+				<< " Add:" << addNs << "ns Iterate:" << iterateNs << "ns Remove:" << removeNs
+				<< "ns IterateHalf:" << sparseNs << "ns Reuse:" << reuseNs << "ns (per element)"
+				<< std::defaultfloat << (ok ? "" : " mismatch") << std::endl;
+		}
+		std::cout << "  Result:" << (result ? "true" : "false") << std::endl;
+	}
+
+/** Destroys an object and creates another in its id, the old handle must go stale and the new one stay valid **/
+
+	void BitContainerHandleTest1(const std::string& testName)
+	{
+		PrintTestHeader(testName);
+
+		GraphicsWorld world;
+		const int32_t first = world.CreateObjectInstance();
+		const GraphicsWorld::ObjectHandle oldHandle = world.GetObjectHandle(first);
+		world.DestroyObjectInstance(oldHandle);
+		const int32_t second = world.CreateObjectInstance();
+		const GraphicsWorld::ObjectHandle newHandle = world.GetObjectHandle(second);
+		world.GetObjectInstance(newHandle).entityID = 42;
+
+		const bool result = first == second
+			&& world.IsValid(oldHandle) == false
+			&& world.IsValid(newHandle) == true
+			&& world.GetObjectInstance(second).entityID == 42;
+		std::cout << "  Result:" << (result ? "true" : "false") << std::endl;
+	}
+
+#pragma endregion
+
+#pragma region FrustumAabbBatchThroughput
+
+/** Culls 10k, 100k and 1M random boxes one at a time, with the scalar batch and with the SSE batch **/
+
+	void FrustumAabbBatchBenchmark(const std::string& testName)
+	{
+		PrintTestHeader(testName);
+
+		constexpr int iterations = 10;
+		const uint32_t counts[] = { 10000, 100000, 1000000 };
+		glm::mat4 proj = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 200.0f);
+		glm::mat4 view = glm::lookAt(Vector3(0.0f, 5.0f, 0.0f), Vector3(0.0f, 0.0f, -50.0f), Vector3(0.0f, 1.0f, 0.0f));
+		const Frustum frust = Frustum::CreateFromViewProj(proj * view);
+
+		auto boxesPerSecond = [](auto start, auto end, size_t boxes) {
+			return static_cast<double>(boxes) * iterations / std::chrono::duration<double>(end - start).count() / 1e6;
+		};
+
+		bool result = true;
+		for (uint32_t count : counts)
+		{
+			std::mt19937 rng(count);
+			std::uniform_real_distribution<float> pos(-250.0f, 250.0f);
+			std::uniform_real_distribution<float> ext(0.1f, 4.0f);
+			std::vector<Aabb> boxes(count);
+			coll::AABBBatch batch;
+			for (Aabb& box : boxes)
+			{
+				Vector3 c{ pos(rng), pos(rng) * 0.1f, pos(rng) };
+				Vector3 h{ ext(rng) };
+				box = Aabb{ c - h, c + h };
+				batch.push_back(box);
+			}
+
+			std::vector<coll::Collision> single(count);
+			std::vector<coll::Collision> scalar(count);
+			std::vector<coll::Collision> simd(count);
+
+			auto start = std::chrono::high_resolution_clock::now();
+			for (int it = 0; it < iterations; it++)
+			{
+				for (uint32_t i = 0; i < count; i++)
+				{
+					single[i] = coll::AABBInFrustum(frust, boxes[i]);
+				}
+			}
+			auto end = std::chrono::high_resolution_clock::now();
+			const double singleRate = boxesPerSecond(start, end, count);
+
+			start = std::chrono::high_resolution_clock::now();
+			for (int it = 0; it < iterations; it++)
+			{
+				coll::AABBInFrustumBatchScalar(frust, batch, scalar.data());
+			}
+			end = std::chrono::high_resolution_clock::now();
+			const double scalarRate = boxesPerSecond(start, end, count);
+
+			start = std::chrono::high_resolution_clock::now();
+			for (int it = 0; it < iterations; it++)
+			{
+				coll::AABBInFrustumBatch(frust, batch, simd.data());
+			}
+			end = std::chrono::high_resolution_clock::now();
+			const double simdRate = boxesPerSecond(start, end, count);
+
+			const bool same = single == scalar && single == simd;
+			result = result && same;
+			std::cout << "  Boxes:" << std::setw(8) << count << std::fixed << std::setprecision(1)
+				<< " Single:" << singleRate << "M/s BatchScalar:" << scalarRate << "M/s BatchSSE:" << simdRate
+				<< "M/s Speedup:" << std::setprecision(2) << simdRate / std::max(scalarRate, 1e-6) << "x over scalar batch, "
+				<< simdRate / std::max(singleRate, 1e-6) << "x over single" << std::defaultfloat
+				<< (same ? "" : " mismatch") << std::endl;
+		}
+		std::cout << "  Result:" << (result ? "true" : "false") << std::endl;
+	}
+
+#pragma endregion
+
+#pragma region MultiViewCulling
+
+/** Multi view culling -- 2 tests, one traversal for every view against culling each view on its own **/
+
+	void RunMultiViewCulling(OctTree& tree, const std::vector<Aabb>& boxes, GraphicsBatch::ViewSet& views, uint32_t numGroups)
+	{
+		TaskManager tm;
+		tm.Init(numGroups);
+		std::queue<Task> tasks;
+		GraphicsBatch::QueueViewCulling(tasks, tree, views, numGroups);
+		tm.AddTaskListAndWait(tasks);
+		tm.Shutdown();
+
+		size_t mismatches{};
+		size_t total{};
+		for (uint32_t v = 0; v < views.size(); v++)
+		{
+			std::vector<uint32_t> alone;
+			for (uint32_t id = 0; id < boxes.size(); id++)
+			{
+				if (coll::AABBInFrustum(views.frustums[v], boxes[id]) != coll::OUTSIDE)
+				{
+					alone.push_back(id);
+				}
+			}
+			std::vector<uint32_t> together = views.visible[v];
+			std::sort(together.begin(), together.end());
+			if (together != alone)
+			{
+				++mismatches;
+			}
+			total += alone.size();
+		}
+		std::cout << "  Views:" << views.size() << " Visible:" << total << std::endl;
+		std::cout << "  Result:" << (mismatches ? "false" : "true") << " mismatches:" << mismatches << std::endl;
+	}
+
+	// A camera and 3 point lights over a scattered scene, the views split over 3 groups
+	void MultiViewCullingTest1(const std::string& testName)
+	{
+		PrintTestHeader(testName);
+
+		std::mt19937 rng(6);
+		std::uniform_real_distribution<float> pos(-90.0f, 90.0f);
+		std::uniform_real_distribution<float> ext(0.1f, 3.0f);
+
+		OctTree tree(Aabb{ Vector3(-100.0f), Vector3(100.0f) });
+		std::vector<Aabb> boxes(2000);
+		for (uint32_t i = 0; i < boxes.size(); i++)
+		{
+			Vector3 c{ pos(rng), pos(rng), pos(rng) };
+			boxes[i] = Aabb{ c - Vector3(ext(rng)), c + Vector3(ext(rng)) };
+			tree.Insert(i, boxes[i]);
+		}
+
+		GraphicsBatch::ViewSet views;
+		glm::mat4 camera = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 120.0f)
+			* glm::lookAt(Vector3(0.0f, 10.0f, 80.0f), Vector3(0.0f), Vector3(0.0f, 1.0f, 0.0f));
+		views.AddView(Frustum::CreateFromViewProj(camera));
+		const Vector3 faces[] = { {1,0,0}, {-1,0,0}, {0,1,0}, {0,-1,0}, {0,0,1}, {0,0,-1} };
+		const Vector3 ups[] = { {0,1,0}, {0,1,0}, {0,0,1}, {0,0,-1}, {0,-1,0}, {0,-1,0} };
+		glm::mat4 faceProj = glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, 40.0f);
+		for (uint32_t l = 0; l < 3; l++)
+		{
+			Vector3 light{ pos(rng), pos(rng), pos(rng) };
+			for (uint32_t f = 0; f < POINT_LIGHT_FACE_COUNT; f++)
+			{
+				views.AddView(Frustum::CreateFromViewProj(faceProj * glm::lookAt(light, light + faces[f], ups[f])));
+			}
+		}
+
+		RunMultiViewCulling(tree, boxes, views, 3);
+	}
+
+	// Every view slot used and objects left outside the root bounds before a rebuild
+	void MultiViewCullingTest2(const std::string& testName)
+	{
+		PrintTestHeader(testName);
+
+		std::mt19937 rng(7);
+		std::uniform_real_distribution<float> pos(-60.0f, 60.0f);
+		std::uniform_real_distribution<float> far(-140.0f, 140.0f);
+		std::uniform_real_distribution<float> angle(0.0f, glm::two_pi<float>());
+
+		OctTree tree(Aabb{ Vector3(-50.0f), Vector3(50.0f) });
+		std::vector<Aabb> boxes(1500);
+		for (uint32_t i = 0; i < boxes.size(); i++)
+		{
+			Vector3 c = i % 5 ? Vector3{ pos(rng), pos(rng), pos(rng) } : Vector3{ far(rng), far(rng), far(rng) };
+			boxes[i] = Aabb{ c - Vector3(1.0f), c + Vector3(1.0f) };
+			tree.Insert(i, boxes[i]);
+		}
+
+		GraphicsBatch::ViewSet views;
+		glm::mat4 proj = glm::perspective(glm::radians(75.0f), 1.0f, 0.5f, 100.0f);
+		for (uint32_t v = 0; v < OctTree::s_max_views; v++)
+		{
+			Vector3 eye{ pos(rng), pos(rng), pos(rng) };
+			float a = angle(rng);
+			views.AddView(Frustum::CreateFromViewProj(proj * glm::lookAt(eye, eye + Vector3(cosf(a), 0.0f, sinf(a)), Vector3(0, 1, 0))));
+		}
+
+		std::cout << "  OutOfBounds:" << (tree.NeedsRebuild() ? "true" : "false") << std::endl;
+		RunMultiViewCulling(tree, boxes, views, 4);
+	}
+
+#pragma endregion
+
+#pragma region GPUSceneSlots
+
+/** GPU scene slots -- only the objects that changed since their last upload go out, in merged ranges **/
+
+	// Frames of a small scene: objects move, stop, change information and are seen by more than one view
+	void GPUSceneSlotsTest1(const std::string& testName)
+	{
+		PrintTestHeader(testName);
+
+		using Range = GPUSceneSlots::Range;
+		struct Object
+		{
+			uint32_t dirtyGeneration{};
+			bool moving{ false };
+			uint32_t info{};
+		};
+
+		constexpr uint32_t numObjects = 64;
+		std::vector<Object> objects(numObjects);
+		std::vector<uint32_t> uploadedInfo(numObjects);
+		GPUSceneSlots slots;
+		std::vector<Range> transforms;
+		std::vector<Range> infos;
+		uint32_t rebuilt = 0;
+
+		// what the renderer does for every object a view draws
+		auto draw = [&](uint32_t id)
+		{
+			const Object& o = objects[id];
+			if (slots.NeedsTransform(id, o.dirtyGeneration))
+			{
+				++rebuilt;
+				slots.SetTransform(id, o.dirtyGeneration, o.moving);
+			}
+			if (slots.HasInfo(id) == false || uploadedInfo[id] != o.info)
+			{
+				uploadedInfo[id] = o.info;
+				slots.SetInfo(id);
+			}
+		};
+		auto frame = [&](uint32_t firstVisible, uint32_t endVisible)
+		{
+			rebuilt = 0;
+			slots.Resize(objects.size());
+			for (uint32_t id = firstVisible; id < endVisible; id++)
+			{
+				draw(id);
+			}
+		};
+		auto move = [&](uint32_t id, bool moving)
+		{
+			objects[id].moving = moving;
+			if (moving) ++objects[id].dirtyGeneration;
+		};
+		auto same = [](const std::vector<Range>& a, const std::vector<Range>& b)
+		{
+			if (a.size() != b.size()) return false;
+			for (size_t i = 0; i < a.size(); i++)
+			{
+				if (a[i].first != b[i].first || a[i].count != b[i].count) return false;
+			}
+			return true;
+		};
+
+		bool result = true;
+
+		// first frame, only what is drawn goes out, in one piece
+		frame(0, 48);
+		slots.TakeTransformRanges(transforms);
+		slots.TakeInfoRanges(infos);
+		result = result && same(transforms, { {0, 48} }) && same(infos, { {0, 48} }) && rebuilt == 48;
+
+		// nothing changed
+		frame(0, 48);
+		result = result && slots.HasQueued() == false && rebuilt == 0;
+
+		// a few move, 4 is also drawn by a shadow face and must still go out once
+		move(3, true); move(4, true); move(5, true); move(40, true);
+		frame(0, 48);
+		draw(4); draw(40);
+		slots.TakeTransformRanges(transforms);
+		slots.TakeInfoRanges(infos);
+		result = result && same(transforms, { {3, 3}, {40, 1} }) && infos.empty() && rebuilt == 4;
+
+		// 40 keeps moving, the rest stop and go out once more so the previous transform catches up
+		move(3, false); move(4, false); move(5, false); move(40, true);
+		frame(0, 48);
+		slots.TakeTransformRanges(transforms);
+		result = result && same(transforms, { {3, 3}, {40, 1} });
+
+		// settled, only 40 is left
+		move(40, false);
+		frame(0, 48);
+		slots.TakeTransformRanges(transforms);
+		result = result && same(transforms, { {40, 1} });
+		frame(0, 48);
+		result = result && slots.HasQueued() == false;
+
+		// an information change leaves the transform alone
+		objects[10].info = 1;
+		objects[11].info = 1;
+		objects[20].info = 1;
+		frame(0, 48);
+		slots.TakeTransformRanges(transforms);
+		slots.TakeInfoRanges(infos);
+		result = result && transforms.empty() && same(infos, { {10, 2}, {20, 1} });
+
+		// an object that moves out of view is not uploaded until it is drawn again
+		move(45, true);
+		frame(0, 40);
+		result = result && slots.HasQueued() == false;
+		frame(0, 48);
+		slots.TakeTransformRanges(transforms);
+		result = result && same(transforms, { {45, 1} });
+
+		// the buffers grew, every slot with data goes out again, the never drawn ones stay out
+		move(45, false);
+		objects.resize(numObjects * 2);
+		uploadedInfo.resize(numObjects * 2);
+		frame(0, 0);
+		slots.QueueAll();
+		slots.TakeTransformRanges(transforms);
+		slots.TakeInfoRanges(infos);
+		result = result && same(transforms, { {0, 48} }) && same(infos, { {0, 48} });
+
+		// taking empties the queue
+		slots.TakeTransformRanges(transforms);
+		result = result && transforms.empty() && slots.HasQueued() == false;
+
+		std::cout << "  Result:" << (result ? "true" : "false") << std::endl;
+	}
+
+#pragma endregion
+
+#pragma region DescriptorSetCache
+
+/** Descriptor set cache -- a set written this frame is only handed out again for the same layout and resources **/
+
+	template <typename Handle>
+	Handle FakeVkHandle(uintptr_t value)
+	{
+		return reinterpret_cast<Handle>(value);
+	}
+
+	// Builds sets the way the passes do and looks them up, no device needed since nothing is allocated
+	void DescriptorSetCacheTest1(const std::string& testName)
+	{
+		PrintTestHeader(testName);
+
+		DescriptorAllocator alloc;
+		alloc.Init(VK_NULL_HANDLE, 1);
+
+		const VkDescriptorSetLayout layoutA = FakeVkHandle<VkDescriptorSetLayout>(0x10);
+		const VkDescriptorSetLayout layoutB = FakeVkHandle<VkDescriptorSetLayout>(0x20);
+		const VkSampler sampler = FakeVkHandle<VkSampler>(0x30);
+
+		auto makeContent = [&](VkDescriptorSetLayout layout, VkBuffer buffer, VkDeviceSize offset, VkImageView secondView)
+		{
+			VkDescriptorBufferInfo bufferInfo{ buffer, offset, 256 };
+			VkDescriptorImageInfo images[2]{
+				{ sampler, FakeVkHandle<VkImageView>(0x100), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL },
+				{ sampler, secondView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL },
+			};
+			DescriptorBuilder builder;
+			builder.BindBuffer(0, &bufferInfo, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+				.BindImage(1, images, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_COMPUTE_BIT, 2);
+			return builder.GetContent(layout);
+		};
+
+		const VkBuffer bufferA = FakeVkHandle<VkBuffer>(0x200);
+		const VkBuffer bufferB = FakeVkHandle<VkBuffer>(0x300);
+		const VkImageView viewA = FakeVkHandle<VkImageView>(0x400);
+		const VkImageView viewB = FakeVkHandle<VkImageView>(0x500);
+		const VkDescriptorSet setA = FakeVkHandle<VkDescriptorSet>(0x1000);
+
+		bool result = true;
+
+		result = result && alloc.FindCached(makeContent(layoutA, bufferA, 0, viewA), 0) == VK_NULL_HANDLE;
+		alloc.AddCached(makeContent(layoutA, bufferA, 0, viewA), setA, 0);
+
+		// the same content is shared
+		result = result && alloc.FindCached(makeContent(layoutA, bufferA, 0, viewA), 0) == setA;
+
+		// anything else written is a different set, down to the last element of an array
+		result = result && alloc.FindCached(makeContent(layoutA, bufferA, 0, viewB), 0) == VK_NULL_HANDLE;
+		result = result && alloc.FindCached(makeContent(layoutA, bufferB, 0, viewA), 0) == VK_NULL_HANDLE;
+		result = result && alloc.FindCached(makeContent(layoutA, bufferA, 256, viewA), 0) == VK_NULL_HANDLE;
+		result = result && alloc.FindCached(makeContent(layoutB, bufferA, 0, viewA), 0) == VK_NULL_HANDLE;
+
+		// every buffer of an array write counts
+		DescriptorSetContent buffers;
+		buffers.layout = layoutA;
+		buffers.writes.push_back({ 0, 0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2 });
+		buffers.bufferInfos = { { bufferA, 0, 256 }, { bufferA, 256, 256 } };
+		DescriptorSetContent otherBuffers = buffers;
+		otherBuffers.bufferInfos[1].buffer = bufferB;
+		result = result && (buffers == otherBuffers) == false;
+		alloc.AddCached(DescriptorSetContent{ buffers }, FakeVkHandle<VkDescriptorSet>(0x2000), 0);
+		result = result && alloc.FindCached(otherBuffers, 0) == VK_NULL_HANDLE;
+		result = result && alloc.FindCached(buffers, 0) == FakeVkHandle<VkDescriptorSet>(0x2000);
+
+		result = result && alloc.GetStats().cacheHits == 2;
+
+		// the sets go back with their pools
+		alloc.ResetPools();
+		result = result && alloc.FindCached(makeContent(layoutA, bufferA, 0, viewA), 0) == VK_NULL_HANDLE;
+		alloc.Cleanup();
+
+		std::cout << "  Result:" << (result ? "true" : "false") << std::endl;
+	}
+
+} // end namespace oGFX
+
+#pragma endregion
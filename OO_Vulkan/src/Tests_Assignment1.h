@@ -708,6 +708,59 @@ void PlaneAabbTest48(const stdstring& testName);
 void PlaneAabbTest49(const stdstring& testName);
 void PlaneAabbTest50(const stdstring& testName);
 
+void FrustumAabbBatchTest1(const stdstring& testName);
+void FrustumAabbBatchTest2(const stdstring& testName);
+
+void CullViewsScalingBenchmark(const stdstring& testName);
+void TaskManagerContentionBenchmark(const stdstring& testName);
+
+void StagingRingTest1(const stdstring& testName);
+void StagingRingTest2(const stdstring& testName);
+
+void ShadowAtlasTest1(const stdstring& testName);
+void ShadowAtlasTest2(const stdstring& testName);
+
+void RenderGraphCompileTest1(const stdstring& testName);
+void RenderGraphCompileTest2(const stdstring& testName);
+
+void TransientAliasingTest1(const stdstring& testName);
+void TransientAliasingTest2(const stdstring& testName);
+
+void PipelineCacheTest1(const stdstring& testName);
+void PipelineCacheTest2(const stdstring& testName);
+
+void ShardedRegistryStressTest(const stdstring& testName);
+
+void MeshRangeAllocatorTest1(const stdstring& testName);
+void MeshRangeAllocatorTest2(const stdstring& testName);
+
+void MeshOptimizerTest1(const stdstring& testName);
+void MeshOptimizerTest2(const stdstring& testName);
+void VertexPackingTest1(const stdstring& testName);
+void VertexPackingTest2(const stdstring& testName);
+void MeshletTest1(const stdstring& testName);
+void MeshletTest2(const stdstring& testName);
+void TextureUploaderTest1(const stdstring& testName);
+void TextureUploaderBenchmark(const stdstring& testName);
+void TextureResidencyTest1(const stdstring& testName);
+void TextureResidencyTest2(const stdstring& testName);
+void ImageLoadingTest1(const stdstring& testName);
+void ImageLoadingBenchmark(const stdstring& testName);
+void ModelImportTest1(const stdstring& testName);
+void ModelImportBenchmark(const stdstring& testName);
+void CookedModelTest1(const stdstring& testName);
+void CookedModelBenchmark(const stdstring& testName);
+void OctTreeUpdateBenchmark(const stdstring& testName);
+void SnapshotCostBenchmark(const stdstring& testName);
+void SnapshotAllocationTest1(const stdstring& testName);
+void BitContainerBenchmark(const stdstring& testName);
+void BitContainerHandleTest1(const stdstring& testName);
+void FrustumAabbBatchBenchmark(const stdstring& testName);
+void MultiViewCullingTest1(const stdstring& testName);
+void MultiViewCullingTest2(const stdstring& testName);
+void GPUSceneSlotsTest1(const stdstring& testName);
+void DescriptorSetCacheTest1(const stdstring& testName);
+
 #pragma endregion
 
 
@@ -0,0 +1,247 @@
+/************************************************************************************//*!
+\file           TextureResidency.cpp
+\project        Ouroboros
+\author         Jamie Kong, j.kong, 390004720 | code contribution (100%)
+\par            email: j.kong\@digipen.edu
+\date           May 28, 2024
+\brief              Defines the mip residency policy of streamed textures, which mips each texture
+should hold on the GPU under a memory budget
+
+Copyright (C) 2022 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents
+without the prior written consent of DigiPen Institute of
+Technology is prohibited.
+*//*************************************************************************************/
+#include "TextureResidency.h"
+#include "UtilCommon.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	constexpr uint64_t NEVER = ~0ull;
+}
+
+namespace oGFX
+{
+
+uint64_t TextureResidency::Texture::BytesFrom(uint32_t mip) const
+{
+	uint64_t bytes{};
+	for (size_t m = mip; m < mipBytes.size(); m++)
+	{
+		bytes += mipBytes[m];
+	}
+	return bytes;
+}
+
+void TextureResidency::Init(uint64_t budgetBytes, uint64_t uploadBytesPerFrame)
+{
+	m_textures.clear();
+	m_budget = budgetBytes;
+	m_uploadPerFrame = uploadBytesPerFrame;
+	m_targetBytes = 0;
+	m_stats = {};
+}
+
+void TextureResidency::SetBudget(uint64_t budgetBytes)
+{
+	m_budget = budgetBytes;
+}
+
+void TextureResidency::Register(uint32_t textureID, uint32_t size, std::vector<uint64_t> mipBytes, uint32_t tailMip)
+{
+	OO_ASSERT(tailMip < mipBytes.size());
+	if (textureID >= m_textures.size())
+	{
+		m_textures.resize(textureID + 1);
+	}
+	Texture& t = m_textures[textureID];
+	OO_ASSERT(t.registered == false);
+	t.mipBytes = std::move(mipBytes);
+	t.size = size;
+	t.tailMip = tailMip;
+	t.residentMip = tailMip;
+	t.pendingMip = tailMip;
+	t.requestedMip = tailMip;
+	t.lastRequested = NEVER;
+	t.registered = true;
+	m_targetBytes += t.BytesFrom(tailMip);
+}
+
+void TextureResidency::Unregister(uint32_t textureID)
+{
+	if (IsStreamed(textureID) == false)
+		return;
+	Texture& t = m_textures[textureID];
+	m_targetBytes -= t.BytesFrom(t.pendingMip);
+	t = Texture{};
+}
+
+bool TextureResidency::IsStreamed(uint32_t textureID) const
+{
+	return textureID < m_textures.size() && m_textures[textureID].registered;
+}
+
+const TextureResidency::Texture* TextureResidency::Get(uint32_t textureID) const
+{
+	return IsStreamed(textureID) ? &m_textures[textureID] : nullptr;
+}
+
+void TextureResidency::Request(uint32_t textureID, uint32_t mip, uint64_t frame)
+{
+	if (IsStreamed(textureID) == false)
+		return;
+	Texture& t = m_textures[textureID];
+	if (t.lastRequested != frame)
+	{
+		t.requestedMip = mip;
+		t.lastRequested = frame;
+	}
+	t.requestedMip = std::min(t.requestedMip, mip);
+}
+
+uint32_t TextureResidency::Wanted(const Texture& t, uint64_t frame) const
+{
+	// the requests of a frame are made while it is recorded and acted on at the start of the next
+	const bool seen = t.lastRequested != NEVER && t.lastRequested + 1 >= frame;
+	return seen ? std::min(t.requestedMip, t.tailMip) : t.tailMip;
+}
+
+void TextureResidency::Update(uint64_t frame, std::vector<Change>& out)
+{
+	out.clear();
+	m_stats.uploadBytes = 0;
+
+	std::vector<uint32_t> loads;
+	std::vector<uint32_t> victims;
+	for (uint32_t id = 0; id < m_textures.size(); id++)
+	{
+		const Texture& t = m_textures[id];
+		if (t.registered == false || t.Busy())
+			continue;
+		const uint32_t wanted = Wanted(t, frame);
+		if (wanted < t.residentMip)
+		{
+			loads.push_back(id);
+		}
+		else if (wanted > t.residentMip)
+		{
+			victims.push_back(id);
+		}
+	}
+
+	// the textures furthest from what they should show first
+	std::sort(loads.begin(), loads.end(), [this, frame](uint32_t l, uint32_t r) {
+		const uint32_t lGap = m_textures[l].residentMip - Wanted(m_textures[l], frame);
+		const uint32_t rGap = m_textures[r].residentMip - Wanted(m_textures[r], frame);
+		return lGap != rGap ? lGap > rGap : l < r;
+	});
+	// least recently used first, the largest first among those seen in the same frame
+	std::sort(victims.begin(), victims.end(), [this](uint32_t l, uint32_t r) {
+		const Texture& lt = m_textures[l];
+		const Texture& rt = m_textures[r];
+		const uint64_t lSeen = lt.lastRequested == NEVER ? 0 : lt.lastRequested + 1;
+		const uint64_t rSeen = rt.lastRequested == NEVER ? 0 : rt.lastRequested + 1;
+		if (lSeen != rSeen)
+			return lSeen < rSeen;
+		const uint64_t lBytes = lt.BytesFrom(lt.residentMip);
+		const uint64_t rBytes = rt.BytesFrom(rt.residentMip);
+		return lBytes != rBytes ? lBytes > rBytes : l < r;
+	});
+
+	// every change uploads the whole new range of mips, the texture is recreated with it
+	auto change = [this, &out](uint32_t id, uint32_t toMip) {
+		Texture& t = m_textures[id];
+		m_targetBytes = m_targetBytes - t.BytesFrom(t.pendingMip) + t.BytesFrom(toMip);
+		m_stats.uploadBytes += t.BytesFrom(toMip);
+		out.push_back(Change{ id, t.residentMip, toMip });
+		t.pendingMip = toMip;
+	};
+	size_t nextVictim = 0;
+	auto evict = [this, frame, &victims, &nextVictim, &change]() {
+		if (nextVictim == victims.size())
+			return false;
+		const uint32_t id = victims[nextVictim++];
+		change(id, Wanted(m_textures[id], frame));
+		++m_stats.evictions;
+		return true;
+	};
+
+	for (uint32_t id : loads)
+	{
+		const Texture& t = m_textures[id];
+		// as fine as fits, a coarser mip than wanted still beats the one shown
+		for (uint32_t mip = Wanted(t, frame); mip < t.residentMip; mip++)
+		{
+			// the first load of a frame always goes, however large
+			if (m_stats.uploadBytes > 0 && m_stats.uploadBytes + t.BytesFrom(mip) > m_uploadPerFrame)
+				continue;
+			const uint64_t grow = t.BytesFrom(mip) - t.BytesFrom(t.residentMip);
+			while (m_targetBytes + grow > m_budget && evict())
+			{
+			}
+			if (m_targetBytes + grow > m_budget)
+				continue;
+
+			change(id, mip);
+			++m_stats.loads;
+			break;
+		}
+	}
+
+	// nothing left to load but still over, the budget was lowered
+	while (m_targetBytes > m_budget && evict())
+	{
+	}
+}
+
+void TextureResidency::Complete(uint32_t textureID, uint32_t mip)
+{
+	if (IsStreamed(textureID) == false)
+		return;
+	Texture& t = m_textures[textureID];
+	if (t.pendingMip == mip)
+	{
+		t.residentMip = mip;
+	}
+}
+
+uint32_t TextureResidency::MipForCoverage(uint32_t textureSize, uint32_t mipCount, float radius, float distance, float tanHalfFov, uint32_t screenHeight)
+{
+	OO_ASSERT(mipCount > 0);
+	// fraction of the screen height the sphere spans, the whole screen once the camera is inside it
+	float coverage = 1.0f;
+	if (distance > radius && tanHalfFov > 0.0f)
+	{
+		coverage = std::min(1.0f, radius / (distance * tanHalfFov));
+	}
+	const float pixels = std::max(1.0f, coverage * static_cast<float>(screenHeight));
+
+	// finest mip with at most 2 texels a pixel
+	const float texelsPerPixel = static_cast<float>(textureSize) / pixels;
+	const uint32_t mip = texelsPerPixel > 1.0f ? static_cast<uint32_t>(std::floor(std::log2(texelsPerPixel))) : 0;
+	return std::min(mip, mipCount - 1);
+}
+
+TextureResidency::Stats TextureResidency::GetStats() const
+{
+	Stats stats = m_stats;
+	stats.budget = m_budget;
+	stats.targetBytes = m_targetBytes;
+	stats.residentBytes = 0;
+	stats.streamed = 0;
+	stats.changesInFlight = 0;
+	for (const Texture& t : m_textures)
+	{
+		if (t.registered == false)
+			continue;
+		stats.residentBytes += t.BytesFrom(t.residentMip);
+		++stats.streamed;
+		stats.changesInFlight += t.Busy();
+	}
+	return stats;
+}
+
+}
@@ -0,0 +1,98 @@
+/************************************************************************************//*!
+\file           TextureResidency.h
+\project        Ouroboros
+\author         Jamie Kong, j.kong, 390004720 | code contribution (100%)
+\par            email: j.kong\@digipen.edu
+\date           May 28, 2024
+\brief              Declares the mip residency policy of streamed textures, which mips each texture
+should hold on the GPU under a memory budget
+
+Copyright (C) 2022 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents
+without the prior written consent of DigiPen Institute of
+Technology is prohibited.
+*//*************************************************************************************/
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace oGFX
+{
+
+// Decides which mips of the streamed textures are resident, works on sizes and frame numbers only
+// so it can be tested without a device. A texture always holds one range of mips, its finest mip down to the last.
+class TextureResidency
+{
+public:
+	struct Texture
+	{
+		std::vector<uint64_t> mipBytes;	// size of each mip, finest first
+		uint32_t size{};				// largest side of mip 0
+		uint32_t tailMip{};				// the mips from here on are always resident
+		uint32_t residentMip{};			// finest mip on the GPU
+		uint32_t pendingMip{};			// finest mip of the change in flight, residentMip when there is none
+		uint32_t requestedMip{};		// finest mip asked for in the last frame it was requested
+		uint64_t lastRequested{};		// frame of the last request
+		bool registered{ false };
+
+		bool Busy() const { return pendingMip != residentMip; }
+		uint64_t BytesFrom(uint32_t mip) const;
+	};
+
+	// New range of mips for a texture, finer when loading and coarser when evicting
+	struct Change
+	{
+		uint32_t textureID{};
+		uint32_t fromMip{};
+		uint32_t toMip{};
+	};
+
+	struct Stats
+	{
+		uint64_t budget{};
+		uint64_t residentBytes{};	// what the GPU holds now
+		uint64_t targetBytes{};		// what it holds once the changes in flight land, kept under the budget
+		uint64_t uploadBytes{};		// sent in the last Update
+		uint32_t streamed{};
+		uint32_t changesInFlight{};
+		uint64_t loads{};
+		uint64_t evictions{};
+	};
+
+	void Init(uint64_t budgetBytes, uint64_t uploadBytesPerFrame);
+	void SetBudget(uint64_t budgetBytes);
+
+	// The texture starts with its mips from tailMip on resident, as they are uploaded on load
+	void Register(uint32_t textureID, uint32_t size, std::vector<uint64_t> mipBytes, uint32_t tailMip);
+	void Unregister(uint32_t textureID);
+	bool IsStreamed(uint32_t textureID) const;
+	const Texture* Get(uint32_t textureID) const;
+
+	// Finest mip wanted on screen, the finest of all requests of the frame wins
+	void Request(uint32_t textureID, uint32_t mip, uint64_t frame);
+
+	// Sends the textures that are wanted finer than they are the mips they asked for, most wanted first and up to the
+	// per frame upload budget. Textures holding finer mips than they were last asked for give them back least recently
+	// used first, but only when the budget needs the room. Unrequested textures fall back to their tail.
+	void Update(uint64_t frame, std::vector<Change>& out);
+
+	// The upload of the change finished, the texture now holds mip and coarser
+	void Complete(uint32_t textureID, uint32_t mip);
+
+	// Finest mip worth sampling when the texture spans the object's sphere once, from how large the sphere is on screen
+	static uint32_t MipForCoverage(uint32_t textureSize, uint32_t mipCount, float radius, float distance, float tanHalfFov, uint32_t screenHeight);
+
+	Stats GetStats() const;
+
+private:
+	uint32_t Wanted(const Texture& t, uint64_t frame) const;
+
+	std::vector<Texture> m_textures;	// indexed by texture id
+	uint64_t m_budget{};
+	uint64_t m_uploadPerFrame{};
+	uint64_t m_targetBytes{};
+	Stats m_stats{};
+};
+
+}
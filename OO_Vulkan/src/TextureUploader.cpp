@@ -0,0 +1,483 @@
+/************************************************************************************//*!
+\file           TextureUploader.cpp
+\project        Ouroboros
+\author         Jamie Kong, j.kong, 390004720 | code contribution (100%)
+\par            email: j.kong\@digipen.edu
+\date           May 27, 2024
+\brief              Defines the batched texture upload service, copies run on the transfer queue
+when the device has one and completion is tracked with timeline semaphores
+
+Copyright (C) 2022 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents
+without the prior written consent of DigiPen Institute of
+Technology is prohibited.
+*//*************************************************************************************/
+#include "TextureUploader.h"
+#include "Profiling.h"
+#include "UtilCommon.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+	VkSemaphore CreateTimelineSemaphore(VkDevice device)
+	{
+		VkSemaphoreTypeCreateInfo timelineCreateInfo{};
+		timelineCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+		timelineCreateInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+		timelineCreateInfo.initialValue = 0;
+
+		VkSemaphoreCreateInfo sci{};
+		sci.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+		sci.pNext = &timelineCreateInfo;
+		VkSemaphore semaphore{ VK_NULL_HANDLE };
+		VK_CHK(vkCreateSemaphore(device, &sci, nullptr, &semaphore));
+		return semaphore;
+	}
+
+	VkCommandPool CreatePool(VkDevice device, uint32_t family)
+	{
+		VkCommandPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+		poolInfo.queueFamilyIndex = family;
+		VkCommandPool pool{ VK_NULL_HANDLE };
+		VK_CHK(vkCreateCommandPool(device, &poolInfo, nullptr, &pool));
+		return pool;
+	}
+
+	void Barrier(VkCommandBuffer cmd, const std::vector<VkImageMemoryBarrier2>& barriers)
+	{
+		VkDependencyInfo di{ VK_STRUCTURE_TYPE_DEPENDENCY_INFO };
+		di.imageMemoryBarrierCount = static_cast<uint32_t>(barriers.size());
+		di.pImageMemoryBarriers = barriers.data();
+		vkCmdPipelineBarrier2(cmd, &di);
+	}
+
+	// Levels the regions copy, counted from level 0
+	uint32_t CopiedLevels(const oGFX::TextureUploader::Upload& upload)
+	{
+		uint32_t levels = 0;
+		for (const VkBufferImageCopy& region : upload.regions)
+		{
+			levels = std::max(levels, region.imageSubresource.mipLevel + 1);
+		}
+		return levels;
+	}
+
+	bool BlitsMips(const oGFX::TextureUploader::Upload& upload)
+	{
+		return upload.generateMips && CopiedLevels(upload) < upload.range.baseMipLevel + upload.range.levelCount;
+	}
+
+	// Every level starts in TRANSFER_DST_OPTIMAL and ends in the upload's final layout, each one halves the one above it
+	void BlitMips(VkCommandBuffer cmd, const oGFX::TextureUploader::Upload& upload)
+	{
+		const VkImageSubresourceRange& range = upload.range;
+		const uint32_t copied = CopiedLevels(upload);
+		const uint32_t last = range.baseMipLevel + range.levelCount - 1;
+
+		VkOffset3D size{ 1, 1, 1 };
+		for (const VkBufferImageCopy& region : upload.regions)
+		{
+			if (region.imageSubresource.mipLevel == copied - 1)
+			{
+				size = { static_cast<int32_t>(region.imageExtent.width), static_cast<int32_t>(region.imageExtent.height), 1 };
+			}
+		}
+
+		VkImageMemoryBarrier2 b{ VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2 };
+		b.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		b.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		b.image = upload.image;
+		b.subresourceRange = range;
+		b.subresourceRange.levelCount = 1;
+		for (uint32_t level = copied; level <= last; level++)
+		{
+			// the level above was copied or blitted, it is read from now on
+			b.srcStageMask = VK_PIPELINE_STAGE_2_COPY_BIT | VK_PIPELINE_STAGE_2_BLIT_BIT;
+			b.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+			b.dstStageMask = VK_PIPELINE_STAGE_2_BLIT_BIT;
+			b.dstAccessMask = VK_ACCESS_2_TRANSFER_READ_BIT;
+			b.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+			b.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+			b.subresourceRange.baseMipLevel = level - 1;
+			Barrier(cmd, { b });
+
+			const VkOffset3D next{ std::max(size.x / 2, 1), std::max(size.y / 2, 1), 1 };
+			VkImageBlit blit{};
+			blit.srcSubresource = { range.aspectMask, level - 1, range.baseArrayLayer, range.layerCount };
+			blit.srcOffsets[1] = size;
+			blit.dstSubresource = { range.aspectMask, level, range.baseArrayLayer, range.layerCount };
+			blit.dstOffsets[1] = next;
+			vkCmdBlitImage(cmd, upload.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, upload.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+				1, &blit, VK_FILTER_LINEAR);
+			size = next;
+		}
+
+		// copied levels above the last one were never read, the ones read from are in TRANSFER_SRC_OPTIMAL, the last was only written
+		std::vector<VkImageMemoryBarrier2> done;
+		auto toFinal = [&done, &b, &upload](uint32_t first, uint32_t count, VkImageLayout layout) {
+			if (count == 0)
+				return;
+			b.srcStageMask = VK_PIPELINE_STAGE_2_COPY_BIT | VK_PIPELINE_STAGE_2_BLIT_BIT;
+			b.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+			b.dstStageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+			b.dstAccessMask = VK_ACCESS_2_SHADER_READ_BIT;
+			b.oldLayout = layout;
+			b.newLayout = upload.finalLayout;
+			b.subresourceRange.baseMipLevel = first;
+			b.subresourceRange.levelCount = count;
+			done.push_back(b);
+		};
+		toFinal(range.baseMipLevel, copied - 1 - range.baseMipLevel, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+		toFinal(copied - 1, last - (copied - 1), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+		toFinal(last, 1, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+		Barrier(cmd, done);
+	}
+
+	void Submit(VkQueue queue, VkCommandBuffer cmd, VkSemaphore wait, uint64_t waitValue, VkSemaphore signal, uint64_t signalValue)
+	{
+		VkTimelineSemaphoreSubmitInfo timelineInfo{};
+		timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+		timelineInfo.waitSemaphoreValueCount = wait ? 1 : 0;
+		timelineInfo.pWaitSemaphoreValues = &waitValue;
+		timelineInfo.signalSemaphoreValueCount = 1;
+		timelineInfo.pSignalSemaphoreValues = &signalValue;
+
+		const VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+		VkSubmitInfo si{};
+		si.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		si.pNext = &timelineInfo;
+		si.waitSemaphoreCount = wait ? 1 : 0;
+		si.pWaitSemaphores = &wait;
+		si.pWaitDstStageMask = &waitStage;
+		si.commandBufferCount = 1;
+		si.pCommandBuffers = &cmd;
+		si.signalSemaphoreCount = 1;
+		si.pSignalSemaphores = &signal;
+		VK_CHK(vkQueueSubmit(queue, 1, &si, VK_NULL_HANDLE));
+	}
+}
+
+namespace oGFX
+{
+
+void UploadTimeline::OnComplete(std::function<void()> fn)
+{
+	m_recording.push_back(std::move(fn));
+}
+
+uint64_t UploadTimeline::Close()
+{
+	++m_submitted;
+	m_inFlight.push_back(Batch{ m_submitted, std::move(m_recording) });
+	m_recording.clear();
+	return m_submitted;
+}
+
+std::vector<std::function<void()>> UploadTimeline::Retire(uint64_t completed)
+{
+	std::vector<std::function<void()>> result;
+	while (m_inFlight.empty() == false && m_inFlight.front().value <= completed)
+	{
+		Batch& batch = m_inFlight.front();
+		m_retired = batch.value;
+		for (auto& fn : batch.callbacks)
+		{
+			result.push_back(std::move(fn));
+		}
+		m_inFlight.pop_front();
+	}
+	return result;
+}
+
+void TextureUploader::Init(VkDevice device, VmaAllocator allocator,
+	VkQueue graphicsQueue, uint32_t graphicsFamily,
+	VkQueue transferQueue, uint32_t transferFamily)
+{
+	OO_ASSERT(device && allocator && graphicsQueue && transferQueue);
+	m_device = device;
+	m_allocator = allocator;
+	m_graphicsQueue = graphicsQueue;
+	m_graphicsFamily = graphicsFamily;
+	m_transferQueue = transferQueue;
+	m_transferFamily = transferFamily;
+
+	m_graphicsPool = CreatePool(m_device, m_graphicsFamily);
+	VK_NAME(m_device, "TextureUploader::graphicsPool", m_graphicsPool);
+	if (m_transferFamily != m_graphicsFamily)
+	{
+		m_transferPool = CreatePool(m_device, m_transferFamily);
+		VK_NAME(m_device, "TextureUploader::transferPool", m_transferPool);
+		m_transferDone = CreateTimelineSemaphore(m_device);
+		VK_NAME(m_device, "TextureUploader::transferDone", m_transferDone);
+	}
+	m_uploadDone = CreateTimelineSemaphore(m_device);
+	VK_NAME(m_device, "TextureUploader::uploadDone", m_uploadDone);
+
+	m_timeline = UploadTimeline{};
+	m_stats = {};
+	m_stats.dedicatedTransferQueue = m_transferFamily != m_graphicsFamily;
+}
+
+void TextureUploader::Destroy()
+{
+	if (m_device == VK_NULL_HANDLE)
+		return;
+
+	// whoever the callbacks were for is shutting down, only the resources are cleaned up
+	if (m_inFlight.empty() == false)
+	{
+		const uint64_t last = m_inFlight.back().value;
+		VkSemaphoreWaitInfo waitInfo{};
+		waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+		waitInfo.semaphoreCount = 1;
+		waitInfo.pSemaphores = &m_uploadDone;
+		waitInfo.pValues = &last;
+		VK_CHK(vkWaitSemaphores(m_device, &waitInfo, UINT64_MAX));
+	}
+	for (Batch& batch : m_inFlight)
+	{
+		Release(batch);
+	}
+	m_inFlight.clear();
+	for (Pending& p : m_pending)
+	{
+		vmaDestroyBuffer(m_allocator, p.staging.buffer, p.staging.alloc);
+	}
+	m_pending.clear();
+	m_timeline = UploadTimeline{};
+
+	vkDestroyCommandPool(m_device, m_graphicsPool, nullptr);
+	vkDestroyCommandPool(m_device, m_transferPool, nullptr);
+	vkDestroySemaphore(m_device, m_transferDone, nullptr);
+	vkDestroySemaphore(m_device, m_uploadDone, nullptr);
+	m_graphicsPool = m_transferPool = VK_NULL_HANDLE;
+	m_transferDone = m_uploadDone = VK_NULL_HANDLE;
+	m_device = VK_NULL_HANDLE;
+}
+
+uint64_t TextureUploader::Enqueue(const Upload& upload, const void* data, VkDeviceSize size, std::function<void()> onComplete)
+{
+	return Enqueue(upload, Stage(data, size), std::move(onComplete));
+}
+
+TextureUploader::Staging TextureUploader::Stage(const void* data, VkDeviceSize size)
+{
+	PROFILE_SCOPED();
+	OO_ASSERT(data && size);
+
+	Staging staging;
+	staging.size = size;
+	CreateBuffer(m_allocator, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+		VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT, staging.buffer);
+	memcpy(staging.buffer.allocInfo.pMappedData, data, size);
+	VK_CHK(vmaFlushAllocation(m_allocator, staging.buffer.alloc, 0, size));
+	return staging;
+}
+
+uint64_t TextureUploader::Enqueue(const Upload& upload, const Staging& staging, std::function<void()> onComplete)
+{
+	OO_ASSERT(upload.image && upload.regions.empty() == false && staging.buffer.buffer && staging.size);
+
+	Pending pending;
+	pending.upload = upload;
+	pending.staging = staging.buffer;
+
+	std::scoped_lock lock(m_mutex);
+	if (onComplete)
+	{
+		m_timeline.OnComplete(std::move(onComplete));
+	}
+	m_pending.push_back(std::move(pending));
+	++m_stats.textures;
+	m_stats.bytes += staging.size;
+	return m_timeline.RecordingValue();
+}
+
+VkCommandBuffer TextureUploader::BeginCommands(VkCommandPool pool)
+{
+	VkCommandBufferAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	allocInfo.commandPool = pool;
+	allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	allocInfo.commandBufferCount = 1;
+	VkCommandBuffer cmd{ VK_NULL_HANDLE };
+	VK_CHK(vkAllocateCommandBuffers(m_device, &allocInfo, &cmd));
+
+	VkCommandBufferBeginInfo beginInfo{};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	VK_CHK(vkBeginCommandBuffer(cmd, &beginInfo));
+	return cmd;
+}
+
+void TextureUploader::Flush()
+{
+	PROFILE_SCOPED();
+
+	std::vector<Pending> pending;
+	Batch batch;
+	{
+		std::scoped_lock lock(m_mutex);
+		if (m_pending.empty())
+			return;
+		pending.swap(m_pending);
+		batch.value = m_timeline.Close();
+		++m_stats.batches;
+		m_stats.peakBatchTextures = std::max(m_stats.peakBatchTextures, static_cast<uint32_t>(pending.size()));
+	}
+
+	const bool shared = m_transferFamily == m_graphicsFamily;
+	VkCommandBuffer copyCmd = BeginCommands(shared ? m_graphicsPool : m_transferPool);
+
+	std::vector<VkImageMemoryBarrier2> barriers(pending.size());
+	for (size_t i = 0; i < pending.size(); i++)
+	{
+		VkImageMemoryBarrier2& b = barriers[i];
+		b = VkImageMemoryBarrier2{ VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2 };
+		b.srcStageMask = VK_PIPELINE_STAGE_2_NONE;
+		b.srcAccessMask = VK_ACCESS_2_NONE;
+		b.dstStageMask = VK_PIPELINE_STAGE_2_COPY_BIT;
+		b.dstAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+		b.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		b.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		b.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		b.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		b.image = pending[i].upload.image;
+		b.subresourceRange = pending[i].upload.range;
+	}
+	Barrier(copyCmd, barriers);
+
+	for (const Pending& p : pending)
+	{
+		vkCmdCopyBufferToImage(copyCmd, p.staging.buffer, p.upload.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			static_cast<uint32_t>(p.upload.regions.size()), p.upload.regions.data());
+		batch.staging.push_back(p.staging);
+	}
+
+	// on a queue of its own this is the release half of the ownership transfer, the graphics queue acquires below.
+	// Images with mips to blit stay in TRANSFER_DST_OPTIMAL for the graphics queue to fill them in
+	for (size_t i = 0; i < pending.size(); i++)
+	{
+		const bool blits = BlitsMips(pending[i].upload);
+		VkImageMemoryBarrier2& b = barriers[i];
+		b.srcStageMask = VK_PIPELINE_STAGE_2_COPY_BIT;
+		b.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+		b.dstStageMask = shared == false ? VK_PIPELINE_STAGE_2_NONE : blits ? VK_PIPELINE_STAGE_2_BLIT_BIT : VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+		b.dstAccessMask = shared == false ? VK_ACCESS_2_NONE : blits ? VK_ACCESS_2_TRANSFER_READ_BIT | VK_ACCESS_2_TRANSFER_WRITE_BIT : VK_ACCESS_2_SHADER_READ_BIT;
+		b.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		b.newLayout = blits ? VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL : pending[i].upload.finalLayout;
+		b.srcQueueFamilyIndex = shared ? VK_QUEUE_FAMILY_IGNORED : m_transferFamily;
+		b.dstQueueFamilyIndex = shared ? VK_QUEUE_FAMILY_IGNORED : m_graphicsFamily;
+	}
+	Barrier(copyCmd, barriers);
+
+	VkCommandBuffer graphicsCmd = copyCmd;
+	if (shared == false)
+	{
+		VK_CHK(vkEndCommandBuffer(copyCmd));
+		batch.transferCmd = copyCmd;
+		Submit(m_transferQueue, copyCmd, VK_NULL_HANDLE, 0, m_transferDone, batch.value);
+
+		graphicsCmd = BeginCommands(m_graphicsPool);
+		for (size_t i = 0; i < pending.size(); i++)
+		{
+			const bool blits = BlitsMips(pending[i].upload);
+			VkImageMemoryBarrier2& b = barriers[i];
+			b.srcStageMask = VK_PIPELINE_STAGE_2_NONE;
+			b.srcAccessMask = VK_ACCESS_2_NONE;
+			b.dstStageMask = blits ? VK_PIPELINE_STAGE_2_BLIT_BIT : VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+			b.dstAccessMask = blits ? VK_ACCESS_2_TRANSFER_READ_BIT | VK_ACCESS_2_TRANSFER_WRITE_BIT : VK_ACCESS_2_SHADER_READ_BIT;
+		}
+		Barrier(graphicsCmd, barriers);
+	}
+
+	// blits need the graphics queue, every texture's mips go in with the batch instead of a submission and wait each
+	for (const Pending& p : pending)
+	{
+		if (BlitsMips(p.upload))
+		{
+			BlitMips(graphicsCmd, p.upload);
+		}
+	}
+	VK_CHK(vkEndCommandBuffer(graphicsCmd));
+	batch.graphicsCmd = graphicsCmd;
+	Submit(m_graphicsQueue, graphicsCmd, shared ? VK_NULL_HANDLE : m_transferDone, batch.value, m_uploadDone, batch.value);
+
+	m_inFlight.push_back(std::move(batch));
+}
+
+void TextureUploader::Update(bool waitAll)
+{
+	PROFILE_SCOPED();
+
+	Flush();
+	if (m_inFlight.empty())
+		return;
+
+	if (waitAll)
+	{
+		const uint64_t last = m_inFlight.back().value;
+		VkSemaphoreWaitInfo waitInfo{};
+		waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+		waitInfo.semaphoreCount = 1;
+		waitInfo.pSemaphores = &m_uploadDone;
+		waitInfo.pValues = &last;
+		VK_CHK(vkWaitSemaphores(m_device, &waitInfo, UINT64_MAX));
+	}
+
+	uint64_t completed{};
+	VK_CHK(vkGetSemaphoreCounterValue(m_device, m_uploadDone, &completed));
+	while (m_inFlight.empty() == false && m_inFlight.front().value <= completed)
+	{
+		Release(m_inFlight.front());
+		m_inFlight.pop_front();
+	}
+
+	std::vector<std::function<void()>> callbacks;
+	{
+		std::scoped_lock lock(m_mutex);
+		callbacks = m_timeline.Retire(completed);
+	}
+	// outside the lock, the callbacks are free to queue more uploads
+	for (auto& fn : callbacks)
+	{
+		fn();
+	}
+}
+
+bool TextureUploader::IsComplete(uint64_t value) const
+{
+	uint64_t completed{};
+	VK_CHK(vkGetSemaphoreCounterValue(m_device, m_uploadDone, &completed));
+	return completed >= value;
+}
+
+TextureUploader::Stats TextureUploader::GetStats() const
+{
+	std::scoped_lock lock(m_mutex);
+	return m_stats;
+}
+
+void TextureUploader::Release(Batch& batch)
+{
+	for (AllocatedBuffer& staging : batch.staging)
+	{
+		vmaDestroyBuffer(m_allocator, staging.buffer, staging.alloc);
+	}
+	batch.staging.clear();
+	if (batch.transferCmd)
+	{
+		vkFreeCommandBuffers(m_device, m_transferPool, 1, &batch.transferCmd);
+	}
+	if (batch.graphicsCmd)
+	{
+		vkFreeCommandBuffers(m_device, m_graphicsPool, 1, &batch.graphicsCmd);
+	}
+	batch.transferCmd = batch.graphicsCmd = VK_NULL_HANDLE;
+}
+
+}
@@ -0,0 +1,152 @@
+/************************************************************************************//*!
+\file           TextureUploader.h
+\project        Ouroboros
+\author         Jamie Kong, j.kong, 390004720 | code contribution (100%)
+\par            email: j.kong\@digipen.edu
+\date           May 27, 2024
+\brief              Declares the batched texture upload service, copies run on the transfer queue
+when the device has one and completion is tracked with timeline semaphores
+
+Copyright (C) 2022 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents
+without the prior written consent of DigiPen Institute of
+Technology is prohibited.
+*//*************************************************************************************/
+#pragma once
+#include "vulkan/vulkan.h"
+#include "VmaUsage.h"
+#include "VulkanUtils.h"
+
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace oGFX
+{
+
+// CPU side bookkeeping of the batches, timeline values and callbacks only so it can be tested without a device
+class UploadTimeline
+{
+public:
+	// Runs once the batch being recorded has completed
+	void OnComplete(std::function<void()> fn);
+
+	// Value the batch being recorded signals
+	uint64_t RecordingValue() const { return m_submitted + 1; }
+
+	// Closes the batch being recorded, its submission has to signal the returned value
+	uint64_t Close();
+
+	// Callbacks of every closed batch the semaphore has reached, oldest first
+	std::vector<std::function<void()>> Retire(uint64_t completed);
+
+	uint64_t Submitted() const { return m_submitted; }
+	uint64_t Retired() const { return m_retired; }
+	size_t BatchesInFlight() const { return m_inFlight.size(); }
+
+private:
+	struct Batch
+	{
+		uint64_t value{};
+		std::vector<std::function<void()>> callbacks;
+	};
+	std::vector<std::function<void()>> m_recording;
+	std::deque<Batch> m_inFlight;
+	uint64_t m_submitted{};
+	uint64_t m_retired{};
+};
+
+class TextureUploader
+{
+public:
+	struct Upload
+	{
+		VkImage image{ VK_NULL_HANDLE };
+		VkImageSubresourceRange range{};
+		VkImageLayout finalLayout{ VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+		std::vector<VkBufferImageCopy> regions;	// offsets into the data handed to Enqueue
+		// The levels of range the regions leave out are blitted down from the last copied one on the graphics queue,
+		// in the same batch. The format needs blits with linear filtering.
+		bool generateMips{ false };
+	};
+
+	// Upload memory holding the pixels of one texture, filled before the image exists
+	struct Staging
+	{
+		AllocatedBuffer buffer{};
+		VkDeviceSize size{};
+	};
+
+	struct Stats
+	{
+		uint64_t batches{};
+		uint64_t textures{};
+		uint64_t bytes{};
+		uint32_t peakBatchTextures{};
+		bool dedicatedTransferQueue{};
+	};
+
+	// With the same family for both queues the uploads share the graphics queue and need no ownership transfer
+	void Init(VkDevice device, VmaAllocator allocator,
+		VkQueue graphicsQueue, uint32_t graphicsFamily,
+		VkQueue transferQueue, uint32_t transferFamily);
+	void Destroy();
+
+	// Stages the data and queues the copy into the next batch, safe to call from any thread.
+	// The image is undefined until onComplete runs, returns the value of the batch it went into.
+	uint64_t Enqueue(const Upload& upload, const void* data, VkDeviceSize size, std::function<void()> onComplete = {});
+
+	// Copies the data into upload memory, safe to call from any thread. The loading threads stage their pixels
+	// so they can be freed right away and the render thread only records the copy.
+	Staging Stage(const void* data, VkDeviceSize size);
+	// Queues the copy from memory staged earlier, the uploader takes the staging over
+	uint64_t Enqueue(const Upload& upload, const Staging& staging, std::function<void()> onComplete = {});
+
+	// Submits everything queued so far as one batch. Only the thread that submits to the graphics queue may call it.
+	void Flush();
+
+	// Flushes, then frees the batches that completed and runs their callbacks. Call once a frame from the render thread.
+	void Update(bool waitAll = false);
+
+	bool IsComplete(uint64_t value) const;
+	Stats GetStats() const;
+
+private:
+	struct Pending
+	{
+		Upload upload;
+		AllocatedBuffer staging{};
+	};
+	struct Batch
+	{
+		uint64_t value{};
+		std::vector<AllocatedBuffer> staging;
+		VkCommandBuffer transferCmd{ VK_NULL_HANDLE };
+		VkCommandBuffer graphicsCmd{ VK_NULL_HANDLE };
+	};
+
+	VkCommandBuffer BeginCommands(VkCommandPool pool);
+	void Release(Batch& batch);
+
+	VkDevice m_device{ VK_NULL_HANDLE };
+	VmaAllocator m_allocator{};
+	VkQueue m_graphicsQueue{ VK_NULL_HANDLE };
+	VkQueue m_transferQueue{ VK_NULL_HANDLE };
+	uint32_t m_graphicsFamily{};
+	uint32_t m_transferFamily{};
+
+	VkCommandPool m_graphicsPool{ VK_NULL_HANDLE };
+	VkCommandPool m_transferPool{ VK_NULL_HANDLE };
+	// the transfer queue signals its half of a batch on the first, the graphics queue the whole batch on the second
+	VkSemaphore m_transferDone{ VK_NULL_HANDLE };
+	VkSemaphore m_uploadDone{ VK_NULL_HANDLE };
+
+	std::vector<Pending> m_pending;
+	std::deque<Batch> m_inFlight;
+	UploadTimeline m_timeline;
+	Stats m_stats{};
+	mutable std::mutex m_mutex;
+};
+
+}
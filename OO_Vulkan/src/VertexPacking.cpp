@@ -0,0 +1,174 @@
+/************************************************************************************//*!
+\file           VertexPacking.cpp
+\project        Ouroboros
+\author         Jamie Kong, j.kong, 390004720 | code contribution (100%)
+\par            email: j.kong\@digipen.edu
+\date           May 22, 2024
+\brief              Defines the packed vertex encode and decode, quantized positions, octahedral normals, half UVs
+
+Copyright (C) 2022 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents
+without the prior written consent of DigiPen Institute of
+Technology is prohibited.
+*//*************************************************************************************/
+#include "VertexPacking.h"
+
+#include <glm/gtc/packing.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+	glm::vec2 OctWrap(const glm::vec2& v)
+	{
+		return glm::vec2{ (1.0f - std::abs(v.y)) * (v.x >= 0.0f ? 1.0f : -1.0f),
+			(1.0f - std::abs(v.x)) * (v.y >= 0.0f ? 1.0f : -1.0f) };
+	}
+}
+
+namespace oGFX::VertexPacking
+{
+	glm::vec4 ComputePositionDequant(const Vertex* vertices, size_t count)
+	{
+		if (count == 0)
+			return glm::vec4{ 0.0f, 0.0f, 0.0f, 1.0f };
+
+		glm::vec3 lo{ vertices[0].pos };
+		glm::vec3 hi{ vertices[0].pos };
+		for (size_t i = 1; i < count; i++)
+		{
+			lo = glm::min(lo, vertices[i].pos);
+			hi = glm::max(hi, vertices[i].pos);
+		}
+		const glm::vec3 extent = hi - lo;
+		const float scale = std::max({ extent.x, extent.y, extent.z });
+		return glm::vec4{ lo, scale > 0.0f ? scale : 1.0f };
+	}
+
+	uint16_t QuantizeUnorm16(float v)
+	{
+		return static_cast<uint16_t>(std::lround(std::clamp(v, 0.0f, 1.0f) * 65535.0f));
+	}
+
+	int16_t QuantizeSnorm16(float v)
+	{
+		return static_cast<int16_t>(std::lround(std::clamp(v, -1.0f, 1.0f) * 32767.0f));
+	}
+
+	float DequantizeUnorm16(uint16_t q)
+	{
+		return q / 65535.0f;
+	}
+
+	float DequantizeSnorm16(int16_t q)
+	{
+		// -32768 and -32767 are both -1, the same as VK_FORMAT_R16G16_SNORM
+		return std::max(q / 32767.0f, -1.0f);
+	}
+
+	void OctEncode(const glm::vec3& n, int16_t out[2])
+	{
+		const float l1 = std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+		if (l1 == 0.0f)
+		{
+			out[0] = out[1] = 0;
+			return;
+		}
+		glm::vec2 p = glm::vec2{ n.x, n.y } / l1;
+		if (n.z < 0.0f)
+			p = OctWrap(p);
+
+		// rounding each component on its own is not the closest direction, try the four around it
+		// in double, float dot products cannot tell directions this close apart
+		const glm::dvec3 target = glm::normalize(glm::dvec3{ n });
+		const float fx = std::floor(std::clamp(p.x, -1.0f, 1.0f) * 32767.0f);
+		const float fy = std::floor(std::clamp(p.y, -1.0f, 1.0f) * 32767.0f);
+		double best = std::numeric_limits<double>::max();
+		for (int i = 0; i < 4; i++)
+		{
+			const int16_t candidate[2]{
+				static_cast<int16_t>(std::clamp(fx + (i & 1), -32767.0f, 32767.0f)),
+				static_cast<int16_t>(std::clamp(fy + (i >> 1), -32767.0f, 32767.0f)) };
+			const double d = glm::length(glm::dvec3{ OctDecode(candidate) } - target);
+			if (d < best)
+			{
+				best = d;
+				out[0] = candidate[0];
+				out[1] = candidate[1];
+			}
+		}
+	}
+
+	glm::vec3 OctDecode(const int16_t in[2])
+	{
+		const glm::vec2 p{ DequantizeSnorm16(in[0]), DequantizeSnorm16(in[1]) };
+		glm::vec3 n{ p.x, p.y, 1.0f - std::abs(p.x) - std::abs(p.y) };
+		if (n.z < 0.0f)
+		{
+			const glm::vec2 w = OctWrap(p);
+			n.x = w.x;
+			n.y = w.y;
+		}
+		return glm::normalize(n);
+	}
+
+	PackedVertex Pack(const Vertex& vertex, const glm::vec4& dequant)
+	{
+		PackedVertex packed;
+		const glm::vec3 unit = (vertex.pos - glm::vec3{ dequant }) / dequant.w;
+		packed.pos[0] = QuantizeUnorm16(unit.x);
+		packed.pos[1] = QuantizeUnorm16(unit.y);
+		packed.pos[2] = QuantizeUnorm16(unit.z);
+		OctEncode(vertex.norm, packed.norm);
+		OctEncode(vertex.tangent, packed.tangent);
+		packed.tex[0] = static_cast<uint16_t>(glm::packHalf1x16(vertex.tex.x));
+		packed.tex[1] = static_cast<uint16_t>(glm::packHalf1x16(vertex.tex.y));
+		return packed;
+	}
+
+	Vertex Unpack(const PackedVertex& packed, const glm::vec4& dequant)
+	{
+		Vertex vertex;
+		const glm::vec3 unit{ DequantizeUnorm16(packed.pos[0]), DequantizeUnorm16(packed.pos[1]), DequantizeUnorm16(packed.pos[2]) };
+		vertex.pos = glm::vec3{ dequant } + unit * dequant.w;
+		vertex.norm = OctDecode(packed.norm);
+		vertex.tangent = OctDecode(packed.tangent);
+		vertex.tex = glm::vec2{ glm::unpackHalf1x16(packed.tex[0]), glm::unpackHalf1x16(packed.tex[1]) };
+		return vertex;
+	}
+
+	void Pack(const Vertex* vertices, size_t count, const glm::vec4& dequant, PackedVertex* out)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			out[i] = Pack(vertices[i], dequant);
+		}
+	}
+
+	float PositionErrorBound(const glm::vec4& dequant)
+	{
+		// half a step, and a little for the float math on both sides
+		const float magnitude = std::max({ std::abs(dequant.x), std::abs(dequant.y), std::abs(dequant.z) }) + dequant.w;
+		return 0.5f * dequant.w / 65535.0f + magnitude * 4.0f * std::numeric_limits<float>::epsilon();
+	}
+
+	float TexCoordErrorBound(float texCoord)
+	{
+		// 11 significant bits, half of the last one, under 2^-14 the step is the subnormal one
+		return std::max(std::abs(texCoord) * 0x1p-11f, 0x1p-25f);
+	}
+
+	void MemoryReport::Add(const Vertex* vertices, size_t count)
+	{
+		++models;
+		this->vertices += count;
+		unpackedBytes += count * sizeof(Vertex);
+		packedBytes += count * sizeof(PackedVertex);
+
+		const glm::vec3 defaultColour = Vertex{}.col;
+		if (std::any_of(vertices, vertices + count, [&](const Vertex& v) { return v.col != defaultColour; }))
+			++modelsWithColour;
+	}
+}
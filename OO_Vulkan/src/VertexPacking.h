@@ -0,0 +1,75 @@
+/************************************************************************************//*!
+\file           VertexPacking.h
+\project        Ouroboros
+\author         Jamie Kong, j.kong, 390004720 | code contribution (100%)
+\par            email: j.kong\@digipen.edu
+\date           May 22, 2024
+\brief              Declares the packed vertex layout of the global vertex buffer and its CPU encode and decode
+
+Copyright (C) 2022 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents
+without the prior written consent of DigiPen Institute of
+Technology is prohibited.
+*//*************************************************************************************/
+#pragma once
+
+#include "VulkanUtils.h"
+
+#include <cstdint>
+#include <cstddef>
+
+namespace oGFX
+{
+	// 20 bytes instead of the 56 of Vertex. Decoded in vertex_input.shader, the colour is not kept,
+	// gbuffer.frag takes the albedo from the texture.
+	struct PackedVertex
+	{
+		uint16_t pos[4]{};		// unorm16 in the model's bounds, w is padding
+		int16_t norm[2]{};		// octahedral snorm16
+		int16_t tangent[2]{};	// octahedral snorm16
+		uint16_t tex[2]{};		// half
+	};
+	static_assert(sizeof(PackedVertex) == 20);
+
+#if PACKED_VERTEX_FORMAT
+	using GpuVertex = PackedVertex;
+#else
+	using GpuVertex = Vertex;
+#endif
+}
+
+namespace oGFX::VertexPacking
+{
+	// xyz is the low corner of the bounds and w the longest side.
+	// One scale for every axis leaves the normal transform as it is.
+	glm::vec4 ComputePositionDequant(const Vertex* vertices, size_t count);
+
+	uint16_t QuantizeUnorm16(float v);
+	int16_t QuantizeSnorm16(float v);
+	float DequantizeUnorm16(uint16_t q);
+	float DequantizeSnorm16(int16_t q);
+
+	// Unit vector to the octahedron unfolded on [-1,1]^2, the snorm16 neighbour closest to the input is picked
+	void OctEncode(const glm::vec3& n, int16_t out[2]);
+	glm::vec3 OctDecode(const int16_t in[2]);
+
+	PackedVertex Pack(const Vertex& vertex, const glm::vec4& dequant);
+	Vertex Unpack(const PackedVertex& packed, const glm::vec4& dequant);
+	void Pack(const Vertex* vertices, size_t count, const glm::vec4& dequant, PackedVertex* out);
+
+	// Largest error the round trip is allowed
+	float PositionErrorBound(const glm::vec4& dequant);
+	constexpr float DIRECTION_ERROR_DEGREES = 0.005f;
+	float TexCoordErrorBound(float texCoord);
+
+	struct MemoryReport
+	{
+		size_t models{};
+		size_t vertices{};
+		size_t unpackedBytes{};
+		size_t packedBytes{};
+		size_t modelsWithColour{};	// colours that the packed layout drops
+
+		void Add(const Vertex* vertices, size_t count);
+	};
+}
@@ -42,6 +42,9 @@ VulkanDevice::~VulkanDevice()
         //}
     }
 
+    stagingRing.Destroy();
+    textureUploader.Destroy();
+
     if (m_allocator)
     {
         vmaDestroyAllocator(m_allocator);
@@ -248,6 +251,7 @@ void VulkanDevice::InitLogicalDevice(const oGFX::SetupInfo& si,VulkanInstance& i
     // So we want to handle the queues
     // From given logical device of given queue family of given index, place reference in VKqueue
     vkGetDeviceQueue(logicalDevice, indices.graphicsFamily, 0, &graphicsQueue);
+    vkGetDeviceQueue(logicalDevice, indices.transferFamily, 0, &transferQueue);
 
     VkCommandPoolCreateInfo poolInfo = {};
     poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
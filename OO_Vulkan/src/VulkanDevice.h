@@ -17,6 +17,8 @@ Technology is prohibited.
 #include "VulkanUtils.h"
 #include "VulkanBuffer.h"
 #include "CommandBufferManager.h"
+#include "StagingRing.h"
+#include "TextureUploader.h"
 
 #include "VmaUsage.h"
 #include "gpuCommon.h"
@@ -42,12 +44,16 @@ struct VulkanDevice
 	VmaAllocator m_allocator{};
 
 	VkQueue graphicsQueue{VK_NULL_HANDLE};
+	// same as the graphics queue when the device has no other family that can copy
+	VkQueue transferQueue{VK_NULL_HANDLE};
 	oGFX::QueueFamilyIndices queueIndices{};
 
 	VkPhysicalDeviceFeatures2 enabledFeatures{};
 	VkPhysicalDeviceProperties properties{};
 
 	std::vector<oGFX::CommandBufferManager> commandPoolManagers;
+	oGFX::StagingRing stagingRing;
+	oGFX::TextureUploader textureUploader;
 
 	bool CheckDeviceSuitable(const oGFX::SetupInfo& si,VkPhysicalDevice device);
 	bool CheckDeviceExtensionSupport(const oGFX::SetupInfo& si,VkPhysicalDevice device);	
@@ -84,6 +84,8 @@ extern GfxRenderpass* g_DLSSPass;
 #include "Profiling.h"
 #include "DebugDraw.h"
 #include "OctTree.h"
+#include "MeshOptimizer.h"
+#include "CookedModel.h"
 
 #include <vector>
 #include <set>
@@ -93,7 +95,9 @@ extern GfxRenderpass* g_DLSSPass;
 #include <chrono>
 #include <random>
 #include <filesystem>
+#include <bit>
 #include <sstream>
+#include <fstream>
 
 // ordering important
 #include <ft2build.h>
@@ -194,10 +198,31 @@ VulkanRenderer::~VulkanRenderer()
 	if (s)
 	{
 		s << "buffer : " << accumulatedBytes << std::endl;
-		s << "texture : " << totalTextureSizeLoaded << std::endl;
+		s << "texture : " << totalTextureSizeLoaded.load() << std::endl;
+		auto staging = m_device.stagingRing.GetStats();
+		s << "staging ring : " << staging.capacity << " peak : " << staging.peakBytesInFlight
+			<< " wraps : " << staging.wraps << " fallbacks : " << staging.fallbackAllocations << std::endl;
+		auto pipelineBuilds = pipelineMap.GetStats();
+		s << "on demand pipelines : " << pipelineMap.Size() << " built : " << pipelineBuilds.builds << " waited : " << pipelineBuilds.waits << std::endl;
+		auto pipelines = pipelineCache.GetStats();
+		s << "startup : " << startupTimeMs << "ms " << (pipelines.loadedBytes ? "warm" : "cold")
+			<< " last cold : " << coldStartupTimeMs << "ms last warm : " << warmStartupTimeMs << "ms"
+			<< " pipeline cache : " << pipelines.loadedBytes << " manifest : " << pipelines.manifestLoaded << " new : " << pipelines.manifestRecorded
+			<< " spirv reads : " << pipelines.shaderReads << " hits : " << pipelines.shaderHits << std::endl;
+		s << "descriptor sets peak frame : " << peakDescriptorStats.allocated << " reused : " << peakDescriptorStats.cacheHits
+			<< " pools : " << peakDescriptorStats.pools << std::endl;
+		auto uploads = m_device.textureUploader.GetStats();
+		s << "texture uploads : " << uploads.textures << " bytes : " << uploads.bytes << " batches : " << uploads.batches
+			<< " peak batch : " << uploads.peakBatchTextures << (uploads.dedicatedTransferQueue ? " transfer queue" : " graphics queue") << std::endl;
+		auto residency = textureResidency.GetStats();
+		s << "streamed textures : " << residency.streamed << " resident : " << residency.residentBytes << " budget : " << residency.budget
+			<< " loads : " << residency.loads << " evictions : " << residency.evictions << std::endl;
 	}
 	s.close();
 
+	// uploads still in flight are for textures about to go away
+	m_device.textureUploader.Destroy();
+
 	if (g_cubeMap.image.image != VK_NULL_HANDLE) {
 		g_cubeMap.destroy();
 	}
@@ -224,16 +249,20 @@ VulkanRenderer::~VulkanRenderer()
 	}
 
 	RenderPassDatabase::Shutdown();
+	transientPool.Destroy();
 
-	for (auto& kvp : pipelineMap)
-	{
-		vkDestroyPipeline(m_device.logicalDevice, kvp.second, nullptr);
-	}
+	pipelineMap.ForEach([device = m_device.logicalDevice](size_t, VkPipeline pipeline) {
+		vkDestroyPipeline(device, pipeline, nullptr);
+	});
+	pipelineMap.Clear();
 
-	for (auto& kvp : pipelineLayoutMap)
-	{
-		vkDestroyPipelineLayout(m_device.logicalDevice, kvp.second, nullptr);
-	}
+	pipelineLayoutMap.ForEach([device = m_device.logicalDevice](size_t, VkPipelineLayout layout) {
+		vkDestroyPipelineLayout(device, layout, nullptr);
+	});
+	pipelineLayoutMap.Clear();
+
+	pipelineCache.Save();
+	pipelineCache.Destroy();
 
 #if VULKAN_MESSENGER
 	DestroyDebugMessenger();
@@ -247,10 +276,12 @@ VulkanRenderer::~VulkanRenderer()
 
 	gpuTransformBuffer.destroy();
 
-	gpuShadowCasterTransformBuffer.destroy();
 
 	g_GlobalMeshBuffers.IdxBuffer.destroy();
 	g_GlobalMeshBuffers.VtxBuffer.destroy();
+	g_GlobalMeshlets.Meshlets.destroy();
+	g_GlobalMeshlets.Vertices.destroy();
+	g_GlobalMeshlets.Triangles.destroy();
 
 	if (m_imguiInitialized)
 	{
@@ -268,6 +299,11 @@ VulkanRenderer::~VulkanRenderer()
 	{
 		g_globalModels[i].destroy(m_device.logicalDevice);
 	}	
+	// queued after the last frame
+	for (PendingModel& pending : g_pendingModels)
+	{
+		pending.model.destroy(m_device.logicalDevice);
+	}
 	for (size_t i = 0; i < g_Textures.size(); i++)
 	{
 		g_Textures[i].destroy();
@@ -360,6 +396,7 @@ LRESULT CALLBACK KeyboardProc(int nCode, WPARAM wParam, LPARAM lParam) {
 
 bool VulkanRenderer::Init(const oGFX::SetupInfo& setupSpecs, Window& window)
 {
+	const auto initStart = std::chrono::high_resolution_clock::now();
 
 	RegisterThreadMapping();
 	g_taskManager.Init(std::thread::hardware_concurrency()-1);
@@ -411,10 +448,13 @@ bool VulkanRenderer::Init(const oGFX::SetupInfo& setupSpecs, Window& window)
 	CreateUniformBuffers();
 	CreateDefaultDescriptorSetLayout();
 
+	pipelineCache.Init(&m_device, "pipeline_cache.bin", "pipeline_manifest.txt");
+	WarmupPipelines();
+
 	fbCache.Init(m_device.logicalDevice);
+	transientPool.Init(&m_device);
 	gpuTransformBuffer.Init(&m_device, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, "gpuTransformBuffer");
 
-	gpuShadowCasterTransformBuffer.Init(&m_device, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,"gpuShadowTransformBuffer");
 
 	CreateDescriptorSets_GPUScene();
 	CreateDescriptorSets_Lights();
@@ -502,6 +542,29 @@ bool VulkanRenderer::Init(const oGFX::SetupInfo& setupSpecs, Window& window)
 	std::array<VkDevice, 1> logicDevs{ m_device.logicalDevice};
 
 	PROFILE_INIT_VULKAN(logicDevs.data(), physDevs.data(), cmdQueues.data(), cmdFamily.data(), 1, nullptr);
+
+	{
+		PROFILE_SCOPED("Wait for pipeline warmup");
+		g_taskManager.WaitForCounter(pipelineWarmup);
+	}
+	startupTimeMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - initStart).count();
+	{
+		// a run only knows its own startup, the other kind comes from the last run that had it
+		const bool warm = pipelineCache.GetStats().loadedBytes != 0;
+		std::ifstream in("startup_times.txt");
+		in >> coldStartupTimeMs >> warmStartupTimeMs;
+		in.close();
+		(warm ? warmStartupTimeMs : coldStartupTimeMs) = startupTimeMs;
+		std::ofstream("startup_times.txt") << coldStartupTimeMs << " " << warmStartupTimeMs << std::endl;
+
+		std::cout << "[PipelineCache] Renderer init took " << startupTimeMs << "ms " << (warm ? "warm" : "cold") << ", "
+			<< pipelineCache.GetStats().manifestLoaded << " pipelines warmed up";
+		if (coldStartupTimeMs > 0.0f && warmStartupTimeMs > 0.0f)
+		{
+			std::cout << ", cold " << coldStartupTimeMs << "ms against warm " << warmStartupTimeMs << "ms";
+		}
+		std::cout << std::endl;
+	}
 	
 	// by now we should have crashed if not ok
 	//std::cerr << "VulkanRenderer::Init failed: " << e.what() << std::endl;
@@ -514,12 +577,26 @@ bool VulkanRenderer::Init(const oGFX::SetupInfo& setupSpecs, Window& window)
 void VulkanRenderer::ReloadShaders()
 {
 	vkDeviceWaitIdle(m_device.logicalDevice);
+	pipelineCache.ClearShaderCode();
 	
 	CreateDefaultPSO();
 	
 	RenderPassDatabase::ReloadAllShaders();
 }
 
+void VulkanRenderer::WarmupPipelines()
+{
+	PROFILE_SCOPED();
+	// built on the workers while this thread carries on with the passes, Init waits for them at the end
+	std::queue<Task> tasks;
+	for (const PipelineDesc& desc : pipelineCache.GetManifest())
+	{
+		const PipelineDesc* d = &desc;
+		tasks.push(Task([d](void*) { rhi::CommandList::WarmupPipeline(*d); }, nullptr, &pipelineWarmup));
+	}
+	g_taskManager.AddTaskList(tasks);
+}
+
 void VulkanRenderer::CreateInstance(const oGFX::SetupInfo& setupSpecs)
 {
 		m_instance.Init(setupSpecs);
@@ -553,6 +630,11 @@ void VulkanRenderer::CreateLogicalDevice(const oGFX::SetupInfo& setupSpecs)
 void VulkanRenderer::InitVMA(const oGFX::SetupInfo& setupSpecs)
 {
 	m_device.InitAllocator(setupSpecs, m_instance);
+	m_device.stagingRing.Init(&m_device, STAGING_RING_SIZE, MAX_FRAME_DRAWS);
+	m_device.textureUploader.Init(m_device.logicalDevice, m_device.m_allocator,
+		m_device.graphicsQueue, m_device.queueIndices.graphicsFamily,
+		m_device.transferQueue, m_device.queueIndices.transferFamily);
+	textureResidency.Init(TEXTURE_STREAMING_BUDGET, TEXTURE_STREAMING_UPLOAD_PER_FRAME);
 }
 
 void VulkanRenderer::SetupSwapchain()
@@ -692,7 +774,7 @@ void VulkanRenderer::CreateDefaultDescriptorSetLayout()
 	descAllocs.resize(m_swapchain.swapChainImages.size());
 	for (size_t i = 0; i < descAllocs.size(); i++)
 	{
-		descAllocs[i].Init(m_device.logicalDevice);
+		descAllocs[i].Init(m_device.logicalDevice, oGFX::MaxMappedThreads());
 	}
 
 	DescLayoutCache.Init(m_device.logicalDevice);
@@ -1082,7 +1164,7 @@ void VulkanRenderer::CreateDefaultPSO()
 	{
 		vkDestroyPipeline(m_device.logicalDevice, pso_utilFullscreenBlit, nullptr);
 	}
-	VK_CHK(vkCreateGraphicsPipelines(m_device.logicalDevice, VK_NULL_HANDLE, 1, &pipelineCI, nullptr, &pso_utilFullscreenBlit));
+	VK_CHK(vkCreateGraphicsPipelines(m_device.logicalDevice, pipelineCache.Get(), 1, &pipelineCI, nullptr, &pso_utilFullscreenBlit));
 	VK_NAME(m_device.logicalDevice, "pso_blit", pso_utilFullscreenBlit);
 	vkDestroyShaderModule(m_device.logicalDevice, shaderStages[0].module, nullptr); // destroy vert
 	vkDestroyShaderModule(m_device.logicalDevice, shaderStages[1].module, nullptr); // destroy fragment
@@ -1095,7 +1177,7 @@ void VulkanRenderer::CreateDefaultPSO()
 	const char* computeShader = "Shaders/bin/ffx_spd_downsample_pass.glsl.spv";
 	VkComputePipelineCreateInfo computeCI = oGFX::vkutils::inits::computeCreateInfo(PSOLayoutDB::AMDSPDPSOLayout);
 	computeCI.stage = LoadShader(m_device, computeShader, VK_SHADER_STAGE_COMPUTE_BIT);
-	VK_CHK(vkCreateComputePipelines(m_device.logicalDevice, VK_NULL_HANDLE, 1, &computeCI, nullptr, &pso_utilAMDSPD));
+	VK_CHK(vkCreateComputePipelines(m_device.logicalDevice, pipelineCache.Get(), 1, &computeCI, nullptr, &pso_utilAMDSPD));
 	VK_NAME(m_device.logicalDevice, "pso_AMDSPD", pso_utilAMDSPD);
 	vkDestroyShaderModule(m_device.logicalDevice, computeCI.stage.module, nullptr);
 
@@ -1106,7 +1188,7 @@ void VulkanRenderer::CreateDefaultPSO()
 	const char* radianceShader = "Shaders/bin/irradiance.comp.spv";
 	computeCI = oGFX::vkutils::inits::computeCreateInfo(PSOLayoutDB::RadiancePSOLayout);
 	computeCI.stage = LoadShader(m_device, radianceShader, VK_SHADER_STAGE_COMPUTE_BIT);
-	VK_CHK(vkCreateComputePipelines(m_device.logicalDevice, VK_NULL_HANDLE, 1, &computeCI, nullptr, &pso_radiance));
+	VK_CHK(vkCreateComputePipelines(m_device.logicalDevice, pipelineCache.Get(), 1, &computeCI, nullptr, &pso_radiance));
 	VK_NAME(m_device.logicalDevice, "pso_Radiance", pso_radiance);
 	vkDestroyShaderModule(m_device.logicalDevice, computeCI.stage.module, nullptr);
 
@@ -1117,7 +1199,7 @@ void VulkanRenderer::CreateDefaultPSO()
 	const char* prefilterShader = "Shaders/bin/envPrefilter.comp.spv";
 	computeCI = oGFX::vkutils::inits::computeCreateInfo(PSOLayoutDB::prefilterPSOLayout);
 	computeCI.stage = LoadShader(m_device, prefilterShader, VK_SHADER_STAGE_COMPUTE_BIT);
-	VK_CHK(vkCreateComputePipelines(m_device.logicalDevice, VK_NULL_HANDLE, 1, &computeCI, nullptr, &pso_prefilter));
+	VK_CHK(vkCreateComputePipelines(m_device.logicalDevice, pipelineCache.Get(), 1, &computeCI, nullptr, &pso_prefilter));
 	VK_NAME(m_device.logicalDevice, "pso_prefilter", pso_prefilter);
 	vkDestroyShaderModule(m_device.logicalDevice, computeCI.stage.module, nullptr);
 
@@ -1128,7 +1210,7 @@ void VulkanRenderer::CreateDefaultPSO()
 	const char* lutShader = "Shaders/bin/brdfLUT.comp.spv";
 	computeCI = oGFX::vkutils::inits::computeCreateInfo(PSOLayoutDB::BRDFLUTPSOLayout);
 	computeCI.stage = LoadShader(m_device, lutShader, VK_SHADER_STAGE_COMPUTE_BIT);
-	VK_CHK(vkCreateComputePipelines(m_device.logicalDevice, VK_NULL_HANDLE, 1, &computeCI, nullptr, &pso_brdfLUT));
+	VK_CHK(vkCreateComputePipelines(m_device.logicalDevice, pipelineCache.Get(), 1, &computeCI, nullptr, &pso_brdfLUT));
 	VK_NAME(m_device.logicalDevice, "pso_brdfLUT", pso_brdfLUT);
 	vkDestroyShaderModule(m_device.logicalDevice, computeCI.stage.module, nullptr);
 	
@@ -1353,7 +1435,7 @@ void VulkanRenderer::PrepareDLSS()
 
 VkCommandBuffer VulkanRenderer::GetCommandBuffer()
 {
-	uint32_t thread_id = (uint32_t)g_taskManagerMapping[std::this_thread::get_id()];
+	uint32_t thread_id = GetThreadMapping();
 	constexpr bool beginBuffer = true;
 	VkCommandBuffer result = m_device.commandPoolManagers[getFrame()].GetNextCommandBuffer(thread_id,beginBuffer);
 	VK_NAME(m_device.logicalDevice, "DEFAULTCMD", result);
@@ -1623,6 +1705,7 @@ void VulkanRenderer::UploadLights()
 	PROFILE_GPU_EVENT("Upload Light");
 	VK_NAME(m_device.logicalDevice, "Upload Light", cmd);
 	globalLightBuffer.writeToCmd(spotLights.size(), spotLights.data(), cmd);
+	shadowTileBuffer.writeToCmd(batches.m_shadowTileRects.size(), batches.m_shadowTileRects.data(), cmd);
 
 }
 
@@ -2148,7 +2231,7 @@ void VulkanRenderer::PerformImguiRestart()
 	init_info.Device = m_device.logicalDevice;
 	init_info.QueueFamily = m_device.queueIndices.graphicsFamily;
 	init_info.Queue = m_device.graphicsQueue;
-	init_info.PipelineCache = VK_NULL_HANDLE;
+	init_info.PipelineCache = pipelineCache.Get();
 	init_info.DescriptorPool = m_imguiConfig.descriptorPools;
 	init_info.Allocator = nullptr;
 	init_info.MinImageCount = m_swapchain.minImageCount+1;
@@ -2186,7 +2269,6 @@ void VulkanRenderer::InitializeRenderBuffers()
 	shadowCasterInstanceBuffer.Init(&m_device, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, "shadowCasterInstanceBuffer");
 
 	objectInformationBuffer.Init(&m_device, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, "Object infoBuffer");
-	casterObjectInformationBuffer.Init(&m_device, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, "Caster Object infoBuffer");
 	//objectInformationBuffer.reserve(MAX_OBJECTS);  
 
 	constexpr uint32_t MAX_LIGHTS = 512;
@@ -2195,6 +2277,7 @@ void VulkanRenderer::InitializeRenderBuffers()
 
 	globalLightBuffer.Init(&m_device, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, "Light Buffer");
 	//globalLightBuffer.reserve(MAX_LIGHTS);
+	shadowTileBuffer.Init(&m_device, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, "Shadow Tile Buffer");
 
 	constexpr uint32_t MAX_GLOBAL_BONES = 2048;
 	constexpr uint32_t MAX_SKINNING_VERTEX_BUFFER_SIZE = 4 * 1024 * 1024; // 4MB
@@ -2213,6 +2296,9 @@ void VulkanRenderer::InitializeRenderBuffers()
 
 	g_GlobalMeshBuffers.IdxBuffer.Init(&m_device, VK_BUFFER_USAGE_INDEX_BUFFER_BIT,"IdxBuffer");
 	g_GlobalMeshBuffers.VtxBuffer.Init(&m_device, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,"VtxBuffer");
+	g_GlobalMeshlets.Meshlets.Init(&m_device, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,"Meshlets");
+	g_GlobalMeshlets.Vertices.Init(&m_device, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,"MeshletVertices");
+	g_GlobalMeshlets.Triangles.Init(&m_device, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,"MeshletTriangles");
 	//g_GlobalMeshBuffers.IdxBuffer.reserve(8 * 1000 * 1000);
 	//g_GlobalMeshBuffers.VtxBuffer.reserve(1 * 1000 * 1000);
 
@@ -2254,8 +2340,8 @@ void VulkanRenderer::DestroyRenderBuffers()
 	instanceBuffer.destroy();
 	shadowCasterInstanceBuffer.destroy();
 	objectInformationBuffer.destroy();
-	casterObjectInformationBuffer.destroy();
 	globalLightBuffer.destroy();
+	shadowTileBuffer.destroy();
 	gpuBoneMatrixBuffer.destroy();
 	g_UIVertexBufferGPU.destroy();
 	g_UIIndexBufferGPU.destroy();
@@ -2320,17 +2406,8 @@ void VulkanRenderer::GenerateCPUIndirectDrawCommands()
 		PROFILE_GPU_CONTEXT(cmd);
 		PROFILE_GPU_EVENT("Upload Indirect");
 		VK_NAME(m_device.logicalDevice, "Upload Indirect", cmd);
+		// the render graph makes the first pass reading it wait on this upload
 		indirectCommandsBuffer.writeToCmd(allObjectsCommands.size(), allObjectsCommands.data(),cmd);
-		VkAccessFlags srcAccess = VK_ACCESS_MEMORY_WRITE_BIT;
-		VkAccessFlags dstAccess = VK_ACCESS_MEMORY_READ_BIT;
-
-		VkPipelineStageFlags prevStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-		VkPipelineStageFlags nextStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-
-		// Make sure next stage can read this values once transfer is done
-		oGFX::vkutils::tools::insertBufferMemoryBarrier(cmd, m_device.queueIndices.graphicsFamily,
-			indirectCommandsBuffer.getBuffer(), srcAccess, dstAccess,
-			prevStage, nextStage);
 	}
 
 	// shadow commands
@@ -2343,17 +2420,6 @@ void VulkanRenderer::GenerateCPUIndirectDrawCommands()
 		shadowCasterCommandsBuffer.clear();
 		auto cmd = GetCommandBuffer();
 		shadowCasterCommandsBuffer.writeToCmd(shadowObjects.size(), (void*)shadowObjects.data(),cmd);
-
-		VkAccessFlags srcAccess = VK_ACCESS_MEMORY_WRITE_BIT;
-		VkAccessFlags dstAccess = VK_ACCESS_MEMORY_READ_BIT;
-
-		VkPipelineStageFlags prevStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-		VkPipelineStageFlags nextStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-
-		// Make sure next stage can read this values once transfer is done
-		oGFX::vkutils::tools::insertBufferMemoryBarrier(cmd, m_device.queueIndices.graphicsFamily,
-			shadowCasterCommandsBuffer.getBuffer(), srcAccess, dstAccess,
-			prevStage, nextStage);
 	}
 
 	{
@@ -2384,30 +2450,71 @@ void VulkanRenderer::UploadInstanceData()
 	constexpr float radius = 10.0f;
 	constexpr float offset = 10.0f;
 
-	// update the transform positions
-	gpuTransform.clear();
-	gpuTransform.reserve(MAX_OBJECTS);
-
-
-	objectInformation.clear();
-	objectInformation.reserve(MAX_OBJECTS);
-
 	boneMatrices.clear();
 	boneMatrices.reserve(MAX_OBJECTS); // TODO:: change to better max value
 
-	// TODO: Must the entire buffer be uploaded every frame?
-
-	uint32_t indexCounter = 0;
 	std::vector<oGFX::InstanceData> instanceDataBuff;
+	std::vector<oGFX::InstanceData> casterInstanceData;
 
 	std::unordered_map<uint32_t, uint32_t>entitiyToBoneBufferOffset;
 
-	instanceDataBuff.reserve(batches.m_culledCameraObjects.size());
+	// Every object owns the slot of its id in gpuTransformBuffer and objectInformationBuffer.
+	// Slots are only rebuilt when the object is drawn and has changed since they were last uploaded.
 	if (currWorld)
 	{
-		uint32_t matCnt = 0;
-		for (DrawData& ent : batches.m_culledCameraObjects)
+		WorldSnapshot& snapshot = currWorld->RenderSnapshot();
+		const size_t numSlots = snapshot.objects.buffer().size();
+		gpuSceneSlots.Resize(numSlots);
+		gpuTransform.resize(numSlots);
+		objectInformation.resize(numSlots);
+
+		auto updateSlot = [&](uint32_t id, const ObjectInstance& ent)
+		{
+			if (gpuSceneSlots.NeedsTransform(id, ent.dirtyGeneration))
+			{
+				const mat4& xform = ent.localToWorld;
+				const mat4& prev = ent.prevLocalToWorld;
+				const mat4 inverseXform = glm::inverse(xform);
+				gpuTransform[id] = ConstructGPUTransform(xform, inverseXform, prev);
+				gpuSceneSlots.SetTransform(id, ent.dirtyGeneration, xform != prev);
+			}
+
+			GPUObjectInformation oi{};
+			oi.entityID = ent.entityID;
+			oi.materialIdx = 7; // tem,p
+			oi.emissiveColour = ent.emissiveColour;
+			oi.positionDequant = g_globalModels[ent.modelID].positionDequant;
+			if ((ent.flags & ObjectInstanceFlags::SKINNED) == ObjectInstanceFlags::SKINNED)
+			{
+				auto& mdl = g_globalModels[ent.modelID];
+				oi.boneWeightsOffset = mdl.skinningWeightsOffset;
+
+				auto it = entitiyToBoneBufferOffset.find(ent.entityID);
+				if (it == entitiyToBoneBufferOffset.end()) // doesnt exist, add bones
+				{
+					uint32_t bonesOffset = static_cast<uint32_t>(boneMatrices.size());
+					const std::vector<glm::mat4>& bones = snapshot.bones[id];
+					boneMatrices.insert(boneMatrices.end(), bones.begin(), bones.end());
+					// save offset
+					entitiyToBoneBufferOffset[ent.entityID] = bonesOffset;
+				}
+
+				oi.boneStartIdx = entitiyToBoneBufferOffset[ent.entityID];
+			}
+
+			if (gpuSceneSlots.HasInfo(id) == false || memcmp(&objectInformation[id], &oi, sizeof(oi)) != 0)
+			{
+				objectInformation[id] = oi;
+				gpuSceneSlots.SetInfo(id);
+			}
+		};
+
+		const std::vector<uint32_t>& cameraObjects = batches.GetVisibleObjects(batches.m_cameraView);
+		instanceDataBuff.reserve(cameraObjects.size());
+
+		for (uint32_t id : cameraObjects)
 		{							
+			const ObjectInstance& ent = snapshot.objects.buffer()[id];
 			oGFX::InstanceData instData;
 
 			// This is per entity. Should be per material.
@@ -2434,7 +2541,7 @@ void VulkanRenderer::UploadInstanceData()
 			// Important: Make sure this index packing matches the unpacking in the shader
 			const uint32_t albedo_normal = albedo << 16 | (normal & 0xFFFF);
 			const uint32_t roughness_metallic = roughness << 16 | (metallic & 0xFFFF);
-			const uint32_t instanceID = uint32_t(indexCounter); // the instance id should point to the entity
+			const uint32_t instanceID = id; // the instance id points to the object's slot in the GPU scene
 			auto res = ent.flags & ObjectInstanceFlags::SKINNED;
 			auto isSkin = (res == ObjectInstanceFlags::SKINNED);
 			const uint32_t emissive_skinned = emissive << 16 | (uint32_t)perInstanceData | isSkin << 8; //matCnt;
@@ -2453,137 +2560,57 @@ void VulkanRenderer::UploadInstanceData()
 
 			instanceDataBuff.emplace_back(instData);
 
-			{
-				// creates a single transform reference for each entity in the scene
-				size_t x = gpuTransform.size();
-				OO_ASSERT(indexCounter == x);
-				const mat4& xform = ent.localToWorld;
-				const mat4& prev = ent.prevLocalToWorld;
-				const mat4 inverseXform = glm::inverse(xform);
-				GPUTransform gpt = ConstructGPUTransform(xform, inverseXform,prev);
+			updateSlot(id, ent);
+		}// end of entity instance loop
 
-				gpuTransform.emplace_back(gpt);
-			}
-			// skined mesh
-			GPUObjectInformation oi;
-			oi.entityID = ent.entityID;
-			oi.materialIdx = 7; // tem,p
-			oi.emissiveColour = ent.emissiveColour;
-			if ((ent.flags & ObjectInstanceFlags::SKINNED) == ObjectInstanceFlags::SKINNED)
+		casterInstanceData.reserve(MAX_OBJECTS);
+		auto& shadowCasters = batches.m_casterData;
+		// for each light
+		for (GraphicsBatch::CastersData& caster : shadowCasters)
+		{		
+			// for each face
+			for (size_t face = 0; face < 6; face++)
 			{
-				auto& mdl = g_globalModels[ent.modelID];				
-				oi.boneWeightsOffset = mdl.skinningWeightsOffset;				
-				
-				auto it = entitiyToBoneBufferOffset.find(ent.entityID);
-				if (it == entitiyToBoneBufferOffset.end()) // doesnt exist, add bones
+				std::vector<oGFX::IndirectCommand>& commands = caster.m_commands[face];
+				// faces still holding last frame's depth are not drawn
+				if (commands.empty() || caster.m_dirty[face] == false) continue;
+				const std::vector<uint32_t>& entities = batches.GetVisibleObjects(caster.m_views[face]);
+
+				// store previous size
+				size_t offset = casterInstanceData.size();
+				// for each mesh
+				for (size_t indir = 0; indir < commands.size(); indir++)
 				{
-					uint32_t bonesOffset = static_cast<uint32_t>(boneMatrices.size());
-					for (size_t i = 0; i < ent.ptrToBoneBuffer->size(); i++)
+					oGFX::IndirectCommand icmd = commands[indir];
+
+					for (size_t i = 0 ; i < icmd.instanceCount; i++)
 					{
-						boneMatrices.push_back((*ent.ptrToBoneBuffer)[i]);
+						const uint32_t id = entities[icmd.firstInstance + i];
+						const ObjectInstance& ent = snapshot.objects.buffer()[id];
+
+						bool isSkin = (bool)(ent.flags & ObjectInstanceFlags::SKINNED);
+						const uint8_t perInstanceData = ent.instanceData;
+						const uint32_t emissive_skinned = ent.bindlessGlobalTextureIndex_Emissive << 16 | (uint32_t)perInstanceData | isSkin << 8; //matCnt;
+						oGFX::InstanceData instData;
+						instData.instanceAttributes = uvec4(id, emissive_skinned, 0, 0);
+						casterInstanceData.emplace_back(instData);
+
+						// casters share the slot with the camera view, no copy per face anymore
+						updateSlot(id, ent);
 					}
-					// save offsert
-					entitiyToBoneBufferOffset[ent.entityID] = bonesOffset;
 				}
 
-				oi.boneStartIdx = entitiyToBoneBufferOffset[ent.entityID];				
-			}
-			//boneMatrices.push_back(mat4(1.0f));
-
-			objectInformation.push_back(oi);
-
-			++indexCounter;
-			++matCnt;
-		}// end of entity instance loop
-	}
-
-
-
-	gpuShadowCasterTransform.clear();
-	gpuShadowCasterTransform.reserve(MAX_OBJECTS);
-	std::vector<oGFX::InstanceData> casterInstanceData;
-	casterInstanceData.reserve(MAX_OBJECTS);
-	std::vector<GPUObjectInformation> casterObjectInformation;
-	casterObjectInformation.reserve(MAX_OBJECTS);
-	auto& shadowCasters = batches.m_casterData;
-	size_t casterCounter{};
-	// for each light
-	for (GraphicsBatch::CastersData& caster : shadowCasters)
-	{		
-		// for each face
-		for (size_t face = 0; face < 6; face++)
-		{
-
-			std::vector<oGFX::IndirectCommand>& commands = caster.m_commands[face];
-			std::vector<DrawData>& entities = caster.m_culledObjects[face];
-
-			// store previous size
-			size_t offset = gpuShadowCasterTransform.size();
-			// for each mesh
-			for (size_t indir = 0; indir < commands.size(); indir++)
-			{
-				oGFX::IndirectCommand icmd = commands[indir];
-
-				for (size_t i = 0 ; i < icmd.instanceCount; i++)
+				for (oGFX::IndirectCommand& cmd : commands)
 				{
-					auto& ent = entities[icmd.firstInstance+i];
-					// creates a single transform reference for each entity in the scene
-					const mat4& xform = ent.localToWorld;
-					const mat4& prev = ent.prevLocalToWorld;
-					const mat4 inverseXform = glm::inverse(xform);
-					GPUTransform gpt = ConstructGPUTransform(xform, inverseXform, prev);
-
-					gpuShadowCasterTransform.emplace_back(gpt);
-
-					bool isSkin = (bool)(ent.flags & ObjectInstanceFlags::SKINNED);
-					const uint8_t perInstanceData = ent.instanceData;
-					const uint32_t emissive_skinned = ent.bindlessGlobalTextureIndex_Emissive << 16 | (uint32_t)perInstanceData | isSkin << 8; //matCnt;
-					oGFX::InstanceData instData;
-					instData.instanceAttributes = uvec4(casterCounter, emissive_skinned, 0, 0);
-					casterInstanceData.emplace_back(instData);
-
-					casterCounter++;
-
-					GPUObjectInformation oi;
-					oi.entityID = ent.entityID;
-					oi.materialIdx = 7; // tem,p
-					oi.emissiveColour = ent.emissiveColour;
-					if ((ent.flags & ObjectInstanceFlags::SKINNED) == ObjectInstanceFlags::SKINNED)
-					{
-						auto& mdl = g_globalModels[ent.modelID];
-						oi.boneWeightsOffset = mdl.skinningWeightsOffset;
-
-						auto it = entitiyToBoneBufferOffset.find(ent.entityID);
-						if (it == entitiyToBoneBufferOffset.end()) // doesnt exist, add bones
-						{
-							uint32_t bonesOffset = static_cast<uint32_t>(boneMatrices.size());
-							for (size_t i = 0; i < ent.ptrToBoneBuffer->size(); i++)
-							{
-								boneMatrices.push_back((*ent.ptrToBoneBuffer)[i]);
-							}
-							// save offset
-							entitiyToBoneBufferOffset[ent.entityID] = bonesOffset;
-						}
-
-						oi.boneStartIdx = entitiyToBoneBufferOffset[ent.entityID];
-					}
-					//boneMatrices.push_back(mat4(1.0f));
-
-					casterObjectInformation.push_back(oi);
+					// the offset to the instance data will be based off the big buffer
+					cmd.firstInstance += (uint32_t)offset;
 				}
-			}
 
-			for (oGFX::IndirectCommand& cmd : commands)
-			{
-				// the offset to the transform will be based off the big buffer
-				cmd.firstInstance += (uint32_t)offset;
-			}
-
-		} // end for face	
+			} // end for face	
+		}
 	}
 
-
-	if (instanceDataBuff.empty())
+	if (instanceDataBuff.empty() && casterInstanceData.empty() && gpuSceneSlots.HasQueued() == false)
 	{
 		return;
 	}
@@ -2593,14 +2620,42 @@ void VulkanRenderer::UploadInstanceData()
 	PROFILE_GPU_CONTEXT(cmd);
 	PROFILE_GPU_EVENT("Upload OI");
 	VK_NAME(m_device.logicalDevice, "Upload OI", cmd);
-	gpuTransformBuffer.writeToCmd(gpuTransform.size(), gpuTransform.data(),cmd);
-	gpuBoneMatrixBuffer.writeToCmd(boneMatrices.size(), boneMatrices.data(),cmd);
 
-	gpuShadowCasterTransformBuffer.writeToCmd(gpuShadowCasterTransform.size(), gpuShadowCasterTransform.data(), cmd);
+	if (gpuTransform.size() > gpuTransformBuffer.m_capacity || objectInformation.size() > objectInformationBuffer.m_capacity)
+	{
+		// the new buffers start out empty, refill every slot we have data for
+		const size_t capacity = std::max<size_t>(gpuTransform.size() * 2, MAX_OBJECTS);
+		gpuTransformBuffer.reserve(cmd, capacity);
+		objectInformationBuffer.reserve(cmd, capacity);
+		gpuSceneSlots.QueueAll();
+	}
 
-	objectInformationBuffer.writeToCmd(objectInformation.size(), objectInformation.data(), cmd);
+	{
+		// the previous frame may still be reading the slots we are about to overwrite
+		VkPipelineStageFlags readStages = VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+		oGFX::vkutils::tools::insertBufferMemoryBarrier(cmd, m_device.queueIndices.graphicsFamily,
+			gpuTransformBuffer.getBuffer(), VK_ACCESS_SHADER_READ_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+			readStages, VK_PIPELINE_STAGE_TRANSFER_BIT);
+		oGFX::vkutils::tools::insertBufferMemoryBarrier(cmd, m_device.queueIndices.graphicsFamily,
+			objectInformationBuffer.getBuffer(), VK_ACCESS_SHADER_READ_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+			readStages, VK_PIPELINE_STAGE_TRANSFER_BIT);
+	}
 
-	casterObjectInformationBuffer.writeToCmd(casterObjectInformation.size(), casterObjectInformation.data(),cmd);
+	// coalesce neighbouring slots into one region each, the whole batch goes out in one copy per buffer
+	gpuSceneSlots.TakeTransformRanges(gpuSceneRanges);
+	for (const GPUSceneSlots::Range& r : gpuSceneRanges)
+	{
+		gpuTransformBuffer.addWriteCommand(r.count, &gpuTransform[r.first], r.first);
+	}
+	gpuSceneSlots.TakeInfoRanges(gpuSceneRanges);
+	for (const GPUSceneSlots::Range& r : gpuSceneRanges)
+	{
+		objectInformationBuffer.addWriteCommand(r.count, &objectInformation[r.first], r.first);
+	}
+	gpuTransformBuffer.flushToGPU(cmd);
+	objectInformationBuffer.flushToGPU(cmd);
+
+	gpuBoneMatrixBuffer.writeToCmd(boneMatrices.size(), boneMatrices.data(),cmd);
 
     // Better to catch this on the software side early than the Vulkan validation layer
 	// TODO: Fix this gracefully
@@ -2635,10 +2690,6 @@ void VulkanRenderer::UploadInstanceData()
 		gpuTransformBuffer.getBuffer(), srcAccess, dstAccess,
 		prevStage, nextStage);
 
-	oGFX::vkutils::tools::insertBufferMemoryBarrier(cmd, m_device.queueIndices.graphicsFamily,
-		gpuShadowCasterTransformBuffer.getBuffer(), srcAccess, dstAccess,
-		prevStage, nextStage);
-
 }
 
 void VulkanRenderer::UploadUIData()
@@ -2687,6 +2738,15 @@ bool VulkanRenderer::PrepareFrame()
 
 	}
 
+	UpdateTextureStreaming();
+
+	{
+		PROFILE_SCOPED("Texture uploads");
+		// the engine's own textures stand in for the ones still uploading, they have to be there from the first frame
+		const bool waitForDefaults = g_Textures[whiteTextureID].isValid == false;
+		m_device.textureUploader.Update(waitForDefaults);
+	}
+
 	if (resizeSwapchain || windowPtr->m_width == 0 ||windowPtr->m_height == 0)
 	{
 		m_prepared = ResizeSwapchain();
@@ -2725,6 +2785,8 @@ void VulkanRenderer::BeginDraw()
 		VK_CHK(vkWaitForFences(m_device.logicalDevice, 1, &drawFences[getFrame()], VK_TRUE, std::numeric_limits<uint64_t>::max()));
 		//mainually reset fences
 		VK_CHK(vkResetFences(m_device.logicalDevice, 1, &drawFences[getFrame()]));
+		// the GPU is done with everything this frame staged last time around
+		m_device.stagingRing.BeginFrame(getFrame());
 	}
 
 	{
@@ -2764,8 +2826,22 @@ void VulkanRenderer::BeginDraw()
 			DelayedDeleter::get()->Update();
 		}
 
+		{
+			const auto descriptors = descAllocs[getFrame()].GetStats();
+			if (descriptors.allocated + descriptors.cacheHits > peakDescriptorStats.allocated + peakDescriptorStats.cacheHits)
+			{
+				peakDescriptorStats = descriptors;
+			}
+		}
 		descAllocs[getFrame()].ResetPools();
 
+		// before the batches are built, they read the submesh offsets
+		if (m_defragmentMeshBuffers)
+		{
+			DefragmentMeshBuffers();
+			m_defragmentMeshBuffers = false;
+		}
+
 		shadowsRendered = false;
 
 		if (currWorld)
@@ -2791,9 +2867,13 @@ void VulkanRenderer::BeginDraw()
 			jitterPhaseCount = ffxFsr2GetJitterPhaseCount(renderWidth, resInfo.width);
 			ffxFsr2GetJitterOffset(&jitterX, &jitterY, m_JitterIndex, jitterPhaseCount);
 						
-			for (size_t i = 0; i < currWorld->numCameras; i++)
+			// take the newest snapshot first, the cameras drawn with are the snapshot's
+			batches.Init(currWorld, this, MAX_OBJECTS);
+			currWorld->BeginFrame();
+			WorldSnapshot& snapshot = currWorld->RenderSnapshot();
+			for (size_t i = 0; i < snapshot.numCameras; i++)
 			{
-				Camera& cam = currWorld->cameras[i];		
+				Camera& cam = snapshot.cameras[i];		
 
 				if (m_useJitter && m_upscaleType != UPSCALING_TYPE::NONE) {
 
@@ -2812,9 +2892,7 @@ void VulkanRenderer::BeginDraw()
 				cam.UpdateMatrices();
 			}
 			
-			batches.Init(currWorld, this, MAX_OBJECTS);
-			currWorld->BeginFrame();
-			auto f = currWorld->cameras[0].GetFrustum();
+			auto f = snapshot.cameras[0].GetFrustum();
 			std::vector<oGFX::AABB> boxes;
 			std::vector<uint32_t> depth;
 			currWorld->m_OctTree->GetActiveBoxList(boxes, depth);
@@ -2848,6 +2926,9 @@ void VulkanRenderer::BeginDraw()
 					PROFILE_SCOPED("Mesh buffers");
 					if (g_GlobalMeshBuffers.IdxBuffer.m_mustUpdate) g_GlobalMeshBuffers.IdxBuffer.flushToGPU(cmd);
 					if (g_GlobalMeshBuffers.VtxBuffer.m_mustUpdate) g_GlobalMeshBuffers.VtxBuffer.flushToGPU(cmd);
+					if (g_GlobalMeshlets.Meshlets.m_mustUpdate) g_GlobalMeshlets.Meshlets.flushToGPU(cmd);
+					if (g_GlobalMeshlets.Vertices.m_mustUpdate) g_GlobalMeshlets.Vertices.flushToGPU(cmd);
+					if (g_GlobalMeshlets.Triangles.m_mustUpdate) g_GlobalMeshlets.Triangles.flushToGPU(cmd);
 					if (gpuSkinningWeightsBuffer.m_mustUpdate) gpuSkinningWeightsBuffer.flushToGPU(cmd);
 				}
 				
@@ -2914,23 +2995,11 @@ void VulkanRenderer::RenderFrame()
 			AddRenderer(g_ImguiRenderpass);
 		}
 
-		std::condition_variable cv;
-		std::mutex waitMut;
-		bool waitingForTasks = true;
-		auto tasksDone = [&w = waitingForTasks, &mut = waitMut, &cond = cv](void*) {
-			std::scoped_lock l(mut);
-			w = false;
-			cond.notify_all();
-			};
-		drawCallRecordingCompleted.CompletionTask = Task(tasksDone);
-		drawCallRecordingCompleted.TaskCount = (uint32_t)m_taskList.size();
-
 		g_taskManager.AddTaskList(m_taskList);
 		{
 			PROFILE_GPU_EVENT("Wait for workers");
-			// wait for task to complete
-			std::unique_lock l(waitMut);
-			cv.wait(l, [&wait = waitingForTasks]() { return wait == false; });
+			// record passes on this thread too until every task is complete
+			g_taskManager.WaitForCounter(drawCallRecordingCompleted);
 		}
 
 		//once done execute sequential task
@@ -2949,6 +3018,7 @@ void VulkanRenderer::RenderFunc(bool shouldRunDebugDraw)
 
 	
 	RenderGraph builder;
+	builder.transients = &transientPool;
 
 	//for (size_t i = 0; i < currWorld->numCameras; i++)
 	{		
@@ -2983,7 +3053,7 @@ void VulkanRenderer::RenderFunc(bool shouldRunDebugDraw)
 		builder.AddPass(g_ZPrePass);
 		builder.AddPass(g_GBufferRenderPass);
 
-		if (currWorld->ssaoSettings.type == 0) {
+		if (currWorld->RenderSnapshot().ssaoSettings.type == 0) {
 			attachments.SSAO_workingTarget = &attachments.SSAO_finalTarget;
 			builder.AddPass(g_XeGTAORenderPass);
 		}
@@ -3014,6 +3084,12 @@ void VulkanRenderer::RenderFunc(bool shouldRunDebugDraw)
 		builder.AddPass(g_DebugDrawRenderpass);
 
 		builder.Setup();
+		// blitted to the swapchain and read back for the exposure after the graph
+		builder.MarkOutput(renderTargets[renderTargetInUseID].texture);
+		builder.MarkOutput(LuminanceBuffer);
+		builder.Compile();
+		// before any pass is recorded, the transients may move to new memory
+		transientPool.Update(builder.GetPassDescs(), builder.GetCompileResult());
 		if (m_dumpRenderpassInfo == true) {
 			m_dumpRenderpassInfo = false;
 			builder.DumpPassDependencies();
@@ -3483,6 +3559,7 @@ bool VulkanRenderer::ResizeSwapchain()
 	CreateFramebuffers();
 
 	fbCache.ResizeSwapchain(m_swapchain.swapChainExtent.width, m_swapchain.swapChainExtent.height);
+	transientPool.Invalidate();
 
 	ResizeGUIBuffers();
 
@@ -3553,6 +3630,11 @@ uint32_t VulkanRenderer::getPreviousFrame() const
 	return 1; // special for first frame
 }
 
+namespace
+{
+	thread_local uint32_t t_threadMapping = UINT32_MAX;
+}
+
 uint32_t VulkanRenderer::RegisterThreadMapping()
 {
 	std::scoped_lock l{ g_mut_taskMap };
@@ -3560,9 +3642,21 @@ uint32_t VulkanRenderer::RegisterThreadMapping()
 	auto thread = std::this_thread::get_id();
 	// printf("Thread %llu mapped to %d\n", *reinterpret_cast<size_t*>(&thread), threadID);
 	g_taskManagerMapping[std::this_thread::get_id()] = threadID;
+	t_threadMapping = threadID;
 	return threadID;
 }
 
+uint32_t VulkanRenderer::GetThreadMapping()
+{
+	// a thread outside the task manager, like a render thread, maps itself on first use
+	if (t_threadMapping == UINT32_MAX)
+	{
+		RegisterThreadMapping();
+	}
+	OO_ASSERT(t_threadMapping < oGFX::MaxMappedThreads());
+	return t_threadMapping;
+}
+
 ModelFileResource* VulkanRenderer::GetDefaultCube()
 {
 	return def_cube.get();
@@ -3600,246 +3694,125 @@ oGFX::Font * VulkanRenderer::LoadFont(const std::string & filename)
 
 ModelFileResource* VulkanRenderer::LoadModelFromFile(const std::string& file)
 {
-	std::stringstream ss;
-	// new model loader
-	Assimp::Importer importer;
-	importer.SetPropertyBool(AI_CONFIG_IMPORT_REMOVE_EMPTY_BONES, false);
-	uint flags = 0;
-	flags |= aiProcess_Triangulate;
-	flags |= aiProcess_GenSmoothNormals;
-	flags |= aiProcess_ImproveCacheLocality;
-	flags |= aiProcess_CalcTangentSpace;
-	flags |= aiProcess_FindInstances; // this step is slow but it finds duplicate instances in FBX
-	flags |= aiProcess_FlipUVs;
-	//flags |= aiProcess_LimitBoneWeights; // limmits bones to 4
-	const aiScene *scene = importer.ReadFile(file,flags
-		//  aiProcess_Triangulate                // Make sure we get triangles rather than nvert polygons
-		//| aiProcess_LimitBoneWeights           // 4 weights for skin model max
-		//| aiProcess_GenUVCoords                // Convert any type of mapping to uv mapping
-		//| aiProcess_TransformUVCoords          // preprocess UV transformations (scaling, translation ...)
-		//| aiProcess_FindInstances              // search for instanced meshes and remove them by references to one master
-		//| aiProcess_CalcTangentSpace           // calculate tangents and bitangents if possible
-		////| aiProcess_JoinIdenticalVertices      // join identical vertices/ optimize indexing
-		//| aiProcess_RemoveRedundantMaterials   // remove redundant materials
-		//| aiProcess_FindInvalidData            // detect invalid model data, such as invalid normal vectors
-		////| aiProcess_PreTransformVertices       // TODO: remove for skinning?
-		//| aiProcess_FlipUVs						// TODO: some mesh need
-		//| aiProcess_GenNormals					// TODO: some mesh need
-	);
-
-	if (!scene)
+	oGFX::ModelImport::Model model;
+	// a copy cooked from this very file skips assimp and its post processing, see CookedModel.h
+	if (oGFX::CookedModel::Load(file, model) == false
+		&& oGFX::ModelImport::ImportModel(file, model, &g_taskManager) == false)
 	{
 		//OO_ASSERT(scene);
 		return nullptr; // Dont explode...
 		//throw std::runtime_error("Failed to load model! (" + file + ")");
 	}
 
-	
+	ModelFileResource* modelFile = model.resource.release();
 
-	ss <<"[Loading] " << file << std::endl;
-	//if (scene->mNumAnimations && scene->mAnimations[0]->mNumMorphMeshChannels)
-	//{
-	//	std::stringstream ss{"Morphs\n"};
-	//	for (size_t i = 0; i < scene->mAnimations[0]->mNumMorphMeshChannels; i++)
-	//	{
-	//		auto& morph = scene->mAnimations[0]->mMorphMeshChannels[i];
-	//		for (size_t y = 0; y < morph->mNumKeys; y++)
-	//		{
-	//			auto& key = morph->mKeys[y];
-	//			ss << "T:[" << key.mTime << "]" << std::endl;
-	//			for (size_t x = 0; x < key.mNumValuesAndWeights; x++)
-	//			{
-	//				ss << "\tV:[" << key.mValues[x] << "] W:[" << key.mWeights[x] << "]" << std::endl;
-	//			}
-	//		}
-	//		ss << std::endl;
-	//	}
-	//	os << ss.str() << std::endl;
-	//}
+	// built here and handed to the render thread whole, see QueueModel
+	gfxModel mdl;
+	mdl.name = std::filesystem::path(file).stem().string();
+	mdl.cpuModel = modelFile;
+	mdl.skeleton = model.skeleton.release();
 
-	size_t count{ 0 };
-	ss << "Meshes" << scene->mNumMeshes << std::endl;
-	for (size_t i = 0; i < scene->mNumMeshes; i++)
 	{
-		auto& mesh = scene->mMeshes[i];
-		ss << "\tMesh" << i << " " << mesh->mName.C_Str() << std::endl;
-		ss << "\t\tverts:"  << mesh->mNumVertices << std::endl;
-		ss << "\t\tbones:"  << mesh->mNumBones << std::endl;
-		/*
-		for (size_t anim = 0; anim < mesh->mNumAnimMeshes; anim++)
+		oGFX::MeshOpt::Report total;
+		for (const auto& r : modelFile->importReports)
 		{
-		std::stringstream ss;
-			ss << "Anim mesh_" << anim << ":" << mesh->mName.C_Str() << std::endl;
-			auto& animMesh = mesh->mAnimMeshes[anim];
-			if (animMesh->HasPositions())
-			{
-				for (size_t pos = 0; pos < animMesh->mNumVertices; pos++)
-				{
-					++count;
-					auto v = aiVector3D_to_glm(animMesh->mVertices[pos]);
-					ss << "\tPos:"<< pos<< "[" << v.x << "," << v.y << "," << v.z <<"]" << std::endl;
-				}
-			}
-		os << ss.str() << std::endl;
+			total.triangles += r.triangles;
+			total.verticesBefore += r.verticesBefore;
+			total.verticesAfter += r.verticesAfter;
+			total.cacheBefore.misses += r.cacheBefore.misses;
+			total.cacheBefore.vertices += r.cacheBefore.vertices;
+			total.cacheAfter.misses += r.cacheAfter.misses;
+			total.cacheAfter.vertices += r.cacheAfter.vertices;
 		}
-		os << "Takes huge amount of data : " << (float)(sizeof(glm::vec3) * count) / (1024) << "Kb" << std::endl;
-		*/
-		
-		//int sum = 0;
-		//for (size_t x = 0; x <  scene->mMeshes[i]->mNumBones; x++)
-		//{
-		//	std::map<uint32_t, float> wts;
-		//	os << "\t\t\tweights:"  << scene->mMeshes[i]->mBones[x]->mNumWeights << std::endl;
-		//	for (size_t y = 0; y < scene->mMeshes[i]->mBones[x]->mNumWeights; y++)
-		//	{
-		//		auto& weight = scene->mMeshes[i]->mBones[x]->mWeights[y];
-		//		assert(wts.find(weight.mVertexId) == wts.end());
-		//		wts[weight.mVertexId] = weight.mWeight;
-		//	}
-		//	for (auto [v,w] :wts)
-		//	{
-		//		os << "\t\t\t\t"  <<":["<<v <<"," << w << "]" << std::endl;
-		//	}
-		//	sum += scene->mMeshes[i]->mBones[x]->mNumWeights;
-		//}
-		//os << "\t\t\t|sum weights:"  << sum << std::endl;
-	}
-
-#if 0
-	if (scene->HasAnimations())
-	{
-		os << "Animated scene\n";
-		for (size_t i = 0; i < scene->mNumAnimations; i++)
+		if (total.triangles)
 		{
-			os << "Anim name: " << scene->mAnimations[i]->mName.C_Str() << std::endl;
-			os << "Anim frames: "<< scene->mAnimations[i]->mDuration << std::endl;
-			os << "Anim ticksPerSecond: "<< scene->mAnimations[i]->mTicksPerSecond << std::endl;
-			os << "Anim duration: "<< static_cast<float>(scene->mAnimations[i]->mDuration)/scene->mAnimations[i]->mTicksPerSecond << std::endl;
-			os << "Anim numChannels: "<< scene->mAnimations[i]->mNumChannels << std::endl;
-			os << "Anim numMeshChannels: "<< scene->mAnimations[i]->mNumMeshChannels << std::endl;
-			os << "Anim numMeshChannels: "<< scene->mAnimations[i]->mNumMorphMeshChannels << std::endl;
-			for (size_t x = 0; x < scene->mAnimations[i]->mNumChannels; x++)
-			{
-				auto& channel = scene->mAnimations[i]->mChannels[x];
-				os << "\tKeys name: " << channel->mNodeName.C_Str() << std::endl;
-				for (size_t y = 0; y < channel->mNumPositionKeys; y++)
-				{
-					os << "\t Key_"<< std::to_string(y)<<" time: " << channel->mPositionKeys[y].mTime << std::endl;
-					auto& pos = channel->mPositionKeys[y].mValue;
-					os << "\t Key_"<< std::to_string(y)<<" value: " <<pos.x <<", " << pos.y<<", " << pos.z << std::endl;
-				}
-			}
+			std::cout << "[MeshOpt] " << mdl.name << " vertices " << total.verticesBefore << " -> " << total.verticesAfter
+				<< ", ACMR " << float(total.cacheBefore.misses) / total.triangles << " -> " << float(total.cacheAfter.misses) / total.triangles
+				<< ", ATVR " << float(total.cacheBefore.misses) / total.cacheBefore.vertices << " -> " << float(total.cacheAfter.misses) / total.cacheAfter.vertices
+				<< std::endl;
 		}
-		os << std::endl;
-	}
-#endif
 
+		const auto& clusters = modelFile->meshlets;
+		if (clusters.meshlets.size())
+		{
+			std::cout << "[Meshlets] " << mdl.name << " " << clusters.meshlets.size() << " meshlets, "
+				<< float(clusters.vertices.size()) / clusters.meshlets.size() << " vertices and "
+				<< float(clusters.triangles.size()) / clusters.meshlets.size() << " triangles each" << std::endl;
+		}
 
-	ModelFileResource* modelFile = new ModelFileResource(file);
-
-	modelFile->materials.resize(scene->mNumMaterials);
-	for (size_t i = 0; i < scene->mNumMaterials; i++)
-	{
-		const aiMaterial* material = scene->mMaterials[i];
-		Material& modelMaterial = modelFile->materials[i];
-
-		auto updateTexture = [&](aiTextureType type, std::string& saveTo) {
-			const unsigned int numTexture = material->GetTextureCount(type);
-			OO_ASSERT(numTexture <= 1);
-			for (unsigned int j = 0; j < numTexture; j++) {
-				aiString texturePath;
-				if (material->GetTexture(type, j, &texturePath) == AI_SUCCESS) {
-					// texturePath contains the path to the diffuse texture
-					std::filesystem::path pWithoutFile = file;
-					pWithoutFile.remove_filename();
-					std::string finalPath = pWithoutFile.string() + texturePath.C_Str();
-					if (std::filesystem::exists(finalPath)) {
-						saveTo = finalPath;
-					}
-				}
-			}
-		};
-		
-		updateTexture(aiTextureType_DIFFUSE, modelMaterial.albedo);
-		updateTexture(aiTextureType_NORMALS, modelMaterial.normal);
-		updateTexture(aiTextureType_DIFFUSE_ROUGHNESS, modelMaterial.roughness);
-		updateTexture(aiTextureType_SPECULAR, modelMaterial.specular);		
-	
+		oGFX::VertexPacking::MemoryReport memory;
+		memory.Add(modelFile->vertices.data(), modelFile->vertices.size());
+		std::cout << "[VertexPacking] " << mdl.name << " " << memory.unpackedBytes / 1024 << "KB -> " << memory.packedBytes / 1024 << "KB"
+			<< (PACKED_VERTEX_FORMAT ? "" : " when packed") << (memory.modelsWithColour ? ", vertex colours not kept" : "") << std::endl;
 	}
 
-	uint32_t indx{};
+	for (const SubMesh& sm : model.submeshes)
 	{
-		std::scoped_lock s(g_mut_globalModels);
-		auto mdlResourceIdx = g_globalModels.size();
-		modelFile->meshResource = static_cast<uint32_t>(mdlResourceIdx);
-		g_globalModels.emplace_back(gfxModel{});
-		indx = (uint32_t)mdlResourceIdx;
+		mdl.vertexCount += sm.vertexCount;
+		mdl.indicesCount += sm.indicesCount;
+
 	}
-	auto& mdl = g_globalModels[indx];
-	mdl.name = std::filesystem::path(file).stem().string();
 
-	mdl.m_subMeshes.resize(scene->mNumMeshes);
-	modelFile->numSubmesh = scene->mNumMeshes;
+	modelFile->meshResource = QueueModel(std::move(mdl), std::move(model.submeshes));
 
-	modelFile->submeshToMaterial.resize(scene->mNumMeshes);
-	
-	mdl.cpuModel = modelFile;
+	return modelFile;
+}
 
-	uint32_t totalBones{ 0 };
-	mdl.m_subMeshes.resize(scene->mNumMeshes);
-	for (size_t i = 0; i < scene->mNumMeshes; i++)
-	{
-		auto& aimesh = scene->mMeshes[i];
-		uint32_t submeshIdx{};
+std::future<ModelFileResource*> VulkanRenderer::LoadModelFromFileAsync(const std::string& file, bool loadTextures)
+{
+	auto promise = std::make_shared<std::promise<ModelFileResource*>>();
+	std::future<ModelFileResource*> result = promise->get_future();
+
+	Task task{ [this, file, loadTextures, promise](void*) {
+		ModelFileResource* model = LoadModelFromFile(file);
+		if (model && loadTextures)
 		{
-			std::scoped_lock s(g_mut_globalModels);
-			submeshIdx = (uint32_t)g_globalSubmesh.size();
-			g_globalSubmesh.push_back(SubMesh{});
+			LoadModelTextures(model);
 		}
-		SubMesh& submesh = g_globalSubmesh[submeshIdx];
-		mdl.m_subMeshes[i] = submeshIdx;
-		
-		modelFile->submeshToMaterial[i] = aimesh->mMaterialIndex;
-		LoadSubmesh(mdl, submesh, aimesh, modelFile);
-		totalBones += scene->mMeshes[i]->mNumBones;
-	}
-	bool hasBone = totalBones > 0;
+		promise->set_value(model);
+	} };
+	g_taskManager.AddTask(task);
+	return result;
+}
 
-	if (hasBone)
+void VulkanRenderer::LoadModelTextures(ModelFileResource* model)
+{
+	PROFILE_SCOPED();
+
+	// materials sharing a file share the texture, each file decodes on its own task
+	std::vector<std::string> files;
+	for (const Material& m : model->materials)
 	{
-		mdl.skeleton = new oGFX::Skeleton();
-		modelFile->skeleton = mdl.skeleton;
-		mdl.skeleton->boneWeights.resize(modelFile->vertices.size());
-		uint32_t verticesCnt = 0;
-		for (size_t i = 0; i < scene->mNumMeshes; i++)
+		for (const std::string* path : { &m.albedo, &m.normal, &m.specular, &m.roughness })
 		{
-			auto& aimesh = scene->mMeshes[i];
-			LoadBoneInformation(*modelFile,*mdl.skeleton, *aimesh, mdl.skeleton->boneWeights, verticesCnt);
+			if (path->size() && std::find(files.begin(), files.end(), *path) == files.end())
+			{
+				files.push_back(*path);
+			}
 		}
-		mdl.skeleton->m_boneNodes = new oGFX::BoneNode();
-		mdl.skeleton->m_boneNodes->mName = "RootNode";
-		BuildSkeletonRecursive(*modelFile, scene->mRootNode, mdl.skeleton->m_boneNodes);
 	}
-	
-	for (auto smID : mdl.m_subMeshes)
-	{
-		auto& sm = g_globalSubmesh[smID];
-		mdl.vertexCount += sm.vertexCount;
-		mdl.indicesCount += sm.indicesCount;
 
+	std::vector<uint32_t> ids(files.size());
+	std::queue<Task> tasks;
+	for (size_t i = 0; i < files.size(); i++)
+	{
+		tasks.emplace([this, file = &files[i], id = &ids[i]](void*) {
+			*id = CreateTexture(*file);
+		});
 	}
+	g_taskManager.AddTaskListAndWait(tasks);
 
-	//always has one transform, root
-	modelFile->ModelSceneLoad(scene, *scene->mRootNode, nullptr, glm::mat4{ 1.0f });
-	
+	auto idOf = [&files, &ids](const std::string& path, uint32_t fallback) {
+		const auto it = std::find(files.begin(), files.end(), path);
+		return it == files.end() ? fallback : ids[it - files.begin()];
+	};
+	for (Material& m : model->materials)
 	{
-		LoadMeshFromBuffers(modelFile->vertices, modelFile->indices, &mdl);
+		m.albedoTexture = idOf(m.albedo, m.albedoTexture);
+		m.normalTexture = idOf(m.normal, m.normalTexture);
+		m.specularTexture = idOf(m.specular, m.specularTexture);
+		m.roughnessTexture = idOf(m.roughness, m.roughnessTexture);
 	}
-
-	ss << "\t [Meshes loaded] " << modelFile->sceneMeshCount << std::endl;
-
-	//std::cout << ss.str();
-	return modelFile;
 }
 
 oGFX::TexturePacker VulkanRenderer::CreateFontAtlas(const std::string& filename, oGFX::Font& font)
@@ -4109,201 +4082,134 @@ oGFX::TexturePacker VulkanRenderer::CreateFontAtlas(const std::string& filename,
 	return atlas;
 }
 
-#define FIX_VERTEX_ISSUES 0
-
-void VulkanRenderer::LoadSubmesh(gfxModel& mdl,
-	SubMesh& submesh,
-	aiMesh* aimesh,
-	ModelFileResource* modelFile
+ModelFileResource* VulkanRenderer::LoadMeshFromBuffers(
+	std::vector<oGFX::Vertex>& vertex,
+	std::vector<uint32_t>& indices
 )
 {
-	submesh.name = aimesh->mName.C_Str();
-
-	auto& vertices = modelFile->vertices;
-	auto& indices = modelFile->indices;
-
-	auto cacheVoffset = vertices.size();
-	auto cacheIoffset = indices.size();
-
-	bool once = false;
-
-	vertices.reserve(vertices.size() + aimesh->mNumVertices);
-	for (size_t i = 0; i < aimesh->mNumVertices; i++)
+	// this is a file-less object, generate a model for it
+	gfxModel model;
+	model.indicesCount = static_cast<uint32_t>(indices.size());
+	model.vertexCount = static_cast<uint32_t>(vertex.size());
+
+	SubMesh sm;
+	sm.baseIndices = static_cast<uint32_t>(0);
+	sm.baseVertex = static_cast<uint32_t>(0);
+	sm.indicesCount = static_cast<uint32_t>(indices.size());
+	sm.vertexCount = static_cast<uint32_t>(vertex.size());
+	std::vector<glm::vec3> plainVertices;
+	plainVertices.resize(vertex.size());
+	for (size_t i = 0; i < plainVertices.size(); i++)
 	{
-		oGFX::Vertex vertex;
-		vertex.pos = aiVector3D_to_glm(aimesh->mVertices[i]);
-		if (aimesh->HasTextureCoords(0)) // does the mesh contain texture coordinates?
-		{
-			vertex.tex = glm::vec2{ aimesh->mTextureCoords[0][i].x, aimesh->mTextureCoords[0][i].y };
-		}
-		if (aimesh->HasNormals())
-		{
-			vertex.norm = aiVector3D_to_glm(aimesh->mNormals[i]);
-		}
-		if (aimesh->HasTangentsAndBitangents())
-		{
-			vertex.tangent = aiVector3D_to_glm(aimesh->mTangents[i]);
-		}
-		if (aimesh->HasVertexColors(0))
-		{
-			const auto& color = aimesh->mColors[0][i];
-			vertex.col = glm::vec4{ color.r, color.g, color.b, color.a };
-		}
-		vertices.emplace_back(vertex);
-
-
-
-		if (once == false) {
-			auto tanlen = glm::dot(vertex.tangent, vertex.tangent);
-			auto nlen = glm::dot(vertex.norm, vertex.norm);
-			auto bt = glm::cross(vertex.tangent, vertex.norm);
-			auto blen = glm::dot(bt, bt);
-
-#if FIX_VERTEX_ISSUES
-			// we can reject here if needed
-			if (tanlen == 0.0f || nlen == 0.0f || blen == 0.0f) {
-				once = true;
-				std::string namestring;
-				if (aimesh->mName.C_Str()) namestring = aimesh->mName.C_Str();
-				printf("Model %s has vertex normal issues v[%llu]\n", namestring.c_str(), i);
-				printf("Fixing vertex normals...\n");
-				//__debugbreak();
-			}
-#endif // FIX_VERTEX_ISSUES
-		}
+		plainVertices[i] = vertex[i].pos;
 	}
+	oGFX::BV::RitterSphere(sm.boundingSphere, plainVertices);		
 
-	uint32_t indicesCnt{};
-	for (uint32_t i = 0; i < aimesh->mNumFaces; i++)
-	{
-		const aiFace& face = aimesh->mFaces[i];
-		indicesCnt += face.mNumIndices;
-		for (uint32_t j = 0; j < face.mNumIndices; j++)
-		{
-			indices.push_back(face.mIndices[j]);
-		}
+	ModelFileResource* m = new ModelFileResource();
+	sm.meshletCount = static_cast<uint32_t>(oGFX::Meshlets::Build(m->meshlets, indices.data(), indices.size(),
+		reinterpret_cast<const float*>(plainVertices.data()), plainVertices.size(), sizeof(glm::vec3)));
+	Node* n = new Node{};
+	m->sceneInfo = n;
+	m->vertices = vertex;
+	m->indices = indices;
+	m->numSubmesh = 1;
 
+	model.cpuModel = m;
+	m->meshResource = QueueModel(std::move(model), { sm });
 
-		assert(face.mNumIndices == 3);
-		std::array<oGFX::Vertex, 3> vert{
-			vertices[face.mIndices[0]],
-			vertices[face.mIndices[1]],
-			vertices[face.mIndices[2]],
-		};
+	return m;
+}
 
-		auto line0= vert[0].pos-vert[1].pos;
-		auto line1= vert[2].pos-vert[2].pos;
-		auto normal = glm::normalize(glm::cross(line0,line1));
-		if (glm::dot(normal, normal) == 0) {
-			__debugbreak();
-		}
+uint32_t VulkanRenderer::QueueModel(gfxModel&& model, std::vector<SubMesh>&& submeshes)
+{
+	model.positionDequant = oGFX::VertexPacking::ComputePositionDequant(model.cpuModel->vertices.data() + model.baseVertex, model.vertexCount);
 
-		for (uint32_t j = 0; j < face.mNumIndices; j++)
-		{			
-			if (glm::dot(vert[j].norm, vert[j].norm) == 0)
-			{
-				// fix zero normals
-				vert[j].norm = normal;
-			}
-		}
+	uint32_t id{};
+	{
+		// ids go out in the order the models are queued, the render thread adds them in the same order
+		std::scoped_lock s{ g_mut_globalModels };
+		id = g_numModelIDs++;
+		g_pendingModels.push_back(PendingModel{ id, std::move(model), std::move(submeshes) });
 	}
-
-	submesh.vertexCount = aimesh->mNumVertices;
-	submesh.baseVertex = static_cast<uint32_t>(cacheVoffset);
-	submesh.indicesCount = indicesCnt;
-	submesh.baseIndices = static_cast<uint32_t>(cacheIoffset);
-
-	std::vector<glm::vec3> plainVertices;
-	plainVertices.resize(aimesh->mNumVertices);
-	for (size_t i = 0; i < plainVertices.size(); i++)
 	{
-		plainVertices[i] = vertices[cacheVoffset+i].pos; 
+		std::scoped_lock s{ g_mut_workQueue };
+		g_workQueue.emplace_back([this]() { PublishModels(); });
 	}
-
-	//generate BV
-	oGFX::BV::LarsonSphere(submesh.boundingSphere, plainVertices);
-
+	return id;
 }
 
-ModelFileResource* VulkanRenderer::LoadMeshFromBuffers(
-	std::vector<oGFX::Vertex>& vertex,
-	std::vector<uint32_t>& indices,
-	gfxModel* model
-)
+void VulkanRenderer::PublishModels()
 {
-	uint32_t index = 0;
-	ModelFileResource* m{ nullptr };
+	PROFILE_SCOPED();
 
-	if (model == nullptr)
+	const size_t firstNew = g_globalModels.size();
 	{
 		std::scoped_lock s{ g_mut_globalModels };
-		// this is a file-less object, generate a model for it
-		index = static_cast<uint32_t>(g_globalModels.size());
-		g_globalModels.emplace_back(gfxModel());
-		model = &g_globalModels[index];
-
-		model->indicesCount = static_cast<uint32_t>(indices.size());
-		model->vertexCount = static_cast<uint32_t>(vertex.size());
-		
-		uint32_t smID = (uint32_t)g_globalSubmesh.size();
-		g_globalSubmesh.push_back(SubMesh{});
-		model->m_subMeshes.push_back(smID);
-		SubMesh& sm = g_globalSubmesh[smID];
-		sm.baseIndices = static_cast<uint32_t>(0);
-		sm.baseVertex = static_cast<uint32_t>(0);
-		sm.indicesCount = static_cast<uint32_t>(indices.size());
-		sm.vertexCount = static_cast<uint32_t>(vertex.size());
-		std::vector<glm::vec3> plainVertices;
-		plainVertices.resize(vertex.size());
-		for (size_t i = 0; i < plainVertices.size(); i++)
+		for (PendingModel& pending : g_pendingModels)
 		{
-			plainVertices[i] = vertex[i].pos;
+			OO_ASSERT(pending.id == g_globalModels.size());
+			gfxModel& mdl = g_globalModels.emplace_back(std::move(pending.model));
+			mdl.m_subMeshes.resize(pending.submeshes.size());
+			for (size_t i = 0; i < pending.submeshes.size(); i++)
+			{
+				mdl.m_subMeshes[i] = static_cast<uint32_t>(g_globalSubmesh.size());
+				g_globalSubmesh.push_back(std::move(pending.submeshes[i]));
+			}
 		}
-		oGFX::BV::RitterSphere(sm.boundingSphere, plainVertices);		
-
-		m = new ModelFileResource();
-		Node* n = new Node{};
-		m->sceneInfo = n;
-		m->vertices = vertex;
-		m->indices = indices;
-		m->numSubmesh = 1;
-		m->meshResource = index;
-
-		model->cpuModel = m;
-	}	
-
-	// these offsets are using local offset based on the buffer.
-	//std::cout << "Writing to vtx from data " << model->baseVertex
-	//	<< " for " << model->vertexCount
-	//	<<" total " << model->baseVertex+model->vertexCount
-	//	<< " at GPU buffer " << g_GlobalMeshBuffers.VtxOffset
-	//	<< std::endl;
-
+		g_pendingModels.clear();
+	}
 
 	// now we update them to the global offset
-	auto cmd = GetCommandBuffer();
-	auto lam = [this,model,cmd]() 
+	for (size_t modelID = firstNew; modelID < g_globalModels.size(); modelID++)
 	{
-		//std::scoped_lock(g_mut_globalMeshBuffers);
+		gfxModel* model = &g_globalModels[modelID];
+		std::scoped_lock s{ g_mut_globalMeshBuffers };
 		auto& indices = model->cpuModel->indices;
 		auto& vertex = model->cpuModel->vertices;
-		
-		g_GlobalMeshBuffers.IdxBuffer.addWriteCommand(model->indicesCount, indices.data() + model->baseIndices,g_GlobalMeshBuffers.IdxOffset);
-		g_GlobalMeshBuffers.VtxBuffer.addWriteCommand(model->vertexCount, vertex.data() + model->baseVertex,g_GlobalMeshBuffers.VtxOffset);
 
-		model->baseIndices = g_GlobalMeshBuffers.IdxOffset;
-		model->baseVertex = g_GlobalMeshBuffers.VtxOffset;
+		// space freed by unloaded models is reused, the buffers only grow when nothing free is big enough
+		model->indexRange = g_GlobalMeshBuffers.IdxRanges.AllocateOrGrow(model->indicesCount);
+		model->vertexRange = g_GlobalMeshBuffers.VtxRanges.AllocateOrGrow(model->vertexCount);
+		OO_ASSERT(model->indexRange.offset != MeshRangeAllocator::NO_SPACE && model->vertexRange.offset != MeshRangeAllocator::NO_SPACE);
+	
+		g_GlobalMeshBuffers.IdxBuffer.addWriteCommand(model->indicesCount, indices.data() + model->baseIndices, model->indexRange.offset);
+#if PACKED_VERTEX_FORMAT
+		std::vector<oGFX::PackedVertex> packed(model->vertexCount);
+		oGFX::VertexPacking::Pack(vertex.data() + model->baseVertex, model->vertexCount, model->positionDequant, packed.data());
+		g_GlobalMeshBuffers.VtxBuffer.addWriteCommand(model->vertexCount, packed.data(), model->vertexRange.offset);
+#else
+		g_GlobalMeshBuffers.VtxBuffer.addWriteCommand(model->vertexCount, vertex.data() + model->baseVertex, model->vertexRange.offset);
+#endif
+
+		model->baseIndices = model->indexRange.offset;
+		model->baseVertex = model->vertexRange.offset;
+
+		// meshlets point at their vertices and triangles through global offsets, the vertices stay relative to the submesh
+		auto& clusters = model->cpuModel->meshlets;
+		model->meshletRange = g_GlobalMeshlets.MeshletRanges.AllocateOrGrow(static_cast<uint32_t>(clusters.meshlets.size()));
+		model->meshletVertexRange = g_GlobalMeshlets.VertexRanges.AllocateOrGrow(static_cast<uint32_t>(clusters.vertices.size()));
+		model->meshletTriangleRange = g_GlobalMeshlets.TriangleRanges.AllocateOrGrow(static_cast<uint32_t>(clusters.triangles.size()));
+		if (clusters.meshlets.size())
+		{
+			std::vector<GPUMeshlet> meshlets(clusters.meshlets);
+			for (GPUMeshlet& m : meshlets)
+			{
+				m.vertexOffset += model->meshletVertexRange.offset;
+				m.triangleOffset += model->meshletTriangleRange.offset;
+			}
+			g_GlobalMeshlets.Meshlets.addWriteCommand(meshlets.size(), meshlets.data(), model->meshletRange.offset);
+			g_GlobalMeshlets.Vertices.addWriteCommand(clusters.vertices.size(), clusters.vertices.data(), model->meshletVertexRange.offset);
+			g_GlobalMeshlets.Triangles.addWriteCommand(clusters.triangles.size(), clusters.triangles.data(), model->meshletTriangleRange.offset);
+		}
 
 		for (size_t i = 0; i < model->m_subMeshes.size(); i++)
 		{
 			SubMesh& sm = g_globalSubmesh[model->m_subMeshes[i]];
 			sm.baseVertex += model->baseVertex;		
 			sm.baseIndices += model->baseIndices;
+			sm.meshletOffset += model->meshletRange.offset;
 		}
 
-		g_GlobalMeshBuffers.IdxOffset += model->indicesCount;
-		g_GlobalMeshBuffers.VtxOffset += model->vertexCount;
-
 		if (model->skeleton)
 		{
 			auto& sk = model->skeleton;
@@ -4312,223 +4218,33 @@ ModelFileResource* VulkanRenderer::LoadMeshFromBuffers(
 			memcpy(this->g_skinningBoneWeights.data() + model->skinningWeightsOffset
 				, sk->boneWeights.data()
 				, sk->boneWeights.size() * sizeof(BoneWeight));
-			
+		
 			gpuSkinningWeightsBuffer.addWriteCommand(sk->boneWeights.size(), sk->boneWeights.data(), model->skinningWeightsOffset);
-			
+		
 		}
-	};
-
-	{
-		std::scoped_lock s{ g_mut_workQueue };
-		g_workQueue.emplace_back(lam);
 	}
-
-	return m;
 }
 
-void VulkanRenderer::LoadBoneInformation(ModelFileResource& fileData,
-	oGFX::Skeleton& skeleton,
-	aiMesh& aimesh,
-	std::vector<BoneWeight>& boneWeights,
-	uint32_t& vCnt
-)
-{
-	uint32_t numBones = 0;
-	std::stringstream ss;
-	for (size_t i = 0; i < aimesh.mNumBones; i++)
-	{
-		auto& currBone = aimesh.mBones[i];
-		uint32_t boneIndex = 0;
-		std::string boneName = currBone->mName.C_Str();
-
-
-		if (fileData.strToBone.find(boneName) == fileData.strToBone.end())
-		{
-			// bone doesnt exist, allocate
-			boneIndex = numBones++;
-
-			oGFX::BoneInverseBindPoseInfo& invBindPoseInfo = skeleton.inverseBindPose.emplace_back(oGFX::BoneInverseBindPoseInfo{});
-
-			// Map the name of this bone to this index. (map<string,int>)
-			fileData.strToBone[boneName] = boneIndex;
-
-			// Setup information
-			// TODO: quaternions?
-			invBindPoseInfo.transform = aiMat4_to_glm(currBone->mOffsetMatrix);
-			invBindPoseInfo.boneIdx = boneIndex;
-		}
-		else
-		{
-			// bone already exists!
-			boneIndex = fileData.strToBone[boneName];
-		}
-
-		// Add the bone weights for the vertices for the current bone
-		for (size_t j = 0; j < currBone->mNumWeights; ++j)
-		{
-			const unsigned vertexID = currBone->mWeights[j].mVertexId + vCnt;
-			const float weight = currBone->mWeights[j].mWeight;
-
-			bool success = false;
-
-			auto& vertex = boneWeights[vertexID];
-			for (int slot = 0; slot < 4; ++slot)
-			{
-				if (vertex.boneIdx[slot] == boneIndex && boneIndex != 0) {
-					success = true;
-					break;
-				}
-
-				if (vertex.boneWeights[slot] == 0.0f)
-				{
-					vertex.boneIdx[slot] = boneIndex;
-					vertex.boneWeights[slot] = weight;
-					success = true;
-					break;
-				}
-			}
-#define NORMALIZE_BONE_WEIGHTS
-
-			// Check if the number of weights is >4, just in case, since we dont support
-			if (!success)
-			{
-				
-				
-				float sum;
-#ifdef NORMALIZE_BONE_WEIGHTS
-				uint32_t minBone = boneIndex;
-				float minW = weight;
-				for (size_t i = 0; i < 4; i++)
-				{
-					if (vertex.boneWeights[i] < minW)
-					{
-						std::swap(vertex.boneWeights[i], minW);
-						std::swap(vertex.boneIdx[i], minBone);
-					}
-				}
-				sum = 0.0f;
-				for (size_t i = 0; i < 4; i++)
-				{
-					sum += vertex.boneWeights[i];
-				}
-				for (size_t i = 0; i < 4; i++)
-				{
-					vertex.boneWeights[i]*= (1.0f/sum);
-				}
-				sum = 0.0f;
-				for (auto&[key,val] :  fileData.strToBone)
-				{
-					if (val == minBone)
-					{
-						ss << "Discarded weight: [" << key<<",\t"<< minW << "]" << std::endl;
-						break;
-					}
-				}
-				for (size_t i = 0; i < 4; i++)
-				{
-					sum += vertex.boneWeights[i];
-				}
-				//std::cout << "Final sum : [" << sum<< "]"<<std::endl;
-
-#else
-				//dump bone names
-				std::cout << "Dumping bones...\n";
-				std::cout << "Bone affected : " << currBone->mName.C_Str() << ",\t" << weight<< std::endl;
-				for (size_t i = 0; i < 4; i++)
-				{
-					for (auto&[key,val] :  fileData.strToBone)
-					{
-						if (val == vertex.boneIdx[i])
-						{
-							std::cout << "Bone affected : " << key << ",\t"<<vertex.boneWeights[i] << std::endl;
-							break;
-						}
-					}
-				}				
-				// Vertex already has 4 bone weights assigned.
-				assert(false && "Bone weights >4 is not supported.");
-#endif // NORMALIZE_BONE_WEIGHTS
-			}
-		}
-
-	} // end bone for
-	vCnt += aimesh.mNumVertices;
-}
-
-void VulkanRenderer::BuildSkeletonRecursive(ModelFileResource& fileData, aiNode* ainode, oGFX::BoneNode* parent, glm::mat4 parentXform,std::string prefix)
+const oGFX::Skeleton* VulkanRenderer::GetSkeleton(uint32_t modelID)
 {
-	std::string node_name{ ainode->mName.data };
-	//std::stringstream ss;
-	// TODO: quat ?
-	glm::mat4x4 node_transform = parentXform * aiMat4_to_glm(ainode->mTransformation);
-	oGFX::BoneNode* targetParent = parent;
-	std::string cName = node_name.substr(node_name.find_last_of("_") + 1);
-	oGFX::BoneNode* node = parent;
-
-	//std::cout << "Loading " << node_name << std::endl;
-
-	// Save the bone index
-	bool bIsBoneNode = false;
-	auto iter = fileData.strToBone.find(node_name);
-	if (iter != fileData.strToBone.end())
-	{
-		//ss <<prefix<< "Creating bone " << node_name << std::endl;
-		prefix += '\t';
-		bIsBoneNode = true;
-		node = new oGFX::BoneNode;
-		node->mbIsBoneNode = true;
-		node->mName = node_name;
-		node->mpParent = targetParent;
-		node->mModelSpaceLocal = node_transform;
-		node->mModelSpaceGlobal= node_transform;
-		node->m_BoneIndex = iter->second;
-		if (targetParent)
-		{
-			targetParent->mChildren.push_back(node);
-		}
-		targetParent = node;
-	}
-
-	// Leaving this here to check the scale
-	aiVector3D pos, scale;
-	aiQuaternion qua;
-	ainode->mTransformation.Decompose(scale, qua, pos);
-
-	if ((scale.x - scale.y) > 0.0001f || (scale.x - scale.z) > 0.0001f)
+	std::scoped_lock s{ g_mut_globalModels };
+	if (modelID < g_globalModels.size())
 	{
-		static bool firstTime = true;
-		if (firstTime)
-		{
-			// Non-uniform scale bone detected...
-			__debugbreak();
-			firstTime = false;
-		}
+		return g_globalModels[modelID].skeleton;
 	}
-
-	// Recursion through all children
-	for (size_t i = 0; i < ainode->mNumChildren; i++)
+	for (const PendingModel& pending : g_pendingModels)
 	{
-		if (bIsBoneNode)
-		{
-			// we have collapsed the transforms start for new local transform
-			BuildSkeletonRecursive(fileData, ainode->mChildren[i], targetParent,glm::mat4(1.0f),prefix);
-		}
-		else
+		if (pending.id == modelID)
 		{
-			BuildSkeletonRecursive(fileData, ainode->mChildren[i], targetParent,node_transform,prefix);
+			return pending.model.skeleton;
 		}
 	}
-	//std::cout << ss.str();
-}
-
-const oGFX::Skeleton* VulkanRenderer::GetSkeleton(uint32_t modelID)
-{
-	return g_globalModels[modelID].skeleton;
+	return nullptr;
 }
 
 oGFX::CPUSkeletonInstance* VulkanRenderer::CreateSkeletonInstance(uint32_t modelID)
 {
-	return oGFX::CreateCPUSkeleton(g_globalModels[modelID].skeleton);
+	return oGFX::CreateCPUSkeleton(GetSkeleton(modelID));
 }
 
 
@@ -4573,7 +4289,6 @@ uint32_t VulkanRenderer::CreateTexture(std::string fname, uint32_t width, uint32
 	fileData.h = height;
 	fileData.channels = 4;
 	fileData.dataSize = (size_t)fileData.w * (size_t)fileData.h * (size_t)fileData.channels * (size_t)fileFormat;
-	fileData.imgData.resize(fileData.dataSize);
 	fileData.generateMips = generateMips;
 	fileData.decodeType = FileImageData::ExtensionType::USER_DEFINED;
 	fileData.format = [fileFormat]{
@@ -4598,33 +4313,20 @@ uint32_t VulkanRenderer::CreateTexture(std::string fname, uint32_t width, uint32
 	copyRegion.imageExtent.depth = 1;
 	fileData.mipInformation.push_back(copyRegion);
 
-	memcpy(fileData.imgData.data(), imgData, fileData.dataSize);
-	//fileData.imgData = imgData;
-
-	// process if half float
+	// process if half float, converted straight from the caller's floats
 	if (fileFormat == 4) {
-		std::vector<uint8_t> processed;
-		processed.resize(fileData.imgData.size() / 2);
-		uint16_t* data = (uint16_t*)processed.data();
-		for (size_t i = 0; i < processed.size() / 2; i++)
-		{
-			float fltValue = *(float*)(fileData.imgData.data() + i * sizeof(float));
-			data[i] = oGFX::float_to_half(fltValue);
-		}
-		std::swap(fileData.imgData, processed);
 		fileData.dataSize /= 2; // data is halved
+		fileData.imgData.resize(fileData.dataSize);
+		oGFX::FloatsToHalf(imgData, fileData.imgData.data(), fileData.dataSize / sizeof(uint16_t));
 	}
-
-	auto ind = CreateTextureImage(fileData);
-	
-	auto lam = [this, ind]() {
-		UpdateBindlessGlobalTexture(ind);
-		};
+	else
 	{
-		std::scoped_lock s{ g_mut_workQueue };
-		g_workQueue.emplace_back(lam);
+		fileData.imgData.resize(fileData.dataSize);
+		memcpy(fileData.imgData.data(), imgData, fileData.dataSize);
 	}
 
+	auto ind = CreateTextureImage(std::move(fileData));
+
 	//return location of set with texture
 	return ind;
 
@@ -4633,15 +4335,8 @@ uint32_t VulkanRenderer::CreateTexture(std::string fname, uint32_t width, uint32
 uint32_t VulkanRenderer::CreateTexture(const std::string& file)
 {
 	// Create texture image and get its location in array
+	// the texture descriptor is written once the upload has completed
 	uint32_t textureImageLoc = LoadTextureData(file);
-	//create texture descriptor
-	auto lam = [this, textureImageLoc]() {
-		UpdateBindlessGlobalTexture(textureImageLoc);
-	};
-	{
-		std::scoped_lock s{ g_mut_workQueue };
-		g_workQueue.emplace_back(lam);
-	}
 
 	//return location of set with texture
 	return textureImageLoc;
@@ -4682,6 +4377,126 @@ void VulkanRenderer::UnloadTexture(uint32_t textureID)
 	constexpr bool delayDeletion = true;
 	texture.destroy(delayDeletion);
 	texture.isValid = false;
+
+	textureResidency.Unregister(textureID);
+	g_streamedTextureData.erase(textureID);
+}
+
+void VulkanRenderer::UnloadMeshResource(uint32_t modelID)
+{
+	gfxModel& model = g_globalModels[modelID];
+	if (model.vertexRange.node == MeshRangeAllocator::NO_SPACE)
+		return;
+
+	// frames in flight may still draw from the ranges
+	auto fun = [this, vtx = model.vertexRange, idx = model.indexRange
+		, meshlets = model.meshletRange, meshletVtx = model.meshletVertexRange, meshletTri = model.meshletTriangleRange]() {
+		std::scoped_lock s{ g_mut_globalMeshBuffers };
+		g_GlobalMeshBuffers.VtxRanges.Free(vtx);
+		g_GlobalMeshBuffers.IdxRanges.Free(idx);
+		// meshlet buffers only reuse their free ranges, they are not defragmented
+		g_GlobalMeshlets.MeshletRanges.Free(meshlets);
+		g_GlobalMeshlets.VertexRanges.Free(meshletVtx);
+		g_GlobalMeshlets.TriangleRanges.Free(meshletTri);
+
+		// the free space is scattered in pieces too small for the next model
+		auto scattered = [](const MeshRangeAllocator& ranges) {
+			return ranges.GetFragmentation() > 0.5f && ranges.GetReport().totalFree > ranges.GetCapacity() / 4;
+		};
+		if (scattered(g_GlobalMeshBuffers.VtxRanges) || scattered(g_GlobalMeshBuffers.IdxRanges))
+		{
+			RequestMeshDefragment();
+		}
+	};
+	DelayedDeleter::get()->DeleteAfterFrames(fun);
+
+	model.vertexRange = {};
+	model.indexRange = {};
+	model.meshletRange = {};
+	model.meshletVertexRange = {};
+	model.meshletTriangleRange = {};
+	model.vertexCount = 0;
+	model.indicesCount = 0;
+	// anything still pointing at the model draws nothing
+	for (uint32_t smID : model.m_subMeshes)
+	{
+		g_globalSubmesh[smID].vertexCount = 0;
+		g_globalSubmesh[smID].indicesCount = 0;
+		g_globalSubmesh[smID].meshletCount = 0;
+	}
+}
+
+void VulkanRenderer::RequestMeshDefragment()
+{
+	m_defragmentMeshBuffers = true;
+}
+
+void VulkanRenderer::DefragmentMeshBuffers()
+{
+	PROFILE_SCOPED();
+
+	std::scoped_lock s{ g_mut_globalMeshBuffers, g_mut_globalModels };
+	auto& meshBuffers = g_GlobalMeshBuffers;
+
+	auto cmd = GetCommandBuffer();
+	VK_NAME(m_device.logicalDevice, "DefragmentMesh", cmd);
+
+	// writes still waiting are at the old offsets, they go out first and move with the rest
+	if (meshBuffers.IdxBuffer.m_mustUpdate) meshBuffers.IdxBuffer.flushToGPU(cmd);
+	if (meshBuffers.VtxBuffer.m_mustUpdate) meshBuffers.VtxBuffer.flushToGPU(cmd);
+
+	VkMemoryBarrier barrier{ VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+	vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+	// packed into new buffers, moving in place would overlap source and destination
+	auto compact = [cmd](auto& buffer, MeshRangeAllocator& ranges) {
+		const auto moves = ranges.Compact();
+		const auto report = ranges.GetReport();
+
+		std::vector<VkBufferCopy> regions;
+		// ranges before the first move kept their offsets
+		const uint32_t kept = moves.empty() ? report.usedEnd : moves.front().dstOffset;
+		if (kept) regions.push_back(VkBufferCopy{ 0, 0, kept });
+		for (const auto& m : moves)
+		{
+			regions.push_back(VkBufferCopy{ m.srcOffset, m.dstOffset, m.size });
+		}
+
+		const uint32_t before = ranges.GetCapacity();
+		ranges.Shrink(report.usedEnd);
+		buffer.relocate(cmd, regions, ranges.GetCapacity());
+		return std::make_pair(before, ranges.GetCapacity());
+	};
+	const auto [vtxBefore, vtxAfter] = compact(meshBuffers.VtxBuffer, meshBuffers.VtxRanges);
+	const auto [idxBefore, idxAfter] = compact(meshBuffers.IdxBuffer, meshBuffers.IdxRanges);
+
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+	vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+		0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+	// submeshes keep their place inside the model
+	for (gfxModel& model : g_globalModels)
+	{
+		if (model.vertexRange.node == MeshRangeAllocator::NO_SPACE)
+			continue;
+
+		model.vertexRange.offset = meshBuffers.VtxRanges.GetOffset(model.vertexRange.node);
+		model.indexRange.offset = meshBuffers.IdxRanges.GetOffset(model.indexRange.node);
+		for (uint32_t smID : model.m_subMeshes)
+		{
+			SubMesh& sm = g_globalSubmesh[smID];
+			sm.baseVertex = sm.baseVertex - model.baseVertex + model.vertexRange.offset;
+			sm.baseIndices = sm.baseIndices - model.baseIndices + model.indexRange.offset;
+		}
+		model.baseVertex = model.vertexRange.offset;
+		model.baseIndices = model.indexRange.offset;
+	}
+
+	std::cout << "[DefragmentMeshBuffers] vertices " << vtxBefore << " -> " << vtxAfter
+		<< ", indices " << idxBefore << " -> " << idxAfter << std::endl;
 }
 
 VulkanRenderer::TextureInfo VulkanRenderer::GetTextureInfo(uint32_t handle)
@@ -4747,9 +4562,10 @@ void VulkanRenderer::UpdateUniformBuffers()
 	CB::FrameContextUBO frameContextUBO[2]{};
 	if (currWorld)
 	{
-		for (size_t i = 0; i < currWorld->numCameras; i++)
+		WorldSnapshot& snapshot = currWorld->RenderSnapshot();
+		for (size_t i = 0; i < snapshot.numCameras; i++)
 		{
-			auto& camera = currWorld->cameras[i];
+			auto& camera = snapshot.cameras[i];
 			
 			frameContextUBO[i].projection = camera.matrices.perspective;
 			frameContextUBO[i].view = camera.matrices.view;
@@ -4835,9 +4651,8 @@ uint32_t VulkanRenderer::LoadTextureData(const std::string& fileName)
 	//VkDeviceSize imageSize;
 	//unsigned char *imageData = oGFX::LoadTextureFromFile(fileName, width, height, imageSize);
 
-	auto value = CreateTextureImage(imageData);
+	auto value = CreateTextureImage(std::move(imageData));
 
-	imageData.Free();
 	return value;
 }
 
@@ -4857,11 +4672,12 @@ uint32_t VulkanRenderer::CreateCubeMapTexture(const std::string& folderName)
 	imageData.mipInformation.front().imageExtent = VkExtent3D{ 1,1,1 };
 #endif // OVERIDE_TEXTURE_SIZE_ONE
 
-	auto lam = [this, imageInfo = imageData, highVal = imageData.highestColValue]() {
+	// moved along to the render thread, the work queue holds copyable functions
+	auto lam = [this, imageInfo = std::make_shared<oGFX::FileImageData>(std::move(imageData))]() {
 
-		g_cubeMap.name = imageInfo.name;
-		g_cubeMap.highestColValue = highVal;
-		g_cubeMap.fromBuffer((void*)imageInfo.imgData.data(), imageInfo.dataSize, imageInfo.format, imageInfo.w, imageInfo.h, imageInfo.mipInformation, &m_device, m_device.graphicsQueue);
+		g_cubeMap.name = imageInfo->name;
+		g_cubeMap.highestColValue = imageInfo->highestColValue;
+		g_cubeMap.fromBuffer((void*)imageInfo->imgData.data(), imageInfo->dataSize, imageInfo->format, imageInfo->w, imageInfo->h, imageInfo->mipInformation, &m_device, m_device.graphicsQueue);
 		// dont generate for now
 		GenerateMipmaps(g_cubeMap);
 
@@ -4874,21 +4690,21 @@ uint32_t VulkanRenderer::CreateCubeMapTexture(const std::string& folderName)
 
 		GenerateMipmaps(g_radianceMap);
 
+		imageInfo->Free();
 		};
 	{
 		std::scoped_lock s{ g_mut_workQueue };
-		g_workQueue.emplace_back(lam);
+		g_workQueue.emplace_back(std::move(lam));
 	}
 	
-	imageData.Free();
 	return 0;
 }
 
-uint32_t VulkanRenderer::CreateTextureImage(const oGFX::FileImageData& imageInfo)
+uint32_t VulkanRenderer::CreateTextureImage(oGFX::FileImageData&& imageInfo)
 {
 	VkDeviceSize imageSize = imageInfo.dataSize;
 	OO_ASSERT(imageInfo.dataSize);
-	totalTextureSizeLoaded += imageSize;
+	totalTextureSizeLoaded.fetch_add(imageSize);
 
 	auto indx = [this]{
 		// mutex
@@ -4905,28 +4721,122 @@ uint32_t VulkanRenderer::CreateTextureImage(const oGFX::FileImageData& imageInfo
 		return indx;
 	}();
 
-	auto lam = [this, indx, imageInfo]() {
-		auto& texture = g_Textures[indx];
+	// large 8 bit textures build their mips here, only the coarse ones are uploaded until the texture is seen up close
+	const bool streamed = imageInfo.decodeType == oGFX::FileImageData::ExtensionType::STB && imageInfo.format == VK_FORMAT_R8G8B8A8_UNORM
+		&& imageInfo.generateMips && static_cast<uint32_t>(std::max(imageInfo.w, imageInfo.h)) > TEXTURE_STREAMING_TAIL;
+	if (streamed)
+	{
+		auto chain = std::make_shared<oGFX::FileImageData>(std::move(imageInfo));
+		chain->GenerateMipChain();
 
-		texture.name = imageInfo.name;
-		texture.fromBuffer((void*)imageInfo.imgData.data(), imageInfo.dataSize, imageInfo.format, imageInfo.w, imageInfo.h,imageInfo.mipInformation, &m_device, m_device.graphicsQueue);
+		auto lam = [this, indx, chain]() {
+			uint32_t tailMip = 0;
+			std::vector<uint64_t> mipBytes(chain->mipInformation.size());
+			for (size_t m = 0; m < mipBytes.size(); m++)
+			{
+				const VkBufferImageCopy& region = chain->mipInformation[m];
+				const VkDeviceSize end = m + 1 < mipBytes.size() ? chain->mipInformation[m + 1].bufferOffset : chain->dataSize;
+				mipBytes[m] = end - region.bufferOffset;
+				if (std::max(region.imageExtent.width, region.imageExtent.height) > TEXTURE_STREAMING_TAIL)
+				{
+					tailMip = static_cast<uint32_t>(m + 1);
+				}
+			}
+			g_Textures[indx].name = chain->name;
+			textureResidency.Register(indx, static_cast<uint32_t>(std::max(chain->w, chain->h)), std::move(mipBytes), tailMip);
+			g_streamedTextureData[indx] = std::move(*chain);
+			StreamTextureMips(indx, tailMip);
+		};
+		std::scoped_lock s{ g_mut_workQueue };
+		g_workQueue.emplace_back(std::move(lam));
+		return static_cast<uint32_t>(indx);
+	}
 
-		if (imageInfo.generateMips == true) {
-			GenerateMipmaps(texture);
-		}
-		//setup imgui binding
-		g_imguiIDs[indx] = CreateImguiBinding(samplerManager.GetDefaultSampler(), &texture);
-		
+	// staged here on the loading thread and the pixels freed, the render thread only creates the image and records the copy
+	const oGFX::TextureUploader::Staging staging = m_device.textureUploader.Stage(imageInfo.imgData.data(), imageInfo.dataSize);
+	imageInfo.Free();
+
+	auto lam = [this, indx, staging, imageInfo = std::make_shared<oGFX::FileImageData>(std::move(imageInfo))]() {
+		auto& texture = g_Textures[indx];
+
+		texture.name = imageInfo->name;
+		// batched with the other uploads of the frame, draws use the fallback textures until it lands.
+		// The mips are blitted in the same batch, it is published once they are done
+		auto onUploaded = [this, indx](VkImage image) {
+			auto& texture = g_Textures[indx];
+			if (texture.image.image != image)
+				return; // unloaded while the upload was in flight
+
+			//setup imgui binding
+			g_imguiIDs[indx] = CreateImguiBinding(samplerManager.GetDefaultSampler(), &texture);
+			UpdateBindlessGlobalTexture(indx);
+		};
+		texture.fromBufferAsync(staging, imageInfo->format, imageInfo->w, imageInfo->h, imageInfo->mipInformation, &m_device, onUploaded,
+			VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT, imageInfo->generateMips);
 	};
 	{
 		std::scoped_lock s{ g_mut_workQueue };
-		g_workQueue.emplace_back(lam);
+		g_workQueue.emplace_back(std::move(lam));
 	}
 
 	// Return index of new texture image
 	return static_cast<uint32_t>(indx);
 }
 
+void VulkanRenderer::StreamTextureMips(uint32_t textureID, uint32_t mip)
+{
+	const oGFX::FileImageData& data = g_streamedTextureData.at(textureID);
+
+	// the range goes up on its own, offsets and levels relative to its finest mip
+	std::vector<VkBufferImageCopy> regions(data.mipInformation.begin() + mip, data.mipInformation.end());
+	const VkDeviceSize base = regions.front().bufferOffset;
+	for (VkBufferImageCopy& region : regions)
+	{
+		region.bufferOffset -= base;
+		region.imageSubresource.mipLevel -= mip;
+	}
+
+	auto next = std::make_shared<vkutils::Texture2D>();
+	next->name = data.name;
+	const VkExtent3D extent = regions.front().imageExtent;
+	next->fromBufferAsync(data.imgData.data() + base, data.dataSize - base, data.format, extent.width, extent.height, regions, &m_device,
+		[this, textureID, mip, next](VkImage) {
+			if (textureResidency.IsStreamed(textureID) == false)
+			{
+				next->destroy(true); // unloaded while the upload was in flight
+				return;
+			}
+
+			auto& texture = g_Textures[textureID];
+			const bool firstUpload = texture.image.image == VK_NULL_HANDLE;
+			if (firstUpload == false)
+			{
+				// frames in flight may still sample the old range
+				texture.destroy(true);
+			}
+			texture = *next;
+			if (firstUpload)
+			{
+				// imgui looks the view up through the texture, the binding survives the swaps
+				g_imguiIDs[textureID] = CreateImguiBinding(samplerManager.GetDefaultSampler(), &texture);
+			}
+			UpdateBindlessGlobalTexture(textureID);
+			textureResidency.Complete(textureID, mip);
+		});
+}
+
+void VulkanRenderer::UpdateTextureStreaming()
+{
+	PROFILE_SCOPED();
+
+	// acts on the mips the batches asked for last frame
+	textureResidency.Update(currentFrame, m_residencyChanges);
+	for (const oGFX::TextureResidency::Change& change : m_residencyChanges)
+	{
+		StreamTextureMips(change.textureID, change.toMip);
+	}
+}
+
 OO_OPTIMIZE_OFF
 VkPipelineShaderStageCreateInfo VulkanRenderer::LoadShader(VulkanDevice& device,const std::string& fileName, VkShaderStageFlagBits stage)
 {
@@ -4938,7 +4848,7 @@ VkPipelineShaderStageCreateInfo VulkanRenderer::LoadShader(VulkanDevice& device,
 
 	//build shader modules to link to pipeline
 	//read in SPIR-V code of shaders
-	auto shaderCode = oGFX::readFile(fileName);
+	const std::vector<char>& shaderCode = VulkanRenderer::get()->pipelineCache.GetShaderCode(fileName);
 	VkShaderModule shaderModule = oGFX::CreateShaderModule(device,shaderCode);
 	VK_NAME(device.logicalDevice, fileName.c_str(), shaderModule);
 
@@ -4976,15 +4886,15 @@ void VulkanRenderer::InitDefaultPrimatives()
 {
 	{
 		DefaultMesh dm = CreateDefaultCubeMesh();
-		def_cube.reset(LoadMeshFromBuffers(dm.m_VertexBuffer, dm.m_IndexBuffer, nullptr));
+		def_cube.reset(LoadMeshFromBuffers(dm.m_VertexBuffer, dm.m_IndexBuffer));
 	}
 	{
 		DefaultMesh pm = CreateDefaultPlaneXZMesh();
-		def_plane.reset(LoadMeshFromBuffers(pm.m_VertexBuffer, pm.m_IndexBuffer, nullptr));
+		def_plane.reset(LoadMeshFromBuffers(pm.m_VertexBuffer, pm.m_IndexBuffer));
 	}
 	{
 		DefaultMesh sm = CreateDefaultPlaneXYMesh();
-		def_sprite.reset(LoadMeshFromBuffers(sm.m_VertexBuffer, sm.m_IndexBuffer, nullptr));
+		def_sprite.reset(LoadMeshFromBuffers(sm.m_VertexBuffer, sm.m_IndexBuffer));
 	}
 	{
 		def_font.reset(LoadFont("defaultAsset/Roboto-Medium.ttf"));
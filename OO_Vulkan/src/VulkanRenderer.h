@@ -33,6 +33,12 @@ Technology is prohibited.
 #include "DescriptorAllocator.h"
 #include "DescriptorLayoutCache.h"
 #include "FramebufferCache.h"
+#include "RGTransientPool.h"
+#include "PipelineCache.h"
+#include "TextureResidency.h"
+#include "ModelImporter.h"
+#include "ShardedRegistry.h"
+#include "GPUSceneSlots.h"
 #include "Geometry.h"
 #include "Collision.h"
 
@@ -61,6 +67,8 @@ Technology is prohibited.
 #include <deque>
 #include <functional>
 #include <memory>
+#include <future>
+#include <atomic>
 
 // dlss
 #include "NGXWrapper.h"
@@ -254,6 +262,11 @@ public:
 
 	static VulkanRenderer* s_vulkanRenderer;
 	static constexpr int MAX_FRAME_DRAWS = 2;
+	static constexpr VkDeviceSize STAGING_RING_SIZE = 32ull * 1024 * 1024;
+	static constexpr VkDeviceSize TEXTURE_STREAMING_BUDGET = 512ull * 1024 * 1024;
+	static constexpr VkDeviceSize TEXTURE_STREAMING_UPLOAD_PER_FRAME = 16ull * 1024 * 1024;
+	// textures larger than this load their coarse mips up to this size first and stream the finer ones
+	static constexpr uint32_t TEXTURE_STREAMING_TAIL = 128;
 
 	struct Attachments {
 		std::array<vkutils::Texture2D, GBufferAttachmentIndex::MAX_ATTACHMENTS> gbuffer{};
@@ -298,7 +311,7 @@ public:
 		vkutils::Texture2D xegtao_workingAOTermPong;
 	}attachments;
 
-	inline static uint64_t totalTextureSizeLoaded = 0;
+	inline static std::atomic<uint64_t> totalTextureSizeLoaded{ 0 };
 
 	static constexpr int MAX_OBJECTS = 2048;
 	static constexpr VkFormat G_DEPTH_FORMAT = VK_FORMAT_D24_UNORM_S8_UINT;
@@ -324,6 +337,8 @@ public:
 	bool Init(const oGFX::SetupInfo& setupSpecs, Window& window);
 	
 	void ReloadShaders();
+	// Builds the pipelines the last run built on demand, see PipelineCache
+	void WarmupPipelines();
 
 	void CreateInstance(const oGFX::SetupInfo& setupSpecs);
 	void CreateDebugCallback();
@@ -354,7 +369,7 @@ public:
 	std::vector<VkCommandBuffer>sequencedBuffers;
 	std::queue<Task>m_taskList;
 	std::vector<Task>m_sequentialTasks;
-	TaskCompletionCallback drawCallRecordingCompleted{ Task([](void*) {}) };
+	TaskCounter drawCallRecordingCompleted;
 	void AddRenderer(GfxRenderpass* pass);
 	
 	ImTextureID myImg{};
@@ -402,6 +417,12 @@ public:
 	int32_t m_numShadowcastLights{0};
 	uint32_t renderTargetInUseID{ 0 };
 	float renderClock{ 0.0f };
+	float startupTimeMs{ 0.0f };
+	// last startup without and with a usable pipeline cache, kept across runs in startup_times.txt
+	float coldStartupTimeMs{ 0.0f };
+	float warmStartupTimeMs{ 0.0f };
+	// the busiest frame's descriptor sets, see DescriptorAllocator::Stats
+	DescriptorAllocator::Stats peakDescriptorStats;
 	float deltaTime{ 0.0016f };
 
 	int32_t GetPixelValue(uint32_t fbID, glm::vec2 uv);
@@ -470,6 +491,10 @@ public:
 
 	bool ReloadTexture(uint32_t textureID, const std::string& file);
 	void UnloadTexture(uint32_t textureID);
+	// Gives the model's part of the global mesh buffers back once the frames in flight are done with it
+	void UnloadMeshResource(uint32_t modelID);
+	// Packs the global mesh buffers at the start of the next frame
+	void RequestMeshDefragment();
 	void GenerateMipmaps(vkutils::Texture& texture);
 	void GenerateRadianceMap(VkCommandBuffer cmdlist , vkutils::CubeTexture& texture);
 	void GeneratePrefilterMap(VkCommandBuffer cmdlist , vkutils::CubeTexture& texture);
@@ -494,14 +519,26 @@ public:
 	// This naming is rather confusing... VertexBufferObject but it contains an index buffer inside?
 	struct IndexedVertexBuffer
 	{
-		GpuVector<oGFX::Vertex> VtxBuffer;
+		GpuVector<oGFX::GpuVertex> VtxBuffer;
 		GpuVector<uint32_t> IdxBuffer;
-		uint32_t VtxOffset{};
-		uint32_t IdxOffset{};
+		MeshRangeAllocator VtxRanges;
+		MeshRangeAllocator IdxRanges;
+	};
+
+	// Clusters of the submeshes for culling finer than a draw, see MeshletBuilder.h
+	struct MeshletBuffer
+	{
+		GpuVector<GPUMeshlet> Meshlets;
+		GpuVector<uint32_t> Vertices;
+		GpuVector<uint32_t> Triangles;
+		MeshRangeAllocator MeshletRanges;
+		MeshRangeAllocator VertexRanges;
+		MeshRangeAllocator TriangleRanges;
 	};
 
 	std::mutex g_mut_globalMeshBuffers;
 	IndexedVertexBuffer g_GlobalMeshBuffers;
+	MeshletBuffer g_GlobalMeshlets;
 
 	GpuVector<ParticleData> g_particleDatas;
 	GpuVector<oGFX::IndirectCommand> g_particleCommandsBuffer;
@@ -519,11 +556,23 @@ public:
 	ModelFileResource* GetDefaultCube();
 	oGFX::Font* GetDefaultFont();
 
+	// Blocks the caller, the submeshes are converted on the task manager's threads meanwhile.
+	// A current cooked copy of the file is read instead when there is one, see CookedModel.h
 	ModelFileResource* LoadModelFromFile(const std::string& file);
-	ModelFileResource* LoadMeshFromBuffers(std::vector<oGFX::Vertex>& vertex, std::vector<uint32_t>& indices, gfxModel* model);
-	void LoadSubmesh(gfxModel& mdl, SubMesh& submesh, aiMesh* aimesh, ModelFileResource* modelFile);
-	void LoadBoneInformation(ModelFileResource& fileData, oGFX::Skeleton& skeleton, aiMesh& aimesh, std::vector<BoneWeight>& boneWeights, uint32_t& vCnt);
-	void BuildSkeletonRecursive(ModelFileResource& fileData, aiNode* ainode, oGFX::BoneNode* node, glm::mat4 parentXform = glm::mat4(1.0f), std::string prefix = std::string("\t"));
+	// Imports on the task manager's threads and decodes the material textures. As with LoadModelFromFile the
+	// vertices and indices go to the GPU with the rest of the next frame's buffer writes.
+	std::future<ModelFileResource*> LoadModelFromFileAsync(const std::string& file, bool loadTextures = true);
+	// Decodes the materials' textures in parallel and fills in their ids, a file used by several materials loads once
+	void LoadModelTextures(ModelFileResource* model);
+	ModelFileResource* LoadMeshFromBuffers(std::vector<oGFX::Vertex>& vertex, std::vector<uint32_t>& indices);
+	// Any thread. Hands a loaded model to the render thread and returns the id it gets in g_globalModels
+	uint32_t QueueModel(gfxModel&& model, std::vector<SubMesh>&& submeshes);
+	// Render thread, through the work queue. Adds the queued models and writes their meshes to the global buffers
+	void PublishModels();
+	// Render thread, a snapshot can hold objects of a model queued after the last publish
+	bool IsModelPublished(uint32_t modelID) const { return modelID < g_globalModels.size(); }
+	void DefragmentMeshBuffers();
+	// Any thread, also for models still waiting to be published
 	const oGFX::Skeleton* GetSkeleton(uint32_t modelID);
 	oGFX::CPUSkeletonInstance* CreateSkeletonInstance(uint32_t modelID);
 
@@ -577,6 +626,9 @@ public:
 	//textures
 	std::mutex g_mut_Textures;
 	std::vector<vkutils::Texture2D> g_Textures;
+	// every mip of the streamed textures, the finer ones are uploaded from here when they are wanted
+	std::unordered_map<uint32_t, oGFX::FileImageData> g_streamedTextureData;
+	oGFX::TextureResidency textureResidency;
 
 	vkutils::CubeTexture g_cubeMap;
 	vkutils::CubeTexture g_radianceMap;
@@ -624,6 +676,7 @@ public:
 	uint32_t indirectDrawCount{};
 
 	GpuVector<LocalLightInstance> globalLightBuffer;
+	GpuVector<glm::vec4> shadowTileBuffer; // atlas uv rect of each shadow grid index
 
 	// - Descriptors
 
@@ -640,18 +693,17 @@ public:
 	std::vector<BoneWeight> g_skinningBoneWeights;
 	GpuVector<BoneWeight> gpuSkinningWeightsBuffer;
 
-	// SSBO
+	// Upload state of every object's slot in the GPU scene buffers
+	GPUSceneSlots gpuSceneSlots;
+	std::vector<GPUSceneSlots::Range> gpuSceneRanges;
+
+	// SSBO, CPU copy of every slot
 	std::vector<GPUTransform> gpuTransform{};
 	GpuVector<GPUTransform> gpuTransformBuffer;
-	
-	// SSBO
-	std::vector<GPUTransform> gpuShadowCasterTransform{};
-	GpuVector<GPUTransform> gpuShadowCasterTransformBuffer;
 
-	// SSBO
+	// SSBO, CPU copy of every slot
 	std::vector<GPUObjectInformation> objectInformation;
 	GpuVector<GPUObjectInformation> objectInformationBuffer;
-	GpuVector<GPUObjectInformation> casterObjectInformationBuffer;
 	
 	// SSBO
 	std::vector<oGFX::AllocatedBuffer> vpUniformBuffer{};
@@ -672,10 +724,14 @@ public:
 	std::vector<DescriptorAllocator> descAllocs;
 	DescriptorLayoutCache DescLayoutCache;
 
-	std::unordered_map<size_t, VkPipelineLayout> pipelineLayoutMap;
-	std::unordered_map<size_t, VkPipeline> pipelineMap;
+	// pipelines the command lists build on demand, recording threads share them
+	ShardedRegistry<VkPipelineLayout> pipelineLayoutMap;
+	ShardedRegistry<VkPipeline> pipelineMap;
+	PipelineCache pipelineCache;
+	TaskCounter pipelineWarmup;
 
 	FramebufferCache fbCache;
+	RGTransientPool transientPool;
 
 	GfxSamplerManager samplerManager;
 
@@ -683,8 +739,18 @@ public:
 
 	//Scene objects
 	std::mutex g_mut_globalModels;
+	// Only added to on the render thread, see PublishModels. Other threads lock g_mut_globalModels to read them.
 	std::vector<gfxModel> g_globalModels;
 	std::vector<SubMesh> g_globalSubmesh;
+	// Loaded with their id reserved, waiting for the render thread to add them
+	struct PendingModel
+	{
+		uint32_t id{};
+		gfxModel model;
+		std::vector<SubMesh> submeshes;
+	};
+	std::vector<PendingModel> g_pendingModels;
+	uint32_t g_numModelIDs{};
 
 	std::mutex g_mut_workQueue;
 	std::vector<std::function<void()>> g_workQueue;
@@ -710,6 +776,7 @@ public:
 	bool resizeSwapchain = false;
 	bool m_prepared = false;
 	bool m_reloadShaders = false;
+	bool m_defragmentMeshBuffers = false;
 	bool m_restartIMGUI = false;
 	bool m_dumpRenderpassInfo = false;
 
@@ -718,6 +785,8 @@ public:
 	std::unordered_map<std::thread::id, uint32_t> g_taskManagerMapping;
 	uint32_t mappedThreadCnt{};
 	uint32_t RegisterThreadMapping();
+	// Index of the calling thread's command and descriptor pools, without a lock once the thread is registered
+	uint32_t GetThreadMapping();
 
 	// These variables area only to speedup development time by passing adjustable values from the C++ side to the shader.
 	// Bind this to every single shader possible.
@@ -786,10 +855,15 @@ public:
 
 	static VkPipelineShaderStageCreateInfo LoadShader(VulkanDevice& device, const std::string& fileName, VkShaderStageFlagBits stage);
 	private:
-		uint32_t CreateTextureImage(const oGFX::FileImageData& imageInfo);		
+		// Takes the pixels over, they are moved to the upload and never copied on the way
+		uint32_t CreateTextureImage(oGFX::FileImageData&& imageInfo);		
 		uint32_t LoadTextureData(const std::string& fileName);
 		
 		uint32_t UpdateBindlessGlobalTexture(uint32_t textureID);		
+		// Recreates a streamed texture holding its mips from mip on, it is swapped in once the upload lands
+		void StreamTextureMips(uint32_t textureID, uint32_t mip);
+		void UpdateTextureStreaming();
+		std::vector<oGFX::TextureResidency::Change> m_residencyChanges;
 
 		bool shadowsRendered{ false };
 
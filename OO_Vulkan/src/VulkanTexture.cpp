@@ -120,10 +120,8 @@ namespace vkutils
 		return localView;
 	}
 
-	void Texture::AllocateImageMemory(VulkanDevice* device, const VkImageUsageFlags& imageUsageFlags, uint32_t mips)
+	VkImageCreateInfo Texture::GetImageCreateInfo(const VkImageUsageFlags& imageUsageFlags) const
 	{
-		mipLevels = mips;
-
 		VkImageCreateFlags        imageCreationFlags = [texType = this->type]()->VkImageCreateFlags {
 			switch (texType)
 			{
@@ -154,7 +152,14 @@ namespace vkutils
 			imageCreateInfo.usage |= VK_IMAGE_USAGE_TRANSFER_DST_BIT;
 			imageCreateInfo.usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
 		}
+		return imageCreateInfo;
+	}
+
+	void Texture::AllocateImageMemory(VulkanDevice* device, const VkImageUsageFlags& imageUsageFlags, uint32_t mips)
+	{
+		mipLevels = mips;
 
+		VkImageCreateInfo imageCreateInfo = GetImageCreateInfo(imageUsageFlags);
 
 		VmaAllocationCreateInfo allocCI{};
 		allocCI.flags = VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT;
@@ -170,6 +175,29 @@ namespace vkutils
 		VK_NAME(device->logicalDevice, name.empty() ? "AllocateImage" : name.c_str(), image.image);
 	}
 
+	void Texture::AliasImageMemory(VmaAllocation memory, VkDeviceSize offset)
+	{
+		OO_ASSERT(device && memory);
+
+		// the old image has to be idle, its own memory goes with it
+		vkDestroyImageView(device->logicalDevice, view, nullptr);
+		vmaDestroyImage(device->m_allocator, image.image, image.allocation);
+		view = VK_NULL_HANDLE;
+		image.allocation = VK_NULL_HANDLE;
+		image.allocationInfo = {};
+
+		const VkImageCreateInfo imageCreateInfo = GetImageCreateInfo(usage);
+		VkResult result = vmaCreateAliasingImage2(device->m_allocator, memory, offset, &imageCreateInfo, &image.image);
+		if (result != VK_SUCCESS)
+		{
+			std::cerr << "Failed to create a image! - " << oGFX::vkutils::tools::VkResultString(result) << std::endl;
+			__debugbreak();
+		}
+		VK_NAME(device->logicalDevice, name.empty() ? "AliasedImage" : name.c_str(), image.image);
+
+		CreateImageView();
+	}
+
 	/**
 	* Load a 2D texture including all mip levels
 	*
@@ -515,6 +543,57 @@ namespace vkutils
 		updateDescriptor();
 	}
 
+	uint64_t Texture2D::fromBufferAsync(const void* buffer, VkDeviceSize bufferSize, VkFormat _format,
+		uint32_t texWidth, uint32_t texHeight, const std::vector<VkBufferImageCopy>& mipInfo, VulkanDevice* device,
+		std::function<void(VkImage)> onComplete, VkImageLayout _imageLayout, VkImageUsageFlags imageUsageFlags, bool generateMips)
+	{
+		assert(buffer);
+		return fromBufferAsync(device->textureUploader.Stage(buffer, bufferSize), _format, texWidth, texHeight, mipInfo, device,
+			std::move(onComplete), _imageLayout, imageUsageFlags, generateMips);
+	}
+
+	uint64_t Texture2D::fromBufferAsync(const oGFX::TextureUploader::Staging& staging, VkFormat _format,
+		uint32_t texWidth, uint32_t texHeight, const std::vector<VkBufferImageCopy>& mipInfo, VulkanDevice* device,
+		std::function<void(VkImage)> onComplete, VkImageLayout _imageLayout, VkImageUsageFlags imageUsageFlags, bool generateMips)
+	{
+		this->device = device;
+		width = texWidth;
+		height = texHeight;
+		format = _format;
+		usage = imageUsageFlags;
+		aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		this->referenceLayout = _imageLayout;
+
+		uint32_t mips = static_cast<uint32_t>(mipInfo.size());
+		if (generateMips)
+		{
+			// formats that cannot be blitted keep the levels they came with
+			constexpr VkFormatFeatureFlags blitFeatures = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT
+				| VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+			VkFormatProperties formatProperties;
+			vkGetPhysicalDeviceFormatProperties(device->physicalDevice, _format, &formatProperties);
+			generateMips = (formatProperties.optimalTilingFeatures & blitFeatures) == blitFeatures;
+		}
+		if (generateMips)
+		{
+			mips = std::max(mips, (uint32_t)std::log2(std::max(texWidth, texHeight)) + 1u);
+		}
+
+		AllocateImageMemory(device, imageUsageFlags, mips);
+		CreateImageView();
+		updateDescriptor();
+
+		oGFX::TextureUploader::Upload upload;
+		upload.image = image.image;
+		upload.range = VkImageSubresourceRange{ aspectMask, 0, mipLevels, 0, layerCount };
+		upload.finalLayout = referenceLayout;
+		upload.regions = mipInfo;
+		upload.generateMips = generateMips;
+		return device->textureUploader.Enqueue(upload, staging, [onComplete = std::move(onComplete), uploaded = image.image]() {
+			if (onComplete) onComplete(uploaded);
+		});
+	}
+
 	void Texture2D::PrepareEmpty(VkFormat _format, uint32_t texWidth, uint32_t texHeight, VulkanDevice* device, VkImageLayout _imageLayout, VkFilter filter, VkImageUsageFlags imageUsageFlags)
 	{
 
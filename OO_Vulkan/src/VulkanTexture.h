@@ -18,6 +18,7 @@ Technology is prohibited.
 #include <string>
 #include <vector>
 #include <array>
+#include <functional>
 
 #include "vulkan/vulkan.h"
 #include "VmaUsage.h"
@@ -63,6 +64,9 @@ namespace vkutils
 		void CreateImageView();
 		VkImageView GenerateMipView(uint32_t desiredMip);
 		void AllocateImageMemory(VulkanDevice* device, const VkImageUsageFlags& imageUsageFlags, uint32_t mips = 1);
+		// Recreates the image inside memory shared with other transient images, the contents are lost
+		void AliasImageMemory(VmaAllocation memory, VkDeviceSize offset);
+		VkImageCreateInfo GetImageCreateInfo(const VkImageUsageFlags& imageUsageFlags) const;
 	};
 
 	inline glm::uvec2 GetMipDims(Texture& tex, uint32_t mip) {
@@ -101,6 +105,36 @@ namespace vkutils
 			VkImageUsageFlags imageUsageFlags = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT
 		);
 
+		// Creates the image and its view, the copy goes through the device's TextureUploader. The contents are
+		// undefined until onComplete runs, it gets the uploaded image so callers can tell if the texture still holds it.
+		// generateMips allocates the whole chain and the uploader blits the levels past the given ones, when the format can be blitted.
+		uint64_t fromBufferAsync(
+			const void* buffer,
+			VkDeviceSize bufferSize,
+			VkFormat format,
+			uint32_t texWidth,
+			uint32_t texHeight,
+			const std::vector<VkBufferImageCopy>& mips,
+			VulkanDevice* device,
+			std::function<void(VkImage)> onComplete,
+			VkImageLayout imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+			VkImageUsageFlags imageUsageFlags = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT,
+			bool generateMips = false
+		);
+		// Same with pixels already staged by TextureUploader::Stage, nothing is copied on the calling thread
+		uint64_t fromBufferAsync(
+			const oGFX::TextureUploader::Staging& staging,
+			VkFormat format,
+			uint32_t texWidth,
+			uint32_t texHeight,
+			const std::vector<VkBufferImageCopy>& mips,
+			VulkanDevice* device,
+			std::function<void(VkImage)> onComplete,
+			VkImageLayout imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+			VkImageUsageFlags imageUsageFlags = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT,
+			bool generateMips = false
+		);
+
 		void PrepareEmpty(VkFormat format,
 			uint32_t texWidth,
 			uint32_t texHeight,
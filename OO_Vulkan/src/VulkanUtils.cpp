@@ -35,6 +35,7 @@ Technology is prohibited.
 
 
 #include "VulkanUtils.h"
+#include "VertexPacking.h"
 #include "VulkanInstance.h"
 #include "VulkanDevice.h"
 #include "VulkanRenderer.h" // pfn
@@ -44,6 +45,7 @@ Technology is prohibited.
 #include <fstream>
 #include <vector>
 #include <filesystem>
+#include <cstdlib>
 
 namespace oGFX
 {
@@ -162,7 +164,7 @@ namespace oGFX
 	{
 	
 		static std::vector<VkVertexInputBindingDescription> bindingDescription {	
-			oGFX::vkutils::inits::vertexInputBindingDescription(BIND_POINT_VERTEX_BUFFER_ID,sizeof(Vertex),VK_VERTEX_INPUT_RATE_VERTEX),
+			oGFX::vkutils::inits::vertexInputBindingDescription(BIND_POINT_VERTEX_BUFFER_ID,sizeof(GpuVertex),VK_VERTEX_INPUT_RATE_VERTEX),
 			//oGFX::vkutils::inits::vertexInputBindingDescription(BIND_POINT_INSTANCE_BUFFER_ID,sizeof(oGFX::InstanceData),VK_VERTEX_INPUT_RATE_INSTANCE),
 		};
 		return bindingDescription;
@@ -172,11 +174,19 @@ namespace oGFX
 	const std::vector<VkVertexInputAttributeDescription>& GetGFXVertexInputAttributes()
 	{
 		static std::vector<VkVertexInputAttributeDescription>attributeDescriptions{
+#if PACKED_VERTEX_FORMAT
+		// decoded in vertex_input.shader, there is no colour
+		oGFX::vkutils::inits::vertexInputAttributeDescription(BIND_POINT_VERTEX_BUFFER_ID,0,VK_FORMAT_R16G16B16A16_UNORM,offsetof(PackedVertex, pos)), //Position attribute
+		oGFX::vkutils::inits::vertexInputAttributeDescription(BIND_POINT_VERTEX_BUFFER_ID,1,VK_FORMAT_R16G16_SNORM,offsetof(PackedVertex, norm)),//normals attribute
+		oGFX::vkutils::inits::vertexInputAttributeDescription(BIND_POINT_VERTEX_BUFFER_ID,3,VK_FORMAT_R16G16_SNORM,offsetof(PackedVertex, tangent)),//tangent attribute
+		oGFX::vkutils::inits::vertexInputAttributeDescription(BIND_POINT_VERTEX_BUFFER_ID,4,VK_FORMAT_R16G16_SFLOAT,offsetof(PackedVertex, tex)),    //Texture attribute
+#else
 		oGFX::vkutils::inits::vertexInputAttributeDescription(BIND_POINT_VERTEX_BUFFER_ID,0,VK_FORMAT_R32G32B32_SFLOAT,offsetof(Vertex, pos)), //Position attribute
 		oGFX::vkutils::inits::vertexInputAttributeDescription(BIND_POINT_VERTEX_BUFFER_ID,1,VK_FORMAT_R32G32B32_SFLOAT,offsetof(Vertex, norm)),//normals attribute
 		oGFX::vkutils::inits::vertexInputAttributeDescription(BIND_POINT_VERTEX_BUFFER_ID,2,VK_FORMAT_R32G32B32_SFLOAT,offsetof(Vertex, col)), // colour attribute
 		oGFX::vkutils::inits::vertexInputAttributeDescription(BIND_POINT_VERTEX_BUFFER_ID,3,VK_FORMAT_R32G32B32_SFLOAT,offsetof(Vertex, tangent)),//tangent attribute
 		oGFX::vkutils::inits::vertexInputAttributeDescription(BIND_POINT_VERTEX_BUFFER_ID,4,VK_FORMAT_R32G32_SFLOAT	  ,offsetof(Vertex, tex)),    //Texture attribute
+#endif
 	
 		// instance data attributes
 		//oGFX::vkutils::inits::vertexInputAttributeDescription(BIND_POINT_INSTANCE_BUFFER_ID,15,VK_FORMAT_R32G32B32A32_UINT,offsetof(InstanceData, InstanceData::instanceAttributes)),
@@ -661,6 +671,57 @@ namespace oGFX
 			});
 	}
 
+	PixelBuffer::~PixelBuffer()
+	{
+		clear();
+	}
+
+	PixelBuffer::PixelBuffer(PixelBuffer&& other) noexcept
+		: m_data{ other.m_data }
+		, m_size{ other.m_size }
+	{
+		other.m_data = nullptr;
+		other.m_size = 0;
+	}
+
+	PixelBuffer& PixelBuffer::operator=(PixelBuffer&& other) noexcept
+	{
+		if (this != &other)
+		{
+			clear();
+			std::swap(m_data, other.m_data);
+			std::swap(m_size, other.m_size);
+		}
+		return *this;
+	}
+
+	void PixelBuffer::Adopt(void* data, size_t size)
+	{
+		clear();
+		m_data = static_cast<uint8_t*>(data);
+		m_size = data ? size : 0;
+	}
+
+	void PixelBuffer::resize(size_t size)
+	{
+		if (size == 0)
+		{
+			clear();
+			return;
+		}
+		void* grown = std::realloc(m_data, size);
+		OO_ASSERT(grown && "out of memory for pixels");
+		m_data = static_cast<uint8_t*>(grown);
+		m_size = size;
+	}
+
+	void PixelBuffer::clear()
+	{
+		std::free(m_data);
+		m_data = nullptr;
+		m_size = 0;
+	}
+
 	bool FileImageData::Create(const std::string& fileName)
 	{
 		name = fileName;
@@ -676,10 +737,11 @@ namespace oGFX
 		{
 			decodeType = ExtensionType::STB;
 			auto ptr = stbi_load(fileName.c_str(), &this->w, &this->h, &this->channels, STBI_rgb_alpha);
+			if (ptr == nullptr)
+				return false;
 			dataSize = size_t(this->w) * size_t(this->h) * size_t(STBI_rgb_alpha);
-			imgData.resize(dataSize);
-			memcpy(imgData.data(), ptr, dataSize);
-			stbi_image_free(ptr);
+			// the decoded pixels are the payload, stb_image allocates them with malloc
+			imgData.Adopt(ptr, dataSize);
 
 			VkBufferImageCopy bufferCopyRegion = {};
 			bufferCopyRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
@@ -701,6 +763,63 @@ namespace oGFX
 	}
 
 
+	void FileImageData::GenerateMipChain()
+	{
+		OO_ASSERT(format == VK_FORMAT_R8G8B8A8_UNORM && mipInformation.size() == 1);
+		constexpr uint32_t TEXEL = 4;
+
+		// grown once for the whole chain, mip 0 is not moved again
+		size_t chainSize = imgData.size();
+		for (uint32_t mw = static_cast<uint32_t>(w), mh = static_cast<uint32_t>(h); mw > 1 || mh > 1;)
+		{
+			mw = std::max(mw / 2, 1u);
+			mh = std::max(mh / 2, 1u);
+			chainSize += size_t(mw) * mh * TEXEL;
+		}
+		size_t dstOffset = imgData.size();
+		imgData.resize(chainSize);
+
+		uint32_t width = static_cast<uint32_t>(w);
+		uint32_t height = static_cast<uint32_t>(h);
+		size_t srcOffset = 0;
+		while (width > 1 || height > 1)
+		{
+			const uint32_t mipWidth = std::max(width / 2, 1u);
+			const uint32_t mipHeight = std::max(height / 2, 1u);
+
+			const uint8_t* src = imgData.data() + srcOffset;
+			uint8_t* dst = imgData.data() + dstOffset;
+			for (uint32_t y = 0; y < mipHeight; y++)
+			{
+				// odd sides repeat their last row or column
+				const uint32_t y0 = std::min(y * 2, height - 1), y1 = std::min(y * 2 + 1, height - 1);
+				for (uint32_t x = 0; x < mipWidth; x++)
+				{
+					const uint32_t x0 = std::min(x * 2, width - 1), x1 = std::min(x * 2 + 1, width - 1);
+					for (uint32_t c = 0; c < TEXEL; c++)
+					{
+						const uint32_t sum = src[(size_t(y0) * width + x0) * TEXEL + c] + src[(size_t(y0) * width + x1) * TEXEL + c]
+							+ src[(size_t(y1) * width + x0) * TEXEL + c] + src[(size_t(y1) * width + x1) * TEXEL + c];
+						dst[(size_t(y) * mipWidth + x) * TEXEL + c] = static_cast<uint8_t>((sum + 2) / 4);
+					}
+				}
+			}
+
+			VkBufferImageCopy region = mipInformation.front();
+			region.imageSubresource.mipLevel = static_cast<uint32_t>(mipInformation.size());
+			region.imageExtent = { mipWidth, mipHeight, 1 };
+			region.bufferOffset = dstOffset;
+			mipInformation.push_back(region);
+
+			srcOffset = dstOffset;
+			dstOffset += size_t(mipWidth) * mipHeight * TEXEL;
+			width = mipWidth;
+			height = mipHeight;
+		}
+		dataSize = imgData.size();
+		generateMips = false;
+	}
+
 	uint16_t float_to_half(const float x)
 	{
 		const uint32_t HALF_FLOAT_MAX_VALUE = 65504;
@@ -714,6 +833,23 @@ namespace oGFX
 		return (b & 0x80000000) >> 16 | (e > 112) * ((((e - 112) << 10) & 0x7C00) | m >> 13) | ((e < 113) & (e > 101)) * ((((0x007FF000 + m) >> (125 - e)) + 1) >> 1) | (e > 143) * 0x7FFF; // sign : normalized : denormalized : saturate
 	}
 
+	float FloatsToHalf(const void* src, void* dst, size_t count)
+	{
+		// front to back, each half lands at or before the float it came from
+		const uint8_t* in = static_cast<const uint8_t*>(src);
+		uint8_t* out = static_cast<uint8_t*>(dst);
+		float highest = std::numeric_limits<float>::lowest();
+		for (size_t i = 0; i < count; i++)
+		{
+			float value;
+			memcpy(&value, in + i * sizeof(float), sizeof(float));
+			highest = std::max(highest, value);
+			const uint16_t half = float_to_half(value);
+			memcpy(out + i * sizeof(uint16_t), &half, sizeof(uint16_t));
+		}
+		return highest;
+	}
+
 	bool FileImageData::CreateCube(const std::string& folder)
 	{
 		name = folder;
@@ -785,7 +921,12 @@ namespace oGFX
 					chunkSize = size_t(this->w) * size_t(this->h) * size_t(STBI_rgb_alpha);
 				}
 
-				imgData.resize(dataSize + chunkSize);
+				if (i == 0)
+				{
+					// the faces are the same size, room for all of them up front
+					imgData.resize(chunkSize * CUBE_FACES);
+				}
+				OO_ASSERT(dataSize + chunkSize <= imgData.size());
 				memcpy(imgData.data()+dataSize, ptr, chunkSize);
 
 				VkBufferImageCopy bufferCopyRegion = {};
@@ -816,17 +957,10 @@ namespace oGFX
 					default:return VK_FORMAT_R16G16B16A16_SFLOAT;
 					}
 				}();
-				std::vector<uint8_t> processed;
-				processed.resize(imgData.size() / 2);
-				uint16_t* data = (uint16_t*)processed.data();
-				for (size_t i = 0; i < processed.size()/2; i++)
-				{
-					float fltValue = *(float*)(imgData.data() + i * sizeof(float));
-					this->highestColValue = std::max(this->highestColValue, fltValue);
-					data[i] = float_to_half(fltValue);
-				}
-				std::swap(imgData, processed);
+				// converted in place, the halves fill the front of the buffer
+				this->highestColValue = std::max(this->highestColValue, FloatsToHalf(imgData.data(), imgData.data(), imgData.size() / sizeof(float)));
 				dataSize /= 2; // data is halved
+				imgData.resize(dataSize);
 				for (size_t i = 0; i < mipInformation.size(); i++)
 				{
 					mipInformation[i].bufferOffset /= 2;
@@ -844,14 +978,8 @@ namespace oGFX
 
 	void FileImageData::Free()
 	{
-		//if (decodeType == ExtensionType::DDS)
-		//{
-		//	delete[] imgData;
-		//}
-		//if (decodeType == ExtensionType::STB)
-		//{
-		//	stbi_image_free(imgData);
-		//}
+		imgData.clear();
+		dataSize = 0;
 	}
 
 	void SetVulkanObjectName(VkDevice device,const VkDebugMarkerObjectNameInfoEXT& info)
@@ -320,6 +320,36 @@ namespace oGFX
 	unsigned char* LoadTextureFromFile(const std::string& fileName, int& width, int& height, uint64_t& imageSize);
 	void FreeTextureFile(uint8_t* data);
 
+	// Pixels of a loaded image in memory from malloc, so the buffer a decoder returns is taken over instead of copied.
+	// Move only, the payload is handed along on its way to the upload and never duplicated.
+	class PixelBuffer
+	{
+	public:
+		PixelBuffer() = default;
+		~PixelBuffer();
+		PixelBuffer(PixelBuffer&& other) noexcept;
+		PixelBuffer& operator=(PixelBuffer&& other) noexcept;
+		PixelBuffer(const PixelBuffer&) = delete;
+		PixelBuffer& operator=(const PixelBuffer&) = delete;
+
+		// Takes ownership of memory from malloc, stb_image allocates its results with it
+		void Adopt(void* data, size_t size);
+		// Keeps the contents, grows in place when the heap can
+		void resize(size_t size);
+		void clear();
+
+		uint8_t* data() { return m_data; }
+		const uint8_t* data() const { return m_data; }
+		size_t size() const { return m_size; }
+		bool empty() const { return m_size == 0; }
+		uint8_t& operator[](size_t i) { return m_data[i]; }
+		const uint8_t& operator[](size_t i) const { return m_data[i]; }
+
+	private:
+		uint8_t* m_data{ nullptr };
+		size_t m_size{};
+	};
+
 	struct FileImageData
 	{
 		std::string name;
@@ -328,7 +358,7 @@ namespace oGFX
 		int32_t channels{};
 		uint64_t dataSize{};
 		float highestColValue{1.0f};
-		std::vector<uint8_t> imgData{};
+		PixelBuffer imgData{};
 		std::vector<VkBufferImageCopy> mipInformation{};
 		bool generateMips{ false };
 		enum class ExtensionType : uint8_t
@@ -348,6 +378,8 @@ namespace oGFX
 
 		bool Create(const std::string& fileName);
 		bool CreateCube(const std::string& folder);
+		// Box filters the 8 bit RGBA mip 0 down to 1x1 on the CPU and appends the mips, so they can be streamed
+		void GenerateMipChain();
 		void Free();
 	};
 
@@ -355,6 +387,8 @@ namespace oGFX
 	bool IsFileHDR(const std::string& fileName);
 
 	uint16_t float_to_half(const float x);
+	// Converts count floats to half floats, dst may be src to convert in place. Returns the largest value.
+	float FloatsToHalf(const void* src, void* dst, size_t count);
 
 	namespace vkutils
 	{
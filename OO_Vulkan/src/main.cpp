@@ -255,7 +255,7 @@ int main(int argc, char argv[])
         }
         renderer->g_MeshBuffers.VtxBuffer.reserve(100000*sizeof(oGFX::Vertex));
         renderer->g_MeshBuffers.IdxBuffer.reserve(100000*sizeof(oGFX::Vertex));
-        icoSphere.reset( renderer->LoadMeshFromBuffers(vertices, indices, nullptr));
+        icoSphere.reset( renderer->LoadMeshFromBuffers(vertices, indices));
     }
 
     std::unique_ptr<Model> bunny{ renderer->LoadMeshFromFile("Models/bunny.obj") };
@@ -280,7 +280,7 @@ int main(int argc, char argv[])
     oGFX::BV::RitterSphere(icoSphere->s, vertPositions);
     oGFX::BV::BoundingAABB(icoSphere->aabb, vertPositions);
 
-    std::unique_ptr<Model> box{ renderer->LoadMeshFromBuffers(defaultCubeMesh.m_VertexBuffer, defaultCubeMesh.m_IndexBuffer, nullptr) };
+    std::unique_ptr<Model> box{ renderer->LoadMeshFromBuffers(defaultCubeMesh.m_VertexBuffer, defaultCubeMesh.m_IndexBuffer) };
     vertPositions.resize(box->vertices.size());
     std::transform(box->vertices.begin(), box->vertices.end(), vertPositions.begin(), [](const oGFX::Vertex& v) { return v.pos; });
     oGFX::BV::LarsonSphere(ms, vertPositions, oGFX::BV::EPOS::_98);
@@ -331,8 +331,8 @@ int main(int argc, char argv[])
     //std::cout << "vertices : " << bunny->vertices.size() << std::endl;
     //
     //
-    //uint32_t triangle = renderer->LoadMeshFromBuffers(quadVerts, quadIndices, nullptr);
-    std::unique_ptr<Model> plane{ renderer->LoadMeshFromBuffers(defaultPlaneMesh.m_VertexBuffer, defaultPlaneMesh.m_IndexBuffer, nullptr) };
+    //uint32_t triangle = renderer->LoadMeshFromBuffers(quadVerts, quadIndices);
+    std::unique_ptr<Model> plane{ renderer->LoadMeshFromBuffers(defaultPlaneMesh.m_VertexBuffer, defaultPlaneMesh.m_IndexBuffer) };
     //delete bunny;
     //
     //oGFX::BV::RitterSphere(ms, positions);
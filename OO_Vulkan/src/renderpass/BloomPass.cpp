@@ -89,6 +89,13 @@ void BloomPass::Init()
 		swapchainext.width, swapchainext.height, true, 1.0f);
 	vr.fbCache.RegisterFramebuffer(vr.attachments.SD_target[1]);
 
+	// the bright pass and the mip chain only live inside this pass
+	vr.transientPool.Register(vr.attachments.Bloom_brightTarget);
+	for (size_t i = 0; i < vr.attachments.MAX_BLOOM_SAMPLES; i++)
+	{
+		vr.transientPool.Register(vr.attachments.Bloom_downsampleTargets[i]);
+	}
+
 	VkFramebufferCreateInfo blankInfo{VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO};
 	std::vector<VkImageView> dummyViews;
 	std::vector<vkutils::Texture2D*> textures;
@@ -136,6 +143,11 @@ bool BloomPass::SetupDependencies(RenderGraph& builder)
 
 	builder.Write(vr.renderTargets[0].texture, UAV);
 	builder.Write(vr.attachments.SD_target[0], UAV);
+	builder.Write(vr.attachments.Bloom_brightTarget, UAV);
+	for (auto& target : vr.attachments.Bloom_downsampleTargets)
+	{
+		builder.Write(target, UAV);
+	}
 
 	vkutils::Texture* mainImage = nullptr;
 	if (vr.m_upscaleType == UPSCALING_TYPE::NONE) {
@@ -188,7 +200,7 @@ void BloomPass::Draw(const VkCommandBuffer cmdlist)
 
 	vkutils::Texture2D* previousBuffer{ mainImage };
 
-	if (vr.currWorld->bloomSettings.enabled == true)
+	if (vr.currWorld->RenderSnapshot().bloomSettings.enabled == true)
 		previousBuffer = PerformBloom(cmd, mainImage);
 	
 	marker.pMarkerName = "TonemappingCOMP";
@@ -208,7 +220,7 @@ void BloomPass::Draw(const VkCommandBuffer cmdlist)
 			.BindImage(2, outputBuffer, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE)
 			.BindBuffer(3, vr.LuminanceBuffer.getBufferInfoPtr(), VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
 
-		auto& colSettings = vr.currWorld->colourSettings;
+		auto& colSettings = vr.currWorld->RenderSnapshot().colourSettings;
 		ColourCorrectPC pc;
 		pc.threshold = glm::vec2{ colSettings.shadowThreshold ,colSettings.highlightThreshold };
 		pc.shadowCol = colSettings.shadowColour;
@@ -262,7 +274,7 @@ void BloomPass::Draw(const VkCommandBuffer cmdlist)
 	
 
 	//  vigneette
-	if (vr.currWorld->vignetteSettings.enabled == true)
+	if (vr.currWorld->RenderSnapshot().vignetteSettings.enabled == true)
 	{
 		marker.pMarkerName = "VignetteCOMP";
 		if (regionBegin)
@@ -279,7 +291,7 @@ void BloomPass::Draw(const VkCommandBuffer cmdlist)
 				.BindImage(1, inputBuffer, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE)
 				.BindImage(2, outputBuffer, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE);
 
-			auto& vignette = vr.currWorld->vignetteSettings;
+			auto& vignette = vr.currWorld->RenderSnapshot().vignetteSettings;
 			VignettePC pc;
 			pc.colour = vignette.colour;
 			pc.vignetteValues = glm::vec4{vignette.innerRadius, vignette.outerRadius,0.0,0.0};
@@ -455,8 +467,9 @@ vkutils::Texture2D* BloomPass::PerformBloom(rhi::CommandList& cmd, vkutils::Text
 			.BindBuffer(3, &dbi, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
 
 		BloomPC pc{};
-		auto knee = vr.currWorld->bloomSettings.threshold * vr.currWorld->bloomSettings.softThreshold;
-		pc.threshold.x = vr.currWorld->bloomSettings.threshold;
+		auto& bloomSettings = vr.currWorld->RenderSnapshot().bloomSettings;
+		auto knee = bloomSettings.threshold * bloomSettings.softThreshold;
+		pc.threshold.x = bloomSettings.threshold;
 		pc.threshold.y = pc.threshold.x - knee;
 		pc.threshold.z = 2.0f * knee;
 		pc.threshold.w = 0.25f / (knee + 0.00001f);
@@ -604,7 +617,7 @@ void BloomPass::CreatePipeline()
 	}
 	VkComputePipelineCreateInfo computeCI = oGFX::vkutils::inits::computeCreateInfo(PSOLayoutDB::brightPixelsLayout);
 	computeCI.stage = vr.LoadShader(m_device, shaderCS, VK_SHADER_STAGE_COMPUTE_BIT);
-	VK_CHK(vkCreateComputePipelines(m_device.logicalDevice, VK_NULL_HANDLE, 1, &computeCI, nullptr, &pso_bloom_bright));
+	VK_CHK(vkCreateComputePipelines(m_device.logicalDevice, vr.pipelineCache.Get(), 1, &computeCI, nullptr, &pso_bloom_bright));
 	VK_NAME(m_device.logicalDevice, "pso_bloom_bright", pso_bloom_bright);
 	vkDestroyShaderModule(m_device.logicalDevice, computeCI.stage.module, nullptr); // destroy compute
 
@@ -614,7 +627,7 @@ void BloomPass::CreatePipeline()
 	}
 	computeCI = oGFX::vkutils::inits::computeCreateInfo(PSOLayoutDB::BloomPSOLayout);
 	computeCI.stage = vr.LoadShader(m_device, shaderDownsample, VK_SHADER_STAGE_COMPUTE_BIT);
-	VK_CHK(vkCreateComputePipelines(m_device.logicalDevice, VK_NULL_HANDLE, 1, &computeCI, nullptr, &pso_bloom_down));
+	VK_CHK(vkCreateComputePipelines(m_device.logicalDevice, vr.pipelineCache.Get(), 1, &computeCI, nullptr, &pso_bloom_down));
 	VK_NAME(m_device.logicalDevice, "pso_bloom_down", pso_bloom_down);
 	vkDestroyShaderModule(m_device.logicalDevice, computeCI.stage.module, nullptr); // destroy compute
 
@@ -624,7 +637,7 @@ void BloomPass::CreatePipeline()
 	}
 	computeCI = oGFX::vkutils::inits::computeCreateInfo(PSOLayoutDB::doubleImageStoreLayout);
 	computeCI.stage = vr.LoadShader(m_device, shaderUpample, VK_SHADER_STAGE_COMPUTE_BIT);
-	VK_CHK(vkCreateComputePipelines(m_device.logicalDevice, VK_NULL_HANDLE, 1, &computeCI, nullptr, &pso_bloom_up));
+	VK_CHK(vkCreateComputePipelines(m_device.logicalDevice, vr.pipelineCache.Get(), 1, &computeCI, nullptr, &pso_bloom_up));
 	VK_NAME(m_device.logicalDevice, "pso_bloom_up", pso_bloom_up);
 	vkDestroyShaderModule(m_device.logicalDevice, computeCI.stage.module, nullptr); // destroy compute
 
@@ -634,7 +647,7 @@ void BloomPass::CreatePipeline()
 	}
 	computeCI = oGFX::vkutils::inits::computeCreateInfo(PSOLayoutDB::BloomPSOLayout);
 	computeCI.stage = vr.LoadShader(m_device, compositeAdditive, VK_SHADER_STAGE_COMPUTE_BIT);
-	VK_CHK(vkCreateComputePipelines(m_device.logicalDevice, VK_NULL_HANDLE, 1, &computeCI, nullptr, &pso_additive_composite));
+	VK_CHK(vkCreateComputePipelines(m_device.logicalDevice, vr.pipelineCache.Get(), 1, &computeCI, nullptr, &pso_additive_composite));
 	VK_NAME(m_device.logicalDevice, "pso_additive_composite", pso_additive_composite);
 	vkDestroyShaderModule(m_device.logicalDevice, computeCI.stage.module, nullptr); // destroy compute
 
@@ -643,7 +656,7 @@ void BloomPass::CreatePipeline()
 		vkDestroyPipeline(m_device.logicalDevice, pso_vignette, nullptr);
 	}
 	computeCI.stage = vr.LoadShader(m_device, vignette, VK_SHADER_STAGE_COMPUTE_BIT);
-	VK_CHK(vkCreateComputePipelines(m_device.logicalDevice, VK_NULL_HANDLE, 1, &computeCI, nullptr, &pso_vignette));
+	VK_CHK(vkCreateComputePipelines(m_device.logicalDevice, vr.pipelineCache.Get(), 1, &computeCI, nullptr, &pso_vignette));
 	VK_NAME(m_device.logicalDevice, "pso_vignette", pso_vignette);
 	vkDestroyShaderModule(m_device.logicalDevice, computeCI.stage.module, nullptr); // destroy compute
 
@@ -652,7 +665,7 @@ void BloomPass::CreatePipeline()
 		vkDestroyPipeline(m_device.logicalDevice, pso_fxaa, nullptr);
 	}
 	computeCI.stage = vr.LoadShader(m_device, fxaa, VK_SHADER_STAGE_COMPUTE_BIT);
-	VK_CHK(vkCreateComputePipelines(m_device.logicalDevice, VK_NULL_HANDLE, 1, &computeCI, nullptr, &pso_fxaa));
+	VK_CHK(vkCreateComputePipelines(m_device.logicalDevice, vr.pipelineCache.Get(), 1, &computeCI, nullptr, &pso_fxaa));
 	VK_NAME(m_device.logicalDevice, "pso_fxaa", pso_fxaa);
 	vkDestroyShaderModule(m_device.logicalDevice, computeCI.stage.module, nullptr); // destroy compute
 	
@@ -662,7 +675,7 @@ void BloomPass::CreatePipeline()
 	}
 	computeCI = oGFX::vkutils::inits::computeCreateInfo(PSOLayoutDB::tonemapPSOLayout);
 	computeCI.stage = vr.LoadShader(m_device, toneMap, VK_SHADER_STAGE_COMPUTE_BIT);
-	VK_CHK(vkCreateComputePipelines(m_device.logicalDevice, VK_NULL_HANDLE, 1, &computeCI, nullptr, &pso_tone_mapping));
+	VK_CHK(vkCreateComputePipelines(m_device.logicalDevice, vr.pipelineCache.Get(), 1, &computeCI, nullptr, &pso_tone_mapping));
 	VK_NAME(m_device.logicalDevice, "pso_tone_mapping", pso_tone_mapping);
 	vkDestroyShaderModule(m_device.logicalDevice, computeCI.stage.module, nullptr); // destroy compute
 }
@@ -390,7 +390,7 @@ void DebugDrawRenderpass::CreatePipeline()
 					{
 						vkDestroyPipeline(m_device.logicalDevice,pso, nullptr);
 					}
-					VK_CHK(vkCreateGraphicsPipelines(m_device.logicalDevice, VK_NULL_HANDLE, 1, &pipelineCreateInfo, nullptr, &pso));
+					VK_CHK(vkCreateGraphicsPipelines(m_device.logicalDevice, vr.pipelineCache.Get(), 1, &pipelineCreateInfo, nullptr, &pso));
 					VK_NAME(m_device.logicalDevice, "DebugDrawLinesPSO", pso);
 				}
 			}
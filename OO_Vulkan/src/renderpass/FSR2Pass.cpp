@@ -265,7 +265,7 @@ void SetupConstantBuffers()
 	VulkanRenderer& vr = *VulkanRenderer::get();
 	size_t currFrame = vr.getFrame();
 
-	Camera& cam = vr.currWorld->cameras[0];
+	Camera& cam = vr.currWorld->RenderSnapshot().cameras[0];
 	VkExtent2D resInfo = vr.m_swapchain.swapChainExtent;
 	
 	// Jitter handled in main
@@ -981,7 +981,7 @@ void FSR2Pass::CreatePipeline()
 		const char* shader = fsr_shaders[i];
 		computeCI = oGFX::vkutils::inits::computeCreateInfo(PSOLayoutDB::fsr2_PSOLayouts[i]);
 		computeCI.stage = vr.LoadShader(m_device, shader, VK_SHADER_STAGE_COMPUTE_BIT);
-		VK_CHK(vkCreateComputePipelines(m_device.logicalDevice, VK_NULL_HANDLE, 1, &computeCI, nullptr, &pipe));
+		VK_CHK(vkCreateComputePipelines(m_device.logicalDevice, vr.pipelineCache.Get(), 1, &computeCI, nullptr, &pipe));
 		std::string name(fsr_shaders_names[i]);
 		name += "_PSO";		
 		VK_NAME(m_device.logicalDevice, name.c_str(), &pipe);
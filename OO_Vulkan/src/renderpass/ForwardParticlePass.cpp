@@ -307,25 +307,20 @@ void ForwardParticlePass::CreatePipeline()
 	pipelineCI.stageCount = static_cast<uint32_t>(shaderStages.size());
 	pipelineCI.pStages = shaderStages.data();
 
-	const auto& bindingDescription = std::vector<VkVertexInputBindingDescription>{	
-		oGFX::vkutils::inits::vertexInputBindingDescription(BIND_POINT_VERTEX_BUFFER_ID,sizeof(oGFX::Vertex),VK_VERTEX_INPUT_RATE_VERTEX),
-		oGFX::vkutils::inits::vertexInputBindingDescription(BIND_POINT_INSTANCE_BUFFER_ID,sizeof(ParticleData),VK_VERTEX_INPUT_RATE_INSTANCE),
-	};
-	const auto& attributeDescriptions = std::vector<VkVertexInputAttributeDescription>{
-		oGFX::vkutils::inits::vertexInputAttributeDescription(BIND_POINT_VERTEX_BUFFER_ID,0,VK_FORMAT_R32G32B32_SFLOAT,offsetof(oGFX::Vertex, pos)), //Position attribute
-		oGFX::vkutils::inits::vertexInputAttributeDescription(BIND_POINT_VERTEX_BUFFER_ID,1,VK_FORMAT_R32G32B32_SFLOAT,offsetof(oGFX::Vertex, norm)),//normals attribute
-		oGFX::vkutils::inits::vertexInputAttributeDescription(BIND_POINT_VERTEX_BUFFER_ID,2,VK_FORMAT_R32G32B32_SFLOAT,offsetof(oGFX::Vertex, col)), // colour attribute
-		oGFX::vkutils::inits::vertexInputAttributeDescription(BIND_POINT_VERTEX_BUFFER_ID,3,VK_FORMAT_R32G32B32_SFLOAT,offsetof(oGFX::Vertex, tangent)),//tangent attribute
-		oGFX::vkutils::inits::vertexInputAttributeDescription(BIND_POINT_VERTEX_BUFFER_ID,4,VK_FORMAT_R32G32_SFLOAT,offsetof(oGFX::Vertex, tex)),    //Texture attribute
+	std::vector<VkVertexInputBindingDescription> bindingDescription = oGFX::GetGFXVertexInputBindings();
+	bindingDescription.push_back(oGFX::vkutils::inits::vertexInputBindingDescription(BIND_POINT_INSTANCE_BUFFER_ID,sizeof(ParticleData),VK_VERTEX_INPUT_RATE_INSTANCE));
 
+	// the mesh attributes are the global vertex layout, packed or not
+	std::vector<VkVertexInputAttributeDescription> attributeDescriptions = oGFX::GetGFXVertexInputAttributes();
+	attributeDescriptions.insert(attributeDescriptions.end(), {
 		oGFX::vkutils::inits::vertexInputAttributeDescription(BIND_POINT_INSTANCE_BUFFER_ID,5,VK_FORMAT_R32G32B32A32_SFLOAT,offsetof(ParticleData, transform)+0*sizeof(glm::vec4)),    //xform
 		oGFX::vkutils::inits::vertexInputAttributeDescription(BIND_POINT_INSTANCE_BUFFER_ID,6,VK_FORMAT_R32G32B32A32_SFLOAT,offsetof(ParticleData, transform)+1*sizeof(glm::vec4)),    //xform
 		oGFX::vkutils::inits::vertexInputAttributeDescription(BIND_POINT_INSTANCE_BUFFER_ID,7,VK_FORMAT_R32G32B32A32_SFLOAT,offsetof(ParticleData, transform)+2*sizeof(glm::vec4)),    //xform
 		oGFX::vkutils::inits::vertexInputAttributeDescription(BIND_POINT_INSTANCE_BUFFER_ID,8,VK_FORMAT_R32G32B32A32_SFLOAT,offsetof(ParticleData, transform)+3*sizeof(glm::vec4)),    //xform
 		oGFX::vkutils::inits::vertexInputAttributeDescription(BIND_POINT_INSTANCE_BUFFER_ID,9,VK_FORMAT_R32G32B32A32_SFLOAT,offsetof(ParticleData, colour)),    //col
 		oGFX::vkutils::inits::vertexInputAttributeDescription(BIND_POINT_INSTANCE_BUFFER_ID,10,VK_FORMAT_R32G32B32A32_UINT,offsetof(ParticleData, instanceData)),    //texindex, entityID
-
-	};
+		oGFX::vkutils::inits::vertexInputAttributeDescription(BIND_POINT_INSTANCE_BUFFER_ID,11,VK_FORMAT_R32G32B32A32_SFLOAT,offsetof(ParticleData, positionDequant)),    //packed position bounds
+	});
 	VkPipelineVertexInputStateCreateInfo vertexInputCreateInfo = oGFX::vkutils::inits::pipelineVertexInputStateCreateInfo(bindingDescription, attributeDescriptions);
 	pipelineCI.pVertexInputState = &vertexInputCreateInfo;
 
@@ -369,7 +364,7 @@ void ForwardParticlePass::CreatePipeline()
 	{
 		vkDestroyPipeline(m_device.logicalDevice, pso_GBufferParticles, nullptr);
 	}
-	VK_CHK(vkCreateGraphicsPipelines(m_device.logicalDevice, VK_NULL_HANDLE, 1, &pipelineCI, nullptr, &pso_GBufferParticles));
+	VK_CHK(vkCreateGraphicsPipelines(m_device.logicalDevice, vr.pipelineCache.Get(), 1, &pipelineCI, nullptr, &pso_GBufferParticles));
 	VK_NAME(m_device.logicalDevice, "forwardParticlesPSO", pso_GBufferParticles);
 
 	vkDestroyShaderModule(m_device.logicalDevice, shaderStages[0].module, nullptr);
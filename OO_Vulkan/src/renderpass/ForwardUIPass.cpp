@@ -303,7 +303,7 @@ void ForwardUIPass::CreatePipeline()
 	{
 		vkDestroyPipeline(m_device.logicalDevice, pso_Forward_UI, nullptr);
 	}
-	VK_CHK(vkCreateGraphicsPipelines(m_device.logicalDevice, VK_NULL_HANDLE, 1, &pipelineCI, nullptr, &pso_Forward_UI));
+	VK_CHK(vkCreateGraphicsPipelines(m_device.logicalDevice, vr.pipelineCache.Get(), 1, &pipelineCI, nullptr, &pso_Forward_UI));
 	VK_NAME(m_device.logicalDevice, "forwardUIPSO", pso_Forward_UI);
 
 
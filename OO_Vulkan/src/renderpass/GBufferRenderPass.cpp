@@ -121,7 +121,7 @@ void GBufferRenderPass::Draw(const VkCommandBuffer cmdlist)
 			.BindBuffer(2, vr.instanceBuffer.GetBufferInfoPtr(), VK_DESCRIPTOR_TYPE_STORAGE_BUFFER)
 			.BindBuffer(3, vr.gpuTransformBuffer.GetBufferInfoPtr(), VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
 		
-		oGFX::Frustum frust = vr.currWorld->cameras[vr.renderIteration].GetFrustum();
+		oGFX::Frustum frust = vr.currWorld->RenderSnapshot().cameras[vr.renderIteration].GetFrustum();
 		struct CullingPC pc;
 		pc. top = frust.top.normal;
 		pc. bottom = frust.bottom.normal;
@@ -167,11 +167,8 @@ void GBufferRenderPass::Draw(const VkCommandBuffer cmdlist)
 	constexpr bool clearOnDraw = true;
 	for (size_t i = 0; i < GBufferAttachmentIndex::TOTAL_COLOR_ATTACHMENTS; i++)
 	{
-		if (i == GBufferAttachmentIndex::NORMAL) 
-		{
-			cmd.BindAttachment((uint32_t)i, &attachments[i],clearOnDraw);
-		}
-		if (i == GBufferAttachmentIndex::VELOCITY)
+		// transient attachments hold whatever the last pass sharing their memory left behind
+		if (i == GBufferAttachmentIndex::VELOCITY || vr.transientPool.IsTransient(&attachments[i]))
 		{
 			cmd.BindAttachment((uint32_t)i, &attachments[i], clearOnDraw);
 		}
@@ -568,7 +565,7 @@ void GBufferRenderPass::CreatePipeline()
 	{
 		vkDestroyPipeline(m_device.logicalDevice, pso_GBufferDefault, nullptr);
 	}
-	VK_CHK(vkCreateGraphicsPipelines(m_device.logicalDevice, VK_NULL_HANDLE, 1, &pipelineCI, nullptr, &pso_GBufferDefault));
+	VK_CHK(vkCreateGraphicsPipelines(m_device.logicalDevice, vr.pipelineCache.Get(), 1, &pipelineCI, nullptr, &pso_GBufferDefault));
 	VK_NAME(m_device.logicalDevice, "GBufferDefaultPSO", pso_GBufferDefault);
 
 	vkDestroyShaderModule(m_device.logicalDevice, shaderStages[0].module, nullptr);
@@ -580,7 +577,7 @@ void GBufferRenderPass::CreatePipeline()
 	}
 	VkComputePipelineCreateInfo computeCI = oGFX::vkutils::inits::computeCreateInfo(PSOLayoutDB::singleSSBOlayout);
 	computeCI.stage = vr.LoadShader(m_device, compute, VK_SHADER_STAGE_COMPUTE_BIT);
-	VK_CHK(vkCreateComputePipelines(m_device.logicalDevice, VK_NULL_HANDLE, 1, &computeCI, nullptr, &pso_ComputeCull));
+	VK_CHK(vkCreateComputePipelines(m_device.logicalDevice, vr.pipelineCache.Get(), 1, &computeCI, nullptr, &pso_ComputeCull));
 	VK_NAME(m_device.logicalDevice, "pso_ComputeCull", pso_ComputeCull);
 	vkDestroyShaderModule(m_device.logicalDevice, computeCI.stage.module, nullptr); // destroy compute
 
@@ -594,7 +591,7 @@ void GBufferRenderPass::CreatePipeline()
 		}
 		VkComputePipelineCreateInfo computeCI = oGFX::vkutils::inits::computeCreateInfo(PSOLayoutDB::shadowPrepassPSOLayout);
 		computeCI.stage = vr.LoadShader(m_device, shaderCS, VK_SHADER_STAGE_COMPUTE_BIT);
-		VK_CHK(vkCreateComputePipelines(m_device.logicalDevice, VK_NULL_HANDLE, 1, &computeCI, nullptr, &pso_ComputeShadowPrepass));
+		VK_CHK(vkCreateComputePipelines(m_device.logicalDevice, vr.pipelineCache.Get(), 1, &computeCI, nullptr, &pso_ComputeShadowPrepass));
 		VK_NAME(m_device.logicalDevice, "pso_ComputeShadowPrepass", pso_ComputeShadowPrepass);
 		vkDestroyShaderModule(m_device.logicalDevice, computeCI.stage.module, nullptr); // destroy compute
 	}
@@ -725,6 +722,12 @@ void GBufferRenderPass::SetupResources() {
 	attachments[GBufferAttachmentIndex::EMISSIVE	].name = "GB_Emissive";
 	attachments[GBufferAttachmentIndex::EMISSIVE	].forFrameBuffer(&m_device, vr.G_HDR_FORMAT_ALPHA, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, width, height);
 	vr.fbCache.RegisterFramebuffer(attachments[GBufferAttachmentIndex::EMISSIVE]);
+
+	// only lit and ambient occlusion read these, the memory is given to later passes after that
+	vr.transientPool.Register(attachments[GBufferAttachmentIndex::NORMAL]);
+	vr.transientPool.Register(attachments[GBufferAttachmentIndex::ALBEDO]);
+	vr.transientPool.Register(attachments[GBufferAttachmentIndex::MATERIAL]);
+	vr.transientPool.Register(attachments[GBufferAttachmentIndex::EMISSIVE]);
 	
 	vr.attachments.shadowMask.name = "GB_ShadowMask";
 	vr.attachments.shadowMask.forFrameBuffer(&m_device, VK_FORMAT_R32_SFLOAT, VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, width, height);
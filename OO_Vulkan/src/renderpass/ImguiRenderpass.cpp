@@ -323,7 +323,7 @@ void ImguiRenderpass::CreatePipeline()
 	depthStencilCreateInfo.front = { };
 	depthStencilCreateInfo.back = { };
 
-	VK_CHK(vkCreateGraphicsPipelines(m_device.logicalDevice, VK_NULL_HANDLE, 1, &pipelineCreateInfo, nullptr, &imguiPSO));
+	VK_CHK(vkCreateGraphicsPipelines(m_device.logicalDevice, vr.pipelineCache.Get(), 1, &pipelineCreateInfo, nullptr, &imguiPSO));
 	VK_NAME(m_device.logicalDevice, "imguiPipe", imguiPSO);
 
 	vkDestroyShaderModule(m_device.logicalDevice, shaderStages[0].module, nullptr);
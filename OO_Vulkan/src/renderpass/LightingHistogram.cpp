@@ -218,7 +218,7 @@ void LightingHistogram::CreatePipeline()
 	{
 		vkDestroyPipeline(m_device.logicalDevice, pso_LightingHistogram, nullptr);
 	}
-	VK_CHK(vkCreateComputePipelines(m_device.logicalDevice, VK_NULL_HANDLE, 1, &computeCI, nullptr, &pso_LightingHistogram));
+	VK_CHK(vkCreateComputePipelines(m_device.logicalDevice, vr.pipelineCache.Get(), 1, &computeCI, nullptr, &pso_LightingHistogram));
 	VK_NAME(m_device.logicalDevice, "pso_LightingHistogram", pso_LightingHistogram);
 	vkDestroyShaderModule(m_device.logicalDevice, computeCI.stage.module, nullptr);
 
@@ -229,7 +229,7 @@ void LightingHistogram::CreatePipeline()
 	{
 		vkDestroyPipeline(m_device.logicalDevice, pso_lightingCDFScan, nullptr);
 	}
-	VK_CHK(vkCreateComputePipelines(m_device.logicalDevice, VK_NULL_HANDLE, 1, &computeCI, nullptr, &pso_lightingCDFScan));
+	VK_CHK(vkCreateComputePipelines(m_device.logicalDevice, vr.pipelineCache.Get(), 1, &computeCI, nullptr, &pso_lightingCDFScan));
 	VK_NAME(m_device.logicalDevice, "pso_lightingCDFScan", pso_lightingCDFScan);
 	vkDestroyShaderModule(m_device.logicalDevice, computeCI.stage.module, nullptr);
 
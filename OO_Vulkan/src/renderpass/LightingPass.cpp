@@ -89,6 +89,7 @@ bool LightingPass::SetupDependencies(RenderGraph& builder)
 	builder.Read(vr.g_Textures[vr.LTCLUTTextureID]);
 
 	builder.Read(vr.globalLightBuffer);
+	builder.Read(vr.shadowTileBuffer);
 
 
 	// READ: Lighting buffer (all the visible lights intersecting the camera frustum)
@@ -168,6 +169,7 @@ void LightingPass::Draw(const VkCommandBuffer cmdlist)
 		.BindImage(15, LTCtex, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE) // arealight lut
 		.BindImage(16, LTCLUTtex, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE) // area light lut
 		.BindSampler(17, GfxSamplerManager::GetSampler_PointClamp()) // ssaosampler
+		.BindBuffer(18, &vr.shadowTileBuffer.GetDescriptorBufferInfo(), VK_DESCRIPTOR_TYPE_STORAGE_BUFFER) // shadow atlas tiles
 	; 
 	
 	cmd.SetDefaultViewportAndScissor();
@@ -179,10 +181,10 @@ void LightingPass::Draw(const VkCommandBuffer cmdlist)
 
 	LightPC pc{};
 	pc.useSSAO = vr.useSSAO ? 1 : 0;
-	pc.specularModifier = vr.currWorld->lightSettings.specularModifier;
-	glm::vec3 normalizedDir = glm::normalize(vr.currWorld->lightSettings.directionalLight);
+	pc.specularModifier = vr.currWorld->RenderSnapshot().lightSettings.specularModifier;
+	glm::vec3 normalizedDir = glm::normalize(vr.currWorld->RenderSnapshot().lightSettings.directionalLight);
 	pc.directionalLight = vec4{ normalizedDir, 0.0f };
-	pc.lightColorInten = vr.currWorld->lightSettings.directionalLightColor;
+	pc.lightColorInten = vr.currWorld->RenderSnapshot().lightSettings.directionalLightColor;
 	pc.resolution.x = (float)tex->width;
 	pc.resolution.y = (float)tex->height;
 
@@ -198,14 +200,9 @@ void LightingPass::Draw(const VkCommandBuffer cmdlist)
 	
 	pc.numLights = static_cast<uint32_t>(lightCnt);
 
-	// calculate shadowmap grid dims
-	float gridSize = ceilf(sqrtf(static_cast<float>(vr.m_numShadowcastLights)));
-	gridSize = std::max<float>(0, gridSize);
-	pc.shadowMapGridDim = glm::vec2{gridSize,gridSize};
-
-	pc.ambient = vr.currWorld->lightSettings.ambient;
-	pc.maxBias = vr.currWorld->lightSettings.maxBias;
-	pc.mulBias = vr.currWorld->lightSettings.biasMultiplier;
+	pc.ambient = vr.currWorld->RenderSnapshot().lightSettings.ambient;
+	pc.maxBias = vr.currWorld->RenderSnapshot().lightSettings.maxBias;
+	pc.mulBias = vr.currWorld->RenderSnapshot().lightSettings.biasMultiplier;
 	
 	cmd.SetPushConstant(PSOLayoutDB::lightingPSOLayout, sizeof(LightPC), &pc);
 
@@ -326,6 +323,7 @@ void LightingPass::CreateDescriptors()
         .BindImage(6, &texDescriptorShadow, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, VK_SHADER_STAGE_ALL_GRAPHICS)
         .BindImage(7, &texDescriptorSSAO, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, VK_SHADER_STAGE_ALL_GRAPHICS)
         .BindBuffer(8, &dbi, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS)
+        .BindBuffer(18, &vr.shadowTileBuffer.GetDescriptorBufferInfo(), VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS)
         .BuildLayout(SetLayoutDB::Lighting);
 }
 
@@ -359,6 +357,7 @@ void LightingPass::CreatePipelineLayout()
 		.BindImage(15, &dummy, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,VK_SHADER_STAGE_ALL_GRAPHICS) // brdflut
 		.BindImage(16, &dummy, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,VK_SHADER_STAGE_ALL_GRAPHICS) // brdflut
 		.BindImage(17, &dummy, VK_DESCRIPTOR_TYPE_SAMPLER,VK_SHADER_STAGE_ALL_GRAPHICS) // ssaosampler
+		.BindBuffer(18, &vr.shadowTileBuffer.GetDescriptorBufferInfo(), VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS) // shadow atlas tiles
 		.BuildLayout(SetLayoutDB::Lighting);
 
 
@@ -451,7 +450,7 @@ void LightingPass::CreatePipeline()
 	{
 		vkDestroyPipeline(m_device.logicalDevice, pso_DeferredLightingComposition, nullptr);
 	}
-	VK_CHK(vkCreateGraphicsPipelines(m_device.logicalDevice, VK_NULL_HANDLE, 1, &pipelineCI, nullptr, &pso_DeferredLightingComposition));
+	VK_CHK(vkCreateGraphicsPipelines(m_device.logicalDevice, vr.pipelineCache.Get(), 1, &pipelineCI, nullptr, &pso_DeferredLightingComposition));
 	VK_NAME(m_device.logicalDevice, "deferredLightingCompositionPSO", pso_DeferredLightingComposition);
 
 	vkDestroyShaderModule(m_device.logicalDevice,shaderStages[0].module , nullptr);
@@ -491,7 +490,7 @@ void LightingPass::CreatePipeline()
 	{
 		vkDestroyPipeline(m_device.logicalDevice, pso_deferredBox, nullptr);
 	}
-	VK_CHK(vkCreateGraphicsPipelines(m_device.logicalDevice, VK_NULL_HANDLE, 1, &pipelineCI, nullptr, &pso_deferredBox));
+	VK_CHK(vkCreateGraphicsPipelines(m_device.logicalDevice, vr.pipelineCache.Get(), 1, &pipelineCI, nullptr, &pso_deferredBox));
 	VK_NAME(m_device.logicalDevice, "deferredBoxLights", pso_deferredBox);
 
 
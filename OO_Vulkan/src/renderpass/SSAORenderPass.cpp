@@ -74,6 +74,9 @@ void SSAORenderPass::Init()
 		swapchainext.width, swapchainext.height, true, 1.0f); // full scale image
 	vr.fbCache.RegisterFramebuffer(vr.attachments.SSAO_finalTarget);
 
+	vr.transientPool.Register(vr.attachments.SSAO_renderTarget);
+	vr.transientPool.Register(vr.attachments.SSAO_finalTarget);
+
 	auto cmd = vr.GetCommandBuffer();
 	vkutils::SetImageInitialState(cmd, vr.attachments.SSAO_renderTarget);
 	vkutils::SetImageInitialState(cmd, vr.attachments.SSAO_finalTarget);
@@ -147,10 +150,10 @@ void SSAORenderPass::Draw(const VkCommandBuffer cmdlist)
 	pc.screenDim.y = static_cast<float>(vr.attachments.SSAO_renderTarget.height);
 	pc.sampleDim.x = 4;
 	pc.sampleDim.y = 4;
-	pc.radius = vr.currWorld->ssaoSettings.radius;
-	pc.bias = vr.currWorld->ssaoSettings.bias;
-	pc.intensity = vr.currWorld->ssaoSettings.intensity;
-	pc.numSamples = std::clamp<uint32_t>(vr.currWorld->ssaoSettings.samples, 1, 64);
+	pc.radius = vr.currWorld->RenderSnapshot().ssaoSettings.radius;
+	pc.bias = vr.currWorld->RenderSnapshot().ssaoSettings.bias;
+	pc.intensity = vr.currWorld->RenderSnapshot().ssaoSettings.intensity;
+	pc.numSamples = std::clamp<uint32_t>(vr.currWorld->RenderSnapshot().ssaoSettings.samples, 1, 64);
 
 	cmd.SetPushConstant(PSOLayoutDB::SSAOPSOLayout, sizeof(SSAOPC), &pc);
 
@@ -187,7 +190,7 @@ void SSAORenderPass::Draw(const VkCommandBuffer cmdlist)
 
 	cmd.DrawFullScreenQuad();
 	
-	if (vr.currWorld->ssaoSettings.type == 1) {
+	if (vr.currWorld->RenderSnapshot().ssaoSettings.type == 1) {
 		vr.attachments.SSAO_workingTarget = &vr.attachments.SSAO_renderTarget;
 	}
 	// wait for blurred image before next
@@ -485,7 +488,7 @@ void SSAORenderPass::CreatePipeline()
 	{
 		vkDestroyPipeline(m_device.logicalDevice, pso_SSAO, nullptr);
 	}
-	VK_CHK(vkCreateGraphicsPipelines(m_device.logicalDevice, VK_NULL_HANDLE, 1, &pipelineCI, nullptr, &pso_SSAO));
+	VK_CHK(vkCreateGraphicsPipelines(m_device.logicalDevice, vr.pipelineCache.Get(), 1, &pipelineCI, nullptr, &pso_SSAO));
 	VK_NAME(m_device.logicalDevice, "SSAO_PSO", pso_SSAO);
 	vkDestroyShaderModule(m_device.logicalDevice, shaderStages[1].module, nullptr); // destroy fragment
 
@@ -496,7 +499,7 @@ void SSAORenderPass::CreatePipeline()
 		vkDestroyPipeline(m_device.logicalDevice, pso_SSAO_blur, nullptr);
 	}
 	format = vr.attachments.SSAO_finalTarget.format;
-	VK_CHK(vkCreateGraphicsPipelines(m_device.logicalDevice, VK_NULL_HANDLE, 1, &pipelineCI, nullptr, &pso_SSAO_blur));
+	VK_CHK(vkCreateGraphicsPipelines(m_device.logicalDevice, vr.pipelineCache.Get(), 1, &pipelineCI, nullptr, &pso_SSAO_blur));
 	VK_NAME(m_device.logicalDevice, "SSAO_PSO_blur", pso_SSAO_blur);
 
 	vkDestroyShaderModule(m_device.logicalDevice,shaderStages[0].module , nullptr);
@@ -53,7 +53,7 @@ private:
 
 DECLARE_RENDERPASS(ShadowPass);
 
-VkExtent2D shadowmapSize = { 4096, 4096 };
+VkExtent2D shadowmapSize = { SHADOW_ATLAS_SIZE, SHADOW_ATLAS_SIZE };
 
 VulkanRenderpass renderpass_Shadow{};
 
@@ -78,9 +78,9 @@ bool ShadowPass::SetupDependencies(RenderGraph& builder)
 	builder.Write(&vr.attachments.shadow_depth, ATTACHMENT);
 
 	builder.Read(vr.shadowCasterInstanceBuffer);
-	builder.Read(vr.gpuShadowCasterTransformBuffer);
+	builder.Read(vr.gpuTransformBuffer);
 	builder.Read(vr.gpuBoneMatrixBuffer);
-	builder.Read(vr.casterObjectInformationBuffer);
+	builder.Read(vr.objectInformationBuffer);
 	builder.Read(vr.gpuSkinningWeightsBuffer);
 	// READ: Scene data SSBO
 	// READ: Instancing Data
@@ -96,7 +96,11 @@ void ShadowPass::Draw(const VkCommandBuffer cmdlist)
 
 	lastCmd = cmdlist;
 	if (!vr.deferredRendering)
+	{
+		// the tiles were not rendered, nothing in them can be reused next frame
+		vr.batches.m_shadowAtlas.Invalidate();
 		return;
+	}
 	auto& device = vr.m_device;
 	auto& swapchain = vr.m_swapchain;
 	//auto& commandBuffers = vr.commandBuffers;
@@ -106,17 +110,16 @@ void ShadowPass::Draw(const VkCommandBuffer cmdlist)
     PROFILE_GPU_CONTEXT(cmdlist);
     PROFILE_GPU_EVENT("Shadow");
 
-	constexpr VkClearColorValue zeroFloat4 = VkClearColorValue{ 0.0f, 0.0f, 0.0f, 0.0f };
+	// every tile still holds the depth it was last rendered with
+	if (vr.batches.m_numShadowFacesRendered == 0)
+		return;
+
+	constexpr VkClearDepthStencilValue clearDepth{ 0.0f, 0 };
 
-	// Clear values for all attachments written in the fragment shader
-	VkClearValue clearValues;
-	clearValues.depthStencil = { 0.0f, 0 };
-	
-	const float vpHeight = (float)vr.attachments.shadow_depth.height;
-	const float vpWidth = (float)vr.attachments.shadow_depth.width;
 	rhi::CommandList cmd{ cmdlist, "Shadow Pass"};
 
-	bool clearOnDraw = true;
+	// only the dirty tiles are cleared, the rest of the atlas is kept
+	bool clearOnDraw = false;
 	cmd.BindDepthAttachment(&vr.attachments.shadow_depth, clearOnDraw);
 
 	cmd.BindPSO(pso_ShadowDefault, PSOLayoutDB::defaultPSOLayout);
@@ -128,9 +131,9 @@ void ShadowPass::Draw(const VkCommandBuffer cmdlist)
 	cmd.DescriptorSetBegin(0)
 		.BindSampler(0, GfxSamplerManager::GetDefaultSampler())
 		.BindBuffer(1, vr.shadowCasterInstanceBuffer.GetBufferInfoPtr(), VK_DESCRIPTOR_TYPE_STORAGE_BUFFER)
-		.BindBuffer(3, vr.gpuShadowCasterTransformBuffer.GetBufferInfoPtr(), VK_DESCRIPTOR_TYPE_STORAGE_BUFFER)
+		.BindBuffer(3, vr.gpuTransformBuffer.GetBufferInfoPtr(), VK_DESCRIPTOR_TYPE_STORAGE_BUFFER)
 		.BindBuffer(4, vr.gpuBoneMatrixBuffer.GetBufferInfoPtr(), VK_DESCRIPTOR_TYPE_STORAGE_BUFFER)
-		.BindBuffer(5, vr.casterObjectInformationBuffer.GetBufferInfoPtr(), VK_DESCRIPTOR_TYPE_STORAGE_BUFFER)
+		.BindBuffer(5, vr.objectInformationBuffer.GetBufferInfoPtr(), VK_DESCRIPTOR_TYPE_STORAGE_BUFFER)
 		.BindBuffer(6, vr.gpuSkinningWeightsBuffer.GetBufferInfoPtr(), VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
 
 	cmd.DescriptorSetBegin(1)
@@ -144,15 +147,6 @@ void ShadowPass::Draw(const VkCommandBuffer cmdlist)
 	//cmd.BindVertexBuffer(BIND_POINT_INSTANCE_BUFFER_ID, 1, vr.instanceBuffer.getBufferPtr());
 	cmd.BindIndexBuffer(vr.g_GlobalMeshBuffers.IdxBuffer.getBuffer(), 0, VK_INDEX_TYPE_UINT32);
 
-	// calculate shadowmap grid dim
-	float smGridDim = ceilf(sqrtf(static_cast<float>(vr.m_numShadowcastLights)));
-	
-	glm::vec2 increment{ vpWidth, vpHeight};
-	if (smGridDim)
-	{
-		increment /= smGridDim;
-	}
-
 	const auto& casterDatas = vr.batches.m_casterData;
 	const auto& lights = vr.batches.GetShadowCasters();
 	for (size_t i = 0; i < lights.size(); ++i)
@@ -161,88 +155,34 @@ void ShadowPass::Draw(const VkCommandBuffer cmdlist)
 		OO_ASSERT(GetLightEnabled(light) == true);
 		OO_ASSERT(GetCastsShadows(light) == true);
 
-		if (GetCastsShadows(light) == true)
-		{			
-			// get the data for this light
-			const GraphicsBatch::CastersData& casterData = casterDatas[i];
-			switch (GetLightType(light))
+		// get the data for this light, point lights have a tile per face and area lights a single one
+		const GraphicsBatch::CastersData& casterData = casterDatas[i];
+		const oGFX::ShadowAtlas::Light& atlasLight = *casterData.m_atlasLight;
+		for (size_t face = 0; face < atlasLight.numFaces; face++)
+		{
+			if (casterData.m_dirty[face] == false)
+				continue;
+
+			const oGFX::ShadowAtlas::Tile& tile = atlasLight.faces[face].tile;
+			const VkRect2D tileRect{ { static_cast<int32_t>(tile.x), static_cast<int32_t>(tile.y) }, { tile.size, tile.size } };
+			cmd.SetScissor(tileRect);
+			cmd.ClearDepthRegion(tileRect, clearDepth);
+
+			// render inside the 1 texel border, flipped so the lighting pass samples it the same way as before
+			const float inner = static_cast<float>(tile.size - 2);
+			cmd.SetViewport(VkViewport{ tile.x + 1.0f, tile.y + 1.0f + inner, inner, -inner, 0.0f, 1.0f });
+
+			glm::mat4 mm(1.0f);
+			mm = light.projection * light.view[face];
+			cmd.SetPushConstant(PSOLayoutDB::defaultPSOLayout, sizeof(glm::mat4), glm::value_ptr(mm));
+
+			const std::vector<oGFX::IndirectCommand>& commands = casterData.m_commands[face];
+			for (const oGFX::IndirectCommand& c : commands)
 			{
-			// this is an omnilight
-			case LightType::POINT: 
-			{
-				for (size_t face = 0; face < POINT_LIGHT_FACE_COUNT; face++)
-				{
-					int lightGrid = light.info.y + static_cast<int>(face);
-					// set custom viewport for each view
-					int ly = static_cast<int>(lightGrid / smGridDim);
-					int lx = static_cast<int>(lightGrid - (ly * smGridDim));
-					vec2 customVP = increment * glm::vec2{ lx,smGridDim - ly };
-
-					//light.info.z = customVP.x; // this is actually wasted
-					//light.info.w = customVP.y; // this is actually wasted
-
-					//cmd.SetViewport(VkViewport{ 0.0f, vpHeight, vpWidth, -vpHeight, 0.0f, 1.0f });
-					//cmd.SetScissor(VkRect2D{ {0, 0}, {(uint32_t)vpWidth , (uint32_t)vpHeight } });
-
-					// calculate viewport for each light
-					cmd.SetViewport(VkViewport{ customVP.x + 1, customVP.y + 1,increment.x - 1, -(increment.y - 1), 0.0f, 1.0f });
-					// TODO: Set exact region for scissor
-					cmd.SetScissor(VkRect2D{ {0, 0}, {(uint32_t)vpHeight, (uint32_t)vpWidth } });
-
-					glm::mat4 mm(1.0f);
-					mm = light.projection * light.view[face];
-					cmd.SetPushConstant(PSOLayoutDB::defaultPSOLayout, sizeof(glm::mat4), glm::value_ptr(mm));
-
-					const std::vector<oGFX::IndirectCommand>& commands = casterData.m_commands[face];
-					for (const oGFX::IndirectCommand& c : commands)
-					{
-						cmd.DrawIndexed(c.indexCount, c.instanceCount, c.firstIndex, c.vertexOffset, c.firstInstance);
-					}
-					//cmd.DrawIndexedIndirect(vr.shadowCasterCommandsBuffer.getBuffer(), 0, static_cast<uint32_t>(vr.shadowCasterCommandsBuffer.size()));
-				}
+				cmd.DrawIndexed(c.indexCount, c.instanceCount, c.firstIndex, c.vertexOffset, c.firstInstance);
 			}
-			break;
-			case LightType::AREA:
-			{
-				for (size_t face = 0; face < AREA_LIGHT_FACE_COUNT; face++)
-				{
-					int lightGrid = light.info.y + static_cast<int>(face);
-					// set custom viewport for each view
-					int ly = static_cast<int>(lightGrid / smGridDim);
-					int lx = static_cast<int>(lightGrid - (ly * smGridDim));
-					vec2 customVP = increment * glm::vec2{ lx,smGridDim - ly };
-
-					//light.info.z = customVP.x; // this is actually wasted
-					//light.info.w = customVP.y; // this is actually wasted
-
-					//cmd.SetViewport(VkViewport{ 0.0f, vpHeight, vpWidth, -vpHeight, 0.0f, 1.0f });
-					//cmd.SetScissor(VkRect2D{ {0, 0}, {(uint32_t)vpWidth , (uint32_t)vpHeight } });
-
-					// calculate viewport for each light
-					cmd.SetViewport(VkViewport{ customVP.x + 1, customVP.y + 1,increment.x - 1, -(increment.y - 1), 0.0f, 1.0f });
-					// TODO: Set exact region for scissor
-					cmd.SetScissor(VkRect2D{ {0, 0}, {(uint32_t)vpHeight, (uint32_t)vpWidth } });
-
-					glm::mat4 mm(1.0f);
-					mm = light.projection * light.view[face];
-					cmd.SetPushConstant(PSOLayoutDB::defaultPSOLayout, sizeof(glm::mat4), glm::value_ptr(mm));
-
-					const std::vector<oGFX::IndirectCommand>& commands = casterData.m_commands[face];
-					for (const oGFX::IndirectCommand& c : commands)
-					{
-						cmd.DrawIndexed(c.indexCount, c.instanceCount, c.firstIndex, c.vertexOffset, c.firstInstance);
-					}
-					//cmd.DrawIndexedIndirect(vr.shadowCasterCommandsBuffer.getBuffer(), 0, static_cast<uint32_t>(vr.shadowCasterCommandsBuffer.size()));
-				}
-			}
-			break;
-			default:
-				break;
-			}
-			
-						
-		}			
-	}	
+		}
+	}
 }
 
 void ShadowPass::Shutdown()
@@ -408,7 +348,7 @@ void ShadowPass::CreatePipeline()
 	{
 		vkDestroyPipeline(m_device.logicalDevice, pso_ShadowDefault, nullptr);
 	}
-	VK_CHK(vkCreateGraphicsPipelines(m_device.logicalDevice, VK_NULL_HANDLE, 1, &pipelineCI, nullptr, &pso_ShadowDefault));
+	VK_CHK(vkCreateGraphicsPipelines(m_device.logicalDevice, vr.pipelineCache.Get(), 1, &pipelineCI, nullptr, &pso_ShadowDefault));
 	VK_NAME(m_device.logicalDevice, "ShadowPipline", pso_ShadowDefault);
 	vkDestroyShaderModule(m_device.logicalDevice, shaderStages[0].module, nullptr);
 	vkDestroyShaderModule(m_device.logicalDevice, shaderStages[1].module, nullptr);
@@ -117,7 +117,7 @@ void SkyRenderPass::Draw(const VkCommandBuffer cmdlist)
 		.BindImage(1, &vr.g_cubeMap, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE);
 
 	LightPC pc{};
-	pc.ambient = vr.currWorld->lightSettings.ambient;
+	pc.ambient = vr.currWorld->RenderSnapshot().lightSettings.ambient;
 
 	cmd.SetPushConstant(PSOLayoutDB::skypassPSOLayout, sizeof(LightPC), &pc);
 
@@ -240,7 +240,7 @@ void SkyRenderPass::CreatePipeline()
 	{
 		vkDestroyPipeline(m_device.logicalDevice, pso_skyPass, nullptr);
 	}
-	VK_CHK(vkCreateGraphicsPipelines(m_device.logicalDevice, VK_NULL_HANDLE, 1, &pipelineCI, nullptr, &pso_skyPass));
+	VK_CHK(vkCreateGraphicsPipelines(m_device.logicalDevice, vr.pipelineCache.Get(), 1, &pipelineCI, nullptr, &pso_skyPass));
 	VK_NAME(m_device.logicalDevice, "Skypass_PSO", pso_skyPass);
 
 	vkDestroyShaderModule(m_device.logicalDevice, shaderStages[0].module, nullptr);
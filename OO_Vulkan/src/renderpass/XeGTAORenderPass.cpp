@@ -153,7 +153,7 @@ void XeGTAORenderPass::UpdateConstants(XeGTAO::GTAOConstants& consts, XeGTAO::GT
 	size_t frameCount = vr.currentFrame;
 	size_t currFrame = vr.getFrame();
 
-	Camera& cam = vr.currWorld->cameras[0];
+	Camera& cam = vr.currWorld->RenderSnapshot().cameras[0];
 	VkExtent2D resInfo = { vr.renderWidth,vr.renderHeight };
 	glm::mat4 projMatrix = cam.matrices.perspectiveJittered;
 	bool rowMajor = true;
@@ -658,7 +658,7 @@ void XeGTAORenderPass::CreatePipeline()
 		const char* shader = xegtao_shaders[i];
 		computeCI = oGFX::vkutils::inits::computeCreateInfo(PSOLayoutDB::xegtao_PSOLayouts[i]);
 		computeCI.stage = vr.LoadShader(m_device, shader, VK_SHADER_STAGE_COMPUTE_BIT);
-		VK_CHK(vkCreateComputePipelines(m_device.logicalDevice, VK_NULL_HANDLE, 1, &computeCI, nullptr, &pipe));
+		VK_CHK(vkCreateComputePipelines(m_device.logicalDevice, vr.pipelineCache.Get(), 1, &computeCI, nullptr, &pipe));
 		std::string name(xegtao_shaders_names[i]);
 		name += "_PSO";
 		VK_NAME(m_device.logicalDevice, name.c_str(), &pipe);
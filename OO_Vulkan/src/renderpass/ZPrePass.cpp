@@ -78,6 +78,7 @@ bool ZPrePass::SetupDependencies(RenderGraph& builder)
 	// WRITE: Shadow Depth Map
 	builder.Write(vr.attachments.gbuffer[GBufferAttachmentIndex::DEPTH], ATTACHMENT);
 
+	builder.Read(vr.indirectCommandsBuffer);
 	builder.Read(vr.instanceBuffer);
 	builder.Read(vr.gpuTransformBuffer);
 	builder.Read(vr.gpuBoneMatrixBuffer);
@@ -249,7 +250,7 @@ void ZPrePass::CreatePipeline()
 	{
 		vkDestroyPipeline(m_device.logicalDevice, pso_zPrepass, nullptr);
 	}
-	VK_CHK(vkCreateGraphicsPipelines(m_device.logicalDevice, VK_NULL_HANDLE, 1, &pipelineCI, nullptr, &pso_zPrepass));
+	VK_CHK(vkCreateGraphicsPipelines(m_device.logicalDevice, vr.pipelineCache.Get(), 1, &pipelineCI, nullptr, &pso_zPrepass));
 	VK_NAME(m_device.logicalDevice, "zPrepass", pso_zPrepass);
 	vkDestroyShaderModule(m_device.logicalDevice, shaderStages[0].module, nullptr);
 	vkDestroyShaderModule(m_device.logicalDevice, shaderStages[1].module, nullptr);
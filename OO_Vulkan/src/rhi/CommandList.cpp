@@ -15,6 +15,8 @@ Technology is prohibited.
 
 #include "VulkanRenderer.h"
 #include <cassert>
+#include <algorithm>
+#include <filesystem>
 
 namespace rhi
 {
@@ -74,6 +76,7 @@ namespace rhi
 		descriptorSets[set].expected = true;
 		descriptorSets[set].bound = false;
 		descriptorSets[set].built = false;
+		descriptorSets[set].external = false;
 		return descriptorSets[set];
 	}
 
@@ -92,6 +95,7 @@ namespace rhi
 		descriptorSets[set].expected = true;
 		descriptorSets[set].bound = false;
 		descriptorSets[set].built = true;
+		descriptorSets[set].external = true;
 
 	}
 
@@ -113,16 +117,6 @@ namespace rhi
 		{
 			f = VK_FORMAT_UNDEFINED;
 		}
-
-		pipelineCI.pInputAssemblyState = &inputAssemblyState;
-		pipelineCI.pRasterizationState = &rasterizationState;
-		pipelineCI.pColorBlendState = &colorBlendState;
-		pipelineCI.pMultisampleState = &multisampleState;
-		pipelineCI.pViewportState = &viewportState;
-		pipelineCI.pDepthStencilState = &depthStencilState;
-		pipelineCI.pDynamicState = &dynamicState;
-		//pipelineCI.stageCount = static_cast<uint32_t>(shaderStages.size());
-		//pipelineCI.pStages = shaderStages.data();
 	}
 	CommandList::~CommandList()
 	{
@@ -551,6 +545,19 @@ void CommandList::ClearImage(vkutils::Texture* tex, VkClearValue clear)
 	}
 }
 
+void CommandList::ClearDepthRegion(const VkRect2D& rect, VkClearDepthStencilValue clear)
+{
+	PROFILE_SCOPED();
+	OO_ASSERT(m_depthBound);
+	BeginRendering(m_renderArea);
+
+	VkClearAttachment attachment{};
+	attachment.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+	attachment.clearValue.depthStencil = clear;
+	VkClearRect clearRect{ rect, 0, 1 };
+	vkCmdClearAttachments(m_VkCommandBuffer, 1, &attachment, 1, &clearRect);
+}
+
 void CommandList::Draw(uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance)
 {
 	PROFILE_SCOPED();
@@ -585,6 +592,7 @@ void CommandList::BindDescriptorSet(VkPipelineLayout layout,
 		DescriptorSetInfo& descSet  = descriptorSets[i + firstSet];
 		descSet.expected = true;
 		descSet.built = true;
+		descSet.external = true;
 		descSet.bound = false;
 		descSet.descriptor = pDescriptorSets[i];
 	}
@@ -733,157 +741,188 @@ void CommandList::GetOrBuildPipeline()
 	if (m_pipeline != VK_NULL_HANDLE) return; // no pipeline, we assume bound
 	OO_ASSERT(m_pipelineBindPoint != VK_PIPELINE_BIND_POINT_MAX_ENUM);
 
-	auto& vr = *VulkanRenderer::get();
-	size_t hash{ 0 };
-	size_t setCount{};
+	PipelineDesc desc;
+	desc.bindPoint = m_pipelineBindPoint;
+
+	// only pipelines whose layouts come from the command list can be built again from the manifest
+	bool recordable = true;
 	std::vector<VkDescriptorSetLayout> setLayouts;
-	for (size_t i = 0; i < descriptorSets.size(); i++)
+	for (DescriptorSetInfo& descSet : descriptorSets)
 	{
-		if (descriptorSets[i].expected) {
-			oGFX::HashCombine(hash, descriptorSets[i].builder.getHash());
-			setCount++;
-			setLayouts.push_back(descriptorSets[i].layout);
+		if (descSet.expected == false) continue;
+		setLayouts.push_back(descSet.layout);
+		if (descSet.external)
+		{
+			oGFX::HashCombine(desc.layoutHash, descSet.layout);
+			recordable = false;
+		}
+		else
+		{
+			oGFX::HashCombine(desc.layoutHash, descSet.builder.getHash());
+			const std::vector<VkDescriptorSetLayoutBinding>& bindings = descSet.builder.getBindings();
+			recordable = recordable && std::none_of(bindings.begin(), bindings.end(), [](const VkDescriptorSetLayoutBinding& b) { return b.pImmutableSamplers; });
+			desc.sets.push_back(bindings);
 		}
 	}
-	oGFX::HashCombine(hash, setCount);
-	size_t pipelineLayoutHash = hash;
+	oGFX::HashCombine(desc.layoutHash, setLayouts.size());
+
+	if (m_pipelineBindPoint == VK_PIPELINE_BIND_POINT_COMPUTE) 
+	{
+		desc.shaders = { shadercodes[COMPUTE] };
+	}
+	else
 	{
-		auto& map = vr.pipelineLayoutMap;
-		auto iter = map.find(pipelineLayoutHash);
-		if (iter == map.end()) {
-			// does not contain, build;
-			VkPipelineLayoutCreateInfo plci = oGFX::vkutils::inits::pipelineLayoutCreateInfo(
-				setLayouts.data(), static_cast<uint32_t>(setLayouts.size()));
+		desc.shaders = { shadercodes[VERTEX], shadercodes[FRAGMENT] };
+		desc.colourFormats.assign(m_attachmentFormats.begin(), m_attachmentFormats.begin() + (m_highestAttachmentBound + 1));
+		desc.depthFormat = m_depthFormat;
+	}
+	desc.hash = desc.ComputeHash();
 
-			printf("Creating pipeline layout hash-0x%zX\n", pipelineLayoutHash);
-			VK_CHK(vkCreatePipelineLayout(vr.m_device.logicalDevice, &plci, nullptr, &m_pipeLayout));
-			//VK_NAME(m_device.logicalDevice, "Bloom_PSOLayout", play);
-			map[pipelineLayoutHash] = m_pipeLayout;
-		}
-		else {
-			m_pipeLayout = iter->second;
-		}
+	m_pipeline = FindOrBuildPipeline(desc, setLayouts, m_pipeLayout, recordable);
+	vkCmdBindPipeline(m_VkCommandBuffer, m_pipelineBindPoint, m_pipeline);
+}
+
+VkPipeline CommandList::FindOrBuildPipeline(const PipelineDesc& desc, const std::vector<VkDescriptorSetLayout>& setLayouts, VkPipelineLayout& layout, bool record)
+{
+	auto& vr = *VulkanRenderer::get();
+	layout = vr.pipelineLayoutMap.GetOrBuild(desc.layoutHash, [&vr, &desc, &setLayouts]() {
+		// does not contain, build;
+		VkPipelineLayoutCreateInfo plci = oGFX::vkutils::inits::pipelineLayoutCreateInfo(
+			setLayouts.data(), static_cast<uint32_t>(setLayouts.size()));
+
+		printf("Creating pipeline layout hash-0x%zX\n", desc.layoutHash);
+		VkPipelineLayout pipelineLayout{};
+		VK_CHK(vkCreatePipelineLayout(vr.m_device.logicalDevice, &plci, nullptr, &pipelineLayout));
+		return pipelineLayout;
+	});
+
+	// a thread missing on a pipeline another thread is building waits for that one
+	bool built = false;
+	VkPipeline pipeline = vr.pipelineMap.GetOrBuild(desc.hash, [&desc, layout]() { return BuildPipeline(desc, layout); }, &built);
+	if (built && record)
+	{
+		vr.pipelineCache.RecordPipeline(desc);
 	}
+	return pipeline;
+}
 
-	if (m_pipelineBindPoint == VK_PIPELINE_BIND_POINT_COMPUTE) 
-	{		
-		oGFX::StringHash comp(shadercodes[COMPUTE]);
-		oGFX::HashCombine(hash, comp.computedHash);
-		{
-			auto& map = vr.pipelineMap;
-			auto iter = map.find(hash);
-			if (iter == map.end()) {
-				// does not contain, build;
-
-				printf("Creating compute pipeline hash-0x%zX\n", hash);
-				computeCI = oGFX::vkutils::inits::computeCreateInfo(m_pipeLayout);
-				computeCI.stage = vr.LoadShader(vr.m_device, shadercodes[COMPUTE], VK_SHADER_STAGE_COMPUTE_BIT);
-				VK_CHK(vkCreateComputePipelines(vr.m_device.logicalDevice, VK_NULL_HANDLE, 1, &computeCI, nullptr, &m_pipeline));
-				vkDestroyShaderModule(vr.m_device.logicalDevice, computeCI.stage.module, nullptr);
-				map[hash] = m_pipeline;
-			}
-			else {
-				m_pipeline = iter->second;
-			}
-		}
+VkPipeline CommandList::BuildPipeline(const PipelineDesc& desc, VkPipelineLayout layout)
+{
+	PROFILE_SCOPED();
+	auto& vr = *VulkanRenderer::get();
+	VkPipeline pipeline{ VK_NULL_HANDLE };
+
+	if (desc.bindPoint == VK_PIPELINE_BIND_POINT_COMPUTE)
+	{
+		printf("Creating compute pipeline hash-0x%zX\n", desc.hash);
+		VkComputePipelineCreateInfo computeCI = oGFX::vkutils::inits::computeCreateInfo(layout);
+		computeCI.stage = vr.LoadShader(vr.m_device, desc.shaders[0], VK_SHADER_STAGE_COMPUTE_BIT);
+		VK_CHK(vkCreateComputePipelines(vr.m_device.logicalDevice, vr.pipelineCache.Get(), 1, &computeCI, nullptr, &pipeline));
+		vkDestroyShaderModule(vr.m_device.logicalDevice, computeCI.stage.module, nullptr);
+		return pipeline;
 	}
-	else 
+
+	// do graphics pipeline
+	printf("Creating graphics pipeline hash-0x%zX\n", desc.hash);
+	VkGraphicsPipelineCreateInfo pipelineCI = oGFX::vkutils::inits::pipelineCreateInfo(layout);
+
+	std::array<VkPipelineShaderStageCreateInfo, 2> shaderStages =
 	{
-		// do graphics pipeline
-		oGFX::StringHash vert(shadercodes[VERTEX]);
-		oGFX::StringHash frag(shadercodes[FRAGMENT]);
-		oGFX::HashCombine(hash, vert.computedHash);
-		oGFX::HashCombine(hash, frag.computedHash);
+		vr.LoadShader(vr.m_device, desc.shaders[VERTEX  ], VK_SHADER_STAGE_VERTEX_BIT),
+		vr.LoadShader(vr.m_device, desc.shaders[FRAGMENT], VK_SHADER_STAGE_FRAGMENT_BIT)
+	};
 
-		oGFX::HashCombine(hash, inputAssemblyState);
-		oGFX::HashCombine(hash, rasterizationState);
-		oGFX::HashCombine(hash, colorBlendState);
-		oGFX::HashCombine(hash, multisampleState);
-		oGFX::HashCombine(hash, viewportState);
-		oGFX::HashCombine(hash, depthStencilState);
+	VkPipelineInputAssemblyStateCreateInfo inputAssemblyState = oGFX::vkutils::inits::pipelineInputAssemblyStateCreateInfo();
+	VkPipelineRasterizationStateCreateInfo rasterizationState = oGFX::vkutils::inits::pipelineRasterizationStateCreateInfo();
+	VkPipelineColorBlendStateCreateInfo colorBlendState = oGFX::vkutils::inits::pipelineColorBlendStateCreateInfo(0, nullptr);
+	VkPipelineDepthStencilStateCreateInfo depthStencilState = oGFX::vkutils::inits::pipelineDepthStencilStateCreateInfo();
+	VkPipelineViewportStateCreateInfo viewportState = oGFX::vkutils::inits::pipelineViewportStateCreateInfo();
+	VkPipelineMultisampleStateCreateInfo multisampleState = oGFX::vkutils::inits::pipelineMultisampleStateCreateInfo();
+	std::vector<VkDynamicState> dynamicStateEnables = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+	VkPipelineDynamicStateCreateInfo dynamicState = oGFX::vkutils::inits::pipelineDynamicStateCreateInfo(dynamicStateEnables);
 
-		{
-			auto& map = vr.pipelineMap;
-			auto iter = map.find(hash);
-			if (iter == map.end()) {
-				// does not contain, build;
-
-				printf("Creating graphics pipeline hash-0x%zX\n", hash);
-				pipelineCI = oGFX::vkutils::inits::pipelineCreateInfo(m_pipeLayout);
-
-				std::array<VkPipelineShaderStageCreateInfo, 2> shaderStages =
-				{
-					vr.LoadShader(vr.m_device, shadercodes[VERTEX  ], VK_SHADER_STAGE_VERTEX_BIT),
-					vr.LoadShader(vr.m_device, shadercodes[FRAGMENT], VK_SHADER_STAGE_FRAGMENT_BIT)
-				};
-
-				pipelineCI.pInputAssemblyState = &inputAssemblyState;
-				pipelineCI.pRasterizationState = &rasterizationState;
-				pipelineCI.pColorBlendState = &colorBlendState;
-				pipelineCI.pMultisampleState = &multisampleState;
-				pipelineCI.pViewportState = &viewportState;
-				pipelineCI.pDepthStencilState = &depthStencilState;
-				pipelineCI.stageCount = static_cast<uint32_t>(shaderStages.size());
-				pipelineCI.pStages = shaderStages.data();
-
-				// Need to enable to 
-				depthStencilState.stencilTestEnable = VK_TRUE;
-				depthStencilState.back.compareOp = VK_COMPARE_OP_ALWAYS;
-				depthStencilState.back.failOp = VK_STENCIL_OP_REPLACE;
-				depthStencilState.back.depthFailOp = VK_STENCIL_OP_REPLACE;
-				depthStencilState.back.passOp = VK_STENCIL_OP_REPLACE;
-				depthStencilState.back.compareMask = 0xff;
-				depthStencilState.back.writeMask = 0xff;
-				depthStencilState.back.reference = 1;
-				depthStencilState.front = depthStencilState.back;
-				// =======================
-
-				pipelineCI.pVertexInputState = &vertexInputCreateInfo;
-
-				// not hashed as assumed not changing
-				pipelineCI.pDynamicState = &dynamicState;
-
-				size_t numAttachments = m_highestAttachmentBound + 1;
-
-				std::vector<VkFormat> colourFormats;
-				colourFormats.resize(numAttachments);
-				for (size_t i = 0; i < numAttachments; i++)
-				{
-					colourFormats[i] = m_attachmentFormats[i];
-				}
+	std::vector<VkVertexInputBindingDescription> bindingDescription = oGFX::GetGFXVertexInputBindings();
+	std::vector<VkVertexInputAttributeDescription>attributeDescriptions = oGFX::GetGFXVertexInputAttributes();
+	VkPipelineVertexInputStateCreateInfo vertexInputCreateInfo = oGFX::vkutils::inits::pipelineVertexInputStateCreateInfo(bindingDescription, attributeDescriptions);
 
-				std::vector<VkPipelineColorBlendAttachmentState> blendAttachmentStates;
-				blendAttachmentStates.resize(numAttachments);
-				for (size_t i = 0; i < numAttachments; i++)
-				{
-					blendAttachmentStates[i] = oGFX::vkutils::inits::pipelineColorBlendAttachmentState(0xf, VK_FALSE);
-				}				
+	pipelineCI.pInputAssemblyState = &inputAssemblyState;
+	pipelineCI.pRasterizationState = &rasterizationState;
+	pipelineCI.pColorBlendState = &colorBlendState;
+	pipelineCI.pMultisampleState = &multisampleState;
+	pipelineCI.pViewportState = &viewportState;
+	pipelineCI.pDepthStencilState = &depthStencilState;
+	pipelineCI.stageCount = static_cast<uint32_t>(shaderStages.size());
+	pipelineCI.pStages = shaderStages.data();
 
-				colorBlendState.attachmentCount = static_cast<uint32_t>(blendAttachmentStates.size());
-				colorBlendState.pAttachments = blendAttachmentStates.data();
+	// Need to enable to 
+	depthStencilState.stencilTestEnable = VK_TRUE;
+	depthStencilState.back.compareOp = VK_COMPARE_OP_ALWAYS;
+	depthStencilState.back.failOp = VK_STENCIL_OP_REPLACE;
+	depthStencilState.back.depthFailOp = VK_STENCIL_OP_REPLACE;
+	depthStencilState.back.passOp = VK_STENCIL_OP_REPLACE;
+	depthStencilState.back.compareMask = 0xff;
+	depthStencilState.back.writeMask = 0xff;
+	depthStencilState.back.reference = 1;
+	depthStencilState.front = depthStencilState.back;
+	// =======================
 
-				VkPipelineRenderingCreateInfo renderingInfo{ VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO };
-				renderingInfo.viewMask = {};
-				renderingInfo.colorAttachmentCount = (uint32_t)numAttachments;
-				renderingInfo.pColorAttachmentFormats = colourFormats.data();
-				renderingInfo.depthAttachmentFormat = m_depthFormat;
-				renderingInfo.stencilAttachmentFormat = m_depthFormat;
+	pipelineCI.pVertexInputState = &vertexInputCreateInfo;
 
-				pipelineCI.pNext = &renderingInfo;
+	// not hashed as assumed not changing
+	pipelineCI.pDynamicState = &dynamicState;
+
+	std::vector<VkPipelineColorBlendAttachmentState> blendAttachmentStates;
+	blendAttachmentStates.resize(desc.colourFormats.size());
+	for (size_t i = 0; i < desc.colourFormats.size(); i++)
+	{
+		blendAttachmentStates[i] = oGFX::vkutils::inits::pipelineColorBlendAttachmentState(0xf, VK_FALSE);
+	}
 
-				VK_CHK(vkCreateGraphicsPipelines(vr.m_device.logicalDevice, VK_NULL_HANDLE, 1, &pipelineCI, nullptr, &m_pipeline));
+	colorBlendState.attachmentCount = static_cast<uint32_t>(blendAttachmentStates.size());
+	colorBlendState.pAttachments = blendAttachmentStates.data();
 
-				vkDestroyShaderModule(vr.m_device.logicalDevice, shaderStages[VERTEX  ].module, nullptr);
-				vkDestroyShaderModule(vr.m_device.logicalDevice, shaderStages[FRAGMENT].module, nullptr);
+	VkPipelineRenderingCreateInfo renderingInfo{ VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO };
+	renderingInfo.viewMask = {};
+	renderingInfo.colorAttachmentCount = (uint32_t)desc.colourFormats.size();
+	renderingInfo.pColorAttachmentFormats = desc.colourFormats.data();
+	renderingInfo.depthAttachmentFormat = desc.depthFormat;
+	renderingInfo.stencilAttachmentFormat = desc.depthFormat;
 
-				map[hash] = m_pipeline;
-			}
-			else {
-				m_pipeline = iter->second;
-			}
-		}
+	pipelineCI.pNext = &renderingInfo;
+
+	VK_CHK(vkCreateGraphicsPipelines(vr.m_device.logicalDevice, vr.pipelineCache.Get(), 1, &pipelineCI, nullptr, &pipeline));
+
+	vkDestroyShaderModule(vr.m_device.logicalDevice, shaderStages[VERTEX  ].module, nullptr);
+	vkDestroyShaderModule(vr.m_device.logicalDevice, shaderStages[FRAGMENT].module, nullptr);
+
+	return pipeline;
+}
+
+void CommandList::WarmupPipeline(PipelineDesc desc)
+{
+	PROFILE_SCOPED();
+	auto& vr = *VulkanRenderer::get();
+	for (const std::string& shader : desc.shaders)
+	{
+		// removed or renamed since the manifest was written
+		if (std::filesystem::exists(shader) == false)
+			return;
 	}
-	vkCmdBindPipeline(m_VkCommandBuffer, m_pipelineBindPoint, m_pipeline);
+
+	// the same keys GetOrBuildPipeline makes from the command list
+	std::vector<VkDescriptorSetLayout> setLayouts;
+	desc.layoutHash = 0;
+	for (const std::vector<VkDescriptorSetLayoutBinding>& bindings : desc.sets)
+	{
+		VkDescriptorSetLayoutCreateInfo layoutInfo = oGFX::vkutils::inits::descriptorSetLayoutCreateInfo(bindings.data(), static_cast<uint32_t>(bindings.size()));
+		oGFX::HashCombine(desc.layoutHash, vr.DescLayoutCache.GetLayoutInfo(&layoutInfo).hash());
+		setLayouts.push_back(vr.DescLayoutCache.CreateDescriptorLayout(&layoutInfo));
+	}
+	oGFX::HashCombine(desc.layoutHash, setLayouts.size());
+	desc.hash = desc.ComputeHash();
+
+	VkPipelineLayout layout{};
+	FindOrBuildPipeline(desc, setLayouts, layout, false);
 }
 
 DescriptorSetInfo& DescriptorSetInfo::BindImage(uint32_t binding, vkutils::Texture* texture, VkDescriptorType type)
@@ -19,6 +19,7 @@ Technology is prohibited.
 #include "VulkanTexture.h"
 #include "DescriptorBuilder.h"
 #include "RGResource.h"
+#include "PipelineCache.h"
 
 namespace rhi
 {
@@ -34,6 +35,7 @@ namespace rhi
 		bool built = false;
 		bool expected = false;
 		bool bound = false;
+		bool external = false; // layout made outside the command list
 
 		bool hasDynamicOffset = false;
 		uint32_t dynamicOffset;
@@ -146,6 +148,8 @@ public:
 	// Drawing Commands
 	//----------------------------------------------------------------------------------------------------
 	void ClearImage(vkutils::Texture* tex, VkClearValue clear);
+	// Clears part of the bound depth attachment, keeps the rest of it
+	void ClearDepthRegion(const VkRect2D& rect, VkClearDepthStencilValue clear);
 
 	void Draw(
 		uint32_t vertexCount,
@@ -193,6 +197,9 @@ public:
 	// TODO: Function not here? Add it on demand...
 
 	VkCommandBuffer getCommandBuffer();
+
+	// Builds a pipeline recorded by an earlier run before anything asks for it, safe to call from any thread
+	static void WarmupPipeline(PipelineDesc desc);
 private:
 	void PrepareDescriptors();
 	void CommitDescriptors();
@@ -200,6 +207,8 @@ private:
 	void EndIfRendering();
 
 	void GetOrBuildPipeline();
+	static VkPipeline FindOrBuildPipeline(const PipelineDesc& desc, const std::vector<VkDescriptorSetLayout>& setLayouts, VkPipelineLayout& layout, bool record);
+	static VkPipeline BuildPipeline(const PipelineDesc& desc, VkPipelineLayout layout);
 
 	enum
 	{
@@ -215,29 +224,8 @@ private:
 	VkPipelineBindPoint m_pipelineBindPoint{ VK_PIPELINE_BIND_POINT_MAX_ENUM };
 	VkShaderStageFlags m_targetStage{ VK_SHADER_STAGE_FLAG_BITS_MAX_ENUM };
 
-	//pipeline info
-	VkPipelineInputAssemblyStateCreateInfo inputAssemblyState = oGFX::vkutils::inits::pipelineInputAssemblyStateCreateInfo();
-	VkPipelineRasterizationStateCreateInfo rasterizationState = oGFX::vkutils::inits::pipelineRasterizationStateCreateInfo();
-	VkPipelineColorBlendAttachmentState blendAttachmentState = oGFX::vkutils::inits::pipelineColorBlendAttachmentState();
-	VkPipelineColorBlendStateCreateInfo colorBlendState = oGFX::vkutils::inits::pipelineColorBlendStateCreateInfo(1, &blendAttachmentState);
-	VkPipelineDepthStencilStateCreateInfo depthStencilState = oGFX::vkutils::inits::pipelineDepthStencilStateCreateInfo();
-	VkPipelineViewportStateCreateInfo viewportState = oGFX::vkutils::inits::pipelineViewportStateCreateInfo();
-	VkPipelineMultisampleStateCreateInfo multisampleState = oGFX::vkutils::inits::pipelineMultisampleStateCreateInfo();
-	std::vector<VkDynamicState> dynamicStateEnables = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
-	VkPipelineDynamicStateCreateInfo dynamicState = oGFX::vkutils::inits::pipelineDynamicStateCreateInfo(dynamicStateEnables);
-
-	VkGraphicsPipelineCreateInfo pipelineCI;
-
-	std::vector<VkVertexInputBindingDescription> bindingDescription = oGFX::GetGFXVertexInputBindings();
-	std::vector<VkVertexInputAttributeDescription>attributeDescriptions = oGFX::GetGFXVertexInputAttributes();
-
-	VkPipelineVertexInputStateCreateInfo vertexInputCreateInfo = oGFX::vkutils::inits::pipelineVertexInputStateCreateInfo(bindingDescription, attributeDescriptions);
-
 	std::array< std::string, 3 > shadercodes;
 
-	VkComputePipelineCreateInfo computeCI;
-	// end pipeline info
-
 	std::array<VkRect2D, 8> m_scissor;
 	std::array<VkViewport, 8> m_viewport;
 	std::array<VkRenderingAttachmentInfo, 8> m_attachments{};